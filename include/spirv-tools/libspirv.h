@@ -55,6 +55,8 @@ typedef enum spv_result_t {
   SPV_ERROR_INVALID_CAPABILITY = -13,
   SPV_ERROR_INVALID_DATA = -14,  // Indicates data rules validation failure.
   SPV_ERROR_MISSING_EXTENSION = -15,
+  SPV_ERROR_EXCEEDED_BUDGET = -16,  // The validation work budget set on the
+                                    // validator options was exhausted.
   SPV_FORCE_32_BIT_ENUM(spv_result_t)
 } spv_result_t;
 
@@ -265,6 +267,15 @@ typedef enum spv_binary_to_text_options_t {
   // time, but will use common names for scalar types, and debug names from
   // OpName instructions.
   SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES = SPV_BIT(6),
+  // Disassemble function bodies concurrently on the available cores.
+  // The resulting text is identical to sequential disassembly.  Ignored
+  // when SPV_BINARY_TO_TEXT_OPTION_PRINT is also set.
+  SPV_BINARY_TO_TEXT_OPTION_PARALLEL = SPV_BIT(7),
+  // Print every id as "%<decimal>" straight from its numeric value, without
+  // building a name mapper or caching per-id name strings.  Useful for batch
+  // disassembly where the text is consumed by other tools rather than read.
+  // Takes precedence over SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES.
+  SPV_BINARY_TO_TEXT_OPTION_RAW_IDS = SPV_BIT(8),
   SPV_FORCE_32_BIT_ENUM(spv_binary_to_text_options_t)
 } spv_binary_to_text_options_t;
 
@@ -307,19 +318,144 @@ typedef struct spv_parsed_instruction_t {
   uint16_t num_operands;
 } spv_parsed_instruction_t;
 
+// The location of one basic block inside an indexed function.
+typedef struct spv_indexed_block_t {
+  uint32_t id;      // Result id of the block's OpLabel.
+  uint32_t offset;  // Word offset of the OpLabel instruction in the module.
+} spv_indexed_block_t;
+
+// The location of one function in a binary SPIR-V module.
+typedef struct spv_indexed_function_t {
+  uint32_t id;     // Result id of the OpFunction.
+  uint32_t begin;  // Word offset of the OpFunction instruction.
+  uint32_t end;    // Word offset just past the OpFunctionEnd instruction.
+  // The function's basic blocks, in the order they appear in the binary.
+  spv_indexed_block_t* blocks;
+  uint32_t num_blocks;
+} spv_indexed_function_t;
+
+// An index of the functions in a binary SPIR-V module.  See
+// spvBinaryBuildFunctionIndex.
+typedef struct spv_function_index_t {
+  spv_indexed_function_t* functions;  // In module order.
+  uint32_t num_functions;
+} spv_function_index_t;
+
+// A specialization constant site in a binary SPIR-V module: an
+// OpSpecConstant, OpSpecConstantTrue, or OpSpecConstantFalse instruction
+// whose result id carries a SpecId decoration.  See
+// spvBinaryBuildSpecConstantIndex.
+typedef struct spv_indexed_spec_constant_t {
+  uint32_t spec_id;            // The SpecId decoration's value.
+  uint32_t result_id;          // Result id of the constant instruction.
+  uint32_t opcode_offset;      // Word offset of the instruction's first word.
+  uint32_t literal_offset;     // Word offset of the first literal word, or 0
+                               // for boolean constants, which encode their
+                               // value in the opcode instead.
+  uint32_t num_literal_words;  // Number of literal words; 0 for booleans.
+} spv_indexed_spec_constant_t;
+
+// An index of the specializable constants in a binary SPIR-V module.  See
+// spvBinaryBuildSpecConstantIndex.
+typedef struct spv_spec_constant_index_t {
+  spv_indexed_spec_constant_t* constants;  // In module order.
+  uint32_t num_constants;
+} spv_spec_constant_index_t;
+
+// A structure-of-arrays view of the instructions of a parsed module: the
+// n-th instruction's attributes live at index n of each array.  A scan over
+// one attribute -- say, every opcode, or every result id -- then touches
+// only that attribute's memory, instead of striding through whole
+// spv_parsed_instruction_t records.  See spvBinaryParseToSoa.
+typedef struct spv_instruction_soa_t {
+  uint32_t num_instructions;
+  uint16_t* opcodes;  // Opcode of each instruction.
+  // The extended instruction type of each instruction, or the "none" value
+  // when its opcode is not OpExtInst.
+  spv_ext_inst_type_t* ext_inst_types;
+  uint32_t* type_ids;    // Type id, or 0 for instructions without one.
+  uint32_t* result_ids;  // Result id, or 0 for instructions without one.
+  // Word offset of each instruction's first word in the module.  Has
+  // num_instructions + 1 entries; the last is the module's word count, so
+  // adjacent entries also give each instruction's size in words.
+  uint32_t* word_offsets;
+  // Index of each instruction's first operand in the operands slab.  Has
+  // num_instructions + 1 entries; the last is the slab's total length, so
+  // adjacent entries also give each instruction's operand count.
+  uint32_t* operand_offsets;
+  // The parsed operands of all instructions in one slab, in module order.
+  // Operand word offsets are relative to the owning instruction's first
+  // word, as in spv_parsed_instruction_t.
+  spv_parsed_operand_t* operands;
+} spv_instruction_soa_t;
+
+// A value to substitute for one specialization constant.  See
+// spvBinarySpecialize.
+typedef struct spv_spec_constant_value_t {
+  uint32_t spec_id;  // The SpecId decoration's value.
+  // The new value.  For multi-word literals the low-order word is applied
+  // first; for boolean constants zero means false and nonzero means true.
+  uint64_t value;
+} spv_spec_constant_value_t;
+
+// One permutation's worth of specialization constant values.  See
+// spvBinarySpecializeBatch.
+typedef struct spv_spec_constant_value_set_t {
+  const spv_spec_constant_value_t* values;
+  size_t num_values;
+} spv_spec_constant_value_set_t;
+
+// A quick triage summary of a module: a content hash plus coarse size and
+// kind counters, computed in one sweep over the instruction stream without
+// decoding any operands.  See spvBinaryGetFingerprint.
+typedef struct spv_module_fingerprint_t {
+  uint64_t hash;         // FNV-1a hash over the endian-fixed module words.
+  uint32_t version;      // Version word from the header.
+  uint32_t generator;    // Generator magic word from the header.
+  uint32_t id_bound;     // Id bound from the header.
+  uint32_t num_instructions;  // Total number of instructions.
+  uint32_t num_functions;     // Number of OpFunction instructions.
+  uint32_t num_entry_points;  // Number of OpEntryPoint instructions.
+  // Number of debug-only instructions: OpSource and friends, OpString,
+  // OpName, OpMemberName, OpLine, OpNoLine, and OpModuleProcessed.
+  uint32_t num_debug_instructions;
+} spv_module_fingerprint_t;
+
 typedef struct spv_const_binary_t {
   const uint32_t* code;
   const size_t wordCount;
 } spv_const_binary_t;
 
+// A caller-supplied memory allocator.  Allocations that would otherwise come
+// from the global heap are served by the callbacks instead, so the library's
+// memory traffic can be isolated in a dedicated pool.  All members may be
+// zero, which selects the global heap.  See spvContextSetAllocator.
+typedef struct spv_allocator_t {
+  // Opaque pointer passed back to the callbacks.
+  void* user_data;
+  // Returns a pointer to |num_bytes| of storage, aligned for any fundamental
+  // type, or NULL on failure.  May be invoked concurrently from several
+  // threads when the library parallelizes work.
+  void* (*allocate)(void* user_data, size_t num_bytes);
+  // Releases |pointer|, previously returned by |allocate| for |num_bytes|.
+  // May be NULL for pools that reclaim their storage wholesale.
+  void (*deallocate)(void* user_data, void* pointer, size_t num_bytes);
+} spv_allocator_t;
+
 typedef struct spv_binary_t {
   uint32_t* code;
   size_t wordCount;
+  // How this object and its code buffer were allocated; all-zero for the
+  // global heap.  Set by the library and read back by spvBinaryDestroy.
+  spv_allocator_t allocator;
 } spv_binary_t;
 
 typedef struct spv_text_t {
   const char* str;
   size_t length;
+  // How this object and its character buffer were allocated; all-zero for
+  // the global heap.  Set by the library and read back by spvTextDestroy.
+  spv_allocator_t allocator;
 } spv_text_t;
 
 typedef struct spv_position_t {
@@ -340,6 +476,15 @@ typedef struct spv_context_t spv_context_t;
 
 typedef struct spv_validator_options_t spv_validator_options_t;
 
+// Opaque struct for an assembler session, which retains token lookup caches
+// across assembly calls.  See spvAssemblerCreate.
+typedef struct spv_assembler_t spv_assembler_t;
+
+// Opaque struct for a streaming disassembler session, which prints each
+// instruction as soon as its words have arrived instead of waiting for the
+// whole module.  See spvStreamingDisassemblerCreate.
+typedef struct spv_streaming_disassembler_t spv_streaming_disassembler_t;
+
 // Type Definitions
 
 typedef spv_const_binary_t* spv_const_binary;
@@ -350,7 +495,12 @@ typedef spv_diagnostic_t* spv_diagnostic;
 typedef const spv_context_t* spv_const_context;
 typedef spv_context_t* spv_context;
 typedef spv_validator_options_t* spv_validator_options;
+typedef spv_function_index_t* spv_function_index;
+typedef spv_spec_constant_index_t* spv_spec_constant_index;
+typedef spv_instruction_soa_t* spv_instruction_soa;
 typedef const spv_validator_options_t* spv_const_validator_options;
+typedef spv_assembler_t* spv_assembler;
+typedef spv_streaming_disassembler_t* spv_streaming_disassembler;
 
 // Platform API
 
@@ -398,11 +548,27 @@ typedef enum {
 const char* spvTargetEnvDescription(spv_target_env env);
 
 // Creates a context object.  Returns null if env is invalid.
+//
+// Creating a context is cheap: the grammar tables it refers to are immutable,
+// statically allocated, and shared by every context targeting the same
+// environment.  Contexts may be created and destroyed freely, and distinct
+// contexts may be used concurrently from different threads.
 spv_context spvContextCreate(spv_target_env env);
 
 // Destroys the given context object.
 void spvContextDestroy(spv_context context);
 
+// Installs |allocator| as the context's memory allocator; it is copied, and
+// passing NULL restores the global heap.  Result objects returned through
+// this context -- assembled binaries and disassembled text -- and the
+// validator's large scratch buffers are then drawn from the callbacks
+// instead of the global heap.  spvBinaryDestroy and spvTextDestroy release
+// such results through the callbacks they were allocated with, so results
+// may safely outlive the context.  Small transient allocations (parser
+// book-keeping and the like) are not redirected.
+void spvContextSetAllocator(spv_context context,
+                            const spv_allocator_t* allocator);
+
 // Creates a Validator options object with default options. Returns a valid
 // options object. The object remains valid until it is passed into
 // spvValidatorOptionsDestroy.
@@ -417,6 +583,78 @@ void spvValidatorOptionsSetUniversalLimit(spv_validator_options options,
                                           spv_validator_limit limit_type,
                                           uint32_t limit);
 
+// Bit flags selecting which groups of validator checks to run.  Callers that
+// trust their inputs can restrict validation to the structural stages they
+// need at load time and run the rest offline.  Note that id checks need the
+// CFG to be built, so requesting SPV_VALIDATOR_CHECK_IDS implies the CFG
+// construction work of SPV_VALIDATOR_CHECK_CFG.
+typedef enum spv_validator_check_t {
+  SPV_VALIDATOR_CHECK_LAYOUT = (1 << 0),        // Module layout rules.
+  SPV_VALIDATOR_CHECK_IDS = (1 << 1),           // Id definition, use, dominance.
+  SPV_VALIDATOR_CHECK_CAPABILITIES = (1 << 2),  // Capability requirements.
+  SPV_VALIDATOR_CHECK_CFG = (1 << 3),           // Structured control flow.
+  SPV_VALIDATOR_CHECK_DATA_RULES = (1 << 4),    // Data rules.
+  SPV_VALIDATOR_CHECK_INSTRUCTIONS = (1 << 5),  // Per-instruction rules and
+                                                // type uniqueness.
+  SPV_VALIDATOR_CHECK_DECORATIONS = (1 << 6),   // Decoration rules.
+  SPV_VALIDATOR_CHECK_ALL = 0x7f,
+} spv_validator_check_t;
+
+// Selects the checks run by spvValidateWithOptions as a bitwise OR of
+// spv_validator_check_t values.  The default is SPV_VALIDATOR_CHECK_ALL.
+void spvValidatorOptionsSetChecks(spv_validator_options options,
+                                  uint32_t checks);
+
+// A work budget bounding the worst-case cost of validating one module,
+// intended for untrusted input.  A zero field leaves that dimension
+// unlimited (the default).  When a budget is exceeded, validation stops
+// with SPV_ERROR_EXCEEDED_BUDGET; nothing can then be said about the
+// module's validity.
+typedef struct spv_validator_budget_t {
+  // Maximum number of instructions in the module.
+  uint64_t max_instructions;
+  // Maximum number of basic blocks in any one function.
+  uint32_t max_blocks_per_function;
+  // Maximum total validation steps.  A step is one instruction processed by
+  // one validation pass or one block visited by the CFG checks, so this
+  // bounds overall work even when the per-dimension limits are generous.
+  uint64_t max_validation_steps;
+} spv_validator_budget_t;
+
+// Sets the work budget enforced by spvValidateWithOptions.  The budget is
+// copied into the options object.
+void spvValidatorOptionsSetBudget(spv_validator_options options,
+                                  const spv_validator_budget_t* budget);
+
+// A caller-pluggable validation result cache.  Keys are 64-bit hashes the
+// validator computes over the binary words, the validator options, and the
+// context's target environment.  lookup returns true if key is present,
+// meaning an identical binary already validated clean under an identical
+// configuration; insert is called after each successful full validation.
+// Both callbacks receive user_data and must be thread-safe if the cache is
+// shared between threads.
+typedef struct spv_validation_cache_t {
+  void* user_data;
+  bool (*lookup)(void* user_data, uint64_t key);
+  void (*insert)(void* user_data, uint64_t key);
+} spv_validation_cache_t;
+
+// Sets the validation cache consulted by spvValidateWithOptions.  On a cache
+// hit validation is skipped and SPV_SUCCESS returned.  The cache must stay
+// valid as long as the options object refers to it; a null <cache> disables
+// caching (the default).
+void spvValidatorOptionsSetValidationCache(spv_validator_options options,
+                                           spv_validation_cache_t* cache);
+
+// Enables pipelined validation: the binary is decoded on the calling thread
+// while the per-instruction checks run on a worker thread fed through a
+// lock-free batch queue.  This overlaps decode and check time even when the
+// module is dominated by a single large function and the validator's
+// per-function parallelism has nothing to split.  Results and diagnostics
+// are the same as for sequential validation.  Off by default.
+void spvValidatorOptionsSetPipelinedChecks(spv_validator_options options,
+                                           bool pipelined);
+
 // Encodes the given SPIR-V assembly text to its binary representation. The
 // length parameter specifies the number of bytes for text. Encoded binary will
 // be stored into *binary. Any error will be written into *diagnostic if
@@ -433,6 +671,53 @@ spv_result_t spvTextToBinaryWithOptions(
     const spv_const_context context, const char* text, const size_t length,
     const uint32_t options, spv_binary* binary, spv_diagnostic* diagnostic);
 
+// A caller-pluggable output buffer for the assembler.  Whenever the encoder
+// needs the buffer to hold at least word_count words, it calls grow with the
+// given user_data; grow returns the buffer base -- which may have moved --
+// with all previously written words preserved, or null on failure.  Letting
+// the caller own the buffer allows encoding straight into storage such as a
+// memory-mapped output file, with no intermediate heap copy.
+typedef struct spv_word_sink_t {
+  void* user_data;
+  uint32_t* (*grow)(void* user_data, size_t word_count);
+} spv_word_sink_t;
+
+// Encodes the given SPIR-V assembly text, writing the binary words through
+// the given caller-owned sink instead of into a freshly allocated
+// spv_binary.  On success *word_count holds the number of words written.
+// The sink's buffer may have been grown beyond that count; the caller is
+// responsible for trimming.  Other parameters behave as in
+// spvTextToBinaryWithOptions.
+spv_result_t spvTextToBinaryToSink(const spv_const_context context,
+                                   const char* text, const size_t length,
+                                   const uint32_t options,
+                                   spv_word_sink_t* sink, size_t* word_count,
+                                   spv_diagnostic* diagnostic);
+
+// Creates an assembler session over the given context.  The session keeps
+// the keyword resolutions made while assembling -- opcode names, operand
+// enum names, extended-instruction names -- so later calls on the same
+// session resolve repeated tokens from a memo cache instead of searching
+// the grammar tables again.  Batch workloads that assemble many similar
+// modules should funnel them through one session; warm-cache assembly then
+// approaches pure encode speed.  The context must outlive the session.  A
+// session is not thread safe: synchronize calls or use one session per
+// thread.  Returns null if context is null.
+spv_assembler spvAssemblerCreate(const spv_const_context context);
+
+// Destroys the given assembler session. This is a no-op if assembler is a
+// null pointer.
+void spvAssemblerDestroy(spv_assembler assembler);
+
+// Encodes the given SPIR-V assembly text through an assembler session.
+// Behaves like spvTextToBinaryWithOptions against the session's context
+// while reusing and extending the session's token caches.
+spv_result_t spvAssemblerTextToBinary(spv_assembler assembler,
+                                      const char* text, const size_t length,
+                                      const uint32_t options,
+                                      spv_binary* binary,
+                                      spv_diagnostic* diagnostic);
+
 // Frees an allocated text stream. This is a no-op if the text parameter
 // is a null pointer.
 void spvTextDestroy(spv_text text);
@@ -447,6 +732,66 @@ spv_result_t spvBinaryToText(const spv_const_context context,
                              const uint32_t options, spv_text* text,
                              spv_diagnostic* diagnostic);
 
+// Like spvBinaryToText, but decodes only the instructions in the word range
+// [begin_offset, end_offset) of |binary|, which must cover whole
+// instructions.  The module's global section before the range is parsed
+// silently first, so the decoded text resolves extended instruction sets
+// and friendly names exactly as a full disassembly would, but only the
+// range's instructions produce text.  With
+// SPV_BINARY_TO_TEXT_OPTION_SHOW_BYTE_OFFSET, the emitted offsets are the
+// instructions' offsets in the full module.  Intended for showing one
+// function or a window of a large module without paying for the rest.
+spv_result_t spvBinaryToTextRange(const spv_const_context context,
+                                  const uint32_t* binary,
+                                  const size_t word_count,
+                                  const uint32_t options,
+                                  const size_t begin_offset,
+                                  const size_t end_offset, spv_text* text,
+                                  spv_diagnostic* diagnostic);
+
+// Like spvBinaryToTextRange, but decodes the single function whose
+// OpFunction result id is |function_id|, located through the function
+// index.  Returns SPV_ERROR_INVALID_LOOKUP if no function has that id.
+spv_result_t spvBinaryToTextFunction(const spv_const_context context,
+                                     const uint32_t* binary,
+                                     const size_t word_count,
+                                     const uint32_t options,
+                                     const uint32_t function_id,
+                                     spv_text* text,
+                                     spv_diagnostic* diagnostic);
+
+// Creates a streaming disassembler session over the given context, which
+// must outlive the session.  The session decodes a module that arrives
+// incrementally -- for example over a pipe -- and prints the text for each
+// instruction as soon as its words are available, so disassembly overlaps
+// with whatever is still producing the binary.  Because the text is printed
+// as it is produced, the options must include
+// SPV_BINARY_TO_TEXT_OPTION_PRINT, and must include neither
+// SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES nor
+// SPV_BINARY_TO_TEXT_OPTION_PARALLEL: both need the whole module before the
+// first line can be emitted.  Returns null if context is null or the
+// options are unsupported.
+spv_streaming_disassembler spvStreamingDisassemblerCreate(
+    const spv_const_context context, const uint32_t options);
+
+// Destroys the given streaming disassembler session.  This is a no-op if
+// disassembler is a null pointer.
+void spvStreamingDisassemblerDestroy(spv_streaming_disassembler disassembler);
+
+// Disassembles those complete instructions in the first |num_words| words
+// of |words| that earlier calls on this session have not yet disassembled.
+// The caller accumulates the words received so far in a single buffer and
+// passes the whole buffer after each chunk arrives; the buffer may have
+// been reallocated between calls.  Pass |input_complete| as true once no
+// more words will arrive, so that a truncated trailing instruction is
+// diagnosed rather than awaited.  On the first error, returns the error
+// code and writes a diagnostic into *diagnostic if diagnostic is non-null;
+// the session must not be used further.
+spv_result_t spvStreamingDisassemblerParse(
+    spv_streaming_disassembler disassembler, const uint32_t* words,
+    const size_t num_words, const bool input_complete,
+    spv_diagnostic* diagnostic);
+
 // Frees a binary stream from memory. This is a no-op if binary is a null
 // pointer.
 void spvBinaryDestroy(spv_binary binary);
@@ -497,12 +842,32 @@ typedef spv_result_t (*spv_parsed_header_fn_t)(
 // A pointer to a function that accepts a parsed SPIR-V instruction.
 // The parsed_instruction value is transient: it may be overwritten
 // or released immediately after the function has returned.  That also
-// applies to the words array member of the parsed instruction.  The
-// function should return SPV_SUCCESS if and only if parsing should
-// continue.
+// applies to the words and operands array members of the parsed
+// instruction: they are borrowed from storage the parser owns and
+// reuses for the next instruction.  The function should return
+// SPV_SUCCESS if and only if parsing should continue.
 typedef spv_result_t (*spv_parsed_instruction_fn_t)(
     void* user_data, const spv_parsed_instruction_t* parsed_instruction);
 
+// A pointer to a function that accepts a batch of parsed SPIR-V
+// instructions, in module order.  The batch and everything it points to --
+// the instruction array, each instruction's operands array, and their word
+// arrays -- is transient: it may be overwritten or released immediately
+// after the function has returned.  The operand storage of a whole batch is
+// one contiguous array, so a consumer's loop over it stays cache-friendly.
+// The function should return SPV_SUCCESS if and only if parsing should
+// continue.
+typedef spv_result_t (*spv_parsed_instruction_batch_fn_t)(
+    void* user_data, const spv_parsed_instruction_t* instructions,
+    size_t num_instructions);
+
+// A pointer to a function that decides whether a parsed instruction is
+// kept by spvBinaryFilter.  Returns true to keep the instruction and
+// false to drop it.  The parsed_instruction value is transient, as for
+// spv_parsed_instruction_fn_t.
+typedef bool (*spv_instruction_filter_fn_t)(
+    void* user_data, const spv_parsed_instruction_t* parsed_instruction);
+
 // Parses a SPIR-V binary, specified as counted sequence of 32-bit words.
 // Parsing feedback is provided via two callbacks provided as function
 // pointers.  Each callback function pointer can be a null pointer, in
@@ -521,6 +886,185 @@ spv_result_t spvBinaryParse(const spv_const_context context, void* user_data,
                             spv_parsed_instruction_fn_t parse_instruction,
                             spv_diagnostic* diagnostic);
 
+// Like spvBinaryParse, but delivers the parsed instructions to
+// parse_instruction_batch in batches of up to an implementation-chosen
+// count, instead of one indirect call per instruction.  Consumers that do
+// non-trivial work per instruction see the same stream; consumers limited
+// by callback overhead loop tightly over each batch.  If a callback returns
+// anything other than SPV_SUCCESS, that status code is returned and no
+// further callbacks are issued; instructions parsed after the last
+// delivered batch are not reported when the parse fails.
+spv_result_t spvBinaryParseBatched(
+    const spv_const_context context, void* user_data, const uint32_t* words,
+    const size_t num_words, spv_parsed_header_fn_t parse_header,
+    spv_parsed_instruction_batch_fn_t parse_instruction_batch,
+    spv_diagnostic* diagnostic);
+
+// Parses a SPIR-V binary into a structure-of-arrays view of its
+// instructions, for consumers that scan one attribute across many
+// instructions rather than all attributes of each instruction in turn.
+// On success, stores the view into *pSoa; the caller is responsible for
+// destroying it with spvInstructionSoaDestroy().  For an invalid binary,
+// returns a status code other than SPV_SUCCESS, and if diagnostic is
+// non-null also emits a diagnostic.
+spv_result_t spvBinaryParseToSoa(const spv_const_context context,
+                                 const uint32_t* words, const size_t num_words,
+                                 spv_instruction_soa* pSoa,
+                                 spv_diagnostic* diagnostic);
+
+// Destroys a structure-of-arrays instruction view.  This is a no-op if soa
+// is a null pointer.
+void spvInstructionSoaDestroy(spv_instruction_soa soa);
+
+// Builds an index of the functions in a SPIR-V binary with one sequential
+// parse, recording for each function its result id, its word offset range,
+// and the word offset of each of its basic blocks.  Offsets index into
+// |words|.  On success, stores the index into *pIndex; the caller is
+// responsible for destroying it with spvFunctionIndexDestroy().  For an
+// invalid binary, returns a status code other than SPV_SUCCESS, and if
+// diagnostic is non-null also emits a diagnostic.
+spv_result_t spvBinaryBuildFunctionIndex(const spv_const_context context,
+                                         const uint32_t* words,
+                                         const size_t num_words,
+                                         spv_function_index* pIndex,
+                                         spv_diagnostic* diagnostic);
+
+// Destroys a function index.  This is a no-op if index is a null pointer.
+void spvFunctionIndexDestroy(spv_function_index index);
+
+// Parses a single function of a SPIR-V binary, given the word offset range
+// recorded for it by spvBinaryBuildFunctionIndex().  The header and the
+// module-level instructions preceding the first function are parsed first,
+// without issuing callbacks, so that the type and extended-instruction
+// import information needed to decode the function is available; the
+// parsed-instruction callback is then issued for each instruction in
+// [begin_word, end_word).  The cost is proportional to the module preamble
+// plus the one function, not the whole module.
+spv_result_t spvBinaryParseFunction(
+    const spv_const_context context, void* user_data, const uint32_t* words,
+    const size_t num_words, const uint32_t begin_word, const uint32_t end_word,
+    spv_parsed_instruction_fn_t parse_instruction, spv_diagnostic* diagnostic);
+
+// Computes a triage fingerprint of the module at |words| in one sweep: a
+// content hash over the endian-fixed words, the header fields worth routing
+// on, and counts of instructions, functions, entry points, and debug
+// instructions.  Instructions are stepped over by their word counts without
+// decoding operands, so the cost is one pass over the buffer, and no
+// grammar tables are consulted -- hence no context parameter.  Returns
+// SPV_ERROR_INVALID_BINARY for a module whose magic number or instruction
+// word counts do not add up; such a module needs a real parse to diagnose.
+spv_result_t spvBinaryGetFingerprint(const uint32_t* words,
+                                     const size_t num_words,
+                                     spv_module_fingerprint_t* pFingerprint);
+
+// Builds an index of the specializable constants in a SPIR-V binary with
+// one sequential parse, recording for each OpSpecConstant,
+// OpSpecConstantTrue, or OpSpecConstantFalse carrying a SpecId decoration
+// the word offsets that specialization must patch.  Offsets index into
+// |words|, which must be in host byte order.  On success, stores the index
+// into *pIndex; the caller is responsible for destroying it with
+// spvSpecConstantIndexDestroy().  For an invalid binary, returns a status
+// code other than SPV_SUCCESS, and if diagnostic is non-null also emits a
+// diagnostic.
+spv_result_t spvBinaryBuildSpecConstantIndex(const spv_const_context context,
+                                             const uint32_t* words,
+                                             const size_t num_words,
+                                             spv_spec_constant_index* pIndex,
+                                             spv_diagnostic* diagnostic);
+
+// Destroys a spec constant index.  This is a no-op if index is a null
+// pointer.
+void spvSpecConstantIndexDestroy(spv_spec_constant_index index);
+
+// Rewrites the given |num_values| specialization constant values into the
+// binary at |words|, which must be a (copy of the) module the index was
+// built from.  Numeric constants have their literal words overwritten,
+// truncating the value to the literal's width; boolean constants have
+// their opcode rewritten to OpSpecConstantTrue or OpSpecConstantFalse.
+// Values whose spec id does not occur in the index are ignored, matching
+// the IR-level specialization pass.  Only the indexed words are touched,
+// so applying a value set to a fresh copy of the buffer costs one patch
+// per constant rather than a parse of the module.  Returns
+// SPV_ERROR_INVALID_BINARY if the index does not fit in |num_words| words.
+spv_result_t spvBinarySpecialize(const spv_spec_constant_index index,
+                                 uint32_t* words, const size_t num_words,
+                                 const spv_spec_constant_value_t* values,
+                                 const size_t num_values);
+
+// Produces one specialized copy of the module at |words| for each of the
+// |num_sets| value sets, sharing a single spec constant index across all
+// of them: the module is scanned once, and each permutation then costs a
+// buffer copy plus one patch per constant.  Permutations are produced
+// concurrently on the available cores when there are enough of them to
+// benefit.  On success, stores into results[i] a freshly allocated binary
+// for value set i; the caller is responsible for destroying each with
+// spvBinaryDestroy().  On failure, no binaries are stored and every
+// results[i] is null.
+spv_result_t spvBinarySpecializeBatch(
+    const spv_const_context context, const uint32_t* words,
+    const size_t num_words, const spv_spec_constant_value_set_t* value_sets,
+    const size_t num_sets, spv_binary* results, spv_diagnostic* diagnostic);
+
+// Produces a copy of the module at |words| containing the header and only
+// those instructions the filter keeps.  The module is parsed once to find
+// instruction boundaries and make the keep/drop decisions; the output is
+// then assembled by copying the surviving word ranges, so the cost beyond
+// the parse is proportional to the bytes moved, not to IR construction.
+// The filter must not change which ids are defined if the result is to
+// remain valid; dropping only non-semantic instructions (such as debug
+// instructions) is the intended use.  On success, stores the new binary
+// into *pBinary; the caller is responsible for destroying it with
+// spvBinaryDestroy().  For an invalid binary, returns a status code other
+// than SPV_SUCCESS, and if diagnostic is non-null also emits a diagnostic.
+spv_result_t spvBinaryFilter(const spv_const_context context,
+                             const uint32_t* words, const size_t num_words,
+                             spv_instruction_filter_fn_t filter,
+                             void* user_data, spv_binary* pBinary,
+                             spv_diagnostic* diagnostic);
+
+// Produces a copy of the module at |words| with all debug instructions
+// removed: OpSource and friends, OpString, OpName, OpMemberName, OpLine,
+// OpNoLine, and OpModuleProcessed.  Equivalent to the optimizer's
+// strip-debug pass, but implemented with spvBinaryFilter, so it costs one
+// parse and a compacting copy instead of IR materialization.  On success,
+// stores the new binary into *pBinary; the caller is responsible for
+// destroying it with spvBinaryDestroy().
+spv_result_t spvBinaryStripDebugInfo(const spv_const_context context,
+                                     const uint32_t* words,
+                                     const size_t num_words,
+                                     spv_binary* pBinary,
+                                     spv_diagnostic* diagnostic);
+
+// Computes an instruction-aligned delta that rewrites the module at
+// |base_words| into the one at |target_words|.  Both modules are parsed
+// once, so the delta is composed of whole instructions: target
+// instructions that also occur in the base (and runs of consecutive ones)
+// become copy directives, and everything else is carried literally.  For
+// the typical update -- a handful of changed constants in an otherwise
+// identical module -- the delta is a few dozen words.  The delta is
+// returned as an spv_binary whose words are in the delta format understood
+// by spvBinaryApplyDelta; it is not a SPIR-V module.  The caller is
+// responsible for destroying it with spvBinaryDestroy().
+spv_result_t spvBinaryDiff(const spv_const_context context,
+                           const uint32_t* base_words,
+                           const size_t base_num_words,
+                           const uint32_t* target_words,
+                           const size_t target_num_words, spv_binary* pDelta,
+                           spv_diagnostic* diagnostic);
+
+// Reconstructs a target module from the module at |base_words| and a delta
+// produced by spvBinaryDiff.  Runs in time proportional to the output:
+// each delta directive is a bounds-checked copy from either the base or
+// the delta itself, with no parsing involved.  On success, stores the
+// reconstructed binary into *pTarget; the caller is responsible for
+// destroying it with spvBinaryDestroy().  Returns SPV_ERROR_INVALID_BINARY
+// for a malformed delta or one that does not fit the given base.
+spv_result_t spvBinaryApplyDelta(const uint32_t* base_words,
+                                 const size_t base_num_words,
+                                 const uint32_t* delta_words,
+                                 const size_t delta_num_words,
+                                 spv_binary* pTarget);
+
 #ifdef __cplusplus
 }
 #endif
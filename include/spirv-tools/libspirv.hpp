@@ -44,10 +44,103 @@ class ValidatorOptions {
     spvValidatorOptionsSetUniversalLimit(options_, limit_type, limit);
   }
 
+  // Sets the work budget; see spvValidatorOptionsSetBudget.
+  void SetBudget(const spv_validator_budget_t& budget) {
+    spvValidatorOptionsSetBudget(options_, &budget);
+  }
+
+  // Enables pipelined validation; see spvValidatorOptionsSetPipelinedChecks.
+  void SetPipelinedChecks(bool pipelined) {
+    spvValidatorOptionsSetPipelinedChecks(options_, pipelined);
+  }
+
  private:
   spv_validator_options options_;
 };
 
+// Owns the storage of an assembled binary adopted from the C API, so the
+// module words can be used without copying them out.  Movable but not
+// copyable.
+class OwnedBinary {
+ public:
+  OwnedBinary() : binary_(nullptr) {}
+  ~OwnedBinary() { spvBinaryDestroy(binary_); }
+
+  OwnedBinary(OwnedBinary&& other) : binary_(other.binary_) {
+    other.binary_ = nullptr;
+  }
+  OwnedBinary& operator=(OwnedBinary&& other) {
+    if (this != &other) {
+      spvBinaryDestroy(binary_);
+      binary_ = other.binary_;
+      other.binary_ = nullptr;
+    }
+    return *this;
+  }
+  OwnedBinary(const OwnedBinary&) = delete;
+  OwnedBinary& operator=(const OwnedBinary&) = delete;
+
+  // Releases the current buffer, if any, and takes ownership of |binary|,
+  // which may be null.
+  void Adopt(spv_binary binary) {
+    spvBinaryDestroy(binary_);
+    binary_ = binary;
+  }
+
+  // Returns the module words, or nullptr when no binary is held.
+  const uint32_t* data() const { return binary_ ? binary_->code : nullptr; }
+  // Returns the number of 32-bit words in the module.
+  size_t size() const { return binary_ ? binary_->wordCount : 0; }
+
+  const uint32_t* begin() const { return data(); }
+  const uint32_t* end() const { return data() + size(); }
+
+ private:
+  spv_binary binary_;
+};
+
+// Owns the storage of a disassembly result adopted from the C API, so the
+// text can be used without copying it out.  Movable but not copyable.
+class OwnedText {
+ public:
+  OwnedText() : text_(nullptr) {}
+  ~OwnedText() { spvTextDestroy(text_); }
+
+  OwnedText(OwnedText&& other) : text_(other.text_) { other.text_ = nullptr; }
+  OwnedText& operator=(OwnedText&& other) {
+    if (this != &other) {
+      spvTextDestroy(text_);
+      text_ = other.text_;
+      other.text_ = nullptr;
+    }
+    return *this;
+  }
+  OwnedText(const OwnedText&) = delete;
+  OwnedText& operator=(const OwnedText&) = delete;
+
+  // Releases the current buffer, if any, and takes ownership of |text|,
+  // which may be null.
+  void Adopt(spv_text text) {
+    spvTextDestroy(text_);
+    text_ = text;
+  }
+
+  // Returns the characters of the text, or nullptr when no text is held.
+  const char* data() const { return text_ ? text_->str : nullptr; }
+  // Returns the number of characters in the text.
+  size_t size() const { return text_ ? text_->length : 0; }
+
+ private:
+  spv_text text_;
+};
+
+// The canonical content hash of one function in a module, as computed by
+// SpirvTools::ComputeFunctionHashes.
+struct FunctionHash {
+  uint32_t id;    // Result id of the OpFunction.
+  uint64_t hash;  // Canonical hash of the function's instructions.
+};
+
 // C++ interface for SPIRV-Tools functionalities. It wraps the context
 // (including target environment and the corresponding SPIR-V grammar) and
 // provides methods for assembling, disassembling, and validating.
@@ -97,6 +190,25 @@ class SpirvTools {
                 std::vector<uint32_t>* binary,
                 uint32_t options = kDefaultAssembleOption) const;
 
+  // Like the vector-based overloads, but |binary| adopts the result buffer
+  // instead of copying it, so no second copy of the module is made.
+  // |binary| is kept untouched if assembling is unsuccessful.
+  bool Assemble(const std::string& text, OwnedBinary* binary,
+                uint32_t options = kDefaultAssembleOption) const;
+  bool Assemble(const char* text, size_t text_size, OwnedBinary* binary,
+                uint32_t options = kDefaultAssembleOption) const;
+
+  // Assembles each entry of |texts| and writes the result to the
+  // corresponding entry of |binaries|, distributing the modules over the
+  // available cores.  Every worker reuses this instance's context, so the
+  // grammar tables are set up once for the whole batch.  Returns true if and
+  // only if every module assembles successfully.  The entry for a failing
+  // module is left empty, and error messages are delivered to the registered
+  // message consumer in module order after all workers have finished.
+  bool AssembleBatch(const std::vector<std::string>& texts,
+                     std::vector<std::vector<uint32_t>>* binaries,
+                     uint32_t options = kDefaultAssembleOption) const;
+
   // Disassembles the given SPIR-V |binary| with the given |options| and writes
   // the assembly to |text|. Returns ture on successful disassembling. |text|
   // will be kept untouched if diassembling is unsuccessful.
@@ -107,6 +219,14 @@ class SpirvTools {
                    std::string* text,
                    uint32_t options = kDefaultDisassembleOption) const;
 
+  // Like the string-based overloads, but |text| adopts the result buffer
+  // instead of copying it, so no second copy of the disassembly is made.
+  // |text| is kept untouched if disassembling is unsuccessful.
+  bool Disassemble(const std::vector<uint32_t>& binary, OwnedText* text,
+                   uint32_t options = kDefaultDisassembleOption) const;
+  bool Disassemble(const uint32_t* binary, size_t binary_size, OwnedText* text,
+                   uint32_t options = kDefaultDisassembleOption) const;
+
   // Validates the given SPIR-V |binary|. Returns true if no issues are found.
   // Otherwise, returns false and communicates issues via the message consumer
   // registered.
@@ -117,6 +237,44 @@ class SpirvTools {
   bool Validate(const uint32_t* binary, size_t binary_size,
                 const ValidatorOptions& options) const;
 
+  // Validates the given SPIR-V |binary| like Validate(), but reuses validator
+  // scratch state held by this instance: the state's containers are cleared
+  // without releasing their capacity between calls, which avoids rebuilding
+  // the validation machinery for every module.  Intended for services that
+  // validate many modules back to back.  Unlike the const methods, concurrent
+  // calls to this method on the same instance must be externally
+  // synchronized.
+  bool ValidatePooled(const uint32_t* binary, size_t binary_size);
+  // Like the previous overload, but takes an options object.
+  bool ValidatePooled(const uint32_t* binary, size_t binary_size,
+                      const ValidatorOptions& options);
+
+  // Validates each entry of |binaries|, distributing the modules over the
+  // available cores.  If |results| is not null, writes the per-module
+  // outcomes to the corresponding entries of |results|.  Returns true if and
+  // only if every module is valid.  Messages are delivered to the registered
+  // message consumer in module order after all workers have finished.
+  bool ValidateBatch(const std::vector<std::vector<uint32_t>>& binaries,
+                     std::vector<bool>* results = nullptr) const;
+
+  // Computes a canonical content hash for every function in |binary| and
+  // writes them to |hashes| in module order.  Returns true on success;
+  // |hashes| is kept untouched if the binary does not parse.
+  //
+  // The hash covers the function's instructions with every id operand
+  // replaced by its first-use index within the function, and with line
+  // debug instructions (OpLine, OpNoLine) skipped, so functions that are
+  // identical up to id renaming and debug info hash equal regardless of
+  // which module they come from.  Ids defined outside the function are
+  // normalized positionally as well, so equal hashes identify candidates
+  // for deduplication; a byte-level confirmation of the match (and of the
+  // referenced module-level definitions) remains the caller's job.
+  bool ComputeFunctionHashes(const std::vector<uint32_t>& binary,
+                             std::vector<FunctionHash>* hashes) const;
+  // |binary_size| specifies the number of words in |binary|.
+  bool ComputeFunctionHashes(const uint32_t* binary, size_t binary_size,
+                             std::vector<FunctionHash>* hashes) const;
+
  private:
   struct Impl;  // Opaque struct for holding the data fields used by this class.
   std::unique_ptr<Impl> impl_;  // Unique pointer to implementation data.
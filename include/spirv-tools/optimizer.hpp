@@ -15,6 +15,7 @@
 #ifndef SPIRV_TOOLS_OPTIMIZER_HPP_
 #define SPIRV_TOOLS_OPTIMIZER_HPP_
 
+#include <iosfwd>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -28,6 +29,11 @@ namespace spvtools {
 // (including target environment and the corresponding SPIR-V grammar) and
 // provides methods for registering optimization passes and optimizing.
 //
+// An instance may be reused to optimize many modules: the type hierarchy
+// interned and the constants folded while optimizing one module are kept and
+// reused for the following Run() calls, which pays off when the modules are
+// structurally similar, as in a batch of specializations of one shader.
+//
 // Instances of this class provides basic thread-safety guarantee.
 class Optimizer {
  public:
@@ -72,6 +78,12 @@ class Optimizer {
   // invoked once for each message communicated from the library.
   void SetMessageConsumer(MessageConsumer consumer);
 
+  // Measures the wall time, instruction counts and IR memory growth of each
+  // registered pass during Run() and writes a one-line report per pass to
+  // |out|. Pass nullptr to disable reporting (the default). The stream must
+  // outlive this instance.
+  Optimizer& SetTimeReport(std::ostream* out);
+
   // Registers the given |pass| to this optimizer. Passes will be run in the
   // exact order of registration. The token passed in will be consumed by this
   // method.
@@ -88,6 +100,37 @@ class Optimizer {
   bool Run(const uint32_t* original_binary, size_t original_binary_size,
            std::vector<uint32_t>* optimized_binary) const;
 
+  // Optimizes the SPIR-V module in |binary| in place.  The vector is both
+  // the input and the output: when no pass changes the module it is left
+  // untouched, and otherwise the optimized module is moved into it, so no
+  // extra copy of the module is made either way.  Returns true on
+  // successful optimization; on failure the contents of |binary| are
+  // unspecified.
+  bool Run(std::vector<uint32_t>* binary) const;
+
+  // Optimizes the SPIR-V module in the mutable buffer |binary|, whose word
+  // count is in |*num_words|.  When the optimized module is no larger than
+  // the original, the result is written back into |binary| and |*num_words|
+  // is set to its word count; this is the common case for pipelines that
+  // only shrink the module (e.g. strip or compact pipelines) and lets
+  // callers optimize buffers they already own, such as mapped caches.  When
+  // the result is larger, it is moved into |*overflow_binary| instead and
+  // |*num_words| is set to zero.  |overflow_binary| may be null when the
+  // pipeline is known not to grow the module; a result that then does not
+  // fit fails the run.  Returns true on successful optimization.
+  bool Run(uint32_t* binary, size_t* num_words,
+           std::vector<uint32_t>* overflow_binary) const;
+
+  // Validates the SPIR-V module |original_binary| and, when it is valid,
+  // optimizes it like Run().  The binary is decoded exactly once: the same
+  // parse feeds both the validator and the optimizer's IR builder, so a
+  // validate-then-optimize pipeline does not pay for a second decode.
+  // Returns false when validation fails (validation diagnostics go to the
+  // message consumer and no pass is run) or when optimization fails.
+  bool RunValidated(const uint32_t* original_binary,
+                    size_t original_binary_size,
+                    std::vector<uint32_t>* optimized_binary) const;
+
  private:
   struct Impl;                  // Opaque struct for holding internal data.
   std::unique_ptr<Impl> impl_;  // Unique pointer to internal data.
@@ -185,6 +228,65 @@ Optimizer::PassToken CreateUnifyConstantPass();
 // OpSpecConstantOp.
 Optimizer::PassToken CreateEliminateDeadConstantPass();
 
+// Creates an eliminate-dead-functions pass.
+// An eliminate-dead-functions pass removes every function that cannot be
+// reached from an entry point or from a function exported through the
+// LinkageAttributes decoration, along with the names and decorations that
+// reference the removed code. Linker-style shader composition commonly
+// leaves such unreachable helper functions behind.
+Optimizer::PassToken CreateEliminateDeadFunctionsPass();
+
+// Creates an aggressive dead code elimination pass.
+// The pass seeds liveness from the instructions in each function that must
+// execute for their side effects or their control flow role, propagates it
+// backwards over the def-use edges with a worklist, and removes every
+// unmarked instruction in one sweep, along with the names and decorations
+// that reference the removed code. Unlike eliminate-dead-constant, which
+// only considers the constant section, this prunes whole dead computation
+// regions such as those left behind by specialization.
+Optimizer::PassToken CreateAggressiveDCEPass();
+
+// Creates a local common subexpression elimination pass.
+// Within each basic block, the pass hashes every pure computation by its
+// opcode, type and operand ids, with the operands of commutative
+// instructions put in a canonical order, and replaces each duplicate with
+// the first equivalent result. Loads take part as well but their remembered
+// results are discarded at every instruction that may write memory. Run
+// after inlining, which tends to leave many repeated access chain, load and
+// arithmetic sequences behind.
+Optimizer::PassToken CreateLocalCSEPass();
+
+// Creates a loop-invariant code motion pass.
+// Within each natural loop that has a preheader, pure computations and loads
+// from read-only storage whose operands are all defined outside the loop are
+// moved into the preheader, so they execute once instead of on every
+// iteration. Integer division and remainder stay put since speculating them
+// past the loop guard could divide by zero. Run after inlining, which fills
+// loop bodies with recomputed invariant access chains and uniform loads.
+Optimizer::PassToken CreateLicmPass();
+
+// Creates an algebraic simplification pass.
+// A compact pattern table maps opcodes to rewrites whose result is an id
+// that already exists: arithmetic and bitwise identities such as x + 0,
+// x * 1 or x & 0, bitcast chains returning to the original type, and
+// composite construct/extract round-trips. Matches are processed through a
+// worklist that re-queues the users of every rewritten result, so patterns
+// exposed by one rewrite cascade without repeated full-module sweeps.
+// Floating-point rules are limited to rewrites exact for every input,
+// including -0, infinities and NaN. The retired instructions are left as
+// dead code for a following dead code elimination pass.
+Optimizer::PassToken CreateSimplifyPass();
+
+// Creates a local variable promotion (mem2reg) pass.
+// Function-storage variables that are only ever loaded and stored whole are
+// rewritten into SSA values: loads become uses of the reaching definition
+// and phis are placed on the pruned iterated dominance frontier of the
+// stores. Variables touched by access chains, decorations, memory access
+// operands, or whose address escapes are left in memory. Running this first
+// lets the CSE and dead code elimination passes see through what would
+// otherwise be opaque memory traffic.
+Optimizer::PassToken CreatePromoteLocalsPass();
+
 // Creates an inline pass.
 // An inline pass exhaustively inlines all function calls in all functions
 // designated as an entry point. The intent is to enable, albeit through
@@ -198,6 +300,16 @@ Optimizer::PassToken CreateInlinePass();
 // The pass remaps result ids to a compact and gapless range starting from %1.
 Optimizer::PassToken CreateCompactIdsPass();
 
+// Creates a canonicalize ids pass.
+// The pass remaps result ids to a compact range like the compact ids pass,
+// but numbers them from a structural traversal of the semantic sections
+// (entry points, then types/constants/globals, then each function's
+// instructions in order) instead of from raw module order.  Debug names and
+// annotation order therefore cannot influence the numbering, so modules
+// with equivalent code serialize to identical bytes -- which makes
+// content-addressed caches deduplicate them.
+Optimizer::PassToken CreateCanonicalizeIdsPass();
+
 }  // namespace spvtools
 
 #endif  // SPIRV_TOOLS_OPTIMIZER_HPP_
@@ -0,0 +1,62 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "allocator.h"
+
+namespace spvtools {
+
+spv_binary AllocateBinary(const spv_allocator_t& allocator, size_t num_words) {
+  if (!AllocatorIsSet(allocator)) {
+    // The global-heap path keeps the allocation style spvBinaryDestroy
+    // expects for results with no allocator recorded.
+    spv_binary binary = new spv_binary_t();
+    binary->code = new uint32_t[num_words];
+    binary->wordCount = num_words;
+    return binary;
+  }
+  spv_binary binary =
+      static_cast<spv_binary>(AllocatorAlloc(allocator, sizeof(spv_binary_t)));
+  if (!binary) return nullptr;
+  binary->code = static_cast<uint32_t*>(
+      AllocatorAlloc(allocator, num_words * sizeof(uint32_t)));
+  if (!binary->code) {
+    AllocatorFree(allocator, binary, sizeof(spv_binary_t));
+    return nullptr;
+  }
+  binary->wordCount = num_words;
+  binary->allocator = allocator;
+  return binary;
+}
+
+spv_text AllocateText(const spv_allocator_t& allocator, size_t length) {
+  if (!AllocatorIsSet(allocator)) {
+    spv_text text = new spv_text_t();
+    text->str = new char[length + 1];
+    text->length = length;
+    return text;
+  }
+  spv_text text =
+      static_cast<spv_text>(AllocatorAlloc(allocator, sizeof(spv_text_t)));
+  if (!text) return nullptr;
+  text->str = static_cast<char*>(AllocatorAlloc(allocator, length + 1));
+  if (!text->str) {
+    AllocatorFree(allocator, text, sizeof(spv_text_t));
+    return nullptr;
+  }
+  text->length = length;
+  text->allocator = allocator;
+  return text;
+}
+
+}  // namespace spvtools
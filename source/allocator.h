@@ -0,0 +1,112 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_ALLOCATOR_H_
+#define LIBSPIRV_ALLOCATOR_H_
+
+#include <cstddef>
+#include <new>
+
+#include "spirv-tools/libspirv.h"
+
+namespace spvtools {
+
+// Returns true if |allocator| has callbacks installed, i.e. it names
+// something other than the global heap.
+inline bool AllocatorIsSet(const spv_allocator_t& allocator) {
+  return allocator.allocate != nullptr;
+}
+
+// Returns |num_bytes| of storage from |allocator|, or from the global heap
+// when no callbacks are installed.
+inline void* AllocatorAlloc(const spv_allocator_t& allocator,
+                            size_t num_bytes) {
+  if (allocator.allocate) {
+    return allocator.allocate(allocator.user_data, num_bytes);
+  }
+  return ::operator new(num_bytes);
+}
+
+// Releases |num_bytes| of storage at |pointer|, previously returned by
+// AllocatorAlloc for the same |allocator|.
+inline void AllocatorFree(const spv_allocator_t& allocator, void* pointer,
+                          size_t num_bytes) {
+  if (allocator.allocate) {
+    // A pool that reclaims its storage wholesale may leave the deallocate
+    // callback unset; individual frees are then no-ops.
+    if (allocator.deallocate) {
+      allocator.deallocate(allocator.user_data, pointer, num_bytes);
+    }
+    return;
+  }
+  (void)num_bytes;
+  ::operator delete(pointer);
+}
+
+// A std-compatible allocator dispensing storage from an spv_allocator_t, so
+// standard containers can live in a caller-supplied pool.  The allocator is
+// held by value, so it need not outlive the context it was copied from.
+// With no callbacks installed the global heap serves the requests as usual.
+template <typename T>
+class CAllocator {
+ public:
+  using value_type = T;
+
+  explicit CAllocator(const spv_allocator_t& allocator)
+      : allocator_(allocator) {}
+  template <typename U>
+  CAllocator(const CAllocator<U>& other) : allocator_(other.c_allocator()) {}
+
+  T* allocate(size_t count) {
+    return static_cast<T*>(AllocatorAlloc(allocator_, count * sizeof(T)));
+  }
+  void deallocate(T* pointer, size_t count) {
+    AllocatorFree(allocator_, pointer, count * sizeof(T));
+  }
+
+  const spv_allocator_t& c_allocator() const { return allocator_; }
+
+  template <typename U>
+  struct rebind {
+    typedef CAllocator<U> other;
+  };
+
+ private:
+  spv_allocator_t allocator_;
+};
+
+template <typename T, typename U>
+inline bool operator==(const CAllocator<T>& lhs, const CAllocator<U>& rhs) {
+  return lhs.c_allocator().user_data == rhs.c_allocator().user_data &&
+         lhs.c_allocator().allocate == rhs.c_allocator().allocate &&
+         lhs.c_allocator().deallocate == rhs.c_allocator().deallocate;
+}
+
+template <typename T, typename U>
+inline bool operator!=(const CAllocator<T>& lhs, const CAllocator<U>& rhs) {
+  return !(lhs == rhs);
+}
+
+// Allocates an spv_binary with room for |num_words| module words from
+// |allocator|, recording in the result how it was allocated so that
+// spvBinaryDestroy releases it the same way.  Returns null on failure.
+spv_binary AllocateBinary(const spv_allocator_t& allocator, size_t num_words);
+
+// As AllocateBinary, but for a text result holding |length| characters plus
+// a terminating null.
+spv_text AllocateText(const spv_allocator_t& allocator, size_t length);
+
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_ALLOCATOR_H_
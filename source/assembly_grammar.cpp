@@ -25,55 +25,6 @@
 
 namespace {
 
-/// @brief Parses a mask expression string for the given operand type.
-///
-/// A mask expression is a sequence of one or more terms separated by '|',
-/// where each term a named enum value for the given type.  No whitespace
-/// is permitted.
-///
-/// On success, the value is written to pValue.
-///
-/// @param[in] operandTable operand lookup table
-/// @param[in] type of the operand
-/// @param[in] textValue word of text to be parsed
-/// @param[out] pValue where the resulting value is written
-///
-/// @return result code
-spv_result_t spvTextParseMaskOperand(const spv_operand_table operandTable,
-                                     const spv_operand_type_t type,
-                                     const char* textValue, uint32_t* pValue) {
-  if (textValue == nullptr) return SPV_ERROR_INVALID_TEXT;
-  size_t text_length = strlen(textValue);
-  if (text_length == 0) return SPV_ERROR_INVALID_TEXT;
-  const char* text_end = textValue + text_length;
-
-  // We only support mask expressions in ASCII, so the separator value is a
-  // char.
-  const char separator = '|';
-
-  // Accumulate the result by interpreting one word at a time, scanning
-  // from left to right.
-  uint32_t value = 0;
-  const char* begin = textValue;  // The left end of the current word.
-  const char* end = nullptr;  // One character past the end of the current word.
-  do {
-    end = std::find(begin, text_end, separator);
-
-    spv_operand_desc entry = nullptr;
-    if (spvOperandTableNameLookup(operandTable, type, begin, end - begin,
-                                  &entry)) {
-      return SPV_ERROR_INVALID_TEXT;
-    }
-    value |= entry->value;
-
-    // Advance to the next word by skipping over the separator.
-    begin = end + 1;
-  } while (end != text_end);
-
-  *pValue = value;
-  return SPV_SUCCESS;
-}
-
 // Associates an opcode with its name.
 struct SpecConstantOpcodeEntry {
   SpvOp opcode;
@@ -173,6 +124,19 @@ bool AssemblyGrammar::isValid() const {
 
 spv_result_t AssemblyGrammar::lookupOpcode(const char* name,
                                            spv_opcode_desc* desc) const {
+  if (token_cache_) {
+    std::string& key = token_cache_->scratch_name;
+    key.assign(name);
+    const auto iter = token_cache_->opcodes.find(key);
+    if (iter != token_cache_->opcodes.end()) {
+      *desc = iter->second;
+      return SPV_SUCCESS;
+    }
+    if (auto error = spvOpcodeTableNameLookup(opcodeTable_, name, desc))
+      return error;
+    token_cache_->opcodes.emplace(key, *desc);
+    return SPV_SUCCESS;
+  }
   return spvOpcodeTableNameLookup(opcodeTable_, name, desc);
 }
 
@@ -184,6 +148,21 @@ spv_result_t AssemblyGrammar::lookupOpcode(SpvOp opcode,
 spv_result_t AssemblyGrammar::lookupOperand(spv_operand_type_t type,
                                             const char* name, size_t name_len,
                                             spv_operand_desc* desc) const {
+  if (token_cache_) {
+    AssemblerTokenCache::TypedKey& key = token_cache_->scratch_key;
+    key.type = uint32_t(type);
+    key.name.assign(name, name_len);
+    const auto iter = token_cache_->operands.find(key);
+    if (iter != token_cache_->operands.end()) {
+      *desc = iter->second;
+      return SPV_SUCCESS;
+    }
+    if (auto error =
+            spvOperandTableNameLookup(operandTable_, type, name, name_len, desc))
+      return error;
+    token_cache_->operands.emplace(key, *desc);
+    return SPV_SUCCESS;
+  }
   return spvOperandTableNameLookup(operandTable_, type, name, name_len, desc);
 }
 
@@ -220,11 +199,56 @@ spv_result_t AssemblyGrammar::lookupSpecConstantOpcode(SpvOp opcode) const {
 spv_result_t AssemblyGrammar::parseMaskOperand(const spv_operand_type_t type,
                                                const char* textValue,
                                                uint32_t* pValue) const {
-  return spvTextParseMaskOperand(operandTable_, type, textValue, pValue);
+  if (textValue == nullptr) return SPV_ERROR_INVALID_TEXT;
+  size_t text_length = strlen(textValue);
+  if (text_length == 0) return SPV_ERROR_INVALID_TEXT;
+  const char* text_end = textValue + text_length;
+
+  // We only support mask expressions in ASCII, so the separator value is a
+  // char.
+  const char separator = '|';
+
+  // Accumulate the result by interpreting one term at a time, scanning
+  // from left to right.  Each term references the input string in place,
+  // and resolves through lookupOperand so repeated terms hit the token
+  // cache when one is attached.
+  uint32_t value = 0;
+  const char* begin = textValue;  // The left end of the current term.
+  const char* end = nullptr;  // One character past the end of the current term.
+  do {
+    end = std::find(begin, text_end, separator);
+
+    spv_operand_desc entry = nullptr;
+    if (lookupOperand(type, begin, end - begin, &entry)) {
+      return SPV_ERROR_INVALID_TEXT;
+    }
+    value |= entry->value;
+
+    // Advance to the next term by skipping over the separator.
+    begin = end + 1;
+  } while (end != text_end);
+
+  *pValue = value;
+  return SPV_SUCCESS;
 }
 spv_result_t AssemblyGrammar::lookupExtInst(spv_ext_inst_type_t type,
                                             const char* textValue,
                                             spv_ext_inst_desc* extInst) const {
+  if (token_cache_) {
+    AssemblerTokenCache::TypedKey& key = token_cache_->scratch_key;
+    key.type = uint32_t(type);
+    key.name.assign(textValue);
+    const auto iter = token_cache_->ext_insts.find(key);
+    if (iter != token_cache_->ext_insts.end()) {
+      *extInst = iter->second;
+      return SPV_SUCCESS;
+    }
+    if (auto error =
+            spvExtInstTableNameLookup(extInstTable_, type, textValue, extInst))
+      return error;
+    token_cache_->ext_insts.emplace(key, *extInst);
+    return SPV_SUCCESS;
+  }
   return spvExtInstTableNameLookup(extInstTable_, type, textValue, extInst);
 }
 
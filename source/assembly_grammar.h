@@ -15,6 +15,9 @@
 #ifndef LIBSPIRV_ASSEMBLY_GRAMMAR_H_
 #define LIBSPIRV_ASSEMBLY_GRAMMAR_H_
 
+#include <string>
+#include <unordered_map>
+
 #include "operand.h"
 #include "spirv-tools/libspirv.h"
 #include "spirv/1.2/spirv.h"
@@ -22,15 +25,57 @@
 
 namespace libspirv {
 
+// Memoizes successful name lookups into the grammar tables.  The map keys
+// double as an interned keyword table: every distinct opcode, operand, or
+// extended-instruction name seen is stored once, and later occurrences of
+// the same token resolve with one hash probe instead of a table search.
+// Retained across assembly runs by an assembler session (spv_assembler),
+// this makes warm-cache assembly of similar modules approach pure encode
+// speed.  A cache is not thread safe; it belongs to one session.
+class AssemblerTokenCache {
+ public:
+  // A name qualified by the enum (operand or ext-inst) type it was looked
+  // up under.  The same spelling may resolve differently per type.
+  struct TypedKey {
+    uint32_t type;
+    std::string name;
+    bool operator==(const TypedKey& that) const {
+      return type == that.type && name == that.name;
+    }
+  };
+  struct TypedKeyHash {
+    size_t operator()(const TypedKey& key) const {
+      return std::hash<std::string>()(key.name) ^
+             (key.type * size_t(2654435761u));
+    }
+  };
+
+  // Memoized successful lookups.  Only hits are recorded: a failed lookup
+  // is a reportable error in the source, not a hot path.
+  std::unordered_map<std::string, spv_opcode_desc> opcodes;
+  std::unordered_map<TypedKey, spv_operand_desc, TypedKeyHash> operands;
+  std::unordered_map<TypedKey, spv_ext_inst_desc, TypedKeyHash> ext_insts;
+
+  // Scratch keys reused across probes, so a lookup never allocates for the
+  // token text (the keys keep their high-water-mark capacity).  Safe
+  // because a cache serves a single single-threaded session.
+  std::string scratch_name;
+  TypedKey scratch_key;
+};
+
 // Encapsulates the grammar to use for SPIR-V assembly.
 // Contains methods to query for valid instructions and operands.
 class AssemblyGrammar {
  public:
-  explicit AssemblyGrammar(const spv_const_context context)
+  // If |token_cache| is non-null, name lookups consult and populate it; see
+  // AssemblerTokenCache.  The cache must outlive this grammar.
+  explicit AssemblyGrammar(const spv_const_context context,
+                           AssemblerTokenCache* token_cache = nullptr)
       : target_env_(context->target_env),
         operandTable_(context->operand_table),
         opcodeTable_(context->opcode_table),
-        extInstTable_(context->ext_inst_table) {}
+        extInstTable_(context->ext_inst_table),
+        token_cache_(token_cache) {}
 
   // Returns true if the internal tables have been initialized with valid data.
   bool isValid() const;
@@ -112,6 +157,8 @@ class AssemblyGrammar {
   const spv_operand_table operandTable_;
   const spv_opcode_table opcodeTable_;
   const spv_ext_inst_table extInstTable_;
+  // Session-owned lookup memo, or null when assembling without a session.
+  AssemblerTokenCache* const token_cache_;
 };
 }
 
@@ -15,14 +15,17 @@
 #include "binary.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstring>
-#include <iterator>
 #include <limits>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "allocator.h"
 #include "assembly_grammar.h"
+#include "call_trace.h"
 #include "diagnostic.h"
 #include "ext_inst.h"
 #include "opcode.h"
@@ -30,6 +33,7 @@
 #include "spirv/1.2/spirv.h"
 #include "spirv_constant.h"
 #include "spirv_endian.h"
+#include "tracing.h"
 
 spv_result_t spvBinaryHeaderGet(const spv_const_binary binary,
                                 const spv_endianness_t endian,
@@ -53,19 +57,47 @@ spv_result_t spvBinaryHeaderGet(const spv_const_binary binary,
 
 namespace {
 
+// Returns true if the given operand type is decoded by the flattened
+// fast path in Parser::tryParseSimpleOperands: a required single-word
+// operand whose parsing never rewrites the expected-operand pattern.
+bool IsSimpleOperandType(const spv_operand_type_t type) {
+  switch (type) {
+    case SPV_OPERAND_TYPE_TYPE_ID:
+    case SPV_OPERAND_TYPE_RESULT_ID:
+    case SPV_OPERAND_TYPE_ID:
+    case SPV_OPERAND_TYPE_SCOPE_ID:
+    case SPV_OPERAND_TYPE_MEMORY_SEMANTICS_ID:
+    case SPV_OPERAND_TYPE_LITERAL_INTEGER:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Number of instructions accumulated before a pending batch is delivered
+// to a batch callback.  Large enough to amortize the call overhead, small
+// enough to keep the batch storage within cache-friendly bounds.
+const size_t kParseBatchSize = 256;
+
 // A SPIR-V binary parser.  A parser instance communicates detailed parse
 // results via callbacks.
 class Parser {
  public:
-  // The user_data value is provided to the callbacks as context.
+  // The user_data value is provided to the callbacks as context.  When
+  // |parsed_batch_fn| is non-null it takes the place of
+  // |parsed_instruction_fn|, and parsed instructions are accumulated and
+  // delivered in batches; see spvBinaryParseBatched.
   Parser(const spv_const_context context, void* user_data,
          spv_parsed_header_fn_t parsed_header_fn,
-         spv_parsed_instruction_fn_t parsed_instruction_fn)
+         spv_parsed_instruction_fn_t parsed_instruction_fn,
+         spv_parsed_instruction_batch_fn_t parsed_batch_fn = nullptr)
       : grammar_(context),
         consumer_(context->consumer),
         user_data_(user_data),
         parsed_header_fn_(parsed_header_fn),
-        parsed_instruction_fn_(parsed_instruction_fn) {}
+        parsed_instruction_fn_(parsed_instruction_fn),
+        parsed_batch_fn_(parsed_batch_fn),
+        suppress_callbacks_(false) {}
 
   // Parses the specified binary SPIR-V module, issuing callbacks on a parsed
   // header and for each parsed instruction.  Returns SPV_SUCCESS on success.
@@ -73,12 +105,46 @@ class Parser {
   spv_result_t parse(const uint32_t* words, size_t num_words,
                      spv_diagnostic* diagnostic);
 
+  // Parses a module that arrives incrementally.  The caller accumulates the
+  // words received so far in a single buffer and passes the whole buffer on
+  // every call; the parser remembers how far it has parsed, so each
+  // instruction is reported exactly once even though the buffer may have
+  // been reallocated between calls.  When |input_complete| is false, a
+  // trailing partial header or instruction is left for a later call instead
+  // of being diagnosed as truncation.  Returns SPV_SUCCESS if all complete
+  // instructions parsed cleanly; otherwise returns an error code and issues
+  // a diagnostic.
+  spv_result_t parseAvailable(const uint32_t* words, size_t num_words,
+                              bool input_complete);
+
+  // Parses one function of the module, given the word offset range recorded
+  // for it by a prior full parse (see spvBinaryBuildFunctionIndex).  The
+  // header and the module-level instructions preceding the first OpFunction
+  // are parsed first without issuing callbacks, so that the type and import
+  // tables needed to decode the function are available; the
+  // parsed-instruction callback is then issued for each instruction in
+  // [begin_word, end_word).  Returns SPV_SUCCESS on success.  Otherwise
+  // returns an error code and issues a diagnostic.
+  spv_result_t parseFunction(const uint32_t* words, size_t num_words,
+                             size_t begin_word, size_t end_word,
+                             spv_diagnostic* diagnostic);
+
  private:
   // All remaining methods work on the current module parse state.
 
   // Like the parse method, but works on the current module parse state.
   spv_result_t parseModule();
 
+  // Like the parseFunction method, but works on the current module parse
+  // state.
+  spv_result_t parseFunctionRange(size_t begin_word, size_t end_word);
+
+  // Checks the magic number, determines the endianness, and processes the
+  // module header, issuing the parsed-header callback.  Assumes at least
+  // the header words are present.  On failure, returns an error code and
+  // issues a diagnostic.
+  spv_result_t parseHeader();
+
   // Parses an instruction at the current position of the binary.  Assumes
   // the header has been parsed, the endian has been set, and the word index is
   // still in range.  Advances the parsing position past the instruction, and
@@ -87,22 +153,70 @@ class Parser {
   // On failure, returns an error code and issues a diagnostic.
   spv_result_t parseInstruction();
 
+  // Appends the given instruction to the pending batch, copying its operands
+  // into the batch operand slab.  Only used when a batch callback is set.
+  void appendToBatch(const spv_parsed_instruction_t& inst);
+
+  // Delivers the pending batch, if any, to the batch callback, fixing up the
+  // operand pointers first.  Clears the batch.  Returns the callback's
+  // result, or SPV_SUCCESS if the batch was empty.
+  spv_result_t flushBatch();
+
   // Parses an instruction operand with the given type, for an instruction
   // starting at inst_offset words into the SPIR-V binary.
-  // If the SPIR-V binary is the same endianness as the host, then the
-  // endian_converted_inst_words parameter is ignored.  Otherwise, this method
-  // appends the words for this operand, converted to host native endianness,
-  // to the end of endian_converted_inst_words.  This method also updates the
-  // expected_operands parameter, and the scalar members of the inst parameter.
+  // This method updates the expected_operands parameter, and the scalar
+  // members of the inst parameter.
   // On success, returns SPV_SUCCESS, advances past the operand, and pushes a
   // new entry on to the operands vector.  Otherwise returns an error code and
   // issues a diagnostic.
   spv_result_t parseOperand(size_t inst_offset, spv_parsed_instruction_t* inst,
                             const spv_operand_type_t type,
-                            std::vector<uint32_t>* endian_converted_inst_words,
                             std::vector<spv_parsed_operand_t>* operands,
                             spv_operand_pattern_t* expected_operands);
 
+  // Parses the operands of an instruction with the generic pattern
+  // machinery, tracking the expected operand types in a mutable list.  Used
+  // for the opcodes that tryParseSimpleOperands does not handle.  On
+  // success, returns SPV_SUCCESS and advances past the operands.  Otherwise
+  // returns an error code and issues a diagnostic.
+  spv_result_t parseOperandsWithPattern(
+      const spv_opcode_desc opcode_desc, size_t inst_offset,
+      uint16_t inst_word_count, spv_parsed_instruction_t* inst,
+      std::vector<spv_parsed_operand_t>* operands);
+
+  // Tries to decode all the operands of an instruction with a flattened
+  // single-pass loop, without materializing the expected-operand pattern.
+  // This applies when the grammar entry for the opcode fixes the decoding up
+  // front: a prefix of required single-word operands whose parsing never
+  // rewrites the pattern, optionally followed by a run of Ids.  That covers
+  // the opcodes dominating decode time, such as OpLoad, OpStore, and
+  // OpAccessChain.  Returns false, leaving the parse position untouched, when
+  // the opcode needs the generic machinery (or its generic diagnostics).
+  // Otherwise decodes the operands exactly as parseOperand would, advances
+  // past them, sets *result, and returns true.
+  bool tryParseSimpleOperands(const spv_opcode_desc opcode_desc,
+                              size_t inst_offset, uint16_t inst_word_count,
+                              spv_parsed_instruction_t* inst,
+                              std::vector<spv_parsed_operand_t>* operands,
+                              spv_result_t* result);
+
+  // Points the parse state at a host-endian copy of the caller's words,
+  // bulk-converting any words that have not been converted yet.  Only
+  // called when the module's endianness differs from the host's.  After
+  // this, instruction decoding takes the same-endian fast path
+  // unconditionally; literal string operands, whose words are never
+  // endian-converted, are restored in place as they are parsed.
+  void convertInputToHostEndian(const uint32_t* words, size_t num_words);
+
+  // Byte-swaps the owned converted words in [begin, end), used to restore
+  // raw literal string bytes (and re-convert the words following a string)
+  // after bulk conversion.
+  void swapOwnedWords(size_t begin, size_t end) {
+    assert(_.requires_endian_conversion);
+    uint32_t* data = _.converted_words.data();
+    spvFixWords(data + begin, end - begin, _.endian, data + begin);
+  }
+
   // Records the numeric type for an operand according to the type information
   // associated with the given non-zero type Id.  This can fail if the type Id
   // is not a type Id, or if the type Id does not reference a scalar numeric
@@ -145,13 +259,15 @@ class Parser {
                         << _.word_index - inst_offset << ".";
   }
 
-  // Returns the endian-corrected word at the current position.
+  // Returns the word at the current position.
   uint32_t peek() const { return peekAt(_.word_index); }
 
-  // Returns the endian-corrected word at the given position.
+  // Returns the word at the given position.  No endian correction is
+  // needed: a foreign-endian stream is bulk-converted right after its
+  // header is parsed.
   uint32_t peekAt(size_t index) const {
     assert(index < _.num_words);
-    return spvFixWord(_.words[index], _.endian);
+    return _.words[index];
   }
 
   // Data members
@@ -162,6 +278,11 @@ class Parser {
   const spv_parsed_header_fn_t parsed_header_fn_;  // Parsed header callback
   const spv_parsed_instruction_fn_t
       parsed_instruction_fn_;  // Parsed instruction callback
+  const spv_parsed_instruction_batch_fn_t
+      parsed_batch_fn_;  // Batched parsed instruction callback
+  // Set while parseFunctionRange digests the module preamble: the
+  // instructions still update the parse tables, but are not reported.
+  bool suppress_callbacks_;
 
   // Describes the format of a typed literal number.
   struct NumberType {
@@ -178,7 +299,8 @@ class Parser {
           diagnostic(diagnostic_arg),
           word_index(0),
           endian(),
-          requires_endian_conversion(false) {}
+          requires_endian_conversion(false),
+          header_parsed(false) {}
     State() : State(0, 0, nullptr) {}
     const uint32_t* words;       // Words in the binary SPIR-V module.
     size_t num_words;            // Number of words in the module.
@@ -186,8 +308,13 @@ class Parser {
     size_t word_index;           // The current position in words.
     spv_endianness_t endian;     // The endianness of the binary.
     // Is the SPIR-V binary in a different endiannes from the host native
-    // endianness?
+    // endianness?  When true, the whole stream is bulk-converted into
+    // converted_words right after the header is parsed, and words points
+    // at that copy.
     bool requires_endian_conversion;
+    // Has the module header been parsed?  Only consulted by parseAvailable,
+    // which may be called before the header words have arrived.
+    bool header_parsed;
 
     // Maps a result ID to its type ID.  By convention:
     //  - a result ID that is a type definition maps to itself.
@@ -195,15 +322,38 @@ class Parser {
     std::unordered_map<uint32_t, uint32_t> id_to_type_id;
     // Maps a type ID to its number type description.
     std::unordered_map<uint32_t, NumberType> type_id_to_number_type_info;
-    // Maps an ExtInstImport id to the extended instruction type.
-    std::unordered_map<uint32_t, spv_ext_inst_type_t>
-        import_id_to_ext_inst_type;
+    // Maps an ExtInstImport id to the extended instruction type, indexed
+    // by the id.  Result ids are small and dense, so a flat array beats a
+    // hash map here.  SPV_EXT_INST_TYPE_NONE marks ids that are not import
+    // results.  The vector grows on demand as imports are recorded.
+    std::vector<spv_ext_inst_type_t> import_id_to_ext_inst_type;
+
+    // The host-endian copy of the caller's words, used when the module's
+    // endianness differs from the host's.
+    std::vector<uint32_t> converted_words;
+    // Scratch storage reused by parseInstruction, to avoid per-instruction
+    // heap allocation.  Holds the parsed operands of the current
+    // instruction.
+    std::vector<spv_parsed_operand_t> operands;
+
+    // Batch delivery accumulation, used only when a batch callback is set.
+    // The operands of every instruction in the batch live contiguously in
+    // batch_operand_slab; each instruction's operands pointer is fixed up
+    // from batch_operand_offsets when the batch is flushed, since the slab
+    // may reallocate while the batch accumulates.
+    std::vector<spv_parsed_instruction_t> batch_insts;
+    std::vector<spv_parsed_operand_t> batch_operand_slab;
+    std::vector<size_t> batch_operand_offsets;
   } _;
 };
 
 spv_result_t Parser::parse(const uint32_t* words, size_t num_words,
                            spv_diagnostic* diagnostic_arg) {
   _ = State(words, num_words, diagnostic_arg);
+  // Most instructions have fewer than 25 logical operands.  The scratch
+  // vector keeps its high-water-mark capacity across instructions, so this
+  // is usually the only allocation it ever makes.
+  _.operands.reserve(25);
 
   const spv_result_t result = parseModule();
 
@@ -216,6 +366,25 @@ spv_result_t Parser::parse(const uint32_t* words, size_t num_words,
 spv_result_t Parser::parseModule() {
   if (!_.words) return diagnostic() << "Missing module.";
 
+  if (auto error = parseHeader()) return error;
+
+  // Process the instructions.
+  _.word_index = SPV_INDEX_INSTRUCTION;
+  while (_.word_index < _.num_words)
+    if (auto error = parseInstruction()) return error;
+
+  // Running off the end should already have been reported earlier.
+  assert(_.word_index == _.num_words);
+
+  // Deliver any instructions still pending in a partial batch.
+  if (parsed_batch_fn_) {
+    if (auto error = flushBatch()) return error;
+  }
+
+  return SPV_SUCCESS;
+}
+
+spv_result_t Parser::parseHeader() {
   if (_.num_words < SPV_INDEX_INSTRUCTION)
     return diagnostic() << "Module has incomplete header: only " << _.num_words
                         << " words instead of " << SPV_INDEX_INSTRUCTION;
@@ -244,13 +413,108 @@ spv_result_t Parser::parseModule() {
     }
   }
 
-  // Process the instructions.
-  _.word_index = SPV_INDEX_INSTRUCTION;
-  while (_.word_index < _.num_words)
+  if (_.requires_endian_conversion) {
+    // Bulk-convert the whole stream once up front (vectorized where the
+    // host supports it), so instruction decoding runs the same-endian fast
+    // path unconditionally instead of translating operand by operand.
+    convertInputToHostEndian(_.words, _.num_words);
+  }
+
+  return SPV_SUCCESS;
+}
+
+void Parser::convertInputToHostEndian(const uint32_t* words,
+                                      size_t num_words) {
+  const size_t already_converted = _.converted_words.size();
+  if (num_words > already_converted) {
+    _.converted_words.resize(num_words);
+    spvFixWords(words + already_converted, num_words - already_converted,
+                _.endian, _.converted_words.data() + already_converted);
+  }
+  _.words = _.converted_words.data();
+}
+
+spv_result_t Parser::parseAvailable(const uint32_t* words, size_t num_words,
+                                    bool input_complete) {
+  _.words = words;
+  _.num_words = num_words;
+
+  if (_.header_parsed && _.requires_endian_conversion) {
+    // Convert any newly arrived words and re-point at the converted copy.
+    convertInputToHostEndian(words, num_words);
+  }
+
+  if (!_.header_parsed) {
+    if (_.num_words < SPV_INDEX_INSTRUCTION && !input_complete)
+      return SPV_SUCCESS;  // Wait for the rest of the header.
+    if (!_.words) return diagnostic() << "Missing module.";
+    if (auto error = parseHeader()) return error;
+    _.header_parsed = true;
+    _.word_index = SPV_INDEX_INSTRUCTION;
+  }
+
+  while (_.word_index < _.num_words) {
+    if (!input_complete) {
+      // Wait until the instruction's words have all arrived.  A zero word
+      // count never completes, so hand it to parseInstruction, which
+      // diagnoses it.
+      uint16_t inst_word_count = 0;
+      uint16_t opcode;
+      spvOpcodeSplit(peek(), &inst_word_count, &opcode);
+      if (inst_word_count != 0 &&
+          _.word_index + inst_word_count > _.num_words)
+        return SPV_SUCCESS;
+    }
     if (auto error = parseInstruction()) return error;
+  }
+  return SPV_SUCCESS;
+}
 
-  // Running off the end should already have been reported earlier.
-  assert(_.word_index == _.num_words);
+spv_result_t Parser::parseFunction(const uint32_t* words, size_t num_words,
+                                   size_t begin_word, size_t end_word,
+                                   spv_diagnostic* diagnostic_arg) {
+  _ = State(words, num_words, diagnostic_arg);
+
+  const spv_result_t result = parseFunctionRange(begin_word, end_word);
+
+  // Clear the module state.  The tables might be big.
+  _ = State();
+
+  return result;
+}
+
+spv_result_t Parser::parseFunctionRange(size_t begin_word, size_t end_word) {
+  if (!_.words) return diagnostic() << "Missing module.";
+
+  if (auto error = parseHeader()) return error;
+
+  if (begin_word < SPV_INDEX_INSTRUCTION || end_word > _.num_words ||
+      begin_word >= end_word) {
+    return diagnostic() << "Function range [" << begin_word << ", " << end_word
+                        << ") does not lie within the module.";
+  }
+
+  // Digest the module preamble up to the first function, so that the type
+  // and extended-instruction-import tables needed to decode the function
+  // are populated.  Its instructions are not reported.
+  _.word_index = SPV_INDEX_INSTRUCTION;
+  suppress_callbacks_ = true;
+  while (_.word_index < begin_word) {
+    uint16_t inst_word_count = 0;
+    uint16_t opcode = 0;
+    spvOpcodeSplit(peek(), &inst_word_count, &opcode);
+    if (opcode == SpvOpFunction) break;
+    if (auto error = parseInstruction()) {
+      suppress_callbacks_ = false;
+      return error;
+    }
+  }
+  suppress_callbacks_ = false;
+
+  // Parse the requested function.
+  _.word_index = begin_word;
+  while (_.word_index < end_word)
+    if (auto error = parseInstruction()) return error;
 
   return SPV_SUCCESS;
 }
@@ -262,24 +526,10 @@ spv_result_t Parser::parseInstruction() {
 
   const uint32_t first_word = peek();
 
-  // TODO(dneto): If it's too expensive to construct the following "words"
-  // and "operands" vectors for each instruction, each instruction, then make
-  // them class data members instead, and clear them here.
-
-  // If the module's endianness is different from the host native endianness,
-  // then converted_words contains the the endian-translated words in the
-  // instruction.
-  std::vector<uint32_t> endian_converted_words = {first_word};
-  if (_.requires_endian_conversion) {
-    // Most instructions have fewer than 25 words.
-    endian_converted_words.reserve(25);
-  }
-
   // After a successful parse of the instruction, the inst.operands member
   // will point to this vector's storage.
-  std::vector<spv_parsed_operand_t> operands;
-  // Most instructions have fewer than 25 logical operands.
-  operands.reserve(25);
+  std::vector<spv_parsed_operand_t>& operands = _.operands;
+  operands.clear();
 
   assert(_.word_index < _.num_words);
   // Decompose and check the first word.
@@ -298,6 +548,72 @@ spv_result_t Parser::parseInstruction() {
   const size_t inst_offset = _.word_index;
   _.word_index++;
 
+  spv_result_t simple_result = SPV_SUCCESS;
+  if (tryParseSimpleOperands(opcode_desc, inst_offset, inst_word_count, &inst,
+                             &operands, &simple_result)) {
+    if (simple_result != SPV_SUCCESS) return simple_result;
+  } else if (auto error = parseOperandsWithPattern(
+                 opcode_desc, inst_offset, inst_word_count, &inst, &operands)) {
+    return error;
+  }
+
+  recordNumberType(inst_offset, &inst);
+
+  // The instruction's words alias the underlying binary, which is already
+  // in host endianness.  This saves time and space.
+  inst.words = _.words + inst_offset;
+  inst.num_words = inst_word_count;
+
+  // We must wait until here to set this pointer, because the vector might
+  // have been be resized while we accumulated its elements.
+  inst.operands = operands.data();
+  inst.num_operands = uint16_t(operands.size());
+
+  // Issue the callback.  The callee should know that all the storage in inst
+  // is transient, and will disappear immediately afterward.
+  if (!suppress_callbacks_) {
+    if (parsed_batch_fn_) {
+      appendToBatch(inst);
+      if (_.batch_insts.size() >= kParseBatchSize) {
+        if (auto error = flushBatch()) return error;
+      }
+    } else if (parsed_instruction_fn_) {
+      if (auto error = parsed_instruction_fn_(user_data_, &inst)) return error;
+    }
+  }
+
+  return SPV_SUCCESS;
+}
+
+void Parser::appendToBatch(const spv_parsed_instruction_t& inst) {
+  // The instruction's words already alias the underlying binary, which
+  // outlives the batch.  The operands point at per-instruction scratch
+  // storage, so copy them into the batch slab; the operands pointer is
+  // fixed up at flush time, since the slab may reallocate until then.
+  _.batch_operand_offsets.push_back(_.batch_operand_slab.size());
+  _.batch_operand_slab.insert(_.batch_operand_slab.end(), inst.operands,
+                              inst.operands + inst.num_operands);
+  _.batch_insts.push_back(inst);
+}
+
+spv_result_t Parser::flushBatch() {
+  if (_.batch_insts.empty()) return SPV_SUCCESS;
+  for (size_t i = 0; i < _.batch_insts.size(); ++i) {
+    _.batch_insts[i].operands =
+        _.batch_operand_slab.data() + _.batch_operand_offsets[i];
+  }
+  const spv_result_t result = parsed_batch_fn_(user_data_, _.batch_insts.data(),
+                                               _.batch_insts.size());
+  _.batch_insts.clear();
+  _.batch_operand_slab.clear();
+  _.batch_operand_offsets.clear();
+  return result;
+}
+
+spv_result_t Parser::parseOperandsWithPattern(
+    const spv_opcode_desc opcode_desc, const size_t inst_offset,
+    const uint16_t inst_word_count, spv_parsed_instruction_t* inst,
+    std::vector<spv_parsed_operand_t>* operands) {
   // Maintains the ordered list of expected operand types.
   // For many instructions we only need the {numTypes, operandTypes}
   // entries in opcode_desc.  However, sometimes we need to modify
@@ -322,9 +638,8 @@ spv_result_t Parser::parseInstruction() {
 
     spv_operand_type_t type = spvTakeFirstMatchableOperand(&expected_operands);
 
-    if (auto error =
-            parseOperand(inst_offset, &inst, type, &endian_converted_words,
-                         &operands, &expected_operands)) {
+    if (auto error = parseOperand(inst_offset, inst, type, operands,
+                                  &expected_operands)) {
       return error;
     }
   }
@@ -345,46 +660,129 @@ spv_result_t Parser::parseInstruction() {
                         << " words instead.";
   }
 
-  // Check the computed length of the endian-converted words vector against
-  // the declared number of words in the instruction.  If endian conversion
-  // is required, then they should match.  If no endian conversion was
-  // performed, then the vector only contains the initial opcode/word-count
-  // word.
-  assert(!_.requires_endian_conversion ||
-         (inst_word_count == endian_converted_words.size()));
-  assert(_.requires_endian_conversion || (endian_converted_words.size() == 1));
-
-  recordNumberType(inst_offset, &inst);
+  return SPV_SUCCESS;
+}
 
-  if (_.requires_endian_conversion) {
-    // We must wait until here to set this pointer, because the vector might
-    // have been be resized while we accumulated its elements.
-    inst.words = endian_converted_words.data();
+bool Parser::tryParseSimpleOperands(const spv_opcode_desc opcode_desc,
+                                    const size_t inst_offset,
+                                    const uint16_t inst_word_count,
+                                    spv_parsed_instruction_t* inst,
+                                    std::vector<spv_parsed_operand_t>* operands,
+                                    spv_result_t* result) {
+  // The whole instruction must be in bounds: the generic path diagnoses
+  // truncated input.
+  if (inst_offset + inst_word_count > _.num_words) return false;
+
+  const spv_operand_type_t* const types = opcode_desc->operandTypes;
+  const uint16_t num_types = opcode_desc->numTypes;
+  uint16_t num_simple = 0;
+  while (num_simple < num_types && IsSimpleOperandType(types[num_simple]))
+    num_simple++;
+
+  const uint16_t num_operand_words = uint16_t(inst_word_count - 1);
+  if (num_operand_words < num_simple) {
+    // Missing required operands; the generic path diagnoses this.
+    return false;
+  }
+  if (num_operand_words == num_simple) {
+    // All words are covered by the simple prefix.  Any remaining grammar
+    // entries must be optional, else the generic path reports the
+    // missing-operand error.
+    if (num_simple < num_types && !spvOperandIsOptional(types[num_simple]))
+      return false;
   } else {
-    // If no conversion is required, then just point to the underlying binary.
-    // This saves time and space.
-    inst.words = _.words + inst_offset;
+    // Extra words are only handled here when they are a run of Ids, as for
+    // the indexes of OpAccessChain or the arguments of OpFunctionCall.
+    if (num_simple + 1 != num_types ||
+        types[num_simple] != SPV_OPERAND_TYPE_VARIABLE_ID)
+      return false;
   }
-  inst.num_words = inst_word_count;
 
-  // We must wait until here to set this pointer, because the vector might
-  // have been be resized while we accumulated its elements.
-  inst.operands = operands.data();
-  inst.num_operands = uint16_t(operands.size());
+  const SpvOp opcode = static_cast<SpvOp>(inst->opcode);
+  for (uint16_t i = 0; i < num_operand_words; i++) {
+    const spv_operand_type_t type =
+        (i < num_simple) ? types[i] : SPV_OPERAND_TYPE_ID;
+    const uint32_t word = peek();
+
+    spv_parsed_operand_t parsed_operand;
+    parsed_operand.offset = uint16_t(_.word_index - inst_offset);
+    parsed_operand.num_words = 1;
+    parsed_operand.type = type;
+    parsed_operand.number_kind = SPV_NUMBER_NONE;
+    parsed_operand.number_bit_width = 0;
+
+    // Decode the word exactly as parseOperand would.
+    switch (type) {
+      case SPV_OPERAND_TYPE_TYPE_ID:
+        if (!word) {
+          *result = diagnostic(SPV_ERROR_INVALID_ID) << "Error: Type Id is 0";
+          return true;
+        }
+        inst->type_id = word;
+        break;
 
-  // Issue the callback.  The callee should know that all the storage in inst
-  // is transient, and will disappear immediately afterward.
-  if (parsed_instruction_fn_) {
-    if (auto error = parsed_instruction_fn_(user_data_, &inst)) return error;
+      case SPV_OPERAND_TYPE_RESULT_ID:
+        if (!word) {
+          *result = diagnostic(SPV_ERROR_INVALID_ID) << "Error: Result Id is 0";
+          return true;
+        }
+        inst->result_id = word;
+        // Save the result ID to type ID mapping.
+        // In the grammar, type ID always appears before result ID.
+        if (_.id_to_type_id.find(inst->result_id) != _.id_to_type_id.end()) {
+          *result = diagnostic(SPV_ERROR_INVALID_ID)
+                    << "Id " << inst->result_id << " is defined more than once";
+          return true;
+        }
+        // Record it.
+        // A regular value maps to its type.  Some instructions (e.g. OpLabel)
+        // have no type Id, and will map to 0.  The result Id for a
+        // type-generating instruction (e.g. OpTypeInt) maps to itself.
+        _.id_to_type_id[inst->result_id] =
+            spvOpcodeGeneratesType(opcode) ? inst->result_id : inst->type_id;
+        break;
+
+      case SPV_OPERAND_TYPE_ID:
+        if (!word) {
+          *result = diagnostic(SPV_ERROR_INVALID_ID) << "Id is 0";
+          return true;
+        }
+        break;
+
+      case SPV_OPERAND_TYPE_SCOPE_ID:
+      case SPV_OPERAND_TYPE_MEMORY_SEMANTICS_ID:
+        // Check for trivially invalid values.  The operand descriptions
+        // already have the word "ID" in them.
+        if (!word) {
+          *result = diagnostic() << spvOperandTypeStr(type) << " is 0";
+          return true;
+        }
+        break;
+
+      case SPV_OPERAND_TYPE_LITERAL_INTEGER:
+        // These are regular single-word literal integer operands.
+        // Post-parsing validation should check the range of the parsed value.
+        // It turns out they are always unsigned integers!
+        parsed_operand.number_kind = SPV_NUMBER_UNSIGNED_INT;
+        parsed_operand.number_bit_width = 32;
+        break;
+
+      default:
+        assert(false && "Unhandled simple operand type");
+        break;
+    }
+
+    operands->push_back(parsed_operand);
+    _.word_index++;
   }
 
-  return SPV_SUCCESS;
+  *result = SPV_SUCCESS;
+  return true;
 }
 
 spv_result_t Parser::parseOperand(size_t inst_offset,
                                   spv_parsed_instruction_t* inst,
                                   const spv_operand_type_t type,
-                                  std::vector<uint32_t>* words,
                                   std::vector<spv_parsed_operand_t>* operands,
                                   spv_operand_pattern_t* expected_operands) {
   const SpvOp opcode = static_cast<SpvOp>(inst->opcode);
@@ -409,10 +807,6 @@ spv_result_t Parser::parseOperand(size_t inst_offset,
 
   const uint32_t word = peek();
 
-  // Do the words in this operand have to be converted to native endianness?
-  // True for all but literal strings.
-  bool convert_operand_endianness = true;
-
   switch (type) {
     case SPV_OPERAND_TYPE_TYPE_ID:
       if (!word)
@@ -445,13 +839,16 @@ spv_result_t Parser::parseOperand(size_t inst_offset,
       if (opcode == SpvOpExtInst && parsed_operand.offset == 3) {
         // The current word is the extended instruction set Id.
         // Set the extended instruction set type for the current instruction.
-        auto ext_inst_type_iter = _.import_id_to_ext_inst_type.find(word);
-        if (ext_inst_type_iter == _.import_id_to_ext_inst_type.end()) {
+        const spv_ext_inst_type_t ext_inst_type =
+            word < _.import_id_to_ext_inst_type.size()
+                ? _.import_id_to_ext_inst_type[word]
+                : SPV_EXT_INST_TYPE_NONE;
+        if (ext_inst_type == SPV_EXT_INST_TYPE_NONE) {
           return diagnostic(SPV_ERROR_INVALID_ID)
                  << "OpExtInst set Id " << word
                  << " does not reference an OpExtInstImport result Id";
         }
-        inst->ext_inst_type = ext_inst_type_iter->second;
+        inst->ext_inst_type = ext_inst_type;
       }
       break;
 
@@ -542,7 +939,31 @@ spv_result_t Parser::parseOperand(size_t inst_offset,
 
     case SPV_OPERAND_TYPE_LITERAL_STRING:
     case SPV_OPERAND_TYPE_OPTIONAL_LITERAL_STRING: {
-      convert_operand_endianness = false;
+      if (_.requires_endian_conversion) {
+        // The stream was bulk-converted up front, but literal string words
+        // are never endian-converted.  Restore the raw bytes of the rest
+        // of this instruction; the words following the string, if any, are
+        // re-converted below once the string's length is known.
+        uint16_t inst_word_count = 0;
+        uint16_t split_opcode = 0;
+        spvOpcodeSplit(peekAt(inst_offset), &inst_word_count, &split_opcode);
+        size_t restored_end =
+            std::min(_.num_words, inst_offset + size_t(inst_word_count));
+        swapOwnedWords(_.word_index, restored_end);
+        const size_t restored_bytes =
+            sizeof(uint32_t) * (restored_end - _.word_index);
+        if (spv_strnlen_s(
+                reinterpret_cast<const char*>(_.words + _.word_index),
+                restored_bytes) == restored_bytes &&
+            restored_end < _.num_words) {
+          // No terminating null within the instruction's stated bounds.
+          // Restore the rest of the input, so the over-long string is
+          // diagnosed the same way as in a same-endian module.  The
+          // instruction is malformed, so the parse is about to end and
+          // nothing after the string will be read as converted words.
+          swapOwnedWords(restored_end, _.num_words);
+        }
+      }
       const char* string =
           reinterpret_cast<const char*>(_.words + _.word_index);
       // Compute the length of the string, but make sure we don't run off the
@@ -584,8 +1005,25 @@ spv_result_t Parser::parseOperand(size_t inst_offset,
         // We must have parsed a valid result ID.  It's a condition
         // of the grammar, and we only accept non-zero result Ids.
         assert(inst->result_id);
+        if (inst->result_id >= _.import_id_to_ext_inst_type.size()) {
+          _.import_id_to_ext_inst_type.resize(inst->result_id + 1,
+                                              SPV_EXT_INST_TYPE_NONE);
+        }
         _.import_id_to_ext_inst_type[inst->result_id] = ext_inst_type;
       }
+
+      if (_.requires_endian_conversion) {
+        // Re-convert the words of this instruction that follow the string,
+        // e.g. the interface ids of an OpEntryPoint.
+        uint16_t inst_word_count = 0;
+        uint16_t split_opcode = 0;
+        spvOpcodeSplit(peekAt(inst_offset), &inst_word_count, &split_opcode);
+        const size_t restored_end =
+            std::min(_.num_words, inst_offset + size_t(inst_word_count));
+        const size_t string_end =
+            std::min(_.word_index + string_num_words, restored_end);
+        swapOwnedWords(string_end, restored_end);
+      }
     } break;
 
     case SPV_OPERAND_TYPE_CAPABILITY:
@@ -687,21 +1125,6 @@ spv_result_t Parser::parseOperand(size_t inst_offset,
   if (_.num_words < index_after_operand)
     return exhaustedInputDiagnostic(inst_offset, opcode, type);
 
-  if (_.requires_endian_conversion) {
-    // Copy instruction words.  Translate to native endianness as needed.
-    if (convert_operand_endianness) {
-      const spv_endianness_t endianness = _.endian;
-      std::transform(_.words + _.word_index, _.words + index_after_operand,
-                     std::back_inserter(*words),
-                     [endianness](const uint32_t raw_word) {
-                       return spvFixWord(raw_word, endianness);
-                     });
-    } else {
-      words->insert(words->end(), _.words + _.word_index,
-                    _.words + index_after_operand);
-    }
-  }
-
   // Advance past the operand.
   _.word_index = index_after_operand;
 
@@ -749,32 +1172,816 @@ void Parser::recordNumberType(size_t inst_offset,
 
 }  // anonymous namespace
 
+namespace libspirv {
+
+struct StreamingBinaryParser::Impl {
+  Impl(const spv_const_context context, void* user_data,
+       spv_parsed_header_fn_t parsed_header,
+       spv_parsed_instruction_fn_t parsed_instruction)
+      : parser(context, user_data, parsed_header, parsed_instruction) {}
+
+  Parser parser;
+};
+
+StreamingBinaryParser::StreamingBinaryParser(
+    const spv_const_context context, void* user_data,
+    spv_parsed_header_fn_t parsed_header,
+    spv_parsed_instruction_fn_t parsed_instruction)
+    : impl_(new Impl(context, user_data, parsed_header, parsed_instruction)) {}
+
+StreamingBinaryParser::~StreamingBinaryParser() {}
+
+spv_result_t StreamingBinaryParser::Parse(const uint32_t* words,
+                                          size_t num_words,
+                                          bool input_complete) {
+  return impl_->parser.parseAvailable(words, num_words, input_complete);
+}
+
+}  // namespace libspirv
+
 spv_result_t spvBinaryParse(const spv_const_context context, void* user_data,
                             const uint32_t* code, const size_t num_words,
                             spv_parsed_header_fn_t parsed_header,
                             spv_parsed_instruction_fn_t parsed_instruction,
                             spv_diagnostic* diagnostic) {
+  libspirv::CallTraceBinaryParse(context->target_env, code, num_words);
   spv_context_t hijack_context = *context;
   if (diagnostic) {
     *diagnostic = nullptr;
     libspirv::UseDiagnosticAsMessageConsumer(&hijack_context, diagnostic);
   }
+  SPIRV_TRACE_SCOPE("parse");
   Parser parser(&hijack_context, user_data, parsed_header, parsed_instruction);
   return parser.parse(code, num_words, diagnostic);
 }
 
+spv_result_t spvBinaryParseBatched(
+    const spv_const_context context, void* user_data, const uint32_t* code,
+    const size_t num_words, spv_parsed_header_fn_t parsed_header,
+    spv_parsed_instruction_batch_fn_t parse_instruction_batch,
+    spv_diagnostic* diagnostic) {
+  libspirv::CallTraceBinaryParse(context->target_env, code, num_words);
+  spv_context_t hijack_context = *context;
+  if (diagnostic) {
+    *diagnostic = nullptr;
+    libspirv::UseDiagnosticAsMessageConsumer(&hijack_context, diagnostic);
+  }
+  SPIRV_TRACE_SCOPE("parse");
+  Parser parser(&hijack_context, user_data, parsed_header, nullptr,
+                parse_instruction_batch);
+  return parser.parse(code, num_words, diagnostic);
+}
+
+namespace {
+
+// Accumulates the structure-of-arrays instruction view during the
+// sequential parse made by spvBinaryParseToSoa.  The offset arrays carry
+// one leading entry so that entry n is always where instruction n begins.
+struct SoaBuilder {
+  SoaBuilder()
+      : word_offsets(1, SPV_INDEX_INSTRUCTION), operand_offsets(1, 0) {}
+
+  std::vector<uint16_t> opcodes;
+  std::vector<spv_ext_inst_type_t> ext_inst_types;
+  std::vector<uint32_t> type_ids;
+  std::vector<uint32_t> result_ids;
+  std::vector<uint32_t> word_offsets;
+  std::vector<uint32_t> operand_offsets;
+  std::vector<spv_parsed_operand_t> operands;
+};
+
+spv_result_t CollectSoaBatch(void* user_data,
+                             const spv_parsed_instruction_t* instructions,
+                             size_t num_instructions) {
+  auto* builder = static_cast<SoaBuilder*>(user_data);
+  for (size_t i = 0; i < num_instructions; ++i) {
+    const spv_parsed_instruction_t& inst = instructions[i];
+    builder->opcodes.push_back(inst.opcode);
+    builder->ext_inst_types.push_back(inst.ext_inst_type);
+    builder->type_ids.push_back(inst.type_id);
+    builder->result_ids.push_back(inst.result_id);
+    builder->word_offsets.push_back(builder->word_offsets.back() +
+                                    inst.num_words);
+    builder->operands.insert(builder->operands.end(), inst.operands,
+                             inst.operands + inst.num_operands);
+    builder->operand_offsets.push_back(
+        static_cast<uint32_t>(builder->operands.size()));
+  }
+  return SPV_SUCCESS;
+}
+
+// Returns a new[]-allocated copy of the vector's contents, or nullptr when
+// it is empty.
+template <typename T>
+T* CopyToNewArray(const std::vector<T>& source) {
+  if (source.empty()) return nullptr;
+  T* copy = new T[source.size()];
+  std::copy(source.begin(), source.end(), copy);
+  return copy;
+}
+
+}  // anonymous namespace
+
+spv_result_t spvBinaryParseToSoa(const spv_const_context context,
+                                 const uint32_t* words, const size_t num_words,
+                                 spv_instruction_soa* pSoa,
+                                 spv_diagnostic* diagnostic) {
+  if (!pSoa) return SPV_ERROR_INVALID_POINTER;
+
+  SoaBuilder builder;
+  if (auto error = spvBinaryParseBatched(context, &builder, words, num_words,
+                                         nullptr, CollectSoaBatch,
+                                         diagnostic)) {
+    return error;
+  }
+
+  spv_instruction_soa soa = new spv_instruction_soa_t();
+  soa->num_instructions = static_cast<uint32_t>(builder.opcodes.size());
+  soa->opcodes = CopyToNewArray(builder.opcodes);
+  soa->ext_inst_types = CopyToNewArray(builder.ext_inst_types);
+  soa->type_ids = CopyToNewArray(builder.type_ids);
+  soa->result_ids = CopyToNewArray(builder.result_ids);
+  // The offset arrays always have num_instructions + 1 entries.
+  soa->word_offsets = CopyToNewArray(builder.word_offsets);
+  soa->operand_offsets = CopyToNewArray(builder.operand_offsets);
+  soa->operands = CopyToNewArray(builder.operands);
+  *pSoa = soa;
+  return SPV_SUCCESS;
+}
+
+void spvInstructionSoaDestroy(spv_instruction_soa soa) {
+  if (!soa) return;
+  delete[] soa->opcodes;
+  delete[] soa->ext_inst_types;
+  delete[] soa->type_ids;
+  delete[] soa->result_ids;
+  delete[] soa->word_offsets;
+  delete[] soa->operand_offsets;
+  delete[] soa->operands;
+  delete soa;
+}
+
+namespace {
+
+// Accumulates the function index during the sequential parse made by
+// spvBinaryBuildFunctionIndex.  The parser reports every instruction in
+// order, so the word offset of each one can be recovered by accumulating
+// instruction sizes from the end of the header.
+struct FunctionIndexBuilder {
+  FunctionIndexBuilder() : word_offset(SPV_INDEX_INSTRUCTION) {}
+
+  size_t word_offset;  // Word offset of the next reported instruction.
+  std::vector<spv_indexed_function_t> functions;
+  std::vector<std::vector<spv_indexed_block_t>> function_blocks;
+};
+
+spv_result_t IndexParsedInstruction(void* user_data,
+                                    const spv_parsed_instruction_t* inst) {
+  auto* builder = static_cast<FunctionIndexBuilder*>(user_data);
+  const uint32_t offset = static_cast<uint32_t>(builder->word_offset);
+  builder->word_offset += inst->num_words;
+  switch (inst->opcode) {
+    case SpvOpFunction: {
+      spv_indexed_function_t function = {};
+      function.id = inst->result_id;
+      function.begin = offset;
+      builder->functions.push_back(function);
+      builder->function_blocks.push_back(std::vector<spv_indexed_block_t>());
+      break;
+    }
+    case SpvOpLabel:
+      if (!builder->functions.empty()) {
+        const spv_indexed_block_t block = {inst->result_id, offset};
+        builder->function_blocks.back().push_back(block);
+      }
+      break;
+    case SpvOpFunctionEnd:
+      if (!builder->functions.empty()) {
+        builder->functions.back().end = offset + inst->num_words;
+      }
+      break;
+    default:
+      break;
+  }
+  return SPV_SUCCESS;
+}
+
+}  // anonymous namespace
+
+spv_result_t spvBinaryBuildFunctionIndex(const spv_const_context context,
+                                         const uint32_t* words,
+                                         const size_t num_words,
+                                         spv_function_index* pIndex,
+                                         spv_diagnostic* diagnostic) {
+  if (!pIndex) return SPV_ERROR_INVALID_POINTER;
+
+  FunctionIndexBuilder builder;
+  if (auto error = spvBinaryParse(context, &builder, words, num_words, nullptr,
+                                  IndexParsedInstruction, diagnostic)) {
+    return error;
+  }
+
+  spv_function_index index = new spv_function_index_t();
+  index->num_functions = static_cast<uint32_t>(builder.functions.size());
+  index->functions = index->num_functions
+                         ? new spv_indexed_function_t[index->num_functions]
+                         : nullptr;
+  for (uint32_t i = 0; i < index->num_functions; ++i) {
+    index->functions[i] = builder.functions[i];
+    const auto& blocks = builder.function_blocks[i];
+    index->functions[i].num_blocks = static_cast<uint32_t>(blocks.size());
+    index->functions[i].blocks =
+        blocks.empty() ? nullptr : new spv_indexed_block_t[blocks.size()];
+    std::copy(blocks.begin(), blocks.end(), index->functions[i].blocks);
+  }
+  *pIndex = index;
+  return SPV_SUCCESS;
+}
+
+void spvFunctionIndexDestroy(spv_function_index index) {
+  if (!index) return;
+  for (uint32_t i = 0; i < index->num_functions; ++i) {
+    delete[] index->functions[i].blocks;
+  }
+  delete[] index->functions;
+  delete index;
+}
+
+spv_result_t spvBinaryParseFunction(
+    const spv_const_context context, void* user_data, const uint32_t* words,
+    const size_t num_words, const uint32_t begin_word, const uint32_t end_word,
+    spv_parsed_instruction_fn_t parse_instruction, spv_diagnostic* diagnostic) {
+  spv_context_t hijack_context = *context;
+  if (diagnostic) {
+    *diagnostic = nullptr;
+    libspirv::UseDiagnosticAsMessageConsumer(&hijack_context, diagnostic);
+  }
+  Parser parser(&hijack_context, user_data, nullptr, parse_instruction);
+  return parser.parseFunction(words, num_words, begin_word, end_word,
+                              diagnostic);
+}
+
+namespace {
+
+// Accumulates the spec constant index during the sequential parse made by
+// spvBinaryBuildSpecConstantIndex.  SpecId decorations precede the
+// constants they decorate in a valid module, so one pass first learns the
+// decorated result ids and then records the sites of the matching
+// OpSpecConstant* instructions.
+struct SpecConstantIndexBuilder {
+  SpecConstantIndexBuilder() : word_offset(SPV_INDEX_INSTRUCTION) {}
+
+  size_t word_offset;  // Word offset of the next reported instruction.
+  std::unordered_map<uint32_t, uint32_t> spec_id_by_result_id;
+  std::vector<spv_indexed_spec_constant_t> constants;
+};
+
+spv_result_t IndexSpecConstantInstruction(
+    void* user_data, const spv_parsed_instruction_t* inst) {
+  auto* builder = static_cast<SpecConstantIndexBuilder*>(user_data);
+  const uint32_t offset = static_cast<uint32_t>(builder->word_offset);
+  builder->word_offset += inst->num_words;
+  switch (inst->opcode) {
+    case SpvOpDecorate:
+      // OpDecorate <target-id> SpecId <literal>
+      if (inst->num_words == 4 && inst->words[2] == SpvDecorationSpecId) {
+        builder->spec_id_by_result_id[inst->words[1]] = inst->words[3];
+      }
+      break;
+    case SpvOpSpecConstant:
+    case SpvOpSpecConstantTrue:
+    case SpvOpSpecConstantFalse: {
+      const auto iter = builder->spec_id_by_result_id.find(inst->result_id);
+      if (iter == builder->spec_id_by_result_id.end()) break;
+      spv_indexed_spec_constant_t constant = {};
+      constant.spec_id = iter->second;
+      constant.result_id = inst->result_id;
+      constant.opcode_offset = offset;
+      if (inst->opcode == SpvOpSpecConstant) {
+        // Header word, type id, result id, then the literal words.
+        constant.literal_offset = offset + 3;
+        constant.num_literal_words = inst->num_words - 3;
+      }
+      builder->constants.push_back(constant);
+    } break;
+    default:
+      break;
+  }
+  return SPV_SUCCESS;
+}
+
+}  // anonymous namespace
+
+spv_result_t spvBinaryBuildSpecConstantIndex(const spv_const_context context,
+                                             const uint32_t* words,
+                                             const size_t num_words,
+                                             spv_spec_constant_index* pIndex,
+                                             spv_diagnostic* diagnostic) {
+  if (!pIndex) return SPV_ERROR_INVALID_POINTER;
+
+  // The recorded offsets are patched as raw host-order words, so a module
+  // the host would first have to byte-swap cannot be indexed.
+  spv_const_binary_t binary = {words, num_words};
+  spv_endianness_t endian;
+  if (SPV_SUCCESS == spvBinaryEndianness(&binary, &endian) &&
+      !spvIsHostEndian(endian)) {
+    spv_context_t hijack_context = *context;
+    if (diagnostic) {
+      *diagnostic = nullptr;
+      libspirv::UseDiagnosticAsMessageConsumer(&hijack_context, diagnostic);
+    }
+    return libspirv::DiagnosticStream({0, 0, 0}, hijack_context.consumer,
+                                      SPV_ERROR_INVALID_BINARY)
+           << "Spec constant indexing requires the module to be in host "
+              "byte order.";
+  }
+
+  SpecConstantIndexBuilder builder;
+  if (auto error = spvBinaryParse(context, &builder, words, num_words, nullptr,
+                                  IndexSpecConstantInstruction, diagnostic)) {
+    return error;
+  }
+
+  spv_spec_constant_index index = new spv_spec_constant_index_t();
+  index->num_constants = static_cast<uint32_t>(builder.constants.size());
+  index->constants =
+      index->num_constants
+          ? new spv_indexed_spec_constant_t[index->num_constants]
+          : nullptr;
+  std::copy(builder.constants.begin(), builder.constants.end(),
+            index->constants);
+  *pIndex = index;
+  return SPV_SUCCESS;
+}
+
+void spvSpecConstantIndexDestroy(spv_spec_constant_index index) {
+  if (!index) return;
+  delete[] index->constants;
+  delete index;
+}
+
+spv_result_t spvBinarySpecialize(const spv_spec_constant_index index,
+                                 uint32_t* words, const size_t num_words,
+                                 const spv_spec_constant_value_t* values,
+                                 const size_t num_values) {
+  if (!index || !words || (!values && num_values))
+    return SPV_ERROR_INVALID_POINTER;
+  for (uint32_t i = 0; i < index->num_constants; ++i) {
+    const spv_indexed_spec_constant_t& constant = index->constants[i];
+    const size_t end_offset =
+        constant.num_literal_words
+            ? constant.literal_offset + constant.num_literal_words
+            : constant.opcode_offset + 1;
+    if (end_offset > num_words) return SPV_ERROR_INVALID_BINARY;
+    for (size_t v = 0; v < num_values; ++v) {
+      if (values[v].spec_id != constant.spec_id) continue;
+      if (constant.num_literal_words == 0) {
+        // Boolean constants encode their value in the opcode.  The word
+        // count is unchanged, so only the opcode half is rewritten.
+        const uint32_t opcode = values[v].value ? SpvOpSpecConstantTrue
+                                                : SpvOpSpecConstantFalse;
+        words[constant.opcode_offset] =
+            (words[constant.opcode_offset] & 0xffff0000u) | opcode;
+      } else {
+        words[constant.literal_offset] =
+            static_cast<uint32_t>(values[v].value);
+        if (constant.num_literal_words > 1) {
+          words[constant.literal_offset + 1] =
+              static_cast<uint32_t>(values[v].value >> 32);
+        }
+      }
+    }
+  }
+  return SPV_SUCCESS;
+}
+
+spv_result_t spvBinarySpecializeBatch(
+    const spv_const_context context, const uint32_t* words,
+    const size_t num_words, const spv_spec_constant_value_set_t* value_sets,
+    const size_t num_sets, spv_binary* results, spv_diagnostic* diagnostic) {
+  if (!results || (!value_sets && num_sets)) return SPV_ERROR_INVALID_POINTER;
+  for (size_t i = 0; i < num_sets; ++i) results[i] = nullptr;
+
+  // Index the module once; every permutation shares it read-only.
+  spv_spec_constant_index index = nullptr;
+  if (auto error = spvBinaryBuildSpecConstantIndex(context, words, num_words,
+                                                   &index, diagnostic)) {
+    return error;
+  }
+
+  // Each permutation is a copy of the original buffer with its value set
+  // patched in, so permutations are independent and can be produced on
+  // as many cores as there are sets to fill.
+  const auto specialize_one = [&](size_t i) {
+    spv_binary binary = spvtools::AllocateBinary(context->allocator, num_words);
+    std::memcpy(binary->code, words, num_words * sizeof(uint32_t));
+    spvBinarySpecialize(index, binary->code, num_words, value_sets[i].values,
+                        value_sets[i].num_values);
+    results[i] = binary;
+  };
+
+  const size_t num_workers = std::min<size_t>(
+      std::max(1u, std::thread::hardware_concurrency()), num_sets);
+  if (num_workers < 2) {
+    for (size_t i = 0; i < num_sets; ++i) specialize_one(i);
+  } else {
+    std::atomic<size_t> next_set(0);
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < num_workers; ++w) {
+      workers.emplace_back([&specialize_one, &next_set, num_sets] {
+        for (size_t i = next_set++; i < num_sets; i = next_set++)
+          specialize_one(i);
+      });
+    }
+    for (auto& worker : workers) worker.join();
+  }
+
+  spvSpecConstantIndexDestroy(index);
+  return SPV_SUCCESS;
+}
+
+namespace {
+
+// Accumulates the surviving word ranges during the parse made by
+// spvBinaryFilter.  Runs of consecutively kept instructions coalesce into
+// one range, so the compaction step is a handful of large copies rather
+// than one per instruction.
+struct FilterBuilder {
+  FilterBuilder(spv_instruction_filter_fn_t filter_arg, void* user_data_arg)
+      : word_offset(SPV_INDEX_INSTRUCTION),
+        num_kept_words(0),
+        filter(filter_arg),
+        user_data(user_data_arg) {}
+
+  size_t word_offset;  // Word offset of the next reported instruction.
+  size_t num_kept_words;
+  spv_instruction_filter_fn_t filter;
+  void* user_data;
+  // Coalesced [begin, end) word ranges of kept instructions.
+  std::vector<std::pair<size_t, size_t>> kept_ranges;
+};
+
+spv_result_t FilterParsedInstruction(void* user_data,
+                                     const spv_parsed_instruction_t* inst) {
+  auto* builder = static_cast<FilterBuilder*>(user_data);
+  const size_t offset = builder->word_offset;
+  builder->word_offset += inst->num_words;
+  if (!builder->filter(builder->user_data, inst)) return SPV_SUCCESS;
+  builder->num_kept_words += inst->num_words;
+  if (!builder->kept_ranges.empty() &&
+      builder->kept_ranges.back().second == offset) {
+    builder->kept_ranges.back().second = builder->word_offset;
+  } else {
+    builder->kept_ranges.push_back({offset, builder->word_offset});
+  }
+  return SPV_SUCCESS;
+}
+
+// Returns true if the given opcode only conveys debug information.  This
+// matches the set the optimizer's strip-debug pass removes.
+bool IsDebugOpcode(const uint16_t opcode) {
+  return (opcode >= SpvOpSourceContinued && opcode <= SpvOpLine) ||
+         opcode == SpvOpNoLine || opcode == SpvOpModuleProcessed;
+}
+
+bool KeepNonDebugInstruction(void*, const spv_parsed_instruction_t* inst) {
+  return !IsDebugOpcode(inst->opcode);
+}
+
+}  // anonymous namespace
+
+spv_result_t spvBinaryFilter(const spv_const_context context,
+                             const uint32_t* words, const size_t num_words,
+                             spv_instruction_filter_fn_t filter,
+                             void* user_data, spv_binary* pBinary,
+                             spv_diagnostic* diagnostic) {
+  if (!pBinary || !filter) return SPV_ERROR_INVALID_POINTER;
+
+  FilterBuilder builder(filter, user_data);
+  if (auto error = spvBinaryParse(context, &builder, words, num_words, nullptr,
+                                  FilterParsedInstruction, diagnostic)) {
+    return error;
+  }
+
+  // Stitch the output from the header and the kept ranges.  The ranges are
+  // copied from the original buffer untouched, so a module in foreign byte
+  // order comes out in that same byte order.
+  const size_t total_words = SPV_INDEX_INSTRUCTION + builder.num_kept_words;
+  spv_binary binary = spvtools::AllocateBinary(context->allocator, total_words);
+  uint32_t* code = binary->code;
+  std::memcpy(code, words, SPV_INDEX_INSTRUCTION * sizeof(uint32_t));
+  size_t out_offset = SPV_INDEX_INSTRUCTION;
+  for (const auto& range : builder.kept_ranges) {
+    std::memcpy(code + out_offset, words + range.first,
+                (range.second - range.first) * sizeof(uint32_t));
+    out_offset += range.second - range.first;
+  }
+
+  *pBinary = binary;
+  return SPV_SUCCESS;
+}
+
+spv_result_t spvBinaryStripDebugInfo(const spv_const_context context,
+                                     const uint32_t* words,
+                                     const size_t num_words,
+                                     spv_binary* pBinary,
+                                     spv_diagnostic* diagnostic) {
+  return spvBinaryFilter(context, words, num_words, KeepNonDebugInstruction,
+                         nullptr, pBinary, diagnostic);
+}
+
+spv_result_t spvBinaryGetFingerprint(const uint32_t* words,
+                                     const size_t num_words,
+                                     spv_module_fingerprint_t* pFingerprint) {
+  if (!words || !pFingerprint) return SPV_ERROR_INVALID_POINTER;
+  if (num_words < SPV_INDEX_INSTRUCTION) return SPV_ERROR_INVALID_BINARY;
+
+  spv_const_binary_t binary = {words, num_words};
+  spv_endianness_t endian;
+  if (spvBinaryEndianness(&binary, &endian)) return SPV_ERROR_INVALID_BINARY;
+
+  spv_module_fingerprint_t fingerprint = {};
+  fingerprint.version = spvFixWord(words[SPV_INDEX_VERSION_NUMBER], endian);
+  fingerprint.generator = spvFixWord(words[SPV_INDEX_GENERATOR_NUMBER], endian);
+  fingerprint.id_bound = spvFixWord(words[SPV_INDEX_BOUND], endian);
+
+  // FNV-1a, as elsewhere in this file; the hash covers every word of the
+  // module, only the operand decode is skipped.
+  const uint64_t kPrime = 0x100000001b3ull;
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < SPV_INDEX_INSTRUCTION; ++i) {
+    hash = (hash ^ spvFixWord(words[i], endian)) * kPrime;
+  }
+
+  size_t index = SPV_INDEX_INSTRUCTION;
+  while (index < num_words) {
+    const uint32_t first_word = spvFixWord(words[index], endian);
+    uint16_t inst_word_count = 0;
+    uint16_t opcode = 0;
+    spvOpcodeSplit(first_word, &inst_word_count, &opcode);
+    if (inst_word_count == 0 || inst_word_count > num_words - index) {
+      return SPV_ERROR_INVALID_BINARY;
+    }
+    ++fingerprint.num_instructions;
+    if (opcode == SpvOpFunction) ++fingerprint.num_functions;
+    if (opcode == SpvOpEntryPoint) ++fingerprint.num_entry_points;
+    if (IsDebugOpcode(opcode)) ++fingerprint.num_debug_instructions;
+    for (size_t i = index; i < index + inst_word_count; ++i) {
+      hash = (hash ^ spvFixWord(words[i], endian)) * kPrime;
+    }
+    index += inst_word_count;
+  }
+  fingerprint.hash = hash;
+  *pFingerprint = fingerprint;
+  return SPV_SUCCESS;
+}
+
+namespace {
+
+// The delta produced by spvBinaryDiff is a word stream:
+//
+//   word 0:  kDeltaMagic
+//   word 1:  kDeltaVersion
+//   word 2:  word count of the reconstructed target
+//   then directives until the stream ends.  Each directive is a word
+//   holding (num_words << 1) | kind.  Kind 0 copies num_words words from
+//   the base, starting at the offset held in the following word.  Kind 1
+//   inserts the num_words words that follow literally.
+//
+// The magic deliberately differs from the SPIR-V magic in both byte
+// orders, so a delta handed to a module consumer (or vice versa) is
+// rejected immediately.
+const uint32_t kDeltaMagic = 0x44565053;  // "SPVD" when stored little-endian.
+const uint32_t kDeltaVersion = 1;
+
+// Collects the word offset and size of every instruction during a
+// sequential parse.
+struct BoundaryCollector {
+  BoundaryCollector() : word_offset(SPV_INDEX_INSTRUCTION) {}
+
+  size_t word_offset;  // Word offset of the next reported instruction.
+  std::vector<std::pair<size_t, size_t>> ranges;  // {offset, num_words}
+};
+
+spv_result_t CollectInstructionBoundary(void* user_data,
+                                        const spv_parsed_instruction_t* inst) {
+  auto* collector = static_cast<BoundaryCollector*>(user_data);
+  collector->ranges.push_back({collector->word_offset, inst->num_words});
+  collector->word_offset += inst->num_words;
+  return SPV_SUCCESS;
+}
+
+// Hashes the given words (FNV-1a), for bucketing identical instructions.
+uint64_t HashWords(const uint32_t* words, size_t num_words) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < num_words; ++i) {
+    hash = (hash ^ words[i]) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+}  // anonymous namespace
+
+spv_result_t spvBinaryDiff(const spv_const_context context,
+                           const uint32_t* base_words,
+                           const size_t base_num_words,
+                           const uint32_t* target_words,
+                           const size_t target_num_words, spv_binary* pDelta,
+                           spv_diagnostic* diagnostic) {
+  if (!pDelta) return SPV_ERROR_INVALID_POINTER;
+
+  BoundaryCollector base_insts;
+  if (auto error = spvBinaryParse(context, &base_insts, base_words,
+                                  base_num_words, nullptr,
+                                  CollectInstructionBoundary, diagnostic)) {
+    return error;
+  }
+  BoundaryCollector target_insts;
+  if (auto error = spvBinaryParse(context, &target_insts, target_words,
+                                  target_num_words, nullptr,
+                                  CollectInstructionBoundary, diagnostic)) {
+    return error;
+  }
+
+  // Bucket the base instructions by a hash of their words, so each target
+  // instruction finds its candidates in one lookup.
+  std::unordered_map<uint64_t, std::vector<size_t>> base_by_hash;
+  for (size_t i = 0; i < base_insts.ranges.size(); ++i) {
+    const auto& range = base_insts.ranges[i];
+    base_by_hash[HashWords(base_words + range.first, range.second)]
+        .push_back(i);
+  }
+
+  std::vector<uint32_t> delta;
+  delta.push_back(kDeltaMagic);
+  delta.push_back(kDeltaVersion);
+  delta.push_back(static_cast<uint32_t>(target_num_words));
+
+  // Literal target words not yet flushed into an insert directive.
+  size_t pending_begin = 0, pending_end = 0;
+  // Index of the directive word of the latest copy, when it is still the
+  // last directive in the delta; 0 otherwise.
+  size_t last_copy = 0;
+  const auto flush_pending = [&] {
+    if (pending_end == pending_begin) return;
+    delta.push_back(
+        static_cast<uint32_t>((pending_end - pending_begin) << 1) | 1u);
+    delta.insert(delta.end(), target_words + pending_begin,
+                 target_words + pending_end);
+    pending_begin = pending_end;
+    last_copy = 0;
+  };
+  const auto emit_copy = [&](size_t base_offset, size_t num_words) {
+    flush_pending();
+    // Merge with an immediately preceding copy of the adjacent base range.
+    if (last_copy) {
+      const uint32_t prev_op = delta[last_copy];
+      if (delta[last_copy + 1] + (prev_op >> 1) == base_offset) {
+        delta[last_copy] =
+            static_cast<uint32_t>(((prev_op >> 1) + num_words) << 1);
+        return;
+      }
+    }
+    last_copy = delta.size();
+    delta.push_back(static_cast<uint32_t>(num_words << 1));
+    delta.push_back(static_cast<uint32_t>(base_offset));
+  };
+
+  // The header: copied when unchanged, carried literally otherwise.
+  if (std::equal(target_words, target_words + SPV_INDEX_INSTRUCTION,
+                 base_words)) {
+    emit_copy(0, SPV_INDEX_INSTRUCTION);
+    pending_begin = pending_end = SPV_INDEX_INSTRUCTION;
+  } else {
+    pending_end = SPV_INDEX_INSTRUCTION;
+  }
+
+  for (size_t ti = 0; ti < target_insts.ranges.size();) {
+    const auto& range = target_insts.ranges[ti];
+    const uint32_t* inst_words = target_words + range.first;
+    size_t match_offset = 0;
+    bool matched = false;
+    const auto bucket =
+        base_by_hash.find(HashWords(inst_words, range.second));
+    if (bucket != base_by_hash.end()) {
+      for (const size_t candidate : bucket->second) {
+        const auto& base_range = base_insts.ranges[candidate];
+        if (base_range.second == range.second &&
+            std::equal(inst_words, inst_words + range.second,
+                       base_words + base_range.first)) {
+          match_offset = base_range.first;
+          matched = true;
+          break;
+        }
+      }
+    }
+    if (!matched) {
+      pending_end = range.first + range.second;
+      ++ti;
+      continue;
+    }
+    // Extend the match over following instructions that continue the same
+    // run of base words, so long unchanged stretches become one copy.
+    size_t copy_words = range.second;
+    ++ti;
+    while (ti < target_insts.ranges.size()) {
+      const auto& next = target_insts.ranges[ti];
+      const size_t base_next = match_offset + copy_words;
+      if (base_next + next.second > base_num_words) break;
+      if (!std::equal(target_words + next.first,
+                      target_words + next.first + next.second,
+                      base_words + base_next))
+        break;
+      copy_words += next.second;
+      ++ti;
+    }
+    emit_copy(match_offset, copy_words);
+    pending_begin = pending_end = target_insts.ranges[ti - 1].first +
+                                  target_insts.ranges[ti - 1].second;
+  }
+  flush_pending();
+
+  spv_binary binary = spvtools::AllocateBinary(context->allocator, delta.size());
+  std::memcpy(binary->code, delta.data(), delta.size() * sizeof(uint32_t));
+  *pDelta = binary;
+  return SPV_SUCCESS;
+}
+
+spv_result_t spvBinaryApplyDelta(const uint32_t* base_words,
+                                 const size_t base_num_words,
+                                 const uint32_t* delta_words,
+                                 const size_t delta_num_words,
+                                 spv_binary* pTarget) {
+  if (!pTarget || !delta_words || (!base_words && base_num_words))
+    return SPV_ERROR_INVALID_POINTER;
+  if (delta_num_words < 3 || delta_words[0] != kDeltaMagic ||
+      delta_words[1] != kDeltaVersion) {
+    return SPV_ERROR_INVALID_BINARY;
+  }
+
+  const size_t target_num_words = delta_words[2];
+  uint32_t* code = new uint32_t[target_num_words];
+  size_t out = 0;
+  size_t in = 3;
+  while (in < delta_num_words) {
+    const uint32_t directive = delta_words[in++];
+    const size_t num_words = directive >> 1;
+    if (directive & 1u) {
+      // Literal insert: the words follow in the delta itself.
+      if (in + num_words > delta_num_words ||
+          out + num_words > target_num_words) {
+        delete[] code;
+        return SPV_ERROR_INVALID_BINARY;
+      }
+      std::memcpy(code + out, delta_words + in, num_words * sizeof(uint32_t));
+      in += num_words;
+    } else {
+      // Copy from the base at the offset held in the next word.
+      if (in >= delta_num_words) {
+        delete[] code;
+        return SPV_ERROR_INVALID_BINARY;
+      }
+      const size_t base_offset = delta_words[in++];
+      if (base_offset + num_words > base_num_words ||
+          out + num_words > target_num_words) {
+        delete[] code;
+        return SPV_ERROR_INVALID_BINARY;
+      }
+      std::memcpy(code + out, base_words + base_offset,
+                  num_words * sizeof(uint32_t));
+    }
+    out += num_words;
+  }
+  if (out != target_num_words) {
+    delete[] code;
+    return SPV_ERROR_INVALID_BINARY;
+  }
+
+  spv_binary binary = new spv_binary_t();
+  binary->code = code;
+  binary->wordCount = target_num_words;
+  *pTarget = binary;
+  return SPV_SUCCESS;
+}
+
 // TODO(dneto): This probably belongs in text.cpp since that's the only place
 // that a spv_binary_t value is created.
 void spvBinaryDestroy(spv_binary binary) {
   if (!binary) return;
+  if (spvtools::AllocatorIsSet(binary->allocator)) {
+    // Copy the allocator out before releasing the object that holds it.
+    const spv_allocator_t allocator = binary->allocator;
+    spvtools::AllocatorFree(allocator, binary->code,
+                            binary->wordCount * sizeof(uint32_t));
+    spvtools::AllocatorFree(allocator, binary, sizeof(spv_binary_t));
+    return;
+  }
   delete[] binary->code;
   delete binary;
 }
 
 size_t spv_strnlen_s(const char* str, size_t strsz) {
   if (!str) return 0;
-  for (size_t i = 0; i < strsz; i++) {
-    if (!str[i]) return i;
-  }
-  return strsz;
+  const void* terminator = memchr(str, '\0', strsz);
+  return terminator ? static_cast<const char*>(terminator) - str : strsz;
 }
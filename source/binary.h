@@ -15,9 +15,47 @@
 #ifndef LIBSPIRV_BINARY_H_
 #define LIBSPIRV_BINARY_H_
 
+#include <memory>
+
 #include "spirv-tools/libspirv.h"
 #include "spirv_definition.h"
 
+namespace libspirv {
+
+// Parses a SPIR-V module that arrives incrementally, issuing the same
+// callbacks as spvBinaryParse as soon as the corresponding words are
+// available.  The caller accumulates the words received so far in a single
+// buffer and passes the whole buffer to Parse after each chunk arrives; the
+// parser remembers how far it has parsed, so each instruction is reported
+// exactly once.  The given context, including its message consumer, must
+// outlive this object.
+class StreamingBinaryParser {
+ public:
+  // The user_data value is provided to the callbacks as context.
+  StreamingBinaryParser(const spv_const_context context, void* user_data,
+                        spv_parsed_header_fn_t parsed_header,
+                        spv_parsed_instruction_fn_t parsed_instruction);
+  ~StreamingBinaryParser();
+
+  StreamingBinaryParser(const StreamingBinaryParser&) = delete;
+  StreamingBinaryParser& operator=(const StreamingBinaryParser&) = delete;
+
+  // Parses those complete instructions in the first |num_words| words of
+  // |words| that earlier calls have not parsed yet.  Pass |input_complete|
+  // as true once no more words will arrive, so that a truncated trailing
+  // instruction is diagnosed rather than awaited.  Returns SPV_SUCCESS or
+  // the first error encountered; errors are reported through the context's
+  // message consumer.
+  spv_result_t Parse(const uint32_t* words, size_t num_words,
+                     bool input_complete);
+
+ private:
+  struct Impl;  // Defined in binary.cpp, next to the parser it wraps.
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace libspirv
+
 // Functions
 
 // Grabs the header from the SPIR-V module given in the binary parameter. The
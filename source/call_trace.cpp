@@ -0,0 +1,124 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "call_trace.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "spirv_validator_options.h"
+
+namespace libspirv {
+
+namespace {
+
+// Depth of CallTraceSuppressor scopes on this thread; non-zero suppresses
+// recording.
+thread_local int suppress_depth = 0;
+
+// Serializes calls from all threads of the process into one file.
+std::mutex& TraceMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+// The trace file, opened on first use from SPIRV_TOOLS_CALL_TRACE, or null
+// when recording is off.  Left open for the life of the process; each
+// record is flushed, so a crash loses at most the record being written.
+FILE* TraceFile() {
+  static FILE* file = [] {
+    const char* path = std::getenv("SPIRV_TOOLS_CALL_TRACE");
+    if (path == nullptr || path[0] == '\0') return static_cast<FILE*>(nullptr);
+    FILE* f = std::fopen(path, "wb");
+    if (f != nullptr) {
+      const uint32_t header[2] = {kCallTraceMagic, kCallTraceVersion};
+      std::fwrite(header, sizeof(uint32_t), 2, f);
+    }
+    return f;
+  }();
+  return file;
+}
+
+void WriteRecord(CallTraceKind kind, spv_target_env env,
+                 const std::vector<uint32_t>& option_words,
+                 const uint32_t* payload, size_t num_payload_words) {
+  FILE* file = TraceFile();
+  if (file == nullptr) return;
+  const uint32_t head[4] = {uint32_t(kind), uint32_t(env),
+                            uint32_t(option_words.size()),
+                            uint32_t(num_payload_words)};
+  std::lock_guard<std::mutex> lock(TraceMutex());
+  std::fwrite(head, sizeof(uint32_t), 4, file);
+  std::fwrite(option_words.data(), sizeof(uint32_t), option_words.size(),
+              file);
+  std::fwrite(payload, sizeof(uint32_t), num_payload_words, file);
+  std::fflush(file);
+}
+
+}  // anonymous namespace
+
+bool CallTraceEnabled() {
+  return suppress_depth == 0 && TraceFile() != nullptr;
+}
+
+CallTraceSuppressor::CallTraceSuppressor() { ++suppress_depth; }
+CallTraceSuppressor::~CallTraceSuppressor() { --suppress_depth; }
+
+void CallTraceTextToBinary(spv_target_env env, const char* text,
+                           size_t num_bytes, uint32_t assemble_options) {
+  if (!CallTraceEnabled()) return;
+  const std::vector<uint32_t> option_words = {assemble_options,
+                                              uint32_t(num_bytes)};
+  // Pad the text to a whole number of words; the recorded byte count
+  // recovers the exact length on replay.
+  std::vector<uint32_t> payload((num_bytes + 3) / 4, 0);
+  std::memcpy(payload.data(), text, num_bytes);
+  WriteRecord(kCallTextToBinary, env, option_words, payload.data(),
+              payload.size());
+}
+
+void CallTraceValidate(spv_target_env env, spv_const_validator_options options,
+                       const uint32_t* words, size_t num_words) {
+  if (!CallTraceEnabled()) return;
+  const spv_validator_options_t defaults;
+  const spv_validator_options_t& o = options ? *options : defaults;
+  const validator_universal_limits_t& limits = o.universal_limits_;
+  const std::vector<uint32_t> option_words = {
+      limits.max_struct_members,
+      limits.max_struct_depth,
+      limits.max_local_variables,
+      limits.max_global_variables,
+      limits.max_switch_branches,
+      limits.max_function_args,
+      limits.max_control_flow_nesting_depth,
+      limits.max_access_chain_indexes,
+      o.checks_,
+      uint32_t(o.budget_.max_instructions),
+      uint32_t(o.budget_.max_instructions >> 32),
+      o.budget_.max_blocks_per_function,
+      uint32_t(o.budget_.max_validation_steps),
+      uint32_t(o.budget_.max_validation_steps >> 32)};
+  WriteRecord(kCallValidate, env, option_words, words, num_words);
+}
+
+void CallTraceBinaryParse(spv_target_env env, const uint32_t* words,
+                          size_t num_words) {
+  if (!CallTraceEnabled()) return;
+  WriteRecord(kCallBinaryParse, env, {}, words, num_words);
+}
+
+}  // namespace libspirv
@@ -0,0 +1,85 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_CALL_TRACE_H_
+#define LIBSPIRV_CALL_TRACE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "spirv-tools/libspirv.h"
+
+// Records the C API calls of a process into a compact trace file, so a
+// production workload's call pattern -- context environments, module mix and
+// option combinations -- can be replayed against other library builds by the
+// spirv-replay tool.  Recording is off unless the SPIRV_TOOLS_CALL_TRACE
+// environment variable names the output file; it then captures every
+// spvTextToBinary, spvValidate/spvValidateWithOptions and spvBinaryParse
+// call with its full input.
+//
+// Trace file layout, in host-endian 32-bit words: a two-word header (magic,
+// version), then one record per call.  Each record is four words -- kind,
+// target environment, option word count, payload word count -- followed by
+// the option words and the payload words.  The payload is the module binary,
+// or the assembly text padded to a word boundary.
+
+namespace libspirv {
+
+const uint32_t kCallTraceMagic = 0x52545653;  // "SVTR" in little endian.
+const uint32_t kCallTraceVersion = 1;
+
+// The call a trace record captures.
+enum CallTraceKind : uint32_t {
+  kCallTextToBinary = 1,
+  kCallValidate = 2,
+  kCallBinaryParse = 3,
+};
+
+// Returns true if call recording is active for this process.  The recording
+// hooks below check this themselves; use it only to skip argument setup.
+bool CallTraceEnabled();
+
+// Records an assembly call.  Option words: the assemble options word and the
+// exact text length in bytes (the payload is padded to whole words).
+void CallTraceTextToBinary(spv_target_env env, const char* text,
+                           size_t num_bytes, uint32_t assemble_options);
+
+// Records a validation call.  Option words: the eight universal limits, the
+// check mask, and the budget.  A plugged-in validation cache is not
+// recorded; replay re-executes the full validation.
+void CallTraceValidate(spv_target_env env, spv_const_validator_options options,
+                       const uint32_t* words, size_t num_words);
+
+// Records a binary parse call.  The caller's parse callbacks are not
+// recorded; replay parses with null callbacks, which exercises the same
+// decoding work.
+void CallTraceBinaryParse(spv_target_env env, const uint32_t* words,
+                          size_t num_words);
+
+// Suppresses recording on the current thread while in scope.  Placed around
+// the library's internal reuse of recorded entry points -- e.g. the
+// validator decoding via spvBinaryParse -- so a trace holds exactly one
+// record per external API call.
+class CallTraceSuppressor {
+ public:
+  CallTraceSuppressor();
+  ~CallTraceSuppressor();
+
+  CallTraceSuppressor(const CallTraceSuppressor&) = delete;
+  CallTraceSuppressor& operator=(const CallTraceSuppressor&) = delete;
+};
+
+}  // namespace libspirv
+
+#endif  // LIBSPIRV_CALL_TRACE_H_
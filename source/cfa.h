@@ -24,6 +24,8 @@
 #include <utility>
 #include <vector>
 
+#include "val/profiling.h"
+
 using std::find;
 using std::function;
 using std::get;
@@ -47,15 +49,18 @@ template<class BB> class CFA {
     bb_iter iter;   ///< Iterator to the current child node being processed
   };
 
-  /// Returns true if a block with @p id is found in the @p work_list vector
-  ///
-  /// @param[in] work_list  Set of blocks visited in the the depth first traversal
-  ///                       of the CFG
-  /// @param[in] id         The ID of the block being checked
-  ///
-  /// @return true if the edge work_list.back().block->id() => id is a back-edge
-  static bool FindInWorkList(
-      const std::vector<block_info>& work_list, uint32_t id);
+  /// Computes dominators with the semi-NCA algorithm of Georgiadis et al.
+  /// Near-linear in the size of the graph, so it is preferred over the
+  /// iterative algorithm for large CFGs; see CalculateDominators for the
+  /// interface contract.
+  static vector<pair<BB*, BB*>> CalculateDominatorsSemiNca(
+      const vector<cbb_ptr>& postorder, get_blocks_func predecessor_func);
+
+  /// Block count at and above which CalculateDominators switches from the
+  /// iterative algorithm to semi-NCA.  The iterative fixpoint is simple and
+  /// has a small constant factor, but its convergence degrades on deep loop
+  /// nests, which large auto-generated kernels have in abundance.
+  static const size_t kSemiNcaBlockThreshold = 512;
 
 public:
   /// @brief Depth first traversal starting from the \p entry BasicBlock
@@ -126,20 +131,36 @@ public:
     get_blocks_func pred_func);
 };
 
-template<class BB> bool CFA<BB>::FindInWorkList(const vector<block_info>& work_list,
-                                                uint32_t id) {
-  for (const auto b : work_list) {
-    if (b.block->id() == id) return true;
-  }
-  return false;
-}
-
 template<class BB> void CFA<BB>::DepthFirstTraversal(const BB* entry,
   get_blocks_func successor_func,
   function<void(cbb_ptr)> preorder,
   function<void(cbb_ptr)> postorder,
   function<void(cbb_ptr, cbb_ptr)> backedge) {
-  unordered_set<uint32_t> processed;
+  const uint8_t kVisited = 1;
+  const uint8_t kOnStack = 2;
+
+  /// Per-block traversal flags, indexed by block id and grown on demand so
+  /// callers need not supply an id bound.  kOnStack marks blocks currently
+  /// on the work list, making back-edge detection O(1) instead of a linear
+  /// walk of the DFS stack.  An id far beyond the ids seen so far — such as
+  /// the validator's pseudo-exit block, which sits at the universal id
+  /// bound — goes to a small overflow map instead of forcing the dense
+  /// array to be zeroed out to that id.  The overflow map is consulted
+  /// first, so an id stays in whichever store it first landed in even if
+  /// the dense array later grows past it.
+  vector<uint8_t> block_flags;
+  unordered_map<uint32_t, uint8_t> overflow_flags;
+  auto flags_of = [&block_flags, &overflow_flags](uint32_t id) -> uint8_t& {
+    if (!overflow_flags.empty()) {
+      auto it = overflow_flags.find(id);
+      if (it != overflow_flags.end()) return it->second;
+    }
+    if (id >= block_flags.size()) {
+      if (id > 2 * block_flags.size() + 64) return overflow_flags[id];
+      block_flags.resize(id + 1, 0);
+    }
+    return block_flags[id];
+  };
 
   /// NOTE: work_list is the sequence of nodes from the root node to the node
   /// being processed in the traversal
@@ -147,26 +168,30 @@ template<class BB> void CFA<BB>::DepthFirstTraversal(const BB* entry,
   work_list.reserve(10);
 
   work_list.push_back({ entry, begin(*successor_func(entry)) });
+  SPIRV_VALIDATOR_PROFILE_CFG_NODE_VISIT();
   preorder(entry);
-  processed.insert(entry->id());
+  flags_of(entry->id()) = kVisited | kOnStack;
 
   while (!work_list.empty()) {
     block_info& top = work_list.back();
     if (top.iter == end(*successor_func(top.block))) {
       postorder(top.block);
+      flags_of(top.block->id()) &= static_cast<uint8_t>(~kOnStack);
       work_list.pop_back();
     }
     else {
       BB* child = *top.iter;
       top.iter++;
-      if (FindInWorkList(work_list, child->id())) {
+      uint8_t& child_flags = flags_of(child->id());
+      if (child_flags & kOnStack) {
         backedge(top.block, child);
       }
-      if (processed.count(child->id()) == 0) {
+      if (!(child_flags & kVisited)) {
+        child_flags |= kVisited | kOnStack;
+        SPIRV_VALIDATOR_PROFILE_CFG_NODE_VISIT();
         preorder(child);
         work_list.emplace_back(
           block_info{ child, begin(*successor_func(child)) });
-        processed.insert(child->id());
       }
     }
   }
@@ -175,68 +200,200 @@ template<class BB> void CFA<BB>::DepthFirstTraversal(const BB* entry,
 template<class BB>
 vector<pair<BB*, BB*>> CFA<BB>::CalculateDominators(
   const vector<cbb_ptr>& postorder, get_blocks_func predecessor_func) {
-  struct block_detail {
-    size_t dominator;  ///< The index of blocks's dominator in post order array
-    size_t postorder_index;  ///< The index of the block in the post order array
-  };
+  // The iterative fixpoint can take many rounds to converge on deep loop
+  // nests.  Large graphs take the near-linear semi-NCA path instead.
+  if (postorder.size() >= kSemiNcaBlockThreshold) {
+    return CalculateDominatorsSemiNca(postorder, predecessor_func);
+  }
+
   const size_t undefined_dom = postorder.size();
 
-  unordered_map<cbb_ptr, block_detail> idoms;
+  // Map a block to its position in the postorder array.  This is the only
+  // hash table in the algorithm: the iterative fixpoint below works on flat
+  // arrays indexed by postorder position.
+  unordered_map<cbb_ptr, size_t> postorder_index;
+  postorder_index.reserve(postorder.size());
   for (size_t i = 0; i < postorder.size(); i++) {
-    idoms[postorder[i]] = { undefined_dom, i };
+    postorder_index[postorder[i]] = i;
   }
-  idoms[postorder.back()].dominator = idoms[postorder.back()].postorder_index;
+
+  // The postorder index of each block's dominator, indexed by the block's
+  // own postorder index.  The root dominates itself.
+  vector<size_t> idoms(postorder.size(), undefined_dom);
+  idoms.back() = postorder.size() - 1;
 
   bool changed = true;
   while (changed) {
     changed = false;
-    for (auto b = postorder.rbegin() + 1; b != postorder.rend(); ++b) {
-      const vector<BB*>& predecessors = *predecessor_func(*b);
+    for (size_t b = postorder.size() - 1; b-- > 0;) {
+      const vector<BB*>& predecessors = *predecessor_func(postorder[b]);
       // Find the first processed/reachable predecessor that is reachable
       // in the forward traversal.
-      auto res = find_if(begin(predecessors), end(predecessors),
-        [&idoms, undefined_dom](BB* pred) {
-        return idoms.count(pred) &&
-          idoms[pred].dominator != undefined_dom;
-      });
-      if (res == end(predecessors)) continue;
-      const BB* idom = *res;
-      size_t idom_idx = idoms[idom].postorder_index;
+      size_t idom_idx = undefined_dom;
+      for (const auto* pred : predecessors) {
+        const auto found = postorder_index.find(pred);
+        if (found != postorder_index.end() &&
+            idoms[found->second] != undefined_dom) {
+          idom_idx = found->second;
+          break;
+        }
+      }
+      if (idom_idx == undefined_dom) continue;
+      const size_t first_pred_idx = idom_idx;
 
       // all other predecessors
       for (const auto* p : predecessors) {
-        if (idom == p) continue;
         // Only consider nodes reachable in the forward traversal.
         // Otherwise the intersection doesn't make sense and will never
         // terminate.
-        if (!idoms.count(p)) continue;
-        if (idoms[p].dominator != undefined_dom) {
-          size_t finger1 = idoms[p].postorder_index;
+        const auto found = postorder_index.find(p);
+        if (found == postorder_index.end()) continue;
+        const size_t p_idx = found->second;
+        if (p_idx == first_pred_idx) continue;
+        if (idoms[p_idx] != undefined_dom) {
+          size_t finger1 = p_idx;
           size_t finger2 = idom_idx;
           while (finger1 != finger2) {
             while (finger1 < finger2) {
-              finger1 = idoms[postorder[finger1]].dominator;
+              finger1 = idoms[finger1];
             }
             while (finger2 < finger1) {
-              finger2 = idoms[postorder[finger2]].dominator;
+              finger2 = idoms[finger2];
             }
           }
           idom_idx = finger1;
         }
       }
-      if (idoms[*b].dominator != idom_idx) {
-        idoms[*b].dominator = idom_idx;
+      if (idoms[b] != idom_idx) {
+        idoms[b] = idom_idx;
         changed = true;
       }
     }
   }
 
   vector<pair<bb_ptr, bb_ptr>> out;
-  for (auto idom : idoms) {
+  out.reserve(postorder.size());
+  for (size_t i = 0; i < postorder.size(); i++) {
+    // NOTE: performing a const cast for convenient usage with
+    // UpdateImmediateDominators
+    out.push_back({ const_cast<BB*>(postorder[i]),
+      const_cast<BB*>(postorder[idoms[i]]) });
+  }
+  return out;
+}
+
+template<class BB>
+vector<pair<BB*, BB*>> CFA<BB>::CalculateDominatorsSemiNca(
+  const vector<cbb_ptr>& postorder, get_blocks_func predecessor_func) {
+  const size_t n = postorder.size();
+  const size_t none = n;
+
+  // Map a block to its position in the postorder array, and recover the
+  // forward edges of the graph by inverting the predecessor lists.  All
+  // remaining bookkeeping uses flat arrays.
+  unordered_map<cbb_ptr, size_t> postorder_index;
+  postorder_index.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    postorder_index[postorder[i]] = i;
+  }
+  vector<vector<size_t>> successors(n);
+  vector<vector<size_t>> predecessors(n);
+  for (size_t i = 0; i < n; i++) {
+    for (const auto* pred : *predecessor_func(postorder[i])) {
+      const auto found = postorder_index.find(pred);
+      if (found == postorder_index.end()) continue;
+      successors[found->second].push_back(i);
+      predecessors[i].push_back(found->second);
+    }
+  }
+
+  // Number the blocks in preorder of a depth-first traversal from the root,
+  // which the caller guarantees is the last postorder entry.  Everything
+  // below is indexed by preorder number.
+  vector<size_t> preorder_of(n, none);   // postorder index -> preorder number
+  vector<size_t> block_of;               // preorder number -> postorder index
+  vector<size_t> parent(n, 0);           // preorder number of the DFS parent
+  block_of.reserve(n);
+  {
+    vector<pair<size_t, size_t>> work_list;  // (postorder index, child cursor)
+    work_list.reserve(n);
+    const size_t root = n - 1;
+    preorder_of[root] = 0;
+    block_of.push_back(root);
+    work_list.push_back({ root, 0 });
+    while (!work_list.empty()) {
+      auto& top = work_list.back();
+      if (top.second == successors[top.first].size()) {
+        work_list.pop_back();
+        continue;
+      }
+      const size_t child = successors[top.first][top.second++];
+      if (preorder_of[child] == none) {
+        preorder_of[child] = block_of.size();
+        parent[block_of.size()] = preorder_of[top.first];
+        block_of.push_back(child);
+        work_list.push_back({ child, 0 });
+      }
+    }
+  }
+  assert(block_of.size() == n && "Predecessor lists disagree with postorder");
+
+  // Phase 1 of Lengauer-Tarjan: compute each block's semidominator, walking
+  // blocks in reverse preorder.  The ancestor/label forest implements eval
+  // with path compression.
+  vector<size_t> semi(n);
+  vector<size_t> label(n);
+  vector<size_t> ancestor(n, none);
+  for (size_t v = 0; v < n; v++) {
+    semi[v] = v;
+    label[v] = v;
+  }
+  vector<size_t> compress_path;
+  auto eval = [&](size_t v) -> size_t {
+    if (ancestor[v] == none) return label[v];
+    // Compress the path from v to its forest root, propagating the minimal
+    // semidominator label downwards.
+    compress_path.clear();
+    size_t u = v;
+    while (ancestor[ancestor[u]] != none) {
+      compress_path.push_back(u);
+      u = ancestor[u];
+    }
+    for (auto it = compress_path.rbegin(); it != compress_path.rend(); ++it) {
+      const size_t w = *it;
+      if (semi[label[ancestor[w]]] < semi[label[w]]) {
+        label[w] = label[ancestor[w]];
+      }
+      ancestor[w] = ancestor[ancestor[w]];
+    }
+    return label[v];
+  };
+  for (size_t v = n - 1; v > 0; v--) {
+    for (const size_t pred : predecessors[block_of[v]]) {
+      const size_t u = preorder_of[pred];
+      const size_t candidate = semi[eval(u)];
+      if (candidate < semi[v]) semi[v] = candidate;
+    }
+    ancestor[v] = parent[v];
+  }
+
+  // Semi-NCA idom phase: in preorder, intersect the DFS-tree parent chain
+  // with the semidominator.  Ancestors have final idoms by the time they
+  // are consulted.
+  vector<size_t> idom(n, 0);
+  for (size_t v = 1; v < n; v++) {
+    size_t d = parent[v];
+    while (d > semi[v]) d = idom[d];
+    idom[v] = d;
+  }
+
+  vector<pair<bb_ptr, bb_ptr>> out;
+  out.reserve(n);
+  for (size_t v = 0; v < n; v++) {
     // NOTE: performing a const cast for convenient usage with
     // UpdateImmediateDominators
-    out.push_back({ const_cast<BB*>(get<0>(idom)),
-      const_cast<BB*>(postorder[get<1>(idom).dominator]) });
+    out.push_back({ const_cast<BB*>(postorder[block_of[v]]),
+      const_cast<BB*>(postorder[block_of[idom[v]]]) });
   }
   return out;
 }
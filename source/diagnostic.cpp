@@ -67,7 +67,7 @@ spv_result_t spvDiagnosticPrint(const spv_diagnostic diagnostic) {
 namespace libspirv {
 
 DiagnosticStream::~DiagnosticStream() {
-  if (error_ != SPV_FAILED_MATCH && consumer_ != nullptr) {
+  if (emittable()) {
     auto level = SPV_MSG_ERROR;
     switch (error_) {
       case SPV_SUCCESS:
@@ -88,7 +88,8 @@ DiagnosticStream::~DiagnosticStream() {
       default:
         break;
     }
-    consumer_(level, "input", position_, stream_.str().c_str());
+    consumer_(level, "input", position_,
+              stream_ ? stream_->str().c_str() : "");
   }
 }
 
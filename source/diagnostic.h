@@ -15,6 +15,7 @@
 #ifndef LIBSPIRV_DIAGNOSTIC_H_
 #define LIBSPIRV_DIAGNOSTIC_H_
 
+#include <memory>
 #include <sstream>
 #include <string>
 
@@ -34,17 +35,26 @@ class DiagnosticStream {
       : position_(position), consumer_(consumer), error_(error) {}
 
   DiagnosticStream(DiagnosticStream&& other)
-      : stream_(other.stream_.str()),
+      : stream_(std::move(other.stream_)),
         position_(other.position_),
         consumer_(other.consumer_),
-        error_(other.error_) {}
+        error_(other.error_) {
+    // The moved-from stream must not emit the message a second time.
+    other.error_ = SPV_FAILED_MATCH;
+  }
 
   ~DiagnosticStream();
 
-  // Adds the given value to the diagnostic message to be written.
+  // Adds the given value to the diagnostic message to be written.  The value
+  // is formatted only when the message will actually be emitted; a stream
+  // that failed to match or has no consumer costs a branch per operand, not
+  // an ostringstream.
   template <typename T>
   DiagnosticStream& operator<<(const T& val) {
-    stream_ << val;
+    if (emittable()) {
+      if (!stream_) stream_.reset(new std::ostringstream());
+      *stream_ << val;
+    }
     return *this;
   }
 
@@ -52,7 +62,13 @@ class DiagnosticStream {
   operator spv_result_t() { return error_; }
 
  private:
-  std::stringstream stream_;
+  // Returns true if the destructor will hand the message to the consumer.
+  bool emittable() const {
+    return error_ != SPV_FAILED_MATCH && consumer_ != nullptr;
+  }
+
+  // Built on first use; never constructed when the message is dropped.
+  std::unique_ptr<std::ostringstream> stream_;
   spv_position_t position_;
   const spvtools::MessageConsumer& consumer_;  // Message consumer callback.
   spv_result_t error_;
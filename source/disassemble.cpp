@@ -17,11 +17,18 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdio>
 #include <cstring>
-#include <iomanip>
+#include <iostream>
+#include <limits>
 #include <memory>
+#include <sstream>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
+#include "allocator.h"
 #include "assembly_grammar.h"
 #include "binary.h"
 #include "diagnostic.h"
@@ -37,12 +44,25 @@
 
 namespace {
 
+// Copies the given text into a new spv_text object, drawn from |allocator|,
+// saved into |text_result|.
+spv_result_t SaveText(const std::string& text, const spv_allocator_t& allocator,
+                      spv_text* text_result) {
+  spv_text result = spvtools::AllocateText(allocator, text.size());
+  if (!result) return SPV_ERROR_OUT_OF_MEMORY;
+  strncpy(const_cast<char*>(result->str), text.c_str(), text.size() + 1);
+  *text_result = result;
+  return SPV_SUCCESS;
+}
+
 // A Disassembler instance converts a SPIR-V binary to its assembly
-// representation.
+// representation.  When accumulating a text result, output is appended to a
+// single contiguous buffer sized up front from the binary's word count, so
+// disassembly does not pay for per-token stream formatting or allocation.
 class Disassembler {
  public:
-  Disassembler(const libspirv::AssemblyGrammar& grammar, uint32_t options,
-               libspirv::NameMapper name_mapper)
+  Disassembler(const libspirv::AssemblyGrammar& grammar, size_t num_words,
+               uint32_t options, libspirv::NameMapper name_mapper)
       : grammar_(grammar),
         print_(spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_PRINT, options)),
         color_(print_ &&
@@ -51,13 +71,21 @@ class Disassembler {
                     ? kStandardIndent
                     : 0),
         text_(),
-        out_(print_ ? out_stream() : out_stream(text_)),
-        stream_(out_.get()),
         header_(!spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_NO_HEADER, options)),
         show_byte_offset_(spvIsInBitfield(
             SPV_BINARY_TO_TEXT_OPTION_SHOW_BYTE_OFFSET, options)),
+        raw_ids_(
+            spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_RAW_IDS, options)),
         byte_offset_(0),
-        name_mapper_(std::move(name_mapper)) {}
+        suppress_count_(0),
+        resume_byte_offset_(0),
+        has_resume_byte_offset_(false),
+        name_mapper_(std::move(name_mapper)) {
+    if (!print_) {
+      // Disassembly runs about a dozen characters per input word.
+      text_.reserve(num_words * 12 + 64);
+    }
+  }
 
   // Emits the assembly header for the module, and sets up internal state
   // so subsequent callbacks can handle the cases where the entire module
@@ -68,15 +96,28 @@ class Disassembler {
   // Emits the assembly text for the given instruction.
   spv_result_t HandleInstruction(const spv_parsed_instruction_t& inst);
 
+  // Arranges for the first |count| parsed instructions to produce no text,
+  // and for the byte offset of the instructions after them to resume at
+  // |resume_byte_offset|.  Used by the parallel path, where workers after
+  // the first re-parse the module's global section for context but emit
+  // only their own span of functions.
+  void SuppressLeadingInstructions(size_t count, size_t resume_byte_offset) {
+    suppress_count_ = count;
+    resume_byte_offset_ = resume_byte_offset;
+    has_resume_byte_offset_ = true;
+  }
+
+  // Returns the accumulated text.  Only valid when not printing.
+  const std::string& text() const { return text_; }
+
   // If not printing, populates text_result with the accumulated text.
   // Returns SPV_SUCCESS on success.
-  spv_result_t SaveTextResult(spv_text* text_result) const;
+  spv_result_t SaveTextResult(const spv_allocator_t& allocator,
+                              spv_text* text_result) const;
 
  private:
   enum { kStandardIndent = 15 };
 
-  using out_stream = libspirv::out_stream;
-
   // Emits an operand for the given instruction, where the instruction
   // is at offset words from the start of the binary.
   void EmitOperand(const spv_parsed_instruction_t& inst,
@@ -85,29 +126,129 @@ class Disassembler {
   // Emits a mask expression for the given mask word of the specified type.
   void EmitMaskOperand(const spv_operand_type_t type, const uint32_t word);
 
+  // Emits the given numeric literal operand of the instruction.
+  void EmitNumericLiteral(const spv_parsed_instruction_t& inst,
+                          const spv_parsed_operand_t& operand);
+
+  // Returns the name for the given id.  The name mapper builds a fresh
+  // string on every call, so names are cached per id: an id referenced many
+  // times is mapped once instead of allocating each time it is printed.
+  const std::string& NameForId(uint32_t id) {
+    if (id < cached_id_names_.size()) {
+      std::string& name = cached_id_names_[id];
+      if (name.empty()) name = name_mapper_(id);
+      return name;
+    }
+    // Out-of-bound ids only occur in invalid modules; don't cache them.
+    uncached_id_name_ = name_mapper_(id);
+    return uncached_id_name_;
+  }
+
+  // Emits "%<name>" for the given id.  In raw-id mode the decimal value is
+  // written straight from the integer, bypassing the name mapper and the
+  // per-id name cache entirely.
+  void WriteId(uint32_t id) {
+    Write('%');
+    if (raw_ids_)
+      WriteUnsigned(id);
+    else
+      Write(NameForId(id));
+  }
+
+  // Returns the number of decimal digits in the given value.
+  static int DecimalDigits(uint32_t value) {
+    int digits = 1;
+    while (value >= 10) {
+      value /= 10;
+      ++digits;
+    }
+    return digits;
+  }
+
+  // Appends the given text to the output: the contiguous text buffer when
+  // accumulating a result, or standard output when printing.
+  void Write(const char* text) {
+    if (print_)
+      std::cout << text;
+    else
+      text_ += text;
+  }
+  void Write(const char* text, size_t length) {
+    if (print_)
+      std::cout.write(text, length);
+    else
+      text_.append(text, length);
+  }
+  void Write(char c) {
+    if (print_)
+      std::cout.put(c);
+    else
+      text_.push_back(c);
+  }
+  void Write(const std::string& text) { Write(text.data(), text.size()); }
+  // Appends the given number of spaces to the output.  Does nothing for
+  // a zero or negative count.
+  void WriteSpaces(int count) {
+    for (int i = 0; i < count; ++i) Write(' ');
+  }
+  // Appends the decimal representation of the given value to the output,
+  // without going through iostream formatting.
+  void WriteUnsigned(uint64_t value) {
+    char digits[20];  // Enough for 2**64 - 1.
+    size_t pos = sizeof(digits);
+    do {
+      digits[--pos] = char('0' + value % 10);
+      value /= 10;
+    } while (value != 0);
+    Write(digits + pos, sizeof(digits) - pos);
+  }
+  void WriteSigned(int64_t value) {
+    if (value < 0) {
+      Write('-');
+      // Negate in unsigned arithmetic: -INT64_MIN overflows.
+      WriteUnsigned(~uint64_t(value) + 1);
+    } else {
+      WriteUnsigned(uint64_t(value));
+    }
+  }
+  // Appends the given value as at least eight lower-case hex digits.
+  void WriteHex(size_t value) {
+    char digits[2 * sizeof(size_t)];
+    size_t pos = sizeof(digits);
+    do {
+      digits[--pos] = "0123456789abcdef"[value & 0xF];
+      value >>= 4;
+    } while (value != 0);
+    while (sizeof(digits) - pos < 8) digits[--pos] = '0';
+    Write(digits + pos, sizeof(digits) - pos);
+  }
+
+  // Colors are only used when printing, so the escape sequences (or, on
+  // Windows, console attribute changes) go straight to standard output.
+
   // Resets the output color, if color is turned on.
   void ResetColor() {
-    if (color_) out_.get() << libspirv::clr::reset();
+    if (color_) std::cout << libspirv::clr::reset();
   }
   // Sets the output to grey, if color is turned on.
   void SetGrey() {
-    if (color_) out_.get() << libspirv::clr::grey();
+    if (color_) std::cout << libspirv::clr::grey();
   }
   // Sets the output to blue, if color is turned on.
   void SetBlue() {
-    if (color_) out_.get() << libspirv::clr::blue();
+    if (color_) std::cout << libspirv::clr::blue();
   }
   // Sets the output to yellow, if color is turned on.
   void SetYellow() {
-    if (color_) out_.get() << libspirv::clr::yellow();
+    if (color_) std::cout << libspirv::clr::yellow();
   }
   // Sets the output to red, if color is turned on.
   void SetRed() {
-    if (color_) out_.get() << libspirv::clr::red();
+    if (color_) std::cout << libspirv::clr::red();
   }
   // Sets the output to green, if color is turned on.
   void SetGreen() {
-    if (color_) out_.get() << libspirv::clr::green();
+    if (color_) std::cout << libspirv::clr::green();
   }
 
   const libspirv::AssemblyGrammar& grammar_;
@@ -115,13 +256,19 @@ class Disassembler {
   const bool color_;  // Should we print in colour?
   const int indent_;  // How much to indent. 0 means don't indent
   spv_endianness_t endian_;  // The detected endianness of the binary.
-  std::stringstream text_;   // Captures the text, if not printing.
-  out_stream out_;  // The Output stream.  Either to text_ or standard output.
-  std::ostream& stream_;  // The output std::stream.
-  const bool header_;     // Should we output header as the leading comment?
+  std::string text_;         // Accumulates the text, if not printing.
+  const bool header_;  // Should we output header as the leading comment?
   const bool show_byte_offset_;  // Should we print byte offset, in hex?
+  const bool raw_ids_;  // Print ids as plain numbers, skipping name mapping?
   size_t byte_offset_;           // The number of bytes processed so far.
+  size_t suppress_count_;        // Emit nothing for this many instructions.
+  size_t resume_byte_offset_;    // Byte offset after the suppressed prefix.
+  bool has_resume_byte_offset_;  // Is resume_byte_offset_ still pending?
   libspirv::NameMapper name_mapper_;
+  // Names already fetched from the mapper, indexed by id.  Sized from the
+  // header's id bound; an empty entry means the id has not been seen yet.
+  std::vector<std::string> cached_id_names_;
+  std::string uncached_id_name_;  // Backing store for out-of-bound ids.
 };
 
 spv_result_t Disassembler::HandleHeader(spv_endianness_t endian,
@@ -133,65 +280,84 @@ spv_result_t Disassembler::HandleHeader(spv_endianness_t endian,
     SetGrey();
     const char* generator_tool =
         spvGeneratorStr(SPV_GENERATOR_TOOL_PART(generator));
-    stream_ << "; SPIR-V\n"
-            << "; Version: " << SPV_SPIRV_VERSION_MAJOR_PART(version) << "."
-            << SPV_SPIRV_VERSION_MINOR_PART(version) << "\n"
-            << "; Generator: " << generator_tool;
+    Write("; SPIR-V\n; Version: ");
+    WriteUnsigned(SPV_SPIRV_VERSION_MAJOR_PART(version));
+    Write('.');
+    WriteUnsigned(SPV_SPIRV_VERSION_MINOR_PART(version));
+    Write("\n; Generator: ");
+    Write(generator_tool);
     // For unknown tools, print the numeric tool value.
     if (0 == strcmp("Unknown", generator_tool)) {
-      stream_ << "(" << SPV_GENERATOR_TOOL_PART(generator) << ")";
+      Write('(');
+      WriteUnsigned(SPV_GENERATOR_TOOL_PART(generator));
+      Write(')');
     }
     // Print the miscellaneous part of the generator word on the same
     // line as the tool name.
-    stream_ << "; " << SPV_GENERATOR_MISC_PART(generator) << "\n"
-            << "; Bound: " << id_bound << "\n"
-            << "; Schema: " << schema << "\n";
+    Write("; ");
+    WriteUnsigned(SPV_GENERATOR_MISC_PART(generator));
+    Write("\n; Bound: ");
+    WriteUnsigned(id_bound);
+    Write("\n; Schema: ");
+    WriteUnsigned(schema);
+    Write('\n');
     ResetColor();
   }
 
   byte_offset_ = SPV_INDEX_INSTRUCTION * sizeof(uint32_t);
+  // Raw-id mode never consults the name cache, so don't pay for it.
+  if (!raw_ids_) cached_id_names_.resize(id_bound);
 
   return SPV_SUCCESS;
 }
 
 spv_result_t Disassembler::HandleInstruction(
     const spv_parsed_instruction_t& inst) {
+  if (suppress_count_) {
+    --suppress_count_;
+    return SPV_SUCCESS;
+  }
+  if (has_resume_byte_offset_) {
+    byte_offset_ = resume_byte_offset_;
+    has_resume_byte_offset_ = false;
+  }
+
   if (inst.result_id) {
     SetBlue();
-    const std::string id_name = name_mapper_(inst.result_id);
-    if (indent_)
-      stream_ << std::setw(std::max(0, indent_ - 3 - int(id_name.size())));
-    stream_ << "%" << id_name;
+    // Pad on the left so the "= " ends at the indent column.
+    if (indent_) {
+      const int name_size = raw_ids_
+                                ? DecimalDigits(inst.result_id)
+                                : int(NameForId(inst.result_id).size());
+      WriteSpaces(indent_ - 4 - name_size);
+    }
+    WriteId(inst.result_id);
     ResetColor();
-    stream_ << " = ";
+    Write(" = ");
   } else {
-    stream_ << std::string(indent_, ' ');
+    WriteSpaces(indent_);
   }
 
-  stream_ << "Op" << spvOpcodeString(static_cast<SpvOp>(inst.opcode));
+  Write(spvOpcodeStringPrefixed(static_cast<SpvOp>(inst.opcode)));
 
   for (uint16_t i = 0; i < inst.num_operands; i++) {
     const spv_operand_type_t type = inst.operands[i].type;
     assert(type != SPV_OPERAND_TYPE_NONE);
     if (type == SPV_OPERAND_TYPE_RESULT_ID) continue;
-    stream_ << " ";
+    Write(' ');
     EmitOperand(inst, i);
   }
 
   if (show_byte_offset_) {
     SetGrey();
-    auto saved_flags = stream_.flags();
-    auto saved_fill = stream_.fill();
-    stream_ << " ; 0x" << std::setw(8) << std::hex << std::setfill('0')
-            << byte_offset_;
-    stream_.flags(saved_flags);
-    stream_.fill(saved_fill);
+    Write(" ; 0x");
+    WriteHex(byte_offset_);
     ResetColor();
   }
 
   byte_offset_ += inst.num_words * sizeof(uint32_t);
 
-  stream_ << "\n";
+  Write('\n');
   return SPV_SUCCESS;
 }
 
@@ -204,48 +370,55 @@ void Disassembler::EmitOperand(const spv_parsed_instruction_t& inst,
     case SPV_OPERAND_TYPE_RESULT_ID:
       assert(false && "<result-id> is not supposed to be handled here");
       SetBlue();
-      stream_ << "%" << name_mapper_(word);
+      WriteId(word);
       break;
     case SPV_OPERAND_TYPE_ID:
     case SPV_OPERAND_TYPE_TYPE_ID:
     case SPV_OPERAND_TYPE_SCOPE_ID:
     case SPV_OPERAND_TYPE_MEMORY_SEMANTICS_ID:
       SetYellow();
-      stream_ << "%" << name_mapper_(word);
+      WriteId(word);
       break;
     case SPV_OPERAND_TYPE_EXTENSION_INSTRUCTION_NUMBER: {
       spv_ext_inst_desc ext_inst;
       if (grammar_.lookupExtInst(inst.ext_inst_type, word, &ext_inst))
         assert(false && "should have caught this earlier");
       SetRed();
-      stream_ << ext_inst->name;
+      Write(ext_inst->name);
     } break;
     case SPV_OPERAND_TYPE_SPEC_CONSTANT_OP_NUMBER: {
       spv_opcode_desc opcode_desc;
       if (grammar_.lookupOpcode(SpvOp(word), &opcode_desc))
         assert(false && "should have caught this earlier");
       SetRed();
-      stream_ << opcode_desc->name;
+      Write(opcode_desc->name);
     } break;
     case SPV_OPERAND_TYPE_LITERAL_INTEGER:
     case SPV_OPERAND_TYPE_TYPED_LITERAL_NUMBER: {
       SetRed();
-      libspirv::EmitNumericLiteral(&stream_, inst, operand);
+      EmitNumericLiteral(inst, operand);
       ResetColor();
     } break;
     case SPV_OPERAND_TYPE_LITERAL_STRING: {
-      stream_ << "\"";
+      Write('"');
       SetGreen();
       // Strings are always little-endian, and null-terminated.
-      // Write out the characters, escaping as needed, and without copying
-      // the entire string.
+      // Write out the characters in runs between escapes, and without
+      // copying the entire string.
       auto c_str = reinterpret_cast<const char*>(inst.words + operand.offset);
-      for (auto p = c_str; *p; ++p) {
-        if (*p == '"' || *p == '\\') stream_ << '\\';
-        stream_ << *p;
+      auto run_start = c_str;
+      for (auto p = c_str;; ++p) {
+        if (*p == '"' || *p == '\\') {
+          Write(run_start, p - run_start);
+          Write('\\');
+          run_start = p;  // The escaped character leads the next run.
+        } else if (!*p) {
+          Write(run_start, p - run_start);
+          break;
+        }
       }
       ResetColor();
-      stream_ << '"';
+      Write('"');
     } break;
     case SPV_OPERAND_TYPE_CAPABILITY:
     case SPV_OPERAND_TYPE_SOURCE_LANGUAGE:
@@ -270,7 +443,7 @@ void Disassembler::EmitOperand(const spv_parsed_instruction_t& inst,
       spv_operand_desc entry;
       if (grammar_.lookupOperand(operand.type, word, &entry))
         assert(false && "should have caught this earlier");
-      stream_ << entry->name;
+      Write(entry->name);
     } break;
     case SPV_OPERAND_TYPE_FP_FAST_MATH_MODE:
     case SPV_OPERAND_TYPE_FUNCTION_CONTROL:
@@ -299,8 +472,8 @@ void Disassembler::EmitMaskOperand(const spv_operand_type_t type,
       spv_operand_desc entry;
       if (grammar_.lookupOperand(type, mask, &entry))
         assert(false && "should have caught this earlier");
-      if (num_emitted) stream_ << "|";
-      stream_ << entry->name;
+      if (num_emitted) Write('|');
+      Write(entry->name);
       num_emitted++;
     }
   }
@@ -309,25 +482,78 @@ void Disassembler::EmitMaskOperand(const spv_operand_type_t type,
     // of the 0 value. In many cases, that's "None".
     spv_operand_desc entry;
     if (SPV_SUCCESS == grammar_.lookupOperand(type, 0, &entry))
-      stream_ << entry->name;
+      Write(entry->name);
   }
 }
 
-spv_result_t Disassembler::SaveTextResult(spv_text* text_result) const {
-  if (!print_) {
-    size_t length = text_.str().size();
-    char* str = new char[length + 1];
-    if (!str) return SPV_ERROR_OUT_OF_MEMORY;
-    strncpy(str, text_.str().c_str(), length + 1);
-    spv_text text = new spv_text_t();
-    if (!text) {
-      delete[] str;
-      return SPV_ERROR_OUT_OF_MEMORY;
+void Disassembler::EmitNumericLiteral(const spv_parsed_instruction_t& inst,
+                                      const spv_parsed_operand_t& operand) {
+  // Integer literals dominate real modules, so format them directly into
+  // the output buffer.  Floating-point literals still go through the
+  // shared stream-based formatter; they are rare enough that the cost of
+  // a temporary stream does not matter.
+  const uint32_t word = inst.words[operand.offset];
+  if (operand.num_words == 1) {
+    if (operand.number_kind == SPV_NUMBER_SIGNED_INT) {
+      WriteSigned(int32_t(word));
+      return;
+    }
+    if (operand.number_kind == SPV_NUMBER_UNSIGNED_INT) {
+      WriteUnsigned(word);
+      return;
+    }
+  } else if (operand.num_words == 2 &&
+             operand.number_kind != SPV_NUMBER_FLOATING) {
+    // Multi-word numbers are presented with lower order words first.
+    const uint64_t bits =
+        uint64_t(word) | (uint64_t(inst.words[operand.offset + 1]) << 32);
+    if (operand.number_kind == SPV_NUMBER_SIGNED_INT) {
+      WriteSigned(int64_t(bits));
+      return;
+    }
+    if (operand.number_kind == SPV_NUMBER_UNSIGNED_INT) {
+      WriteUnsigned(bits);
+      return;
+    }
+  }
+  // Zero and normal 32- and 64-bit floats format via printf %g, which
+  // produces the same text as the stream formatter's default floatfield at
+  // the same precision, without constructing a stream per literal.
+  // Subnormals, infinities, NaNs, and 16-bit floats keep the hex-float
+  // stream path for bit fidelity.
+  if (operand.number_kind == SPV_NUMBER_FLOATING) {
+    char buffer[64];
+    int length = -1;
+    if (operand.number_bit_width == 32 && operand.num_words == 1) {
+      const float value = spvutils::FloatProxy<float>(word).getAsFloat();
+      const int value_class = std::fpclassify(value);
+      if (value_class == FP_ZERO || value_class == FP_NORMAL) {
+        length = snprintf(buffer, sizeof(buffer), "%.*g",
+                          std::numeric_limits<float>::digits10, value);
+      }
+    } else if (operand.number_bit_width == 64 && operand.num_words == 2) {
+      const uint64_t bits =
+          uint64_t(word) | (uint64_t(inst.words[operand.offset + 1]) << 32);
+      const double value = spvutils::FloatProxy<double>(bits).getAsFloat();
+      const int value_class = std::fpclassify(value);
+      if (value_class == FP_ZERO || value_class == FP_NORMAL) {
+        length = snprintf(buffer, sizeof(buffer), "%.*g",
+                          std::numeric_limits<double>::digits10, value);
+      }
+    }
+    if (length > 0) {
+      Write(buffer, size_t(length));
+      return;
     }
-    text->str = str;
-    text->length = length;
-    *text_result = text;
   }
+  std::ostringstream formatted;
+  libspirv::EmitNumericLiteral(&formatted, inst, operand);
+  Write(formatted.str());
+}
+
+spv_result_t Disassembler::SaveTextResult(const spv_allocator_t& allocator,
+                                          spv_text* text_result) const {
+  if (!print_) return SaveText(text_, allocator, text_result);
   return SPV_SUCCESS;
 }
 
@@ -348,6 +574,147 @@ spv_result_t DisassembleInstruction(
   return disassembler->HandleInstruction(*parsed_instruction);
 }
 
+// A contiguous range of words holding whole functions, to be disassembled
+// by one worker.
+struct FunctionSpan {
+  size_t begin;  // Word index of the span's first OpFunction.
+  size_t end;    // Word index just past the span's last instruction.
+};
+
+// Scans the instruction stream of the given binary and records the word
+// index of each top-level OpFunction, using only the word counts in the
+// instruction headers.  On success, sets |global_end| to the word index of
+// the first OpFunction (or num_words if there is none), sets
+// |num_global_instructions| to the number of instructions before that
+// point, and returns true.  Returns false if an instruction header is
+// malformed; the caller should fall back to the sequential parser, which
+// will produce a proper diagnostic.
+bool FindFunctionBoundaries(const uint32_t* code, size_t num_words,
+                            spv_endianness_t endian, size_t* global_end,
+                            size_t* num_global_instructions,
+                            std::vector<size_t>* function_starts) {
+  *global_end = num_words;
+  *num_global_instructions = 0;
+  size_t index = SPV_INDEX_INSTRUCTION;
+  if (index > num_words) return false;
+  while (index < num_words) {
+    uint16_t word_count;
+    uint16_t opcode;
+    spvOpcodeSplit(spvFixWord(code[index], endian), &word_count, &opcode);
+    if (word_count == 0 || num_words - index < word_count) return false;
+    if (opcode == SpvOpFunction) {
+      if (function_starts->empty()) *global_end = index;
+      function_starts->push_back(index);
+    } else if (function_starts->empty()) {
+      ++*num_global_instructions;
+    }
+    index += word_count;
+  }
+  return true;
+}
+
+// Disassembles function bodies concurrently, one contiguous span of
+// functions per worker, and saves the per-worker text stitched back in
+// module order.  The first worker emits the header and the global section
+// along with its own functions; later workers re-parse a copy of the
+// global section silently, so the parser sees extended-instruction imports
+// and type widths, and emit only their own span.  Returns false, without
+// touching |text_result|, when the binary is too small to partition or a
+// worker's parse fails; the caller then disassembles sequentially, which
+// also reports any parse error through the usual path.
+bool TryParallelDisassemble(const spv_context_t& context,
+                            const libspirv::AssemblyGrammar& grammar,
+                            const libspirv::NameMapper& name_mapper,
+                            const uint32_t* code, size_t num_words,
+                            uint32_t options, spv_text* text_result,
+                            spv_result_t* result) {
+  spv_const_binary_t binary = {code, num_words};
+  spv_endianness_t endian;
+  if (spvBinaryEndianness(&binary, &endian)) return false;
+
+  size_t global_end;
+  size_t num_global_instructions;
+  std::vector<size_t> function_starts;
+  if (!FindFunctionBoundaries(code, num_words, endian, &global_end,
+                              &num_global_instructions, &function_starts))
+    return false;
+
+  const size_t num_workers = std::min<size_t>(
+      std::max(1u, std::thread::hardware_concurrency()),
+      function_starts.size());
+  if (num_workers < 2) return false;
+
+  // Split the function region into contiguous spans of roughly equal word
+  // counts, cutting only at function boundaries.
+  const size_t target_words =
+      (num_words - global_end + num_workers - 1) / num_workers;
+  std::vector<FunctionSpan> spans;
+  size_t span_begin = function_starts[0];
+  for (size_t i = 0; i < function_starts.size(); ++i) {
+    const size_t function_end =
+        i + 1 < function_starts.size() ? function_starts[i + 1] : num_words;
+    if (function_end - span_begin >= target_words &&
+        spans.size() + 1 < num_workers) {
+      spans.push_back({span_begin, function_end});
+      span_begin = function_end;
+    }
+  }
+  if (span_begin < num_words) spans.push_back({span_begin, num_words});
+  if (spans.size() < 2) return false;
+
+  // Workers parse with a muted message consumer, so the caller's consumer
+  // is never invoked from more than one thread.  On failure the caller
+  // re-parses sequentially and the diagnostic is produced deterministically.
+  spv_context_t quiet_context = context;
+  SetContextMessageConsumer(&quiet_context,
+                            [](spv_message_level_t, const char*,
+                               const spv_position_t&, const char*) {});
+
+  std::vector<std::unique_ptr<Disassembler>> workers(spans.size());
+  std::vector<spv_result_t> results(spans.size(), SPV_SUCCESS);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < spans.size(); ++i) {
+    threads.emplace_back([&workers, &results, &spans, &quiet_context, &grammar,
+                          &name_mapper, code, options, global_end,
+                          num_global_instructions, i] {
+      if (i == 0) {
+        // The leading span includes the header and the global section, so
+        // it parses the original binary's prefix directly.
+        workers[i].reset(
+            new Disassembler(grammar, spans[i].end, options, name_mapper));
+        results[i] = spvBinaryParse(&quiet_context, workers[i].get(), code,
+                                    spans[i].end, DisassembleHeader,
+                                    DisassembleInstruction, nullptr);
+      } else {
+        std::vector<uint32_t> subset(code, code + global_end);
+        subset.insert(subset.end(), code + spans[i].begin,
+                      code + spans[i].end);
+        workers[i].reset(new Disassembler(
+            grammar, spans[i].end - spans[i].begin,
+            options | SPV_BINARY_TO_TEXT_OPTION_NO_HEADER, name_mapper));
+        workers[i]->SuppressLeadingInstructions(
+            num_global_instructions, spans[i].begin * sizeof(uint32_t));
+        results[i] = spvBinaryParse(&quiet_context, workers[i].get(),
+                                    subset.data(), subset.size(),
+                                    DisassembleHeader, DisassembleInstruction,
+                                    nullptr);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  for (auto worker_result : results)
+    if (worker_result != SPV_SUCCESS) return false;
+
+  size_t total_length = 0;
+  for (auto& worker : workers) total_length += worker->text().size();
+  std::string text;
+  text.reserve(total_length);
+  for (auto& worker : workers) text += worker->text();
+  *result = SaveText(text, context.allocator, text_result);
+  return true;
+}
+
 }  // anonymous namespace
 
 spv_result_t spvBinaryToText(const spv_const_context context,
@@ -363,22 +730,226 @@ spv_result_t spvBinaryToText(const spv_const_context context,
   const libspirv::AssemblyGrammar grammar(&hijack_context);
   if (!grammar.isValid()) return SPV_ERROR_INVALID_TABLE;
 
-  // Generate friendly names for Ids if requested.
+  // Generate friendly names for Ids if requested.  Raw-id mode prints ids
+  // straight from their numeric values, so no mapper is built for it.
   std::unique_ptr<libspirv::FriendlyNameMapper> friendly_mapper;
   libspirv::NameMapper name_mapper = libspirv::GetTrivialNameMapper();
-  if (options & SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES) {
+  if ((options & SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES) &&
+      !(options & SPV_BINARY_TO_TEXT_OPTION_RAW_IDS)) {
     friendly_mapper.reset(
         new libspirv::FriendlyNameMapper(&hijack_context, code, wordCount));
     name_mapper = friendly_mapper->GetNameMapper();
   }
 
+  // Try the multi-threaded path first, if requested.  It only applies when
+  // accumulating a text result: printing interleaves with the console (and,
+  // on Windows, with console color attributes) and stays sequential.
+  if (spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_PARALLEL, options) &&
+      !spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_PRINT, options) && pText) {
+    // Resolve all friendly names before the workers start: the mapper
+    // otherwise parses the module on the first lookup, and lookups after
+    // that parse are read-only and safe to share.
+    if (friendly_mapper) friendly_mapper->ParseModule();
+    spv_result_t result = SPV_SUCCESS;
+    if (TryParallelDisassemble(hijack_context, grammar, name_mapper, code,
+                               wordCount, options, pText, &result)) {
+      return result;
+    }
+    // Otherwise fall through to the sequential path, which also reports
+    // any parse error a worker ran into.
+  }
+
   // Now disassemble!
-  Disassembler disassembler(grammar, options, name_mapper);
+  Disassembler disassembler(grammar, wordCount, options, name_mapper);
   if (auto error = spvBinaryParse(&hijack_context, &disassembler, code,
                                   wordCount, DisassembleHeader,
                                   DisassembleInstruction, pDiagnostic)) {
     return error;
   }
 
-  return disassembler.SaveTextResult(pText);
+  return disassembler.SaveTextResult(hijack_context.allocator, pText);
+}
+
+spv_result_t spvBinaryToTextRange(const spv_const_context context,
+                                  const uint32_t* code, const size_t wordCount,
+                                  const uint32_t options,
+                                  const size_t begin_offset,
+                                  const size_t end_offset, spv_text* pText,
+                                  spv_diagnostic* pDiagnostic) {
+  spv_context_t hijack_context = *context;
+  if (pDiagnostic) {
+    *pDiagnostic = nullptr;
+    libspirv::UseDiagnosticAsMessageConsumer(&hijack_context, pDiagnostic);
+  }
+
+  if (begin_offset < SPV_INDEX_INSTRUCTION || begin_offset >= end_offset ||
+      end_offset > wordCount) {
+    return libspirv::DiagnosticStream({0, 0, 0}, hijack_context.consumer,
+                                      SPV_ERROR_INVALID_BINARY)
+           << "Word range [" << begin_offset << ", " << end_offset
+           << ") does not lie within the module.";
+  }
+
+  const libspirv::AssemblyGrammar grammar(&hijack_context);
+  if (!grammar.isValid()) return SPV_ERROR_INVALID_TABLE;
+
+  spv_const_binary_t binary = {code, wordCount};
+  spv_endianness_t endian;
+  if (spvBinaryEndianness(&binary, &endian)) {
+    return libspirv::DiagnosticStream({0, 0, 0}, hijack_context.consumer,
+                                      SPV_ERROR_INVALID_BINARY)
+           << "Invalid SPIR-V magic number.";
+  }
+
+  std::unique_ptr<libspirv::FriendlyNameMapper> friendly_mapper;
+  libspirv::NameMapper name_mapper = libspirv::GetTrivialNameMapper();
+  if ((options & SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES) &&
+      !(options & SPV_BINARY_TO_TEXT_OPTION_RAW_IDS)) {
+    friendly_mapper.reset(
+        new libspirv::FriendlyNameMapper(&hijack_context, code, wordCount));
+    name_mapper = friendly_mapper->GetNameMapper();
+  }
+
+  // Re-parse the global section ahead of the range, silently, so the parser
+  // sees the extended instruction set imports and type widths the range's
+  // instructions may rely on.  A range starting inside the global section
+  // keeps only the part before it as context.
+  size_t global_end;
+  size_t num_global_instructions;
+  std::vector<size_t> function_starts;
+  if (!FindFunctionBoundaries(code, wordCount, endian, &global_end,
+                              &num_global_instructions, &function_starts)) {
+    return libspirv::DiagnosticStream({0, 0, 0}, hijack_context.consumer,
+                                      SPV_ERROR_INVALID_BINARY)
+           << "Malformed instruction header in the module.";
+  }
+  const size_t prefix_end = std::min(begin_offset, global_end);
+  size_t num_prefix_instructions = 0;
+  for (size_t index = SPV_INDEX_INSTRUCTION; index < prefix_end;) {
+    uint16_t word_count_field, opcode;
+    spvOpcodeSplit(spvFixWord(code[index], endian), &word_count_field,
+                   &opcode);
+    index += word_count_field;
+    ++num_prefix_instructions;
+  }
+
+  std::vector<uint32_t> subset(code, code + prefix_end);
+  subset.insert(subset.end(), code + begin_offset, code + end_offset);
+
+  Disassembler disassembler(grammar, end_offset - begin_offset, options,
+                            name_mapper);
+  disassembler.SuppressLeadingInstructions(
+      num_prefix_instructions, begin_offset * sizeof(uint32_t));
+  if (auto error = spvBinaryParse(&hijack_context, &disassembler,
+                                  subset.data(), subset.size(),
+                                  DisassembleHeader, DisassembleInstruction,
+                                  pDiagnostic)) {
+    return error;
+  }
+
+  return disassembler.SaveTextResult(hijack_context.allocator, pText);
+}
+
+spv_result_t spvBinaryToTextFunction(const spv_const_context context,
+                                     const uint32_t* code,
+                                     const size_t wordCount,
+                                     const uint32_t options,
+                                     const uint32_t function_id,
+                                     spv_text* pText,
+                                     spv_diagnostic* pDiagnostic) {
+  spv_function_index index = nullptr;
+  if (auto error = spvBinaryBuildFunctionIndex(context, code, wordCount,
+                                               &index, pDiagnostic)) {
+    return error;
+  }
+  size_t begin_offset = 0, end_offset = 0;
+  for (uint32_t i = 0; i < index->num_functions; ++i) {
+    if (index->functions[i].id == function_id) {
+      begin_offset = index->functions[i].begin;
+      end_offset = index->functions[i].end;
+      break;
+    }
+  }
+  spvFunctionIndexDestroy(index);
+  if (begin_offset == end_offset) {
+    spv_context_t hijack_context = *context;
+    if (pDiagnostic) {
+      *pDiagnostic = nullptr;
+      libspirv::UseDiagnosticAsMessageConsumer(&hijack_context, pDiagnostic);
+    }
+    return libspirv::DiagnosticStream({0, 0, 0}, hijack_context.consumer,
+                                      SPV_ERROR_INVALID_LOOKUP)
+           << "No function with result id " << function_id
+           << " in the module.";
+  }
+  return spvBinaryToTextRange(context, code, wordCount, options, begin_offset,
+                              end_offset, pText, pDiagnostic);
+}
+
+// A streaming disassembler session couples a Disassembler in printing mode
+// to a StreamingBinaryParser, so each instruction's text is emitted as soon
+// as its words have been fed in.  The copied context redirects messages
+// into the session's diagnostic slot, which Parse hands to the caller.
+struct spv_streaming_disassembler_t {
+  explicit spv_streaming_disassembler_t(const spv_const_context context)
+      : hijack_context(*context) {}
+
+  spv_context_t hijack_context;
+  spv_diagnostic diagnostic = nullptr;
+  std::unique_ptr<libspirv::AssemblyGrammar> grammar;
+  std::unique_ptr<Disassembler> disassembler;
+  std::unique_ptr<libspirv::StreamingBinaryParser> parser;
+
+  ~spv_streaming_disassembler_t() { spvDiagnosticDestroy(diagnostic); }
+};
+
+spv_streaming_disassembler spvStreamingDisassemblerCreate(
+    const spv_const_context context, const uint32_t options) {
+  if (!context) return nullptr;
+  // Printing is the only way to emit text before the module ends, and both
+  // friendly names and the parallel path must see the whole module first.
+  if (!spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_PRINT, options) ||
+      spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES, options) ||
+      spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_PARALLEL, options)) {
+    return nullptr;
+  }
+
+  auto session = std::unique_ptr<spv_streaming_disassembler_t>(
+      new spv_streaming_disassembler_t(context));
+  libspirv::UseDiagnosticAsMessageConsumer(&session->hijack_context,
+                                           &session->diagnostic);
+  session->grammar.reset(
+      new libspirv::AssemblyGrammar(&session->hijack_context));
+  if (!session->grammar->isValid()) return nullptr;
+  // The word count is only used to size the text buffer, which printing
+  // never allocates.
+  session->disassembler.reset(new Disassembler(
+      *session->grammar, 0, options, libspirv::GetTrivialNameMapper()));
+  session->parser.reset(new libspirv::StreamingBinaryParser(
+      &session->hijack_context, session->disassembler.get(),
+      DisassembleHeader, DisassembleInstruction));
+  return session.release();
+}
+
+void spvStreamingDisassemblerDestroy(spv_streaming_disassembler disassembler) {
+  delete disassembler;
+}
+
+spv_result_t spvStreamingDisassemblerParse(
+    spv_streaming_disassembler disassembler, const uint32_t* words,
+    const size_t num_words, const bool input_complete,
+    spv_diagnostic* diagnostic) {
+  if (diagnostic) *diagnostic = nullptr;
+  if (!disassembler) return SPV_ERROR_INVALID_POINTER;
+  const spv_result_t result =
+      disassembler->parser->Parse(words, num_words, input_complete);
+  if (disassembler->diagnostic) {
+    if (diagnostic) {
+      *diagnostic = disassembler->diagnostic;
+    } else {
+      spvDiagnosticDestroy(disassembler->diagnostic);
+    }
+    disassembler->diagnostic = nullptr;
+  }
+  return result;
 }
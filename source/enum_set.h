@@ -26,10 +26,12 @@
 namespace libspirv {
 
 // A set of values of a 32-bit enum type.
-// It is fast and compact for the common case, where enum values
-// are at most 63.  But it can represent enums with larger values,
-// as may appear in extensions.
-template <typename EnumType>
+// Enum values below 64 * |kNumMaskWords| are stored in a fixed-width inline
+// bitset, so membership and intersection tests on them are plain word
+// operations with no allocation.  Larger values, as may appear in
+// extensions a set was not sized for, still work through a heap std::set
+// overflow, so correctness never depends on the chosen width.
+template <typename EnumType, uint32_t kNumMaskWords = 1>
 class EnumSet {
  private:
   // The ForEach method will call the functor on enum values in
@@ -50,15 +52,17 @@ class EnumSet {
   EnumSet(const EnumSet& other) { *this = other; }
   // Move constructor.  The moved-from set is emptied.
   EnumSet(EnumSet&& other) {
-    mask_ = other.mask_;
+    for (uint32_t i = 0; i < kNumMaskWords; ++i) {
+      mask_[i] = other.mask_[i];
+      other.mask_[i] = 0;
+    }
     overflow_ = std::move(other.overflow_);
-    other.mask_ = 0;
     other.overflow_.reset(nullptr);
   }
   // Assignment operator.
   EnumSet& operator=(const EnumSet& other) {
     if (&other != this) {
-      mask_ = other.mask_;
+      for (uint32_t i = 0; i < kNumMaskWords; ++i) mask_[i] = other.mask_[i];
       overflow_.reset(other.overflow_ ? new OverflowSetType(*other.overflow_)
                                       : nullptr);
     }
@@ -69,14 +73,49 @@ class EnumSet {
   // enum value is already in the set.
   void Add(EnumType c) { AddWord(ToWord(c)); }
 
+  // Adds every element of |other| to the set.  The inline parts combine as
+  // plain word ORs.
+  void AddAll(const EnumSet& other) {
+    for (uint32_t i = 0; i < kNumMaskWords; ++i) mask_[i] |= other.mask_[i];
+    if (other.overflow_) {
+      for (uint32_t c : *other.overflow_) Overflow().insert(c);
+    }
+  }
+
   // Returns true if this enum value is in the set.
   bool Contains(EnumType c) const { return ContainsWord(ToWord(c)); }
 
+  // Set union and intersection.  The inline parts combine as plain word
+  // operations; overflow members are merged or filtered through the sets.
+  EnumSet& operator|=(const EnumSet& other) {
+    AddAll(other);
+    return *this;
+  }
+  EnumSet& operator&=(const EnumSet& other) {
+    for (uint32_t i = 0; i < kNumMaskWords; ++i) mask_[i] &= other.mask_[i];
+    if (overflow_) {
+      if (!other.overflow_) {
+        overflow_.reset(nullptr);
+      } else {
+        for (auto it = overflow_->begin(); it != overflow_->end();) {
+          if (other.overflow_->count(*it) == 0)
+            it = overflow_->erase(it);
+          else
+            ++it;
+        }
+      }
+    }
+    return *this;
+  }
+
   // Applies f to each enum in the set, in order from smallest enum
-  // value to largest.
+  // value to largest.  Only the set bits of each mask word are visited, so
+  // sparse sets don't pay for the empty bit positions.
   void ForEach(std::function<void(EnumType)> f) const {
-    for (uint32_t i = 0; i < 64; ++i) {
-      if (mask_ & AsMask(i)) f(static_cast<EnumType>(i));
+    for (uint32_t w = 0; w < kNumMaskWords; ++w) {
+      for (uint64_t bits = mask_[w]; bits; bits &= bits - 1) {
+        f(static_cast<EnumType>(w * 64 + LowestBit(bits)));
+      }
     }
     if (overflow_) {
       for (uint32_t c : *overflow_) f(static_cast<EnumType>(c));
@@ -85,18 +124,21 @@ class EnumSet {
 
   // Returns true if the set is empty.
   bool IsEmpty() const {
-    if (mask_) return false;
+    for (uint32_t i = 0; i < kNumMaskWords; ++i) {
+      if (mask_[i]) return false;
+    }
     if (overflow_ && !overflow_->empty()) return false;
     return true;
   }
 
   // Returns true if the set contains ANY of the elements of |in_set|,
   // or if |in_set| is empty.
-  bool HasAnyOf(const EnumSet<EnumType>& in_set) const {
+  bool HasAnyOf(const EnumSet& in_set) const {
     if (in_set.IsEmpty()) return true;
 
-    if (mask_ & in_set.mask_)
-      return true;
+    for (uint32_t i = 0; i < kNumMaskWords; ++i) {
+      if (mask_[i] & in_set.mask_[i]) return true;
+    }
 
     if (!overflow_ || !in_set.overflow_)
       return false;
@@ -113,8 +155,8 @@ class EnumSet {
   // Adds the given enum value (as a 32-bit word) to the set.  This has no
   // effect if the enum value is already in the set.
   void AddWord(uint32_t word) {
-    if (auto new_bits = AsMask(word)) {
-      mask_ |= new_bits;
+    if (InMask(word)) {
+      mask_[word / 64] |= uint64_t(1) << (word % 64);
     } else {
       Overflow().insert(word);
     }
@@ -123,8 +165,8 @@ class EnumSet {
   // Returns true if the enum represented as a 32-bit word is in the set.
   bool ContainsWord(uint32_t word) const {
     // We shouldn't call Overflow() since this is a const method.
-    if (auto bits = AsMask(word)) {
-      return (mask_ & bits) != 0;
+    if (InMask(word)) {
+      return (mask_[word / 64] & (uint64_t(1) << (word % 64))) != 0;
     } else if (auto overflow = overflow_.get()) {
       return overflow->find(word) != overflow->end();
     }
@@ -140,12 +182,22 @@ class EnumSet {
     return static_cast<uint32_t>(value);
   }
 
-  // Determines whether the given enum value can be represented
-  // as a bit in a uint64_t mask. If so, then returns that mask bit.
-  // Otherwise, returns 0.
-  uint64_t AsMask(uint32_t word) const {
-    if (word > 63) return 0;
-    return uint64_t(1) << word;
+  // Returns true if the given enum value is covered by the inline bitset.
+  static bool InMask(uint32_t word) { return word < kNumMaskWords * 64; }
+
+  // Returns the index of the lowest set bit of |word|, which must not be
+  // zero.
+  static uint32_t LowestBit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<uint32_t>(__builtin_ctzll(word));
+#else
+    uint32_t bit = 0;
+    while (!(word & 1)) {
+      word >>= 1;
+      ++bit;
+    }
+    return bit;
+#endif
   }
 
   // Ensures that overflow_set_ references a set.  A new empty set is
@@ -157,15 +209,23 @@ class EnumSet {
     return *overflow_;
   }
 
-  // Enums with values up to 63 are stored as bits in this mask.
-  uint64_t mask_ = 0;
-  // Enums with values larger than 63 are stored in this set.
+  // Enums with values below 64 * kNumMaskWords are stored as bits here.
+  uint64_t mask_[kNumMaskWords] = {};
+  // Enums with larger values are stored in this set.
   // This set should normally be empty or very small.
   std::unique_ptr<OverflowSetType> overflow_ = {};
 };
 
-// A set of SpvCapability, optimized for small capability values.
-using CapabilitySet = EnumSet<SpvCapability>;
+// The number of inline bitset words for CapabilitySet.  Sized to cover every
+// capability value in the grammar tables, including the extension
+// capabilities in the 4xxx and 5xxx ranges, so capability queries never
+// touch the overflow set.
+static const uint32_t kCapabilityMaskWords = 88;
+
+// A set of SpvCapability.  Capability checks run for nearly every operand
+// the validator sees, so all values the tables can produce live in the
+// inline bitset.
+using CapabilitySet = EnumSet<SpvCapability, kCapabilityMaskWords>;
 
 }  // namespace libspirv
 
@@ -15,8 +15,8 @@
 #include "enum_string_mapping.h"
 
 #include <cassert>
+#include <cstdint>
 #include <string>
-#include <unordered_map>
 
 #include "extensions.h"
 
@@ -14,8 +14,13 @@
 
 #include "ext_inst.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include "spirv/1.0/GLSL.std.450.h"
 #include "spirv/1.0/OpenCL.std.h"
@@ -35,22 +40,81 @@ static const spv_ext_inst_desc_t spv_amd_gcn_shader_entries[] = {
 #include "spv-amd-gcn-shader.insts.inc"
 };
 
+namespace {
+
+// Sentinel marking an unused slot in a value-indexed lookup vector.
+const uint16_t kInvalidExtInstEntry = 0xffff;
+
+// A lookup index over one extended instruction group: entry indices sorted
+// by instruction name for binary-search name lookup, and a dense
+// value-to-entry-index vector for O(1) value lookup.  GLSL.std.450
+// instructions in particular are looked up on every OpExtInst assembled or
+// disassembled, so the linear scans add up.
+struct ExtInstGroupIndex {
+  explicit ExtInstGroupIndex(const spv_ext_inst_group_t& group) {
+    const spv_ext_inst_desc_t* entries = group.entries;
+    by_name.resize(group.count);
+    for (uint32_t i = 0; i < group.count; ++i) by_name[i] = uint16_t(i);
+    std::sort(by_name.begin(), by_name.end(),
+              [entries](uint16_t lhs, uint16_t rhs) {
+                return strcmp(entries[lhs].name, entries[rhs].name) < 0;
+              });
+
+    uint32_t max_value = 0;
+    for (uint32_t i = 0; i < group.count; ++i)
+      max_value = std::max(max_value, entries[i].ext_inst);
+    by_value.resize(max_value + 1, kInvalidExtInstEntry);
+    for (uint32_t i = 0; i < group.count; ++i) {
+      uint16_t& slot = by_value[entries[i].ext_inst];
+      // Keep the first entry for a value, matching a linear scan.
+      if (slot == kInvalidExtInstEntry) slot = uint16_t(i);
+    }
+  }
+
+  std::vector<uint16_t> by_name;   // Entry indices sorted by name.
+  std::vector<uint16_t> by_value;  // Maps an instruction value to an entry.
+};
+
+// Returns the lookup index for |group|, building it on first use.  The
+// groups handed out by spvExtInstTableGet are static, so indexes are cached
+// for the lifetime of the process.
+const ExtInstGroupIndex& spvExtInstGroupIndexFor(
+    const spv_ext_inst_group_t& group) {
+  static std::mutex mutex;
+  static auto* cache =
+      new std::unordered_map<const spv_ext_inst_group_t*,
+                             std::unique_ptr<ExtInstGroupIndex>>;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& index = (*cache)[&group];
+  if (!index) index.reset(new ExtInstGroupIndex(group));
+  return *index;
+}
+
+}  // anonymous namespace
+
+namespace {
+
+// The table descriptors are constexpr so that they are fully formed at
+// compile time and spvExtInstTableGet degenerates to returning a pointer,
+// with no static-initialization guard on the fast path.
+constexpr spv_ext_inst_group_t kExtInstGroups_1_0[] = {
+    {SPV_EXT_INST_TYPE_GLSL_STD_450, ARRAY_SIZE(glslStd450Entries_1_0),
+     glslStd450Entries_1_0},
+    {SPV_EXT_INST_TYPE_OPENCL_STD, ARRAY_SIZE(openclEntries_1_0),
+     openclEntries_1_0},
+    {SPV_EXT_INST_TYPE_SPV_AMD_GCN_SHADER,
+     ARRAY_SIZE(spv_amd_gcn_shader_entries), spv_amd_gcn_shader_entries},
+};
+
+constexpr spv_ext_inst_table_t kExtInstTable_1_0 = {
+    ARRAY_SIZE(kExtInstGroups_1_0), kExtInstGroups_1_0};
+
+}  // anonymous namespace
+
 spv_result_t spvExtInstTableGet(spv_ext_inst_table* pExtInstTable,
                                 spv_target_env env) {
   if (!pExtInstTable) return SPV_ERROR_INVALID_POINTER;
 
-  static const spv_ext_inst_group_t groups_1_0[] = {
-      {SPV_EXT_INST_TYPE_GLSL_STD_450, ARRAY_SIZE(glslStd450Entries_1_0),
-       glslStd450Entries_1_0},
-      {SPV_EXT_INST_TYPE_OPENCL_STD, ARRAY_SIZE(openclEntries_1_0),
-       openclEntries_1_0},
-      {SPV_EXT_INST_TYPE_SPV_AMD_GCN_SHADER,
-       ARRAY_SIZE(spv_amd_gcn_shader_entries), spv_amd_gcn_shader_entries},
-  };
-
-  static const spv_ext_inst_table_t table_1_0 = {ARRAY_SIZE(groups_1_0),
-                                                 groups_1_0};
-
   switch (env) {
     // The extended instruction sets are all version 1.0 so far.
     case SPV_ENV_UNIVERSAL_1_0:
@@ -64,7 +128,7 @@ spv_result_t spvExtInstTableGet(spv_ext_inst_table* pExtInstTable,
     case SPV_ENV_OPENGL_4_2:
     case SPV_ENV_OPENGL_4_3:
     case SPV_ENV_OPENGL_4_5:
-      *pExtInstTable = &table_1_0;
+      *pExtInstTable = &kExtInstTable_1_0;
       return SPV_SUCCESS;
     default:
       assert(0 && "Unknown spv_target_env in spvExtInstTableGet()");
@@ -97,12 +161,16 @@ spv_result_t spvExtInstTableNameLookup(const spv_ext_inst_table table,
   for (uint32_t groupIndex = 0; groupIndex < table->count; groupIndex++) {
     const auto& group = table->groups[groupIndex];
     if (type != group.type) continue;
-    for (uint32_t index = 0; index < group.count; index++) {
-      const auto& entry = group.entries[index];
-      if (!strcmp(name, entry.name)) {
-        *pEntry = &entry;
-        return SPV_SUCCESS;
-      }
+    const ExtInstGroupIndex& index = spvExtInstGroupIndexFor(group);
+    const auto where = std::lower_bound(
+        index.by_name.begin(), index.by_name.end(), name,
+        [&group](uint16_t entry, const char* key) {
+          return strcmp(group.entries[entry].name, key) < 0;
+        });
+    if (where != index.by_name.end() &&
+        !strcmp(group.entries[*where].name, name)) {
+      *pEntry = &group.entries[*where];
+      return SPV_SUCCESS;
     }
   }
 
@@ -119,12 +187,11 @@ spv_result_t spvExtInstTableValueLookup(const spv_ext_inst_table table,
   for (uint32_t groupIndex = 0; groupIndex < table->count; groupIndex++) {
     const auto& group = table->groups[groupIndex];
     if (type != group.type) continue;
-    for (uint32_t index = 0; index < group.count; index++) {
-      const auto& entry = group.entries[index];
-      if (value == entry.ext_inst) {
-        *pEntry = &entry;
-        return SPV_SUCCESS;
-      }
+    const ExtInstGroupIndex& index = spvExtInstGroupIndexFor(group);
+    if (value < index.by_value.size() &&
+        index.by_value[value] != kInvalidExtInstEntry) {
+      *pEntry = &group.entries[index.by_value[value]];
+      return SPV_SUCCESS;
     }
   }
 
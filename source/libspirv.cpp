@@ -14,10 +14,113 @@
 
 #include "spirv-tools/libspirv.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <unordered_map>
+
+#include "operand.h"
+#include "spirv/1.2/spirv.h"
 #include "table.h"
+#include "val/validation_state.h"
+#include "validate.h"
 
 namespace spvtools {
 
+namespace {
+
+// Runs task(i) for each i in [0, num_tasks), distributing the tasks over the
+// available cores.  Runs the tasks inline when there is no benefit to
+// spawning threads.
+void RunBatch(size_t num_tasks, const std::function<void(size_t)>& task) {
+  const size_t num_workers = std::min(
+      size_t(std::max(1u, std::thread::hardware_concurrency())), num_tasks);
+  if (num_workers < 2) {
+    for (size_t i = 0; i < num_tasks; ++i) task(i);
+    return;
+  }
+  std::atomic<size_t> next_task(0);
+  auto worker = [&next_task, num_tasks, &task] {
+    for (size_t i = next_task++; i < num_tasks; i = next_task++) task(i);
+  };
+  std::vector<std::thread> workers;
+  workers.reserve(num_workers);
+  for (size_t i = 0; i < num_workers; ++i) workers.emplace_back(worker);
+  for (auto& w : workers) w.join();
+}
+
+// Forwards the given per-module diagnostics to the consumer in module order,
+// then destroys them.  Null entries are skipped.
+void ForwardDiagnostics(std::vector<spv_diagnostic>* diagnostics,
+                        const MessageConsumer& consumer) {
+  for (spv_diagnostic diagnostic : *diagnostics) {
+    if (diagnostic && consumer) {
+      consumer(SPV_MSG_ERROR, "input", diagnostic->position,
+               diagnostic->error);
+    }
+    spvDiagnosticDestroy(diagnostic);
+  }
+  diagnostics->clear();
+}
+
+// Per-module state for ComputeFunctionHashes.  Hashing uses 64-bit FNV-1a
+// over the instruction words, with id operands replaced by their first-use
+// index inside the current function.
+struct FunctionHasher {
+  std::vector<FunctionHash>* out;
+  bool in_function = false;
+  uint32_t function_id = 0;
+  uint64_t hash = 0;
+  std::unordered_map<uint32_t, uint32_t> local_ids;
+
+  void Mix(uint32_t word) { hash = (hash ^ word) * 0x100000001b3ull; }
+
+  // Returns the dense number for |id|, assigning the next one on first use.
+  uint32_t Normalize(uint32_t id) {
+    const auto insertion =
+        local_ids.insert({id, static_cast<uint32_t>(local_ids.size() + 1)});
+    return insertion.first->second;
+  }
+
+  void HashInstruction(const spv_parsed_instruction_t* inst) {
+    Mix(inst->opcode);
+    for (uint16_t i = 0; i < inst->num_operands; ++i) {
+      const spv_parsed_operand_t& operand = inst->operands[i];
+      if (spvIsIdType(operand.type)) {
+        Mix(Normalize(inst->words[operand.offset]));
+      } else {
+        for (uint16_t w = 0; w < operand.num_words; ++w) {
+          Mix(inst->words[operand.offset + w]);
+        }
+      }
+    }
+  }
+};
+
+spv_result_t HashParsedInstruction(void* user_data,
+                                   const spv_parsed_instruction_t* inst) {
+  auto* hasher = static_cast<FunctionHasher*>(user_data);
+  const SpvOp opcode = static_cast<SpvOp>(inst->opcode);
+  if (opcode == SpvOpFunction) {
+    hasher->in_function = true;
+    hasher->function_id = inst->result_id;
+    hasher->hash = 0xcbf29ce484222325ull;
+    hasher->local_ids.clear();
+  }
+  if (!hasher->in_function) return SPV_SUCCESS;
+  // Line debug info does not affect the hash.
+  if (opcode == SpvOpLine || opcode == SpvOpNoLine) return SPV_SUCCESS;
+  hasher->HashInstruction(inst);
+  if (opcode == SpvOpFunctionEnd) {
+    hasher->out->push_back({hasher->function_id, hasher->hash});
+    hasher->in_function = false;
+  }
+  return SPV_SUCCESS;
+}
+
+}  // anonymous namespace
+
 // Structs for holding the data members for SpvTools.
 struct SpirvTools::Impl {
   explicit Impl(spv_target_env env) : context(spvContextCreate(env)) {
@@ -25,9 +128,18 @@ struct SpirvTools::Impl {
     // equivalent functionality (from the user's perspective) as a real consumer
     // does nothing.
   }
-  ~Impl() { spvContextDestroy(context); }
+  ~Impl() {
+    if (pooled_options) spvValidatorOptionsDestroy(pooled_options);
+    spvContextDestroy(context);
+  }
 
   spv_context context;  // C interface context object.
+
+  // Scratch state reused by ValidatePooled.  Created on first use; Reset
+  // clears its containers between modules without releasing their capacity.
+  std::unique_ptr<libspirv::ValidationState_t> pooled_vstate;
+  // Default options for the ValidatePooled overload without options.
+  spv_validator_options pooled_options = nullptr;
 };
 
 SpirvTools::SpirvTools(spv_target_env env) : impl_(new Impl(env)) {}
@@ -57,6 +169,52 @@ bool SpirvTools::Assemble(const char* text, const size_t text_size,
   return status == SPV_SUCCESS;
 }
 
+bool SpirvTools::Assemble(const std::string& text, OwnedBinary* binary,
+                          uint32_t options) const {
+  return Assemble(text.data(), text.size(), binary, options);
+}
+
+bool SpirvTools::Assemble(const char* text, const size_t text_size,
+                          OwnedBinary* binary, uint32_t options) const {
+  spv_binary spvbinary = nullptr;
+  spv_result_t status = spvTextToBinaryWithOptions(
+      impl_->context, text, text_size, options, &spvbinary, nullptr);
+  if (status == SPV_SUCCESS) {
+    binary->Adopt(spvbinary);
+  } else {
+    spvBinaryDestroy(spvbinary);
+  }
+  return status == SPV_SUCCESS;
+}
+
+bool SpirvTools::AssembleBatch(const std::vector<std::string>& texts,
+                               std::vector<std::vector<uint32_t>>* binaries,
+                               uint32_t options) const {
+  binaries->clear();
+  binaries->resize(texts.size());
+  std::vector<spv_diagnostic> diagnostics(texts.size(), nullptr);
+  std::atomic<bool> success(true);
+  const spv_context context = impl_->context;
+  RunBatch(texts.size(), [&texts, binaries, &diagnostics, &success, context,
+                          options](size_t i) {
+    // Passing a diagnostic out-parameter makes the C API redirect messages
+    // into it through a local copy of the context, so workers share the
+    // immutable grammar tables but never invoke the consumer concurrently.
+    spv_binary spvbinary = nullptr;
+    if (SPV_SUCCESS == spvTextToBinaryWithOptions(
+                           context, texts[i].data(), texts[i].size(), options,
+                           &spvbinary, &diagnostics[i])) {
+      (*binaries)[i].assign(spvbinary->code,
+                            spvbinary->code + spvbinary->wordCount);
+    } else {
+      success = false;
+    }
+    spvBinaryDestroy(spvbinary);
+  });
+  ForwardDiagnostics(&diagnostics, context->consumer);
+  return success;
+}
+
 bool SpirvTools::Disassemble(const std::vector<uint32_t>& binary,
                              std::string* text, uint32_t options) const {
   return Disassemble(binary.data(), binary.size(), text, options);
@@ -74,6 +232,24 @@ bool SpirvTools::Disassemble(const uint32_t* binary, const size_t binary_size,
   return status == SPV_SUCCESS;
 }
 
+bool SpirvTools::Disassemble(const std::vector<uint32_t>& binary,
+                             OwnedText* text, uint32_t options) const {
+  return Disassemble(binary.data(), binary.size(), text, options);
+}
+
+bool SpirvTools::Disassemble(const uint32_t* binary, const size_t binary_size,
+                             OwnedText* text, uint32_t options) const {
+  spv_text spvtext = nullptr;
+  spv_result_t status = spvBinaryToText(impl_->context, binary, binary_size,
+                                        options, &spvtext, nullptr);
+  if (status == SPV_SUCCESS) {
+    text->Adopt(spvtext);
+  } else {
+    spvTextDestroy(spvtext);
+  }
+  return status == SPV_SUCCESS;
+}
+
 bool SpirvTools::Validate(const std::vector<uint32_t>& binary) const {
   return Validate(binary.data(), binary.size());
 }
@@ -91,4 +267,82 @@ bool SpirvTools::Validate(const uint32_t* binary, const size_t binary_size,
                                 nullptr) == SPV_SUCCESS;
 }
 
+bool SpirvTools::ValidatePooled(const uint32_t* binary,
+                                const size_t binary_size) {
+  if (!impl_->pooled_options)
+    impl_->pooled_options = spvValidatorOptionsCreate();
+  if (!impl_->pooled_vstate) {
+    impl_->pooled_vstate.reset(new libspirv::ValidationState_t(
+        impl_->context, impl_->pooled_options));
+  } else {
+    impl_->pooled_vstate->Reset(impl_->context, impl_->pooled_options);
+  }
+  return ValidateBinaryUsingContextAndValidationState(
+             *impl_->context, binary, binary_size, nullptr,
+             impl_->pooled_vstate.get()) == SPV_SUCCESS;
+}
+
+bool SpirvTools::ValidatePooled(const uint32_t* binary,
+                                const size_t binary_size,
+                                const spvtools::ValidatorOptions& options) {
+  if (!impl_->pooled_vstate) {
+    impl_->pooled_vstate.reset(
+        new libspirv::ValidationState_t(impl_->context, options));
+  } else {
+    impl_->pooled_vstate->Reset(impl_->context, options);
+  }
+  return ValidateBinaryUsingContextAndValidationState(
+             *impl_->context, binary, binary_size, nullptr,
+             impl_->pooled_vstate.get()) == SPV_SUCCESS;
+}
+
+bool SpirvTools::ValidateBatch(
+    const std::vector<std::vector<uint32_t>>& binaries,
+    std::vector<bool>* results) const {
+  std::vector<spv_diagnostic> diagnostics(binaries.size(), nullptr);
+  // Collected per worker and copied into |results| after the join:
+  // std::vector<bool> packs its elements, so its entries cannot be written
+  // concurrently.
+  std::vector<spv_result_t> statuses(binaries.size(), SPV_SUCCESS);
+  const spv_context context = impl_->context;
+  RunBatch(binaries.size(),
+           [&binaries, &diagnostics, &statuses, context](size_t i) {
+             statuses[i] =
+                 spvValidateBinary(context, binaries[i].data(),
+                                   binaries[i].size(), &diagnostics[i]);
+           });
+  ForwardDiagnostics(&diagnostics, context->consumer);
+  bool success = true;
+  if (results) results->assign(binaries.size(), false);
+  for (size_t i = 0; i < binaries.size(); ++i) {
+    if (statuses[i] == SPV_SUCCESS) {
+      if (results) (*results)[i] = true;
+    } else {
+      success = false;
+    }
+  }
+  return success;
+}
+
+bool SpirvTools::ComputeFunctionHashes(
+    const std::vector<uint32_t>& binary,
+    std::vector<FunctionHash>* hashes) const {
+  return ComputeFunctionHashes(binary.data(), binary.size(), hashes);
+}
+
+bool SpirvTools::ComputeFunctionHashes(
+    const uint32_t* binary, const size_t binary_size,
+    std::vector<FunctionHash>* hashes) const {
+  FunctionHasher hasher;
+  std::vector<FunctionHash> result;
+  hasher.out = &result;
+  if (SPV_SUCCESS != spvBinaryParse(impl_->context, &hasher, binary,
+                                    binary_size, nullptr,
+                                    HashParsedInstruction, nullptr)) {
+    return false;
+  }
+  *hashes = std::move(result);
+  return true;
+}
+
 }  // namespace spvtools
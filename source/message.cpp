@@ -14,9 +14,20 @@
 
 #include "message.h"
 
+#include <cstring>
 #include <sstream>
 
 namespace spvtools {
+namespace {
+
+// Copies |text| into the |size|-byte buffer at |dst|, truncating if needed
+// and always terminating with a nul.
+void CopyTruncated(const char* text, char* dst, size_t size) {
+  std::strncpy(dst, text, size - 1);
+  dst[size - 1] = '\0';
+}
+
+}  // anonymous namespace
 
 std::string StringifyMessage(spv_message_level_t level, const char* source,
                              const spv_position_t& position,
@@ -51,4 +62,92 @@ std::string StringifyMessage(spv_message_level_t level, const char* source,
   return oss.str();
 }
 
+AsyncMessageConsumer::AsyncMessageConsumer(MessageConsumer sink,
+                                           size_t capacity)
+    : sink_(std::move(sink)), head_(0), tail_(0), dropped_(0), stop_(false) {
+  uint64_t rounded = 1;
+  while (rounded < capacity) rounded <<= 1;
+  mask_ = rounded - 1;
+  ring_.reset(new Record[rounded]);
+  for (uint64_t i = 0; i < rounded; ++i)
+    ring_[i].sequence.store(i, std::memory_order_relaxed);
+  drainer_ = std::thread(&AsyncMessageConsumer::Drain, this);
+}
+
+AsyncMessageConsumer::~AsyncMessageConsumer() {
+  stop_.store(true, std::memory_order_release);
+  drainer_.join();
+  const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+  if (dropped > 0 && sink_) {
+    std::ostringstream oss;
+    oss << "dropped " << dropped << " message(s): the message ring was full";
+    spv_position_t position = {};
+    sink_(SPV_MSG_WARNING, nullptr, position, oss.str().c_str());
+  }
+}
+
+MessageConsumer AsyncMessageConsumer::GetConsumer() {
+  return [this](spv_message_level_t level, const char* source,
+                const spv_position_t& position, const char* message) {
+    if (!Enqueue(level, source, position, message))
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+  };
+}
+
+bool AsyncMessageConsumer::Enqueue(spv_message_level_t level,
+                                   const char* source,
+                                   const spv_position_t& position,
+                                   const char* message) {
+  // Claim a slot.  A slot is free for position |pos| exactly when its
+  // sequence equals |pos|; winning the CAS on head_ makes this producer the
+  // only writer of that slot until it republishes the sequence.
+  uint64_t pos = head_.load(std::memory_order_relaxed);
+  Record* slot;
+  for (;;) {
+    slot = &ring_[pos & mask_];
+    const uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+    const int64_t dif = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+    if (dif == 0) {
+      if (head_.compare_exchange_weak(pos, pos + 1,
+                                      std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (dif < 0) {
+      // The drainer has not freed this slot yet: the ring is full.
+      return false;
+    } else {
+      pos = head_.load(std::memory_order_relaxed);
+    }
+  }
+  slot->level = level;
+  slot->position = position;
+  slot->has_source = source != nullptr;
+  CopyTruncated(source ? source : "", slot->source, sizeof(slot->source));
+  CopyTruncated(message ? message : "", slot->message, sizeof(slot->message));
+  slot->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+void AsyncMessageConsumer::Drain() {
+  for (;;) {
+    Record* slot = &ring_[tail_ & mask_];
+    const uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+    if (seq == tail_ + 1) {
+      if (sink_) {
+        sink_(slot->level, slot->has_source ? slot->source : nullptr,
+              slot->position, slot->message);
+      }
+      // Mark the slot free for the producer that will lap the ring.
+      slot->sequence.store(tail_ + mask_ + 1, std::memory_order_release);
+      ++tail_;
+    } else if (stop_.load(std::memory_order_acquire)) {
+      // Every Enqueue call publishes its record before returning, so once
+      // the owner has reached the destructor an empty ring stays empty.
+      break;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
+
 }  // namespace spvtools
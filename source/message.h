@@ -15,9 +15,14 @@
 #ifndef SPIRV_TOOLS_MESSAGE_H_
 #define SPIRV_TOOLS_MESSAGE_H_
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <thread>
 
 #include "spirv-tools/libspirv.h"
+#include "spirv-tools/libspirv.hpp"
 
 namespace spvtools {
 
@@ -28,6 +33,69 @@ std::string StringifyMessage(spv_message_level_t level, const char* source,
                              const spv_position_t& position,
                              const char* message);
 
+// Forwards messages to a wrapped consumer from a dedicated drainer thread.
+//
+// The consumer returned by GetConsumer() copies each message into a
+// fixed-size record and publishes it to a bounded lock-free multi-producer
+// single-consumer ring buffer; the drainer thread dequeues the records and
+// invokes the wrapped consumer with them.  Producers never take a lock and
+// never block, so hot paths that report diagnostics from many threads do
+// not serialize on the consumer.  The price is truncation: source and
+// message strings longer than the record fields are cut short, and when
+// the ring is full new messages are dropped and only counted.
+//
+// The destructor drains the outstanding records, joins the drainer thread,
+// and reports the number of dropped messages (if any) to the wrapped
+// consumer at SPV_MSG_WARNING level.  The caller must guarantee that no
+// thread is still invoking the returned consumer when destruction starts.
+class AsyncMessageConsumer {
+ public:
+  // Wraps |sink|.  The ring holds |capacity| records, rounded up to a
+  // power of two.  |sink| is only ever called from the drainer thread, so
+  // it needs no synchronization of its own.
+  explicit AsyncMessageConsumer(MessageConsumer sink, size_t capacity = 256);
+  ~AsyncMessageConsumer();
+
+  AsyncMessageConsumer(const AsyncMessageConsumer&) = delete;
+  AsyncMessageConsumer& operator=(const AsyncMessageConsumer&) = delete;
+
+  // Returns a consumer that enqueues into the ring.  The returned consumer
+  // may be copied freely and called from any thread, but must not outlive
+  // this object.
+  MessageConsumer GetConsumer();
+
+ private:
+  // One fixed-size message in the ring.  |sequence| implements the bounded
+  // MPSC handshake: it holds the slot index while the slot is free and the
+  // claiming position plus one once the payload has been published.
+  struct Record {
+    std::atomic<uint64_t> sequence;
+    spv_message_level_t level;
+    spv_position_t position;
+    bool has_source;
+    char source[64];
+    char message[256];
+  };
+
+  // Copies one message into the ring.  Returns false when the ring is
+  // full, in which case the message is not recorded.
+  bool Enqueue(spv_message_level_t level, const char* source,
+               const spv_position_t& position, const char* message);
+
+  // Body of the drainer thread: forwards records to |sink_| until stop_ is
+  // set and the ring is empty.
+  void Drain();
+
+  MessageConsumer sink_;
+  uint64_t mask_;
+  std::unique_ptr<Record[]> ring_;
+  std::atomic<uint64_t> head_;
+  uint64_t tail_;  // Only touched by the drainer thread.
+  std::atomic<uint64_t> dropped_;
+  std::atomic<bool> stop_;
+  std::thread drainer_;
+};
+
 }  // namespace spvtools
 
 #endif  // SPIRV_TOOLS_MESSAGE_H_
@@ -47,15 +47,23 @@ NameMapper GetTrivialNameMapper() { return to_string; }
 FriendlyNameMapper::FriendlyNameMapper(const spv_const_context context,
                                        const uint32_t* code,
                                        const size_t wordCount)
-    : grammar_(libspirv::AssemblyGrammar(context)) {
+    : grammar_(libspirv::AssemblyGrammar(context)),
+      context_(context),
+      code_(code),
+      word_count_(wordCount) {}
+
+void FriendlyNameMapper::ParseModule() {
+  if (parsed_) return;
+  parsed_ = true;
   spv_diagnostic diag = nullptr;
   // We don't care if the parse fails.
-  spvBinaryParse(context, this, code, wordCount, nullptr,
+  spvBinaryParse(context_, this, code_, word_count_, nullptr,
                  ParseInstructionForwarder, &diag);
   spvDiagnosticDestroy(diag);
 }
 
 std::string FriendlyNameMapper::NameForId(uint32_t id) {
+  ParseModule();
   auto iter = name_for_id_.find(id);
   if (iter == name_for_id_.end()) {
     // It must have been an invalid module, so just return a trivial mapping.
@@ -69,15 +77,12 @@ std::string FriendlyNameMapper::NameForId(uint32_t id) {
 std::string FriendlyNameMapper::Sanitize(const std::string& suggested_name) {
   if (suggested_name.empty()) return "_";
   // Otherwise, replace invalid characters by '_'.
-  std::string result;
-  std::string valid =
-      "abcdefghijklmnopqrstuvwxyz"
-      "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-      "_0123456789";
-  std::transform(suggested_name.begin(), suggested_name.end(),
-                 std::back_inserter(result), [&valid](const char c) {
-                   return (std::string::npos == valid.find(c)) ? '_' : c;
-                 });
+  std::string result = suggested_name;
+  for (auto& c : result) {
+    const bool valid = ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') ||
+                       ('0' <= c && c <= '9') || ('_' == c);
+    if (!valid) c = '_';
+  }
   return result;
 }
 
@@ -85,17 +90,23 @@ void FriendlyNameMapper::SaveName(uint32_t id,
                                   const std::string& suggested_name) {
   if (name_for_id_.find(id) != name_for_id_.end()) return;
 
-  const std::string sanitized_suggested_name = Sanitize(suggested_name);
-  std::string name = sanitized_suggested_name;
-  auto inserted = used_names_.insert(name);
-  if (!inserted.second) {
-    const std::string base_name = sanitized_suggested_name + "_";
-    for (uint32_t index = 0; !inserted.second; ++index) {
-      name = base_name + to_string(index);
-      inserted = used_names_.insert(name);
-    }
+  std::string name = Sanitize(suggested_name);
+  if (!used_names_.insert(name).second) {
+    // The sanitized name is taken.  Probe suffixed names starting from the
+    // per-base counter, so a run of ids sharing one suggested name costs a
+    // single probe each instead of rescanning every earlier suffix, and
+    // reuse one buffer for the candidates rather than building each from
+    // fresh temporaries.
+    name.push_back('_');
+    const size_t base_length = name.size();
+    uint32_t& next_suffix = next_suffix_for_base_[name];
+    do {
+      name.resize(base_length);
+      name += to_string(next_suffix);
+      ++next_suffix;
+    } while (!used_names_.insert(name).second);
   }
-  name_for_id_[id] = name;
+  name_for_id_[id] = std::move(name);
 }
 
 void FriendlyNameMapper::SaveBuiltInName(uint32_t target_id,
@@ -33,9 +33,9 @@ using NameMapper = std::function<std::string(uint32_t)>;
 // Returns a NameMapper which always maps an Id to its decimal representation.
 NameMapper GetTrivialNameMapper();
 
-// A FriendlyNameMapper parses a module upon construction.  If the parse is
-// successful, then the NameForId method maps an Id to a friendly name
-// while also satisfying the constraints on a NameMapper.
+// A FriendlyNameMapper parses a module on the first name lookup.  If the
+// parse is successful, then the NameForId method maps an Id to a friendly
+// name while also satisfying the constraints on a NameMapper.
 //
 // The mapping is friendly in the following sense:
 //  - If an Id has a debug name (via OpName), then that will be used when
@@ -60,12 +60,21 @@ NameMapper GetTrivialNameMapper();
 //  - Numeric literals in OpConstant map to a human-friendly name.
 class FriendlyNameMapper {
  public:
-  // Construct a friendly name mapper, and determine friendly names for each
-  // defined Id in the specified module.  The module is specified by the code
-  // wordCount, and should be parseable in the specified context.
+  // Construct a friendly name mapper for the module specified by code and
+  // wordCount, which should be parseable in the specified context.  The
+  // module is not parsed yet: friendly names for every defined Id are
+  // determined on the first name lookup, so a mapper that is never queried
+  // costs nothing beyond construction.  The context and code must remain
+  // valid until the first lookup (or ParseModule call) returns.
   FriendlyNameMapper(const spv_const_context context, const uint32_t* code,
                      const size_t wordCount);
 
+  // Parses the module and determines the friendly names now, if that has
+  // not happened yet.  This is done implicitly by the first name lookup;
+  // call it explicitly before sharing the mapper across threads, since
+  // lookups afterwards are read-only.
+  void ParseModule();
+
   // Returns a NameMapper which maps ids to the friendly names parsed from the
   // module provided to the constructor.
   NameMapper GetNameMapper() {
@@ -107,13 +116,23 @@ class FriendlyNameMapper {
   // Returns the friendly name for an enumerant.
   std::string NameForEnumOperand(spv_operand_type_t type, uint32_t word);
 
-  // Maps an id to its friendly name.  This will have an entry for each Id
-  // defined in the module.
+  // Maps an id to its friendly name.  Once the module has been parsed, this
+  // will have an entry for each Id defined in the module.
   std::unordered_map<uint32_t, std::string> name_for_id_;
   // The set of names that have a mapping in name_for_id_;
   std::unordered_set<std::string> used_names_;
+  // For each suffixed base name (sanitized name plus '_'), the next suffix
+  // index to try when resolving a collision.  Keeping the counter per base
+  // makes uniquing a run of identically named ids amortized constant time.
+  std::unordered_map<std::string, uint32_t> next_suffix_for_base_;
   // The assembly grammar for the current context.
   const libspirv::AssemblyGrammar grammar_;
+  // The context and module to parse on the first name lookup, and whether
+  // that parse has happened yet.
+  const spv_const_context context_;
+  const uint32_t* const code_;
+  const size_t word_count_;
+  bool parsed_ = false;
 };
 
 }  // namespace libspirv
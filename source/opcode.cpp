@@ -19,6 +19,10 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include "instruction.h"
 #include "macro.h"
@@ -29,15 +33,13 @@
 namespace {
 
 // Descriptions of each opcode.  Each entry describes the format of the
-// instruction that follows a particular opcode.
-const spv_opcode_desc_t opcodeTableEntries_1_0[] = {
-#include "core.insts-1.0.inc"
-};
-const spv_opcode_desc_t opcodeTableEntries_1_1[] = {
-#include "core.insts-1.1.inc"
-};
-const spv_opcode_desc_t opcodeTableEntries_1_2[] = {
-#include "core.insts-1.2.inc"
+// instruction that follows a particular opcode.  All SPIR-V versions share
+// this one immutable array: each entry carries a bitmask of the versions
+// that define it, and the per-version tables below select from it by
+// version bit, so only a single copy stays hot in cache no matter which
+// target environments are in use.
+const spv_opcode_desc_t opcodeTableEntries[] = {
+#include "core.insts-unified.inc"
 };
 
 // Represents a vendor tool entry in the SPIR-V XML Regsitry.
@@ -52,6 +54,194 @@ const VendorTool vendor_tools[] = {
 #include "generators.inc"
 };
 
+// The per-version table descriptors are constexpr so that they are fully
+// formed at compile time and spvOpcodeTableGet degenerates to returning a
+// pointer, with no static-initialization guard on the fast path.  They all
+// view the shared entry array, differing only in the version bit their
+// lookups filter on.
+constexpr spv_opcode_table_t kOpcodeTable_1_0 = {
+    ARRAY_SIZE(opcodeTableEntries), opcodeTableEntries,
+    SPV_OPCODE_VERSION_BIT_1_0};
+constexpr spv_opcode_table_t kOpcodeTable_1_1 = {
+    ARRAY_SIZE(opcodeTableEntries), opcodeTableEntries,
+    SPV_OPCODE_VERSION_BIT_1_1};
+constexpr spv_opcode_table_t kOpcodeTable_1_2 = {
+    ARRAY_SIZE(opcodeTableEntries), opcodeTableEntries,
+    SPV_OPCODE_VERSION_BIT_1_2};
+
+// Sentinel marking an unused slot in a value-indexed lookup vector.
+const uint16_t kInvalidOpcodeEntry = 0xffff;
+
+// A lookup index over one opcode table: entry indices sorted by opcode name
+// for binary-search name lookup, and a dense opcode-value-to-entry-index
+// vector for O(1) value lookup.  Entries of the shared array that do not
+// belong to the table's version are excluded here, so the lookups need no
+// version filtering of their own.
+struct OpcodeTableIndex {
+  explicit OpcodeTableIndex(const spv_opcode_table_t& table) {
+    const spv_opcode_desc_t* entries = table.entries;
+    for (uint32_t i = 0; i < table.count; ++i) {
+      if (entries[i].versions & table.version) by_name.push_back(uint16_t(i));
+    }
+    std::sort(by_name.begin(), by_name.end(),
+              [entries](uint16_t lhs, uint16_t rhs) {
+                return strcmp(entries[lhs].name, entries[rhs].name) < 0;
+              });
+
+    uint32_t max_opcode = 0;
+    for (uint32_t i = 0; i < table.count; ++i)
+      max_opcode = std::max(max_opcode, uint32_t(entries[i].opcode));
+    by_value.resize(max_opcode + 1, kInvalidOpcodeEntry);
+    for (uint32_t i = 0; i < table.count; ++i) {
+      if (!(entries[i].versions & table.version)) continue;
+      uint16_t& slot = by_value[entries[i].opcode];
+      // Keep the first entry for a value, matching a linear scan.
+      if (slot == kInvalidOpcodeEntry) slot = uint16_t(i);
+    }
+  }
+
+  std::vector<uint16_t> by_name;   // Entry indices sorted by opcode name.
+  std::vector<uint16_t> by_value;  // Maps an opcode value to an entry index.
+};
+
+// Bit flags for per-opcode attributes stored in the table built by
+// OpcodeAttributeTable() below.  One bit per predicate exported from this
+// file.
+enum : uint32_t {
+  kOpcodeAttrScalarType = 1u << 0,
+  kOpcodeAttrConstant = 1u << 1,
+  kOpcodeAttrScalarSpecConstant = 1u << 2,
+  kOpcodeAttrComposite = 1u << 3,
+  kOpcodeAttrLogicalVariablePointer = 1u << 4,
+  kOpcodeAttrLogicalPointer = 1u << 5,
+  kOpcodeAttrGeneratesType = 1u << 6,
+};
+
+// Returns the attribute bits for |opcode|.  This switch runs once per opcode
+// when the attribute table is built; the exported predicates read the table
+// so the hot paths are a load and mask instead of a branchy switch.
+uint32_t OpcodeAttributesOf(const SpvOp opcode) {
+  switch (opcode) {
+    case SpvOpTypeBool:
+    case SpvOpTypeInt:
+    case SpvOpTypeFloat:
+      return kOpcodeAttrScalarType | kOpcodeAttrGeneratesType;
+    case SpvOpTypeVector:
+    case SpvOpTypeMatrix:
+    case SpvOpTypeArray:
+    case SpvOpTypeStruct:
+      return kOpcodeAttrComposite | kOpcodeAttrGeneratesType;
+    case SpvOpTypeVoid:
+    case SpvOpTypeImage:
+    case SpvOpTypeSampler:
+    case SpvOpTypeSampledImage:
+    case SpvOpTypeRuntimeArray:
+    case SpvOpTypeOpaque:
+    case SpvOpTypePointer:
+    case SpvOpTypeFunction:
+    case SpvOpTypeEvent:
+    case SpvOpTypeDeviceEvent:
+    case SpvOpTypeReserveId:
+    case SpvOpTypeQueue:
+    case SpvOpTypePipe:
+    case SpvOpTypePipeStorage:
+    case SpvOpTypeNamedBarrier:
+      // In particular, OpTypeForwardPointer does not generate a type,
+      // but declares a storage class for a pointer type generated
+      // by a different instruction.
+      return kOpcodeAttrGeneratesType;
+    case SpvOpConstantTrue:
+    case SpvOpConstantFalse:
+    case SpvOpConstant:
+    case SpvOpConstantComposite:
+    case SpvOpConstantSampler:
+    case SpvOpSpecConstantComposite:
+    case SpvOpSpecConstantOp:
+      return kOpcodeAttrConstant;
+    case SpvOpConstantNull:
+      return kOpcodeAttrConstant | kOpcodeAttrLogicalVariablePointer;
+    case SpvOpSpecConstantTrue:
+    case SpvOpSpecConstantFalse:
+    case SpvOpSpecConstant:
+      return kOpcodeAttrConstant | kOpcodeAttrScalarSpecConstant;
+    case SpvOpVariable:
+    case SpvOpAccessChain:
+    case SpvOpInBoundsAccessChain:
+    case SpvOpFunctionParameter:
+    case SpvOpImageTexelPointer:
+    case SpvOpCopyObject:
+      return kOpcodeAttrLogicalPointer | kOpcodeAttrLogicalVariablePointer;
+    case SpvOpSelect:
+    case SpvOpPhi:
+    case SpvOpFunctionCall:
+    case SpvOpPtrAccessChain:
+    case SpvOpLoad:
+      return kOpcodeAttrLogicalVariablePointer;
+    default:
+      return 0;
+  }
+}
+
+// Returns the dense opcode-value-indexed attribute bitfield table, built on
+// first use from the unified opcode table, which covers every version.
+const std::vector<uint32_t>& OpcodeAttributeTable() {
+  static const std::vector<uint32_t>* const table = [] {
+    uint32_t max_opcode = 0;
+    for (const auto& entry : opcodeTableEntries)
+      max_opcode = std::max(max_opcode, uint32_t(entry.opcode));
+    auto* attrs = new std::vector<uint32_t>(max_opcode + 1, 0u);
+    for (const auto& entry : opcodeTableEntries)
+      (*attrs)[entry.opcode] = OpcodeAttributesOf(entry.opcode);
+    return attrs;
+  }();
+  return *table;
+}
+
+// Returns the attribute bits recorded for |opcode|, 0 for unknown opcodes.
+uint32_t OpcodeAttributes(const SpvOp opcode) {
+  const std::vector<uint32_t>& table = OpcodeAttributeTable();
+  const uint32_t value = opcode;
+  return value < table.size() ? table[value] : 0u;
+}
+
+// Returns the dense opcode-value-indexed name table, built on first use
+// from the unified opcode table, which covers every version.  Each slot
+// holds the opcode's name with the "Op" prefix already attached; slots for
+// values that are not opcodes hold nullptr.  The backing strings are never
+// freed, like the table itself.
+const std::vector<const char*>& OpcodeNameTable() {
+  static const std::vector<const char*>* const table = [] {
+    uint32_t max_opcode = 0;
+    for (const auto& entry : opcodeTableEntries)
+      max_opcode = std::max(max_opcode, uint32_t(entry.opcode));
+    auto* names = new std::vector<const char*>(max_opcode + 1, nullptr);
+    for (const auto& entry : opcodeTableEntries) {
+      // Keep the first entry for a value, matching a linear scan.
+      if ((*names)[entry.opcode]) continue;
+      const size_t name_length = strlen(entry.name);
+      char* prefixed = new char[2 + name_length + 1];
+      memcpy(prefixed, "Op", 2);
+      memcpy(prefixed + 2, entry.name, name_length + 1);
+      (*names)[entry.opcode] = prefixed;
+    }
+    return names;
+  }();
+  return *table;
+}
+
+// Returns the lookup index for |table|, building it on first use.  The
+// tables returned by spvOpcodeTableGet are static, so indexes are cached for
+// the lifetime of the process.
+const OpcodeTableIndex& spvOpcodeTableIndexFor(const spv_opcode_table table) {
+  static std::mutex mutex;
+  static auto* cache = new std::unordered_map<const spv_opcode_table_t*,
+                                              std::unique_ptr<OpcodeTableIndex>>;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& index = (*cache)[table];
+  if (!index) index.reset(new OpcodeTableIndex(*table));
+  return *index;
+}
+
 }  // anonymous namespace
 
 // TODO(dneto): Move this to another file.  It doesn't belong with opcode
@@ -82,13 +272,6 @@ spv_result_t spvOpcodeTableGet(spv_opcode_table* pInstTable,
                                spv_target_env env) {
   if (!pInstTable) return SPV_ERROR_INVALID_POINTER;
 
-  static const spv_opcode_table_t table_1_0 = {
-      ARRAY_SIZE(opcodeTableEntries_1_0), opcodeTableEntries_1_0};
-  static const spv_opcode_table_t table_1_1 = {
-      ARRAY_SIZE(opcodeTableEntries_1_1), opcodeTableEntries_1_1};
-  static const spv_opcode_table_t table_1_2 = {
-      ARRAY_SIZE(opcodeTableEntries_1_2), opcodeTableEntries_1_2};
-
   switch (env) {
     case SPV_ENV_UNIVERSAL_1_0:
     case SPV_ENV_VULKAN_1_0:
@@ -98,14 +281,14 @@ spv_result_t spvOpcodeTableGet(spv_opcode_table* pInstTable,
     case SPV_ENV_OPENGL_4_2:
     case SPV_ENV_OPENGL_4_3:
     case SPV_ENV_OPENGL_4_5:
-      *pInstTable = &table_1_0;
+      *pInstTable = &kOpcodeTable_1_0;
       return SPV_SUCCESS;
     case SPV_ENV_UNIVERSAL_1_1:
-      *pInstTable = &table_1_1;
+      *pInstTable = &kOpcodeTable_1_1;
       return SPV_SUCCESS;
     case SPV_ENV_UNIVERSAL_1_2:
     case SPV_ENV_OPENCL_2_2:
-      *pInstTable = &table_1_2;
+      *pInstTable = &kOpcodeTable_1_2;
       return SPV_SUCCESS;
   }
   assert(0 && "Unknown spv_target_env in spvOpcodeTableGet()");
@@ -118,18 +301,16 @@ spv_result_t spvOpcodeTableNameLookup(const spv_opcode_table table,
   if (!name || !pEntry) return SPV_ERROR_INVALID_POINTER;
   if (!table) return SPV_ERROR_INVALID_TABLE;
 
-  // TODO: This lookup of the Opcode table is suboptimal! Binary sort would be
-  // preferable but the table requires sorting on the Opcode name, but it's
-  // static
-  // const initialized and matches the order of the spec.
-  const size_t nameLength = strlen(name);
-  for (uint64_t opcodeIndex = 0; opcodeIndex < table->count; ++opcodeIndex) {
-    if (nameLength == strlen(table->entries[opcodeIndex].name) &&
-        !strncmp(name, table->entries[opcodeIndex].name, nameLength)) {
-      // NOTE: Found out Opcode!
-      *pEntry = &table->entries[opcodeIndex];
-      return SPV_SUCCESS;
-    }
+  const OpcodeTableIndex& index = spvOpcodeTableIndexFor(table);
+  const auto where = std::lower_bound(
+      index.by_name.begin(), index.by_name.end(), name,
+      [table](uint16_t entry, const char* key) {
+        return strcmp(table->entries[entry].name, key) < 0;
+      });
+  if (where != index.by_name.end() &&
+      !strcmp(table->entries[*where].name, name)) {
+    *pEntry = &table->entries[*where];
+    return SPV_SUCCESS;
   }
 
   return SPV_ERROR_INVALID_LOOKUP;
@@ -141,13 +322,12 @@ spv_result_t spvOpcodeTableValueLookup(const spv_opcode_table table,
   if (!table) return SPV_ERROR_INVALID_TABLE;
   if (!pEntry) return SPV_ERROR_INVALID_POINTER;
 
-  // TODO: As above this lookup is not optimal.
-  for (uint64_t opcodeIndex = 0; opcodeIndex < table->count; ++opcodeIndex) {
-    if (opcode == table->entries[opcodeIndex].opcode) {
-      // NOTE: Found the Opcode!
-      *pEntry = &table->entries[opcodeIndex];
-      return SPV_SUCCESS;
-    }
+  const OpcodeTableIndex& index = spvOpcodeTableIndexFor(table);
+  const uint32_t value = opcode;
+  if (value < index.by_value.size() &&
+      index.by_value[value] != kInvalidOpcodeEntry) {
+    *pEntry = &table->entries[index.by_value[value]];
+    return SPV_SUCCESS;
   }
 
   return SPV_ERROR_INVALID_LOOKUP;
@@ -171,44 +351,30 @@ void spvInstructionCopy(const uint32_t* words, const SpvOp opcode,
 }
 
 const char* spvOpcodeString(const SpvOp opcode) {
-  // Use the latest SPIR-V version, which should be backward-compatible with all
-  // previous ones.
-  for (uint32_t i = 0; i < ARRAY_SIZE(opcodeTableEntries_1_2); ++i) {
-    if (opcodeTableEntries_1_2[i].opcode == opcode)
-      return opcodeTableEntries_1_2[i].name;
-  }
+  // The stored names carry the "Op" prefix; step past it for the bare name.
+  const std::vector<const char*>& table = OpcodeNameTable();
+  const uint32_t value = opcode;
+  if (value < table.size() && table[value]) return table[value] + 2;
   assert(0 && "Unreachable!");
   return "unknown";
 }
 
+const char* spvOpcodeStringPrefixed(const SpvOp opcode) {
+  // The unified table covers every SPIR-V version; an opcode's name never
+  // changes between versions, so one dense table serves them all.
+  const std::vector<const char*>& table = OpcodeNameTable();
+  const uint32_t value = opcode;
+  if (value < table.size() && table[value]) return table[value];
+  assert(0 && "Unreachable!");
+  return "OpUnknown";
+}
+
 int32_t spvOpcodeIsScalarType(const SpvOp opcode) {
-  switch (opcode) {
-    case SpvOpTypeInt:
-    case SpvOpTypeFloat:
-    case SpvOpTypeBool:
-      return true;
-    default:
-      return false;
-  }
+  return (OpcodeAttributes(opcode) & kOpcodeAttrScalarType) != 0;
 }
 
 int32_t spvOpcodeIsConstant(const SpvOp opcode) {
-  switch (opcode) {
-    case SpvOpConstantTrue:
-    case SpvOpConstantFalse:
-    case SpvOpConstant:
-    case SpvOpConstantComposite:
-    case SpvOpConstantSampler:
-    case SpvOpConstantNull:
-    case SpvOpSpecConstantTrue:
-    case SpvOpSpecConstantFalse:
-    case SpvOpSpecConstant:
-    case SpvOpSpecConstantComposite:
-    case SpvOpSpecConstantOp:
-      return true;
-    default:
-      return false;
-  }
+  return (OpcodeAttributes(opcode) & kOpcodeAttrConstant) != 0;
 }
 
 bool spvOpcodeIsConstantOrUndef(const SpvOp opcode) {
@@ -216,92 +382,21 @@ bool spvOpcodeIsConstantOrUndef(const SpvOp opcode) {
 }
 
 bool spvOpcodeIsScalarSpecConstant(const SpvOp opcode) {
-  switch (opcode) {
-    case SpvOpSpecConstantTrue:
-    case SpvOpSpecConstantFalse:
-    case SpvOpSpecConstant:
-      return true;
-    default:
-      return false;
-  }
+  return (OpcodeAttributes(opcode) & kOpcodeAttrScalarSpecConstant) != 0;
 }
 
 int32_t spvOpcodeIsComposite(const SpvOp opcode) {
-  switch (opcode) {
-    case SpvOpTypeVector:
-    case SpvOpTypeMatrix:
-    case SpvOpTypeArray:
-    case SpvOpTypeStruct:
-      return true;
-    default:
-      return false;
-  }
+  return (OpcodeAttributes(opcode) & kOpcodeAttrComposite) != 0;
 }
 
 bool spvOpcodeReturnsLogicalVariablePointer(const SpvOp opcode) {
-  switch (opcode) {
-    case SpvOpVariable:
-    case SpvOpAccessChain:
-    case SpvOpInBoundsAccessChain:
-    case SpvOpFunctionParameter:
-    case SpvOpImageTexelPointer:
-    case SpvOpCopyObject:
-    case SpvOpSelect:
-    case SpvOpPhi:
-    case SpvOpFunctionCall:
-    case SpvOpPtrAccessChain:
-    case SpvOpLoad:
-    case SpvOpConstantNull:
-      return true;
-    default:
-      return false;
-  }
+  return (OpcodeAttributes(opcode) & kOpcodeAttrLogicalVariablePointer) != 0;
 }
 
 int32_t spvOpcodeReturnsLogicalPointer(const SpvOp opcode) {
-  switch (opcode) {
-    case SpvOpVariable:
-    case SpvOpAccessChain:
-    case SpvOpInBoundsAccessChain:
-    case SpvOpFunctionParameter:
-    case SpvOpImageTexelPointer:
-    case SpvOpCopyObject:
-      return true;
-    default:
-      return false;
-  }
+  return (OpcodeAttributes(opcode) & kOpcodeAttrLogicalPointer) != 0;
 }
 
 int32_t spvOpcodeGeneratesType(SpvOp op) {
-  switch (op) {
-    case SpvOpTypeVoid:
-    case SpvOpTypeBool:
-    case SpvOpTypeInt:
-    case SpvOpTypeFloat:
-    case SpvOpTypeVector:
-    case SpvOpTypeMatrix:
-    case SpvOpTypeImage:
-    case SpvOpTypeSampler:
-    case SpvOpTypeSampledImage:
-    case SpvOpTypeArray:
-    case SpvOpTypeRuntimeArray:
-    case SpvOpTypeStruct:
-    case SpvOpTypeOpaque:
-    case SpvOpTypePointer:
-    case SpvOpTypeFunction:
-    case SpvOpTypeEvent:
-    case SpvOpTypeDeviceEvent:
-    case SpvOpTypeReserveId:
-    case SpvOpTypeQueue:
-    case SpvOpTypePipe:
-    case SpvOpTypePipeStorage:
-    case SpvOpTypeNamedBarrier:
-      return true;
-    default:
-      // In particular, OpTypeForwardPointer does not generate a type,
-      // but declares a storage class for a pointer type generated
-      // by a different instruction.
-      break;
-  }
-  return 0;
+  return (OpcodeAttributes(op) & kOpcodeAttrGeneratesType) != 0;
 }
@@ -57,6 +57,12 @@ void spvInstructionCopy(const uint32_t* words, const SpvOp opcode,
 // Gets the name of an instruction, without the "Op" prefix.
 const char* spvOpcodeString(const SpvOp opcode);
 
+// Gets the name of an instruction with the "Op" prefix attached, e.g.
+// "OpTypeInt".  Both name functions are a single indexed load from a dense
+// opcode-value-indexed table, so they are cheap enough for per-instruction
+// use in print loops.
+const char* spvOpcodeStringPrefixed(const SpvOp opcode);
+
 // Determine if the given opcode is a scalar type. Returns zero if false,
 // non-zero otherwise.
 int32_t spvOpcodeIsScalarType(const SpvOp opcode);
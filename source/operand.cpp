@@ -17,6 +17,12 @@
 #include <assert.h>
 #include <string.h>
 
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 #include "macro.h"
 
 // Pull in operand info tables automatically generated from JSON grammar.
@@ -30,20 +36,27 @@ namespace v1_2 {
 #include "operand.kinds-1.2.inc"
 }  // namespace v1_2
 
+namespace {
+
+// The per-version table descriptors are constexpr so that they are fully
+// formed at compile time and spvOperandTableGet degenerates to returning a
+// pointer, with no static-initialization guard on the fast path.
+constexpr spv_operand_table_t kOperandTable_1_0 = {
+    ARRAY_SIZE(v1_0::pygen_variable_OperandInfoTable),
+    v1_0::pygen_variable_OperandInfoTable};
+constexpr spv_operand_table_t kOperandTable_1_1 = {
+    ARRAY_SIZE(v1_1::pygen_variable_OperandInfoTable),
+    v1_1::pygen_variable_OperandInfoTable};
+constexpr spv_operand_table_t kOperandTable_1_2 = {
+    ARRAY_SIZE(v1_2::pygen_variable_OperandInfoTable),
+    v1_2::pygen_variable_OperandInfoTable};
+
+}  // anonymous namespace
+
 spv_result_t spvOperandTableGet(spv_operand_table* pOperandTable,
                                 spv_target_env env) {
   if (!pOperandTable) return SPV_ERROR_INVALID_POINTER;
 
-  static const spv_operand_table_t table_1_0 = {
-      ARRAY_SIZE(v1_0::pygen_variable_OperandInfoTable),
-      v1_0::pygen_variable_OperandInfoTable};
-  static const spv_operand_table_t table_1_1 = {
-      ARRAY_SIZE(v1_1::pygen_variable_OperandInfoTable),
-      v1_1::pygen_variable_OperandInfoTable};
-  static const spv_operand_table_t table_1_2 = {
-      ARRAY_SIZE(v1_2::pygen_variable_OperandInfoTable),
-      v1_2::pygen_variable_OperandInfoTable};
-
   switch (env) {
     case SPV_ENV_UNIVERSAL_1_0:
     case SPV_ENV_VULKAN_1_0:
@@ -53,14 +66,14 @@ spv_result_t spvOperandTableGet(spv_operand_table* pOperandTable,
     case SPV_ENV_OPENGL_4_2:
     case SPV_ENV_OPENGL_4_3:
     case SPV_ENV_OPENGL_4_5:
-      *pOperandTable = &table_1_0;
+      *pOperandTable = &kOperandTable_1_0;
       return SPV_SUCCESS;
     case SPV_ENV_UNIVERSAL_1_1:
-      *pOperandTable = &table_1_1;
+      *pOperandTable = &kOperandTable_1_1;
       return SPV_SUCCESS;
     case SPV_ENV_UNIVERSAL_1_2:
     case SPV_ENV_OPENCL_2_2:
-      *pOperandTable = &table_1_2;
+      *pOperandTable = &kOperandTable_1_2;
       return SPV_SUCCESS;
   }
   assert(0 && "Unknown spv_target_env in spvOperandTableGet()");
@@ -69,6 +82,61 @@ spv_result_t spvOperandTableGet(spv_operand_table* pOperandTable,
 
 #undef ARRAY_SIZE
 
+namespace {
+
+// A lookup index over one operand-kind group in an operand table: entry
+// indices sorted by name for binary-search name lookup, and sorted by value
+// for binary-search value lookup.  Sorting is stable so that a lookup finds
+// the same entry as a linear scan when values are aliased.
+struct OperandGroupIndex {
+  explicit OperandGroupIndex(const spv_operand_desc_group_t& group) {
+    const spv_operand_desc_t* entries = group.entries;
+    by_name.resize(group.count);
+    for (uint32_t i = 0; i < group.count; ++i) by_name[i] = uint16_t(i);
+    by_value = by_name;
+    std::stable_sort(by_name.begin(), by_name.end(),
+                     [entries](uint16_t lhs, uint16_t rhs) {
+                       return strcmp(entries[lhs].name, entries[rhs].name) < 0;
+                     });
+    std::stable_sort(by_value.begin(), by_value.end(),
+                     [entries](uint16_t lhs, uint16_t rhs) {
+                       return entries[lhs].value < entries[rhs].value;
+                     });
+  }
+
+  std::vector<uint16_t> by_name;   // Entry indices sorted by name.
+  std::vector<uint16_t> by_value;  // Entry indices sorted by value.
+};
+
+// Per-group indexes for an operand table, parallel to the table's types
+// array.
+struct OperandTableIndex {
+  explicit OperandTableIndex(const spv_operand_table_t& table) {
+    groups.reserve(table.count);
+    for (uint32_t i = 0; i < table.count; ++i)
+      groups.emplace_back(table.types[i]);
+  }
+
+  std::vector<OperandGroupIndex> groups;
+};
+
+// Returns the lookup index for |table|, building it on first use.  The
+// tables returned by spvOperandTableGet are static, so indexes are cached
+// for the lifetime of the process.
+const OperandTableIndex& spvOperandTableIndexFor(
+    const spv_operand_table table) {
+  static std::mutex mutex;
+  static auto* cache =
+      new std::unordered_map<const spv_operand_table_t*,
+                             std::unique_ptr<OperandTableIndex>>;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& index = (*cache)[table];
+  if (!index) index.reset(new OperandTableIndex(*table));
+  return *index;
+}
+
+}  // anonymous namespace
+
 spv_result_t spvOperandTableNameLookup(const spv_operand_table table,
                                        const spv_operand_type_t type,
                                        const char* name,
@@ -77,13 +145,25 @@ spv_result_t spvOperandTableNameLookup(const spv_operand_table table,
   if (!table) return SPV_ERROR_INVALID_TABLE;
   if (!name || !pEntry) return SPV_ERROR_INVALID_POINTER;
 
+  const OperandTableIndex& index = spvOperandTableIndexFor(table);
   for (uint64_t typeIndex = 0; typeIndex < table->count; ++typeIndex) {
     const auto& group = table->types[typeIndex];
     if (type != group.type) continue;
-    for (uint64_t index = 0; index < group.count; ++index) {
-      const auto& entry = group.entries[index];
-      if (nameLength == strlen(entry.name) &&
-          !strncmp(entry.name, name, nameLength)) {
+    const auto& by_name = index.groups[typeIndex].by_name;
+    // The lookup key is not null-terminated, so compare its nameLength
+    // characters and then require the candidate to end there.
+    const auto where = std::lower_bound(
+        by_name.begin(), by_name.end(), name,
+        [&group, nameLength](uint16_t entry, const char* key) {
+          // A candidate that is a strict prefix of the key compares less
+          // here because its terminating null orders before the key's next
+          // character.  A candidate with the key as a prefix compares equal.
+          return strncmp(group.entries[entry].name, key, nameLength) < 0;
+        });
+    for (auto candidate = where; candidate != by_name.end(); ++candidate) {
+      const auto& entry = group.entries[*candidate];
+      if (strncmp(entry.name, name, nameLength)) break;
+      if (entry.name[nameLength] == '\0') {
         *pEntry = &entry;
         return SPV_SUCCESS;
       }
@@ -100,15 +180,19 @@ spv_result_t spvOperandTableValueLookup(const spv_operand_table table,
   if (!table) return SPV_ERROR_INVALID_TABLE;
   if (!pEntry) return SPV_ERROR_INVALID_POINTER;
 
+  const OperandTableIndex& index = spvOperandTableIndexFor(table);
   for (uint64_t typeIndex = 0; typeIndex < table->count; ++typeIndex) {
     const auto& group = table->types[typeIndex];
     if (type != group.type) continue;
-    for (uint64_t index = 0; index < group.count; ++index) {
-      const auto& entry = group.entries[index];
-      if (value == entry.value) {
-        *pEntry = &entry;
-        return SPV_SUCCESS;
-      }
+    const auto& by_value = index.groups[typeIndex].by_value;
+    const auto where = std::lower_bound(
+        by_value.begin(), by_value.end(), value,
+        [&group](uint16_t entry, uint32_t key) {
+          return group.entries[entry].value < key;
+        });
+    if (where != by_value.end() && group.entries[*where].value == value) {
+      *pEntry = &group.entries[*where];
+      return SPV_SUCCESS;
     }
   }
 
@@ -223,7 +307,7 @@ void spvPrependOperandTypes(const spv_operand_type_t* types,
   const spv_operand_type_t* endTypes;
   for (endTypes = types; *endTypes != SPV_OPERAND_TYPE_NONE; ++endTypes)
     ;
-  pattern->insert(pattern->begin(), types, endTypes);
+  pattern->prepend(types, endTypes);
 }
 
 void spvPrependOperandTypesForMask(const spv_operand_table operandTable,
@@ -262,24 +346,21 @@ bool spvExpandOperandSequenceOnce(spv_operand_type_t type,
                                   spv_operand_pattern_t* pattern) {
   switch (type) {
     case SPV_OPERAND_TYPE_VARIABLE_ID:
-      pattern->insert(pattern->begin(), {SPV_OPERAND_TYPE_OPTIONAL_ID, type});
+      pattern->prepend({SPV_OPERAND_TYPE_OPTIONAL_ID, type});
       return true;
     case SPV_OPERAND_TYPE_VARIABLE_LITERAL_INTEGER:
-      pattern->insert(pattern->begin(),
-                      {SPV_OPERAND_TYPE_OPTIONAL_LITERAL_INTEGER, type});
+      pattern->prepend({SPV_OPERAND_TYPE_OPTIONAL_LITERAL_INTEGER, type});
       return true;
     case SPV_OPERAND_TYPE_VARIABLE_LITERAL_INTEGER_ID:
       // Represents Zero or more (Literal number, Id) pairs,
       // where the literal number must be a scalar integer.
-      pattern->insert(pattern->begin(),
-                      {SPV_OPERAND_TYPE_OPTIONAL_TYPED_LITERAL_INTEGER,
-                       SPV_OPERAND_TYPE_ID, type});
+      pattern->prepend({SPV_OPERAND_TYPE_OPTIONAL_TYPED_LITERAL_INTEGER,
+                        SPV_OPERAND_TYPE_ID, type});
       return true;
     case SPV_OPERAND_TYPE_VARIABLE_ID_LITERAL_INTEGER:
       // Represents Zero or more (Id, Literal number) pairs.
-      pattern->insert(pattern->begin(),
-                      {SPV_OPERAND_TYPE_OPTIONAL_ID,
-                       SPV_OPERAND_TYPE_LITERAL_INTEGER, type});
+      pattern->prepend({SPV_OPERAND_TYPE_OPTIONAL_ID,
+                        SPV_OPERAND_TYPE_LITERAL_INTEGER, type});
       return true;
     default:
       break;
@@ -15,7 +15,12 @@
 #ifndef LIBSPIRV_OPERAND_H_
 #define LIBSPIRV_OPERAND_H_
 
-#include <deque>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
 
 #include "spirv-tools/libspirv.h"
 #include "table.h"
@@ -27,7 +32,123 @@
 //
 // As we parse an instruction in text or binary form from left to right,
 // we pull and push from the front of the pattern.
-using spv_operand_pattern_t = std::deque<spv_operand_type_t>;
+//
+// The sequence is stored back to front in a fixed inline buffer, so the
+// front push/pop churn on every instruction decode touches only the end
+// of the buffer and never allocates.  Patterns longer than the inline
+// capacity (none in the core grammar) spill to the heap.
+class spv_operand_pattern_t {
+ public:
+  // Iteration is in pattern order, i.e. front first.
+  using const_iterator = std::reverse_iterator<const spv_operand_type_t*>;
+
+  spv_operand_pattern_t() : size_(0), capacity_(kInlineCapacity),
+                            data_(inline_storage_) {}
+
+  // Constructs a pattern from the given array of types, front first.
+  spv_operand_pattern_t(const spv_operand_type_t* first,
+                        const spv_operand_type_t* last)
+      : spv_operand_pattern_t() {
+    prepend(first, last);
+  }
+
+  spv_operand_pattern_t(std::initializer_list<spv_operand_type_t> types)
+      : spv_operand_pattern_t(types.begin(), types.end()) {}
+
+  spv_operand_pattern_t(const spv_operand_pattern_t& that)
+      : spv_operand_pattern_t() {
+    Reserve(that.size_);
+    std::copy(that.data_, that.data_ + that.size_, data_);
+    size_ = that.size_;
+  }
+
+  spv_operand_pattern_t& operator=(const spv_operand_pattern_t& that) {
+    if (this != &that) {
+      Reserve(that.size_);
+      std::copy(that.data_, that.data_ + that.size_, data_);
+      size_ = that.size_;
+    }
+    return *this;
+  }
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+
+  spv_operand_type_t front() const {
+    assert(!empty());
+    return data_[size_ - 1];
+  }
+
+  void push_front(spv_operand_type_t type) {
+    Reserve(size_ + 1);
+    data_[size_++] = type;
+  }
+
+  void pop_front() {
+    assert(!empty());
+    --size_;
+  }
+
+  // Appends the given type at the back of the pattern.  Only used when
+  // building short patterns, so the cost of shifting the storage is fine.
+  void push_back(spv_operand_type_t type) {
+    Reserve(size_ + 1);
+    std::copy_backward(data_, data_ + size_, data_ + size_ + 1);
+    data_[0] = type;
+    ++size_;
+  }
+
+  // Inserts the given types at the front of the pattern, retaining their
+  // order: *first becomes the new front.
+  void prepend(const spv_operand_type_t* first,
+               const spv_operand_type_t* last) {
+    Reserve(size_ + (last - first));
+    while (last != first) data_[size_++] = *--last;
+  }
+
+  void prepend(std::initializer_list<spv_operand_type_t> types) {
+    prepend(types.begin(), types.end());
+  }
+
+  const_iterator begin() const { return const_iterator(data_ + size_); }
+  const_iterator end() const { return const_iterator(data_); }
+
+  bool operator==(const spv_operand_pattern_t& that) const {
+    return size_ == that.size_ &&
+           std::equal(data_, data_ + size_, that.data_);
+  }
+  bool operator!=(const spv_operand_pattern_t& that) const {
+    return !(*this == that);
+  }
+
+ private:
+  // Covers the longest pattern the core grammar tables can produce: the
+  // opcode table stores at most 16 operand types per instruction, and
+  // expansion of masks and variable operands prepends only a few types
+  // per step as the front is consumed.
+  static const size_t kInlineCapacity = 32;
+
+  // Grows the storage to hold at least min_capacity types.
+  void Reserve(size_t min_capacity) {
+    if (min_capacity <= capacity_) return;
+    size_t new_capacity = capacity_ * 2;
+    if (new_capacity < min_capacity) new_capacity = min_capacity;
+    std::unique_ptr<spv_operand_type_t[]> new_storage(
+        new spv_operand_type_t[new_capacity]);
+    std::copy(data_, data_ + size_, new_storage.get());
+    heap_storage_ = std::move(new_storage);
+    data_ = heap_storage_.get();
+    capacity_ = new_capacity;
+  }
+
+  size_t size_;
+  size_t capacity_;
+  // Points at inline_storage_ or heap_storage_.  Element 0 is the back of
+  // the pattern; element size_ - 1 is the front.
+  spv_operand_type_t* data_;
+  spv_operand_type_t inline_storage_[kInlineCapacity];
+  std::unique_ptr<spv_operand_type_t[]> heap_storage_;
+};
 
 // Finds the named operand in the table. The type parameter specifies the
 // operand's group. A handle of the operand table entry for this operand will
@@ -0,0 +1,112 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "aggressive_dead_code_elim_pass.h"
+
+#include <unordered_set>
+#include <vector>
+
+#include "reflect.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+// Returns true if |inst| has no side effects, so that it may be removed
+// once its result has no remaining uses. The opcode ranges follow the
+// numbering of the SPIR-V specification, like the classifiers in reflect.h.
+// Function calls, extended instructions and image operations are
+// conservatively treated as live roots.
+bool IsSideEffectFree(const ir::Instruction& inst) {
+  const SpvOp opcode = inst.opcode();
+  // A load carrying a MemoryAccess operand (e.g. Volatile) must execute
+  // even when its result is unused; the spec forbids eliminating volatile
+  // accesses.  Same operand-count check as the licm pass's IsHoistableLoad.
+  if (opcode == SpvOpLoad) return inst.NumOperands() == 3;
+  return opcode == SpvOpUndef || opcode == SpvOpPhi ||
+         (opcode >= SpvOpAccessChain &&
+          opcode <= SpvOpInBoundsPtrAccessChain) ||
+         (opcode >= SpvOpVectorExtractDynamic && opcode <= SpvOpTranspose) ||
+         (opcode >= SpvOpConvertFToU && opcode <= SpvOpBitcast) ||
+         (opcode >= SpvOpSNegate && opcode <= SpvOpSMulExtended) ||
+         (opcode >= SpvOpAny && opcode <= SpvOpFUnordGreaterThanEqual) ||
+         (opcode >= SpvOpShiftRightLogical && opcode <= SpvOpBitCount);
+}
+
+}  // anonymous namespace
+
+bool AggressiveDCEPass::ProcessFunction(ir::Function* func,
+                                        analysis::DefUseManager* def_use) {
+  // Seed the worklist with every instruction that must execute for its side
+  // effects or its control flow role. Everything else is presumed dead until
+  // reached from a seed.
+  std::unordered_set<const ir::Instruction*> live;
+  std::vector<ir::Instruction*> worklist;
+  func->ForEachInst([&live, &worklist](ir::Instruction* inst) {
+    if (!IsSideEffectFree(*inst)) {
+      live.insert(inst);
+      worklist.push_back(inst);
+    }
+  });
+
+  // Propagate liveness backwards over the def-use edges. Definitions outside
+  // the function (types, constants, global variables) may get marked too;
+  // that is harmless since only instructions in |func| are swept.
+  while (!worklist.empty()) {
+    ir::Instruction* inst = worklist.back();
+    worklist.pop_back();
+    inst->ForEachInId([&live, &worklist, def_use](const uint32_t* id) {
+      ir::Instruction* def = def_use->GetDef(*id);
+      if (def != nullptr && live.insert(def).second) worklist.push_back(def);
+    });
+  }
+
+  std::vector<ir::Instruction*> dead;
+  func->ForEachInst([&live, &dead](ir::Instruction* inst) {
+    if (!live.count(inst)) dead.push_back(inst);
+  });
+  if (dead.empty()) return false;
+
+  // Names and decorations of dead instructions must go with them. Group
+  // decorations referencing function-local ids do not occur in practice, so
+  // whole-instruction removal suffices here as well.
+  std::unordered_set<ir::Instruction*> dead_others;
+  for (ir::Instruction* inst : dead) {
+    if (analysis::UseList* uses = def_use->GetUses(inst->result_id())) {
+      for (const auto& u : *uses) {
+        if (ir::IsAnnotationInst(u.inst->opcode()) ||
+            ir::IsDebugInst(u.inst->opcode())) {
+          dead_others.insert(u.inst);
+        }
+      }
+    }
+  }
+
+  for (ir::Instruction* inst : dead_others) def_use->KillInst(inst);
+  for (ir::Instruction* inst : dead) def_use->KillInst(inst);
+  return true;
+}
+
+Pass::Status AggressiveDCEPass::Process(ir::Module* module) {
+  analysis::DefUseManager* def_use = analyses(module)->GetDefUse();
+  bool modified = false;
+  for (auto& func : *module) {
+    modified |= ProcessFunction(&func, def_use);
+  }
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
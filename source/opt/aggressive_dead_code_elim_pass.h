@@ -0,0 +1,46 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_AGGRESSIVE_DEAD_CODE_ELIM_PASS_H_
+#define LIBSPIRV_OPT_AGGRESSIVE_DEAD_CODE_ELIM_PASS_H_
+
+#include "def_use_manager.h"
+#include "module.h"
+#include "pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class AggressiveDCEPass : public Pass {
+ public:
+  const char* name() const override { return "eliminate-dead-code-aggressive"; }
+  Status Process(ir::Module*) override;
+
+  // Every removal goes through DefUseManager and only touches straight-line
+  // instructions, so the shared analyses survive this pass.
+  uint32_t GetPreservedAnalyses() const override {
+    return AnalysisManager::kAnalysisAll;
+  }
+
+ private:
+  // Eliminates dead instructions in |func|. Returns true if anything was
+  // removed.
+  bool ProcessFunction(ir::Function* func, analysis::DefUseManager* def_use);
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_AGGRESSIVE_DEAD_CODE_ELIM_PASS_H_
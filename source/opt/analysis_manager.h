@@ -0,0 +1,158 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_ANALYSIS_MANAGER_H_
+#define LIBSPIRV_OPT_ANALYSIS_MANAGER_H_
+
+#include <memory>
+
+#include "cfg.h"
+#include "constant_manager.h"
+#include "def_use_manager.h"
+#include "make_unique.h"
+#include "module.h"
+#include "type_manager.h"
+#include "type_pool.h"
+
+#include "spirv-tools/libspirv.hpp"
+
+namespace spvtools {
+namespace opt {
+
+// Analysis state that outlives any one module: a pool of interned types and
+// a constant manager whose hash-consed constants and memoized folds are
+// keyed on the pooled types. A pipeline that optimizes many structurally
+// similar modules hands the same session to the AnalysisManager of each
+// run, so the type hierarchy is interned once and the constants and fold
+// results warmed on one module are reused on the next.
+class AnalysisSession {
+ public:
+  AnalysisSession() {}
+
+  AnalysisSession(const AnalysisSession&) = delete;
+  AnalysisSession& operator=(const AnalysisSession&) = delete;
+
+  // Returns the pool of interned types shared by the runs of this session.
+  analysis::TypePool* type_pool() { return &type_pool_; }
+  // Returns the constant manager shared by the runs of this session. Its
+  // constants must be built over types owned by type_pool().
+  analysis::ConstantManager* constants() { return &constants_; }
+
+ private:
+  analysis::TypePool type_pool_;
+  analysis::ConstantManager constants_;
+};
+
+// Builds and caches the analyses shared by the passes of one pipeline. A
+// pass requests an analysis with one of the Get methods; the first request
+// builds it and later requests, including those from later passes, return
+// the same instance. After a pass changes the module, PassManager drops the
+// analyses the pass did not declare preserved, so a pipeline pays for each
+// analysis once per invalidation instead of once per pass.
+class AnalysisManager {
+ public:
+  // The analyses handed out by this manager, as bits to be combined into the
+  // preservation masks returned from Pass::GetPreservedAnalyses().
+  enum Analysis : uint32_t {
+    kAnalysisNone = 0,
+    kAnalysisDefUse = 1 << 0,
+    kAnalysisCfg = 1 << 1,
+    kAnalysisTypes = 1 << 2,
+    kAnalysisConstants = 1 << 3,
+    kAnalysisAll = ~0u,
+  };
+
+  // Constructs a manager for the given |module|. Internal messages of the
+  // analyses go to |consumer|; both must outlive this instance. The
+  // optional |session| carries the type and constant state shared across
+  // the modules of one pipeline and must outlive every manager using it.
+  AnalysisManager(const MessageConsumer& consumer, ir::Module* module,
+                  AnalysisSession* session = nullptr)
+      : consumer_(consumer), module_(module), session_(session) {}
+
+  AnalysisManager(const AnalysisManager&) = delete;
+  AnalysisManager& operator=(const AnalysisManager&) = delete;
+
+  // Returns the module the analyses describe.
+  ir::Module* module() const { return module_; }
+
+  // Returns the def-use analysis, building it on first request.
+  analysis::DefUseManager* GetDefUse() {
+    if (!def_use_) {
+      def_use_ = MakeUnique<analysis::DefUseManager>(consumer_, module_);
+    }
+    return def_use_.get();
+  }
+
+  // Returns the control flow analysis dispenser, building it on first
+  // request. The individual FunctionCfg analyses are computed lazily by the
+  // dispenser itself.
+  analysis::CfgManager* GetCfgs() {
+    if (!cfgs_) cfgs_ = MakeUnique<analysis::CfgManager>(module_);
+    return cfgs_.get();
+  }
+
+  // Returns the type analysis, building it on first request. With a
+  // session, the analysis interns its types into the session's pool.
+  analysis::TypeManager* GetTypes() {
+    if (!types_) {
+      types_ = MakeUnique<analysis::TypeManager>(
+          consumer_, *module_, session_ ? session_->type_pool() : nullptr);
+    }
+    return types_.get();
+  }
+
+  // Returns the constant canonicalization and folding manager, building it
+  // on first request. The session's manager is handed out only when the
+  // type analysis pools every type, since constants are keyed on type
+  // pointers and sharing them is only sound over pool-owned types.
+  analysis::ConstantManager* GetConstants() {
+    if (session_ && GetTypes()->AllTypesPooled()) return session_->constants();
+    if (!constants_) constants_ = MakeUnique<analysis::ConstantManager>();
+    return constants_.get();
+  }
+
+  // Drops every analysis whose bit is not set in |preserved|. Dropping the
+  // type analysis also drops the constant manager, since canonical constants
+  // point at types owned by the type manager. Session-owned state is never
+  // dropped: its constants point at pool-owned types, which stay valid when
+  // the per-module type analysis is rebuilt.
+  void Invalidate(uint32_t preserved) {
+    if (!(preserved & kAnalysisDefUse)) def_use_.reset();
+    if (!(preserved & kAnalysisCfg)) cfgs_.reset();
+    if (!(preserved & kAnalysisTypes)) {
+      types_.reset();
+      constants_.reset();
+    }
+    if (!(preserved & kAnalysisConstants)) constants_.reset();
+  }
+
+ private:
+  // Consumer for the messages of the analyses built here.
+  const MessageConsumer& consumer_;
+  // The module the analyses describe.
+  ir::Module* module_;
+  // The cross-module session state, if any.
+  AnalysisSession* session_;
+  // The cached analyses; null until first requested or after invalidation.
+  std::unique_ptr<analysis::DefUseManager> def_use_;
+  std::unique_ptr<analysis::CfgManager> cfgs_;
+  std::unique_ptr<analysis::TypeManager> types_;
+  std::unique_ptr<analysis::ConstantManager> constants_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_ANALYSIS_MANAGER_H_
@@ -0,0 +1,241 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_ARENA_H_
+#define LIBSPIRV_OPT_ARENA_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "allocator.h"
+#include "spirv-tools/libspirv.h"
+
+namespace spvtools {
+namespace ir {
+
+// A chunked bump allocator.  Allocations are served from large chunks by
+// advancing a cursor, and all memory is released wholesale when the arena is
+// destroyed.  Individual allocations are never returned to the arena.
+//
+// This exists to back the in-memory IR: a module loaded from a large binary
+// creates very many small, equally-lived objects (instructions, basic
+// blocks), and placing them in an arena avoids per-object heap traffic and
+// improves locality for the passes that walk them later.
+class Arena {
+ public:
+  Arena()
+      : upstream_(),
+        cursor_(nullptr),
+        remaining_(0),
+        used_bytes_(0),
+        num_allocations_(0) {}
+  ~Arena() {
+    for (size_t i = 0; i < chunks_.size(); ++i)
+      AllocatorFree(upstream_, chunks_[i], chunk_sizes_[i]);
+  }
+
+  // The arena owns its chunks; copying makes no sense.
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // Directs chunk reservations to |allocator|, which is copied; passing
+  // null restores the global heap.  Must be called before the arena reserves
+  // its first chunk, so every chunk is released the way it was reserved.
+  // See spv_allocator_t in libspirv.h.
+  void SetUpstreamAllocator(const spv_allocator_t* allocator) {
+    assert(chunks_.empty() &&
+           "the upstream allocator must be set before the first allocation");
+    if (allocator) {
+      upstream_ = *allocator;
+    } else {
+      upstream_ = spv_allocator_t{nullptr, nullptr, nullptr};
+    }
+  }
+
+  // Returns the allocator serving chunk reservations; all-zero callbacks
+  // mean the global heap.
+  const spv_allocator_t& upstream_allocator() const { return upstream_; }
+
+  // Returns a pointer to |num_bytes| of storage aligned for any of the IR
+  // types placed in the arena.  The storage lives until this arena is
+  // destroyed.
+  void* Allocate(size_t num_bytes) {
+    num_bytes = (num_bytes + kAlignment - 1) & ~size_t(kAlignment - 1);
+    if (num_bytes > remaining_) AddChunk(num_bytes);
+    void* result = cursor_;
+    cursor_ += num_bytes;
+    remaining_ -= num_bytes;
+    used_bytes_ += num_bytes;
+    ++num_allocations_;
+    return result;
+  }
+
+  // A snapshot of the allocation state, taken by Mark() and restored by
+  // Rollback().
+  struct Checkpoint {
+    size_t num_chunks;       // Number of chunks at the mark.
+    char* cursor;            // Bump cursor at the mark.
+    size_t remaining;        // Free bytes in the then-current chunk at the mark.
+    size_t used_bytes;       // Bytes handed out at the mark.
+    size_t num_allocations;  // Allocations served at the mark.
+  };
+
+  // Returns a checkpoint of the current high-water mark.
+  Checkpoint Mark() const {
+    return {chunks_.size(), cursor_, remaining_, used_bytes_,
+            num_allocations_};
+  }
+
+  // Returns the arena to the state captured by |mark|: chunks added since
+  // the mark are freed and the bump cursor rewinds, so the bytes handed out
+  // since the mark serve later allocations again. Every object placed in
+  // the arena after the mark must be dead by now; only its storage is
+  // reclaimed here, destructors do not run.
+  void Rollback(const Checkpoint& mark) {
+    while (chunks_.size() > mark.num_chunks) {
+      AllocatorFree(upstream_, chunks_.back(), chunk_sizes_.back());
+      chunks_.pop_back();
+      chunk_sizes_.pop_back();
+    }
+    cursor_ = mark.cursor;
+    remaining_ = mark.remaining;
+    used_bytes_ = mark.used_bytes;
+    num_allocations_ = mark.num_allocations;
+  }
+
+  // Exchanges the entire allocation state with |other|, chunks and upstream
+  // allocator included.  Objects placed in either arena stay valid and are
+  // now owned by the other; Module::Compact uses this to adopt a freshly
+  // packed arena while the fragmented one is torn down with the stale IR.
+  void Swap(Arena& other) {
+    std::swap(upstream_, other.upstream_);
+    chunks_.swap(other.chunks_);
+    chunk_sizes_.swap(other.chunk_sizes_);
+    std::swap(cursor_, other.cursor_);
+    std::swap(remaining_, other.remaining_);
+    std::swap(used_bytes_, other.used_bytes_);
+    std::swap(num_allocations_, other.num_allocations_);
+  }
+
+  // Returns the total number of bytes reserved by this arena.
+  size_t TotalBytes() const {
+    size_t total = 0;
+    for (size_t chunk_bytes : chunk_sizes_) total += chunk_bytes;
+    return total;
+  }
+
+  // Aggregate accounting for this arena, for memory telemetry.
+  struct Stats {
+    size_t num_chunks;       // Number of chunks reserved.
+    size_t reserved_bytes;   // Bytes reserved across all chunks.
+    size_t used_bytes;       // Bytes handed out by Allocate, after rounding.
+    size_t num_allocations;  // Number of Allocate calls served.
+  };
+
+  // Returns a snapshot of this arena's accounting.  The difference between
+  // reserved and used bytes is chunk slack: unreachable tails of chunks that
+  // filled up plus the free space in the current chunk.
+  Stats GetStats() const {
+    return {chunks_.size(), TotalBytes(), used_bytes_, num_allocations_};
+  }
+
+ private:
+  // All allocations are rounded up to this alignment.  Pointer/uint64_t
+  // alignment is sufficient for the IR types placed in the arena.
+  static const size_t kAlignment = alignof(uint64_t);
+  // Default chunk size.  Large enough that chunk setup is rare, small enough
+  // not to hurt modest modules.
+  static const size_t kDefaultChunkBytes = size_t(64) << 10;
+
+  // Makes a fresh chunk of at least |min_bytes| the current chunk.
+  void AddChunk(size_t min_bytes) {
+    const size_t num_bytes =
+        min_bytes > kDefaultChunkBytes ? min_bytes : kDefaultChunkBytes;
+    char* chunk = static_cast<char*>(AllocatorAlloc(upstream_, num_bytes));
+    chunks_.push_back(chunk);
+    chunk_sizes_.push_back(num_bytes);
+    cursor_ = chunk;
+    remaining_ = num_bytes;
+  }
+
+  // Where chunks come from; all-zero callbacks mean the global heap.
+  spv_allocator_t upstream_;
+  std::vector<char*> chunks_;        // All chunks, freed by the destructor.
+  std::vector<size_t> chunk_sizes_;  // Size of each chunk in bytes.
+  char* cursor_;                     // Next free byte in the current chunk.
+  size_t remaining_;                 // Free bytes left in the current chunk.
+  size_t used_bytes_;                // Bytes handed out so far.
+  size_t num_allocations_;           // Allocations served so far.
+};
+
+// While alive, makes the given arena the allocation target for dynamically
+// allocated ArenaAllocated objects created on this thread.  Scopes nest; the
+// previous target is restored on destruction.
+class ArenaScope {
+ public:
+  explicit ArenaScope(Arena* arena) : previous_(current_) { current_ = arena; }
+  ~ArenaScope() { current_ = previous_; }
+
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+
+  // Returns the arena targeted on this thread, or nullptr if none.
+  static Arena* Current() { return current_; }
+
+ private:
+  static thread_local Arena* current_;
+  Arena* const previous_;
+};
+
+// Mixin giving a class arena-aware dynamic allocation.  Objects created with
+// `new` inside an ArenaScope are placed in the scope's arena; their storage
+// is reclaimed wholesale when the arena dies and `delete` only runs the
+// destructor.  Objects created outside any scope use the global heap as
+// usual, so existing call sites stay correct without modification.
+class ArenaAllocated {
+ public:
+  void* operator new(size_t num_bytes) {
+    Arena* const arena = ArenaScope::Current();
+    Header* header;
+    if (arena) {
+      header = static_cast<Header*>(arena->Allocate(num_bytes + sizeof(Header)));
+    } else {
+      header = static_cast<Header*>(::operator new(num_bytes + sizeof(Header)));
+    }
+    header->from_arena = arena != nullptr;
+    return header + 1;
+  }
+
+  void operator delete(void* ptr) {
+    if (!ptr) return;
+    Header* const header = static_cast<Header*>(ptr) - 1;
+    if (!header->from_arena) ::operator delete(header);
+    // Arena-backed storage is reclaimed when the arena is destroyed.
+  }
+
+ private:
+  // Records where the allocation came from.  Sized as a pointer-width word
+  // so the object following it keeps fundamental alignment.
+  struct Header {
+    size_t from_arena;
+  };
+};
+
+}  // namespace ir
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_ARENA_H_
@@ -14,12 +14,91 @@
 
 #include "basic_block.h"
 
+#include "function.h"
+#include "ir_journal.h"
+#include "module.h"
+
 namespace spvtools {
 namespace ir {
 
+InstructionList::~InstructionList() {
+  Instruction* inst = head_;
+  while (inst) {
+    Instruction* next = inst->next_inst_;
+    delete inst;
+    inst = next;
+  }
+}
+
+void InstructionList::push_back(std::unique_ptr<Instruction> inst) {
+  InsertBefore(nullptr, std::move(inst));
+}
+
+Instruction* InstructionList::InsertBefore(Instruction* pos,
+                                           std::unique_ptr<Instruction> inst) {
+  Instruction* const node = inst.release();
+  Instruction* const prev = pos ? pos->prev_inst_ : tail_;
+  node->prev_inst_ = prev;
+  node->next_inst_ = pos;
+  if (prev)
+    prev->next_inst_ = node;
+  else
+    head_ = node;
+  if (pos)
+    pos->prev_inst_ = node;
+  else
+    tail_ = node;
+  if (IrJournal* journal = JournalScope::Current()) {
+    journal->RecordInsert(this, node);
+  }
+  return node;
+}
+
+Instruction* InstructionList::Erase(Instruction* inst) {
+  Instruction* const next = inst->next_inst_;
+  Unlink(inst);
+  if (IrJournal* journal = JournalScope::Current()) {
+    // The journal keeps the instruction alive with its links intact, so a
+    // rollback can splice it back in place.
+    journal->RecordErase(this, inst);
+  } else {
+    delete inst;
+  }
+  return next;
+}
+
+void InstructionList::Unlink(Instruction* inst) {
+  if (inst->prev_inst_)
+    inst->prev_inst_->next_inst_ = inst->next_inst_;
+  else
+    head_ = inst->next_inst_;
+  if (inst->next_inst_)
+    inst->next_inst_->prev_inst_ = inst->prev_inst_;
+  else
+    tail_ = inst->prev_inst_;
+}
+
+void InstructionList::Relink(Instruction* inst) {
+  if (inst->prev_inst_)
+    inst->prev_inst_->next_inst_ = inst;
+  else
+    head_ = inst;
+  if (inst->next_inst_)
+    inst->next_inst_->prev_inst_ = inst;
+  else
+    tail_ = inst;
+}
+
+void BasicBlock::AddInstruction(std::unique_ptr<Instruction> i) {
+  if (function_ && function_->module()) {
+    function_->module()->NotifyInsert(i.get());
+  }
+  insts_.push_back(std::move(i));
+}
+
 void BasicBlock::ForEachSuccessorLabel(
     const std::function<void(const uint32_t)>& f) {
-  const auto br = &*insts_.back();
+  const auto br = &insts_.back();
   switch (br->opcode()) {
     case SpvOpBranch: {
       f(br->GetOperand(0).words[0]);
@@ -30,45 +30,214 @@ namespace spvtools {
 namespace ir {
 
 class Function;
+class IrJournal;
+
+// An intrusive doubly-linked list of instructions. The list owns its
+// elements; the prev/next links live inside Instruction itself, so insertion
+// and erasure at any position are O(1) pointer updates with no element
+// shuffling and no per-node bookkeeping allocation. Instructions are
+// ArenaAllocated, so elements created inside an ArenaScope sit in the
+// scope's arena and keep their sequential layout.
+class InstructionList {
+ public:
+  template <bool IsConst>
+  class iterator_template;
+  using iterator = iterator_template<false>;
+  using const_iterator = iterator_template<true>;
+
+  InstructionList() : head_(nullptr), tail_(nullptr) {}
+  ~InstructionList();
+
+  // The list owns its instructions; copying makes no sense.
+  InstructionList(const InstructionList&) = delete;
+  InstructionList& operator=(const InstructionList&) = delete;
+
+  bool empty() const { return head_ == nullptr; }
+  Instruction& back() { return *tail_; }
+
+  // Appends |inst| to this list, taking ownership.
+  void push_back(std::unique_ptr<Instruction> inst);
+
+  inline iterator begin();
+  inline iterator end();
+  inline const_iterator cbegin() const;
+  inline const_iterator cend() const;
+
+ private:
+  // Links |inst| into this list right before |pos|, or at the end if |pos|
+  // is null. Takes ownership and returns the linked instruction.
+  Instruction* InsertBefore(Instruction* pos, std::unique_ptr<Instruction> inst);
+
+  // Unlinks and destroys |inst|, returning its successor (null if |inst|
+  // was the last element).  Under an active JournalScope the instruction is
+  // handed to the journal instead of being destroyed, so the erasure can be
+  // rolled back.
+  Instruction* Erase(Instruction* inst);
+
+  // Removes |inst| from the links without destroying it.  The instruction's
+  // own link fields keep naming its old neighbors, which Relink() relies on.
+  void Unlink(Instruction* inst);
+  // Splices a previously unlinked |inst| back between the neighbors its own
+  // link fields name.  Used by IrJournal rollback.
+  void Relink(Instruction* inst);
+
+  friend class IrJournal;
+
+  Instruction* head_;  // First element, or null if the list is empty.
+  Instruction* tail_;  // Last element, or null if the list is empty.
+};
+
+// An iterator over an InstructionList. Dereferences transparently to
+// Instruction so pass code reads as if iterating a container of values.
+// Unlike UptrVectorIterator, InsertBefore() and Erase() never invalidate
+// other iterators: only an Erase() invalidates the iterators pointing at
+// the erased instruction itself.
+template <bool IsConst>
+class InstructionList::iterator_template
+    : public std::iterator<std::bidirectional_iterator_tag,
+                           typename std::conditional<IsConst, const Instruction,
+                                                     Instruction>::type> {
+ public:
+  using super = std::iterator<
+      std::bidirectional_iterator_tag,
+      typename std::conditional<IsConst, const Instruction, Instruction>::type>;
+
+  using pointer = typename super::pointer;
+  using reference = typename super::reference;
+
+  // The list type with constness applied if |IsConst| is true.
+  using List = typename std::conditional<IsConst, const InstructionList,
+                                         InstructionList>::type;
+
+  // Creates an iterator into |list| at element |node|. A null |node|
+  // represents the end position.
+  iterator_template(List* list, pointer node) : list_(list), node_(node) {}
+  iterator_template(const iterator_template&) = default;
+  iterator_template& operator=(const iterator_template&) = default;
+
+  reference operator*() const { return *node_; }
+  pointer operator->() const { return node_; }
+
+  iterator_template& operator++() {
+    node_ = node_->next_inst_;
+    return *this;
+  }
+  iterator_template operator++(int) {
+    auto it = *this;
+    ++(*this);
+    return it;
+  }
+  iterator_template& operator--() {
+    node_ = node_ ? node_->prev_inst_ : list_->tail_;
+    return *this;
+  }
+  iterator_template operator--(int) {
+    auto it = *this;
+    --(*this);
+    return it;
+  }
+
+  bool operator==(const iterator_template& that) const {
+    return list_ == that.list_ && node_ == that.node_;
+  }
+  bool operator!=(const iterator_template& that) const {
+    return !(*this == that);
+  }
+
+  // Inserts the given |value| right before the position pointed to by this
+  // iterator and returns an iterator to the newly inserted |value|.
+  template <bool IsConstForMethod = IsConst>
+  typename std::enable_if<!IsConstForMethod, iterator_template>::type
+  InsertBefore(std::unique_ptr<Instruction> value) {
+    return iterator_template(list_, list_->InsertBefore(node_, std::move(value)));
+  }
+
+  // Inserts the given |values| in order right before the position pointed to
+  // by this iterator and returns an iterator to the first newly inserted
+  // value.
+  template <bool IsConstForMethod = IsConst>
+  typename std::enable_if<!IsConstForMethod, iterator_template>::type
+  InsertBefore(std::vector<std::unique_ptr<Instruction>>* values) {
+    iterator_template first = *this;
+    bool seen_first = false;
+    for (auto& value : *values) {
+      Instruction* node = list_->InsertBefore(node_, std::move(value));
+      if (!seen_first) {
+        first = iterator_template(list_, node);
+        seen_first = true;
+      }
+    }
+    return first;
+  }
+
+  // Erases the instruction at the position pointed to by this iterator and
+  // returns an iterator to the following instruction. This iterator and any
+  // other iterator to the erased instruction are invalidated.
+  template <bool IsConstForMethod = IsConst>
+  typename std::enable_if<!IsConstForMethod, iterator_template>::type
+  Erase() {
+    return iterator_template(list_, list_->Erase(node_));
+  }
+
+ private:
+  List* list_;    // The list this iterator walks.
+  pointer node_;  // The current element; null represents end().
+};
+
+inline InstructionList::iterator InstructionList::begin() {
+  return iterator(this, head_);
+}
+inline InstructionList::iterator InstructionList::end() {
+  return iterator(this, nullptr);
+}
+inline InstructionList::const_iterator InstructionList::cbegin() const {
+  return const_iterator(this, head_);
+}
+inline InstructionList::const_iterator InstructionList::cend() const {
+  return const_iterator(this, nullptr);
+}
 
 // A SPIR-V basic block.
-class BasicBlock {
+class BasicBlock : public ArenaAllocated {
  public:
-  using iterator = UptrVectorIterator<Instruction>;
-  using const_iterator = UptrVectorIterator<Instruction, true>;
+  using iterator = InstructionList::iterator;
+  using const_iterator = InstructionList::const_iterator;
 
   // Creates a basic block with the given starting |label|.
   inline explicit BasicBlock(std::unique_ptr<Instruction> label);
 
   // Sets the enclosing function for this basic block.
   void SetParent(Function* function) { function_ = function; }
-  // Appends an instruction to this basic block.
-  inline void AddInstruction(std::unique_ptr<Instruction> i);
+  // Appends an instruction to this basic block.  If the block is already
+  // attached to a function in a module, that module's change listeners are
+  // notified.
+  void AddInstruction(std::unique_ptr<Instruction> i);
   // The label starting this basic block.
   Instruction& Label() { return *label_; }
 
   // Returns the id of the label at the top of this block
   inline uint32_t id() const { return label_->result_id(); }
 
-  iterator begin() { return iterator(&insts_, insts_.begin()); }
-  iterator end() { return iterator(&insts_, insts_.end()); }
-  const_iterator cbegin() const {
-    return const_iterator(&insts_, insts_.cbegin());
-  }
-  const_iterator cend() const {
-    return const_iterator(&insts_, insts_.cend());
-  }
+  iterator begin() { return insts_.begin(); }
+  iterator end() { return insts_.end(); }
+  const_iterator cbegin() const { return insts_.cbegin(); }
+  const_iterator cend() const { return insts_.cend(); }
 
   // Runs the given function |f| on each instruction in this basic block, and
-  // optionally on the debug line instructions that might precede them.
-  inline void ForEachInst(const std::function<void(Instruction*)>& f,
+  // optionally on the debug line instructions that might precede them.  |f|
+  // is any callable taking an Instruction* (const Instruction* for the const
+  // overload) and is inlined at the call site.
+  template <typename FunctionT>
+  inline void ForEachInst(const FunctionT& f,
                           bool run_on_debug_line_insts = false);
-  inline void ForEachInst(const std::function<void(const Instruction*)>& f,
+  template <typename FunctionT>
+  inline void ForEachInst(const FunctionT& f,
                           bool run_on_debug_line_insts = false) const;
 
   // Runs the given function |f| on each Phi instruction in this basic block,
   // and optionally on the debug line instructions that might precede them.
-  inline void ForEachPhiInst(const std::function<void(Instruction*)>& f,
+  template <typename FunctionT>
+  inline void ForEachPhiInst(const FunctionT& f,
                              bool run_on_debug_line_insts = false);
 
   // Runs the given function |f| on each label id of each successor block
@@ -81,38 +250,36 @@ class BasicBlock {
   // The label starting this basic block.
   std::unique_ptr<Instruction> label_;
   // Instructions inside this basic block, but not the OpLabel.
-  std::vector<std::unique_ptr<Instruction>> insts_;
+  InstructionList insts_;
 };
 
 inline BasicBlock::BasicBlock(std::unique_ptr<Instruction> label)
     : function_(nullptr), label_(std::move(label)) {}
 
-inline void BasicBlock::AddInstruction(std::unique_ptr<Instruction> i) {
-  insts_.emplace_back(std::move(i));
-}
-
-inline void BasicBlock::ForEachInst(const std::function<void(Instruction*)>& f,
+template <typename FunctionT>
+inline void BasicBlock::ForEachInst(const FunctionT& f,
                                     bool run_on_debug_line_insts) {
   if (label_) label_->ForEachInst(f, run_on_debug_line_insts);
-  for (auto& inst : insts_) inst->ForEachInst(f, run_on_debug_line_insts);
+  for (auto ii = insts_.begin(); ii != insts_.end(); ++ii)
+    ii->ForEachInst(f, run_on_debug_line_insts);
 }
 
-inline void BasicBlock::ForEachInst(
-    const std::function<void(const Instruction*)>& f,
-    bool run_on_debug_line_insts) const {
+template <typename FunctionT>
+inline void BasicBlock::ForEachInst(const FunctionT& f,
+                                    bool run_on_debug_line_insts) const {
   if (label_)
     static_cast<const Instruction*>(label_.get())
         ->ForEachInst(f, run_on_debug_line_insts);
-  for (const auto& inst : insts_)
-    static_cast<const Instruction*>(inst.get())
-        ->ForEachInst(f, run_on_debug_line_insts);
+  for (auto ii = insts_.cbegin(); ii != insts_.cend(); ++ii)
+    ii->ForEachInst(f, run_on_debug_line_insts);
 }
 
-inline void BasicBlock::ForEachPhiInst(
-    const std::function<void(Instruction*)>& f, bool run_on_debug_line_insts) {
-  for (auto& inst : insts_) {
-    if (inst->opcode() != SpvOpPhi) break;
-    inst->ForEachInst(f, run_on_debug_line_insts);
+template <typename FunctionT>
+inline void BasicBlock::ForEachPhiInst(const FunctionT& f,
+                                       bool run_on_debug_line_insts) {
+  for (auto ii = insts_.begin(); ii != insts_.end(); ++ii) {
+    if (ii->opcode() != SpvOpPhi) break;
+    ii->ForEachInst(f, run_on_debug_line_insts);
   }
 }
 
@@ -14,6 +14,10 @@
 
 #include "build_module.h"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 #include "ir_loader.h"
 #include "make_unique.h"
 #include "table.h"
@@ -41,17 +45,65 @@ spv_result_t SetSpvInst(void* builder, const spv_parsed_instruction_t* inst) {
   return SPV_ERROR_INVALID_BINARY;
 };
 
+// Materializes every deferred function body in |module|, spreading the
+// functions over at most |num_threads| worker threads.  Each function gets
+// its own body arena first, so the workers never contend on the module
+// arena.
+void MaterializeFunctionsInParallel(ir::Module* module, size_t num_threads) {
+  std::vector<ir::Function*> functions;
+  for (auto& function : *module) {
+    if (function.HasDeferredBody()) functions.push_back(&function);
+  }
+  const size_t num_workers = std::min(num_threads, functions.size());
+  if (num_workers < 2) {
+    for (ir::Function* function : functions) function->MaterializeBody();
+    return;
+  }
+
+  for (ir::Function* function : functions) function->CreateBodyArena();
+
+  // Workers draw function indices from a shared counter, so a worker that
+  // finishes a small function moves on to the next unclaimed one.
+  std::atomic<size_t> next_index(0);
+  std::vector<std::thread> workers;
+  workers.reserve(num_workers);
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers.emplace_back([&functions, &next_index] {
+      for (size_t fi = next_index++; fi < functions.size();
+           fi = next_index++) {
+        functions[fi]->MaterializeBody();
+      }
+    });
+  }
+  for (auto& worker : workers) worker.join();
+}
+
 }  // annoymous namespace
 
 std::unique_ptr<ir::Module> BuildModule(spv_target_env env,
                                         MessageConsumer consumer,
                                         const uint32_t* binary,
-                                        const size_t size) {
+                                        const size_t size,
+                                        bool defer_function_bodies,
+                                        size_t num_threads,
+                                        const spv_allocator_t* allocator) {
   auto context = spvContextCreate(env);
   SetContextMessageConsumer(context, consumer);
 
   auto module = MakeUnique<ir::Module>();
+  // Function body arenas created later copy the module arena's allocator,
+  // so one assignment here covers the whole object graph.
+  if (allocator) module->arena().SetUpstreamAllocator(allocator);
   ir::IrLoader loader(context->consumer, module.get());
+  // Parallel loading reuses the deferred-body machinery: the initial parse
+  // builds only the global section and records per-function word ranges,
+  // which the workers below then build concurrently.
+  const bool parallel_bodies = !defer_function_bodies && num_threads >= 2;
+  if (defer_function_bodies || parallel_bodies) {
+    loader.SetDeferFunctionBodies(env);
+  } else {
+    loader.PreScanFunctionBlockCounts(binary, size);
+  }
 
   spv_result_t status = spvBinaryParse(context, &loader, binary, size,
                                        SetSpvHeader, SetSpvInst, nullptr);
@@ -59,7 +111,11 @@ std::unique_ptr<ir::Module> BuildModule(spv_target_env env,
 
   spvContextDestroy(context);
 
-  return status == SPV_SUCCESS ? std::move(module) : nullptr;
+  if (status != SPV_SUCCESS) return nullptr;
+  if (parallel_bodies) {
+    MaterializeFunctionsInParallel(module.get(), num_threads);
+  }
+  return module;
 }
 
 std::unique_ptr<ir::Module> BuildModule(spv_target_env env,
@@ -27,9 +27,24 @@ namespace spvtools {
 // specifies number of words in |binary|. The |binary| will be decoded
 // according to the given target |env|. Returns nullptr if erors occur and
 // sends the errors to |consumer|.
+//
+// If |defer_function_bodies| is true, function bodies are kept as raw word
+// ranges and only built into IR when first iterated; untouched functions are
+// copied back verbatim by ir::Module::ToBinary.
+//
+// If |num_threads| is two or more (and bodies are not deferred), the global
+// section loads first and worker threads then build the function bodies
+// concurrently, each into its own arena.  Error messages for a malformed
+// function body may then reach |consumer| from a worker thread.
+//
+// If |allocator| is not null, the arenas backing the module's IR objects
+// reserve their chunks through it instead of the global heap; see
+// spv_allocator_t in libspirv.h.  The allocator is copied, and the copies
+// live as long as the module.
 std::unique_ptr<ir::Module> BuildModule(
     spv_target_env env, MessageConsumer consumer, const uint32_t* binary,
-    size_t size);
+    size_t size, bool defer_function_bodies = false, size_t num_threads = 1,
+    const spv_allocator_t* allocator = nullptr);
 
 // Builds and returns an ir::Module from the given SPIR-V assembly |text|.
 // The |text| will be encoded according to the given target |env|. Returns
@@ -0,0 +1,47 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "canonicalize_ids_pass.h"
+
+#include "id_remap.h"
+
+namespace spvtools {
+namespace opt {
+
+Pass::Status CanonicalizeIdsPass::Process(ir::Module* module) {
+  DenseIdRemapper remapper(module->ComputeIdBound());
+
+  // Seed the numbering from the semantic sections only, so that debug
+  // names and annotation order cannot influence it: entry points first,
+  // then types, constants, and module-scope variables in layout order,
+  // then each function's instructions in the order their ids appear.  Two
+  // modules with the same instructions thus number their ids identically
+  // even when their debug info or decoration order differs -- which is
+  // what lets a content-addressed cache deduplicate them.
+  const auto seed = [&remapper](ir::Instruction* inst) {
+    inst->ForEachId([&remapper](uint32_t* id) { remapper.MapId(*id); });
+  };
+  for (auto& inst : module->entry_points()) seed(&inst);
+  for (auto& inst : module->types_values()) seed(&inst);
+  for (auto& func : *module) func.ForEachInst(seed);
+
+  // Rewrite every id operand in the module.  Ids that occur only in the
+  // debug or annotation sections (strings, decoration groups) were not
+  // seeded and so number last, in section order.
+  const bool modified = remapper.ApplyTo(module);
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,175 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cfg.h"
+
+#include <unordered_set>
+#include <utility>
+
+#include "cfa.h"
+#include "make_unique.h"
+#include "reflect.h"
+
+namespace spvtools {
+namespace opt {
+namespace analysis {
+
+FunctionCfg::FunctionCfg(ir::Function* func) {
+  if (func->begin() == func->end()) return;
+  ir::BasicBlock* entry = &*func->begin();
+
+  // Raw successor lists, needed as stable storage for the CFA traversals.
+  std::unordered_map<uint32_t, ir::BasicBlock*> id2block;
+  for (auto& block : *func) id2block[block.id()] = &block;
+  std::unordered_map<const ir::BasicBlock*, std::vector<ir::BasicBlock*>>
+      succs;
+  for (auto& block : *func) {
+    block.ForEachSuccessorLabel([&id2block, &succs, &block](uint32_t sbid) {
+      succs[&block].push_back(id2block[sbid]);
+    });
+  }
+  auto succ_func = [&succs](const ir::BasicBlock* block) {
+    return &succs[block];
+  };
+
+  // Postorder over the reachable blocks; back edges give the loop nest
+  // below.
+  std::vector<const ir::BasicBlock*> postorder;
+  std::vector<std::pair<ir::BasicBlock*, ir::BasicBlock*>> back_edges;
+  CFA<ir::BasicBlock>::DepthFirstTraversal(
+      entry, succ_func, [](const ir::BasicBlock*) {},
+      [&postorder](const ir::BasicBlock* b) { postorder.push_back(b); },
+      [&back_edges, &id2block](const ir::BasicBlock* from,
+                               const ir::BasicBlock* to) {
+        back_edges.push_back(
+            std::make_pair(id2block[from->id()], id2block[to->id()]));
+      });
+  postorder_.reserve(postorder.size());
+  for (const ir::BasicBlock* block : postorder) {
+    index_[block] = static_cast<uint32_t>(postorder_.size());
+    postorder_.push_back(id2block[block->id()]);
+  }
+
+  // Pack the adjacency into CSR form, dropping edges into unreachable
+  // blocks. The offsets are built with the usual two sweeps: count the
+  // degree of every block, turn the counts into offsets, then scatter.
+  const size_t num_blocks = postorder_.size();
+  succ_offsets_.assign(num_blocks + 1, 0);
+  pred_offsets_.assign(num_blocks + 1, 0);
+  for (ir::BasicBlock* block : postorder_) {
+    for (ir::BasicBlock* succ : succs[block]) {
+      if (!index_.count(succ)) continue;
+      ++succ_offsets_[index_[block] + 1];
+      ++pred_offsets_[index_[succ] + 1];
+    }
+  }
+  for (size_t i = 1; i <= num_blocks; ++i) {
+    succ_offsets_[i] += succ_offsets_[i - 1];
+    pred_offsets_[i] += pred_offsets_[i - 1];
+  }
+  succ_edges_.resize(succ_offsets_[num_blocks]);
+  pred_edges_.resize(pred_offsets_[num_blocks]);
+  std::vector<uint32_t> succ_fill(succ_offsets_.begin(),
+                                  succ_offsets_.end() - 1);
+  std::vector<uint32_t> pred_fill(pred_offsets_.begin(),
+                                  pred_offsets_.end() - 1);
+  for (ir::BasicBlock* block : postorder_) {
+    for (ir::BasicBlock* succ : succs[block]) {
+      if (!index_.count(succ)) continue;
+      succ_edges_[succ_fill[index_[block]]++] = succ;
+      pred_edges_[pred_fill[index_[succ]]++] = block;
+    }
+  }
+
+  // Immediate dominators over the reachable blocks.
+  std::unordered_map<const ir::BasicBlock*, std::vector<ir::BasicBlock*>>
+      preds;
+  for (ir::BasicBlock* block : postorder_) {
+    BlockRange range = predecessors(block);
+    preds[block].assign(range.begin(), range.end());
+  }
+  auto pred_func = [&preds](const ir::BasicBlock* block) {
+    return &preds[block];
+  };
+  idom_.resize(num_blocks);
+  for (auto& edge :
+       CFA<ir::BasicBlock>::CalculateDominators(postorder, pred_func)) {
+    idom_[index_[edge.first]] = edge.second;
+  }
+
+  // Natural loops: every back edge (tail, header) closes one, and back
+  // edges sharing a header are merged into a single loop. The body is found
+  // by walking predecessors from the tails until the header.
+  std::unordered_map<const ir::BasicBlock*, size_t> header2loop;
+  std::vector<std::unordered_set<const ir::BasicBlock*>> members;
+  for (const auto& back_edge : back_edges) {
+    ir::BasicBlock* tail = back_edge.first;
+    ir::BasicBlock* header = back_edge.second;
+    if (!index_.count(header) || !index_.count(tail)) continue;
+    auto iter = header2loop.find(header);
+    if (iter == header2loop.end()) {
+      iter = header2loop.insert(std::make_pair(header, loops_.size())).first;
+      loops_.push_back(Loop());
+      loops_.back().header = header;
+      loops_.back().blocks.push_back(header);
+      members.push_back(std::unordered_set<const ir::BasicBlock*>());
+      members.back().insert(header);
+    }
+    Loop& loop = loops_[iter->second];
+    std::unordered_set<const ir::BasicBlock*>& in_loop = members[iter->second];
+    std::vector<ir::BasicBlock*> worklist;
+    if (in_loop.insert(tail).second) {
+      loop.blocks.push_back(tail);
+      worklist.push_back(tail);
+    }
+    while (!worklist.empty()) {
+      ir::BasicBlock* block = worklist.back();
+      worklist.pop_back();
+      for (ir::BasicBlock* pred : predecessors(block)) {
+        if (!in_loop.insert(pred).second) continue;
+        loop.blocks.push_back(pred);
+        worklist.push_back(pred);
+      }
+    }
+  }
+
+  // The loop depth of a block is the number of loops containing it.
+  loop_depth_.assign(num_blocks, 0);
+  for (const Loop& loop : loops_) {
+    for (ir::BasicBlock* block : loop.blocks) ++loop_depth_[index_[block]];
+  }
+}
+
+const FunctionCfg& CfgManager::GetCfg(ir::Function* func) {
+  auto iter = cache_.find(func);
+  if (iter == cache_.end()) {
+    iter = cache_.insert(std::make_pair(
+                             func, MakeUnique<FunctionCfg>(func)))
+               .first;
+  }
+  return *iter->second;
+}
+
+void CfgManager::InvalidateIfCfgChanged(const ir::Instruction* inst) {
+  const SpvOp opcode = inst->opcode();
+  if (opcode == SpvOpLabel || opcode == SpvOpSelectionMerge ||
+      opcode == SpvOpLoopMerge || opcode == SpvOpFunction ||
+      ir::IsTerminatorInst(opcode)) {
+    cache_.clear();
+  }
+}
+
+}  // namespace analysis
+}  // namespace opt
+}  // namespace spvtools
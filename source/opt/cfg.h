@@ -0,0 +1,162 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_CFG_H_
+#define LIBSPIRV_OPT_CFG_H_
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "basic_block.h"
+#include "function.h"
+#include "module.h"
+
+namespace spvtools {
+namespace opt {
+namespace analysis {
+
+// Control flow analysis of a single function: the reachable blocks in
+// postorder, the successor and predecessor adjacency, the immediate
+// dominators, and the loop nesting depth of every block.
+//
+// Adjacency is stored in compressed sparse row form, one offsets array and
+// one contiguous edge array per direction, so walking the neighbours of a
+// block touches consecutive memory and the whole analysis makes a fixed
+// number of allocations regardless of the edge count.
+class FunctionCfg {
+ public:
+  // A view of the neighbours of one block inside the CSR edge array.
+  class BlockRange {
+   public:
+    BlockRange(ir::BasicBlock* const* begin, ir::BasicBlock* const* end)
+        : begin_(begin), end_(end) {}
+    ir::BasicBlock* const* begin() const { return begin_; }
+    ir::BasicBlock* const* end() const { return end_; }
+    size_t size() const { return end_ - begin_; }
+
+   private:
+    ir::BasicBlock* const* begin_;
+    ir::BasicBlock* const* end_;
+  };
+
+  // Builds the analysis for |func|. The function's block structure must not
+  // change while this analysis is alive; CfgManager takes care of that.
+  explicit FunctionCfg(ir::Function* func);
+
+  // The reachable blocks in postorder. The entry block is last.
+  const std::vector<ir::BasicBlock*>& postorder() const { return postorder_; }
+
+  // Returns true if |block| is reachable from the entry block.
+  bool IsReachable(const ir::BasicBlock* block) const {
+    return index_.count(block) != 0;
+  }
+
+  // The successors/predecessors of reachable |block|. Only edges between
+  // reachable blocks are recorded.
+  BlockRange successors(const ir::BasicBlock* block) const {
+    return Range(succ_offsets_, succ_edges_, index_.find(block)->second);
+  }
+  BlockRange predecessors(const ir::BasicBlock* block) const {
+    return Range(pred_offsets_, pred_edges_, index_.find(block)->second);
+  }
+
+  // The immediate dominator of reachable |block|. The entry block is its
+  // own immediate dominator.
+  ir::BasicBlock* ImmediateDominator(const ir::BasicBlock* block) const {
+    return idom_[index_.find(block)->second];
+  }
+
+  // The number of natural loops containing reachable |block|; zero for
+  // straight-line code.
+  uint32_t LoopDepth(const ir::BasicBlock* block) const {
+    return loop_depth_[index_.find(block)->second];
+  }
+
+  // One natural loop: the header together with every block that reaches a
+  // back edge into the header without passing through the header. Back
+  // edges sharing a header describe the same loop.
+  struct Loop {
+    ir::BasicBlock* header;
+    // The member blocks, header first; the rest in discovery order.
+    std::vector<ir::BasicBlock*> blocks;
+  };
+
+  // The natural loops of the function, one entry per loop header. Nested
+  // loops appear as separate entries whose block sets overlap.
+  const std::vector<Loop>& loops() const { return loops_; }
+
+ private:
+  static BlockRange Range(const std::vector<uint32_t>& offsets,
+                          const std::vector<ir::BasicBlock*>& edges,
+                          uint32_t index) {
+    ir::BasicBlock* const* base = edges.empty() ? nullptr : edges.data();
+    return BlockRange(base + offsets[index], base + offsets[index + 1]);
+  }
+
+  // Reachable blocks in postorder; indices below refer to positions here.
+  std::vector<ir::BasicBlock*> postorder_;
+  std::unordered_map<const ir::BasicBlock*, uint32_t> index_;
+  // CSR adjacency: block i's neighbours are edges[offsets[i]..offsets[i+1]).
+  std::vector<uint32_t> succ_offsets_;
+  std::vector<ir::BasicBlock*> succ_edges_;
+  std::vector<uint32_t> pred_offsets_;
+  std::vector<ir::BasicBlock*> pred_edges_;
+  // Immediate dominator and loop depth per block index.
+  std::vector<ir::BasicBlock*> idom_;
+  std::vector<uint32_t> loop_depth_;
+  // The natural loops, one per loop header.
+  std::vector<Loop> loops_;
+};
+
+// Hands out FunctionCfg analyses, computing each function's lazily and
+// caching it for the passes that follow. The manager registers itself as a
+// change listener on the module and drops every cached analysis when an
+// instruction that shapes control flow is inserted or erased, the same way
+// DefUseManager keeps itself current.
+class CfgManager : public ir::IrChangeListener {
+ public:
+  explicit CfgManager(ir::Module* module) : module_(module) {
+    if (module_) module_->RegisterChangeListener(this);
+  }
+
+  ~CfgManager() override {
+    if (module_) module_->UnregisterChangeListener(this);
+  }
+
+  CfgManager(const CfgManager&) = delete;
+  CfgManager& operator=(const CfgManager&) = delete;
+
+  // Returns the analysis for |func|, computing it on first request.
+  const FunctionCfg& GetCfg(ir::Function* func);
+
+  // ir::IrChangeListener hooks. Only instructions that shape the CFG
+  // invalidate the cache; inserting or erasing straight-line instructions
+  // keeps every analysis valid.
+  void OnInsert(ir::Instruction* inst) override { InvalidateIfCfgChanged(inst); }
+  void OnErase(ir::Instruction* inst) override { InvalidateIfCfgChanged(inst); }
+
+ private:
+  void InvalidateIfCfgChanged(const ir::Instruction* inst);
+
+  ir::Module* module_;
+  std::unordered_map<const ir::Function*, std::unique_ptr<FunctionCfg>>
+      cache_;
+};
+
+}  // namespace analysis
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_CFG_H_
@@ -14,42 +14,16 @@
 
 #include "compact_ids_pass.h"
 
-#include <cassert>
-#include <unordered_map>
+#include "id_remap.h"
 
 namespace spvtools {
 namespace opt {
 
-using ir::Instruction;
-using ir::Operand;
-
 Pass::Status CompactIdsPass::Process(ir::Module* module) {
-  bool modified = false;
-  std::unordered_map<uint32_t, uint32_t> result_id_mapping;
-
-  module->ForEachInst([&result_id_mapping, &modified] (Instruction* inst) {
-    auto operand = inst->begin();
-    while (operand != inst->end()) {
-      if (spvIsIdType(operand->type)) {
-        assert(operand->words.size() == 1);
-        uint32_t& id = operand->words[0];
-        auto it = result_id_mapping.find(id);
-        if (it == result_id_mapping.end()) {
-          const uint32_t new_id =
-              static_cast<uint32_t>(result_id_mapping.size()) + 1;
-          const auto insertion_result = result_id_mapping.emplace(id, new_id);
-          it = insertion_result.first;
-          assert(insertion_result.second);
-        }
-        if (id != it->second) {
-          modified = true;
-          id = it->second;
-        }
-      }
-      ++operand;
-    }
-  }, true);
-
+  // Size the flat remap table from the computed bound rather than the header
+  // bound, which an earlier pass may have left stale.
+  DenseIdRemapper remapper(module->ComputeIdBound());
+  const bool modified = remapper.ApplyTo(module);
   return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
 }
 
@@ -0,0 +1,401 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "constant_manager.h"
+
+#include <cassert>
+
+#include "make_unique.h"
+
+namespace spvtools {
+namespace opt {
+namespace analysis {
+
+namespace {
+
+// Combines a hash value into a seed, following boost::hash_combine.
+size_t CombineHash(size_t seed, size_t value) {
+  return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+// A scalar operand value prepared for evaluation.
+struct ScalarValue {
+  uint64_t bits;   // The value, zero-extended to 64 bits.
+  uint32_t width;  // The bit width of the value's type; bools use 1.
+  bool is_bool;
+};
+
+// Returns the given value truncated to the given bit width.
+uint64_t Truncate(uint64_t value, uint32_t width) {
+  if (width >= 64) return value;
+  return value & ((uint64_t(1) << width) - 1);
+}
+
+// Returns the given value sign-extended from the given bit width.
+int64_t SignExtend(uint64_t value, uint32_t width) {
+  if (width >= 64) return static_cast<int64_t>(value);
+  const uint64_t sign_bit = uint64_t(1) << (width - 1);
+  return static_cast<int64_t>((value ^ sign_bit) - sign_bit);
+}
+
+// Extracts the value of the given scalar or null constant.  Returns false if
+// the constant's type is not a bool or a 32- or 64-bit integer.
+bool ExtractScalar(const Constant* c, ScalarValue* out) {
+  const Type* type = c->type();
+  if (type->AsBool()) {
+    out->width = 1;
+    out->is_bool = true;
+  } else if (const Integer* int_type = type->AsInteger()) {
+    if (int_type->width() != 32 && int_type->width() != 64) return false;
+    out->width = int_type->width();
+    out->is_bool = false;
+  } else {
+    return false;
+  }
+  if (c->AsNullConstant()) {
+    out->bits = 0;
+    return true;
+  }
+  const ScalarConstant* scalar = c->AsScalarConstant();
+  if (!scalar) return false;
+  const std::vector<uint32_t>& words = scalar->words();
+  // Literal words are stored low-order word first.
+  out->bits = words.empty() ? 0 : words.front();
+  if (words.size() > 1) out->bits |= uint64_t(words[1]) << 32;
+  return true;
+}
+
+// Extracts the d-th component value of the given vector or null constant.
+// Returns false if the operand is not a vector of foldable scalars.
+bool ExtractComponent(const Constant* c, uint32_t d, ScalarValue* out) {
+  if (const VectorConstant* vec = c->AsVectorConstant()) {
+    if (d >= vec->GetComponents().size()) return false;
+    return ExtractScalar(vec->GetComponents()[d], out);
+  }
+  if (c->AsNullConstant()) {
+    const Vector* vec_type = c->type()->AsVector();
+    if (!vec_type) return false;
+    // A null vector's components are all zero.  Probe the element type by
+    // building a zero value of it.
+    ScalarValue zero = {0, 0, false};
+    if (const Integer* int_type = vec_type->element_type()->AsInteger()) {
+      if (int_type->width() != 32 && int_type->width() != 64) return false;
+      zero.width = int_type->width();
+    } else if (vec_type->element_type()->AsBool()) {
+      zero.width = 1;
+      zero.is_bool = true;
+    } else {
+      return false;
+    }
+    *out = zero;
+    return true;
+  }
+  return false;
+}
+
+// Evaluates the given unary operation.  Returns false if the opcode is not
+// supported.
+bool EvaluateUnary(SpvOp opcode, const ScalarValue& a, uint64_t* out) {
+  switch (opcode) {
+    case SpvOp::SpvOpSNegate:
+      *out = uint64_t(0) - a.bits;
+      return true;
+    case SpvOp::SpvOpNot:
+      *out = ~a.bits;
+      return true;
+    case SpvOp::SpvOpLogicalNot:
+      *out = !a.bits;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Evaluates the given binary operation.  Returns false if the opcode is not
+// supported or the evaluation is undefined, e.g. division by zero.
+bool EvaluateBinary(SpvOp opcode, const ScalarValue& a, const ScalarValue& b,
+                    uint64_t* out) {
+  switch (opcode) {
+    // Arithmetics
+    case SpvOp::SpvOpIAdd:
+      *out = a.bits + b.bits;
+      return true;
+    case SpvOp::SpvOpISub:
+      *out = a.bits - b.bits;
+      return true;
+    case SpvOp::SpvOpIMul:
+      *out = a.bits * b.bits;
+      return true;
+    case SpvOp::SpvOpUDiv:
+      if (b.bits == 0) return false;
+      *out = a.bits / b.bits;
+      return true;
+    case SpvOp::SpvOpSDiv:
+      if (b.bits == 0) return false;
+      *out = uint64_t(SignExtend(a.bits, a.width) / SignExtend(b.bits, b.width));
+      return true;
+    case SpvOp::SpvOpSRem:
+      // The sign of a non-zero result comes from the first operand.  This is
+      // guaranteed by C++11 rules for the integer division operator: the
+      // division result is rounded toward zero, so the result of '%' has the
+      // sign of the first operand.
+      if (b.bits == 0) return false;
+      *out = uint64_t(SignExtend(a.bits, a.width) % SignExtend(b.bits, b.width));
+      return true;
+    case SpvOp::SpvOpSMod: {
+      // The sign of a non-zero result comes from the second operand.
+      if (b.bits == 0) return false;
+      const int64_t rem = SignExtend(a.bits, a.width) % SignExtend(b.bits, b.width);
+      const int64_t b_prim = SignExtend(b.bits, b.width);
+      *out = uint64_t((rem + b_prim) % b_prim);
+      return true;
+    }
+    case SpvOp::SpvOpUMod:
+      if (b.bits == 0) return false;
+      *out = a.bits % b.bits;
+      return true;
+
+    // Shifting
+    case SpvOp::SpvOpShiftRightLogical:
+      if (b.bits >= a.width) return false;
+      *out = a.bits >> b.bits;
+      return true;
+    case SpvOp::SpvOpShiftRightArithmetic:
+      if (b.bits >= a.width) return false;
+      *out = uint64_t(SignExtend(a.bits, a.width) >> b.bits);
+      return true;
+    case SpvOp::SpvOpShiftLeftLogical:
+      if (b.bits >= a.width) return false;
+      *out = a.bits << b.bits;
+      return true;
+
+    // Bitwise operations
+    case SpvOp::SpvOpBitwiseOr:
+      *out = a.bits | b.bits;
+      return true;
+    case SpvOp::SpvOpBitwiseAnd:
+      *out = a.bits & b.bits;
+      return true;
+    case SpvOp::SpvOpBitwiseXor:
+      *out = a.bits ^ b.bits;
+      return true;
+
+    // Logical
+    case SpvOp::SpvOpLogicalEqual:
+      *out = bool(a.bits) == bool(b.bits);
+      return true;
+    case SpvOp::SpvOpLogicalNotEqual:
+      *out = bool(a.bits) != bool(b.bits);
+      return true;
+    case SpvOp::SpvOpLogicalOr:
+      *out = bool(a.bits) || bool(b.bits);
+      return true;
+    case SpvOp::SpvOpLogicalAnd:
+      *out = bool(a.bits) && bool(b.bits);
+      return true;
+
+    // Comparison
+    case SpvOp::SpvOpIEqual:
+      *out = a.bits == b.bits;
+      return true;
+    case SpvOp::SpvOpINotEqual:
+      *out = a.bits != b.bits;
+      return true;
+    case SpvOp::SpvOpULessThan:
+      *out = a.bits < b.bits;
+      return true;
+    case SpvOp::SpvOpSLessThan:
+      *out = SignExtend(a.bits, a.width) < SignExtend(b.bits, b.width);
+      return true;
+    case SpvOp::SpvOpUGreaterThan:
+      *out = a.bits > b.bits;
+      return true;
+    case SpvOp::SpvOpSGreaterThan:
+      *out = SignExtend(a.bits, a.width) > SignExtend(b.bits, b.width);
+      return true;
+    case SpvOp::SpvOpULessThanEqual:
+      *out = a.bits <= b.bits;
+      return true;
+    case SpvOp::SpvOpSLessThanEqual:
+      *out = SignExtend(a.bits, a.width) <= SignExtend(b.bits, b.width);
+      return true;
+    case SpvOp::SpvOpUGreaterThanEqual:
+      *out = a.bits >= b.bits;
+      return true;
+    case SpvOp::SpvOpSGreaterThanEqual:
+      *out = SignExtend(a.bits, a.width) >= SignExtend(b.bits, b.width);
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Evaluates the given ternary operation.  Returns false if the opcode is not
+// supported.
+bool EvaluateTernary(SpvOp opcode, const ScalarValue& a, const ScalarValue& b,
+                     const ScalarValue& c, uint64_t* out) {
+  switch (opcode) {
+    case SpvOp::SpvOpSelect:
+      *out = a.bits ? b.bits : c.bits;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Evaluates the given operation on the given operand values.  Returns false
+// if the opcode, the number of operands or the evaluation itself is not
+// supported.
+bool Evaluate(SpvOp opcode, const std::vector<ScalarValue>& operands,
+              uint64_t* out) {
+  switch (operands.size()) {
+    case 1:
+      return EvaluateUnary(opcode, operands[0], out);
+    case 2:
+      return EvaluateBinary(opcode, operands[0], operands[1], out);
+    case 3:
+      return EvaluateTernary(opcode, operands[0], operands[1], operands[2],
+                             out);
+    default:
+      return false;
+  }
+}
+
+// Builds a scalar constant of the given type holding the given value, which
+// is truncated to the type's width.  Returns nullptr if the type is not a
+// bool or a 32- or 64-bit integer.
+std::unique_ptr<Constant> MakeScalarConstant(const Type* type, uint64_t bits) {
+  if (const Bool* bool_type = type->AsBool()) {
+    return MakeUnique<BoolConstant>(bool_type, bits != 0);
+  }
+  if (const Integer* int_type = type->AsInteger()) {
+    const uint64_t value = Truncate(bits, int_type->width());
+    if (int_type->width() == 32) {
+      return MakeUnique<IntConstant>(
+          int_type, std::vector<uint32_t>{uint32_t(value)});
+    }
+    if (int_type->width() == 64) {
+      // Literal words are stored low-order word first.
+      return MakeUnique<IntConstant>(
+          int_type,
+          std::vector<uint32_t>{uint32_t(value), uint32_t(value >> 32)});
+    }
+  }
+  return nullptr;
+}
+
+}  // anonymous namespace
+
+size_t ConstantManager::ConstantValueHash::operator()(const Constant* c) const {
+  size_t hash = std::hash<const Type*>()(c->type());
+  if (c->AsNullConstant()) {
+    hash = CombineHash(hash, 1);
+  } else if (const ScalarConstant* scalar = c->AsScalarConstant()) {
+    hash = CombineHash(hash, 2);
+    for (uint32_t word : scalar->words()) hash = CombineHash(hash, word);
+  } else if (const CompositeConstant* composite = c->AsCompositeConstant()) {
+    hash = CombineHash(hash, 3);
+    for (const Constant* component : composite->GetComponents())
+      hash = CombineHash(hash, std::hash<const Constant*>()(component));
+  }
+  return hash;
+}
+
+bool ConstantManager::ConstantValueEqual::operator()(const Constant* a,
+                                                     const Constant* b) const {
+  if (a->type() != b->type()) return false;
+  if (a->AsNullConstant()) return b->AsNullConstant() != nullptr;
+  if (const ScalarConstant* sa = a->AsScalarConstant()) {
+    const ScalarConstant* sb = b->AsScalarConstant();
+    return sb && sa->words() == sb->words();
+  }
+  if (const CompositeConstant* ca = a->AsCompositeConstant()) {
+    // Components are canonical, so identity comparison is value comparison.
+    const CompositeConstant* cb = b->AsCompositeConstant();
+    return cb && ca->GetComponents() == cb->GetComponents();
+  }
+  return false;
+}
+
+size_t ConstantManager::FoldKeyHash::operator()(const FoldKey& key) const {
+  size_t hash = CombineHash(std::hash<uint32_t>()(key.opcode),
+                            std::hash<const Type*>()(key.result_type));
+  for (const Constant* operand : key.operands)
+    hash = CombineHash(hash, std::hash<const Constant*>()(operand));
+  return hash;
+}
+
+const Constant* ConstantManager::GetCanonical(std::unique_ptr<Constant> c) {
+  if (!c) return nullptr;
+  auto insertion = unique_constants_.insert(c.get());
+  if (insertion.second) owned_constants_.push_back(std::move(c));
+  return *insertion.first;
+}
+
+const Constant* ConstantManager::FoldScalar(
+    SpvOp opcode, const std::vector<const Constant*>& operands,
+    const Type* result_type) {
+  std::vector<ScalarValue> values(operands.size());
+  for (size_t i = 0; i < operands.size(); ++i) {
+    if (!ExtractScalar(operands[i], &values[i])) return nullptr;
+  }
+  uint64_t result_bits = 0;
+  if (!Evaluate(opcode, values, &result_bits)) return nullptr;
+  return GetCanonical(MakeScalarConstant(result_type, result_bits));
+}
+
+const Constant* ConstantManager::Fold(
+    SpvOp opcode, const std::vector<const Constant*>& operands,
+    const Type* result_type) {
+  FoldKey key = {opcode, result_type, operands};
+  auto cached = fold_results_.find(key);
+  if (cached != fold_results_.end()) return cached->second;
+
+  const Constant* result = nullptr;
+  if (const Vector* vec_type = result_type->AsVector()) {
+    // Component-wise operation over the operand vectors.
+    std::vector<const Constant*> components;
+    components.reserve(vec_type->element_count());
+    for (uint32_t d = 0; d < vec_type->element_count(); ++d) {
+      std::vector<ScalarValue> values(operands.size());
+      for (size_t i = 0; i < operands.size(); ++i) {
+        if (!ExtractComponent(operands[i], d, &values[i])) {
+          fold_results_[std::move(key)] = nullptr;
+          return nullptr;
+        }
+      }
+      uint64_t component_bits = 0;
+      const Constant* component = nullptr;
+      if (Evaluate(opcode, values, &component_bits)) {
+        component = GetCanonical(
+            MakeScalarConstant(vec_type->element_type(), component_bits));
+      }
+      if (!component) {
+        fold_results_[std::move(key)] = nullptr;
+        return nullptr;
+      }
+      components.push_back(component);
+    }
+    result = GetCanonical(
+        MakeUnique<VectorConstant>(vec_type, std::move(components)));
+  } else {
+    result = FoldScalar(opcode, operands, result_type);
+  }
+  fold_results_[std::move(key)] = result;
+  return result;
+}
+
+}  // namespace analysis
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,105 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_CONSTANT_MANAGER_H_
+#define LIBSPIRV_OPT_CONSTANT_MANAGER_H_
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "constants.h"
+#include "types.h"
+
+namespace spvtools {
+namespace opt {
+namespace analysis {
+
+// Owns analysis::Constant instances and hands out one canonical instance per
+// distinct constant value, so structurally equal constants compare equal by
+// pointer.  On top of the canonical instances it evaluates the component-wise
+// operations allowed in OpSpecConstantOp, memoizing each evaluation: a
+// specialization pipeline that folds the same subexpressions across many
+// spec-constant permutations pays for each distinct fold only once.
+//
+// Types are compared by pointer, so constants managed by one instance must be
+// built over types from a single TypeManager (or otherwise pointer-unique
+// types), and composite constants must be built over canonical components.
+class ConstantManager {
+ public:
+  ConstantManager() {}
+
+  ConstantManager(const ConstantManager&) = delete;
+  ConstantManager& operator=(const ConstantManager&) = delete;
+
+  // Returns the canonical instance for the value of |c|, taking ownership of
+  // |c| if it becomes the canonical instance.  Returns nullptr if |c| is
+  // null.
+  const Constant* GetCanonical(std::unique_ptr<Constant> c);
+
+  // Returns the canonical result of performing the given scalar or
+  // component-wise operation on the given canonical |operands|, or nullptr if
+  // the opcode or the operand types are not supported.  The supported result
+  // types are bool, 32- and 64-bit integers, and vectors thereof; null
+  // constant operands evaluate as zero.  Results are memoized, keyed on the
+  // opcode, the operand identities and the result type.
+  const Constant* Fold(SpvOp opcode, const std::vector<const Constant*>& operands,
+                       const Type* result_type);
+
+ private:
+  // Hashes a constant by its value: its type pointer together with its words
+  // for scalars and its component identities for composites.
+  struct ConstantValueHash {
+    size_t operator()(const Constant* c) const;
+  };
+  // Compares two constants by value under the same scheme.
+  struct ConstantValueEqual {
+    bool operator()(const Constant* a, const Constant* b) const;
+  };
+
+  // A memoization key for Fold.
+  struct FoldKey {
+    SpvOp opcode;
+    const Type* result_type;
+    std::vector<const Constant*> operands;
+
+    bool operator==(const FoldKey& that) const {
+      return opcode == that.opcode && result_type == that.result_type &&
+             operands == that.operands;
+    }
+  };
+  struct FoldKeyHash {
+    size_t operator()(const FoldKey& key) const;
+  };
+
+  // Folds one scalar result; |operands| are scalar or null constants.
+  const Constant* FoldScalar(SpvOp opcode,
+                             const std::vector<const Constant*>& operands,
+                             const Type* result_type);
+
+  // Storage for the canonical instances.
+  std::vector<std::unique_ptr<Constant>> owned_constants_;
+  // The canonical instance for each distinct constant value seen so far.
+  std::unordered_set<const Constant*, ConstantValueHash, ConstantValueEqual>
+      unique_constants_;
+  // Memoized fold results.
+  std::unordered_map<FoldKey, const Constant*, FoldKeyHash> fold_results_;
+};
+
+}  // namespace analysis
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_CONSTANT_MANAGER_H_
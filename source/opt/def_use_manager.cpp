@@ -14,6 +14,8 @@
 
 #include "def_use_manager.h"
 
+#include <algorithm>
+
 #include "log.h"
 #include "reflect.h"
 
@@ -38,8 +40,10 @@ void DefUseManager::AnalyzeInstDefUse(ir::Instruction* inst) {
   // Create entry for the given instruction. Note that the instruction may
   // not have any in-operands. In such cases, we still need a entry for those
   // instructions so this manager knows it has seen the instruction later.
-  inst_to_used_ids_[inst] = {};
+  auto& used_ids = inst_to_used_ids_[inst];
+  used_ids.clear();
 
+  const bool is_annotation = ir::IsAnnotationInst(inst->opcode());
   for (uint32_t i = 0; i < inst->NumOperands(); ++i) {
     switch (inst->GetOperand(i).type) {
       // For any id type but result id type
@@ -50,7 +54,8 @@ void DefUseManager::AnalyzeInstDefUse(ir::Instruction* inst) {
         uint32_t use_id = inst->GetSingleWordOperand(i);
         // use_id is used by the instruction generating def_id.
         id_to_uses_[use_id].push_back({inst, i});
-        inst_to_used_ids_[inst].push_back(use_id);
+        if (is_annotation) id_to_annotations_[use_id].push_back(inst);
+        used_ids.push_back(use_id);
       } break;
       default:
         break;
@@ -77,15 +82,19 @@ const UseList* DefUseManager::GetUses(uint32_t id) const {
 }
 
 std::vector<ir::Instruction*> DefUseManager::GetAnnotations(uint32_t id) const {
-  std::vector<ir::Instruction*> annos;
-  const auto* uses = GetUses(id);
-  if (!uses) return annos;
-  for (const auto& c : *uses) {
-    if (ir::IsAnnotationInst(c.inst->opcode())) {
-      annos.push_back(c.inst);
-    }
-  }
-  return annos;
+  const AnnotationList& annos = GetAnnotationSpan(id);
+  return std::vector<ir::Instruction*>(annos.begin(), annos.end());
+}
+
+const DefUseManager::AnnotationList& DefUseManager::GetAnnotationSpan(
+    uint32_t id) const {
+  static const AnnotationList empty;
+  const auto iter = id_to_annotations_.find(id);
+  return iter == id_to_annotations_.end() ? empty : iter->second;
+}
+
+bool DefUseManager::HasAnnotations(uint32_t id) const {
+  return !GetAnnotationSpan(id).empty();
 }
 
 bool DefUseManager::KillDef(uint32_t id) {
@@ -138,13 +147,25 @@ bool DefUseManager::ReplaceAllUsesWith(uint32_t before, uint32_t after) {
     // Register the use of |after| id into id_to_uses_.
     // TODO(antiagainst): de-duplication.
     id_to_uses_[after].push_back({it->inst, it->operand_index});
+    if (ir::IsAnnotationInst(it->inst->opcode())) {
+      id_to_annotations_[after].push_back(it->inst);
+    }
   }
   id_to_uses_.erase(before);
+  id_to_annotations_.erase(before);
   return true;
 }
 
 void DefUseManager::AnalyzeDefUse(ir::Module* module) {
   if (!module) return;
+  // Pre-size the hash maps from the module's id bound and instruction count
+  // so the bulk build below does not rehash repeatedly.
+  const uint32_t id_bound = module->IdBound();
+  id_to_def_.reserve(id_bound);
+  id_to_uses_.reserve(id_bound);
+  size_t num_insts = 0;
+  module->ForEachInst([&num_insts](ir::Instruction*) { ++num_insts; });
+  inst_to_used_ids_.reserve(num_insts);
   module->ForEachInst(std::bind(&DefUseManager::AnalyzeInstDefUse, this,
                                 std::placeholders::_1));
 }
@@ -155,6 +176,7 @@ void DefUseManager::ClearInst(ir::Instruction* inst) {
     EraseUseRecordsOfOperandIds(inst);
     if (inst->result_id() != 0) {
       id_to_uses_.erase(inst->result_id());  // Remove all uses of this id.
+      id_to_annotations_.erase(inst->result_id());
       id_to_def_.erase(inst->result_id());
     }
   }
@@ -165,6 +187,9 @@ void DefUseManager::EraseUseRecordsOfOperandIds(const ir::Instruction* inst) {
   // uses of them.
   auto iter = inst_to_used_ids_.find(inst);
   if (iter != inst_to_used_ids_.end()) {
+    // This runs before KillInst turns |inst| into a Nop, so the opcode still
+    // tells whether the annotation index holds records for it.
+    const bool is_annotation = ir::IsAnnotationInst(inst->opcode());
     for (const auto use_id : iter->second) {
       auto uses_iter = id_to_uses_.find(use_id);
       if (uses_iter == id_to_uses_.end()) continue;
@@ -177,6 +202,14 @@ void DefUseManager::EraseUseRecordsOfOperandIds(const ir::Instruction* inst) {
         }
       }
       if (uses.empty()) id_to_uses_.erase(use_id);
+      if (is_annotation) {
+        auto annos_iter = id_to_annotations_.find(use_id);
+        if (annos_iter == id_to_annotations_.end()) continue;
+        auto& annos = annos_iter->second;
+        annos.erase(std::remove(annos.begin(), annos.end(), inst),
+                    annos.end());
+        if (annos.empty()) id_to_annotations_.erase(use_id);
+      }
     }
     inst_to_used_ids_.erase(inst);
   }
@@ -15,7 +15,6 @@
 #ifndef LIBSPIRV_OPT_DEF_USE_MANAGER_H_
 #define LIBSPIRV_OPT_DEF_USE_MANAGER_H_
 
-#include <list>
 #include <unordered_map>
 #include <vector>
 
@@ -37,10 +36,20 @@ struct Use {
                            // the index of result type id.
 };
 
-using UseList = std::list<Use>;
+// Uses of an id are stored contiguously: iterating a use list touches
+// consecutive memory rather than chasing per-node heap allocations.  Note
+// that growing a use list may invalidate pointers into it, so do not hold on
+// to Use pointers across def-use mutations.
+using UseList = std::vector<Use>;
 
 // A class for analyzing and managing defs and uses in an ir::Module.
-class DefUseManager {
+//
+// The manager registers itself as a change listener on the module, so the
+// analysis stays in sync incrementally while instructions are inserted
+// through the module/function/basic-block mutators or erased through
+// KillDef/KillInst — there is no need to rebuild it between mutations or
+// between passes sharing the same instance.
+class DefUseManager : public ir::IrChangeListener {
  public:
   using IdToDefMap = std::unordered_map<uint32_t, ir::Instruction*>;
   using IdToUsesMap = std::unordered_map<uint32_t, UseList>;
@@ -50,8 +59,13 @@ class DefUseManager {
   // instance only keeps a reference to the |consumer|, so the |consumer| should
   // outlive this instance.
   DefUseManager(const MessageConsumer& consumer, ir::Module* module)
-      : consumer_(consumer) {
+      : consumer_(consumer), module_(module) {
     AnalyzeDefUse(module);
+    if (module_) module_->RegisterChangeListener(this);
+  }
+
+  ~DefUseManager() override {
+    if (module_) module_->UnregisterChangeListener(this);
   }
 
   DefUseManager(const DefUseManager&) = delete;
@@ -59,6 +73,11 @@ class DefUseManager {
   DefUseManager& operator=(const DefUseManager&) = delete;
   DefUseManager& operator=(DefUseManager&&) = delete;
 
+  // ir::IrChangeListener hooks, keeping the analysis current as the IR is
+  // mutated.
+  void OnInsert(ir::Instruction* inst) override { AnalyzeInstDefUse(inst); }
+  void OnErase(ir::Instruction* inst) override { ClearInst(inst); }
+
   // Analyzes the defs and uses in the given |inst|.
   void AnalyzeInstDefUse(ir::Instruction* inst);
 
@@ -69,12 +88,26 @@ class DefUseManager {
   // |id|, returns nullptr.
   UseList* GetUses(uint32_t id);
   const UseList* GetUses(uint32_t id) const;
+  // The annotation instructions directly using one id, in use-registration
+  // order.
+  using AnnotationList = std::vector<ir::Instruction*>;
+
   // Returns the annotation instrunctions which are a direct use of the given
   // |id|. This means when the decorations are applied through decoration
   // group(s), this function will just return the OpGroupDecorate
   // instrcution(s) which refer to the given id as an operand. The OpDecorate
   // instructions which decorate the decoration group will not be returned.
+  // This is a compatibility shim that copies GetAnnotationSpan into a fresh
+  // vector; prefer the span for per-id queries in a loop.
   std::vector<ir::Instruction*> GetAnnotations(uint32_t id) const;
+  // Same as GetAnnotations, but returns a view into the annotation index
+  // kept by this manager: no per-call allocation.  The view is invalidated
+  // by any def-use mutation involving an annotation instruction.
+  const AnnotationList& GetAnnotationSpan(uint32_t id) const;
+  // Returns true if any direct use of the given |id| is an annotation
+  // instruction. Equivalent to !GetAnnotations(id).empty(), without building
+  // the vector.
+  bool HasAnnotations(uint32_t id) const;
 
   // Returns the map from ids to their def instructions.
   const IdToDefMap& id_to_defs() const { return id_to_def_; }
@@ -115,8 +148,12 @@ class DefUseManager {
   void EraseUseRecordsOfOperandIds(const ir::Instruction* inst);
 
   const MessageConsumer& consumer_;  // Message consumer.
+  ir::Module* module_;               // The module being analyzed.
   IdToDefMap id_to_def_;             // Mapping from ids to their definitions
   IdToUsesMap id_to_uses_;           // Mapping from ids to their uses
+  // The annotation uses of each id, maintained alongside id_to_uses_ so
+  // that GetAnnotationSpan answers without filtering or allocating.
+  std::unordered_map<uint32_t, AnnotationList> id_to_annotations_;
   // Mapping from instructions to the ids used in the instructions generating
   // the result ids.
   InstToUsedIdsMap inst_to_used_ids_;
@@ -26,7 +26,7 @@ namespace spvtools {
 namespace opt {
 
 Pass::Status EliminateDeadConstantPass::Process(ir::Module* module) {
-  analysis::DefUseManager def_use(consumer(), module);
+  analysis::DefUseManager& def_use = *analyses(module)->GetDefUse();
   std::unordered_set<ir::Instruction*> working_list;
   // Traverse all the instructions to get the initial set of dead constants as
   // working list and count number of real uses for constants. Uses in
@@ -103,12 +103,12 @@ Pass::Status EliminateDeadConstantPass::Process(ir::Module* module) {
   }
 
   // Turn all dead instructions and uses of them to nop
+  for (auto* da : dead_others) {
+    def_use.KillInst(da);
+  }
   for (auto* dc : dead_consts) {
     def_use.KillDef(dc->result_id());
   }
-  for (auto* da : dead_others) {
-    da->ToNop();
-  }
   return dead_consts.empty() ? Status::SuccessWithoutChange
                              : Status::SuccessWithChange;
 }
@@ -0,0 +1,109 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "eliminate_dead_functions_pass.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+// Operand index of the entry point <id> in OpEntryPoint.
+const uint32_t kEntryPointFunctionIdIndex = 1;
+// Operand index of the callee <id> in OpFunctionCall.
+const uint32_t kFunctionCallFunctionIdIndex = 2;
+// Operand indices of the target <id> and the decoration in OpDecorate.
+const uint32_t kDecorateTargetIdIndex = 0;
+const uint32_t kDecorateDecorationIndex = 1;
+
+// Returns true if |inst| decorates its target as an exported linkage symbol.
+bool IsExportDecoration(const ir::Instruction& inst) {
+  if (inst.opcode() != SpvOpDecorate) return false;
+  if (inst.GetSingleWordOperand(kDecorateDecorationIndex) !=
+      SpvDecorationLinkageAttributes)
+    return false;
+  // The linkage type follows the name string, as the last operand.
+  return inst.GetSingleWordOperand(inst.NumOperands() - 1) ==
+         SpvLinkageTypeExport;
+}
+
+}  // anonymous namespace
+
+Pass::Status EliminateDeadFunctionsPass::Process(ir::Module* module) {
+  std::unordered_map<uint32_t, ir::Function*> id_to_function;
+  for (auto& func : *module) id_to_function[func.result_id()] = &func;
+
+  // Mark the roots: entry point functions and exported functions, which a
+  // later link step may call.
+  std::unordered_set<uint32_t> live;
+  std::vector<ir::Function*> worklist;
+  auto mark = [&id_to_function, &live, &worklist](uint32_t id) {
+    const auto iter = id_to_function.find(id);
+    if (iter != id_to_function.end() && live.insert(id).second)
+      worklist.push_back(iter->second);
+  };
+  for (const auto& inst : module->entry_points())
+    mark(inst.GetSingleWordOperand(kEntryPointFunctionIdIndex));
+  for (const auto& inst : module->annotations()) {
+    if (IsExportDecoration(inst))
+      mark(inst.GetSingleWordOperand(kDecorateTargetIdIndex));
+  }
+
+  // Mark every function reachable from the roots through OpFunctionCall.
+  while (!worklist.empty()) {
+    ir::Function* func = worklist.back();
+    worklist.pop_back();
+    func->ForEachInst([&mark](const ir::Instruction* inst) {
+      if (inst->opcode() == SpvOpFunctionCall)
+        mark(inst->GetSingleWordOperand(kFunctionCallFunctionIdIndex));
+    });
+  }
+
+  if (live.size() == id_to_function.size())
+    return Status::SuccessWithoutChange;
+
+  // Collect every result id defined inside the dead functions, so the names
+  // and decorations that reference them can be swept along with the bodies.
+  std::unordered_set<uint32_t> dead_ids;
+  for (auto& func : *module) {
+    if (live.count(func.result_id())) continue;
+    func.ForEachInst([&dead_ids](const ir::Instruction* inst) {
+      if (inst->result_id() != 0) dead_ids.insert(inst->result_id());
+    });
+  }
+
+  // Drop any debug or annotation instruction referencing a dead id.  A
+  // group decoration listing both live and dead targets is dropped whole;
+  // decoration groups naming function ids do not occur in practice.
+  module->RemoveDebugAndAnnotationsIf(
+      [&dead_ids](const ir::Instruction& inst) {
+        bool references_dead = false;
+        inst.ForEachInId([&dead_ids, &references_dead](const uint32_t* id) {
+          if (dead_ids.count(*id)) references_dead = true;
+        });
+        return references_dead;
+      });
+
+  module->RemoveFunctionsIf([&live](const ir::Function& func) {
+    return live.count(func.result_id()) == 0;
+  });
+  return Status::SuccessWithChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -109,10 +109,14 @@ Pass::Status FlattenDecorationPass::Process(ir::Module* module) {
             operands.push_back(Operand(SPV_OPERAND_TYPE_ID, {target}));
             operands.push_back(
                 Operand(SPV_OPERAND_TYPE_LITERAL_INTEGER, {member}));
-            auto decoration_operands_iter = inst_iter->begin();
-            decoration_operands_iter++;  // Skip the group target.
-            operands.insert(operands.end(), decoration_operands_iter,
-                            inst_iter->end());
+            // Copy the decoration operands following the group target.
+            for (uint32_t operand_index = 1;
+                 operand_index < inst_iter->NumOperands(); ++operand_index) {
+              const auto operand = inst_iter->GetOperand(operand_index);
+              operands.emplace_back(
+                  operand.type, std::vector<uint32_t>(operand.words.begin(),
+                                                      operand.words.end()));
+            }
             std::unique_ptr<Instruction> new_inst(
                 new Instruction(SpvOp::SpvOpMemberDecorate, 0, 0, operands));
             inst_iter = inst_iter.InsertBefore(std::move(new_inst));
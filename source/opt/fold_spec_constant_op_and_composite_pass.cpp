@@ -18,234 +18,18 @@
 #include <initializer_list>
 #include <tuple>
 
+#include "constant_manager.h"
 #include "constants.h"
 #include "make_unique.h"
 
 namespace spvtools {
 namespace opt {
 
-namespace {
-// Returns the single-word result from performing the given unary operation on
-// the operand value which is passed in as a 32-bit word.
-uint32_t UnaryOperate(SpvOp opcode, uint32_t operand) {
-  switch (opcode) {
-    // Arthimetics
-    case SpvOp::SpvOpSNegate:
-      return -static_cast<int32_t>(operand);
-    case SpvOp::SpvOpNot:
-      return ~operand;
-    case SpvOp::SpvOpLogicalNot:
-      return !static_cast<bool>(operand);
-    default:
-      assert(false &&
-             "Unsupported unary operation for OpSpecConstantOp instruction");
-      return 0u;
-  }
-}
-
-// Returns the single-word result from performing the given binary operation on
-// the operand values which are passed in as two 32-bit word.
-uint32_t BinaryOperate(SpvOp opcode, uint32_t a, uint32_t b) {
-  switch (opcode) {
-    // Arthimetics
-    case SpvOp::SpvOpIAdd:
-      return a + b;
-    case SpvOp::SpvOpISub:
-      return a - b;
-    case SpvOp::SpvOpIMul:
-      return a * b;
-    case SpvOp::SpvOpUDiv:
-      assert(b != 0);
-      return a / b;
-    case SpvOp::SpvOpSDiv:
-      assert(b != 0u);
-      return (static_cast<int32_t>(a)) / (static_cast<int32_t>(b));
-    case SpvOp::SpvOpSRem: {
-      // The sign of non-zero result comes from the first operand: a. This is
-      // guaranteed by C++11 rules for integer division operator. The division
-      // result is rounded toward zero, so the result of '%' has the sign of
-      // the first operand.
-      assert(b != 0u);
-      return static_cast<int32_t>(a) % static_cast<int32_t>(b);
-    }
-    case SpvOp::SpvOpSMod: {
-      // The sign of non-zero result comes from the second operand: b
-      assert(b != 0u);
-      int32_t rem = BinaryOperate(SpvOp::SpvOpSRem, a, b);
-      int32_t b_prim = static_cast<int32_t>(b);
-      return (rem + b_prim) % b_prim;
-    }
-    case SpvOp::SpvOpUMod:
-      assert(b != 0u);
-      return (a % b);
-
-    // Shifting
-    case SpvOp::SpvOpShiftRightLogical: {
-      return a >> b;
-    }
-    case SpvOp::SpvOpShiftRightArithmetic:
-      return (static_cast<int32_t>(a)) >> b;
-    case SpvOp::SpvOpShiftLeftLogical:
-      return a << b;
-
-    // Bitwise operations
-    case SpvOp::SpvOpBitwiseOr:
-      return a | b;
-    case SpvOp::SpvOpBitwiseAnd:
-      return a & b;
-    case SpvOp::SpvOpBitwiseXor:
-      return a ^ b;
-
-    // Logical
-    case SpvOp::SpvOpLogicalEqual:
-      return (static_cast<bool>(a)) == (static_cast<bool>(b));
-    case SpvOp::SpvOpLogicalNotEqual:
-      return (static_cast<bool>(a)) != (static_cast<bool>(b));
-    case SpvOp::SpvOpLogicalOr:
-      return (static_cast<bool>(a)) || (static_cast<bool>(b));
-    case SpvOp::SpvOpLogicalAnd:
-      return (static_cast<bool>(a)) && (static_cast<bool>(b));
-
-    // Comparison
-    case SpvOp::SpvOpIEqual:
-      return a == b;
-    case SpvOp::SpvOpINotEqual:
-      return a != b;
-    case SpvOp::SpvOpULessThan:
-      return a < b;
-    case SpvOp::SpvOpSLessThan:
-      return (static_cast<int32_t>(a)) < (static_cast<int32_t>(b));
-    case SpvOp::SpvOpUGreaterThan:
-      return a > b;
-    case SpvOp::SpvOpSGreaterThan:
-      return (static_cast<int32_t>(a)) > (static_cast<int32_t>(b));
-    case SpvOp::SpvOpULessThanEqual:
-      return a <= b;
-    case SpvOp::SpvOpSLessThanEqual:
-      return (static_cast<int32_t>(a)) <= (static_cast<int32_t>(b));
-    case SpvOp::SpvOpUGreaterThanEqual:
-      return a >= b;
-    case SpvOp::SpvOpSGreaterThanEqual:
-      return (static_cast<int32_t>(a)) >= (static_cast<int32_t>(b));
-    default:
-      assert(false &&
-             "Unsupported binary operation for OpSpecConstantOp instruction");
-      return 0u;
-  }
-}
-
-// Returns the single-word result from performing the given ternary operation
-// on the operand values which are passed in as three 32-bit word.
-uint32_t TernaryOperate(SpvOp opcode, uint32_t a, uint32_t b, uint32_t c) {
-  switch (opcode) {
-    case SpvOp::SpvOpSelect:
-      return (static_cast<bool>(a)) ? b : c;
-    default:
-      assert(false &&
-             "Unsupported ternary operation for OpSpecConstantOp instruction");
-      return 0u;
-  }
-}
-
-// Returns the single-word result from performing the given operation on the
-// operand words. This only works with 32-bit operations and uses boolean
-// convention that 0u is false, and anything else is boolean true.
-// TODO(qining): Support operands other than 32-bit wide.
-uint32_t OperateWords(SpvOp opcode,
-                      const std::vector<uint32_t>& operand_words) {
-  switch (operand_words.size()) {
-    case 1:
-      return UnaryOperate(opcode, operand_words.front());
-    case 2:
-      return BinaryOperate(opcode, operand_words.front(), operand_words.back());
-    case 3:
-      return TernaryOperate(opcode, operand_words[0], operand_words[1],
-                            operand_words[2]);
-    default:
-      assert(false && "Invalid number of operands");
-      return 0;
-  }
-}
-
-// Returns the result of performing an operation on scalar constant operands.
-// This function extracts the operand values as 32 bit words and returns the
-// result in 32 bit word. Scalar constants with longer than 32-bit width are
-// not accepted in this function.
-uint32_t OperateScalars(SpvOp opcode,
-                        const std::vector<analysis::Constant*>& operands) {
-  std::vector<uint32_t> operand_values_in_raw_words;
-  for (analysis::Constant* operand : operands) {
-    if (analysis::ScalarConstant* scalar = operand->AsScalarConstant()) {
-      const auto& scalar_words = scalar->words();
-      assert(scalar_words.size() == 1 &&
-             "Scalar constants with longer than 32-bit width are not allowed "
-             "in OperateScalars()");
-      operand_values_in_raw_words.push_back(scalar_words.front());
-    } else if (operand->AsNullConstant()) {
-      operand_values_in_raw_words.push_back(0u);
-    } else {
-      assert(false &&
-             "OperateScalars() only accepts ScalarConst or NullConst type of "
-             "constant");
-    }
-  }
-  return OperateWords(opcode, operand_values_in_raw_words);
-}
-
-// Returns the result of performing an operation over constant vectors. This
-// function iterates through the given vector type constant operands and
-// calculates the result for each element of the result vector to return.
-// Vectors with longer than 32-bit scalar components are not accepted in this
-// function.
-std::vector<uint32_t> OperateVectors(
-    SpvOp opcode, uint32_t num_dims,
-    const std::vector<analysis::Constant*>& operands) {
-  std::vector<uint32_t> result;
-  for (uint32_t d = 0; d < num_dims; d++) {
-    std::vector<uint32_t> operand_values_for_one_dimension;
-    for (analysis::Constant* operand : operands) {
-      if (analysis::VectorConstant* vector_operand =
-              operand->AsVectorConstant()) {
-        // Extract the raw value of the scalar component constants
-        // in 32-bit words here. The reason of not using OperateScalars() here
-        // is that we do not create temporary null constants as components
-        // when the vector operand is a NullConstant because Constant creation
-        // may need extra checks for the validity and that is not manageed in
-        // here.
-        if (const analysis::ScalarConstant* scalar_component =
-                vector_operand->GetComponents().at(d)->AsScalarConstant()) {
-          const auto& scalar_words = scalar_component->words();
-          assert(
-              scalar_words.size() == 1 &&
-              "Vector components with longer than 32-bit width are not allowed "
-              "in OperateVectors()");
-          operand_values_for_one_dimension.push_back(scalar_words.front());
-        } else if (operand->AsNullConstant()) {
-          operand_values_for_one_dimension.push_back(0u);
-        } else {
-          assert(false &&
-                 "VectorConst should only has ScalarConst or NullConst as "
-                 "components");
-        }
-      } else if (operand->AsNullConstant()) {
-        operand_values_for_one_dimension.push_back(0u);
-      } else {
-        assert(false &&
-               "OperateVectors() only accepts VectorConst or NullConst type of "
-               "constant");
-      }
-    }
-    result.push_back(OperateWords(opcode, operand_values_for_one_dimension));
-  }
-  return result;
-}
-}  // anonymous namespace
-
 FoldSpecConstantOpAndCompositePass::FoldSpecConstantOpAndCompositePass()
-    : max_id_(0),
-      module_(nullptr),
+    : module_(nullptr),
       def_use_mgr_(nullptr),
       type_mgr_(nullptr),
+      const_mgr_(nullptr),
       id_to_const_val_() {}
 
 Pass::Status FoldSpecConstantOpAndCompositePass::Process(ir::Module* module) {
@@ -254,11 +38,9 @@ Pass::Status FoldSpecConstantOpAndCompositePass::Process(ir::Module* module) {
 }
 
 void FoldSpecConstantOpAndCompositePass::Initialize(ir::Module* module) {
-  type_mgr_.reset(new analysis::TypeManager(consumer(), *module));
-  def_use_mgr_.reset(new analysis::DefUseManager(consumer(), module));
-  for (const auto& id_def : def_use_mgr_->id_to_defs()) {
-    max_id_ = std::max(max_id_, id_def.first);
-  }
+  type_mgr_ = analyses(module)->GetTypes();
+  def_use_mgr_ = analyses(module)->GetDefUse();
+  const_mgr_ = analyses(module)->GetConstants();
   module_ = module;
 };
 
@@ -320,8 +102,8 @@ Pass::Status FoldSpecConstantOpAndCompositePass::ProcessImpl(
             inst->SetOpcode(SpvOp::SpvOpConstantComposite);
             modified = true;
           }
-          const_val_to_id_[const_value.get()] = inst->result_id();
-          id_to_const_val_[inst->result_id()] = std::move(const_value);
+          const_val_to_id_[const_value] = inst->result_id();
+          id_to_const_val_[inst->result_id()] = const_value;
         }
         break;
       }
@@ -395,7 +177,7 @@ ir::Instruction* FoldSpecConstantOpAndCompositePass::DoCompositeExtract(
 
   // Note that for OpSpecConstantOp, the second in-operand is the first id
   // operand. The first in-operand is the spec opcode.
-  analysis::Constant* first_operand_const =
+  const analysis::Constant* first_operand_const =
       FindRecordedConst(inst->GetSingleWordInOperand(1));
   if (!first_operand_const) return nullptr;
 
@@ -419,7 +201,7 @@ ir::Instruction* FoldSpecConstantOpAndCompositePass::DoCompositeExtract(
       return nullptr;
     }
   }
-  return BuildInstructionAndAddToModule(current_const->Copy(), pos);
+  return BuildInstructionAndAddToModule(current_const, pos);
 }
 
 ir::Instruction* FoldSpecConstantOpAndCompositePass::DoVectorShuffle(
@@ -432,10 +214,9 @@ ir::Instruction* FoldSpecConstantOpAndCompositePass::DoVectorShuffle(
   assert(result_vec_type &&
          "The result of VectorShuffle must be of type vector");
 
-  // A temporary null constants that can be used as the components fo the
-  // result vector. This is needed when any one of the vector operands are null
-  // constant.
-  std::unique_ptr<analysis::Constant> null_component_constants;
+  // A null constant that can be used as the components of the result vector.
+  // This is needed when any one of the vector operands are null constant.
+  const analysis::Constant* null_component_constants = nullptr;
 
   // Get a concatenated vector of scalar constants. The vector should be built
   // with the components from the first and the second operand of VectorShuffle.
@@ -446,12 +227,12 @@ ir::Instruction* FoldSpecConstantOpAndCompositePass::DoVectorShuffle(
     assert(inst->GetInOperand(i).type == SPV_OPERAND_TYPE_ID &&
            "The vector operand must have a SPV_OPERAND_TYPE_ID type");
     uint32_t operand_id = inst->GetSingleWordInOperand(i);
-    analysis::Constant* operand_const = FindRecordedConst(operand_id);
+    const analysis::Constant* operand_const = FindRecordedConst(operand_id);
     if (!operand_const) return nullptr;
     const analysis::Type* operand_type = operand_const->type();
     assert(operand_type->AsVector() &&
            "The first two operand of VectorShuffle must be of vector type");
-    if (analysis::VectorConstant* vec_const =
+    if (const analysis::VectorConstant* vec_const =
             operand_const->AsVectorConstant()) {
       // case 1: current operand is a non-null vector constant.
       concatenated_components.insert(concatenated_components.end(),
@@ -469,7 +250,7 @@ ir::Instruction* FoldSpecConstantOpAndCompositePass::DoVectorShuffle(
       // vector.
       concatenated_components.insert(concatenated_components.end(),
                                      operand_type->AsVector()->element_count(),
-                                     null_component_constants.get());
+                                     null_component_constants);
     } else {
       // no other valid cases
       return nullptr;
@@ -479,7 +260,7 @@ ir::Instruction* FoldSpecConstantOpAndCompositePass::DoVectorShuffle(
   // must be added to the module before the dependee composite constants to
   // satisfy SSA def-use dominance.
   if (null_component_constants) {
-    BuildInstructionAndAddToModule(std::move(null_component_constants), pos);
+    BuildInstructionAndAddToModule(null_component_constants, pos);
   }
   // Create the new vector constant with the selected components.
   std::vector<const analysis::Constant*> selected_components;
@@ -491,29 +272,30 @@ ir::Instruction* FoldSpecConstantOpAndCompositePass::DoVectorShuffle(
            "Literal index out of bound of the concatenated vector");
     selected_components.push_back(concatenated_components[literal]);
   }
-  auto new_vec_const = MakeUnique<analysis::VectorConstant>(
-      result_vec_type, selected_components);
-  return BuildInstructionAndAddToModule(std::move(new_vec_const), pos);
+  const analysis::Constant* new_vec_const =
+      const_mgr_->GetCanonical(MakeUnique<analysis::VectorConstant>(
+          result_vec_type, std::move(selected_components)));
+  return BuildInstructionAndAddToModule(new_vec_const, pos);
 }
 
 namespace {
 // A helper function to check the type for component wise operations. Returns
 // true if the type:
 //  1) is bool type;
-//  2) is 32-bit int type;
+//  2) is 32-bit or 64-bit int type;
 //  3) is vector of bool type;
-//  4) is vector of 32-bit integer type.
+//  4) is vector of 32-bit or 64-bit integer type.
 // Otherwise returns false.
 bool IsValidTypeForComponentWiseOperation(const analysis::Type* type) {
   if (type->AsBool()) {
     return true;
   } else if (auto* it = type->AsInteger()) {
-    if (it->width() == 32) return true;
+    if (it->width() == 32 || it->width() == 64) return true;
   } else if (auto* vt = type->AsVector()) {
     if (vt->element_type()->AsBool())
       return true;
     else if (auto* vit = vt->element_type()->AsInteger()) {
-      if (vit->width() == 32) return true;
+      if (vit->width() == 32 || vit->width() == 64) return true;
     }
   }
   return false;
@@ -526,15 +308,15 @@ ir::Instruction* FoldSpecConstantOpAndCompositePass::DoComponentWiseOperation(
   const analysis::Type* result_type = GetType(inst);
   SpvOp spec_opcode = static_cast<SpvOp>(inst->GetSingleWordInOperand(0));
   // Check and collect operands.
-  std::vector<analysis::Constant*> operands;
+  std::vector<const analysis::Constant*> operands;
 
   if (!std::all_of(inst->cbegin(), inst->cend(),
-                   [&operands, this](const ir::Operand& o) {
+                   [&operands, this](const ir::OperandRef& o) {
                      // skip the operands that is not an id.
                      if (o.type != spv_operand_type_t::SPV_OPERAND_TYPE_ID)
                        return true;
                      uint32_t id = o.words.front();
-                     if (analysis::Constant* c = FindRecordedConst(id)) {
+                     if (const analysis::Constant* c = FindRecordedConst(id)) {
                        if (IsValidTypeForComponentWiseOperation(c->type())) {
                          operands.push_back(c);
                          return true;
@@ -544,50 +326,35 @@ ir::Instruction* FoldSpecConstantOpAndCompositePass::DoComponentWiseOperation(
                    }))
     return nullptr;
 
-  if (result_type->AsInteger() || result_type->AsBool()) {
-    // Scalar operation
-    uint32_t result_val = OperateScalars(spec_opcode, operands);
-    auto result_const = CreateConst(result_type, {result_val});
-    return BuildInstructionAndAddToModule(std::move(result_const), pos);
-  } else if (result_type->AsVector()) {
-    // Vector operation
-    const analysis::Type* element_type =
-        result_type->AsVector()->element_type();
-    uint32_t num_dims = result_type->AsVector()->element_count();
-    std::vector<uint32_t> result_vec =
-        OperateVectors(spec_opcode, num_dims, operands);
-    std::vector<const analysis::Constant*> result_vector_components;
-    for (uint32_t r : result_vec) {
-      if (auto rc = CreateConst(element_type, {r})) {
-        result_vector_components.push_back(rc.get());
-        if (!BuildInstructionAndAddToModule(std::move(rc), pos)) {
-          assert(false &&
-                 "Failed to build and insert constant declaring instruction "
-                 "for the given vector component constant");
-        }
-      } else {
-        assert(false && "Failed to create constants with 32-bit word");
+  // The constant manager memoizes the evaluation, so folding the same
+  // subexpression again across spec-constant permutations is a lookup.
+  const analysis::Constant* folded =
+      const_mgr_->Fold(spec_opcode, operands, result_type);
+  if (!folded) return nullptr;
+
+  if (const analysis::VectorConstant* folded_vec =
+          folded->AsVectorConstant()) {
+    // The component constants must be added to the module before the
+    // dependee composite constant to satisfy SSA def-use dominance.
+    for (const analysis::Constant* component : folded_vec->GetComponents()) {
+      if (!BuildInstructionAndAddToModule(component, pos)) {
+        assert(false &&
+               "Failed to build and insert constant declaring instruction "
+               "for the given vector component constant");
+        return nullptr;
       }
     }
-    auto new_vec_const = MakeUnique<analysis::VectorConstant>(
-        result_type->AsVector(), result_vector_components);
-    return BuildInstructionAndAddToModule(std::move(new_vec_const), pos);
-  } else {
-    // Cannot process invalid component wise operation. The result of component
-    // wise operation must be of integer or bool scalar or vector of
-    // integer/bool type.
-    return nullptr;
   }
+  return BuildInstructionAndAddToModule(folded, pos);
 }
 
 ir::Instruction*
 FoldSpecConstantOpAndCompositePass::BuildInstructionAndAddToModule(
-    std::unique_ptr<analysis::Constant> c, ir::Module::inst_iterator* pos) {
-  analysis::Constant* new_const = c.get();
-  uint32_t new_id = ++max_id_;
-  module_->SetIdBound(new_id + 1);
+    const analysis::Constant* new_const, ir::Module::inst_iterator* pos) {
+  uint32_t new_id = module_->id_allocator().TakeNextId();
+  module_->FinalizeIdBound();
   const_val_to_id_[new_const] = new_id;
-  id_to_const_val_[new_id] = std::move(c);
+  id_to_const_val_[new_id] = new_const;
   auto new_inst = CreateInstruction(new_id, new_const);
   if (!new_inst) return nullptr;
   auto* new_inst_ptr = new_inst.get();
@@ -597,10 +364,9 @@ FoldSpecConstantOpAndCompositePass::BuildInstructionAndAddToModule(
   return new_inst_ptr;
 }
 
-std::unique_ptr<analysis::Constant>
+const analysis::Constant*
 FoldSpecConstantOpAndCompositePass::CreateConstFromInst(ir::Instruction* inst) {
   std::vector<uint32_t> literal_words_or_ids;
-  std::unique_ptr<analysis::Constant> new_const;
   // Collect the constant defining literals or component ids.
   for (uint32_t i = 0; i < inst->NumInOperands(); i++) {
     literal_words_or_ids.insert(literal_words_or_ids.end(),
@@ -627,13 +393,13 @@ FoldSpecConstantOpAndCompositePass::CreateConstFromInst(ir::Instruction* inst) {
   return CreateConst(GetType(inst), literal_words_or_ids);
 }
 
-analysis::Constant* FoldSpecConstantOpAndCompositePass::FindRecordedConst(
+const analysis::Constant* FoldSpecConstantOpAndCompositePass::FindRecordedConst(
     uint32_t id) {
   auto iter = id_to_const_val_.find(id);
   if (iter == id_to_const_val_.end()) {
     return nullptr;
   } else {
-    return iter->second.get();
+    return iter->second;
   }
 }
 
@@ -652,7 +418,7 @@ FoldSpecConstantOpAndCompositePass::GetConstsFromIds(
     const std::vector<uint32_t>& ids) {
   std::vector<const analysis::Constant*> constants;
   for (uint32_t id : ids) {
-    if (analysis::Constant* c = FindRecordedConst(id)) {
+    if (const analysis::Constant* c = FindRecordedConst(id)) {
       constants.push_back(c);
     } else {
       return {};
@@ -661,22 +427,23 @@ FoldSpecConstantOpAndCompositePass::GetConstsFromIds(
   return constants;
 }
 
-std::unique_ptr<analysis::Constant>
-FoldSpecConstantOpAndCompositePass::CreateConst(
+const analysis::Constant* FoldSpecConstantOpAndCompositePass::CreateConst(
     const analysis::Type* type,
     const std::vector<uint32_t>& literal_words_or_ids) {
-  std::unique_ptr<analysis::Constant> new_const;
   if (literal_words_or_ids.size() == 0) {
     // Constant declared with OpConstantNull
-    return MakeUnique<analysis::NullConstant>(type);
+    return const_mgr_->GetCanonical(MakeUnique<analysis::NullConstant>(type));
   } else if (auto* bt = type->AsBool()) {
     assert(literal_words_or_ids.size() == 1 &&
            "Bool constant should be declared with one operand");
-    return MakeUnique<analysis::BoolConstant>(bt, literal_words_or_ids.front());
+    return const_mgr_->GetCanonical(
+        MakeUnique<analysis::BoolConstant>(bt, literal_words_or_ids.front()));
   } else if (auto* it = type->AsInteger()) {
-    return MakeUnique<analysis::IntConstant>(it, literal_words_or_ids);
+    return const_mgr_->GetCanonical(
+        MakeUnique<analysis::IntConstant>(it, literal_words_or_ids));
   } else if (auto* ft = type->AsFloat()) {
-    return MakeUnique<analysis::FloatConstant>(ft, literal_words_or_ids);
+    return const_mgr_->GetCanonical(
+        MakeUnique<analysis::FloatConstant>(ft, literal_words_or_ids));
   } else if (auto* vt = type->AsVector()) {
     auto components = GetConstsFromIds(literal_words_or_ids);
     if (components.empty()) return nullptr;
@@ -699,15 +466,18 @@ FoldSpecConstantOpAndCompositePass::CreateConst(
                        return false;
                      }))
       return nullptr;
-    return MakeUnique<analysis::VectorConstant>(vt, components);
+    return const_mgr_->GetCanonical(
+        MakeUnique<analysis::VectorConstant>(vt, components));
   } else if (auto* st = type->AsStruct()) {
     auto components = GetConstsFromIds(literal_words_or_ids);
     if (components.empty()) return nullptr;
-    return MakeUnique<analysis::StructConstant>(st, components);
+    return const_mgr_->GetCanonical(
+        MakeUnique<analysis::StructConstant>(st, components));
   } else if (auto* at = type->AsArray()) {
     auto components = GetConstsFromIds(literal_words_or_ids);
     if (components.empty()) return nullptr;
-    return MakeUnique<analysis::ArrayConstant>(at, components);
+    return const_mgr_->GetCanonical(
+        MakeUnique<analysis::ArrayConstant>(at, components));
   } else {
     return nullptr;
   }
@@ -724,29 +494,29 @@ std::vector<ir::Operand> BuildOperandsFromIds(
 }
 
 std::unique_ptr<ir::Instruction>
-FoldSpecConstantOpAndCompositePass::CreateInstruction(uint32_t id,
-                                                      analysis::Constant* c) {
+FoldSpecConstantOpAndCompositePass::CreateInstruction(
+    uint32_t id, const analysis::Constant* c) {
   if (c->AsNullConstant()) {
     return MakeUnique<ir::Instruction>(SpvOp::SpvOpConstantNull,
                                        type_mgr_->GetId(c->type()), id,
                                        std::initializer_list<ir::Operand>{});
-  } else if (analysis::BoolConstant* bc = c->AsBoolConstant()) {
+  } else if (const analysis::BoolConstant* bc = c->AsBoolConstant()) {
     return MakeUnique<ir::Instruction>(
         bc->value() ? SpvOp::SpvOpConstantTrue : SpvOp::SpvOpConstantFalse,
         type_mgr_->GetId(c->type()), id, std::initializer_list<ir::Operand>{});
-  } else if (analysis::IntConstant* ic = c->AsIntConstant()) {
+  } else if (const analysis::IntConstant* ic = c->AsIntConstant()) {
     return MakeUnique<ir::Instruction>(
         SpvOp::SpvOpConstant, type_mgr_->GetId(c->type()), id,
         std::initializer_list<ir::Operand>{ir::Operand(
             spv_operand_type_t::SPV_OPERAND_TYPE_TYPED_LITERAL_NUMBER,
             ic->words())});
-  } else if (analysis::FloatConstant* fc = c->AsFloatConstant()) {
+  } else if (const analysis::FloatConstant* fc = c->AsFloatConstant()) {
     return MakeUnique<ir::Instruction>(
         SpvOp::SpvOpConstant, type_mgr_->GetId(c->type()), id,
         std::initializer_list<ir::Operand>{ir::Operand(
             spv_operand_type_t::SPV_OPERAND_TYPE_TYPED_LITERAL_NUMBER,
             fc->words())});
-  } else if (analysis::CompositeConstant* cc = c->AsCompositeConstant()) {
+  } else if (const analysis::CompositeConstant* cc = c->AsCompositeConstant()) {
     return CreateCompositeInstruction(id, cc);
   } else {
     return nullptr;
@@ -755,7 +525,7 @@ FoldSpecConstantOpAndCompositePass::CreateInstruction(uint32_t id,
 
 std::unique_ptr<ir::Instruction>
 FoldSpecConstantOpAndCompositePass::CreateCompositeInstruction(
-    uint32_t result_id, analysis::CompositeConstant* cc) {
+    uint32_t result_id, const analysis::CompositeConstant* cc) {
   std::vector<ir::Operand> operands;
   for (const analysis::Constant* component_const : cc->GetComponents()) {
     uint32_t id = FindRecordedConst(component_const);
@@ -19,6 +19,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "constant_manager.h"
 #include "constants.h"
 #include "def_use_manager.h"
 #include "module.h"
@@ -37,6 +38,13 @@ class FoldSpecConstantOpAndCompositePass : public Pass {
 
   Status Process(ir::Module* module) override;
 
+  // Newly inserted constants are analyzed into DefUseManager explicitly and
+  // removals go through it; control flow and types are untouched, and the
+  // constant manager only gains canonical instances.
+  uint32_t GetPreservedAnalyses() const override {
+    return AnalysisManager::kAnalysisAll;
+  }
+
  private:
   // Initializes the type manager, def-use manager and get the maximal id used
   // in the module.
@@ -79,37 +87,36 @@ class FoldSpecConstantOpAndCompositePass : public Pass {
   ir::Instruction* DoComponentWiseOperation(
       ir::Module::inst_iterator* inst_iter_ptr);
 
-  // Creates a constant defining instruction for the given Constant instance
-  // and inserts the instruction at the position specified by the given
-  // instruction iterator. Returns a pointer to the created instruction if
-  // succeeded, otherwise returns a null pointer. The instruction iterator
+  // Creates a constant defining instruction for the given canonical Constant
+  // instance and inserts the instruction at the position specified by the
+  // given instruction iterator. Returns a pointer to the created instruction
+  // if succeeded, otherwise returns a null pointer. The instruction iterator
   // points to the same instruction before and after the insertion. This is the
   // only method that actually manages id creation/assignment and instruction
   // creation/insertion for a new Constant instance.
   ir::Instruction* BuildInstructionAndAddToModule(
-      std::unique_ptr<analysis::Constant> c, ir::Module::inst_iterator* pos);
-
-  // Creates a Constant instance to hold the constant value of the given
-  // instruction. If the given instruction defines a normal constants whose
-  // value is already known in the module, returns the unique pointer to the
-  // created Constant instance. Otherwise does not create anything and returns a
-  // nullptr.
-  std::unique_ptr<analysis::Constant> CreateConstFromInst(
-      ir::Instruction* inst);
-
-  // Creates a Constant instance with the given type and a vector of constant
-  // defining words. Returns an unique pointer to the created Constant instance
-  // if the Constant instance can be created successfully. To create scalar
-  // type constants, the vector should contain the constant value in 32 bit
-  // words and the given type must be of type Bool, Integer or Float. To create
-  // composite type constants, the vector should contain the component ids, and
-  // those component ids should have been recorded before as Normal Constants.
-  // And the given type must be of type Struct, Vector or Array. When creating
-  // VectorType Constant instance, the components must be scalars of the same
-  // type, either Bool, Integer or Float. If any of the rules above failed, the
-  // creation will fail and nullptr will be returned. If the vector is empty,
-  // a NullConstant instance will be created with the given type.
-  std::unique_ptr<analysis::Constant> CreateConst(
+      const analysis::Constant* c, ir::Module::inst_iterator* pos);
+
+  // Creates a canonical Constant instance to hold the constant value of the
+  // given instruction. If the given instruction defines a normal constants
+  // whose value is already known in the module, returns the pointer to the
+  // canonical Constant instance. Otherwise does not create anything and
+  // returns a nullptr.
+  const analysis::Constant* CreateConstFromInst(ir::Instruction* inst);
+
+  // Creates a canonical Constant instance with the given type and a vector of
+  // constant defining words. Returns a pointer to the canonical Constant
+  // instance if the Constant instance can be created successfully. To create
+  // scalar type constants, the vector should contain the constant value in 32
+  // bit words and the given type must be of type Bool, Integer or Float. To
+  // create composite type constants, the vector should contain the component
+  // ids, and those component ids should have been recorded before as Normal
+  // Constants. And the given type must be of type Struct, Vector or Array.
+  // When creating VectorType Constant instance, the components must be scalars
+  // of the same type, either Bool, Integer or Float. If any of the rules above
+  // failed, the creation will fail and nullptr will be returned. If the vector
+  // is empty, a NullConstant instance will be created with the given type.
+  const analysis::Constant* CreateConst(
       const analysis::Type* type,
       const std::vector<uint32_t>& literal_words_or_ids);
 
@@ -118,19 +125,19 @@ class FoldSpecConstantOpAndCompositePass : public Pass {
   // the created instruction if the instruction can be created successfully.
   // Otherwise, returns a null pointer.
   std::unique_ptr<ir::Instruction> CreateInstruction(uint32_t result_id,
-                                                     analysis::Constant* c);
+                                                     const analysis::Constant* c);
 
   // Creates an OpConstantComposite instruction with the given result id and
   // the CompositeConst instance which represents a composite constant. Returns
   // an unique pointer to the created instruction if succeeded. Otherwise
   // returns a null pointer.
   std::unique_ptr<ir::Instruction> CreateCompositeInstruction(
-      uint32_t result_id, analysis::CompositeConstant* cc);
+      uint32_t result_id, const analysis::CompositeConstant* cc);
 
   // A helper function to get the collected normal constant with the given id.
-  // Returns the pointer to the Constant instance in case it is found.
-  // Otherwise, returns null pointer.
-  analysis::Constant* FindRecordedConst(uint32_t id);
+  // Returns the pointer to the canonical Constant instance in case it is
+  // found. Otherwise, returns null pointer.
+  const analysis::Constant* FindRecordedConst(uint32_t id);
   // A helper function to get the id of a collected constant with the pointer
   // to the Constant instance. Returns 0 in case the constant is not found.
   uint32_t FindRecordedConst(const analysis::Constant* c);
@@ -147,25 +154,28 @@ class FoldSpecConstantOpAndCompositePass : public Pass {
     return type_mgr_->GetType(inst->type_id());
   }
 
-  // The maximum used ID.
-  uint32_t max_id_;
   // A pointer to the module under process.
   ir::Module* module_;
+  // The analyses below are owned by the AnalysisManager and fetched anew for
+  // every processed module.
   // DefUse manager
-  std::unique_ptr<analysis::DefUseManager> def_use_mgr_;
+  analysis::DefUseManager* def_use_mgr_;
   // Type manager
-  std::unique_ptr<analysis::TypeManager> type_mgr_;
+  analysis::TypeManager* type_mgr_;
+  // Constant manager. Owns the analysis::Constant instances and memoizes the
+  // folding of component-wise operations across the whole run.
+  analysis::ConstantManager* const_mgr_;
 
-  // A mapping from the result ids of Normal Constants to their
+  // A mapping from the result ids of Normal Constants to their canonical
   // analysis::Constant instances. All Normal Constants in the module, either
   // existing ones before optimization or the newly generated ones, should have
   // their Constant instance stored and their result id registered in this map.
-  std::unordered_map<uint32_t, std::unique_ptr<analysis::Constant>>
-      id_to_const_val_;
+  std::unordered_map<uint32_t, const analysis::Constant*> id_to_const_val_;
   // A mapping from the analsis::Constant instance of Normal Contants to their
-  // result id in the module. This is a mirror map of id_to_const_val_. All
-  // Normal Constants that defining instructions in the module should have
-  // their analysis::Constant and their result id registered here.
+  // result id in the module. This is a mirror map of id_to_const_val_. As the
+  // Constant instances are canonical, a value declared by several ids maps to
+  // the most recently registered one, whose definition always precedes the
+  // instructions folded after its registration.
   std::unordered_map<const analysis::Constant*, uint32_t> const_val_to_id_;
 };
 
@@ -17,34 +17,28 @@
 namespace spvtools {
 namespace opt {
 
-Pass::Status FreezeSpecConstantValuePass::Process(ir::Module* module) {
-  bool modified = false;
-  module->ForEachInst([&modified](ir::Instruction* inst) {
-    switch (inst->opcode()) {
-      case SpvOp::SpvOpSpecConstant:
-        inst->SetOpcode(SpvOp::SpvOpConstant);
-        modified = true;
-        break;
-      case SpvOp::SpvOpSpecConstantTrue:
-        inst->SetOpcode(SpvOp::SpvOpConstantTrue);
-        modified = true;
-        break;
-      case SpvOp::SpvOpSpecConstantFalse:
-        inst->SetOpcode(SpvOp::SpvOpConstantFalse);
-        modified = true;
-        break;
-      case SpvOp::SpvOpDecorate:
-        if (inst->GetSingleWordInOperand(1) ==
-            SpvDecoration::SpvDecorationSpecId) {
-          inst->ToNop();
-          modified = true;
-        }
-        break;
-      default:
-        break;
-    }
-  });
-  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+bool FreezeSpecConstantValuePass::VisitInst(ir::Instruction* inst) {
+  switch (inst->opcode()) {
+    case SpvOp::SpvOpSpecConstant:
+      inst->SetOpcode(SpvOp::SpvOpConstant);
+      return true;
+    case SpvOp::SpvOpSpecConstantTrue:
+      inst->SetOpcode(SpvOp::SpvOpConstantTrue);
+      return true;
+    case SpvOp::SpvOpSpecConstantFalse:
+      inst->SetOpcode(SpvOp::SpvOpConstantFalse);
+      return true;
+    case SpvOp::SpvOpDecorate:
+      if (inst->GetSingleWordInOperand(1) ==
+          SpvDecoration::SpvDecorationSpecId) {
+        inst->ToNop();
+        return true;
+      }
+      break;
+    default:
+      break;
+  }
+  return false;
 }
 
 }  // namespace opt
@@ -22,10 +22,10 @@ namespace spvtools {
 namespace opt {
 
 // See optimizer.hpp for documentation.
-class FreezeSpecConstantValuePass : public Pass {
+class FreezeSpecConstantValuePass : public InstVisitorPass {
  public:
   const char* name() const override { return "freeze-spec-const"; }
-  Status Process(ir::Module*) override;
+  bool VisitInst(ir::Instruction* inst) override;
 };
 
 }  // namespace opt
@@ -14,41 +14,72 @@
 
 #include "function.h"
 
+#include "module.h"
+
 namespace spvtools {
 namespace ir {
 
-void Function::ForEachInst(const std::function<void(Instruction*)>& f,
-                           bool run_on_debug_line_insts) {
-  if (def_inst_) def_inst_->ForEachInst(f, run_on_debug_line_insts);
-  for (auto& param : params_) param->ForEachInst(f, run_on_debug_line_insts);
-  for (auto& bb : blocks_) bb->ForEachInst(f, run_on_debug_line_insts);
-  if (end_inst_) end_inst_->ForEachInst(f, run_on_debug_line_insts);
+void Function::AddParameter(std::unique_ptr<Instruction> p) {
+  // Keep deferred raw words and built IR from coexisting.  This is a no-op
+  // while a materializer is itself adding the body.
+  MaterializeBody();
+  if (module_) module_->NotifyInsert(p.get());
+  params_.emplace_back(std::move(p));
 }
 
-void Function::ForEachInst(const std::function<void(const Instruction*)>& f,
-                           bool run_on_debug_line_insts) const {
-  if (def_inst_)
-    static_cast<const Instruction*>(def_inst_.get())
-        ->ForEachInst(f, run_on_debug_line_insts);
+void Function::AddBasicBlock(std::unique_ptr<BasicBlock> b) {
+  MaterializeBody();
+  if (module_) {
+    b->ForEachInst([this](Instruction* inst) { module_->NotifyInsert(inst); });
+  }
+  blocks_.emplace_back(std::move(b));
+}
 
-  for (const auto& param : params_)
-    static_cast<const Instruction*>(param.get())
-        ->ForEachInst(f, run_on_debug_line_insts);
+void Function::SetDeferredBody(std::vector<uint32_t>&& words,
+                               std::function<bool(Function*)> materializer) {
+  deferred_body_words_ = std::move(words);
+  body_materializer_ = std::move(materializer);
+}
 
-  for (const auto& bb : blocks_)
-    static_cast<const BasicBlock*>(bb.get())
-        ->ForEachInst(f, run_on_debug_line_insts);
+void Function::CreateBodyArena() {
+  if (body_arena_) return;
+  body_arena_.reset(new Arena());
+  // Body objects should come from the same pool as the module's own IR.
+  if (module_) {
+    body_arena_->SetUpstreamAllocator(&module_->arena().upstream_allocator());
+  }
+}
 
-  if (end_inst_)
-    static_cast<const Instruction*>(end_inst_.get())
-        ->ForEachInst(f, run_on_debug_line_insts);
+void Function::MaterializeBody() {
+  if (body_materializer_ == nullptr) return;
+  // Clear the materializer first: building the body goes through the
+  // ordinary mutators above, which must not re-enter this method.
+  std::function<bool(Function*)> materializer = std::move(body_materializer_);
+  body_materializer_ = nullptr;
+  if (materializer(this)) {
+    deferred_body_words_.clear();
+  }
+  // On failure the raw words are kept, so Module::ToBinary can still write
+  // the function back verbatim.
 }
 
-void Function::ForEachParam(const std::function<void(const Instruction*)>& f,
-                            bool run_on_debug_line_insts) const {
-  for (const auto& param : params_)
-    static_cast<const Instruction*>(param.get())
-        ->ForEachInst(f, run_on_debug_line_insts);
+size_t Function::EstimateMemoryUsage() const {
+  size_t total = params_.capacity() * sizeof(std::unique_ptr<Instruction>) +
+                 blocks_.capacity() * sizeof(std::unique_ptr<BasicBlock>) +
+                 deferred_body_words_.capacity() * sizeof(uint32_t);
+  if (body_arena_) total += sizeof(Arena) + body_arena_->TotalBytes();
+  const auto add_inst = [&total](const Instruction* inst) {
+    total += inst->EstimateMemoryUsage();
+  };
+  // Walk the members directly rather than through ForEachInst, which would
+  // materialize a deferred body just to measure it.
+  if (def_inst_) add_inst(def_inst_.get());
+  for (const auto& param : params_) add_inst(param.get());
+  for (const auto& block : blocks_) {
+    static_cast<const BasicBlock*>(block.get())->ForEachInst(add_inst);
+  }
+  if (end_inst_) add_inst(end_inst_.get());
+  return total;
 }
 
 }  // namespace ir
@@ -30,7 +30,7 @@ namespace ir {
 class Module;
 
 // A SPIR-V function.
-class Function {
+class Function : public ArenaAllocated {
  public:
   using iterator = UptrVectorIterator<BasicBlock>;
   using const_iterator = UptrVectorIterator<BasicBlock, true>;
@@ -43,44 +43,104 @@ class Function {
 
   // Sets the enclosing module for this function.
   void SetParent(Module* module) { module_ = module; }
+  // Returns the enclosing module, or nullptr if not yet set.
+  Module* module() { return module_; }
   // Appends a parameter to this function.
-  inline void AddParameter(std::unique_ptr<Instruction> p);
+  void AddParameter(std::unique_ptr<Instruction> p);
   // Appends a basic block to this function.
-  inline void AddBasicBlock(std::unique_ptr<BasicBlock> b);
+  void AddBasicBlock(std::unique_ptr<BasicBlock> b);
+  // Pre-sizes the basic block container to hold |num_blocks| blocks.  The IR
+  // loader calls this with a count from a pre-scan of the function's words,
+  // so the block array lands in one allocation instead of growing
+  // incrementally while blocks are appended.
+  void ReserveBlocks(size_t num_blocks) { blocks_.reserve(num_blocks); }
 
   // Saves the given function end instruction.
   inline void SetFunctionEnd(std::unique_ptr<Instruction> end_inst);
 
+  // Defers building IR for this function's body.  |words| is the raw word
+  // range of the whole function, from OpFunction through OpFunctionEnd, and
+  // |materializer| builds the parameters, basic blocks, and end instruction
+  // into the given function when called.  The body is built on the first
+  // access that could observe or mutate it; a function that is never touched
+  // is written back verbatim from |words| by Module::ToBinary.
+  void SetDeferredBody(std::vector<uint32_t>&& words,
+                       std::function<bool(Function*)> materializer);
+  // Returns true if this function still carries a deferred body that has not
+  // been built into IR.
+  bool HasDeferredBody() const { return !deferred_body_words_.empty(); }
+  // Returns the raw words of a deferred body.  Empty once the body has been
+  // built.
+  const std::vector<uint32_t>& deferred_body_words() const {
+    return deferred_body_words_;
+  }
+  // Builds the IR for a deferred body, if that has not happened yet.  This
+  // is called implicitly by the iteration methods below.
+  void MaterializeBody();
+
+  // Gives this function its own arena for its materialized body IR.  Used
+  // by parallel loading, where worker threads materialize functions
+  // concurrently and must not contend on the module arena.  No-op if the
+  // function already has a body arena.
+  void CreateBodyArena();
+  // Returns this function's own body arena, or nullptr if body IR goes into
+  // the module arena.
+  Arena* body_arena() { return body_arena_.get(); }
+
   // Returns function's id
   inline uint32_t result_id() const { return def_inst_->result_id(); }
 
   // Returns function's type id
   inline uint32_t type_id() const { return def_inst_->type_id(); }
 
-  iterator begin() { return iterator(&blocks_, blocks_.begin()); }
-  iterator end() { return iterator(&blocks_, blocks_.end()); }
+  iterator begin() {
+    MaterializeBody();
+    return iterator(&blocks_, blocks_.begin());
+  }
+  iterator end() {
+    MaterializeBody();
+    return iterator(&blocks_, blocks_.end());
+  }
   const_iterator cbegin() const {
+    const_cast<Function*>(this)->MaterializeBody();
     return const_iterator(&blocks_, blocks_.cbegin());
   }
   const_iterator cend() const {
+    const_cast<Function*>(this)->MaterializeBody();
     return const_iterator(&blocks_, blocks_.cend());
   }
 
   // Runs the given function |f| on each instruction in this function, and
-  // optionally on debug line instructions that might precede them.
-  void ForEachInst(const std::function<void(Instruction*)>& f,
-                   bool run_on_debug_line_insts = false);
-  void ForEachInst(const std::function<void(const Instruction*)>& f,
-                   bool run_on_debug_line_insts = false) const;
+  // optionally on debug line instructions that might precede them.  |f| is
+  // any callable taking an Instruction* (const Instruction* for the const
+  // overload) and is inlined at the call site.
+  template <typename FunctionT>
+  inline void ForEachInst(const FunctionT& f,
+                          bool run_on_debug_line_insts = false);
+  template <typename FunctionT>
+  inline void ForEachInst(const FunctionT& f,
+                          bool run_on_debug_line_insts = false) const;
 
   // Runs the given function |f| on each parameter instruction in this function,
   // and optionally on debug line instructions that might precede them.
-  void ForEachParam(const std::function<void(const Instruction*)>& f,
-                    bool run_on_debug_line_insts = false) const;
+  template <typename FunctionT>
+  inline void ForEachParam(const FunctionT& f,
+                           bool run_on_debug_line_insts = false) const;
+
+  // Returns an estimate in bytes of the heap storage owned by this function
+  // beyond the object itself: its owning containers, deferred body words,
+  // and the out-of-line storage of every instruction built so far.  A
+  // deferred body is measured from its raw words and not materialized.
+  size_t EstimateMemoryUsage() const;
 
  private:
   // The enclosing module.
   Module* module_;
+  // The arena holding this function's body IR when it was materialized on a
+  // worker thread, or null when the body lives in the module arena.
+  // Declared before the containers below: members are destroyed in reverse
+  // order, and the arena storage must outlive the objects placed in it.
+  std::unique_ptr<Arena> body_arena_;
   // The OpFunction instruction that begins the definition of this function.
   std::unique_ptr<Instruction> def_inst_;
   // All parameters to this function.
@@ -89,21 +149,57 @@ class Function {
   std::vector<std::unique_ptr<BasicBlock>> blocks_;
   // The OpFunctionEnd instruction.
   std::unique_ptr<Instruction> end_inst_;
+  // The raw words of a deferred body, and the callback that builds the IR
+  // for them on first access.  Both are empty for eagerly built functions.
+  std::vector<uint32_t> deferred_body_words_;
+  std::function<bool(Function*)> body_materializer_;
 };
 
 inline Function::Function(std::unique_ptr<Instruction> def_inst)
     : module_(nullptr), def_inst_(std::move(def_inst)), end_inst_() {}
 
-inline void Function::AddParameter(std::unique_ptr<Instruction> p) {
-  params_.emplace_back(std::move(p));
+inline void Function::SetFunctionEnd(std::unique_ptr<Instruction> end_inst) {
+  end_inst_ = std::move(end_inst);
 }
 
-inline void Function::AddBasicBlock(std::unique_ptr<BasicBlock> b) {
-  blocks_.emplace_back(std::move(b));
+template <typename FunctionT>
+inline void Function::ForEachInst(const FunctionT& f,
+                                  bool run_on_debug_line_insts) {
+  MaterializeBody();
+  if (def_inst_) def_inst_->ForEachInst(f, run_on_debug_line_insts);
+  for (auto& param : params_) param->ForEachInst(f, run_on_debug_line_insts);
+  for (auto& bb : blocks_) bb->ForEachInst(f, run_on_debug_line_insts);
+  if (end_inst_) end_inst_->ForEachInst(f, run_on_debug_line_insts);
 }
 
-inline void Function::SetFunctionEnd(std::unique_ptr<Instruction> end_inst) {
-  end_inst_ = std::move(end_inst);
+template <typename FunctionT>
+inline void Function::ForEachInst(const FunctionT& f,
+                                  bool run_on_debug_line_insts) const {
+  const_cast<Function*>(this)->MaterializeBody();
+  if (def_inst_)
+    static_cast<const Instruction*>(def_inst_.get())
+        ->ForEachInst(f, run_on_debug_line_insts);
+
+  for (const auto& param : params_)
+    static_cast<const Instruction*>(param.get())
+        ->ForEachInst(f, run_on_debug_line_insts);
+
+  for (const auto& bb : blocks_)
+    static_cast<const BasicBlock*>(bb.get())
+        ->ForEachInst(f, run_on_debug_line_insts);
+
+  if (end_inst_)
+    static_cast<const Instruction*>(end_inst_.get())
+        ->ForEachInst(f, run_on_debug_line_insts);
+}
+
+template <typename FunctionT>
+inline void Function::ForEachParam(const FunctionT& f,
+                                   bool run_on_debug_line_insts) const {
+  const_cast<Function*>(this)->MaterializeBody();
+  for (const auto& param : params_)
+    static_cast<const Instruction*>(param.get())
+        ->ForEachInst(f, run_on_debug_line_insts);
 }
 
 }  // namespace ir
@@ -0,0 +1,56 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_ID_ALLOCATOR_H_
+#define LIBSPIRV_OPT_ID_ALLOCATOR_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace spvtools {
+namespace ir {
+
+// Hands out fresh result ids for a module.  A reservation is a single atomic
+// fetch-add, so passes working on disjoint functions can mint ids
+// concurrently without further coordination.
+class IdAllocator {
+ public:
+  explicit IdAllocator(uint32_t id_bound = 0) : next_id_(id_bound) {}
+
+  // Restarts allocation so that the next fresh id is |id_bound|.
+  void Reset(uint32_t id_bound) {
+    next_id_.store(id_bound, std::memory_order_relaxed);
+  }
+
+  // Returns one fresh id.
+  uint32_t TakeNextId() { return ReserveIds(1); }
+
+  // Reserves |count| consecutive fresh ids and returns the first one.  Bulk
+  // reservation costs one atomic operation per batch instead of one per id.
+  uint32_t ReserveIds(uint32_t count) {
+    return next_id_.fetch_add(count, std::memory_order_relaxed);
+  }
+
+  // Returns one more than the largest id handed out so far, i.e. the id
+  // bound the module header needs once allocation is finished.
+  uint32_t bound() const { return next_id_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint32_t> next_id_;
+};
+
+}  // namespace ir
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_ID_ALLOCATOR_H_
@@ -0,0 +1,76 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_ID_REMAP_H_
+#define LIBSPIRV_OPT_ID_REMAP_H_
+
+#include <cassert>
+#include <vector>
+
+#include "module.h"
+
+namespace spvtools {
+namespace opt {
+
+// Builds a dense renumbering of ids.  Since ids are bounded by the module id
+// bound, the mapping is a flat vector indexed by old id, so each query is an
+// array load instead of a hash lookup.  New ids are handed out from 1 in
+// order of first appearance.
+class DenseIdRemapper {
+ public:
+  // Constructs a remapper for ids below |id_bound|.
+  explicit DenseIdRemapper(uint32_t id_bound)
+      : remap_(id_bound, 0u), next_id_(1) {}
+
+  // Returns the new id for the given old |id|, assigning the next unused
+  // dense id the first time |id| is seen.  |id| must be below the id bound
+  // this remapper was built for.
+  uint32_t MapId(uint32_t id) {
+    assert(id < remap_.size() && "id exceeds the id bound");
+    uint32_t& slot = remap_[id];
+    if (slot == 0) slot = next_id_++;
+    return slot;
+  }
+
+  // Returns one more than the largest id handed out so far, i.e. the id
+  // bound of a fully remapped module.
+  uint32_t NextId() const { return next_id_; }
+
+  // Rewrites every id operand in |module| in a single sweep, numbering ids
+  // in order of first appearance.  Returns true if any id changed.
+  bool ApplyTo(ir::Module* module) {
+    bool modified = false;
+    module->ForEachInst(
+        [this, &modified](ir::Instruction* inst) {
+          inst->ForEachId([this, &modified](uint32_t* id) {
+            const uint32_t new_id = MapId(*id);
+            if (*id != new_id) {
+              modified = true;
+              *id = new_id;
+            }
+          });
+        },
+        true);
+    return modified;
+  }
+
+ private:
+  std::vector<uint32_t> remap_;  // Indexed by old id; 0 means unassigned.
+  uint32_t next_id_;             // The next dense id to hand out.
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_ID_REMAP_H_
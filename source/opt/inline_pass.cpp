@@ -28,6 +28,11 @@ static const int kSpvTypePointerTypeId = 2;
 static const int kSpvLoopMergeMergeBlockId = 0;
 static const int kSpvSelectionMergeMergeBlockId = 0;
 
+// Instruction count budget for a single caller. Call sites whose inlining
+// would grow the caller past this size are left as calls, stopping code
+// explosion on deeply nested call trees.
+static const uint32_t kInlineSizeBudget = 100000;
+
 namespace spvtools {
 namespace opt {
 
@@ -125,22 +130,20 @@ uint32_t InlinePass::GetFalseId() {
 
 void InlinePass::MapParams(
     ir::Function* calleeFn,
-    ir::UptrVectorIterator<ir::Instruction> call_inst_itr,
-    std::unordered_map<uint32_t, uint32_t>* callee2caller) {
+    ir::BasicBlock::iterator call_inst_itr) {
   int param_idx = 0;
   calleeFn->ForEachParam(
-      [&call_inst_itr, &param_idx, &callee2caller](const ir::Instruction* cpi) {
+      [&call_inst_itr, &param_idx, this](const ir::Instruction* cpi) {
         const uint32_t pid = cpi->result_id();
-        (*callee2caller)[pid] = call_inst_itr->GetSingleWordOperand(
-            kSpvFunctionCallArgumentId + param_idx);
+        MapCalleeId(pid, call_inst_itr->GetSingleWordOperand(
+                             kSpvFunctionCallArgumentId + param_idx));
         ++param_idx;
       });
 }
 
 void InlinePass::CloneAndMapLocals(
     ir::Function* calleeFn,
-    std::vector<std::unique_ptr<ir::Instruction>>* new_vars,
-    std::unordered_map<uint32_t, uint32_t>* callee2caller) {
+    std::vector<std::unique_ptr<ir::Instruction>>* new_vars) {
   auto callee_block_itr = calleeFn->begin();
   auto callee_var_itr = callee_block_itr->begin();
   while (callee_var_itr->opcode() == SpvOp::SpvOpVariable) {
@@ -148,7 +151,7 @@ void InlinePass::CloneAndMapLocals(
         new ir::Instruction(*callee_var_itr));
     uint32_t newId = TakeNextId();
     var_inst->SetResultId(newId);
-    (*callee2caller)[callee_var_itr->result_id()] = newId;
+    MapCalleeId(callee_var_itr->result_id(), newId);
     new_vars->push_back(std::move(var_inst));
     ++callee_var_itr;
   }
@@ -162,11 +165,15 @@ uint32_t InlinePass::CreateReturnVar(
   const ir::Instruction* calleeType =
       def_use_mgr_->id_to_defs().find(calleeTypeId)->second;
   if (calleeType->opcode() != SpvOpTypeVoid) {
-    // Find or create ptr to callee return type.
-    uint32_t returnVarTypeId =
-        FindPointerToType(calleeTypeId, SpvStorageClassFunction);
-    if (returnVarTypeId == 0)
-      returnVarTypeId = AddPointerToType(calleeTypeId, SpvStorageClassFunction);
+    // Find or create ptr to callee return type. The result is cached so
+    // further call sites returning the same type skip the type-section scan.
+    uint32_t& returnVarTypeId = return_var_type_ids_[calleeTypeId];
+    if (returnVarTypeId == 0) {
+      returnVarTypeId = FindPointerToType(calleeTypeId, SpvStorageClassFunction);
+      if (returnVarTypeId == 0)
+        returnVarTypeId =
+            AddPointerToType(calleeTypeId, SpvStorageClassFunction);
+    }
     // Add return var to new function scope variables.
     returnVarId = TakeNextId();
     std::unique_ptr<ir::Instruction> var_inst(new ir::Instruction(
@@ -215,11 +222,12 @@ void InlinePass::CloneSameBlockOps(
 void InlinePass::GenInlineCode(
     std::vector<std::unique_ptr<ir::BasicBlock>>* new_blocks,
     std::vector<std::unique_ptr<ir::Instruction>>* new_vars,
-    ir::UptrVectorIterator<ir::Instruction> call_inst_itr,
+    ir::BasicBlock::iterator call_inst_itr,
     ir::UptrVectorIterator<ir::BasicBlock> call_block_itr) {
-  // Map from all ids in the callee to their equivalent id in the caller
-  // as callee instructions are copied into caller.
-  std::unordered_map<uint32_t, uint32_t> callee2caller;
+  // Invalidate the callee-to-caller id remap table entries left over from
+  // the previous call site. Mappings are recorded as callee instructions
+  // are copied into the caller.
+  BeginCalleeIdMap();
   // Pre-call same-block insts
   std::unordered_map<uint32_t, ir::Instruction*> preCallSB;
   // Post-call same-block op ids
@@ -233,11 +241,11 @@ void InlinePass::GenInlineCode(
   bool earlyReturn = fi != early_return_.end();
 
   // Map parameters to actual arguments.
-  MapParams(calleeFn, call_inst_itr, &callee2caller);
+  MapParams(calleeFn, call_inst_itr);
 
   // Define caller local variables for all callee variables and create map to
   // them.
-  CloneAndMapLocals(calleeFn, new_vars, &callee2caller);
+  CloneAndMapLocals(calleeFn, new_vars);
 
   // Create return var if needed.
   uint32_t returnVarId = CreateReturnVar(calleeFn, new_vars);
@@ -251,7 +259,7 @@ void InlinePass::GenInlineCode(
   bool multiBlocks = false;
   const uint32_t calleeTypeId = calleeFn->type_id();
   std::unique_ptr<ir::BasicBlock> new_blk_ptr;
-  calleeFn->ForEachInst([&new_blocks, &callee2caller, &call_block_itr,
+  calleeFn->ForEachInst([&new_blocks, &call_block_itr,
                          &call_inst_itr, &new_blk_ptr, &prevInstWasReturn,
                          &returnLabelId, &returnVarId, &calleeTypeId,
                          &multiBlocks, &postCallSB, &preCallSB, &earlyReturn,
@@ -279,15 +287,13 @@ void InlinePass::GenInlineCode(
           new_blocks->push_back(std::move(new_blk_ptr));
           // If result id is already mapped, use it, otherwise get a new
           // one.
-          const uint32_t rid = cpi->result_id();
-          const auto mapItr = callee2caller.find(rid);
-          labelId = (mapItr != callee2caller.end()) ? mapItr->second
-                                                    : this->TakeNextId();
+          labelId = this->MappedCalleeId(cpi->result_id());
+          if (labelId == 0) labelId = this->TakeNextId();
         } else {
           // First block needs to use label of original block
           // but map callee label in case of phi reference.
           labelId = call_block_itr->id();
-          callee2caller[cpi->result_id()] = labelId;
+          this->MapCalleeId(cpi->result_id(), labelId);
           firstBlock = true;
         }
         // Create first/next block.
@@ -330,10 +336,8 @@ void InlinePass::GenInlineCode(
         // Store return value to return variable.
         assert(returnVarId != 0);
         uint32_t valId = cpi->GetInOperand(kSpvReturnValueId).words[0];
-        const auto mapItr = callee2caller.find(valId);
-        if (mapItr != callee2caller.end()) {
-          valId = mapItr->second;
-        }
+        const uint32_t mappedValId = this->MappedCalleeId(valId);
+        if (mappedValId != 0) valId = mappedValId;
         AddStore(returnVarId, valId, &new_blk_ptr);
 
         // Remember we saw a return; if followed by a label, will need to
@@ -387,28 +391,28 @@ void InlinePass::GenInlineCode(
       } break;
       default: {
         // Copy callee instruction and remap all input Ids.
-        std::unique_ptr<ir::Instruction> cp_inst(new ir::Instruction(*cpi));
-        cp_inst->ForEachInId([&callee2caller, &cpi, this](uint32_t* iid) {
-          const auto mapItr = callee2caller.find(*iid);
-          if (mapItr != callee2caller.end()) {
-            *iid = mapItr->second;
-          } else if (cpi->HasLabels()) {
-            const ir::Instruction* inst =
-                def_use_mgr_->id_to_defs().find(*iid)->second;
-            if (inst->opcode() == SpvOpLabel) {
-              // Forward label reference. Allocate a new label id, map it,
-              // use it and check for it at each label.
-              const uint32_t nid = this->TakeNextId();
-              callee2caller[*iid] = nid;
-              *iid = nid;
-            }
-          }
-        });
+        std::unique_ptr<ir::Instruction> cp_inst(new ir::Instruction(
+            cpi->CloneWithMappedIds([&cpi, this](uint32_t iid) {
+              const uint32_t mappedId = this->MappedCalleeId(iid);
+              if (mappedId != 0) return mappedId;
+              if (cpi->HasLabels()) {
+                const ir::Instruction* inst =
+                    def_use_mgr_->id_to_defs().find(iid)->second;
+                if (inst->opcode() == SpvOpLabel) {
+                  // Forward label reference. Allocate a new label id, map it,
+                  // use it and check for it at each label.
+                  const uint32_t nid = this->TakeNextId();
+                  this->MapCalleeId(iid, nid);
+                  return nid;
+                }
+              }
+              return iid;
+            })));
         // Map and reset result id.
         const uint32_t rid = cp_inst->result_id();
         if (rid != 0) {
           const uint32_t nid = this->TakeNextId();
-          callee2caller[rid] = nid;
+          this->MapCalleeId(rid, nid);
           cp_inst->SetResultId(nid);
         }
         new_blk_ptr->AddInstruction(std::move(cp_inst));
@@ -431,14 +435,25 @@ bool InlinePass::IsInlinableFunctionCall(const ir::Instruction* inst) {
 
 bool InlinePass::Inline(ir::Function* func) {
   bool modified = false;
+  uint32_t& funcSize = function_size_[func->result_id()];
   // Using block iterators here because of block erasures and insertions.
   for (auto bi = func->begin(); bi != func->end(); ++bi) {
     for (auto ii = bi->begin(); ii != bi->end();) {
       if (IsInlinableFunctionCall(&*ii)) {
+        // Honor the size budget: leave the call in place if inlining it
+        // would grow this function past the budget.
+        const uint32_t calleeId =
+            ii->GetSingleWordOperand(kSpvFunctionCallFunctionId);
+        const uint32_t calleeSize = function_size_[calleeId];
+        if (funcSize + calleeSize > kInlineSizeBudget) {
+          ++ii;
+          continue;
+        }
         // Inline call.
         std::vector<std::unique_ptr<ir::BasicBlock>> newBlocks;
         std::vector<std::unique_ptr<ir::Instruction>> newVars;
         GenInlineCode(&newBlocks, &newVars, ii, bi);
+        funcSize += calleeSize;
         // Update phi functions in successor blocks if call block
         // is replaced with more than one block.
         if (newBlocks.size() > 1) {
@@ -457,11 +472,15 @@ bool InlinePass::Inline(ir::Function* func) {
               });
         }
         // Replace old calling block with new block(s).
+        const size_t numBlocks = newBlocks.size();
         bi = bi.Erase();
         bi = bi.InsertBefore(&newBlocks);
         // Insert new function variables.
         if (newVars.size() > 0) func->begin()->begin().InsertBefore(&newVars);
-        // Restart inlining at beginning of calling block.
+        // The inlined callee code is already in its final form, so resume
+        // scanning at the last new block, which holds the remainder of the
+        // original calling block.
+        for (size_t i = 1; i < numBlocks; ++i) ++bi;
         ii = bi->begin();
         modified = true;
       } else {
@@ -579,6 +598,20 @@ void InlinePass::AnalyzeReturns(ir::Function* func) {
     no_return_in_loop_.insert(func->result_id());
 }
 
+void InlinePass::OrderCalleesFirst(ir::Function* func,
+                                   std::set<uint32_t>* seen,
+                                   std::vector<ir::Function*>* order) {
+  if (!seen->insert(func->result_id()).second) return;
+  func->ForEachInst([&seen, &order, this](const ir::Instruction* inst) {
+    if (inst->opcode() != SpvOp::SpvOpFunctionCall) return;
+    const auto calleeItr = id2function_.find(
+        inst->GetSingleWordOperand(kSpvFunctionCallFunctionId));
+    if (calleeItr != id2function_.end())
+      OrderCalleesFirst(calleeItr->second, seen, order);
+  });
+  order->push_back(func);
+}
+
 bool InlinePass::IsInlinableFunction(ir::Function* func) {
   // We can only inline a function if it has blocks.
   if (func->cbegin() == func->cend())
@@ -594,12 +627,9 @@ bool InlinePass::IsInlinableFunction(ir::Function* func) {
 }
 
 void InlinePass::Initialize(ir::Module* module) {
-  def_use_mgr_.reset(new analysis::DefUseManager(consumer(), module));
-
-  // Initialize next unused Id.
-  next_id_ = module->id_bound();
+  def_use_mgr_ = analyses(module)->GetDefUse();
 
-  // Save module.
+  // Save module. Fresh ids come from its allocator.
   module_ = module;
 
   false_id_ = 0;
@@ -608,12 +638,18 @@ void InlinePass::Initialize(ir::Module* module) {
   id2block_.clear();
   block2structured_succs_.clear();
   inlinable_.clear();
+  function_size_.clear();
+  return_var_type_ids_.clear();
   for (auto& fn : *module_) {
     // Initialize function and block maps.
     id2function_[fn.result_id()] = &fn;
     for (auto& blk : fn) {
       id2block_[blk.id()] = &blk;
     }
+    // Compute the function size for the inlining budget.
+    uint32_t size = 0;
+    fn.ForEachInst([&size](const ir::Instruction*) { ++size; });
+    function_size_[fn.result_id()] = size;
     // Compute inlinability
     if (IsInlinableFunction(&fn))
       inlinable_.insert(fn.result_id());
@@ -621,12 +657,21 @@ void InlinePass::Initialize(ir::Module* module) {
 };
 
 Pass::Status InlinePass::ProcessImpl() {
-  // Do exhaustive inlining on each entry point function in module
-  bool modified = false;
+  // Process the functions reachable from the entry points bottom-up over
+  // the call graph, so that every callee is in its final form before it is
+  // cloned into its callers. Each function then needs a single inlining
+  // sweep, instead of re-cloning nested callees through every level of the
+  // call tree.
+  std::set<uint32_t> seen;
+  std::vector<ir::Function*> bottom_up;
   for (auto& e : module_->entry_points()) {
     ir::Function* fn =
         id2function_[e.GetSingleWordOperand(kSpvEntryPointFunctionId)];
-    modified = modified || Inline(fn);
+    OrderCalleesFirst(fn, &seen, &bottom_up);
+  }
+  bool modified = false;
+  for (ir::Function* fn : bottom_up) {
+    if (Inline(fn)) modified = true;
   }
 
   FinalizeNextId(module_);
@@ -635,7 +680,9 @@ Pass::Status InlinePass::ProcessImpl() {
 }
 
 InlinePass::InlinePass()
-    : module_(nullptr), def_use_mgr_(nullptr), next_id_(0) {}
+    : module_(nullptr),
+      def_use_mgr_(nullptr),
+      callee2caller_epoch_(0) {}
 
 Pass::Status InlinePass::Process(ir::Module* module) {
   Initialize(module);
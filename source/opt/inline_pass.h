@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <memory>
+#include <set>
 #include <unordered_map>
 #include <vector>
 #include <list>
@@ -45,12 +46,12 @@ class InlinePass : public Pass {
   const char* name() const override { return "inline"; }
 
  private:
-  // Return the next available Id and increment it.
-  inline uint32_t TakeNextId() { return next_id_++; }
+  // Return the next available Id from the module's allocator.
+  inline uint32_t TakeNextId() { return module_->id_allocator().TakeNextId(); }
 
-  // Write the next available Id back to the module.
+  // Write the next available Id back to the module header.
   inline void FinalizeNextId(ir::Module* module) {
-    module->SetIdBound(next_id_);
+    module->FinalizeIdBound();
   }
 
   // Find pointer to type and storage in module, return its resultId,
@@ -86,16 +87,49 @@ class InlinePass : public Pass {
   // and creates it if not found. Remembers it for future calls.
   uint32_t GetFalseId();
 
+  // Start a fresh callee-to-caller id mapping for the next call site.
+  // Stale entries from previous call sites are invalidated by bumping the
+  // epoch; the table itself is never cleared.
+  void BeginCalleeIdMap() {
+    ++callee2caller_epoch_;
+    if (callee2caller_epoch_ == 0) {
+      // Epoch counter wrapped; old stamps would read as current. Clear and
+      // restart.
+      callee2caller_ids_.clear();
+      callee2caller_epochs_.clear();
+      callee2caller_epoch_ = 1;
+    }
+  }
+
+  // Record that callee id |callee_id| maps to caller id |caller_id| at the
+  // current call site. The table grows on demand, so ids minted during
+  // earlier inlining are valid keys.
+  void MapCalleeId(uint32_t callee_id, uint32_t caller_id) {
+    if (callee_id >= callee2caller_ids_.size()) {
+      callee2caller_ids_.resize(callee_id + 1, 0);
+      callee2caller_epochs_.resize(callee_id + 1, 0);
+    }
+    callee2caller_ids_[callee_id] = caller_id;
+    callee2caller_epochs_[callee_id] = callee2caller_epoch_;
+  }
+
+  // Return the caller id mapped to |callee_id| at the current call site,
+  // or 0 if the id is unmapped.
+  uint32_t MappedCalleeId(uint32_t callee_id) const {
+    return (callee_id < callee2caller_ids_.size() &&
+            callee2caller_epochs_[callee_id] == callee2caller_epoch_)
+               ? callee2caller_ids_[callee_id]
+               : 0;
+  }
+
   // Map callee params to caller args
   void MapParams(ir::Function* calleeFn,
-                 ir::UptrVectorIterator<ir::Instruction> call_inst_itr,
-                 std::unordered_map<uint32_t, uint32_t>* callee2caller);
+                 ir::BasicBlock::iterator call_inst_itr);
 
   // Clone and map callee locals
   void CloneAndMapLocals(
       ir::Function* calleeFn,
-      std::vector<std::unique_ptr<ir::Instruction>>* new_vars,
-      std::unordered_map<uint32_t, uint32_t>* callee2caller);
+      std::vector<std::unique_ptr<ir::Instruction>>* new_vars);
 
   // Create return variable for callee clone code if needed. Return id
   // if created, otherwise 0.
@@ -133,7 +167,7 @@ class InlinePass : public Pass {
   // call_block_itr is replaced with new_blocks.
   void GenInlineCode(std::vector<std::unique_ptr<ir::BasicBlock>>* new_blocks,
                      std::vector<std::unique_ptr<ir::Instruction>>* new_vars,
-                     ir::UptrVectorIterator<ir::Instruction> call_inst_itr,
+                     ir::BasicBlock::iterator call_inst_itr,
                      ir::UptrVectorIterator<ir::BasicBlock> call_block_itr);
 
   // Return true if |inst| is a function call that can be inlined.
@@ -170,15 +204,26 @@ class InlinePass : public Pass {
   // Return true if |func| is a function that can be inlined.
   bool IsInlinableFunction(ir::Function* func);
 
-  // Exhaustively inline all function calls in func as well as in
-  // all code that is inlined into func. Return true if func is modified.
+  // Append to |order| the functions reachable from |func| in bottom-up
+  // call-graph order: every function appears after all the functions it
+  // calls. |seen| guards against revisiting shared callees and breaks
+  // recursion cycles.
+  void OrderCalleesFirst(ir::Function* func, std::set<uint32_t>* seen,
+                         std::vector<ir::Function*>* order);
+
+  // Inline all function calls in |func|. Runs after all of the callees of
+  // |func| have themselves been inlined, so a single sweep suffices: the
+  // cloned callee code cannot contain further inlinable calls. Call sites
+  // whose inlining would grow |func| past the size budget are left as
+  // calls. Return true if func is modified.
   bool Inline(ir::Function* func);
 
   void Initialize(ir::Module* module);
   Pass::Status ProcessImpl();
 
   ir::Module* module_;
-  std::unique_ptr<analysis::DefUseManager> def_use_mgr_;
+  // Owned by the AnalysisManager; fetched anew for every processed module.
+  analysis::DefUseManager* def_use_mgr_;
 
   // Map from function's result id to function.
   std::unordered_map<uint32_t, ir::Function*> id2function_;
@@ -195,16 +240,31 @@ class InlinePass : public Pass {
   // Set of ids of inlinable functions
   std::set<uint32_t> inlinable_;
 
-  // Map from block to its structured successor blocks. See 
+  // Map from block to its structured successor blocks. See
   // ComputeStructuredSuccessors() for definition.
   std::unordered_map<const ir::BasicBlock*, std::vector<ir::BasicBlock*>>
       block2structured_succs_;
 
+  // Map from function's result id to its current instruction count, updated
+  // as inlining grows a function. Used to enforce the size budget.
+  std::unordered_map<uint32_t, uint32_t> function_size_;
+
+  // Cached OpTypePointer result ids for callee return types, keyed by the
+  // return type id, so repeated call sites of the same callee do not
+  // re-scan the type section.
+  std::unordered_map<uint32_t, uint32_t> return_var_type_ids_;
+
+  // Flat callee-to-caller id remap table indexed by callee id. A slot is
+  // live only when its stamp in callee2caller_epochs_ equals
+  // callee2caller_epoch_, so reusing the table at the next call site is a
+  // counter bump rather than a clear. Since ids are bounded by the module
+  // id bound, a lookup is a bounds-checked array read.
+  std::vector<uint32_t> callee2caller_ids_;
+  std::vector<uint32_t> callee2caller_epochs_;
+  uint32_t callee2caller_epoch_;
+
   // result id for OpConstantFalse
   uint32_t false_id_;
-
-  // Next unused ID
-  uint32_t next_id_;
 };
 
 }  // namespace opt
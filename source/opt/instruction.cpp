@@ -14,9 +14,11 @@
 
 #include "instruction.h"
 
-#include <initializer_list>
+#include <algorithm>
+#include <cstring>
 
 #include "reflect.h"
+#include "string_pool.h"
 
 namespace spvtools {
 namespace ir {
@@ -26,67 +28,234 @@ Instruction::Instruction(const spv_parsed_instruction_t& inst,
     : opcode_(static_cast<SpvOp>(inst.opcode)),
       type_id_(inst.type_id),
       result_id_(inst.result_id),
-      dbg_line_insts_(std::move(dbg_line)) {
-  assert((!IsDebugLineInst(opcode_) || dbg_line.empty()) &&
+      dbg_line_insts_(dbg_line.empty()
+                          ? nullptr
+                          : new std::vector<Instruction>(std::move(dbg_line))) {
+  assert((!IsDebugLineInst(opcode_) || !HasDbgLineInsts()) &&
          "Op(No)Line attaching to Op(No)Line found");
+  words_.reserve(inst.num_words > 0 ? inst.num_words - 1 : 0);
+  operands_.reserve(inst.num_operands);
   for (uint32_t i = 0; i < inst.num_operands; ++i) {
     const auto& current_payload = inst.operands[i];
-    std::vector<uint32_t> words(
-        inst.words + current_payload.offset,
-        inst.words + current_payload.offset + current_payload.num_words);
-    operands_.emplace_back(current_payload.type, std::move(words));
+    if (spvIsIdType(current_payload.type))
+      id_offsets_.push_back(static_cast<uint32_t>(words_.size()));
+    operands_.push_back({current_payload.type,
+                         static_cast<uint32_t>(words_.size()),
+                         current_payload.num_words});
+    words_.insert(words_.end(), inst.words + current_payload.offset,
+                  inst.words + current_payload.offset +
+                      current_payload.num_words);
   }
 }
 
 Instruction::Instruction(SpvOp op, uint32_t ty_id, uint32_t res_id,
                          const std::vector<Operand>& in_operands)
-    : opcode_(op), type_id_(ty_id), result_id_(res_id), operands_() {
+    : opcode_(op), type_id_(ty_id), result_id_(res_id) {
+  size_t num_in_words = 0;
+  for (const auto& operand : in_operands) num_in_words += operand.words.size();
+  operands_.reserve(TypeResultIdCount() + in_operands.size());
+  words_.reserve(TypeResultIdCount() + num_in_words);
   if (type_id_ != 0) {
-    operands_.emplace_back(spv_operand_type_t::SPV_OPERAND_TYPE_TYPE_ID,
-                           std::initializer_list<uint32_t>{type_id_});
+    id_offsets_.push_back(static_cast<uint32_t>(words_.size()));
+    operands_.push_back({spv_operand_type_t::SPV_OPERAND_TYPE_TYPE_ID,
+                         static_cast<uint32_t>(words_.size()), 1});
+    words_.push_back(type_id_);
   }
   if (result_id_ != 0) {
-    operands_.emplace_back(spv_operand_type_t::SPV_OPERAND_TYPE_RESULT_ID,
-                           std::initializer_list<uint32_t>{result_id_});
+    id_offsets_.push_back(static_cast<uint32_t>(words_.size()));
+    operands_.push_back({spv_operand_type_t::SPV_OPERAND_TYPE_RESULT_ID,
+                         static_cast<uint32_t>(words_.size()), 1});
+    words_.push_back(result_id_);
+  }
+  for (const auto& operand : in_operands) {
+    if (spvIsIdType(operand.type))
+      id_offsets_.push_back(static_cast<uint32_t>(words_.size()));
+    operands_.push_back({operand.type, static_cast<uint32_t>(words_.size()),
+                         static_cast<uint32_t>(operand.words.size())});
+    words_.insert(words_.end(), operand.words.begin(), operand.words.end());
   }
-  operands_.insert(operands_.end(), in_operands.begin(), in_operands.end());
+}
+
+Instruction::Instruction(SpvOp op, uint32_t ty_id, uint32_t res_id,
+                         std::vector<Operand>&& in_operands)
+    : Instruction(op, ty_id, res_id,
+                  static_cast<const std::vector<Operand>&>(in_operands)) {}
+
+Instruction::Instruction(const Instruction& that)
+    : opcode_(that.opcode_),
+      type_id_(that.type_id_),
+      result_id_(that.result_id_),
+      words_(that.words_),
+      operands_(that.operands_),
+      id_offsets_(that.id_offsets_),
+      dbg_line_insts_(that.dbg_line_insts_
+                          ? new std::vector<Instruction>(*that.dbg_line_insts_)
+                          : nullptr),
+      interned_strings_(that.interned_strings_
+                            ? new InternedStrings(*that.interned_strings_)
+                            : nullptr) {}
+
+Instruction& Instruction::operator=(const Instruction& that) {
+  opcode_ = that.opcode_;
+  type_id_ = that.type_id_;
+  result_id_ = that.result_id_;
+  words_ = that.words_;
+  operands_ = that.operands_;
+  id_offsets_ = that.id_offsets_;
+  dbg_line_insts_.reset(
+      that.dbg_line_insts_ ? new std::vector<Instruction>(*that.dbg_line_insts_)
+                           : nullptr);
+  interned_strings_.reset(that.interned_strings_
+                              ? new InternedStrings(*that.interned_strings_)
+                              : nullptr);
+  return *this;
 }
 
 Instruction::Instruction(Instruction&& that)
     : opcode_(that.opcode_),
       type_id_(that.type_id_),
       result_id_(that.result_id_),
+      words_(std::move(that.words_)),
       operands_(std::move(that.operands_)),
-      dbg_line_insts_(std::move(that.dbg_line_insts_)) {}
+      id_offsets_(std::move(that.id_offsets_)),
+      dbg_line_insts_(std::move(that.dbg_line_insts_)),
+      interned_strings_(std::move(that.interned_strings_)) {}
 
 Instruction& Instruction::operator=(Instruction&& that) {
   opcode_ = that.opcode_;
   type_id_ = that.type_id_;
   result_id_ = that.result_id_;
+  words_ = std::move(that.words_);
   operands_ = std::move(that.operands_);
+  id_offsets_ = std::move(that.id_offsets_);
   dbg_line_insts_ = std::move(that.dbg_line_insts_);
+  interned_strings_ = std::move(that.interned_strings_);
   return *this;
 }
 
+Instruction Instruction::CloneWithMappedIds(
+    const std::function<uint32_t(uint32_t)>& id_map) const {
+  Instruction clone(*this);
+  clone.ForEachInId([&id_map](uint32_t* iid) { *iid = id_map(*iid); });
+  return clone;
+}
+
 uint32_t Instruction::GetSingleWordOperand(uint32_t index) const {
-  const auto& words = GetOperand(index).words;
-  assert(words.size() == 1 && "expected the operand only taking one word");
-  return words.front();
+  assert(index < operands_.size() && "operand index out of bound");
+  const OperandSlot& slot = operands_[index];
+  assert(slot.num_words == 1 && "expected the operand only taking one word");
+  return words_[slot.offset];
 }
 
-uint32_t Instruction::NumInOperandWords() const {
-  uint32_t size = 0;
-  for (uint32_t i = TypeResultIdCount(); i < operands_.size(); ++i)
-    size += static_cast<uint32_t>(operands_[i].words.size());
-  return size;
+void Instruction::ReplaceOperandWords(uint32_t index,
+                                      const std::vector<uint32_t>& data) {
+  OperandSlot& slot = operands_[index];
+  if (data.size() == slot.num_words) {
+    std::copy(data.begin(), data.end(), words_.begin() + slot.offset);
+    return;
+  }
+  // The operand changes width: splice the flat buffer and rebase every
+  // descriptor that follows.
+  words_.erase(words_.begin() + slot.offset,
+               words_.begin() + slot.offset + slot.num_words);
+  words_.insert(words_.begin() + slot.offset, data.begin(), data.end());
+  slot.num_words = static_cast<uint32_t>(data.size());
+  for (size_t i = index + 1; i < operands_.size(); ++i)
+    operands_[i].offset = operands_[i - 1].offset + operands_[i - 1].num_words;
+  RebuildIdOffsets();
+}
+
+void Instruction::RebuildIdOffsets() {
+  id_offsets_.clear();
+  for (const OperandSlot& slot : operands_)
+    if (spvIsIdType(slot.type)) id_offsets_.push_back(slot.offset);
+}
+
+void Instruction::InternStrings(StringPool* pool) {
+  // Interning twice would treat the one-word intern ids as strings.
+  if (interned_strings_) return;
+  for (uint32_t i = 0; i < operands_.size(); ++i) {
+    if (operands_[i].type != SPV_OPERAND_TYPE_LITERAL_STRING) continue;
+    if (!interned_strings_)
+      interned_strings_.reset(new InternedStrings{pool, {}});
+    const uint32_t id =
+        pool->Intern(words_.data() + operands_[i].offset,
+                     operands_[i].num_words);
+    ReplaceOperandWords(i, {id});
+    interned_strings_->operand_indexes.push_back(i);
+  }
+}
+
+uint32_t Instruction::NumSerializedOperandWords() const {
+  uint32_t num_words = NumOperandWords();
+  if (interned_strings_) {
+    for (uint32_t index : interned_strings_->operand_indexes) {
+      const uint32_t id = words_[operands_[index].offset];
+      num_words += static_cast<uint32_t>(
+                       interned_strings_->pool->words(id).size()) -
+                   1;
+    }
+  }
+  return num_words;
 }
 
 void Instruction::ToBinaryWithoutAttachedDebugInsts(
     std::vector<uint32_t>* binary) const {
+  if (interned_strings_) {
+    const size_t start = binary->size();
+    binary->resize(start + 1 + NumSerializedOperandWords());
+    ToBinaryWithoutAttachedDebugInsts(binary->data() + start);
+    return;
+  }
   const uint32_t num_words = 1 + NumOperandWords();
   binary->push_back((num_words << 16) | static_cast<uint16_t>(opcode_));
-  for (const auto& operand : operands_)
-    binary->insert(binary->end(), operand.words.begin(), operand.words.end());
+  binary->insert(binary->end(), words_.begin(), words_.end());
+}
+
+uint32_t* Instruction::ToBinaryWithoutAttachedDebugInsts(
+    uint32_t* binary) const {
+  const uint32_t num_words = 1 + NumSerializedOperandWords();
+  *binary++ = (num_words << 16) | static_cast<uint16_t>(opcode_);
+  if (!interned_strings_) {
+    if (!words_.empty()) {
+      std::memcpy(binary, words_.data(), words_.size() * sizeof(uint32_t));
+      binary += words_.size();
+    }
+    return binary;
+  }
+  // Expand every interned operand back to the pooled string's words and copy
+  // the rest verbatim.
+  const auto& indexes = interned_strings_->operand_indexes;
+  for (uint32_t i = 0; i < operands_.size(); ++i) {
+    const OperandSlot& slot = operands_[i];
+    if (std::find(indexes.begin(), indexes.end(), i) != indexes.end()) {
+      const auto& string_words =
+          interned_strings_->pool->words(words_[slot.offset]);
+      binary = std::copy(string_words.begin(), string_words.end(), binary);
+    } else {
+      binary = std::copy(words_.begin() + slot.offset,
+                         words_.begin() + slot.offset + slot.num_words,
+                         binary);
+    }
+  }
+  return binary;
+}
+
+size_t Instruction::EstimateMemoryUsage() const {
+  size_t total = words_.capacity() * sizeof(uint32_t) +
+                 operands_.capacity() * sizeof(OperandSlot) +
+                 id_offsets_.capacity() * sizeof(uint32_t);
+  if (dbg_line_insts_) {
+    total += sizeof(*dbg_line_insts_) +
+             dbg_line_insts_->capacity() * sizeof(Instruction);
+    for (const auto& dbg_line : *dbg_line_insts_)
+      total += dbg_line.EstimateMemoryUsage();
+  }
+  if (interned_strings_) {
+    total += sizeof(*interned_strings_) +
+             interned_strings_->operand_indexes.capacity() * sizeof(uint32_t);
+  }
+  return total;
 }
 
 }  // namespace ir
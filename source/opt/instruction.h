@@ -15,11 +15,15 @@
 #ifndef LIBSPIRV_OPT_INSTRUCTION_H_
 #define LIBSPIRV_OPT_INSTRUCTION_H_
 
+#include <algorithm>
 #include <cassert>
 #include <functional>
+#include <iterator>
+#include <memory>
 #include <utility>
 #include <vector>
 
+#include "arena.h"
 #include "operand.h"
 
 #include "spirv-tools/libspirv.h"
@@ -28,7 +32,10 @@
 namespace spvtools {
 namespace ir {
 
+class StringPool;
+
 class Function;
+class InstructionList;
 class Module;
 
 // About operand:
@@ -47,7 +54,10 @@ class Module;
 // operands.
 
 // A *logical* operand to a SPIR-V instruction. It can be the type id, result
-// id, or other additional operands carried in an instruction.
+// id, or other additional operands carried in an instruction. This is the
+// owning form used when building instructions; inside an Instruction the
+// operand words are flattened into one contiguous buffer, and inspection
+// goes through the OperandRef view below.
 struct Operand {
   Operand(spv_operand_type_t t, std::vector<uint32_t>&& w)
       : type(t), words(std::move(w)) {}
@@ -61,16 +71,128 @@ struct Operand {
   // TODO(antiagainst): create fields for literal number kind, width, etc.
 };
 
+// A read-only view of the words of one logical operand, pointing into the
+// owning instruction's flat word buffer. Offers enough of the vector
+// interface for the common read patterns; the view stays valid only as long
+// as the instruction's operands are not added to or resized.
+class OperandWords {
+ public:
+  using const_iterator = const uint32_t*;
+
+  OperandWords(const uint32_t* data, uint32_t size)
+      : data_(data), size_(size) {}
+
+  const uint32_t* begin() const { return data_; }
+  const uint32_t* end() const { return data_ + size_; }
+  const uint32_t* cbegin() const { return data_; }
+  const uint32_t* cend() const { return data_ + size_; }
+  const uint32_t* data() const { return data_; }
+  uint32_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  uint32_t front() const { return data_[0]; }
+  uint32_t back() const { return data_[size_ - 1]; }
+  uint32_t operator[](size_t index) const { return data_[index]; }
+
+ private:
+  const uint32_t* data_;  // First word of the operand.
+  uint32_t size_;         // Number of words the operand occupies.
+};
+
+inline bool operator==(const OperandWords& lhs,
+                       const std::vector<uint32_t>& rhs) {
+  return lhs.size() == rhs.size() &&
+         std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+inline bool operator==(const std::vector<uint32_t>& lhs,
+                       const OperandWords& rhs) {
+  return rhs == lhs;
+}
+inline bool operator!=(const OperandWords& lhs,
+                       const std::vector<uint32_t>& rhs) {
+  return !(lhs == rhs);
+}
+inline bool operator!=(const std::vector<uint32_t>& lhs,
+                       const OperandWords& rhs) {
+  return !(rhs == lhs);
+}
+
+// A read-only view of one logical operand of an Instruction: the operand
+// type plus a view of the operand's words. Operand iteration and the
+// operand accessors yield this; Operand above remains the owning form used
+// to build instructions.
+struct OperandRef {
+  OperandRef(spv_operand_type_t t, const uint32_t* d, uint32_t n)
+      : type(t), words(d, n) {}
+
+  spv_operand_type_t type;  // Type of this logical operand.
+  OperandWords words;       // View of this operand's binary segments.
+};
+
 // A SPIR-V instruction. It contains the opcode and any additional logical
 // operand, including the result id (if any) and result type id (if any). It
 // may also contain line-related debug instruction (OpLine, OpNoLine) directly
 // appearing before this instruction. Note that the result id of an instruction
 // should never change after the instruction being built. If the result id
 // needs to change, the user should create a new instruction instead.
-class Instruction {
+//
+// Operands are stored flattened: one contiguous array holds every operand's
+// words back to back, and a compact descriptor per logical operand records
+// its type and word range. Scanning operands is a linear walk over a single
+// allocation, and serialization is a bulk copy of the word array.
+//
+// Instructions created with `new` inside an ArenaScope (as the IR loader
+// does, using the owning module's arena) have their storage reclaimed
+// wholesale when that module dies; see arena.h.
+class Instruction : public ArenaAllocated {
  public:
-  using iterator = std::vector<Operand>::iterator;
-  using const_iterator = std::vector<Operand>::const_iterator;
+  // Iterator over the logical operands, yielding read-only OperandRef views
+  // into the flat word buffer. The const and non-const spellings are the
+  // same type: operand mutation goes through the dedicated setters, never
+  // through iteration.
+  class operand_iterator
+      : public std::iterator<std::bidirectional_iterator_tag, OperandRef> {
+   public:
+    operand_iterator(const Instruction* inst, uint32_t index)
+        : inst_(inst), index_(index) {}
+
+    OperandRef operator*() const { return inst_->GetOperand(index_); }
+
+    operand_iterator& operator++() {
+      ++index_;
+      return *this;
+    }
+    operand_iterator operator++(int) {
+      auto it = *this;
+      ++index_;
+      return it;
+    }
+    operand_iterator& operator--() {
+      --index_;
+      return *this;
+    }
+    operand_iterator operator--(int) {
+      auto it = *this;
+      --index_;
+      return it;
+    }
+    operand_iterator operator+(int32_t n) const {
+      return operand_iterator(inst_, index_ + n);
+    }
+
+    bool operator==(const operand_iterator& that) const {
+      return inst_ == that.inst_ && index_ == that.index_;
+    }
+    bool operator!=(const operand_iterator& that) const {
+      return !(*this == that);
+    }
+
+   private:
+    const Instruction* inst_;  // The instruction whose operands are walked.
+    uint32_t index_;           // The current logical operand index.
+  };
+
+  using iterator = operand_iterator;
+  using const_iterator = operand_iterator;
 
   // Creates a default OpNop instruction.
   Instruction() : opcode_(SpvOpNop), type_id_(0), result_id_(0) {}
@@ -85,12 +207,20 @@ class Instruction {
               std::vector<Instruction>&& dbg_line = {});
 
   // Creates an instruction with the given opcode |op|, type id: |ty_id|,
-  // result id: |res_id| and input operands: |in_operands|.
+  // result id: |res_id| and input operands: |in_operands|. The operand words
+  // are copied into the instruction's flat word buffer.
   Instruction(SpvOp op, uint32_t ty_id, uint32_t res_id,
               const std::vector<Operand>& in_operands);
+  // Same as above; braced operand lists at call sites select this overload
+  // automatically. The words end up in the flat buffer either way.
+  Instruction(SpvOp op, uint32_t ty_id, uint32_t res_id,
+              std::vector<Operand>&& in_operands);
 
-  Instruction(const Instruction&) = default;
-  Instruction& operator=(const Instruction&) = default;
+  // Copies and moves never transfer list membership: the intrusive links of
+  // a new instruction start out null, and assignment leaves the target's
+  // links untouched.
+  Instruction(const Instruction&);
+  Instruction& operator=(const Instruction&);
 
   Instruction(Instruction&&);
   Instruction& operator=(Instruction&&);
@@ -103,21 +233,32 @@ class Instruction {
   void SetOpcode(SpvOp op) { opcode_ = op; }
   uint32_t type_id() const { return type_id_; }
   uint32_t result_id() const { return result_id_; }
+  // Returns true if any line-related debug instructions are attached to this
+  // instruction.  This is the cheap query: it never allocates the backing
+  // storage the way the mutable dbg_line_insts() accessor does.
+  bool HasDbgLineInsts() const {
+    return dbg_line_insts_ != nullptr && !dbg_line_insts_->empty();
+  }
   // Returns the vector of line-related debug instructions attached to this
-  // instruction and the caller can directly modify them.
-  std::vector<Instruction>& dbg_line_insts() { return dbg_line_insts_; }
-  const std::vector<Instruction>& dbg_line_insts() const {
-    return dbg_line_insts_;
+  // instruction and the caller can directly modify them.  The backing
+  // storage is allocated on first use; query with HasDbgLineInsts() first
+  // when only inspecting.
+  std::vector<Instruction>& dbg_line_insts() {
+    if (!dbg_line_insts_) dbg_line_insts_.reset(new std::vector<Instruction>());
+    return *dbg_line_insts_;
   }
+  inline const std::vector<Instruction>& dbg_line_insts() const;
+  // Detaches and destroys all attached line-related debug instructions.
+  void ClearDbgLineInsts() { dbg_line_insts_.reset(); }
 
   // Begin and end iterators for operands.
-  iterator begin() { return operands_.begin(); }
-  iterator end() { return operands_.end(); }
-  const_iterator begin() const { return operands_.cbegin(); }
-  const_iterator end() const { return operands_.cend(); }
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, NumOperands()); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, NumOperands()); }
   // Const begin and end iterators for operands.
-  const_iterator cbegin() const { return operands_.cbegin(); }
-  const_iterator cend() const { return operands_.cend(); }
+  const_iterator cbegin() const { return const_iterator(this, 0); }
+  const_iterator cend() const { return const_iterator(this, NumOperands()); }
 
   // Gets the number of logical operands.
   uint32_t NumOperands() const {
@@ -125,14 +266,19 @@ class Instruction {
   }
   // Gets the number of SPIR-V words occupied by all logical operands.
   uint32_t NumOperandWords() const {
-    return NumInOperandWords() + TypeResultIdCount();
+    return static_cast<uint32_t>(words_.size());
   }
-  // Gets the |index|-th logical operand.
-  inline const Operand& GetOperand(uint32_t index) const;
+  // Gets a view of the |index|-th logical operand.
+  inline OperandRef GetOperand(uint32_t index) const;
   // Gets the |index|-th logical operand as a single SPIR-V word. This method is
   // not expected to be used with logical operands consisting of multiple SPIR-V
   // words.
   uint32_t GetSingleWordOperand(uint32_t index) const;
+  // Appends a logical operand with the given |type| and |words|.  The words
+  // are appended to the flat word buffer.  The result type id and result id,
+  // if any, must already be in place: this only builds up the trailing in
+  // operands.
+  inline void AddOperand(spv_operand_type_t type, std::vector<uint32_t>&& words);
   // Sets the |index|-th in-operand's data to the given |data|.
   inline void SetInOperand(uint32_t index, std::vector<uint32_t>&& data);
   // Sets the result type id.
@@ -144,8 +290,10 @@ class Instruction {
   uint32_t NumInOperands() const {
     return static_cast<uint32_t>(operands_.size() - TypeResultIdCount());
   }
-  uint32_t NumInOperandWords() const;
-  const Operand& GetInOperand(uint32_t index) const {
+  uint32_t NumInOperandWords() const {
+    return NumOperandWords() - TypeResultIdCount();
+  }
+  OperandRef GetInOperand(uint32_t index) const {
     return GetOperand(index + TypeResultIdCount());
   }
   uint32_t GetSingleWordInOperand(uint32_t index) const {
@@ -160,63 +308,170 @@ class Instruction {
 
   // Runs the given function |f| on this instruction and optionally on the
   // preceding debug line instructions.  The function will always be run
-  // if this is itself a debug line instruction.
-  inline void ForEachInst(const std::function<void(Instruction*)>& f,
+  // if this is itself a debug line instruction.  |f| is any callable taking
+  // an Instruction* (const Instruction* for the const overload); taking it
+  // as a template parameter lets the compiler inline the callback into
+  // these innermost traversal loops.
+  template <typename FunctionT>
+  inline void ForEachInst(const FunctionT& f,
                           bool run_on_debug_line_insts = false);
-  inline void ForEachInst(const std::function<void(const Instruction*)>& f,
+  template <typename FunctionT>
+  inline void ForEachInst(const FunctionT& f,
                           bool run_on_debug_line_insts = false) const;
 
-  // Runs the given function |f| on all "in" operand ids
-  inline void ForEachInId(const std::function<void(uint32_t*)>& f);
-  inline void ForEachInId(const std::function<void(const uint32_t*)>& f) const;
+  // Runs the given function |f| on all "in" operand ids.  |f| is any
+  // callable taking a uint32_t* (const uint32_t* for the const overload).
+  template <typename FunctionT>
+  inline void ForEachInId(const FunctionT& f);
+  template <typename FunctionT>
+  inline void ForEachInId(const FunctionT& f) const;
+
+  // Runs the given function |f| on every id-typed operand word, including
+  // the result type id and result id.  |f| is any callable taking a
+  // uint32_t* and may rewrite the ids; the cached type id and result id
+  // are refreshed from the operand words afterwards.  The id slots are
+  // precomputed at construction, so this touches exactly the id words
+  // instead of re-testing every operand type.
+  template <typename FunctionT>
+  inline void ForEachId(const FunctionT& f);
 
   // Returns true if any operands can be labels
   inline bool HasLabels() const;
 
+  // Returns a copy of this instruction with every "in" operand id replaced
+  // by |id_map| applied to it. The result type id and result id are copied
+  // unchanged; remap the result id afterwards with SetResultId if needed.
+  Instruction CloneWithMappedIds(
+      const std::function<uint32_t(uint32_t)>& id_map) const;
+
+  // Replaces the words of every literal-string operand with a single word
+  // holding an intern id from |pool|, releasing this instruction's own copy
+  // of each string. The pool must outlive the instruction. Serialization
+  // re-expands the strings, so the binary form is unchanged; until then two
+  // interned operands hold the same string exactly when their intern id
+  // words compare equal. Idempotent: a second call does nothing.
+  void InternStrings(StringPool* pool);
+  // Returns true if InternStrings() has replaced any operand.
+  bool HasInternedStrings() const { return interned_strings_ != nullptr; }
+
+  // The number of words the serialized operands occupy: NumOperandWords()
+  // with interned string operands counted at their expanded size.
+  uint32_t NumSerializedOperandWords() const;
+
   // Pushes the binary segments for this instruction into the back of *|binary|.
   void ToBinaryWithoutAttachedDebugInsts(std::vector<uint32_t>* binary) const;
+  // Writes the binary segments for this instruction to |binary|, which must
+  // have room for 1 + NumOperandWords() words.  Returns a pointer just past
+  // the last word written.
+  uint32_t* ToBinaryWithoutAttachedDebugInsts(uint32_t* binary) const;
+
+  // Returns an estimate in bytes of the heap storage owned by this
+  // instruction beyond the object itself: the flat operand words, the
+  // operand descriptors, and any attached debug line instructions together
+  // with their own storage.
+  size_t EstimateMemoryUsage() const;
 
  private:
+  // The containing InstructionList threads its elements through these links.
+  friend class InstructionList;
+
+  // Describes one logical operand: its type and where its words sit inside
+  // words_.
+  struct OperandSlot {
+    spv_operand_type_t type;  // Type of this logical operand.
+    uint32_t offset;          // Index of the operand's first word in words_.
+    uint32_t num_words;       // Number of words the operand occupies.
+  };
+
   // Returns the toal count of result type id and result id.
   uint32_t TypeResultIdCount() const {
     return (type_id_ != 0) + (result_id_ != 0);
   }
 
+  // Replaces the words of the |index|-th logical operand with |data|,
+  // growing or shrinking the flat word buffer and rebasing the trailing
+  // operand descriptors when the length changes.
+  void ReplaceOperandWords(uint32_t index, const std::vector<uint32_t>& data);
+
+  // Recomputes id_offsets_ from the operand descriptors.  Only needed when
+  // operand word offsets shift wholesale; appends maintain the list
+  // incrementally.
+  void RebuildIdOffsets();
+
+  // Intrusive links for the InstructionList holding this instruction, or
+  // null if it is not in a list.
+  Instruction* prev_inst_ = nullptr;
+  Instruction* next_inst_ = nullptr;
+
   SpvOp opcode_;        // Opcode
   uint32_t type_id_;    // Result type id. A value of 0 means no result type id.
   uint32_t result_id_;  // Result id. A value of 0 means no result id.
-  // All logical operands, including result type id and result id.
-  std::vector<Operand> operands_;
+  // Every operand's words, including the result type id and result id words,
+  // stored back to back in one contiguous buffer in instruction order.
+  std::vector<uint32_t> words_;
+  // One descriptor per logical operand, in instruction order, naming its
+  // type and its word range inside words_.
+  std::vector<OperandSlot> operands_;
+  // Offset in words_ of every id-typed operand word (result type id and
+  // result id included), in instruction order.  Computed once from the
+  // operand types so id-remapping loops touch exactly the id words.
+  std::vector<uint32_t> id_offsets_;
   // Opline and OpNoLine instructions preceding this instruction. Note that for
   // Instructions representing OpLine or OpNonLine itself, this field should be
-  // empty.
-  std::vector<Instruction> dbg_line_insts_;
+  // empty.  Kept behind a pointer because the vast majority of instructions
+  // carry no line info: a null pointer costs one word and no destructor
+  // walk, which keeps instruction traversal dense for all passes.
+  std::unique_ptr<std::vector<Instruction>> dbg_line_insts_;
+  // Bookkeeping for interned string operands: the pool holding the words
+  // and the logical operand indexes whose single word is an intern id.
+  // Null for the vast majority of instructions, which have none.
+  struct InternedStrings {
+    const StringPool* pool;
+    std::vector<uint32_t> operand_indexes;
+  };
+  std::unique_ptr<InternedStrings> interned_strings_;
 };
 
-inline const Operand& Instruction::GetOperand(uint32_t index) const {
+inline const std::vector<Instruction>& Instruction::dbg_line_insts() const {
+  static const std::vector<Instruction>* const kNoDbgLineInsts =
+      new std::vector<Instruction>();
+  return dbg_line_insts_ ? *dbg_line_insts_ : *kNoDbgLineInsts;
+}
+
+inline OperandRef Instruction::GetOperand(uint32_t index) const {
   assert(index < operands_.size() && "operand index out of bound");
-  return operands_[index];
+  const OperandSlot& slot = operands_[index];
+  return OperandRef(slot.type, words_.data() + slot.offset, slot.num_words);
 };
 
+inline void Instruction::AddOperand(spv_operand_type_t type,
+                                    std::vector<uint32_t>&& words) {
+  if (spvIsIdType(type))
+    id_offsets_.push_back(static_cast<uint32_t>(words_.size()));
+  operands_.push_back({type, static_cast<uint32_t>(words_.size()),
+                       static_cast<uint32_t>(words.size())});
+  words_.insert(words_.end(), words.begin(), words.end());
+}
+
 inline void Instruction::SetInOperand(uint32_t index,
                                       std::vector<uint32_t>&& data) {
   assert(index + TypeResultIdCount() < operands_.size() &&
          "operand index out of bound");
-  operands_[index + TypeResultIdCount()].words = std::move(data);
+  ReplaceOperandWords(index + TypeResultIdCount(), data);
 }
 
 inline void Instruction::SetResultId(uint32_t res_id) {
   result_id_ = res_id;
   auto ridx = (type_id_ != 0) ? 1 : 0;
   assert(operands_[ridx].type == SPV_OPERAND_TYPE_RESULT_ID);
-  operands_[ridx].words = {res_id};
+  words_[operands_[ridx].offset] = res_id;
 }
 
 inline void Instruction::SetResultType(uint32_t ty_id) {
   if (type_id_ != 0) {
     type_id_ = ty_id;
     assert(operands_.front().type == SPV_OPERAND_TYPE_TYPE_ID);
-    operands_.front().words = {ty_id};
+    words_[operands_.front().offset] = ty_id;
   }
 }
 
@@ -228,33 +483,48 @@ inline bool Instruction::IsNop() const {
 inline void Instruction::ToNop() {
   opcode_ = SpvOpNop;
   type_id_ = result_id_ = 0;
+  words_.clear();
   operands_.clear();
+  id_offsets_.clear();
+  interned_strings_.reset();
 }
 
-inline void Instruction::ForEachInst(const std::function<void(Instruction*)>& f,
+template <typename FunctionT>
+inline void Instruction::ForEachInst(const FunctionT& f,
                                      bool run_on_debug_line_insts) {
-  if (run_on_debug_line_insts)
-    for (auto& dbg_line : dbg_line_insts_) f(&dbg_line);
+  if (run_on_debug_line_insts && dbg_line_insts_)
+    for (auto& dbg_line : *dbg_line_insts_) f(&dbg_line);
   f(this);
 }
 
-inline void Instruction::ForEachInst(
-    const std::function<void(const Instruction*)>& f,
-    bool run_on_debug_line_insts) const {
-  if (run_on_debug_line_insts)
-    for (auto& dbg_line : dbg_line_insts_) f(&dbg_line);
+template <typename FunctionT>
+inline void Instruction::ForEachInst(const FunctionT& f,
+                                     bool run_on_debug_line_insts) const {
+  if (run_on_debug_line_insts && dbg_line_insts_)
+    for (const auto& dbg_line : *dbg_line_insts_) f(&dbg_line);
   f(this);
 }
 
-inline void Instruction::ForEachInId(const std::function<void(uint32_t*)>& f) {
+template <typename FunctionT>
+inline void Instruction::ForEachInId(const FunctionT& f) {
   for (auto& opnd : operands_)
-    if (opnd.type == SPV_OPERAND_TYPE_ID) f(&opnd.words[0]);
+    if (opnd.type == SPV_OPERAND_TYPE_ID) f(&words_[opnd.offset]);
 }
 
-inline void Instruction::ForEachInId(
-    const std::function<void(const uint32_t*)>& f) const {
+template <typename FunctionT>
+inline void Instruction::ForEachInId(const FunctionT& f) const {
   for (const auto& opnd : operands_)
-    if (opnd.type == SPV_OPERAND_TYPE_ID) f(&opnd.words[0]);
+    if (opnd.type == SPV_OPERAND_TYPE_ID) f(&words_[opnd.offset]);
+}
+
+template <typename FunctionT>
+inline void Instruction::ForEachId(const FunctionT& f) {
+  const bool has_type_id = type_id_ != 0;
+  const bool has_result_id = result_id_ != 0;
+  for (const uint32_t offset : id_offsets_) f(&words_[offset]);
+  if (has_type_id) type_id_ = words_[operands_.front().offset];
+  if (has_result_id)
+    result_id_ = words_[operands_[has_type_id ? 1 : 0].offset];
 }
 
 inline bool Instruction::HasLabels() const {
@@ -0,0 +1,49 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ir_journal.h"
+
+#include "basic_block.h"
+#include "instruction.h"
+
+namespace spvtools {
+namespace ir {
+
+thread_local IrJournal* JournalScope::current_ = nullptr;
+
+IrJournal::~IrJournal() {
+  // Committing: the erased instructions are no longer reachable from any
+  // list, so release them now.
+  for (const Entry& entry : entries_) {
+    if (entry.erased) delete entry.inst;
+  }
+}
+
+void IrJournal::Rollback() {
+  // Undo newest first, so each entry is inverted against the exact list
+  // state its mutation produced: by the time an erasure is undone, the
+  // neighbors its instruction still points at are alive and back in place.
+  for (auto it = entries_.rbegin(); it != entries_.rend(); ++it) {
+    if (it->erased) {
+      it->list->Relink(it->inst);
+    } else {
+      it->list->Unlink(it->inst);
+      delete it->inst;
+    }
+  }
+  entries_.clear();
+}
+
+}  // namespace ir
+}  // namespace spvtools
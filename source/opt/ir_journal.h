@@ -0,0 +1,137 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_IR_JOURNAL_H_
+#define LIBSPIRV_OPT_IR_JOURNAL_H_
+
+#include <vector>
+
+#include "arena.h"
+#include "module.h"
+
+namespace spvtools {
+namespace ir {
+
+// Records the intrusive-link mutations performed on InstructionLists while
+// activated through a JournalScope, so a speculative transformation can be
+// undone in time proportional to the number of changes instead of
+// re-parsing the original binary into fresh IR.
+//
+// An insertion is remembered so the inserted instruction can be unlinked
+// and destroyed again; an erasure hands the unlinked instruction to the
+// journal instead of destroying it, so a rollback can splice it back into
+// place. Destroying the journal without calling Rollback() commits the
+// changes and releases the deferred instructions.
+class IrJournal {
+ public:
+  IrJournal() {}
+  ~IrJournal();
+
+  IrJournal(const IrJournal&) = delete;
+  IrJournal& operator=(const IrJournal&) = delete;
+
+  // Undoes the recorded mutations, newest first, restoring every journaled
+  // list to the state it had when recording started. The journal is empty
+  // afterwards.
+  void Rollback();
+
+  // Returns the number of mutations recorded so far.
+  size_t NumChanges() const { return entries_.size(); }
+
+  // Called by InstructionList: records that |inst| was linked into |list|.
+  void RecordInsert(InstructionList* list, Instruction* inst) {
+    entries_.push_back({list, inst, false});
+  }
+  // Called by InstructionList: records that |inst| was unlinked from |list|
+  // and takes ownership of it until commit or rollback. The instruction's
+  // own link fields must still name its old neighbors.
+  void RecordErase(InstructionList* list, Instruction* inst) {
+    entries_.push_back({list, inst, true});
+  }
+
+ private:
+  // One recorded link mutation.
+  struct Entry {
+    InstructionList* list;  // The mutated list.
+    Instruction* inst;      // The instruction linked or unlinked.
+    bool erased;            // True for an erasure, false for an insertion.
+  };
+
+  std::vector<Entry> entries_;  // All mutations, in the order they happened.
+};
+
+// While alive, makes the given journal record the instruction-link
+// mutations performed on this thread. Scopes nest; the previous journal is
+// restored on destruction. Mirrors ArenaScope.
+class JournalScope {
+ public:
+  explicit JournalScope(IrJournal* journal) : previous_(current_) {
+    current_ = journal;
+  }
+  ~JournalScope() { current_ = previous_; }
+
+  JournalScope(const JournalScope&) = delete;
+  JournalScope& operator=(const JournalScope&) = delete;
+
+  // Returns the journal recording on this thread, or nullptr if none.
+  static IrJournal* Current() { return current_; }
+
+ private:
+  static thread_local IrJournal* current_;
+  IrJournal* const previous_;
+};
+
+// Captures what is needed to revert a speculative transformation of
+// |module| — e.g. trying an aggressive pass and backing out when the module
+// grows past a budget. Construction marks the module's arena and starts
+// journaling the instruction-link mutations on this thread; Rollback()
+// reverts them and rewinds the arena; destruction without a rollback
+// commits.
+//
+// Only what the journal sees is reverted: instruction insertions and
+// erasures within existing instruction lists. A speculative pass that also
+// adds blocks or functions, rewrites operands in place, or mints new ids
+// must restore that state itself or forgo rollback. Analyses kept in sync
+// through change listeners observe the speculative mutations but not the
+// rollback, so invalidate them after rolling back.
+class ModuleCheckpoint {
+ public:
+  explicit ModuleCheckpoint(Module* module)
+      : module_(module), mark_(module->arena().Mark()), scope_(&journal_) {}
+
+  ModuleCheckpoint(const ModuleCheckpoint&) = delete;
+  ModuleCheckpoint& operator=(const ModuleCheckpoint&) = delete;
+
+  // Returns the number of link mutations recorded so far.
+  size_t NumChanges() const { return journal_.NumChanges(); }
+
+  // Reverts the journaled mutations and returns the module's arena to its
+  // state at construction, reclaiming the storage of everything the
+  // speculative pass placed there.
+  void Rollback() {
+    journal_.Rollback();
+    module_->arena().Rollback(mark_);
+  }
+
+ private:
+  Module* module_;          // The module covered by this checkpoint.
+  Arena::Checkpoint mark_;  // The arena state at construction.
+  IrJournal journal_;       // The link mutations since construction.
+  JournalScope scope_;      // Keeps the journal recording while alive.
+};
+
+}  // namespace ir
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_IR_JOURNAL_H_
@@ -16,19 +16,227 @@
 
 #include "log.h"
 #include "reflect.h"
+#include "table.h"
 
 namespace spvtools {
 namespace ir {
 
+namespace {
+
+// Counts the OpLabel instructions in the instruction stream |words| of
+// |num_words| words (with no module header in front).  Each block starts
+// with exactly one OpLabel, so this is the block count of the functions the
+// stream spans.  Stops at a malformed word count.
+uint32_t CountLabels(const uint32_t* words, size_t num_words) {
+  uint32_t num_labels = 0;
+  for (size_t i = 0; i < num_words;) {
+    const uint32_t word_count = words[i] >> 16;
+    if (word_count == 0) break;
+    if ((words[i] & 0xffffu) == SpvOpLabel) ++num_labels;
+    i += word_count;
+  }
+  return num_labels;
+}
+
+// Rebuilds the IR for one deferred function body.  Receives the parsed
+// instructions of a synthetic module made of the original module's header
+// and out-of-function instructions followed by the function's word range,
+// and ignores everything up to and including the OpFunction: the function
+// definition instruction was already built during the initial load.
+class DeferredBodyBuilder {
+ public:
+  explicit DeferredBodyBuilder(Function* function)
+      : function_(function), in_function_(false) {}
+
+  bool AddInstruction(const spv_parsed_instruction_t* inst) {
+    // Put the rebuilt IR in the function's own body arena when it has one
+    // (parallel loading), otherwise in the arena of the owning module.
+    Arena* arena = function_->body_arena();
+    if (arena == nullptr && function_->module() != nullptr) {
+      arena = &function_->module()->arena();
+    }
+    ArenaScope arena_scope(arena);
+
+    const auto opcode = static_cast<SpvOp>(inst->opcode);
+    if (!in_function_) {
+      in_function_ = opcode == SpvOpFunction;
+      return true;
+    }
+    if (IsDebugLineInst(opcode)) {
+      dbg_line_info_.push_back(Instruction(*inst));
+      return true;
+    }
+
+    std::unique_ptr<Instruction> spv_inst(
+        new Instruction(*inst, std::move(dbg_line_info_)));
+    dbg_line_info_.clear();
+
+    if (opcode == SpvOpFunctionEnd) {
+      function_->SetFunctionEnd(std::move(spv_inst));
+    } else if (opcode == SpvOpFunctionParameter) {
+      function_->AddParameter(std::move(spv_inst));
+    } else if (opcode == SpvOpLabel) {
+      if (block_ != nullptr) return false;
+      block_.reset(new BasicBlock(std::move(spv_inst)));
+    } else if (IsTerminatorInst(opcode)) {
+      if (block_ == nullptr) return false;
+      block_->AddInstruction(std::move(spv_inst));
+      block_->SetParent(function_);
+      function_->AddBasicBlock(std::move(block_));
+      block_ = nullptr;
+    } else {
+      if (block_ == nullptr) return false;
+      block_->AddInstruction(std::move(spv_inst));
+    }
+    return true;
+  }
+
+ private:
+  // The function whose body is being rebuilt.
+  Function* function_;
+  // Whether the OpFunction has been seen yet.
+  bool in_function_;
+  // The basic block under construction.
+  std::unique_ptr<BasicBlock> block_;
+  // Line related debug instructions accumulated thus far.
+  std::vector<Instruction> dbg_line_info_;
+};
+
+// Processes a parsed instruction for DeferredBodyBuilder.  Meets the
+// interface requirement of spvBinaryParse().
+spv_result_t ForwardToDeferredBodyBuilder(void* builder,
+                                          const spv_parsed_instruction_t* inst) {
+  if (reinterpret_cast<DeferredBodyBuilder*>(builder)->AddInstruction(inst)) {
+    return SPV_SUCCESS;
+  }
+  return SPV_ERROR_INVALID_BINARY;
+}
+
+// Returns a callback that rebuilds a deferred function body by re-parsing
+// the |preamble| followed by the function's recorded word range under a
+// fresh context for |env|, reporting problems to |consumer|.
+std::function<bool(Function*)> MakeBodyMaterializer(
+    spv_target_env env, MessageConsumer consumer,
+    std::shared_ptr<std::vector<uint32_t>> preamble) {
+  return [env, consumer, preamble](Function* function) {
+    const std::vector<uint32_t>& body = function->deferred_body_words();
+    std::vector<uint32_t> binary;
+    binary.reserve(preamble->size() + body.size());
+    binary.insert(binary.end(), preamble->begin(), preamble->end());
+    binary.insert(binary.end(), body.begin(), body.end());
+
+    // Pre-size the block array from the recorded words, so the blocks built
+    // below land in one allocation.
+    function->ReserveBlocks(CountLabels(body.data(), body.size()));
+
+    spv_context context = spvContextCreate(env);
+    SetContextMessageConsumer(context, consumer);
+    DeferredBodyBuilder builder(function);
+    const spv_result_t status =
+        spvBinaryParse(context, &builder, binary.data(), binary.size(),
+                       nullptr, ForwardToDeferredBodyBuilder, nullptr);
+    spvContextDestroy(context);
+    return status == SPV_SUCCESS;
+  };
+}
+
+}  // anonymous namespace
+
 IrLoader::IrLoader(const MessageConsumer& consumer, Module* module)
     : consumer_(consumer),
       module_(module),
       source_("<instruction>"),
       inst_index_(0) {}
 
+void IrLoader::SetDeferFunctionBodies(spv_target_env env) {
+  defer_function_bodies_ = true;
+  deferred_env_ = env;
+  preamble_words_.reset(new std::vector<uint32_t>());
+}
+
+void IrLoader::PreScanFunctionBlockCounts(const uint32_t* binary,
+                                          size_t num_words) {
+  function_block_counts_.clear();
+  next_function_index_ = 0;
+  const size_t kHeaderWords = 5;
+  if (binary == nullptr || num_words <= kHeaderWords) return;
+  const uint32_t* words = binary + kHeaderWords;
+  bool in_function = false;
+  for (size_t i = 0, remaining = num_words - kHeaderWords; i < remaining;) {
+    const uint32_t word_count = words[i] >> 16;
+    if (word_count == 0) break;
+    const SpvOp opcode = static_cast<SpvOp>(words[i] & 0xffffu);
+    if (opcode == SpvOpFunction) {
+      function_block_counts_.push_back(0);
+      in_function = true;
+    } else if (opcode == SpvOpLabel && in_function) {
+      ++function_block_counts_.back();
+    } else if (opcode == SpvOpFunctionEnd) {
+      in_function = false;
+    }
+    i += word_count;
+  }
+}
+
 bool IrLoader::AddInstruction(const spv_parsed_instruction_t* inst) {
+  // Place the instruction, basic block, and function objects created below
+  // into the module's arena: they all live exactly as long as the module.
+  ArenaScope arena_scope(&module_->arena());
+
   ++inst_index_;
   const auto opcode = static_cast<SpvOp>(inst->opcode);
+
+  if (defer_function_bodies_) {
+    const uint32_t* words = inst->words;
+    const uint32_t* words_end = inst->words + inst->num_words;
+    if (function_ != nullptr || opcode == SpvOpFunction) {
+      // Record the function's raw word range instead of building IR for it.
+      if (opcode == SpvOpFunction) {
+        if (function_ != nullptr) {
+          Error(consumer_, source_.c_str(), {inst_index_, 0, 0},
+                "function inside function");
+          return false;
+        }
+        // Debug line instructions preceding the OpFunction belong to the
+        // function's word range, and also stay attached to the eagerly
+        // built function definition instruction.
+        deferred_body_words_ = std::move(pending_line_words_);
+        pending_line_words_.clear();
+        deferred_body_words_.insert(deferred_body_words_.end(), words,
+                                    words_end);
+        std::unique_ptr<Instruction> spv_inst(
+            new Instruction(*inst, std::move(dbg_line_info_)));
+        dbg_line_info_.clear();
+        function_.reset(new Function(std::move(spv_inst)));
+        return true;
+      }
+      deferred_body_words_.insert(deferred_body_words_.end(), words,
+                                  words_end);
+      if (opcode == SpvOpFunctionEnd) {
+        function_->SetDeferredBody(
+            std::move(deferred_body_words_),
+            MakeBodyMaterializer(deferred_env_, consumer_, preamble_words_));
+        deferred_body_words_.clear();
+        module_->AddFunction(std::move(function_));
+        function_ = nullptr;
+      }
+      return true;
+    }
+    // Outside function definitions: extend the preamble used to re-parse
+    // deferred bodies, then fall through to ordinary IR construction.
+    // Debug line instructions are held back until it is known whether they
+    // precede a global instruction or an OpFunction.
+    if (IsDebugLineInst(opcode)) {
+      pending_line_words_.insert(pending_line_words_.end(), words, words_end);
+    } else {
+      preamble_words_->insert(preamble_words_->end(),
+                              pending_line_words_.begin(),
+                              pending_line_words_.end());
+      pending_line_words_.clear();
+      preamble_words_->insert(preamble_words_->end(), words, words_end);
+    }
+  }
+
   if (IsDebugLineInst(opcode)) {
     dbg_line_info_.push_back(Instruction(*inst));
     return true;
@@ -49,6 +257,9 @@ bool IrLoader::AddInstruction(const spv_parsed_instruction_t* inst) {
       return false;
     }
     function_.reset(new Function(std::move(spv_inst)));
+    if (next_function_index_ < function_block_counts_.size()) {
+      function_->ReserveBlocks(function_block_counts_[next_function_index_++]);
+    }
   } else if (opcode == SpvOpFunctionEnd) {
     if (function_ == nullptr) {
       Error(consumer_, src, loc,
@@ -144,13 +355,26 @@ void IrLoader::EndModule() {
     // We're in the middle of a function, but the OpFunctionEnd is missing.
     // Register the function anyway.  This lets us write tests with less
     // boilerplate.
+    if (defer_function_bodies_) {
+      function_->SetDeferredBody(
+          std::move(deferred_body_words_),
+          MakeBodyMaterializer(deferred_env_, consumer_, preamble_words_));
+      deferred_body_words_.clear();
+    }
     module_->AddFunction(std::move(function_));
     function_ = nullptr;
   }
   for (auto& function : *module_) {
-    for (auto& bb : function) bb.SetParent(&function);
+    // Iterating the blocks of a deferred function would force its IR to be
+    // built; the materializer sets block parents itself.
+    if (!function.HasDeferredBody()) {
+      for (auto& bb : function) bb.SetParent(&function);
+    }
     function.SetParent(module_);
   }
+  // Interning is transparent: serialization re-expands the strings, so the
+  // loaded module round-trips byte-for-byte.
+  module_->InternDebugStrings();
 }
 
 }  // namespace ir
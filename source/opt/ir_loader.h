@@ -44,11 +44,32 @@ class IrLoader {
   // Sets the source name of the module.
   void SetSource(const std::string& src) { source_ = src; }
 
+  // Enables lazy loading of function bodies.  Instead of building IR for
+  // every function up front, each function keeps the raw word range of its
+  // OpFunction..OpFunctionEnd instructions and only builds the IR when a
+  // pass first touches it; functions that stay untouched are written back
+  // verbatim by Module::ToBinary.  A body is rebuilt by re-parsing its words
+  // against the given target |env|, which should match the environment the
+  // module is being decoded for.  Must be called before any instruction is
+  // added.
+  void SetDeferFunctionBodies(spv_target_env env);
+
   // Sets the fields in the module's header to the given parameters.
   void SetModuleHeader(uint32_t magic, uint32_t version, uint32_t generator,
                        uint32_t bound, uint32_t reserved) {
     module_->SetHeader({magic, version, generator, bound, reserved});
+    if (defer_function_bodies_) {
+      *preamble_words_ = {magic, version, generator, bound, reserved};
+    }
   }
+  // Scans the raw |binary| of |num_words| words (including the module
+  // header) once and records the basic block count of every function, in
+  // module order.  AddInstruction() then pre-sizes each function's block
+  // array as the function is created.  Only useful when function bodies are
+  // built eagerly; deferred bodies pre-scan their own word range when they
+  // are materialized.
+  void PreScanFunctionBlockCounts(const uint32_t* binary, size_t num_words);
+
   // Adds an instruction to the module. Returns true if no error occurs. This
   // method will properly capture and store the data provided in |inst| so that
   // |inst| is no longer needed after returning.
@@ -74,6 +95,24 @@ class IrLoader {
   std::unique_ptr<BasicBlock> block_;
   // Line related debug instructions accumulated thus far.
   std::vector<Instruction> dbg_line_info_;
+
+  // Whether function bodies are kept as raw word ranges instead of being
+  // built into IR, and the environment used to re-parse them on demand.
+  bool defer_function_bodies_ = false;
+  spv_target_env deferred_env_ = SPV_ENV_UNIVERSAL_1_0;
+  // The header and all instructions outside function definitions, used as
+  // the parsing preamble when a deferred body is rebuilt.  Shared with the
+  // materializer of every deferred function.
+  std::shared_ptr<std::vector<uint32_t>> preamble_words_;
+  // The raw words of the function currently being recorded.
+  std::vector<uint32_t> deferred_body_words_;
+  // Raw words of debug line instructions not yet assigned to the preamble
+  // or to a function's word range.
+  std::vector<uint32_t> pending_line_words_;
+  // Per-function basic block counts recorded by PreScanFunctionBlockCounts,
+  // in module order, and the index of the next function to be created.
+  std::vector<uint32_t> function_block_counts_;
+  size_t next_function_index_ = 0;
 };
 
 }  // namespace ir
@@ -0,0 +1,217 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ir_snapshot.h"
+
+#include <vector>
+
+#include "ir_loader.h"
+#include "make_unique.h"
+#include "opcode.h"
+#include "spirv_constant.h"
+#include "spirv_endian.h"
+#include "table.h"
+
+namespace spvtools {
+
+namespace {
+
+// Snapshot word layout:
+//   [0] magic  [1] format version  [2] content hash, low word
+//   [3] content hash, high word    [4] module word count
+//   [5] instruction record count
+//   [6 ..]     the endian-fixed module words
+//   then one record per instruction, in module order:
+//     [0] ext_inst_type  [1] type_id  [2] result_id  [3] operand count
+//     then 3 words per operand:
+//       [0] offset | num_words << 16
+//       [1] type | number_kind << 16
+//       [2] number_bit_width
+// An instruction's word offset is not stored: instructions are contiguous
+// from the end of the module header, so the loader keeps a running cursor
+// and takes each word count from the instruction's own first word.
+const uint32_t kSnapshotMagic = 0x4e535053;  // "SPSN" when stored little-endian.
+const uint32_t kSnapshotVersion = 1;
+
+const size_t kMagicIndex = 0;
+const size_t kVersionIndex = 1;
+const size_t kHashLowIndex = 2;
+const size_t kHashHighIndex = 3;
+const size_t kModuleWordCountIndex = 4;
+const size_t kInstructionCountIndex = 5;
+const size_t kSnapshotHeaderWords = 6;
+
+const size_t kRecordFixedWords = 4;
+const size_t kWordsPerOperand = 3;
+
+// Returns the FNV-1a hash of the |num_words| words starting at |words|,
+// after conversion from |endian| to the host endianness.  Hashing the
+// converted words makes the stored hash independent of the host that wrote
+// the snapshot.
+uint64_t HashModuleWords(const uint32_t* words, size_t num_words,
+                         spv_endianness_t endian) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < num_words; ++i) {
+    hash ^= spvFixWord(words[i], endian);
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+// Appends the record for one parsed instruction to the snapshot under
+// construction, and bumps the record count in its header.  Meets the
+// interface requirement of spvBinaryParse().
+spv_result_t AppendInstructionRecord(void* user_data,
+                                     const spv_parsed_instruction_t* inst) {
+  auto* out = reinterpret_cast<std::vector<uint32_t>*>(user_data);
+  ++(*out)[kInstructionCountIndex];
+  out->push_back(inst->ext_inst_type);
+  out->push_back(inst->type_id);
+  out->push_back(inst->result_id);
+  out->push_back(inst->num_operands);
+  for (uint16_t i = 0; i < inst->num_operands; ++i) {
+    const spv_parsed_operand_t& operand = inst->operands[i];
+    out->push_back(uint32_t(operand.offset) |
+                   (uint32_t(operand.num_words) << 16));
+    out->push_back(uint32_t(operand.type) |
+                   (uint32_t(operand.number_kind) << 16));
+    out->push_back(operand.number_bit_width);
+  }
+  return SPV_SUCCESS;
+}
+
+}  // anonymous namespace
+
+bool SaveModuleSnapshot(spv_target_env env, MessageConsumer consumer,
+                        const uint32_t* binary, size_t size,
+                        std::vector<uint32_t>* snapshot) {
+  if (!binary || !snapshot) return false;
+  spv_const_binary_t input = {binary, size};
+  spv_endianness_t endian;
+  if (spvBinaryEndianness(&input, &endian) != SPV_SUCCESS) return false;
+
+  std::vector<uint32_t> out(kSnapshotHeaderWords + size);
+  out[kMagicIndex] = kSnapshotMagic;
+  out[kVersionIndex] = kSnapshotVersion;
+  const uint64_t hash = HashModuleWords(binary, size, endian);
+  out[kHashLowIndex] = uint32_t(hash);
+  out[kHashHighIndex] = uint32_t(hash >> 32);
+  out[kModuleWordCountIndex] = uint32_t(size);
+  out[kInstructionCountIndex] = 0;  // Counted up by the parse callback.
+  spvFixWords(binary, size, endian, out.data() + kSnapshotHeaderWords);
+
+  auto context = spvContextCreate(env);
+  SetContextMessageConsumer(context, consumer);
+  const spv_result_t status = spvBinaryParse(
+      context, &out, binary, size, nullptr, AppendInstructionRecord, nullptr);
+  spvContextDestroy(context);
+  if (status != SPV_SUCCESS) return false;
+
+  snapshot->insert(snapshot->end(), out.begin(), out.end());
+  return true;
+}
+
+std::unique_ptr<ir::Module> BuildModuleFromSnapshot(MessageConsumer consumer,
+                                                    const uint32_t* binary,
+                                                    size_t size,
+                                                    const uint32_t* snapshot,
+                                                    size_t snapshot_size) {
+  if (!binary || !snapshot) return nullptr;
+  if (snapshot_size < kSnapshotHeaderWords) return nullptr;
+  if (snapshot[kMagicIndex] != kSnapshotMagic) return nullptr;
+  if (snapshot[kVersionIndex] != kSnapshotVersion) return nullptr;
+  const uint32_t num_module_words = snapshot[kModuleWordCountIndex];
+  const uint32_t num_records = snapshot[kInstructionCountIndex];
+  if (num_module_words < SPV_INDEX_INSTRUCTION) return nullptr;
+  if (num_module_words > snapshot_size - kSnapshotHeaderWords) return nullptr;
+
+  // The snapshot only speaks for the binary it was written from.
+  if (num_module_words != size) return nullptr;
+  spv_const_binary_t current = {binary, size};
+  spv_endianness_t endian;
+  if (spvBinaryEndianness(&current, &endian) != SPV_SUCCESS) return nullptr;
+  const uint64_t hash = HashModuleWords(binary, size, endian);
+  if (snapshot[kHashLowIndex] != uint32_t(hash) ||
+      snapshot[kHashHighIndex] != uint32_t(hash >> 32)) {
+    return nullptr;
+  }
+
+  const uint32_t* module_words = snapshot + kSnapshotHeaderWords;
+  auto module = MakeUnique<ir::Module>();
+  ir::IrLoader loader(consumer, module.get());
+  loader.PreScanFunctionBlockCounts(module_words, num_module_words);
+  loader.SetModuleHeader(module_words[SPV_INDEX_MAGIC_NUMBER],
+                         module_words[SPV_INDEX_VERSION_NUMBER],
+                         module_words[SPV_INDEX_GENERATOR_NUMBER],
+                         module_words[SPV_INDEX_BOUND],
+                         module_words[SPV_INDEX_SCHEMA]);
+
+  size_t record = kSnapshotHeaderWords + num_module_words;
+  size_t cursor = SPV_INDEX_INSTRUCTION;
+  std::vector<spv_parsed_operand_t> operands;
+  for (uint32_t i = 0; i < num_records; ++i) {
+    if (cursor >= num_module_words) return nullptr;
+    uint16_t inst_word_count = 0;
+    uint16_t opcode = 0;
+    spvOpcodeSplit(module_words[cursor], &inst_word_count, &opcode);
+    if (inst_word_count == 0 ||
+        inst_word_count > num_module_words - cursor) {
+      return nullptr;
+    }
+    if (snapshot_size - record < kRecordFixedWords) return nullptr;
+
+    spv_parsed_instruction_t inst = {};
+    inst.words = module_words + cursor;
+    inst.num_words = inst_word_count;
+    inst.opcode = opcode;
+    inst.ext_inst_type =
+        static_cast<spv_ext_inst_type_t>(snapshot[record + 0]);
+    inst.type_id = snapshot[record + 1];
+    inst.result_id = snapshot[record + 2];
+    const uint32_t num_operands = snapshot[record + 3];
+    record += kRecordFixedWords;
+    if (num_operands > UINT16_MAX) return nullptr;
+    if ((snapshot_size - record) / kWordsPerOperand < num_operands) {
+      return nullptr;
+    }
+
+    operands.clear();
+    operands.reserve(num_operands);
+    for (uint32_t j = 0; j < num_operands; ++j) {
+      spv_parsed_operand_t operand;
+      operand.offset = uint16_t(snapshot[record + 0] & 0xffff);
+      operand.num_words = uint16_t(snapshot[record + 0] >> 16);
+      operand.type =
+          static_cast<spv_operand_type_t>(snapshot[record + 1] & 0xffff);
+      operand.number_kind =
+          static_cast<spv_number_kind_t>(snapshot[record + 1] >> 16);
+      operand.number_bit_width = snapshot[record + 2];
+      operands.push_back(operand);
+      record += kWordsPerOperand;
+    }
+    inst.operands = operands.data();
+    inst.num_operands = uint16_t(num_operands);
+
+    if (!loader.AddInstruction(&inst)) return nullptr;
+    cursor += inst_word_count;
+  }
+  // Every module word and every record word must be accounted for.
+  if (cursor != num_module_words) return nullptr;
+  if (record != snapshot_size) return nullptr;
+
+  loader.EndModule();
+  return module;
+}
+
+}  // namespace spvtools
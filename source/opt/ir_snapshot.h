@@ -0,0 +1,59 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SPIRV_TOOLS_OPT_IR_SNAPSHOT_H_
+#define SPIRV_TOOLS_OPT_IR_SNAPSHOT_H_
+
+#include <memory>
+#include <vector>
+
+#include "module.h"
+#include "spirv-tools/libspirv.hpp"
+
+namespace spvtools {
+
+// A snapshot caches the decoded instruction stream of a module so that a
+// later run can rebuild the ir::Module without re-running the grammar-driven
+// operand decoder, which dominates BuildModule time.  The format is a flat,
+// versioned word stream with no internal pointers, so a tool can write it to
+// a file next to the shader binary and map it straight back in: a header
+// carrying a content hash of the binary, the endian-fixed module words, and
+// one record per instruction holding the fields spvBinaryParse would have
+// produced.  A snapshot is only honored when its stored hash matches the
+// binary presented at load time, so a stale cache degrades to an ordinary
+// rebuild rather than a wrong module.
+
+// Parses the SPIR-V |binary| of |size| words against the given target |env|
+// and appends its snapshot to |*snapshot|.  Returns false (leaving
+// |*snapshot| unchanged) if the binary does not parse; errors go to
+// |consumer|.
+bool SaveModuleSnapshot(spv_target_env env, MessageConsumer consumer,
+                        const uint32_t* binary, size_t size,
+                        std::vector<uint32_t>* snapshot);
+
+// Builds and returns an ir::Module from the |snapshot| of |snapshot_size|
+// words, provided the snapshot is well formed, carries a version this
+// library understands, and its stored content hash matches the SPIR-V
+// |binary| of |size| words.  Returns nullptr otherwise, in which case the
+// caller should fall back to BuildModule().  Only the snapshot's own words
+// are read after validation, so |binary| may be released once this returns.
+std::unique_ptr<ir::Module> BuildModuleFromSnapshot(MessageConsumer consumer,
+                                                    const uint32_t* binary,
+                                                    size_t size,
+                                                    const uint32_t* snapshot,
+                                                    size_t snapshot_size);
+
+}  // namespace spvtools
+
+#endif  // SPIRV_TOOLS_OPT_IR_SNAPSHOT_H_
@@ -0,0 +1,243 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "licm_pass.h"
+
+#include <algorithm>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+// Indices of operands in SPIR-V instructions
+static const int kSpvLoadPtrId = 2;
+static const int kSpvAccessChainBaseId = 2;
+static const int kSpvVariableStorageClass = 2;
+static const int kSpvTypePointerTypeId = 2;
+static const int kSpvTypeArrayElementTypeId = 1;
+static const int kSpvDecorateDecoration = 1;
+
+// Returns true if an instruction with |opcode| computes its result from its
+// operands alone and may be executed speculatively, so an invariant instance
+// can move ahead of the loop guard. The ranges follow the opcode numbering
+// of the SPIR-V specification, like the local-cse pass; integer division and
+// remainder are excluded because speculating them past the guard could
+// divide by zero on an iteration that never runs.
+bool IsHoistableComputation(SpvOp opcode) {
+  switch (opcode) {
+    case SpvOpUDiv:
+    case SpvOpSDiv:
+    case SpvOpUMod:
+    case SpvOpSRem:
+    case SpvOpSMod:
+      return false;
+    default:
+      break;
+  }
+  return (opcode >= SpvOpAccessChain &&
+          opcode <= SpvOpInBoundsPtrAccessChain) ||
+         (opcode >= SpvOpVectorExtractDynamic && opcode <= SpvOpTranspose) ||
+         (opcode >= SpvOpConvertFToU && opcode <= SpvOpBitcast) ||
+         (opcode >= SpvOpSNegate && opcode <= SpvOpSMulExtended) ||
+         (opcode >= SpvOpAny && opcode <= SpvOpFUnordGreaterThanEqual) ||
+         (opcode >= SpvOpShiftRightLogical && opcode <= SpvOpBitCount);
+}
+
+// Returns true if the load |inst| reads memory the shader cannot write, so
+// hoisting it out of a loop cannot change the value loaded. The pointer is
+// traced through access chains to its variable; UniformConstant, Input and
+// PushConstant storage is always read-only, and Uniform storage is read-only
+// unless the pointee — behind any level of arraying — carries the
+// BufferBlock decoration that turns it into a writable storage buffer.
+bool IsHoistableLoad(const ir::Instruction& inst,
+                     analysis::DefUseManager* def_use) {
+  // Memory access operands (e.g. Volatile) keep the load where it is.
+  if (inst.NumOperands() != 3) return false;
+  uint32_t ptr_id = inst.GetSingleWordOperand(kSpvLoadPtrId);
+  for (;;) {
+    ir::Instruction* def = def_use->GetDef(ptr_id);
+    if (def == nullptr) return false;
+    if (def->opcode() == SpvOpAccessChain ||
+        def->opcode() == SpvOpInBoundsAccessChain) {
+      ptr_id = def->GetSingleWordOperand(kSpvAccessChainBaseId);
+      continue;
+    }
+    if (def->opcode() != SpvOpVariable) return false;
+    switch (def->GetSingleWordOperand(kSpvVariableStorageClass)) {
+      case SpvStorageClassUniformConstant:
+      case SpvStorageClassInput:
+      case SpvStorageClassPushConstant:
+        return true;
+      case SpvStorageClassUniform: {
+        const ir::Instruction* ptr_type = def_use->GetDef(def->type_id());
+        uint32_t pointee_id =
+            ptr_type->GetSingleWordOperand(kSpvTypePointerTypeId);
+        // An arrayed storage buffer is an array (or runtime array) of
+        // BufferBlock-decorated structs; the decoration sits on the element
+        // type, so unwrap any arraying before looking for it.
+        const ir::Instruction* pointee = def_use->GetDef(pointee_id);
+        while (pointee != nullptr &&
+               (pointee->opcode() == SpvOpTypeArray ||
+                pointee->opcode() == SpvOpTypeRuntimeArray)) {
+          pointee_id =
+              pointee->GetSingleWordOperand(kSpvTypeArrayElementTypeId);
+          pointee = def_use->GetDef(pointee_id);
+        }
+        for (const ir::Instruction* anno :
+             def_use->GetAnnotationSpan(pointee_id)) {
+          if (anno->opcode() == SpvOpDecorate &&
+              anno->GetSingleWordOperand(kSpvDecorateDecoration) ==
+                  SpvDecorationBufferBlock)
+            return false;
+        }
+        return true;
+      }
+      default:
+        return false;
+    }
+  }
+}
+
+// Returns true if |inst| is hoistable and every id it reads is defined
+// outside the loop, i.e. outside |defined_in_loop|.
+bool IsInvariant(const ir::Instruction& inst,
+                 const std::unordered_set<uint32_t>& defined_in_loop,
+                 analysis::DefUseManager* def_use) {
+  if (inst.result_id() == 0) return false;
+  if (inst.opcode() == SpvOpLoad) {
+    if (!IsHoistableLoad(inst, def_use)) return false;
+  } else if (!IsHoistableComputation(inst.opcode())) {
+    return false;
+  }
+  bool invariant = true;
+  inst.ForEachInId([&invariant, &defined_in_loop](const uint32_t* id) {
+    if (defined_in_loop.count(*id)) invariant = false;
+  });
+  return invariant;
+}
+
+}  // anonymous namespace
+
+bool LicmPass::ProcessLoop(const analysis::FunctionCfg::Loop& loop,
+                           const analysis::FunctionCfg& cfg,
+                           analysis::DefUseManager* def_use) {
+  // The loop is only touched when it has a preheader to hoist into: a
+  // single out-of-loop predecessor of the header that falls through with an
+  // unconditional branch. Structured code produced by front-ends has one;
+  // restructuring the CFG to create one is not this pass's business.
+  std::unordered_set<const ir::BasicBlock*> in_loop(loop.blocks.begin(),
+                                                    loop.blocks.end());
+  ir::BasicBlock* preheader = nullptr;
+  for (ir::BasicBlock* pred : cfg.predecessors(loop.header)) {
+    if (in_loop.count(pred)) continue;
+    if (preheader != nullptr) return false;
+    preheader = pred;
+  }
+  if (preheader == nullptr || preheader->begin() == preheader->end())
+    return false;
+  // Hoisted instructions go right before the branch to the header, or
+  // before the merge instruction glued to it when the preheader is itself
+  // a header.
+  auto insert_point = preheader->end();
+  --insert_point;
+  if (insert_point->opcode() != SpvOpBranch) return false;
+  if (insert_point != preheader->begin()) {
+    auto prev = insert_point;
+    --prev;
+    if (prev->opcode() == SpvOpLoopMerge ||
+        prev->opcode() == SpvOpSelectionMerge)
+      insert_point = prev;
+  }
+
+  // Every id defined inside the loop; an instruction reading none of them
+  // computes the same value on every iteration.
+  std::unordered_set<uint32_t> defined_in_loop;
+  for (ir::BasicBlock* block : loop.blocks) {
+    defined_in_loop.insert(block->id());
+    for (auto inst = block->begin(); inst != block->end(); ++inst) {
+      if (inst->result_id() != 0) defined_in_loop.insert(inst->result_id());
+    }
+  }
+
+  // Visit the loop blocks in reverse postorder so definitions are seen
+  // before their uses; one sweep then hoists whole chains of invariant
+  // instructions in dependency order.
+  bool modified = false;
+  const std::vector<ir::BasicBlock*>& postorder = cfg.postorder();
+  for (auto block = postorder.rbegin(); block != postorder.rend(); ++block) {
+    if (!in_loop.count(*block)) continue;
+    for (auto inst = (*block)->begin(); inst != (*block)->end(); ++inst) {
+      if (!IsInvariant(*inst, defined_in_loop, def_use)) continue;
+      // Move the instruction by inserting a copy under a fresh id into the
+      // preheader and retiring the original, the same replace-and-kill
+      // sequence the local-cse pass uses.
+      const uint32_t old_id = inst->result_id();
+      const uint32_t new_id = TakeNextId();
+      std::unique_ptr<ir::Instruction> copy(new ir::Instruction(*inst));
+      copy->SetResultId(new_id);
+      auto pos = insert_point.InsertBefore(std::move(copy));
+      def_use->AnalyzeInstDefUse(&*pos);
+      def_use->ReplaceAllUsesWith(old_id, new_id);
+      def_use->KillInst(&*inst);
+      defined_in_loop.erase(old_id);
+      modified = true;
+    }
+  }
+  return modified;
+}
+
+bool LicmPass::ProcessFunction(ir::Function* func,
+                               analysis::DefUseManager* def_use,
+                               analysis::CfgManager* cfgs) {
+  if (func->begin() == func->end()) return false;
+  const analysis::FunctionCfg& cfg = cfgs->GetCfg(func);
+  if (cfg.loops().empty()) return false;
+
+  // Inner loops are processed before the loops containing them, so a value
+  // hoisted into an inner preheader can be hoisted again by the enclosing
+  // loop. A loop always has more blocks than the loops nested in it, which
+  // makes the block count a valid processing order.
+  std::vector<const analysis::FunctionCfg::Loop*> loops;
+  for (const analysis::FunctionCfg::Loop& loop : cfg.loops())
+    loops.push_back(&loop);
+  std::stable_sort(loops.begin(), loops.end(),
+                   [](const analysis::FunctionCfg::Loop* lhs,
+                      const analysis::FunctionCfg::Loop* rhs) {
+                     return lhs->blocks.size() < rhs->blocks.size();
+                   });
+
+  bool modified = false;
+  for (const analysis::FunctionCfg::Loop* loop : loops)
+    modified |= ProcessLoop(*loop, cfg, def_use);
+  return modified;
+}
+
+Pass::Status LicmPass::Process(ir::Module* module) {
+  module_ = module;
+  analysis::DefUseManager* def_use = analyses(module)->GetDefUse();
+  analysis::CfgManager* cfgs = analyses(module)->GetCfgs();
+  bool modified = false;
+  for (auto& func : *module) {
+    modified |= ProcessFunction(&func, def_use, cfgs);
+  }
+  module->FinalizeIdBound();
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
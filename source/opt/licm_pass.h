@@ -0,0 +1,63 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_LICM_PASS_H_
+#define LIBSPIRV_OPT_LICM_PASS_H_
+
+#include "cfg.h"
+#include "def_use_manager.h"
+#include "function.h"
+#include "module.h"
+#include "pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class LicmPass : public Pass {
+ public:
+  LicmPass() : module_(nullptr) {}
+  const char* name() const override { return "licm"; }
+  Status Process(ir::Module*) override;
+
+  // The def-use analysis is kept current through DefUseManager (hoisted
+  // copies are analyzed explicitly), and moving straight-line instructions
+  // between existing blocks does not shape the CFG.
+  uint32_t GetPreservedAnalyses() const override {
+    return AnalysisManager::kAnalysisAll;
+  }
+
+ private:
+  // Return the next available id from the module's allocator.
+  inline uint32_t TakeNextId() { return module_->id_allocator().TakeNextId(); }
+
+  // Hoists the invariant instructions out of the loops of |func|. Returns
+  // true if anything was hoisted.
+  bool ProcessFunction(ir::Function* func, analysis::DefUseManager* def_use,
+                       analysis::CfgManager* cfgs);
+
+  // Hoists the invariant instructions of |loop| into its preheader. Returns
+  // true if anything was hoisted.
+  bool ProcessLoop(const analysis::FunctionCfg::Loop& loop,
+                   const analysis::FunctionCfg& cfg,
+                   analysis::DefUseManager* def_use);
+
+  // The module being processed.
+  ir::Module* module_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_LICM_PASS_H_
@@ -0,0 +1,344 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "link.h"
+
+#include <algorithm>
+#include <cassert>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "reflect.h"
+
+namespace spvtools {
+
+namespace {
+
+using ir::Instruction;
+using ir::Module;
+
+// Appends the bytes of |word| to |key|.
+void AppendWord(std::string* key, uint32_t word) {
+  key->append(reinterpret_cast<const char*>(&word), sizeof(word));
+}
+
+// Returns true for instructions whose structurally identical occurrences
+// may collapse to one definition: types (except forward pointer
+// declarations, whose operands are not yet resolved where they appear) and
+// front-end constants.  Spec constants stay per-module since their
+// specialization state is external, and variables have identity.
+bool IsInternCandidate(SpvOp opcode) {
+  if (ir::IsTypeInst(opcode)) return opcode != SpvOpTypeForwardPointer;
+  return opcode >= SpvOpConstantTrue && opcode <= SpvOpConstantNull;
+}
+
+// One import or export declared through a LinkageAttributes decoration.
+struct LinkageSymbol {
+  size_t module_index;  // Which input module declares it.
+  uint32_t id;          // The decorated id, in that module's numbering.
+  std::string name;     // The linkage name.
+};
+
+// Merges modules; see Link() below for the contract.
+class Linker {
+ public:
+  Linker(const std::vector<Module*>& modules, const MessageConsumer& consumer)
+      : consumer_(consumer), next_id_(1) {
+    states_.reserve(modules.size());
+    for (Module* module : modules) {
+      states_.push_back(ModuleState{
+          module,
+          std::vector<uint32_t>(
+              std::max(module->id_bound(), module->ComputeIdBound()), 0u),
+          {}});
+    }
+  }
+
+  bool Run(std::vector<uint32_t>* linked_binary);
+
+ private:
+  // Per input module: the module, its old-id to output-id map (0 means
+  // unassigned), and the ids its annotations mention.
+  struct ModuleState {
+    Module* module;
+    std::vector<uint32_t> remap;
+    std::unordered_set<uint32_t> decorated_ids;
+  };
+
+  void Error(const std::string& message) {
+    if (consumer_) consumer_(SPV_MSG_ERROR, "link", {0, 0, 0}, message.c_str());
+  }
+
+  // Returns the output id for |old_id| of |state|'s module, assigning the
+  // next unused one the first time the id is seen.
+  uint32_t MapId(ModuleState* state, uint32_t old_id) {
+    assert(old_id < state->remap.size() && "id exceeds the id bound");
+    uint32_t& slot = state->remap[old_id];
+    if (slot == 0) slot = next_id_++;
+    return slot;
+  }
+
+  // Returns the interning key of |inst|: its opcode and its operand words,
+  // with every id operand already translated to the output numbering and
+  // the result id excluded.  Equal keys mean structurally identical
+  // definitions, since operands of types and constants are themselves
+  // already interned when their users are reached.
+  std::string InternKey(ModuleState* state, const Instruction& inst) {
+    std::string key;
+    AppendWord(&key, inst.opcode());
+    for (const auto& operand : inst) {
+      if (operand.type == SPV_OPERAND_TYPE_RESULT_ID) continue;
+      if (spvIsIdType(operand.type)) {
+        AppendWord(&key, MapId(state, operand.words[0]));
+      } else {
+        for (const uint32_t word : operand.words) AppendWord(&key, word);
+      }
+    }
+    return key;
+  }
+
+  // Interns the result id of |inst|: maps it to the output id of an
+  // already-seen identical definition and drops the instruction, or assigns
+  // it a fresh output id and registers the definition.
+  void InternInstruction(ModuleState* state, Instruction* inst) {
+    // An id that was already assigned was forward-referenced (a pointer to
+    // a not-yet-declared struct); keep such a definition as it is.
+    if (state->remap[inst->result_id()] != 0) return;
+    const std::string key = InternKey(state, *inst);
+    const auto insertion = intern_table_.insert({key, 0u});
+    if (insertion.second) {
+      insertion.first->second = MapId(state, inst->result_id());
+    } else {
+      state->remap[inst->result_id()] = insertion.first->second;
+      inst->ToNop();
+    }
+  }
+
+  // Records the imports and exports declared by |state|'s annotations, and
+  // collects every id its annotations mention (such ids never dedup, since
+  // merging them could merge distinct decorations).
+  void CollectAnnotationInfo(size_t module_index);
+
+  // Redirects resolved imports to their exports and removes the importing
+  // declarations with their names and decorations.
+  void ResolveImports();
+
+  // Appends the non-OpNop instructions of |range| to |binary|.  When
+  // |dedup| is given, an instruction whose serialized words were already
+  // seen by that set is skipped.
+  template <typename Range>
+  void AppendSection(const Range& range, std::vector<uint32_t>* binary,
+                     std::unordered_set<std::string>* dedup = nullptr) {
+    for (const Instruction& inst : range) {
+      if (inst.IsNop()) continue;
+      if (dedup) {
+        std::vector<uint32_t> words;
+        inst.ToBinaryWithoutAttachedDebugInsts(&words);
+        std::string key;
+        for (const uint32_t word : words) AppendWord(&key, word);
+        if (!dedup->insert(key).second) continue;
+        binary->insert(binary->end(), words.begin(), words.end());
+      } else {
+        inst.ToBinaryWithoutAttachedDebugInsts(binary);
+      }
+    }
+  }
+
+  const MessageConsumer& consumer_;
+  std::vector<ModuleState> states_;
+  uint32_t next_id_;  // The next unused output id.
+
+  // Interning key -> output id of the first occurrence.
+  std::unordered_map<std::string, uint32_t> intern_table_;
+
+  std::vector<LinkageSymbol> imports_;
+  // Linkage name -> exporting occurrence.  The first export of a name wins.
+  std::unordered_map<std::string, LinkageSymbol> exports_;
+};
+
+void Linker::CollectAnnotationInfo(size_t module_index) {
+  ModuleState& state = states_[module_index];
+  for (const Instruction& inst : state.module->annotations()) {
+    inst.ForEachInId([&state](const uint32_t* id) {
+      state.decorated_ids.insert(*id);
+    });
+    if (inst.opcode() != SpvOpDecorate) continue;
+    if (inst.GetSingleWordOperand(1) != SpvDecorationLinkageAttributes)
+      continue;
+    const auto name_words = inst.GetOperand(2).words;
+    const char* name = reinterpret_cast<const char*>(name_words.data());
+    LinkageSymbol symbol = {module_index, inst.GetSingleWordOperand(0), name};
+    if (inst.GetSingleWordOperand(inst.NumOperands() - 1) ==
+        SpvLinkageTypeImport) {
+      imports_.push_back(std::move(symbol));
+    } else {
+      exports_.insert({symbol.name, symbol});
+    }
+  }
+}
+
+void Linker::ResolveImports() {
+  for (const LinkageSymbol& import : imports_) {
+    const auto exported = exports_.find(import.name);
+    if (exported == exports_.end()) continue;  // Leave unresolved imports.
+    ModuleState& state = states_[import.module_index];
+    ModuleState& export_state = states_[exported->second.module_index];
+    // Redirect every reference to the import at the exported definition.
+    // The import id may already carry an output id; overwriting is safe
+    // because nothing has been rewritten to the output numbering yet.
+    state.remap[import.id] = MapId(&export_state, exported->second.id);
+    // Drop the importing declaration together with its decorations and
+    // debug names: the exported definition keeps its own.
+    const uint32_t import_id = import.id;
+    state.module->RemoveFunctionsIf([import_id](const ir::Function& func) {
+      return func.result_id() == import_id;
+    });
+    for (auto& inst : state.module->types_values()) {
+      if (inst.result_id() == import_id) inst.ToNop();
+    }
+    state.module->RemoveDebugAndAnnotationsIf(
+        [import_id](const Instruction& inst) {
+          switch (inst.opcode()) {
+            case SpvOpName:
+            case SpvOpMemberName:
+            case SpvOpDecorate:
+            case SpvOpMemberDecorate:
+              return inst.GetSingleWordOperand(0) == import_id;
+            default:
+              return false;
+          }
+        });
+  }
+}
+
+bool Linker::Run(std::vector<uint32_t>* linked_binary) {
+  if (states_.empty()) {
+    Error("No modules to link");
+    return false;
+  }
+
+  // The modules must agree on one memory model.
+  const Instruction* memory_model = states_[0].module->GetMemoryModel();
+  if (!memory_model) {
+    Error("Missing memory model");
+    return false;
+  }
+  std::vector<uint32_t> model_words;
+  memory_model->ToBinaryWithoutAttachedDebugInsts(&model_words);
+  for (size_t i = 1; i < states_.size(); ++i) {
+    std::vector<uint32_t> words;
+    const Instruction* other = states_[i].module->GetMemoryModel();
+    if (other) other->ToBinaryWithoutAttachedDebugInsts(&words);
+    if (words != model_words) {
+      Error("Memory models of the modules to link disagree");
+      return false;
+    }
+  }
+
+  for (size_t i = 0; i < states_.size(); ++i) CollectAnnotationInfo(i);
+
+  // Intern extended instruction set imports by their serialized operands
+  // (the set name), and types and constants structurally.  Definitions are
+  // visited in section order, so each instruction's operands are already in
+  // the output numbering when its key is built.
+  for (ModuleState& state : states_) {
+    for (auto& inst : state.module->ext_inst_imports()) {
+      InternInstruction(&state, &inst);
+    }
+    for (auto& inst : state.module->types_values()) {
+      if (IsInternCandidate(inst.opcode()) &&
+          !state.decorated_ids.count(inst.result_id())) {
+        InternInstruction(&state, &inst);
+      }
+    }
+  }
+
+  ResolveImports();
+
+  // Rewrite every id to the output numbering, assigning ids for anything
+  // not already covered above in order of first appearance.
+  for (ModuleState& state : states_) {
+    ModuleState* state_ptr = &state;
+    state.module->ForEachInst(
+        [this, state_ptr](Instruction* inst) {
+          inst->ForEachId([this, state_ptr](uint32_t* id) {
+            *id = MapId(state_ptr, *id);
+          });
+        },
+        true);
+  }
+
+  // Serialize the merged module, section by section in logical layout
+  // order.  Identical capabilities, extensions, debug instructions and
+  // annotations from different modules collapse to one occurrence; their
+  // words are fully remapped, so word equality is semantic equality.
+  linked_binary->clear();
+  uint32_t version = 0;
+  for (const ModuleState& state : states_) {
+    version = std::max(version, state.module->version());
+  }
+  linked_binary->push_back(SpvMagicNumber);
+  linked_binary->push_back(version);
+  linked_binary->push_back(states_[0].module->generator());
+  linked_binary->push_back(next_id_);
+  linked_binary->push_back(0u);  // Reserved schema word.
+
+  std::unordered_set<std::string> seen;
+  for (ModuleState& s : states_) AppendSection(s.module->capabilities(),
+                                               linked_binary, &seen);
+  seen.clear();
+  for (ModuleState& s : states_) AppendSection(s.module->extensions(),
+                                               linked_binary, &seen);
+  for (ModuleState& s : states_) AppendSection(s.module->ext_inst_imports(),
+                                               linked_binary);
+  linked_binary->insert(linked_binary->end(), model_words.begin(),
+                        model_words.end());
+  for (ModuleState& s : states_) AppendSection(s.module->entry_points(),
+                                               linked_binary);
+  for (ModuleState& s : states_) AppendSection(s.module->execution_modes(),
+                                               linked_binary);
+  seen.clear();
+  for (ModuleState& s : states_) AppendSection(s.module->debugs(),
+                                               linked_binary, &seen);
+  seen.clear();
+  for (ModuleState& s : states_) AppendSection(s.module->annotations(),
+                                               linked_binary, &seen);
+  for (ModuleState& s : states_) AppendSection(s.module->types_values(),
+                                               linked_binary);
+  for (ModuleState& s : states_) {
+    for (auto& func : *s.module) {
+      func.ForEachInst(
+          [linked_binary](const Instruction* inst) {
+            inst->ToBinaryWithoutAttachedDebugInsts(linked_binary);
+          },
+          true);
+    }
+  }
+  return true;
+}
+
+}  // anonymous namespace
+
+bool Link(const std::vector<ir::Module*>& modules,
+          std::vector<uint32_t>* linked_binary,
+          const MessageConsumer& consumer) {
+  std::vector<uint32_t> result;
+  Linker linker(modules, consumer);
+  if (!linker.Run(&result)) return false;
+  *linked_binary = std::move(result);
+  return true;
+}
+
+}  // namespace spvtools
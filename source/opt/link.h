@@ -0,0 +1,50 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_LINK_H_
+#define LIBSPIRV_OPT_LINK_H_
+
+#include <vector>
+
+#include "module.h"
+#include "spirv-tools/libspirv.hpp"
+
+namespace spvtools {
+
+// Links the given |modules| into a single module and writes its binary form
+// to |linked_binary|.  Returns true on success; on failure, reports the
+// problem through |consumer| and leaves |linked_binary| untouched.
+//
+// Sections are merged in the order the modules are given.  Duplicate
+// capabilities, extensions, and extended instruction set imports collapse to
+// one occurrence.  Structurally identical undecorated types and constants
+// are interned across modules, so each distinct definition appears once in
+// the output; ids are renumbered densely over the merged module.  Functions
+// and global variables declared with an Import linkage attribute resolve
+// against an Export of the same name from any module: the importing
+// declaration and its decorations are dropped and every reference is
+// redirected to the exported definition.  Imports without a matching export
+// are kept, so the result can itself be linked again.  All modules must
+// declare the same memory model.
+//
+// The input modules are consumed: their ids are rewritten to the output
+// numbering and deduplicated instructions are removed, so they should be
+// discarded afterwards.  Link time is linear in the total size of the
+// inputs.
+bool Link(const std::vector<ir::Module*>& modules,
+          std::vector<uint32_t>* linked_binary, const MessageConsumer& consumer);
+
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_LINK_H_
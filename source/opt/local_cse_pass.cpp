@@ -0,0 +1,149 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "local_cse_pass.h"
+
+#include <memory>
+
+#include "make_unique.h"
+#include "result_id_map.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+// Returns true if an instruction with |opcode| always computes the same
+// result from the same operands, so a duplicate within one block can reuse
+// an earlier result. OpLoad is handled separately since its result also
+// depends on memory contents. The ranges follow the opcode numbering of the
+// SPIR-V specification.
+bool IsPureComputation(SpvOp opcode) {
+  return (opcode >= SpvOpAccessChain &&
+          opcode <= SpvOpInBoundsPtrAccessChain) ||
+         (opcode >= SpvOpVectorExtractDynamic && opcode <= SpvOpTranspose) ||
+         (opcode >= SpvOpConvertFToU && opcode <= SpvOpBitcast) ||
+         (opcode >= SpvOpSNegate && opcode <= SpvOpSMulExtended) ||
+         (opcode >= SpvOpAny && opcode <= SpvOpFUnordGreaterThanEqual) ||
+         (opcode >= SpvOpShiftRightLogical && opcode <= SpvOpBitCount);
+}
+
+// Returns true if |opcode| takes exactly two value operands and yields the
+// same result when they are swapped, so their ids can be put in a canonical
+// order before hashing.
+bool IsCommutative(SpvOp opcode) {
+  switch (opcode) {
+    case SpvOpIAdd:
+    case SpvOpFAdd:
+    case SpvOpIMul:
+    case SpvOpFMul:
+    case SpvOpDot:
+    case SpvOpBitwiseOr:
+    case SpvOpBitwiseXor:
+    case SpvOpBitwiseAnd:
+    case SpvOpLogicalEqual:
+    case SpvOpLogicalNotEqual:
+    case SpvOpLogicalOr:
+    case SpvOpLogicalAnd:
+    case SpvOpIEqual:
+    case SpvOpINotEqual:
+    case SpvOpFOrdEqual:
+    case SpvOpFUnordEqual:
+    case SpvOpFOrdNotEqual:
+    case SpvOpFUnordNotEqual:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Returns true if |opcode| may change the contents of memory, invalidating
+// any remembered load results. Anything not known to be harmless is
+// conservatively treated as a clobber: being over-cautious here only costs a
+// missed reuse, never correctness.
+bool MayClobberMemory(SpvOp opcode) {
+  if (IsPureComputation(opcode)) return false;
+  switch (opcode) {
+    case SpvOpNop:
+    case SpvOpUndef:
+    case SpvOpLoad:
+    case SpvOpVariable:
+    case SpvOpPhi:
+    case SpvOpSelectionMerge:
+    case SpvOpLoopMerge:
+      return false;
+    default:
+      return true;
+  }
+}
+
+}  // anonymous namespace
+
+bool LocalCSEPass::ProcessBlock(ir::BasicBlock* block,
+                                analysis::DefUseManager* def_use) {
+  bool modified = false;
+  // One table for pure computations, whose results only depend on their
+  // operands, and one for loads, whose results also depend on memory and
+  // must be forgotten at every potential write.
+  ResultIdMap computations;
+  std::unique_ptr<ResultIdMap> loads = MakeUnique<ResultIdMap>();
+  for (auto inst = block->begin(); inst != block->end(); ++inst) {
+    const SpvOp opcode = inst->opcode();
+    if (MayClobberMemory(opcode)) {
+      loads = MakeUnique<ResultIdMap>();
+      continue;
+    }
+
+    ResultIdMap* table = nullptr;
+    if (opcode == SpvOpLoad) {
+      // A load carrying a MemoryAccess operand (e.g. Volatile) must not be
+      // combined with an identical one: each volatile access has to happen.
+      // Same operand-count check as the licm pass's IsHoistableLoad.
+      if (inst->NumOperands() != 3) continue;
+      table = loads.get();
+    } else if (IsPureComputation(opcode)) {
+      table = &computations;
+    } else {
+      continue;
+    }
+
+    // Ids carrying decorations are left alone: two otherwise identical
+    // instructions may be decorated differently, e.g. RelaxedPrecision on
+    // only one of them. Same policy as the unify-const pass.
+    if (def_use->HasAnnotations(inst->result_id())) continue;
+
+    const uint32_t id =
+        table->LookupEquivalentResultFor(*inst, IsCommutative(opcode));
+    if (id != inst->result_id()) {
+      def_use->ReplaceAllUsesWith(inst->result_id(), id);
+      def_use->KillInst(&*inst);
+      modified = true;
+    }
+  }
+  return modified;
+}
+
+Pass::Status LocalCSEPass::Process(ir::Module* module) {
+  analysis::DefUseManager* def_use = analyses(module)->GetDefUse();
+  bool modified = false;
+  for (auto& func : *module) {
+    for (auto& block : func) {
+      modified |= ProcessBlock(&block, def_use);
+    }
+  }
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,47 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_LOCAL_CSE_PASS_H_
+#define LIBSPIRV_OPT_LOCAL_CSE_PASS_H_
+
+#include "basic_block.h"
+#include "def_use_manager.h"
+#include "module.h"
+#include "pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class LocalCSEPass : public Pass {
+ public:
+  const char* name() const override { return "local-cse"; }
+  Status Process(ir::Module*) override;
+
+  // Replacements and removals go through DefUseManager and never touch
+  // control flow, types or constants.
+  uint32_t GetPreservedAnalyses() const override {
+    return AnalysisManager::kAnalysisAll;
+  }
+
+ private:
+  // Eliminates duplicated computations in |block|. Returns true if anything
+  // was replaced.
+  bool ProcessBlock(ir::BasicBlock* block, analysis::DefUseManager* def_use);
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_LOCAL_CSE_PASS_H_
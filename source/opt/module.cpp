@@ -15,48 +15,91 @@
 #include "module.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <thread>
 
+#include "build_module.h"
 #include "operand.h"
 #include "reflect.h"
+#include "tracing.h"
 
 namespace spvtools {
 namespace ir {
 
-std::vector<Instruction*> Module::GetTypes() {
-  std::vector<Instruction*> insts;
-  for (uint32_t i = 0; i < types_values_.size(); ++i) {
-    if (IsTypeInst(types_values_[i]->opcode()))
-      insts.push_back(types_values_[i].get());
-  }
-  return insts;
-};
+namespace {
 
-std::vector<const Instruction*> Module::GetTypes() const {
-  std::vector<const Instruction*> insts;
-  for (uint32_t i = 0; i < types_values_.size(); ++i) {
-    if (IsTypeInst(types_values_[i]->opcode()))
-      insts.push_back(types_values_[i].get());
+// Returns the exact number of words that serializing |fn| produces.  A
+// deferred body is measured from its raw words without being materialized.
+uint32_t CountFunctionWords(const Function& fn, bool skip_nop) {
+  if (fn.HasDeferredBody()) {
+    return static_cast<uint32_t>(fn.deferred_body_words().size());
   }
-  return insts;
-};
+  uint32_t num_words = 0;
+  fn.ForEachInst(
+      [&num_words, skip_nop](const Instruction* i) {
+        if (!(skip_nop && i->IsNop()))
+          num_words += 1 + i->NumSerializedOperandWords();
+      },
+      true);
+  return num_words;
+}
 
-std::vector<Instruction*> Module::GetConstants() {
-  std::vector<Instruction*> insts;
-  for (uint32_t i = 0; i < types_values_.size(); ++i) {
-    if (IsConstantInst(types_values_[i]->opcode()))
-      insts.push_back(types_values_[i].get());
+// Serializes |fn| to |cursor| and returns a pointer just past the last word
+// written.  A deferred body is copied back verbatim from its raw words.
+uint32_t* WriteFunction(const Function& fn, bool skip_nop, uint32_t* cursor) {
+  if (fn.HasDeferredBody()) {
+    const auto& words = fn.deferred_body_words();
+    return std::copy(words.begin(), words.end(), cursor);
   }
-  return insts;
-};
+  fn.ForEachInst(
+      [&cursor, skip_nop](const Instruction* i) {
+        if (!(skip_nop && i->IsNop()))
+          cursor = i->ToBinaryWithoutAttachedDebugInsts(cursor);
+      },
+      true);
+  return cursor;
+}
 
-std::vector<const Instruction*> Module::GetConstants() const {
-  std::vector<const Instruction*> insts;
-  for (uint32_t i = 0; i < types_values_.size(); ++i) {
-    if (IsConstantInst(types_values_[i]->opcode()))
-      insts.push_back(types_values_[i].get());
+}  // anonymous namespace
+
+void Module::RefreshGlobalCaches() const {
+  if (global_caches_valid_) return;
+  cached_types_.clear();
+  cached_types_const_.clear();
+  cached_constants_.clear();
+  cached_constants_const_.clear();
+  for (const auto& inst : types_values_) {
+    if (IsTypeInst(inst->opcode())) {
+      cached_types_.push_back(inst.get());
+      cached_types_const_.push_back(inst.get());
+    } else if (IsConstantInst(inst->opcode())) {
+      cached_constants_.push_back(inst.get());
+      cached_constants_const_.push_back(inst.get());
+    }
   }
-  return insts;
-};
+  global_caches_valid_ = true;
+}
+
+const std::vector<Instruction*>& Module::GetTypes() {
+  RefreshGlobalCaches();
+  return cached_types_;
+}
+
+const std::vector<const Instruction*>& Module::GetTypes() const {
+  RefreshGlobalCaches();
+  return cached_types_const_;
+}
+
+const std::vector<Instruction*>& Module::GetConstants() {
+  RefreshGlobalCaches();
+  return cached_constants_;
+}
+
+const std::vector<const Instruction*>& Module::GetConstants() const {
+  RefreshGlobalCaches();
+  return cached_constants_const_;
+}
 
 uint32_t Module::GetGlobalValue(SpvOp opcode) const {
   for (uint32_t i = 0; i < types_values_.size(); ++i) {
@@ -73,55 +116,87 @@ void Module::AddGlobalValue(SpvOp opcode, uint32_t result_id,
   AddGlobalValue(std::move(newGlobal));
 }
 
-void Module::ForEachInst(const std::function<void(Instruction*)>& f,
-                         bool run_on_debug_line_insts) {
-#define DELEGATE(i) i->ForEachInst(f, run_on_debug_line_insts)
-  for (auto& i : capabilities_) DELEGATE(i);
-  for (auto& i : extensions_) DELEGATE(i);
-  for (auto& i : ext_inst_imports_) DELEGATE(i);
-  if (memory_model_) DELEGATE(memory_model_);
-  for (auto& i : entry_points_) DELEGATE(i);
-  for (auto& i : execution_modes_) DELEGATE(i);
-  for (auto& i : debugs_) DELEGATE(i);
-  for (auto& i : annotations_) DELEGATE(i);
-  for (auto& i : types_values_) DELEGATE(i);
-  for (auto& i : functions_) DELEGATE(i);
-#undef DELEGATE
-}
-
-void Module::ForEachInst(const std::function<void(const Instruction*)>& f,
-                         bool run_on_debug_line_insts) const {
-#define DELEGATE(i)                                      \
-  static_cast<const Instruction*>(i.get())->ForEachInst( \
-      f, run_on_debug_line_insts)
-  for (auto& i : capabilities_) DELEGATE(i);
-  for (auto& i : extensions_) DELEGATE(i);
-  for (auto& i : ext_inst_imports_) DELEGATE(i);
-  if (memory_model_) DELEGATE(memory_model_);
-  for (auto& i : entry_points_) DELEGATE(i);
-  for (auto& i : execution_modes_) DELEGATE(i);
-  for (auto& i : debugs_) DELEGATE(i);
-  for (auto& i : annotations_) DELEGATE(i);
-  for (auto& i : types_values_) DELEGATE(i);
-  for (auto& i : functions_) {
-    static_cast<const Function*>(i.get())->ForEachInst(f,
-                                                       run_on_debug_line_insts);
-  }
-#undef DELEGATE
+void Module::InternDebugStrings() {
+  for (auto& inst : debugs_) inst->InternStrings(&debug_strings_);
 }
 
-void Module::ToBinary(std::vector<uint32_t>* binary, bool skip_nop) const {
-  binary->push_back(header_.magic_number);
-  binary->push_back(header_.version);
+
+void Module::ToBinary(std::vector<uint32_t>* binary, bool skip_nop,
+                      size_t num_threads) const {
+  SPIRV_TRACE_SCOPE("serialize");
+  // Size the vector up front: every instruction knows its own word count, so
+  // an exact pre-pass is cheaper than repeated reallocation during appending.
+  const size_t start = binary->size();
+  binary->resize(start + ComputeBinaryWordCount(skip_nop));
+  const uint32_t num_written =
+      ToBinary(binary->data() + start, skip_nop, num_threads);
+  (void)num_written;
+  assert(start + num_written == binary->size() &&
+         "word count pre-pass disagrees with serialization");
+}
+
+uint32_t Module::ToBinary(uint32_t* binary, bool skip_nop,
+                          size_t num_threads) const {
+  uint32_t* cursor = binary;
+  *cursor++ = header_.magic_number;
+  *cursor++ = header_.version;
   // TODO(antiagainst): should we change the generator number?
-  binary->push_back(header_.generator);
-  binary->push_back(header_.bound);
-  binary->push_back(header_.reserved);
+  *cursor++ = header_.generator;
+  *cursor++ = header_.bound;
+  *cursor++ = header_.reserved;
+
+  auto write_inst = [&cursor, skip_nop](const Instruction* i) {
+    if (!(skip_nop && i->IsNop()))
+      cursor = i->ToBinaryWithoutAttachedDebugInsts(cursor);
+  };
+  ForEachGlobalInst(write_inst, true);
+
+  const size_t num_workers = std::min(num_threads, functions_.size());
+  if (num_workers < 2) {
+    for (auto& fn : functions_) {
+      cursor = WriteFunction(*fn, skip_nop, cursor);
+    }
+    return static_cast<uint32_t>(cursor - binary);
+  }
+
+  // Prefix-sum each function's output position from exact word counts, then
+  // let worker threads serialize the functions directly into their disjoint
+  // slices of the buffer.
+  std::vector<uint32_t*> starts(functions_.size() + 1);
+  starts[0] = cursor;
+  for (size_t i = 0; i < functions_.size(); ++i) {
+    starts[i + 1] = starts[i] + CountFunctionWords(*functions_[i], skip_nop);
+  }
 
-  auto write_inst = [binary, skip_nop](const Instruction* i) {
-    if (!(skip_nop && i->IsNop())) i->ToBinaryWithoutAttachedDebugInsts(binary);
+  std::atomic<size_t> next_index(0);
+  std::vector<std::thread> workers;
+  workers.reserve(num_workers);
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers.emplace_back([this, skip_nop, &starts, &next_index] {
+      for (size_t fi = next_index++; fi < functions_.size();
+           fi = next_index++) {
+        uint32_t* end = WriteFunction(*functions_[fi], skip_nop, starts[fi]);
+        (void)end;
+        assert(end == starts[fi + 1] &&
+               "word count pre-pass disagrees with serialization");
+      }
+    });
+  }
+  for (auto& worker : workers) worker.join();
+  return static_cast<uint32_t>(starts.back() - binary);
+}
+
+uint32_t Module::ComputeBinaryWordCount(bool skip_nop) const {
+  uint32_t num_words = 5;  // Module header words.
+  auto count_inst = [&num_words, skip_nop](const Instruction* i) {
+    if (!(skip_nop && i->IsNop()))
+      num_words += 1 + i->NumSerializedOperandWords();
   };
-  ForEachInst(write_inst, true);
+  ForEachGlobalInst(count_inst, true);
+  for (auto& fn : functions_) {
+    num_words += CountFunctionWords(*fn, skip_nop);
+  }
+  return num_words;
 }
 
 uint32_t Module::ComputeIdBound() const {
@@ -140,6 +215,68 @@ uint32_t Module::ComputeIdBound() const {
   return highest + 1;
 }
 
+size_t Module::EstimateMemoryUsage() const {
+  size_t total = sizeof(*this) + arena_.TotalBytes() +
+                 listeners_.capacity() * sizeof(IrChangeListener*);
+  total += (cached_types_.capacity() + cached_constants_.capacity() +
+            cached_types_const_.capacity() +
+            cached_constants_const_.capacity()) *
+           sizeof(Instruction*);
+  const auto count_section =
+      [&total](const std::vector<std::unique_ptr<Instruction>>& insts) {
+        total += insts.capacity() * sizeof(std::unique_ptr<Instruction>);
+        for (const auto& inst : insts) total += inst->EstimateMemoryUsage();
+      };
+  count_section(capabilities_);
+  count_section(extensions_);
+  count_section(ext_inst_imports_);
+  count_section(entry_points_);
+  count_section(execution_modes_);
+  count_section(debugs_);
+  count_section(annotations_);
+  count_section(types_values_);
+  if (memory_model_) total += memory_model_->EstimateMemoryUsage();
+  total += debug_strings_.EstimateMemoryUsage();
+  total += functions_.capacity() * sizeof(std::unique_ptr<Function>);
+  for (const auto& fn : functions_) total += fn->EstimateMemoryUsage();
+  return total;
+}
+
+bool Module::Compact(spv_target_env env, const MessageConsumer& consumer) {
+  assert(listeners_.empty() &&
+         "compaction replaces the IR wholesale; unregister listeners first");
+  std::vector<uint32_t> binary;
+  ToBinary(&binary, /* skip_nop = */ true);
+  // The reloaded module reserves its chunks the same way this one does, and
+  // keeping its function bodies deferred packs untouched functions as raw
+  // words until a later pass actually walks them.
+  std::unique_ptr<Module> fresh =
+      BuildModule(env, consumer, binary.data(), binary.size(),
+                  /* defer_function_bodies = */ true, /* num_threads = */ 1,
+                  &arena_.upstream_allocator());
+  if (fresh == nullptr) return false;
+
+  // Adopt the reloaded IR.  The moves below destroy the old instructions
+  // while the old arena is still in place under arena_; the arenas then
+  // trade places, so the fragmented one is torn down with |fresh|.
+  capabilities_ = std::move(fresh->capabilities_);
+  extensions_ = std::move(fresh->extensions_);
+  ext_inst_imports_ = std::move(fresh->ext_inst_imports_);
+  memory_model_ = std::move(fresh->memory_model_);
+  entry_points_ = std::move(fresh->entry_points_);
+  execution_modes_ = std::move(fresh->execution_modes_);
+  debugs_ = std::move(fresh->debugs_);
+  annotations_ = std::move(fresh->annotations_);
+  types_values_ = std::move(fresh->types_values_);
+  functions_ = std::move(fresh->functions_);
+  debug_strings_.Swap(fresh->debug_strings_);
+  arena_.Swap(fresh->arena_);
+  global_caches_valid_ = false;
+  // The header and the id allocator carry over: the binary was written from
+  // this very module, so the reloaded header matches.
+  return true;
+}
+
 bool Module::HasCapability(uint32_t cap) {
   for (auto& ci : capabilities_) {
     uint32_t tcap = ci->GetSingleWordOperand(0);
@@ -15,18 +15,38 @@
 #ifndef LIBSPIRV_OPT_MODULE_H_
 #define LIBSPIRV_OPT_MODULE_H_
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <utility>
 #include <vector>
 
 #include "function.h"
+#include "id_allocator.h"
 #include "instruction.h"
 #include "iterator.h"
+#include "spirv-tools/libspirv.hpp"
+#include "string_pool.h"
 
 namespace spvtools {
 namespace ir {
 
+// Interface for observers that keep derived information (such as a def-use
+// analysis) in sync with the IR.  Listeners registered on a Module are
+// notified by the module/function/basic-block mutators, so a pipeline of
+// passes can share one analysis instead of recomputing it after every
+// mutation.
+class IrChangeListener {
+ public:
+  virtual ~IrChangeListener() {}
+
+  // Called after |inst| has been inserted into the module.
+  virtual void OnInsert(Instruction* inst) = 0;
+  // Called just before |inst| is removed from the module or turned into a
+  // Nop.
+  virtual void OnErase(Instruction* inst) = 0;
+};
+
 // A struct for containing the module header information.
 struct ModuleHeader {
   uint32_t magic_number;
@@ -49,11 +69,26 @@ class Module {
   Module() : header_({}) {}
 
   // Sets the header to the given |header|.
-  void SetHeader(const ModuleHeader& header) { header_ = header; }
-  // Sets the Id bound.
-  void SetIdBound(uint32_t bound) { header_.bound = bound; }
+  void SetHeader(const ModuleHeader& header) {
+    header_ = header;
+    id_allocator_.Reset(header.bound);
+  }
+  // Sets the Id bound and restarts fresh-id allocation from it.
+  void SetIdBound(uint32_t bound) {
+    header_.bound = bound;
+    id_allocator_.Reset(bound);
+  }
   // Returns the Id bound.
   uint32_t IdBound() { return header_.bound; }
+
+  // Returns the allocator handing out fresh result ids for this module.
+  // Passes should mint new ids through it rather than tracking a next id of
+  // their own; see id_allocator.h.
+  IdAllocator& id_allocator() { return id_allocator_; }
+
+  // Writes the ids handed out by the allocator back to the header bound.
+  // Call once a pass is done minting ids.
+  void FinalizeIdBound() { header_.bound = id_allocator_.bound(); }
   // Appends a capability instruction to this module.
   inline void AddCapability(std::unique_ptr<Instruction> c);
   // Appends an extension instruction to this module.
@@ -77,14 +112,17 @@ class Module {
   // Appends a function to this module.
   inline void AddFunction(std::unique_ptr<Function> f);
 
-  // Returns a vector of pointers to type-declaration instructions in this
-  // module.
-  std::vector<Instruction*> GetTypes();
-  std::vector<const Instruction*> GetTypes() const;
-  // Returns a vector of pointers to constant-creation instructions in this
-  // module.
-  std::vector<Instruction*> GetConstants();
-  std::vector<const Instruction*> GetConstants() const;
+  // Returns the type-declaration instructions of this module, in module
+  // order.  The returned vector is a cached view owned by the module: it is
+  // rebuilt lazily after a mutation of the global section and stays valid
+  // only until the next such mutation, so copy it before mutating if the
+  // mutation and the walk interleave.
+  const std::vector<Instruction*>& GetTypes();
+  const std::vector<const Instruction*>& GetTypes() const;
+  // Returns the constant-creation instructions of this module.  Same
+  // caching contract as GetTypes().
+  const std::vector<Instruction*>& GetConstants();
+  const std::vector<const Instruction*>& GetConstants() const;
 
   // Return result id of global value with |opcode|, 0 if not present.
   uint32_t GetGlobalValue(SpvOp opcode) const;
@@ -94,6 +132,11 @@ class Module {
 
   inline uint32_t id_bound() const { return header_.bound; }
 
+  // Returns the SPIR-V version recorded in the module header.
+  uint32_t version() const { return header_.version; }
+  // Returns the generator magic word recorded in the module header.
+  uint32_t generator() const { return header_.generator; }
+
   // Iterators for debug instructions (excluding OpLine & OpNoLine) contained in
   // this module.
   inline inst_iterator debug_begin();
@@ -105,9 +148,51 @@ class Module {
   inline IteratorRange<inst_iterator> entry_points();
   inline IteratorRange<const_inst_iterator> entry_points() const;
 
+  // Iterators for capability instructions contained in this module.
+  inline IteratorRange<inst_iterator> capabilities();
+  inline IteratorRange<const_inst_iterator> capabilities() const;
+
+  // Iterators for extension instructions contained in this module.
+  inline IteratorRange<inst_iterator> extensions();
+  inline IteratorRange<const_inst_iterator> extensions() const;
+
+  // Iterators for extended instruction set import instructions contained in
+  // this module.
+  inline IteratorRange<inst_iterator> ext_inst_imports();
+  inline IteratorRange<const_inst_iterator> ext_inst_imports() const;
+
+  // Returns the memory model instruction, or nullptr if it has not been set.
+  Instruction* GetMemoryModel() { return memory_model_.get(); }
+  const Instruction* GetMemoryModel() const { return memory_model_.get(); }
+
+  // Iterators for execution mode instructions contained in this module.
+  inline IteratorRange<inst_iterator> execution_modes();
+  inline IteratorRange<const_inst_iterator> execution_modes() const;
+
   // Clears all debug instructions (excluding OpLine & OpNoLine).
   void debug_clear() { debugs_.clear(); }
 
+  // Interns the literal-string operands of every debug instruction into this
+  // module's string pool, so repeated names and source paths are stored once.
+  // Idempotent; serialization re-expands the strings, so callers see no
+  // difference in the produced binary.
+  void InternDebugStrings();
+
+  // Returns the pool holding the module's interned debug strings.
+  StringPool& debug_strings() { return debug_strings_; }
+
+  // Removes every debug and annotation instruction for which |predicate|
+  // returns true, notifying change listeners.  |predicate| is any callable
+  // taking a const Instruction&.
+  template <typename Predicate>
+  inline void RemoveDebugAndAnnotationsIf(Predicate predicate);
+
+  // Removes every function for which |predicate| returns true, notifying
+  // change listeners of each erased instruction.  |predicate| is any
+  // callable taking a const Function&.
+  template <typename Predicate>
+  inline void RemoveFunctionsIf(Predicate predicate);
+
   // Iterators for annotation instructions contained in this module.
   IteratorRange<inst_iterator> annotations();
   IteratorRange<const_inst_iterator> annotations() const;
@@ -125,25 +210,117 @@ class Module {
   inline const_iterator cend() const;
 
   // Invokes function |f| on all instructions in this module, and optionally on
-  // the debug line instructions that precede them.
-  void ForEachInst(const std::function<void(Instruction*)>& f,
-                   bool run_on_debug_line_insts = false);
-  void ForEachInst(const std::function<void(const Instruction*)>& f,
-                   bool run_on_debug_line_insts = false) const;
+  // the debug line instructions that precede them.  |f| is any callable
+  // taking an Instruction* (const Instruction* for the const overload) and
+  // is inlined at the call site.
+  template <typename FunctionT>
+  inline void ForEachInst(const FunctionT& f,
+                          bool run_on_debug_line_insts = false);
+  template <typename FunctionT>
+  inline void ForEachInst(const FunctionT& f,
+                          bool run_on_debug_line_insts = false) const;
 
   // Pushes the binary segments for this instruction into the back of *|binary|.
-  // If |skip_nop| is true and this is a OpNop, do nothing.
-  void ToBinary(std::vector<uint32_t>* binary, bool skip_nop) const;
+  // If |skip_nop| is true and this is a OpNop, do nothing.  The vector is
+  // grown to its final size in one step before serialization starts.
+  //
+  // If |num_threads| is two or more, each function's output offset is
+  // computed from exact per-instruction word counts and worker threads
+  // serialize the functions directly into their slices of the buffer.
+  void ToBinary(std::vector<uint32_t>* binary, bool skip_nop,
+                size_t num_threads = 1) const;
+
+  // Writes the binary representation of this module into |binary|, which must
+  // have room for ComputeBinaryWordCount(skip_nop) words.  Returns the number
+  // of words written.  This lets callers serialize straight into storage they
+  // already own without an intermediate vector.  |num_threads| behaves as in
+  // the vector overload above.
+  uint32_t ToBinary(uint32_t* binary, bool skip_nop,
+                    size_t num_threads = 1) const;
+
+  // Returns the exact number of words that ToBinary produces, including the
+  // five module header words.  If |skip_nop| is true, OpNops are not counted.
+  uint32_t ComputeBinaryWordCount(bool skip_nop) const;
 
   // Returns 1 more than the maximum Id value mentioned in the module.
   uint32_t ComputeIdBound() const;
 
+  // Returns an estimate in bytes of the memory retained by this module: the
+  // module object itself, the arena backing IR objects built inside its
+  // scope, the owning containers, and the out-of-line storage of every
+  // instruction.  Deferred function bodies are measured from their raw
+  // words and not materialized.  IR objects a pass allocated outside any
+  // arena scope contribute only their out-of-line storage, so treat the
+  // result as a floor rather than an exact footprint.
+  size_t EstimateMemoryUsage() const;
+
+  // Repacks this module's IR into a fresh, densely filled arena by
+  // round-tripping through the binary form: the module is serialized with
+  // OpNops dropped and reloaded with deferred function bodies, and the
+  // reloaded IR replaces the old storage.  Heavy churn -- inlining followed
+  // by dead-code elimination, say -- leaves the live instructions scattered
+  // among dead arena slots that only compaction can reclaim; calling this
+  // between pipeline phases restores the traversal locality and footprint
+  // of a freshly loaded module.
+  //
+  // |env| selects the grammar the binary is reloaded under and must accept
+  // everything this module contains.  On failure, errors go to |consumer|
+  // and the module is left unchanged.  On success, every pointer into the
+  // module's IR -- instructions, blocks, functions -- is invalidated, as is
+  // any analysis built over them.  Change listeners must be unregistered
+  // first: the wholesale replacement is not announced per instruction.
+  bool Compact(spv_target_env env, const MessageConsumer& consumer = nullptr);
+
   // Returns true if module has capability |cap|
   bool HasCapability(uint32_t cap);
 
+  // Returns the arena backing bulk IR allocations for this module.  Objects
+  // placed here live exactly as long as the module; see arena.h.
+  Arena& arena() { return arena_; }
+
+  // Registers |listener| to be notified of instruction insertions and
+  // erasures.  The listener must stay alive until unregistered.
+  void RegisterChangeListener(IrChangeListener* listener) {
+    listeners_.push_back(listener);
+  }
+  // Unregisters a previously registered |listener|.
+  void UnregisterChangeListener(IrChangeListener* listener) {
+    listeners_.erase(
+        std::remove(listeners_.begin(), listeners_.end(), listener),
+        listeners_.end());
+  }
+  // Notifies registered listeners that |inst| has been inserted.
+  void NotifyInsert(Instruction* inst) {
+    for (auto* listener : listeners_) listener->OnInsert(inst);
+  }
+  // Notifies registered listeners that |inst| is about to be erased.
+  // Erasure may remove a type or constant (or turn it into a Nop), so the
+  // cached global views are invalidated as well.
+  void NotifyErase(Instruction* inst) {
+    global_caches_valid_ = false;
+    for (auto* listener : listeners_) listener->OnErase(inst);
+  }
+
  private:
+  // Rebuilds the cached type/constant views if a mutation invalidated them.
+  void RefreshGlobalCaches() const;
+  // Invokes |f| on all instructions outside function definitions, and
+  // optionally on the debug line instructions that precede them.
+  template <typename FunctionT>
+  inline void ForEachGlobalInst(const FunctionT& f,
+                                bool run_on_debug_line_insts) const;
+
+  // The arena must be declared before the containers below so that it is
+  // destroyed after them: instruction destructors still run normally, only
+  // their storage is reclaimed wholesale here.
+  Arena arena_;
+
   ModuleHeader header_;  // Module header
 
+  // Source of fresh result ids; kept in sync with header_.bound by
+  // SetHeader()/SetIdBound()/FinalizeIdBound().
+  IdAllocator id_allocator_;
+
   // The following fields respect the "Logical Layout of a Module" in
   // Section 2.4 of the SPIR-V specification.
   std::vector<std::unique_ptr<Instruction>> capabilities_;
@@ -158,52 +335,113 @@ class Module {
   // Type declarations, constants, and global variable declarations.
   std::vector<std::unique_ptr<Instruction>> types_values_;
   std::vector<std::unique_ptr<Function>> functions_;
+
+  // Canonical storage for interned debug-string operands; see
+  // InternDebugStrings().
+  StringPool debug_strings_;
+
+  // Observers notified on instruction insertion and erasure.
+  std::vector<IrChangeListener*> listeners_;
+
+  // Cached views of types_values_ handed out by GetTypes()/GetConstants(),
+  // rebuilt lazily by RefreshGlobalCaches().  Mutable so that the const
+  // accessors can rebuild them on demand.
+  mutable std::vector<Instruction*> cached_types_;
+  mutable std::vector<const Instruction*> cached_types_const_;
+  mutable std::vector<Instruction*> cached_constants_;
+  mutable std::vector<const Instruction*> cached_constants_const_;
+  mutable bool global_caches_valid_ = false;
 };
 
 inline void Module::AddCapability(std::unique_ptr<Instruction> c) {
+  NotifyInsert(c.get());
   capabilities_.emplace_back(std::move(c));
 }
 
 inline void Module::AddExtension(std::unique_ptr<Instruction> e) {
+  NotifyInsert(e.get());
   extensions_.emplace_back(std::move(e));
 }
 
 inline void Module::AddExtInstImport(std::unique_ptr<Instruction> e) {
+  NotifyInsert(e.get());
   ext_inst_imports_.emplace_back(std::move(e));
 }
 
 inline void Module::SetMemoryModel(std::unique_ptr<Instruction> m) {
+  NotifyInsert(m.get());
   memory_model_ = std::move(m);
 }
 
 inline void Module::AddEntryPoint(std::unique_ptr<Instruction> e) {
+  NotifyInsert(e.get());
   entry_points_.emplace_back(std::move(e));
 }
 
 inline void Module::AddExecutionMode(std::unique_ptr<Instruction> e) {
+  NotifyInsert(e.get());
   execution_modes_.emplace_back(std::move(e));
 }
 
 inline void Module::AddDebugInst(std::unique_ptr<Instruction> d) {
+  NotifyInsert(d.get());
   debugs_.emplace_back(std::move(d));
 }
 
 inline void Module::AddAnnotationInst(std::unique_ptr<Instruction> a) {
+  NotifyInsert(a.get());
   annotations_.emplace_back(std::move(a));
 }
 
 inline void Module::AddType(std::unique_ptr<Instruction> t) {
+  NotifyInsert(t.get());
   types_values_.emplace_back(std::move(t));
+  global_caches_valid_ = false;
 }
 
 inline void Module::AddGlobalValue(std::unique_ptr<Instruction> v) {
+  NotifyInsert(v.get());
   types_values_.emplace_back(std::move(v));
+  global_caches_valid_ = false;
 }
 
 inline void Module::AddFunction(std::unique_ptr<Function> f) {
+  if (f->HasDeferredBody()) {
+    // Only the OpFunction instruction has been built so far.  The body
+    // notifies through the block/parameter mutators when it materializes.
+    NotifyInsert(&f->DefInst());
+  } else {
+    f->ForEachInst([this](Instruction* inst) { NotifyInsert(inst); });
+  }
   functions_.emplace_back(std::move(f));
 }
 
+template <typename Predicate>
+inline void Module::RemoveDebugAndAnnotationsIf(Predicate predicate) {
+  auto doomed = [this, &predicate](const std::unique_ptr<Instruction>& inst) {
+    if (!predicate(*inst)) return false;
+    NotifyErase(inst.get());
+    return true;
+  };
+  debugs_.erase(std::remove_if(debugs_.begin(), debugs_.end(), doomed),
+                debugs_.end());
+  annotations_.erase(
+      std::remove_if(annotations_.begin(), annotations_.end(), doomed),
+      annotations_.end());
+}
+
+template <typename Predicate>
+inline void Module::RemoveFunctionsIf(Predicate predicate) {
+  auto doomed = [this, &predicate](const std::unique_ptr<Function>& func) {
+    if (!predicate(*func)) return false;
+    func->ForEachInst([this](Instruction* inst) { NotifyErase(inst); });
+    return true;
+  };
+  functions_.erase(
+      std::remove_if(functions_.begin(), functions_.end(), doomed),
+      functions_.end());
+}
+
 inline Module::inst_iterator Module::debug_begin() {
   return inst_iterator(&debugs_, debugs_.begin());
 }
@@ -227,6 +465,40 @@ inline IteratorRange<Module::const_inst_iterator> Module::entry_points() const {
   return make_const_range(entry_points_);
 }
 
+inline IteratorRange<Module::inst_iterator> Module::capabilities() {
+  return make_range(capabilities_);
+}
+
+inline IteratorRange<Module::const_inst_iterator> Module::capabilities() const {
+  return make_const_range(capabilities_);
+}
+
+inline IteratorRange<Module::inst_iterator> Module::extensions() {
+  return make_range(extensions_);
+}
+
+inline IteratorRange<Module::const_inst_iterator> Module::extensions() const {
+  return make_const_range(extensions_);
+}
+
+inline IteratorRange<Module::inst_iterator> Module::ext_inst_imports() {
+  return make_range(ext_inst_imports_);
+}
+
+inline IteratorRange<Module::const_inst_iterator> Module::ext_inst_imports()
+    const {
+  return make_const_range(ext_inst_imports_);
+}
+
+inline IteratorRange<Module::inst_iterator> Module::execution_modes() {
+  return make_range(execution_modes_);
+}
+
+inline IteratorRange<Module::const_inst_iterator> Module::execution_modes()
+    const {
+  return make_const_range(execution_modes_);
+}
+
 inline IteratorRange<Module::inst_iterator> Module::annotations() {
   return make_range(annotations_);
 }
@@ -259,6 +531,51 @@ inline Module::const_iterator Module::cend() const {
   return const_iterator(&functions_, functions_.cend());
 }
 
+template <typename FunctionT>
+inline void Module::ForEachInst(const FunctionT& f,
+                                bool run_on_debug_line_insts) {
+#define DELEGATE(i) i->ForEachInst(f, run_on_debug_line_insts)
+  for (auto& i : capabilities_) DELEGATE(i);
+  for (auto& i : extensions_) DELEGATE(i);
+  for (auto& i : ext_inst_imports_) DELEGATE(i);
+  if (memory_model_) DELEGATE(memory_model_);
+  for (auto& i : entry_points_) DELEGATE(i);
+  for (auto& i : execution_modes_) DELEGATE(i);
+  for (auto& i : debugs_) DELEGATE(i);
+  for (auto& i : annotations_) DELEGATE(i);
+  for (auto& i : types_values_) DELEGATE(i);
+  for (auto& i : functions_) DELEGATE(i);
+#undef DELEGATE
+}
+
+template <typename FunctionT>
+inline void Module::ForEachGlobalInst(const FunctionT& f,
+                                      bool run_on_debug_line_insts) const {
+#define DELEGATE(i)                                      \
+  static_cast<const Instruction*>(i.get())->ForEachInst( \
+      f, run_on_debug_line_insts)
+  for (auto& i : capabilities_) DELEGATE(i);
+  for (auto& i : extensions_) DELEGATE(i);
+  for (auto& i : ext_inst_imports_) DELEGATE(i);
+  if (memory_model_) DELEGATE(memory_model_);
+  for (auto& i : entry_points_) DELEGATE(i);
+  for (auto& i : execution_modes_) DELEGATE(i);
+  for (auto& i : debugs_) DELEGATE(i);
+  for (auto& i : annotations_) DELEGATE(i);
+  for (auto& i : types_values_) DELEGATE(i);
+#undef DELEGATE
+}
+
+template <typename FunctionT>
+inline void Module::ForEachInst(const FunctionT& f,
+                                bool run_on_debug_line_insts) const {
+  ForEachGlobalInst(f, run_on_debug_line_insts);
+  for (auto& i : functions_) {
+    static_cast<const Function*>(i.get())->ForEachInst(f,
+                                                       run_on_debug_line_insts);
+  }
+}
+
 }  // namespace ir
 }  // namespace spvtools
 
@@ -14,13 +14,45 @@
 
 #include "spirv-tools/optimizer.hpp"
 
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
 #include "build_module.h"
+#include "ir_loader.h"
 #include "make_unique.h"
 #include "pass_manager.h"
 #include "passes.h"
+#include "table.h"
+#include "val/validation_state.h"
+#include "validate.h"
 
 namespace spvtools {
 
+namespace {
+
+// Forwards the header of a module being validated to the IR loader.  Meets
+// the forwarding-callback interface of ValidateBinaryAndForwardParse().
+spv_result_t ForwardHeaderToLoader(void* loader, spv_endianness_t,
+                                   uint32_t magic, uint32_t version,
+                                   uint32_t generator, uint32_t id_bound,
+                                   uint32_t reserved) {
+  reinterpret_cast<ir::IrLoader*>(loader)->SetModuleHeader(
+      magic, version, generator, id_bound, reserved);
+  return SPV_SUCCESS;
+}
+
+// Forwards an instruction of a module being validated to the IR loader.
+spv_result_t ForwardInstToLoader(void* loader,
+                                 const spv_parsed_instruction_t* inst) {
+  if (reinterpret_cast<ir::IrLoader*>(loader)->AddInstruction(inst)) {
+    return SPV_SUCCESS;
+  }
+  return SPV_ERROR_INVALID_BINARY;
+}
+
+}  // anonymous namespace
+
 struct Optimizer::PassToken::Impl {
   Impl(std::unique_ptr<opt::Pass> p) : pass(std::move(p)) {}
 
@@ -59,6 +91,25 @@ void Optimizer::SetMessageConsumer(MessageConsumer c) {
   impl_->pass_manager.SetMessageConsumer(std::move(c));
 }
 
+Optimizer& Optimizer::SetTimeReport(std::ostream* out) {
+  if (out) {
+    std::ostream* stream = out;
+    impl_->pass_manager.SetPassStatsCallback(
+        [stream](const opt::PassManager::PassStats& stats) {
+          *stream << "  " << std::fixed << std::setprecision(3) << std::setw(10)
+                  << stats.wall_time_ms << " ms  insts "
+                  << stats.instructions_before << " -> "
+                  << stats.instructions_after << "  arena "
+                  << (stats.arena_bytes_delta >= 0 ? "+" : "")
+                  << stats.arena_bytes_delta << " B  mem ~"
+                  << stats.memory_usage << " B  " << stats.pass_name << "\n";
+        });
+  } else {
+    impl_->pass_manager.SetPassStatsCallback(nullptr);
+  }
+  return *this;
+}
+
 Optimizer& Optimizer::RegisterPass(PassToken&& p) {
   // Change to use the pass manager's consumer.
   p.impl_->pass->SetMessageConsumer(impl_->pass_manager.consumer());
@@ -75,15 +126,117 @@ bool Optimizer::Run(const uint32_t* original_binary,
   if (module == nullptr) return false;
 
   auto status = impl_->pass_manager.Run(module.get());
-  if (status == opt::Pass::Status::SuccessWithChange ||
-      (status == opt::Pass::Status::SuccessWithoutChange &&
-       (optimized_binary->data() != original_binary ||
-        optimized_binary->size() != original_binary_size))) {
-    optimized_binary->clear();
-    module->ToBinary(optimized_binary, /* skip_nop = */ true);
+  if (status == opt::Pass::Status::Failure) return false;
+
+  // When no pass changed the module, the output is the input by definition,
+  // so hand back the original bytes verbatim instead of re-serializing.
+  if (status == opt::Pass::Status::SuccessWithoutChange) {
+    if (optimized_binary->data() == original_binary) {
+      // The caller reuses the input vector; the words are already in place.
+      optimized_binary->resize(original_binary_size);
+    } else {
+      optimized_binary->assign(original_binary,
+                               original_binary + original_binary_size);
+    }
+    return true;
   }
 
-  return status != opt::Pass::Status::Failure;
+  optimized_binary->clear();
+  module->ToBinary(optimized_binary, /* skip_nop = */ true);
+  return true;
+}
+
+bool Optimizer::Run(std::vector<uint32_t>* binary) const {
+  std::unique_ptr<ir::Module> module =
+      BuildModule(impl_->target_env, impl_->pass_manager.consumer(),
+                  binary->data(), binary->size());
+  if (module == nullptr) return false;
+
+  auto status = impl_->pass_manager.Run(module.get());
+  if (status == opt::Pass::Status::Failure) return false;
+
+  // When no pass changed the module, the vector already holds the result.
+  if (status == opt::Pass::Status::SuccessWithoutChange) return true;
+
+  std::vector<uint32_t> optimized;
+  module->ToBinary(&optimized, /* skip_nop = */ true);
+  *binary = std::move(optimized);
+  return true;
+}
+
+bool Optimizer::Run(uint32_t* binary, size_t* num_words,
+                    std::vector<uint32_t>* overflow_binary) const {
+  std::unique_ptr<ir::Module> module = BuildModule(
+      impl_->target_env, impl_->pass_manager.consumer(), binary, *num_words);
+  if (module == nullptr) return false;
+
+  auto status = impl_->pass_manager.Run(module.get());
+  if (status == opt::Pass::Status::Failure) return false;
+
+  // When no pass changed the module, the buffer already holds the result.
+  if (status == opt::Pass::Status::SuccessWithoutChange) {
+    if (overflow_binary) overflow_binary->clear();
+    return true;
+  }
+
+  std::vector<uint32_t> optimized;
+  module->ToBinary(&optimized, /* skip_nop = */ true);
+  if (optimized.size() <= *num_words) {
+    std::copy(optimized.begin(), optimized.end(), binary);
+    *num_words = optimized.size();
+    if (overflow_binary) overflow_binary->clear();
+    return true;
+  }
+  if (overflow_binary == nullptr) return false;
+  *overflow_binary = std::move(optimized);
+  *num_words = 0;
+  return true;
+}
+
+bool Optimizer::RunValidated(const uint32_t* original_binary,
+                             const size_t original_binary_size,
+                             std::vector<uint32_t>* optimized_binary) const {
+  auto context = spvContextCreate(impl_->target_env);
+  SetContextMessageConsumer(context, impl_->pass_manager.consumer());
+
+  auto module = MakeUnique<ir::Module>();
+  ir::IrLoader loader(context->consumer, module.get());
+  loader.PreScanFunctionBlockCounts(original_binary, original_binary_size);
+
+  // One decode serves both phases: the validator runs its per-instruction
+  // checks on each parsed instruction and then hands the same parsed form to
+  // the IR loader, so the IR only ever sees instructions that passed those
+  // checks.
+  spv_validator_options options = spvValidatorOptionsCreate();
+  std::unique_ptr<libspirv::ValidationState_t> vstate;
+  const spv_result_t valid = ValidateBinaryAndForwardParse(
+      context, options, original_binary, original_binary_size,
+      /* pDiagnostic = */ nullptr, &vstate, ForwardHeaderToLoader,
+      ForwardInstToLoader, &loader);
+  loader.EndModule();
+  spvValidatorOptionsDestroy(options);
+  spvContextDestroy(context);
+  if (valid != SPV_SUCCESS) return false;
+
+  auto status = impl_->pass_manager.Run(module.get());
+  if (status == opt::Pass::Status::Failure) return false;
+
+  // When no pass changed the module, the output is the input by definition,
+  // so hand back the original bytes verbatim instead of re-serializing.
+  if (status == opt::Pass::Status::SuccessWithoutChange) {
+    if (optimized_binary->data() == original_binary) {
+      // The caller reuses the input vector; the words are already in place.
+      optimized_binary->resize(original_binary_size);
+    } else {
+      optimized_binary->assign(original_binary,
+                               original_binary + original_binary_size);
+    }
+    return true;
+  }
+
+  optimized_binary->clear();
+  module->ToBinary(optimized_binary, /* skip_nop = */ true);
+  return true;
 }
 
 Optimizer::PassToken CreateNullPass() {
@@ -132,6 +285,34 @@ Optimizer::PassToken CreateEliminateDeadConstantPass() {
       MakeUnique<opt::EliminateDeadConstantPass>());
 }
 
+Optimizer::PassToken CreateEliminateDeadFunctionsPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::EliminateDeadFunctionsPass>());
+}
+
+Optimizer::PassToken CreateAggressiveDCEPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::AggressiveDCEPass>());
+}
+
+Optimizer::PassToken CreateLocalCSEPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(MakeUnique<opt::LocalCSEPass>());
+}
+
+Optimizer::PassToken CreateLicmPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(MakeUnique<opt::LicmPass>());
+}
+
+Optimizer::PassToken CreateSimplifyPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::SimplifyPass>());
+}
+
+Optimizer::PassToken CreatePromoteLocalsPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::PromoteLocalsPass>());
+}
+
 Optimizer::PassToken CreateInlinePass() {
   return MakeUnique<Optimizer::PassToken::Impl>(MakeUnique<opt::InlinePass>());
 }
@@ -141,4 +322,9 @@ Optimizer::PassToken CreateCompactIdsPass() {
       MakeUnique<opt::CompactIdsPass>());
 }
 
+Optimizer::PassToken CreateCanonicalizeIdsPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::CanonicalizeIdsPass>());
+}
+
 }  // namespace spvtools
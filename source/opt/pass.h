@@ -15,14 +15,19 @@
 #ifndef LIBSPIRV_OPT_PASS_H_
 #define LIBSPIRV_OPT_PASS_H_
 
+#include <memory>
 #include <utility>
 
+#include "analysis_manager.h"
 #include "module.h"
 #include "spirv-tools/libspirv.hpp"
 
 namespace spvtools {
 namespace opt {
 
+class FunctionPass;
+class InstVisitorPass;
+
 // Abstract class of a pass. All passes should implement this abstract class
 // and all analysis and transformation is done via the Process() method.
 class Pass {
@@ -42,7 +47,7 @@ class Pass {
   // The constructed instance will have an empty message consumer, which just
   // ignores all messages from the library. Use SetMessageConsumer() to supply
   // one if messages are of concern.
-  Pass() : consumer_(nullptr) {}
+  Pass() : consumer_(nullptr), analyses_(nullptr) {}
 
   // Destructs the pass.
   virtual ~Pass() = default;
@@ -50,6 +55,26 @@ class Pass {
   // Returns a descriptive name for this pass.
   virtual const char* name() const = 0;
 
+  // Checked down-casts identifying the traversal shape of this pass.  The
+  // library is built without RTTI, so PassManager relies on these instead of
+  // dynamic_cast.  Each returns |this| if the pass derives from the
+  // corresponding class, and nullptr otherwise.
+  virtual FunctionPass* AsFunctionPass() { return nullptr; }
+  virtual InstVisitorPass* AsInstVisitorPass() { return nullptr; }
+
+  // Returns the mask of AnalysisManager::Analysis bits describing which
+  // analyses stay valid when this pass changes the module. The default
+  // preserves nothing; a pass that keeps an analysis current — for example
+  // by mutating the module only through DefUseManager — should override
+  // this so the pipeline need not rebuild that analysis after it runs.
+  virtual uint32_t GetPreservedAnalyses() const {
+    return AnalysisManager::kAnalysisNone;
+  }
+
+  // Sets the analysis manager shared across a pipeline. PassManager installs
+  // its own manager before running each pass.
+  void SetAnalysisManager(AnalysisManager* analyses) { analyses_ = analyses; }
+
   // Sets the message consumer to the given |consumer|. |consumer| which will be
   // invoked every time there is a message to be communicated to the outside.
   void SetMessageConsumer(MessageConsumer c) { consumer_ = std::move(c); }
@@ -61,8 +86,98 @@ class Pass {
   // succesful to indicate whether changes are made to the module.
   virtual Status Process(ir::Module* module) = 0;
 
+ protected:
+  // Returns the analysis manager for |module|. Inside a pipeline this is the
+  // manager installed by PassManager; when the pass runs on its own, a
+  // private manager is created on first request, and replaced if the pass is
+  // reused on another module. Not safe to call from the per-function workers
+  // of a parallel FunctionPass run.
+  AnalysisManager* analyses(ir::Module* module) {
+    if (analyses_ && analyses_->module() == module) return analyses_;
+    if (!owned_analyses_ || owned_analyses_->module() != module) {
+      owned_analyses_.reset(new AnalysisManager(consumer_, module));
+    }
+    return owned_analyses_.get();
+  }
+
  private:
   MessageConsumer consumer_;  // Message consumer.
+  // The pipeline-wide analysis manager, when running under a PassManager.
+  AnalysisManager* analyses_;
+  // The fallback manager for a pass running outside a pipeline.
+  std::unique_ptr<AnalysisManager> owned_analyses_;
+};
+
+// Abstract class of a pass whose transformation is local to single functions.
+// Subclasses implement ProcessFunction(); the default Process() runs it over
+// every function in the module after the serial module-scope hook.  Because
+// each function is processed independently, PassManager can distribute the
+// per-function work over several threads; a subclass must therefore confine
+// its writes to the function it was given and the state it owns.
+class FunctionPass : public Pass {
+ public:
+  FunctionPass* AsFunctionPass() override { return this; }
+
+  // Processes the module-scope parts of |module| (types, constants,
+  // annotations) before the per-function work.  Always runs serially, even
+  // in a parallel run.  The default does nothing.
+  virtual Status ProcessModuleScope(ir::Module*) {
+    return Status::SuccessWithoutChange;
+  }
+
+  // Processes the given |function|. Returns Status::Failure if errors occur
+  // when processing. Returns the corresponding Status::Success otherwise to
+  // indicate whether changes are made to the function.
+  virtual Status ProcessFunction(ir::Function* function) = 0;
+
+  // Runs ProcessModuleScope() and then ProcessFunction() over every function
+  // in the module, combining the statuses.
+  Status Process(ir::Module* module) override {
+    auto status = ProcessModuleScope(module);
+    if (status == Status::Failure) return status;
+    for (auto& function : *module) {
+      const auto one_status = ProcessFunction(&function);
+      if (one_status == Status::Failure) return one_status;
+      if (one_status == Status::SuccessWithChange) status = one_status;
+    }
+    return status;
+  }
+};
+
+// Abstract class of a pass whose whole transformation is one forward walk
+// over the instructions of the module.  Subclasses implement VisitInst();
+// the default Process() performs the walk.  Deriving from this class
+// declares the pass's traversal shape, which lets PassManager fuse a run
+// of adjacent InstVisitorPasses into a single walk: each instruction is
+// shown to every pass of the run, in registration order, before the walk
+// advances.  A visitor must therefore confine itself to the instruction it
+// was given — it may rewrite it in place, clear its debug line
+// instructions, or ToNop() it, but must not add, remove, or reorder other
+// instructions.  Module-scope work belongs in BeginModule().
+class InstVisitorPass : public Pass {
+ public:
+  InstVisitorPass* AsInstVisitorPass() override { return this; }
+
+  // Processes the module-scope parts of |module| before the walk.  The
+  // default does nothing.
+  virtual Status BeginModule(ir::Module*) {
+    return Status::SuccessWithoutChange;
+  }
+
+  // Visits one instruction. Returns true if the instruction was changed.
+  virtual bool VisitInst(ir::Instruction* inst) = 0;
+
+  // Runs BeginModule() and then VisitInst() over every instruction.
+  Status Process(ir::Module* module) override {
+    auto status = BeginModule(module);
+    if (status == Status::Failure) return status;
+    bool modified = false;
+    module->ForEachInst([this, &modified](ir::Instruction* inst) {
+      modified |= VisitInst(inst);
+    });
+    if (modified) status = Status::SuccessWithChange;
+    return status;
+  }
 };
 
 }  // namespace opt
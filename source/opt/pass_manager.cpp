@@ -14,21 +14,202 @@
 
 #include "pass_manager.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "tracing.h"
+
 namespace spvtools {
 namespace opt {
 
-Pass::Status PassManager::Run(ir::Module* module) {
+namespace {
+
+// Counts the instructions in |module|, including debug line instructions.
+uint32_t CountInstructions(ir::Module* module) {
+  uint32_t count = 0;
+  module->ForEachInst([&count](ir::Instruction*) { ++count; }, true);
+  return count;
+}
+
+}  // anonymous namespace
+
+Pass::Status PassManager::RunPass(Pass* pass, ir::Module* module) {
+  FunctionPass* function_pass = pass->AsFunctionPass();
+  if (function_pass == nullptr || num_threads_ < 2) {
+    return pass->Process(module);
+  }
+
+  std::vector<ir::Function*> functions;
+  for (auto& function : *module) functions.push_back(&function);
+  const size_t num_workers = std::min(num_threads_, functions.size());
+  if (num_workers < 2) return pass->Process(module);
+
+  // Module-scope work runs serially, and every deferred function body is
+  // built up front: materialization allocates from the module's arena,
+  // which must not grow from several threads at once.
+  auto status = function_pass->ProcessModuleScope(module);
+  if (status == Pass::Status::Failure) return status;
+  for (ir::Function* function : functions) function->MaterializeBody();
+
+  // Workers draw function indices from a shared counter, so a worker that
+  // finishes a cheap function moves on to the next unclaimed one.
+  std::atomic<size_t> next_index(0);
+  std::vector<Pass::Status> statuses(num_workers,
+                                     Pass::Status::SuccessWithoutChange);
+  std::vector<std::thread> workers;
+  workers.reserve(num_workers);
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers.emplace_back([function_pass, &functions, &next_index, &statuses,
+                          i] {
+      for (size_t fi = next_index++; fi < functions.size(); fi = next_index++) {
+        const auto one_status = function_pass->ProcessFunction(functions[fi]);
+        if (one_status == Pass::Status::Failure) {
+          statuses[i] = one_status;
+          return;
+        }
+        if (one_status == Pass::Status::SuccessWithChange) {
+          statuses[i] = one_status;
+        }
+      }
+    });
+  }
+  for (auto& worker : workers) worker.join();
+
+  for (const auto one_status : statuses) {
+    if (one_status == Pass::Status::Failure) return one_status;
+    if (one_status == Pass::Status::SuccessWithChange) status = one_status;
+  }
+  return status;
+}
+
+Pass::Status PassManager::RunFusedVisitors(size_t begin, size_t end,
+                                           ir::Module* module) {
+  std::vector<InstVisitorPass*> visitors;
+  visitors.reserve(end - begin);
+  for (size_t i = begin; i < end; ++i) {
+    visitors.push_back(passes_[i]->AsInstVisitorPass());
+  }
+
   auto status = Pass::Status::SuccessWithoutChange;
-  for (const auto& pass : passes_) {
-    const auto one_status = pass->Process(module);
+  for (InstVisitorPass* visitor : visitors) {
+    const auto one_status = visitor->BeginModule(module);
     if (one_status == Pass::Status::Failure) return one_status;
     if (one_status == Pass::Status::SuccessWithChange) status = one_status;
   }
+
+  bool modified = false;
+  module->ForEachInst([&visitors, &modified](ir::Instruction* inst) {
+    for (InstVisitorPass* visitor : visitors) {
+      modified |= visitor->VisitInst(inst);
+    }
+  });
+  if (modified) status = Pass::Status::SuccessWithChange;
+  return status;
+}
+
+Pass::Status PassManager::Run(ir::Module* module) {
+  SPIRV_TRACE_SCOPE("optimize");
+  // The analyses built for one pass stay cached for the passes that follow,
+  // until a pass that does not preserve them changes the module.  The
+  // session carries the interned types and hash-consed constants over to
+  // the next module this manager runs on.
+  AnalysisManager analyses(consumer_, module, &session_);
+  for (auto& pass : passes_) pass->SetAnalysisManager(&analyses);
+  // The manager lives on this stack frame; the passes must not keep pointing
+  // at it once the run is over.
+  auto finish = [this](Pass::Status s) {
+    for (auto& pass : passes_) pass->SetAnalysisManager(nullptr);
+    return s;
+  };
+
+  // With a profile installed the module is classed once up front; the
+  // coarse logarithmic buckets rarely move within one run, and classing is
+  // a full instruction walk not worth repeating per pass.
+  PassProfile::ModuleClass module_class = {};
+  if (profile_) module_class = PassProfile::ClassifyModule(*module);
+
+  auto status = Pass::Status::SuccessWithoutChange;
+  for (size_t index = 0; index < passes_.size();) {
+    // Fuse a run of adjacent InstVisitorPasses into one walk.  With a stats
+    // callback or a profile installed every pass runs on its own so it can
+    // be measured individually.
+    if (!stats_callback_ && !profile_ &&
+        passes_[index]->AsInstVisitorPass() != nullptr) {
+      size_t run_end = index + 1;
+      while (run_end < passes_.size() &&
+             passes_[run_end]->AsInstVisitorPass() != nullptr) {
+        ++run_end;
+      }
+      if (run_end - index > 1) {
+        SPIRV_TRACE_SCOPE("fused-visitors");
+        const auto one_status = RunFusedVisitors(index, run_end, module);
+        if (one_status == Pass::Status::Failure) return finish(one_status);
+        if (one_status == Pass::Status::SuccessWithChange) {
+          status = one_status;
+          uint32_t preserved = AnalysisManager::kAnalysisAll;
+          for (size_t i = index; i < run_end; ++i) {
+            preserved &= passes_[i]->GetPreservedAnalyses();
+          }
+          analyses.Invalidate(preserved);
+        }
+        index = run_end;
+        continue;
+      }
+    }
+
+    Pass* pass = passes_[index].get();
+    if (profile_ && profile_->PredictsNoChange(module_class, pass->name())) {
+      ++index;
+      continue;
+    }
+    PassStats stats = {};
+    if (stats_callback_) {
+      stats.pass_name = pass->name();
+      stats.instructions_before = CountInstructions(module);
+      stats.arena_bytes_delta =
+          -static_cast<int64_t>(module->arena().TotalBytes());
+    }
+    const auto start = std::chrono::steady_clock::now();
+    Pass::Status one_status;
+    {
+      SPIRV_TRACE_SCOPE(pass->name());
+      one_status = RunPass(pass, module);
+    }
+    if (stats_callback_) {
+      stats.wall_time_ms = std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+      stats.instructions_after = CountInstructions(module);
+      stats.arena_bytes_delta +=
+          static_cast<int64_t>(module->arena().TotalBytes());
+      const ir::Arena::Stats arena_stats = module->arena().GetStats();
+      stats.arena_chunks = arena_stats.num_chunks;
+      stats.arena_bytes_used = arena_stats.used_bytes;
+      stats.memory_usage = module->EstimateMemoryUsage();
+      stats_callback_(stats);
+    }
+    if (profile_ && one_status != Pass::Status::Failure) {
+      const double wall_time_ms = std::chrono::duration<double, std::milli>(
+                                      std::chrono::steady_clock::now() - start)
+                                      .count();
+      profile_->RecordRun(module_class, pass->name(),
+                          one_status == Pass::Status::SuccessWithChange,
+                          wall_time_ms);
+    }
+    if (one_status == Pass::Status::Failure) return finish(one_status);
+    if (one_status == Pass::Status::SuccessWithChange) {
+      status = one_status;
+      analyses.Invalidate(pass->GetPreservedAnalyses());
+    }
+    ++index;
+  }
   // Set the Id bound in the header in case a pass forgot to do so.
   if (status == Pass::Status::SuccessWithChange) {
     module->SetIdBound(module->ComputeIdBound());
   }
-  return status;
+  return finish(status);
 }
 
 }  // namespace opt
@@ -15,12 +15,16 @@
 #ifndef LIBSPIRV_OPT_PASS_MANAGER_H_
 #define LIBSPIRV_OPT_PASS_MANAGER_H_
 
+#include <functional>
 #include <memory>
+#include <utility>
 #include <vector>
 
+#include "analysis_manager.h"
 #include "log.h"
 #include "module.h"
 #include "pass.h"
+#include "pass_profile.h"
 
 #include "spirv-tools/libspirv.hpp"
 
@@ -32,6 +36,24 @@ namespace opt {
 // to run on a module. Passes are executed in the exact order of addition.
 class PassManager {
  public:
+  // Measurements gathered for one pass by Run() when a stats callback is
+  // installed.  The wall time covers the Process() call alone; the arena
+  // delta is the growth of the module's IR arena across the pass, which
+  // approximates the memory retained by newly built IR.
+  struct PassStats {
+    const char* pass_name;         // The name of the pass measured.
+    double wall_time_ms;           // Wall time spent in the pass.
+    uint32_t instructions_before;  // Instruction count entering the pass.
+    uint32_t instructions_after;   // Instruction count leaving the pass.
+    int64_t arena_bytes_delta;     // Arena growth across the pass, in bytes.
+    size_t arena_chunks;           // Arena chunks reserved after the pass.
+    size_t arena_bytes_used;       // Arena bytes handed out after the pass.
+    size_t memory_usage;  // Module::EstimateMemoryUsage() after the pass.
+  };
+
+  // A callback receiving the measurements of each pass right after it runs.
+  using PassStatsCallback = std::function<void(const PassStats&)>;
+
   // Constructs a pass manager.
   //
   // The constructed instance will have an empty message consumer, which just
@@ -42,6 +64,28 @@ class PassManager {
   // Sets the message consumer to the given |consumer|.
   void SetMessageConsumer(MessageConsumer c) { consumer_ = std::move(c); }
 
+  // Sets the callback invoked with the measurements of each pass that runs.
+  // Gathering the measurements costs two instruction-count walks per pass,
+  // so leave the callback unset when not profiling.
+  void SetPassStatsCallback(PassStatsCallback c) {
+    stats_callback_ = std::move(c);
+  }
+
+  // Sets the pass profile consulted and updated by Run(), or nullptr to
+  // run every pass unconditionally.  The profile is not owned and must
+  // outlive this manager; see PassProfile for the prediction rule and for
+  // persisting a profile across tool invocations.  With a profile
+  // installed every pass runs unfused so it can be measured and predicted
+  // individually, like with a stats callback.
+  void SetPassProfile(PassProfile* profile) { profile_ = profile; }
+
+  // Sets the number of threads used to run function passes.  With more than
+  // one thread, Run() distributes the per-function work of each FunctionPass
+  // over a worker pool; module-scope work and non-function passes still run
+  // serially.  Module change listeners must not be registered during a
+  // parallel run, since workers would notify them concurrently.
+  void SetNumThreads(size_t num_threads) { num_threads_ = num_threads; }
+
   // Adds an externally constructed pass.
   void AddPass(std::unique_ptr<Pass> pass);
   // Uses the argument |args| to construct a pass instance of type |T|, and adds
@@ -63,11 +107,44 @@ class PassManager {
   // registered after the error-reporting pass will be skipped. Returns the
   // corresponding Status::Success if processing is succesful to indicate
   // whether changes are made to the module.
+  //
+  // Adjacent InstVisitorPasses are fused into a single module walk, unless
+  // a stats callback or a pass profile is installed, since fused passes
+  // cannot be measured individually.
+  //
+  // With a pass profile installed, the module is classed once on entry and
+  // passes the profile predicts ineffective for that class are skipped;
+  // every pass that does run is recorded back into the profile.
+  //
+  // Run() may be called repeatedly with different modules.  The types
+  // interned and the constants folded while processing one module are kept
+  // and reused for the next, so a batch of structurally similar modules
+  // amortizes that work across the whole batch.
   Pass::Status Run(ir::Module* module);
 
  private:
+  // Runs a single |pass| on the given |module|, distributing the
+  // per-function work of a FunctionPass over the worker pool when more than
+  // one thread was requested.
+  Pass::Status RunPass(Pass* pass, ir::Module* module);
+
+  // Runs the InstVisitorPasses with indices [begin, end) in passes_ as one
+  // module walk, showing each instruction to every pass in order.
+  Pass::Status RunFusedVisitors(size_t begin, size_t end, ir::Module* module);
+
   // Consumer for messages.
   MessageConsumer consumer_;
+  // Callback for per-pass measurements, if profiling was requested.
+  PassStatsCallback stats_callback_;
+  // Accumulated pass effectiveness used to skip predicted-ineffective
+  // passes; not owned.  Null when no profile was installed.
+  PassProfile* profile_ = nullptr;
+  // The number of threads used to run function passes.
+  size_t num_threads_ = 1;
+  // Analysis state kept across Run() calls: interned types and the
+  // constants hash-consed over them, so a sequence of structurally similar
+  // modules pays for each distinct type and constant fold only once.
+  AnalysisSession session_;
   // A vector of passes. Order matters.
   std::vector<std::unique_ptr<Pass>> passes_;
 };
@@ -0,0 +1,112 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_profile.h"
+
+#include <sstream>
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+// Returns floor(log2(count + 1)), the bucket a count is classed into.
+uint32_t BucketOf(uint32_t count) {
+  uint32_t bucket = 0;
+  for (uint64_t value = uint64_t(count) + 1; value > 1; value >>= 1) ++bucket;
+  return bucket;
+}
+
+// Packs a module class into the single ordered map key.
+uint64_t KeyOf(const PassProfile::ModuleClass& cls) {
+  return (uint64_t(cls.size_bucket) << 32) | cls.function_bucket;
+}
+
+}  // anonymous namespace
+
+PassProfile::ModuleClass PassProfile::ClassifyModule(const ir::Module& module) {
+  uint32_t num_instructions = 0;
+  module.ForEachInst(
+      [&num_instructions](const ir::Instruction*) { ++num_instructions; },
+      true);
+  uint32_t num_functions = 0;
+  for (auto it = module.cbegin(); it != module.cend(); ++it) ++num_functions;
+  return {BucketOf(num_instructions), BucketOf(num_functions)};
+}
+
+void PassProfile::RecordRun(const ModuleClass& cls, const char* pass_name,
+                            bool changed, double wall_time_ms) {
+  PassRecord& record = records_[KeyOf(cls)][pass_name];
+  ++record.runs;
+  if (changed) ++record.runs_with_change;
+  record.total_ms += wall_time_ms;
+}
+
+bool PassProfile::PredictsNoChange(const ModuleClass& cls,
+                                   const char* pass_name) const {
+  auto by_class = records_.find(KeyOf(cls));
+  if (by_class == records_.end()) return false;
+  auto by_pass = by_class->second.find(pass_name);
+  if (by_pass == by_class->second.end()) return false;
+  const PassRecord& record = by_pass->second;
+  return record.runs >= min_samples_ && record.runs_with_change == 0;
+}
+
+std::string PassProfile::Serialize() const {
+  std::ostringstream out;
+  for (const auto& by_class : records_) {
+    const uint32_t size_bucket = uint32_t(by_class.first >> 32);
+    const uint32_t function_bucket = uint32_t(by_class.first & 0xffffffffu);
+    for (const auto& by_pass : by_class.second) {
+      const PassRecord& record = by_pass.second;
+      out << size_bucket << " " << function_bucket << " " << by_pass.first
+          << " " << record.runs << " " << record.runs_with_change << " "
+          << record.total_ms << "\n";
+    }
+  }
+  return out.str();
+}
+
+bool PassProfile::Deserialize(const std::string& text) {
+  // Parse into a scratch copy first, so a malformed blob leaves the
+  // profile untouched.
+  std::map<uint64_t, std::map<std::string, PassRecord>> parsed;
+  std::istringstream in(text);
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty()) continue;
+    std::istringstream fields(line);
+    ModuleClass cls;
+    std::string pass_name;
+    PassRecord record;
+    if (!(fields >> cls.size_bucket >> cls.function_bucket >> pass_name >>
+          record.runs >> record.runs_with_change >> record.total_ms)) {
+      return false;
+    }
+    if (record.runs_with_change > record.runs) return false;
+    parsed[KeyOf(cls)][pass_name] = record;
+  }
+  for (const auto& by_class : parsed) {
+    for (const auto& by_pass : by_class.second) {
+      PassRecord& record = records_[by_class.first][by_pass.first];
+      record.runs += by_pass.second.runs;
+      record.runs_with_change += by_pass.second.runs_with_change;
+      record.total_ms += by_pass.second.total_ms;
+    }
+  }
+  return true;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,95 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_PASS_PROFILE_H_
+#define LIBSPIRV_OPT_PASS_PROFILE_H_
+
+#include <map>
+#include <string>
+
+#include "module.h"
+
+namespace spvtools {
+namespace opt {
+
+// Accumulated pass effectiveness, keyed by a coarse module class, that a
+// PassManager uses to stop running passes which never change modules like
+// the one at hand.  Install one with PassManager::SetPassProfile(); the
+// manager records every pass it runs and, once a (class, pass) pair has
+// enough samples with no change ever observed, predicts the pass
+// ineffective and skips it.
+//
+// The module class is deliberately coarse -- logarithmic buckets of the
+// instruction and function counts -- so modules from the same family land
+// in the same class and a profile warmed up on a few of them pays off for
+// the rest.  Serialize()/Deserialize() round-trip the profile through a
+// text blob, so a build system can persist it between tool invocations.
+//
+// A profile never makes skipping unsound by itself: a skipped pass is one
+// that made no change on every sampled module of the class, so the risk is
+// a missed optimization on an atypical module, never a miscompile.
+class PassProfile {
+ public:
+  // The coarse features a module is classed by.
+  struct ModuleClass {
+    uint32_t size_bucket;      // floor(log2(instruction count + 1)).
+    uint32_t function_bucket;  // floor(log2(function count + 1)).
+  };
+
+  // Returns the class of |module|.  Costs one walk of the instruction list.
+  static ModuleClass ClassifyModule(const ir::Module& module);
+
+  // Records one run of the pass named |pass_name| on a module of class
+  // |cls|: whether it reported a change, and its wall time.
+  void RecordRun(const ModuleClass& cls, const char* pass_name, bool changed,
+                 double wall_time_ms);
+
+  // Returns true when the profile predicts the pass named |pass_name| will
+  // not change a module of class |cls|: the pair has at least
+  // |min_samples()| recorded runs and none of them made a change.
+  bool PredictsNoChange(const ModuleClass& cls, const char* pass_name) const;
+
+  // The number of recorded runs a (class, pass) pair needs before
+  // PredictsNoChange may fire.  Defaults to 8.
+  uint32_t min_samples() const { return min_samples_; }
+  void set_min_samples(uint32_t n) { min_samples_ = n; }
+
+  // Returns the number of distinct (class, pass) pairs recorded.
+  size_t NumRecords() const { return records_.size(); }
+
+  // Writes the profile as a text blob, one record per line.
+  std::string Serialize() const;
+  // Merges the records in |text|, as produced by Serialize(), into this
+  // profile.  Returns false and leaves the profile unchanged when |text|
+  // is malformed.
+  bool Deserialize(const std::string& text);
+
+ private:
+  // The accumulated measurements of one pass on one module class.
+  struct PassRecord {
+    uint32_t runs = 0;              // Recorded runs.
+    uint32_t runs_with_change = 0;  // Runs that reported a change.
+    double total_ms = 0.0;          // Wall time summed over all runs.
+  };
+
+  // Records keyed by class then pass name; ordered so Serialize() output
+  // is stable.
+  std::map<uint64_t, std::map<std::string, PassRecord>> records_;
+  uint32_t min_samples_ = 8;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_PASS_PROFILE_H_
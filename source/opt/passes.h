@@ -17,14 +17,21 @@
 
 // A single header to include all passes.
 
+#include "aggressive_dead_code_elim_pass.h"
+#include "canonicalize_ids_pass.h"
 #include "compact_ids_pass.h"
 #include "eliminate_dead_constant_pass.h"
+#include "eliminate_dead_functions_pass.h"
 #include "flatten_decoration_pass.h"
 #include "fold_spec_constant_op_and_composite_pass.h"
 #include "inline_pass.h"
+#include "licm_pass.h"
+#include "local_cse_pass.h"
 #include "freeze_spec_constant_value_pass.h"
 #include "null_pass.h"
+#include "promote_locals_pass.h"
 #include "set_spec_constant_default_value_pass.h"
+#include "simplify_pass.h"
 #include "strip_debug_info_pass.h"
 #include "unify_const_pass.h"
 
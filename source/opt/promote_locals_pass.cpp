@@ -0,0 +1,327 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "promote_locals_pass.h"
+
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "cfg.h"
+#include "reflect.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+// Indices of operands in SPIR-V instructions
+static const int kSpvLoadPtrId = 2;
+static const int kSpvStorePtrId = 0;
+static const int kSpvStoreValId = 1;
+static const int kSpvVariableStorageClass = 2;
+static const int kSpvVariableInitializerId = 3;
+static const int kSpvTypePointerTypeId = 2;
+
+// Everything a promotable variable contributes to SSA construction.
+struct LocalVar {
+  uint32_t type_id;  // The pointee type, which the SSA values will have.
+  uint32_t init_id;  // The initializer id, or 0 if the variable has none.
+  // Blocks containing a store to the variable.
+  std::unordered_set<ir::BasicBlock*> store_blocks;
+  // Blocks loading the variable before any store in the same block; the
+  // variable is live into exactly the blocks these reach backwards.
+  std::vector<ir::BasicBlock*> upward_exposed_blocks;
+};
+
+// A phi to be materialized once every incoming edge has been renamed.
+struct PhiRecord {
+  uint32_t var_id;
+  uint32_t type_id;
+  uint32_t result_id;
+  // Pairs of (value id, predecessor label id) in renaming order.
+  std::vector<std::pair<uint32_t, uint32_t>> incoming;
+};
+
+}  // anonymous namespace
+
+uint32_t PromoteLocalsPass::GetUndef(uint32_t type_id) {
+  auto iter = type2undef_.find(type_id);
+  if (iter != type2undef_.end()) return iter->second;
+  const uint32_t undef_id = TakeNextId();
+  std::unique_ptr<ir::Instruction> undef_inst(
+      new ir::Instruction(SpvOpUndef, type_id, undef_id, {}));
+  module_->AddGlobalValue(std::move(undef_inst));
+  type2undef_[type_id] = undef_id;
+  return undef_id;
+}
+
+bool PromoteLocalsPass::ProcessFunction(ir::Function* func,
+                                        analysis::DefUseManager* def_use,
+                                        analysis::CfgManager* cfgs) {
+  if (func->begin() == func->end()) return false;
+  ir::BasicBlock* entry = &*func->begin();
+
+  // The shared CFG analysis already restricts edges, dominators and the
+  // postorder to the reachable blocks, so nothing below ever mentions
+  // unreachable code.
+  const analysis::FunctionCfg& cfg = cfgs->GetCfg(func);
+  const std::vector<ir::BasicBlock*>& postorder = cfg.postorder();
+
+  // Dominance frontiers per Cooper et al.
+  std::unordered_map<const ir::BasicBlock*,
+                     std::unordered_set<ir::BasicBlock*>>
+      frontier;
+  for (ir::BasicBlock* block : postorder) {
+    analysis::FunctionCfg::BlockRange block_preds = cfg.predecessors(block);
+    if (block_preds.size() < 2) continue;
+    for (ir::BasicBlock* pred : block_preds) {
+      ir::BasicBlock* runner = pred;
+      while (runner != cfg.ImmediateDominator(block)) {
+        frontier[runner].insert(block);
+        runner = cfg.ImmediateDominator(runner);
+      }
+    }
+  }
+
+  // Select the promotable variables: Function-storage OpVariables in the
+  // entry block whose every use is a whole-object load or store in a
+  // reachable block of this function. Anything else — access chains, the
+  // address escaping as a store value or call argument, decorations — keeps
+  // the variable in memory. OpName uses are swept with the variable.
+  std::unordered_map<const ir::Instruction*, ir::BasicBlock*> access2block;
+  for (ir::BasicBlock* block : postorder) {
+    for (auto inst = block->begin(); inst != block->end(); ++inst) {
+      if (inst->opcode() == SpvOpLoad || inst->opcode() == SpvOpStore)
+        access2block[&*inst] = block;
+    }
+  }
+  std::map<uint32_t, LocalVar> vars;
+  for (auto inst = entry->begin(); inst != entry->end(); ++inst) {
+    if (inst->opcode() != SpvOpVariable) break;
+    if (inst->GetSingleWordOperand(kSpvVariableStorageClass) !=
+        SpvStorageClassFunction)
+      continue;
+    const uint32_t var_id = inst->result_id();
+    bool promotable = true;
+    if (analysis::UseList* uses = def_use->GetUses(var_id)) {
+      for (const auto& use : *uses) {
+        const SpvOp op = use.inst->opcode();
+        // Memory access operands (e.g. Volatile) keep the access in memory.
+        if (op == SpvOpLoad && use.inst->NumOperands() == 3 &&
+            use.inst->GetSingleWordOperand(kSpvLoadPtrId) == var_id &&
+            access2block.count(use.inst)) {
+          continue;
+        }
+        if (op == SpvOpStore && use.inst->NumOperands() == 2 &&
+            use.inst->GetSingleWordOperand(kSpvStorePtrId) == var_id &&
+            use.inst->GetSingleWordOperand(kSpvStoreValId) != var_id &&
+            access2block.count(use.inst)) {
+          continue;
+        }
+        if (op == SpvOpName) continue;
+        promotable = false;
+        break;
+      }
+    }
+    if (!promotable) continue;
+    LocalVar& var = vars[var_id];
+    const ir::Instruction* ptr_type = def_use->GetDef(inst->type_id());
+    var.type_id = ptr_type->GetSingleWordOperand(kSpvTypePointerTypeId);
+    var.init_id = inst->NumOperands() > kSpvVariableInitializerId
+                      ? inst->GetSingleWordOperand(kSpvVariableInitializerId)
+                      : 0;
+  }
+  if (vars.empty()) return false;
+
+  // Record, per variable, the defining blocks and the blocks with an
+  // upward-exposed load.
+  for (ir::BasicBlock* block : postorder) {
+    std::unordered_set<uint32_t> stored_here;
+    std::unordered_set<uint32_t> exposed_here;
+    for (auto inst = block->begin(); inst != block->end(); ++inst) {
+      if (inst->opcode() == SpvOpStore) {
+        const uint32_t ptr = inst->GetSingleWordOperand(kSpvStorePtrId);
+        auto var = vars.find(ptr);
+        if (var != vars.end()) {
+          stored_here.insert(ptr);
+          var->second.store_blocks.insert(block);
+        }
+      } else if (inst->opcode() == SpvOpLoad) {
+        const uint32_t ptr = inst->GetSingleWordOperand(kSpvLoadPtrId);
+        auto var = vars.find(ptr);
+        if (var != vars.end() && !stored_here.count(ptr) &&
+            exposed_here.insert(ptr).second) {
+          var->second.upward_exposed_blocks.push_back(block);
+        }
+      }
+    }
+  }
+
+  // Place phis for each variable on the iterated dominance frontier of its
+  // stores, pruned to the blocks the variable is actually live into.
+  std::unordered_map<const ir::BasicBlock*, std::vector<PhiRecord>> phis;
+  for (auto& var_entry : vars) {
+    const uint32_t var_id = var_entry.first;
+    LocalVar& var = var_entry.second;
+
+    // Backwards liveness: a block propagates liveness to a predecessor
+    // unless the predecessor stores the variable itself.
+    std::unordered_set<const ir::BasicBlock*> live_in(
+        var.upward_exposed_blocks.begin(), var.upward_exposed_blocks.end());
+    std::vector<ir::BasicBlock*> live_worklist = var.upward_exposed_blocks;
+    while (!live_worklist.empty()) {
+      ir::BasicBlock* block = live_worklist.back();
+      live_worklist.pop_back();
+      for (ir::BasicBlock* pred : cfg.predecessors(block)) {
+        if (var.store_blocks.count(pred)) continue;
+        if (live_in.insert(pred).second) live_worklist.push_back(pred);
+      }
+    }
+
+    std::unordered_set<const ir::BasicBlock*> has_phi;
+    std::vector<ir::BasicBlock*> phi_worklist(var.store_blocks.begin(),
+                                              var.store_blocks.end());
+    while (!phi_worklist.empty()) {
+      ir::BasicBlock* block = phi_worklist.back();
+      phi_worklist.pop_back();
+      for (ir::BasicBlock* join : frontier[block]) {
+        if (!live_in.count(join)) continue;
+        if (!has_phi.insert(join).second) continue;
+        PhiRecord phi;
+        phi.var_id = var_id;
+        phi.type_id = var.type_id;
+        phi.result_id = TakeNextId();
+        phis[join].push_back(phi);
+        // The phi is itself a definition and may force phis further out.
+        phi_worklist.push_back(join);
+      }
+    }
+  }
+
+  // Rename over the dominator tree. Loads record a pending replacement of
+  // their result by the reaching definition; stores update the reaching
+  // definition. Values are resolved through the pending replacements as
+  // they are read, so every recorded id is final.
+  std::unordered_map<const ir::BasicBlock*, std::vector<ir::BasicBlock*>>
+      dom_children;
+  // Built from the postorder list so children, and with them the phi
+  // operand order, come out the same on every run.
+  for (ir::BasicBlock* block : postorder) {
+    if (cfg.ImmediateDominator(block) != block)
+      dom_children[cfg.ImmediateDominator(block)].push_back(block);
+  }
+  std::unordered_map<uint32_t, uint32_t> replacements;
+  std::vector<ir::Instruction*> to_kill;
+  auto resolve = [&replacements](uint32_t id) {
+    auto iter = replacements.find(id);
+    while (iter != replacements.end()) {
+      id = iter->second;
+      iter = replacements.find(id);
+    }
+    return id;
+  };
+  // The reaching definition of a variable, falling back to its initializer
+  // and finally to an undef of its type.
+  auto reaching_def = [this, &vars](
+      const std::unordered_map<uint32_t, uint32_t>& defs, uint32_t var_id) {
+    auto def = defs.find(var_id);
+    if (def != defs.end()) return def->second;
+    const LocalVar& var = vars.find(var_id)->second;
+    if (var.init_id != 0) return var.init_id;
+    return GetUndef(var.type_id);
+  };
+  std::function<void(ir::BasicBlock*, std::unordered_map<uint32_t, uint32_t>)>
+      rename = [&](ir::BasicBlock* block,
+                   std::unordered_map<uint32_t, uint32_t> defs) {
+        for (PhiRecord& phi : phis[block]) defs[phi.var_id] = phi.result_id;
+        for (auto inst = block->begin(); inst != block->end(); ++inst) {
+          if (inst->opcode() == SpvOpStore) {
+            const uint32_t ptr = inst->GetSingleWordOperand(kSpvStorePtrId);
+            if (!vars.count(ptr)) continue;
+            defs[ptr] = resolve(inst->GetSingleWordOperand(kSpvStoreValId));
+            to_kill.push_back(&*inst);
+          } else if (inst->opcode() == SpvOpLoad) {
+            const uint32_t ptr = inst->GetSingleWordOperand(kSpvLoadPtrId);
+            if (!vars.count(ptr)) continue;
+            replacements[inst->result_id()] = reaching_def(defs, ptr);
+            to_kill.push_back(&*inst);
+          }
+        }
+        for (ir::BasicBlock* succ : cfg.successors(block)) {
+          for (PhiRecord& phi : phis[succ]) {
+            phi.incoming.push_back(
+                std::make_pair(reaching_def(defs, phi.var_id), block->id()));
+          }
+        }
+        for (ir::BasicBlock* child : dom_children[block]) rename(child, defs);
+      };
+  rename(entry, std::unordered_map<uint32_t, uint32_t>());
+
+  // Materialize the phis now that all incoming edges are known.
+  for (auto& block_phis : phis) {
+    ir::BasicBlock* block = const_cast<ir::BasicBlock*>(block_phis.first);
+    for (const PhiRecord& phi : block_phis.second) {
+      std::vector<ir::Operand> operands;
+      for (const auto& incoming : phi.incoming) {
+        operands.push_back({spv_operand_type_t::SPV_OPERAND_TYPE_ID,
+                            {resolve(incoming.first)}});
+        operands.push_back(
+            {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {incoming.second}});
+      }
+      std::unique_ptr<ir::Instruction> phi_inst(new ir::Instruction(
+          SpvOpPhi, phi.type_id, phi.result_id, std::move(operands)));
+      auto pos = block->begin().InsertBefore(std::move(phi_inst));
+      def_use->AnalyzeInstDefUse(&*pos);
+    }
+  }
+
+  // Rewrite the remaining uses of load results, then drop the loads, the
+  // stores, the variables and their names.
+  for (const auto& replacement : replacements) {
+    def_use->ReplaceAllUsesWith(replacement.first,
+                                resolve(replacement.second));
+  }
+  for (ir::Instruction* inst : to_kill) def_use->KillInst(inst);
+  for (const auto& var_entry : vars) {
+    std::vector<ir::Instruction*> names;
+    if (analysis::UseList* uses = def_use->GetUses(var_entry.first)) {
+      for (const auto& use : *uses) {
+        if (ir::IsDebugInst(use.inst->opcode())) names.push_back(use.inst);
+      }
+    }
+    for (ir::Instruction* name : names) def_use->KillInst(name);
+    def_use->KillDef(var_entry.first);
+  }
+  return true;
+}
+
+Pass::Status PromoteLocalsPass::Process(ir::Module* module) {
+  module_ = module;
+  type2undef_.clear();
+  analysis::DefUseManager* def_use = analyses(module)->GetDefUse();
+  analysis::CfgManager* cfgs = analyses(module)->GetCfgs();
+  bool modified = false;
+  for (auto& func : *module) {
+    modified |= ProcessFunction(&func, def_use, cfgs);
+  }
+  module->FinalizeIdBound();
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
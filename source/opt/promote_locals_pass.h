@@ -0,0 +1,65 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_PROMOTE_LOCALS_PASS_H_
+#define LIBSPIRV_OPT_PROMOTE_LOCALS_PASS_H_
+
+#include <unordered_map>
+
+#include "cfg.h"
+#include "def_use_manager.h"
+#include "function.h"
+#include "module.h"
+#include "pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class PromoteLocalsPass : public Pass {
+ public:
+  PromoteLocalsPass() : module_(nullptr) {}
+  const char* name() const override { return "promote-locals"; }
+  Status Process(ir::Module*) override;
+
+  // The def-use analysis is kept current through DefUseManager (new phis are
+  // analyzed explicitly), and the inserted phis and removed loads and stores
+  // do not shape the CFG.
+  uint32_t GetPreservedAnalyses() const override {
+    return AnalysisManager::kAnalysisAll;
+  }
+
+ private:
+  // Return the next available id from the module's allocator.
+  inline uint32_t TakeNextId() { return module_->id_allocator().TakeNextId(); }
+
+  // Promotes the eligible function-local variables of |func| to SSA values.
+  // Returns true if any variable was promoted.
+  bool ProcessFunction(ir::Function* func, analysis::DefUseManager* def_use,
+                       analysis::CfgManager* cfgs);
+
+  // Returns the id of an OpUndef of |type_id| in the global value section,
+  // adding one on first request per type.
+  uint32_t GetUndef(uint32_t type_id);
+
+  // The module being processed.
+  ir::Module* module_;
+  // Cache of global OpUndef ids, keyed by type id.
+  std::unordered_map<uint32_t, uint32_t> type2undef_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_PROMOTE_LOCALS_PASS_H_
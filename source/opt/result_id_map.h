@@ -0,0 +1,128 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_RESULT_ID_MAP_H_
+#define LIBSPIRV_OPT_RESULT_ID_MAP_H_
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "instruction.h"
+
+namespace spvtools {
+namespace opt {
+
+// Stores a bunch of result ids and, for a given instruction, searches the
+// result id that has been defined with the same opcode, type and operands.
+// Each key sequence is appended to one contiguous arena and the table maps
+// a view of that sequence to the canonical result id, so a lookup costs a
+// single hash probe and duplicates allocate nothing.
+class ResultIdMap {
+ public:
+  ResultIdMap()
+      : key_arena_(),
+        ids_(kInitialBuckets, KeyRangeHash(&key_arena_),
+             KeyRangeEqual(&key_arena_)) {}
+
+  // The hash and equality functors point into key_arena_, so this class
+  // must stay put once constructed.
+  ResultIdMap(const ResultIdMap&) = delete;
+  ResultIdMap& operator=(const ResultIdMap&) = delete;
+
+  // For a given instruction, extracts its opcode, type id and operand words
+  // as an array of keys and looks up the result id which is stored with the
+  // same opcode, type id and operand words. If none of such result id is
+  // found, stores the instruction's result id under those keys and returns
+  // that result id. If an existing result id is found, returns the existing
+  // result id. If |commutative| is true, the last two key words (the two
+  // value operands of a commutative binary instruction) are put in sorted
+  // order so that operand order does not defeat the match.
+  uint32_t LookupEquivalentResultFor(const ir::Instruction& inst,
+                                     bool commutative = false) {
+    const uint32_t begin = static_cast<uint32_t>(key_arena_.size());
+    AppendLookUpKeys(inst);
+    if (commutative && key_arena_.size() >= begin + 2) {
+      std::sort(key_arena_.end() - 2, key_arena_.end());
+    }
+    const KeyRange keys = {
+        begin, static_cast<uint32_t>(key_arena_.size()) - begin};
+    auto insertion = ids_.insert(std::make_pair(keys, inst.result_id()));
+    if (!insertion.second) {
+      // Duplicated instruction: discard the keys appended for it.
+      key_arena_.resize(begin);
+    }
+    return insertion.first->second;
+  }
+
+ private:
+  // A view of one key sequence inside the arena.
+  struct KeyRange {
+    uint32_t begin;
+    uint32_t length;
+  };
+
+  // FNV-1a over the words of a key sequence.
+  struct KeyRangeHash {
+    explicit KeyRangeHash(const std::vector<uint32_t>* arena)
+        : arena_(arena) {}
+    size_t operator()(const KeyRange& range) const {
+      uint64_t hash = 0xcbf29ce484222325ull;
+      for (uint32_t i = 0; i < range.length; ++i) {
+        hash = (hash ^ (*arena_)[range.begin + i]) * 0x100000001b3ull;
+      }
+      return static_cast<size_t>(hash);
+    }
+    const std::vector<uint32_t>* arena_;
+  };
+
+  struct KeyRangeEqual {
+    explicit KeyRangeEqual(const std::vector<uint32_t>* arena)
+        : arena_(arena) {}
+    bool operator()(const KeyRange& lhs, const KeyRange& rhs) const {
+      return lhs.length == rhs.length &&
+             std::equal(arena_->begin() + lhs.begin,
+                        arena_->begin() + lhs.begin + lhs.length,
+                        arena_->begin() + rhs.begin);
+    }
+    const std::vector<uint32_t>* arena_;
+  };
+
+  // Appends to the arena the opcode followed by the words in the raw SPIR-V
+  // instruction encoding but without the result id.
+  void AppendLookUpKeys(const ir::Instruction& inst) {
+    // Need to use the opcode, otherwise there might be a conflict with the
+    // following case when <op>'s binary value equals xx's id:
+    //  OpSpecConstantOp tt <op> yy zz
+    //  OpSpecConstantComposite tt xx yy zz;
+    key_arena_.push_back(static_cast<uint32_t>(inst.opcode()));
+    for (const auto& operand : inst) {
+      if (operand.type == SPV_OPERAND_TYPE_RESULT_ID) continue;
+      key_arena_.insert(key_arena_.end(), operand.words.cbegin(),
+                        operand.words.cend());
+    }
+  }
+
+  static const size_t kInitialBuckets = 64;
+
+  // The arena holding every stored key sequence back to back.  Must be
+  // declared before ids_, whose functors point at it.
+  std::vector<uint32_t> key_arena_;
+  std::unordered_map<KeyRange, uint32_t, KeyRangeHash, KeyRangeEqual> ids_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_RESULT_ID_MAP_H_
@@ -201,8 +201,8 @@ Pass::Status SetSpecConstantDefaultValuePass::Process(ir::Module* module) {
   const uint32_t kOpSpecConstantLiteralInOperandIndex = 0;
 
   bool modified = false;
-  analysis::DefUseManager def_use_mgr(consumer(), module);
-  analysis::TypeManager type_mgr(consumer(), *module);
+  analysis::DefUseManager& def_use_mgr = *analyses(module)->GetDefUse();
+  analysis::TypeManager& type_mgr = *analyses(module)->GetTypes();
   // Scan through all the annotation instructions to find 'OpDecorate SpecId'
   // instructions. Then extract the decoration target of those instructions.
   // The decoration targets should be spec constant defining instructions with
@@ -52,6 +52,14 @@ class SetSpecConstantDefaultValuePass : public Pass {
   const char* name() const override { return "set-spec-const-default-value"; }
   Status Process(ir::Module*) override;
 
+  // Only the literal words of spec constants change; ids, control flow and
+  // types are untouched. A cached constant analysis would hold the old
+  // default values, so it is dropped.
+  uint32_t GetPreservedAnalyses() const override {
+    return AnalysisManager::kAnalysisDefUse | AnalysisManager::kAnalysisCfg |
+           AnalysisManager::kAnalysisTypes;
+  }
+
   // Parses the given null-terminated C string to get a mapping from Spec Id to
   // default value strings. Returns a unique pointer of the mapping from spec
   // ids to spec constant default value strings built from the given |str| on
@@ -0,0 +1,366 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "shard.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "opcode.h"
+#include "reflect.h"
+#include "spirv_constant.h"
+
+namespace spvtools {
+
+namespace {
+
+// Reports |message| as a sharding error through |consumer|.
+void ShardError(const MessageConsumer& consumer, const std::string& message) {
+  if (consumer) consumer(SPV_MSG_ERROR, "shard", {0, 0, 0}, message.c_str());
+}
+
+// The word range of one function definition in the module binary.
+struct FunctionRange {
+  uint32_t id;   // Result id of the OpFunction.
+  size_t begin;  // Word offset of the OpFunction instruction.
+  size_t end;    // Word offset just past the OpFunctionEnd instruction.
+};
+
+// Splits the instruction stream of |binary| into the global section
+// [SPV_INDEX_INSTRUCTION, *globals_end) and the function definitions.
+// Returns true on success; reports malformed streams through |consumer|.
+bool ScanModule(const std::vector<uint32_t>& binary,
+                const MessageConsumer& consumer, size_t* globals_end,
+                std::vector<FunctionRange>* functions) {
+  if (binary.size() < SPV_INDEX_INSTRUCTION ||
+      binary[SPV_INDEX_MAGIC_NUMBER] != SpvMagicNumber) {
+    ShardError(consumer, "Invalid module binary");
+    return false;
+  }
+  *globals_end = binary.size();
+  size_t index = SPV_INDEX_INSTRUCTION;
+  bool in_function = false;
+  size_t function_begin = 0;
+  uint32_t function_id = 0;
+  while (index < binary.size()) {
+    uint16_t word_count = 0;
+    uint16_t opcode = 0;
+    spvOpcodeSplit(binary[index], &word_count, &opcode);
+    if (word_count == 0 || index + word_count > binary.size()) {
+      ShardError(consumer, "Truncated or malformed instruction stream");
+      return false;
+    }
+    if (opcode == SpvOpFunction) {
+      if (!in_function) {
+        if (*globals_end == binary.size()) *globals_end = index;
+        in_function = true;
+        function_begin = index;
+        function_id = binary[index + 2];
+      }
+    } else if (opcode == SpvOpFunctionEnd && in_function) {
+      functions->push_back({function_id, function_begin, index + word_count});
+      in_function = false;
+    }
+    index += word_count;
+  }
+  if (in_function) {
+    ShardError(consumer, "Module ends inside a function");
+    return false;
+  }
+  return true;
+}
+
+// Union-find over function indices, used to cluster call graphs.
+size_t FindRoot(std::vector<size_t>* parent, size_t index) {
+  while ((*parent)[index] != index) {
+    (*parent)[index] = (*parent)[(*parent)[index]];  // Path halving.
+    index = (*parent)[index];
+  }
+  return index;
+}
+
+void UnionRoots(std::vector<size_t>* parent, size_t a, size_t b) {
+  (*parent)[FindRoot(parent, a)] = FindRoot(parent, b);
+}
+
+// A set of call-connected functions, kept whole during shard assignment.
+struct CallCluster {
+  std::vector<size_t> function_indices;  // Into the scanned function list.
+  size_t num_words = 0;                  // Total size of those functions.
+};
+
+// Groups |functions| into call clusters: two functions land in the same
+// cluster when one calls the other, directly or transitively.
+std::vector<CallCluster> BuildCallClusters(
+    const std::vector<uint32_t>& binary,
+    const std::vector<FunctionRange>& functions) {
+  std::unordered_map<uint32_t, size_t> function_of_id;
+  for (size_t i = 0; i < functions.size(); ++i) {
+    function_of_id.emplace(functions[i].id, i);
+  }
+  std::vector<size_t> parent(functions.size());
+  for (size_t i = 0; i < parent.size(); ++i) parent[i] = i;
+  for (size_t i = 0; i < functions.size(); ++i) {
+    size_t index = functions[i].begin;
+    while (index < functions[i].end) {
+      uint16_t word_count = 0;
+      uint16_t opcode = 0;
+      spvOpcodeSplit(binary[index], &word_count, &opcode);
+      if (opcode == SpvOpFunctionCall) {
+        const uint32_t callee_id = binary[index + 3];
+        auto callee = function_of_id.find(callee_id);
+        if (callee != function_of_id.end()) {
+          UnionRoots(&parent, i, callee->second);
+        }
+      }
+      index += word_count;
+    }
+  }
+  // Collect clusters in first-function order, so the result is
+  // deterministic regardless of union order.
+  std::unordered_map<size_t, size_t> cluster_of_root;
+  std::vector<CallCluster> clusters;
+  for (size_t i = 0; i < functions.size(); ++i) {
+    const size_t root = FindRoot(&parent, i);
+    auto where = cluster_of_root.find(root);
+    if (where == cluster_of_root.end()) {
+      where = cluster_of_root.emplace(root, clusters.size()).first;
+      clusters.push_back(CallCluster());
+    }
+    CallCluster& cluster = clusters[where->second];
+    cluster.function_indices.push_back(i);
+    cluster.num_words += functions[i].end - functions[i].begin;
+  }
+  return clusters;
+}
+
+// Returns the result id of the instruction at |words|, or 0 when its opcode
+// does not produce one (or is unknown to the unified grammar).
+uint32_t ResultIdOf(const spv_opcode_table table, const uint32_t* words) {
+  uint16_t word_count = 0;
+  uint16_t opcode = 0;
+  spvOpcodeSplit(words[0], &word_count, &opcode);
+  spv_opcode_desc desc = nullptr;
+  if (spvOpcodeTableValueLookup(table, static_cast<SpvOp>(opcode), &desc)) {
+    return 0;
+  }
+  if (!desc->hasResult) return 0;
+  return words[desc->hasType ? 2 : 1];
+}
+
+// Returns the logical-layout section the module-level instruction with
+// |opcode| belongs to, as an ordering key for merged output.  Everything in
+// the type/constant/variable tail of the global section maps to the last
+// slot, preserving relative order.
+size_t SectionOf(const SpvOp opcode) {
+  switch (opcode) {
+    case SpvOpCapability:
+      return 0;
+    case SpvOpExtension:
+      return 1;
+    case SpvOpExtInstImport:
+      return 2;
+    case SpvOpMemoryModel:
+      return 3;
+    case SpvOpEntryPoint:
+      return 4;
+    case SpvOpExecutionMode:
+      return 5;
+    default:
+      break;
+  }
+  if (ir::IsDebugInst(opcode) && !ir::IsDebugLineInst(opcode)) return 6;
+  if (ir::IsAnnotationInst(opcode)) return 7;
+  return 8;
+}
+const size_t kNumSections = 9;
+
+}  // anonymous namespace
+
+bool ShardModule(const std::vector<uint32_t>& binary, size_t max_shards,
+                 uint32_t fresh_ids_per_shard,
+                 std::vector<std::vector<uint32_t>>* shard_binaries,
+                 const MessageConsumer& consumer) {
+  if (!shard_binaries) {
+    ShardError(consumer, "Missing shard output vector");
+    return false;
+  }
+  if (max_shards == 0) {
+    ShardError(consumer, "At least one shard must be allowed");
+    return false;
+  }
+
+  size_t globals_end = 0;
+  std::vector<FunctionRange> functions;
+  if (!ScanModule(binary, consumer, &globals_end, &functions)) return false;
+
+  const std::vector<CallCluster> clusters =
+      BuildCallClusters(binary, functions);
+  const size_t num_shards =
+      std::max<size_t>(1, std::min(max_shards, clusters.size()));
+
+  const uint64_t highest_bound =
+      uint64_t(binary[SPV_INDEX_BOUND]) +
+      uint64_t(num_shards - 1) * fresh_ids_per_shard;
+  if (highest_bound > 0xffffffffull) {
+    ShardError(consumer, "Id range reservation overflows the id space");
+    return false;
+  }
+
+  // Assign clusters, heaviest first, to the lightest shard so far.
+  std::vector<size_t> order(clusters.size());
+  for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&clusters](size_t a, size_t b) {
+    return clusters[a].num_words > clusters[b].num_words;
+  });
+  std::vector<std::vector<size_t>> shard_functions(num_shards);
+  std::vector<size_t> shard_weights(num_shards, 0);
+  for (const size_t cluster_index : order) {
+    size_t lightest = 0;
+    for (size_t shard = 1; shard < num_shards; ++shard) {
+      if (shard_weights[shard] < shard_weights[lightest]) lightest = shard;
+    }
+    const CallCluster& cluster = clusters[cluster_index];
+    shard_functions[lightest].insert(shard_functions[lightest].end(),
+                                     cluster.function_indices.begin(),
+                                     cluster.function_indices.end());
+    shard_weights[lightest] += cluster.num_words;
+  }
+
+  std::vector<std::vector<uint32_t>> shards(num_shards);
+  for (size_t shard = 0; shard < num_shards; ++shard) {
+    // Keep the module's function order within the shard.
+    std::sort(shard_functions[shard].begin(), shard_functions[shard].end());
+    std::unordered_set<uint32_t> shard_function_ids;
+    for (const size_t function_index : shard_functions[shard]) {
+      shard_function_ids.insert(functions[function_index].id);
+    }
+
+    std::vector<uint32_t>& out = shards[shard];
+    out.reserve(globals_end + shard_weights[shard]);
+    out.insert(out.end(), binary.begin(),
+               binary.begin() + SPV_INDEX_INSTRUCTION);
+    out[SPV_INDEX_BOUND] = binary[SPV_INDEX_BOUND] +
+                           uint32_t(shard) * fresh_ids_per_shard;
+
+    // The global section, minus entry points and execution modes whose
+    // function lives in another shard.
+    size_t index = SPV_INDEX_INSTRUCTION;
+    while (index < globals_end) {
+      uint16_t word_count = 0;
+      uint16_t opcode = 0;
+      spvOpcodeSplit(binary[index], &word_count, &opcode);
+      bool keep = true;
+      if (opcode == SpvOpEntryPoint) {
+        keep = shard_function_ids.count(binary[index + 2]) != 0;
+      } else if (opcode == SpvOpExecutionMode) {
+        keep = shard_function_ids.count(binary[index + 1]) != 0;
+      }
+      if (keep) {
+        out.insert(out.end(), binary.begin() + index,
+                   binary.begin() + index + word_count);
+      }
+      index += word_count;
+    }
+
+    for (const size_t function_index : shard_functions[shard]) {
+      const FunctionRange& range = functions[function_index];
+      out.insert(out.end(), binary.begin() + range.begin,
+                 binary.begin() + range.end);
+    }
+  }
+
+  *shard_binaries = std::move(shards);
+  return true;
+}
+
+bool MergeShards(const std::vector<std::vector<uint32_t>>& shard_binaries,
+                 std::vector<uint32_t>* merged_binary,
+                 const MessageConsumer& consumer) {
+  if (!merged_binary) {
+    ShardError(consumer, "Missing merge output vector");
+    return false;
+  }
+  if (shard_binaries.empty()) {
+    ShardError(consumer, "No shards to merge");
+    return false;
+  }
+
+  spv_opcode_table opcode_table = nullptr;
+  if (spvOpcodeTableGet(&opcode_table, SPV_ENV_UNIVERSAL_1_2)) {
+    ShardError(consumer, "Missing opcode table");
+    return false;
+  }
+
+  std::vector<std::vector<uint32_t>> sections(kNumSections);
+  std::vector<uint32_t> function_stream;
+  std::unordered_set<uint32_t> seen_ids;
+  std::unordered_set<std::string> seen_words;
+  uint32_t merged_bound = 0;
+
+  for (size_t shard = 0; shard < shard_binaries.size(); ++shard) {
+    const std::vector<uint32_t>& binary = shard_binaries[shard];
+    size_t globals_end = 0;
+    std::vector<FunctionRange> functions;
+    if (!ScanModule(binary, consumer, &globals_end, &functions)) return false;
+    merged_bound = std::max(merged_bound, binary[SPV_INDEX_BOUND]);
+
+    size_t index = SPV_INDEX_INSTRUCTION;
+    while (index < globals_end) {
+      uint16_t word_count = 0;
+      uint16_t opcode_word = 0;
+      spvOpcodeSplit(binary[index], &word_count, &opcode_word);
+      const SpvOp opcode = static_cast<SpvOp>(opcode_word);
+      // An instruction shared by the split appears once per shard; keep the
+      // first copy.  Result-id identity is authoritative where there is
+      // one -- the shards' fresh-id ranges are disjoint -- and the exact
+      // words decide for the rest.
+      bool keep;
+      const uint32_t result_id = ResultIdOf(opcode_table, &binary[index]);
+      if (result_id != 0) {
+        keep = seen_ids.insert(result_id).second;
+      } else {
+        keep = seen_words
+                   .insert(std::string(
+                       reinterpret_cast<const char*>(&binary[index]),
+                       size_t(word_count) * sizeof(uint32_t)))
+                   .second;
+      }
+      if (keep) {
+        std::vector<uint32_t>& section = sections[SectionOf(opcode)];
+        section.insert(section.end(), binary.begin() + index,
+                       binary.begin() + index + word_count);
+      }
+      index += word_count;
+    }
+    function_stream.insert(function_stream.end(), binary.begin() + globals_end,
+                           binary.end());
+  }
+
+  std::vector<uint32_t> merged;
+  merged.insert(merged.end(), shard_binaries[0].begin(),
+                shard_binaries[0].begin() + SPV_INDEX_INSTRUCTION);
+  merged[SPV_INDEX_BOUND] = merged_bound;
+  for (const std::vector<uint32_t>& section : sections) {
+    merged.insert(merged.end(), section.begin(), section.end());
+  }
+  merged.insert(merged.end(), function_stream.begin(), function_stream.end());
+
+  *merged_binary = std::move(merged);
+  return true;
+}
+
+}  // namespace spvtools
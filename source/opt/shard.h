@@ -0,0 +1,69 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_SHARD_H_
+#define LIBSPIRV_OPT_SHARD_H_
+
+#include <vector>
+
+#include "spirv-tools/libspirv.hpp"
+
+namespace spvtools {
+
+// Partitions the module in |binary| into at most |max_shards| self-contained
+// shard binaries, so very large modules can be optimized in parallel --
+// including on separate machines -- and re-merged with MergeShards.
+//
+// Every shard carries the whole module-level section (capabilities,
+// extensions, imports, memory model, debug and annotation instructions, and
+// all types, constants, and global variables) plus a subset of the
+// functions.  Functions connected by OpFunctionCall are clustered together
+// so a call never crosses a shard boundary, and clusters are balanced
+// across shards by word count.  Entry points and execution modes follow
+// their function's shard.
+//
+// Shards keep the original id numbering, and shard i's header bound is
+// raised by i * |fresh_ids_per_shard| so the fresh ids each shard allocates
+// while being optimized come from disjoint ranges.  |fresh_ids_per_shard|
+// must therefore exceed the number of ids any one shard's optimization will
+// create; MergeShards relies on the ranges staying disjoint.
+//
+// Returns true on success; on failure, reports the problem through
+// |consumer| and leaves |shard_binaries| untouched.  Fewer than
+// |max_shards| shards are produced when the module has fewer call clusters.
+bool ShardModule(const std::vector<uint32_t>& binary, size_t max_shards,
+                 uint32_t fresh_ids_per_shard,
+                 std::vector<std::vector<uint32_t>>* shard_binaries,
+                 const MessageConsumer& consumer);
+
+// Re-merges shard binaries produced by ShardModule -- and possibly
+// optimized independently since -- into one module written to
+// |merged_binary|.  Module-level instructions shared by the split collapse
+// to one occurrence: instructions with a result id are deduplicated by that
+// id (sound because shard id ranges are disjoint), the rest by their exact
+// words.  Instructions a shard's optimization added are carried over;
+// module-level instructions must not have been mutated in place, since one
+// shard's copy of a shared instruction is kept unexamined.  Functions from
+// all shards are concatenated, and the merged bound is the largest shard
+// bound.
+//
+// Returns true on success; on failure, reports the problem through
+// |consumer| and leaves |merged_binary| untouched.
+bool MergeShards(const std::vector<std::vector<uint32_t>>& shard_binaries,
+                 std::vector<uint32_t>* merged_binary,
+                 const MessageConsumer& consumer);
+
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_SHARD_H_
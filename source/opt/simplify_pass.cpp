@@ -0,0 +1,287 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "simplify_pass.h"
+
+#include <unordered_set>
+#include <vector>
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+// Indices of operands in SPIR-V instructions
+static const int kSpvTypeFloatWidth = 1;
+static const int kSpvTypeVectorCount = 2;
+
+// The constant value an operand must hold for a rule to fire.
+enum class IdentityValue { kZero, kOne };
+
+// What a fired rule replaces the result with.
+enum class RuleAction {
+  kReturnOther,     // the non-constant operand, e.g. x + 0 -> x
+  kReturnIdentity,  // the constant operand itself, e.g. x & 0 -> 0
+};
+
+// One entry of the pattern table for binary operations: when one operand of
+// |opcode| is the given constant, the result reduces to an existing id.
+// Rules with |either_operand| fire on both operand positions; the others
+// only on the second operand (subtraction, division and shifts are not
+// symmetric). Floating-point rules are restricted to the transformations
+// that hold for every operand value including -0, infinities and NaN, so
+// x + 0.0 is deliberately absent: it would turn -0 into +0.
+struct BinaryRule {
+  SpvOp opcode;
+  IdentityValue identity;
+  bool either_operand;
+  RuleAction action;
+};
+
+const BinaryRule kBinaryRules[] = {
+    {SpvOpIAdd, IdentityValue::kZero, true, RuleAction::kReturnOther},
+    {SpvOpISub, IdentityValue::kZero, false, RuleAction::kReturnOther},
+    {SpvOpIMul, IdentityValue::kOne, true, RuleAction::kReturnOther},
+    {SpvOpIMul, IdentityValue::kZero, true, RuleAction::kReturnIdentity},
+    {SpvOpUDiv, IdentityValue::kOne, false, RuleAction::kReturnOther},
+    {SpvOpSDiv, IdentityValue::kOne, false, RuleAction::kReturnOther},
+    {SpvOpFSub, IdentityValue::kZero, false, RuleAction::kReturnOther},
+    {SpvOpFMul, IdentityValue::kOne, true, RuleAction::kReturnOther},
+    {SpvOpFDiv, IdentityValue::kOne, false, RuleAction::kReturnOther},
+    {SpvOpBitwiseOr, IdentityValue::kZero, true, RuleAction::kReturnOther},
+    {SpvOpBitwiseXor, IdentityValue::kZero, true, RuleAction::kReturnOther},
+    {SpvOpBitwiseAnd, IdentityValue::kZero, true,
+     RuleAction::kReturnIdentity},
+    {SpvOpShiftLeftLogical, IdentityValue::kZero, false,
+     RuleAction::kReturnOther},
+    {SpvOpShiftRightLogical, IdentityValue::kZero, false,
+     RuleAction::kReturnOther},
+    {SpvOpShiftRightArithmetic, IdentityValue::kZero, false,
+     RuleAction::kReturnOther},
+};
+
+// Returns true if |id| is a constant holding |value|: a scalar zero or one
+// of integer or floating-point type, an OpConstantNull for zero, or a
+// constant composite whose components all hold the value (a splat).
+bool IsIdentityConstant(uint32_t id, IdentityValue value,
+                        analysis::DefUseManager* def_use) {
+  const ir::Instruction* def = def_use->GetDef(id);
+  if (def == nullptr) return false;
+  switch (def->opcode()) {
+    case SpvOpConstantNull:
+      return value == IdentityValue::kZero;
+    case SpvOpConstant: {
+      const ir::OperandWords words = def->GetInOperand(0).words;
+      if (value == IdentityValue::kZero) {
+        // All-zero bits are zero for both integers and floats.
+        for (uint32_t word : words)
+          if (word != 0) return false;
+        return !words.empty();
+      }
+      const ir::Instruction* type = def_use->GetDef(def->type_id());
+      if (type->opcode() == SpvOpTypeInt) {
+        if (words.empty() || words.front() != 1) return false;
+        for (uint32_t i = 1; i < words.size(); ++i)
+          if (words[i] != 0) return false;
+        return true;
+      }
+      if (type->opcode() == SpvOpTypeFloat) {
+        switch (type->GetSingleWordOperand(kSpvTypeFloatWidth)) {
+          case 16:
+            return words.size() == 1 && words[0] == 0x3c00u;
+          case 32:
+            return words.size() == 1 && words[0] == 0x3f800000u;
+          case 64:
+            return words.size() == 2 && words[0] == 0 &&
+                   words[1] == 0x3ff00000u;
+          default:
+            return false;
+        }
+      }
+      return false;
+    }
+    case SpvOpConstantComposite: {
+      for (uint32_t i = 0; i < def->NumInOperands(); ++i) {
+        if (!IsIdentityConstant(def->GetSingleWordInOperand(i), value,
+                                def_use))
+          return false;
+      }
+      return def->NumInOperands() != 0;
+    }
+    default:
+      return false;
+  }
+}
+
+// Runs |inst| against the binary rule table. Returns the replacement id, or
+// 0 if no rule fires.
+uint32_t MatchBinaryRules(const ir::Instruction& inst,
+                          analysis::DefUseManager* def_use) {
+  if (inst.NumInOperands() != 2) return 0;
+  const uint32_t lhs = inst.GetSingleWordInOperand(0);
+  const uint32_t rhs = inst.GetSingleWordInOperand(1);
+  for (const BinaryRule& rule : kBinaryRules) {
+    if (rule.opcode != inst.opcode()) continue;
+    uint32_t replacement = 0;
+    if (IsIdentityConstant(rhs, rule.identity, def_use)) {
+      replacement = rule.action == RuleAction::kReturnOther ? lhs : rhs;
+    } else if (rule.either_operand &&
+               IsIdentityConstant(lhs, rule.identity, def_use)) {
+      replacement = rule.action == RuleAction::kReturnOther ? rhs : lhs;
+    }
+    if (replacement == 0) continue;
+    // The integer opcodes accept operands whose signedness differs from
+    // the result type; forwarding such an operand (or the identity
+    // constant) would change the type of every use. Only replace when the
+    // types agree exactly.
+    const ir::Instruction* replacement_def = def_use->GetDef(replacement);
+    if (replacement_def == nullptr ||
+        replacement_def->type_id() != inst.type_id())
+      continue;
+    return replacement;
+  }
+  return 0;
+}
+
+// A bitcast whose operand already has the result type, or whose operand is
+// itself a bitcast from the result type, reduces to the original value.
+uint32_t MatchBitcast(const ir::Instruction& inst,
+                      analysis::DefUseManager* def_use) {
+  const uint32_t operand_id = inst.GetSingleWordInOperand(0);
+  const ir::Instruction* operand_def = def_use->GetDef(operand_id);
+  if (operand_def == nullptr) return 0;
+  if (operand_def->type_id() == inst.type_id()) return operand_id;
+  if (operand_def->opcode() == SpvOpBitcast) {
+    const uint32_t source_id = operand_def->GetSingleWordInOperand(0);
+    const ir::Instruction* source_def = def_use->GetDef(source_id);
+    if (source_def != nullptr && source_def->type_id() == inst.type_id())
+      return source_id;
+  }
+  return 0;
+}
+
+// Returns true if constituent i of |construct| is component i of the
+// result. Structs, arrays and matrices always list one constituent per
+// member; vectors may be built from smaller vectors, so only an operand
+// count matching the component count lines the two up.
+bool ConstructIsOnePerComponent(const ir::Instruction& construct,
+                                analysis::DefUseManager* def_use) {
+  const ir::Instruction* type = def_use->GetDef(construct.type_id());
+  if (type->opcode() == SpvOpTypeVector) {
+    return construct.NumInOperands() ==
+           type->GetSingleWordOperand(kSpvTypeVectorCount);
+  }
+  return true;
+}
+
+// An extract of component i from a construct listing one constituent per
+// component reduces to constituent i.
+uint32_t MatchCompositeExtract(const ir::Instruction& inst,
+                               analysis::DefUseManager* def_use) {
+  if (inst.NumInOperands() != 2) return 0;  // A single literal index only.
+  const ir::Instruction* composite =
+      def_use->GetDef(inst.GetSingleWordInOperand(0));
+  if (composite == nullptr ||
+      composite->opcode() != SpvOpCompositeConstruct)
+    return 0;
+  if (!ConstructIsOnePerComponent(*composite, def_use)) return 0;
+  const uint32_t index = inst.GetSingleWordInOperand(1);
+  if (index >= composite->NumInOperands()) return 0;
+  return composite->GetSingleWordInOperand(index);
+}
+
+// A construct that reassembles every component of one value in order is
+// that value: construct(extract(v, 0), ..., extract(v, n-1)) -> v.
+uint32_t MatchCompositeConstruct(const ir::Instruction& inst,
+                                 analysis::DefUseManager* def_use) {
+  if (inst.NumInOperands() == 0) return 0;
+  if (!ConstructIsOnePerComponent(inst, def_use)) return 0;
+  uint32_t source_id = 0;
+  for (uint32_t i = 0; i < inst.NumInOperands(); ++i) {
+    const ir::Instruction* extract =
+        def_use->GetDef(inst.GetSingleWordInOperand(i));
+    if (extract == nullptr || extract->opcode() != SpvOpCompositeExtract ||
+        extract->NumInOperands() != 2 ||
+        extract->GetSingleWordInOperand(1) != i)
+      return 0;
+    const uint32_t composite_id = extract->GetSingleWordInOperand(0);
+    if (i == 0) {
+      source_id = composite_id;
+    } else if (composite_id != source_id) {
+      return 0;
+    }
+  }
+  const ir::Instruction* source = def_use->GetDef(source_id);
+  if (source == nullptr || source->type_id() != inst.type_id()) return 0;
+  return source_id;
+}
+
+// Returns the existing id |inst|'s result reduces to, or 0 when no pattern
+// applies.
+uint32_t Simplify(const ir::Instruction& inst,
+                  analysis::DefUseManager* def_use) {
+  switch (inst.opcode()) {
+    case SpvOpBitcast:
+      return MatchBitcast(inst, def_use);
+    case SpvOpCompositeExtract:
+      return MatchCompositeExtract(inst, def_use);
+    case SpvOpCompositeConstruct:
+      return MatchCompositeConstruct(inst, def_use);
+    default:
+      return MatchBinaryRules(inst, def_use);
+  }
+}
+
+}  // anonymous namespace
+
+Pass::Status SimplifyPass::Process(ir::Module* module) {
+  analysis::DefUseManager* def_use = analyses(module)->GetDefUse();
+
+  // Seed the worklist with every instruction in the function bodies, in
+  // module order. Simplifying an instruction re-queues its users, so a
+  // pattern exposed by an earlier rewrite is picked up in the same run
+  // without another full-module sweep.
+  std::vector<ir::Instruction*> worklist;
+  std::unordered_set<const ir::Instruction*> queued;
+  for (auto& func : *module) {
+    for (auto& block : func) {
+      for (auto inst = block.begin(); inst != block.end(); ++inst) {
+        worklist.push_back(&*inst);
+        queued.insert(&*inst);
+      }
+    }
+  }
+
+  bool modified = false;
+  for (size_t i = 0; i < worklist.size(); ++i) {
+    ir::Instruction* inst = worklist[i];
+    queued.erase(inst);
+    if (inst->result_id() == 0) continue;
+    const uint32_t replacement = Simplify(*inst, def_use);
+    if (replacement == 0 || replacement == inst->result_id()) continue;
+    // Queue the users before the use list moves over to the replacement id.
+    if (analysis::UseList* uses = def_use->GetUses(inst->result_id())) {
+      for (const auto& use : *uses) {
+        if (queued.insert(use.inst).second) worklist.push_back(use.inst);
+      }
+    }
+    def_use->ReplaceAllUsesWith(inst->result_id(), replacement);
+    def_use->KillInst(inst);
+    modified = true;
+  }
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,42 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "string_pool.h"
+
+namespace spvtools {
+namespace ir {
+
+uint32_t StringPool::Intern(const uint32_t* words, uint32_t num_words) {
+  std::string key(reinterpret_cast<const char*>(words),
+                  num_words * sizeof(uint32_t));
+  auto insertion =
+      index_.insert(std::make_pair(std::move(key),
+                                   static_cast<uint32_t>(strings_.size())));
+  if (insertion.second) {
+    strings_.push_back(std::vector<uint32_t>(words, words + num_words));
+  }
+  return insertion.first->second;
+}
+
+size_t StringPool::EstimateMemoryUsage() const {
+  size_t total = strings_.capacity() * sizeof(std::vector<uint32_t>);
+  for (const auto& words : strings_)
+    total += words.capacity() * sizeof(uint32_t);
+  for (const auto& entry : index_)
+    total += entry.first.capacity() + sizeof(entry);
+  return total;
+}
+
+}  // namespace ir
+}  // namespace spvtools
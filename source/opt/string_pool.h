@@ -0,0 +1,72 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_STRING_POOL_H_
+#define LIBSPIRV_OPT_STRING_POOL_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace spvtools {
+namespace ir {
+
+// Interns the word sequences of literal-string operands. Each distinct
+// sequence is stored once and named by a small intern id, so a module full
+// of repeated debug path strings keeps a single copy of every string, and
+// two interned operands hold the same string exactly when their intern ids
+// compare equal. Ids are never invalidated; the pool only grows.
+class StringPool {
+ public:
+  StringPool() {}
+
+  // The pool owns the canonical copies; duplicating it makes no sense.
+  StringPool(const StringPool&) = delete;
+  StringPool& operator=(const StringPool&) = delete;
+
+  // Interns the |num_words| words at |words| and returns their intern id.
+  // The same sequence always yields the same id.
+  uint32_t Intern(const uint32_t* words, uint32_t num_words);
+
+  // The words of the interned string |id|.
+  const std::vector<uint32_t>& words(uint32_t id) const {
+    return strings_[id];
+  }
+
+  // The number of distinct strings interned.
+  size_t size() const { return strings_.size(); }
+
+  // Exchanges contents with |other|.  Intern ids from each pool keep
+  // naming the same strings in their new home.
+  void Swap(StringPool& other) {
+    strings_.swap(other.strings_);
+    index_.swap(other.index_);
+  }
+
+  // Returns an estimate in bytes of the heap storage owned by this pool
+  // beyond the object itself.
+  size_t EstimateMemoryUsage() const;
+
+ private:
+  // The canonical copy of every interned string, indexed by intern id.
+  std::vector<std::vector<uint32_t>> strings_;
+  // Maps the raw bytes of a sequence to its intern id.
+  std::unordered_map<std::string, uint32_t> index_;
+};
+
+}  // namespace ir
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_STRING_POOL_H_
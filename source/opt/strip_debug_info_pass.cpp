@@ -17,17 +17,17 @@
 namespace spvtools {
 namespace opt {
 
-Pass::Status StripDebugInfoPass::Process(ir::Module* module) {
-  bool modified = !module->debugs().empty();
+Pass::Status StripDebugInfoPass::BeginModule(ir::Module* module) {
+  const bool modified = !module->debugs().empty();
   module->debug_clear();
-
-  module->ForEachInst([&modified](ir::Instruction* inst) {
-    modified |= !inst->dbg_line_insts().empty();
-    inst->dbg_line_insts().clear();
-  });
-
   return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
 }
 
+bool StripDebugInfoPass::VisitInst(ir::Instruction* inst) {
+  const bool modified = inst->HasDbgLineInsts();
+  inst->ClearDbgLineInsts();
+  return modified;
+}
+
 }  // namespace opt
 }  // namespace spvtools
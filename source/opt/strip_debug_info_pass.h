@@ -22,10 +22,11 @@ namespace spvtools {
 namespace opt {
 
 // See optimizer.hpp for documentation.
-class StripDebugInfoPass : public Pass {
+class StripDebugInfoPass : public InstVisitorPass {
  public:
   const char* name() const override { return "strip-debug"; }
-  Status Process(ir::Module* module) override;
+  Status BeginModule(ir::Module* module) override;
+  bool VisitInst(ir::Instruction* inst) override;
 };
 
 }  // namespace opt
@@ -14,6 +14,7 @@
 
 #include "type_manager.h"
 
+#include <string>
 #include <utility>
 
 #include "log.h"
@@ -24,6 +25,8 @@ namespace opt {
 namespace analysis {
 
 Type* TypeManager::GetType(uint32_t id) const {
+  auto pooled = id_to_pooled_.find(id);
+  if (pooled != id_to_pooled_.end()) return (*pooled).second;
   auto iter = id_to_type_.find(id);
   if (iter != id_to_type_.end()) return (*iter).second.get();
   return nullptr;
@@ -35,6 +38,12 @@ uint32_t TypeManager::GetId(const Type* type) const {
   return 0;
 }
 
+Type* TypeManager::GetCanonicalType(const Type* type) const {
+  auto iter = canonical_types_.find(type);
+  if (iter != canonical_types_.end()) return (*iter).second;
+  return nullptr;
+}
+
 ForwardPointer* TypeManager::GetForwardPointer(uint32_t index) const {
   if (index >= forward_pointers_.size()) return nullptr;
   return forward_pointers_.at(index).get();
@@ -43,6 +52,57 @@ ForwardPointer* TypeManager::GetForwardPointer(uint32_t index) const {
 void TypeManager::AnalyzeTypes(const spvtools::ir::Module& module) {
   for (const auto* inst : module.GetTypes()) RecordIfTypeDefinition(*inst);
   for (const auto& inst : module.annotations()) AttachIfTypeDecoration(inst);
+  // Canonicalization needs the decorations, so it must run last.
+  CanonicalizeTypes();
+}
+
+void TypeManager::CanonicalizeTypes() {
+  // Bucket types by a structural fingerprint. The fingerprint does not cover
+  // struct member decorations, so IsSame stays authoritative within a
+  // bucket; it over-approximates equivalence classes, which only costs a few
+  // extra deep comparisons. Processing in definition order keeps the choice
+  // of representative deterministic.
+  std::unordered_map<std::string, std::vector<Type*>> buckets;
+  for (const uint32_t id : type_definition_order_) {
+    Type* type = id_to_type_[id].get();
+    auto& bucket = buckets[type->str() + "|" + type->GetDecorationStr()];
+    Type* canonical = nullptr;
+    for (Type* candidate : bucket) {
+      if (candidate->IsSame(type)) {
+        canonical = candidate;
+        break;
+      }
+    }
+    if (canonical == nullptr) {
+      bucket.push_back(type);
+      canonical = type;
+    }
+    canonical_types_[type] = canonical;
+  }
+  if (pool_ != nullptr) PoolTypes();
+}
+
+void TypeManager::PoolTypes() {
+  // Interning is all-or-nothing: if some type cannot be pooled (e.g. a
+  // pointer left incomplete by an unresolved forward reference), handing
+  // out a mix of pooled and module-owned pointers would break the pointer
+  // comparisons the pool exists for, so fall back to module-local
+  // canonicalization entirely.
+  for (const uint32_t id : type_definition_order_) {
+    Type* type = id_to_type_[id].get();
+    Type* pooled = pool_->GetRegisteredType(type);
+    if (pooled == nullptr) {
+      id_to_pooled_.clear();
+      return;
+    }
+    id_to_pooled_[id] = pooled;
+    // Keep the first defining id as the answer for GetId() on the pooled
+    // representative, matching the representative choice made above.
+    type_to_id_.emplace(pooled, id);
+    canonical_types_[type] = pooled;
+    canonical_types_[pooled] = pooled;
+  }
+  all_types_pooled_ = true;
 }
 
 Type* TypeManager::RecordIfTypeDefinition(
@@ -175,6 +235,7 @@ Type* TypeManager::RecordIfTypeDefinition(
                  "type should not be nullptr at this point");
     id_to_type_[id].reset(type);
     type_to_id_[type] = id;
+    type_definition_order_.push_back(id);
   }
   return type;
 }
@@ -20,8 +20,10 @@
 #include <unordered_set>
 #include <vector>
 
+#include "arena.h"
 #include "module.h"
 #include "spirv-tools/libspirv.hpp"
+#include "type_pool.h"
 #include "types.h"
 
 namespace spvtools {
@@ -37,8 +39,12 @@ class TypeManager {
   // will be communicated to the outside via the given message |consumer|.
   // This instance only keeps a reference to the |consumer|, so the |consumer|
   // should outlive this instance.
+  // The optional |pool| must outlive this instance; when given, every
+  // registered type is also interned into it and GetType() hands out the
+  // pooled representatives, so structurally identical types resolve to the
+  // same pointer across all managers sharing the pool.
   TypeManager(const MessageConsumer& consumer,
-              const spvtools::ir::Module& module);
+              const spvtools::ir::Module& module, TypePool* pool = nullptr);
 
   TypeManager(const TypeManager&) = delete;
   TypeManager(TypeManager&&) = delete;
@@ -46,7 +52,8 @@ class TypeManager {
   TypeManager& operator=(TypeManager&&) = delete;
 
   // Returns the type for the given type |id|. Returns nullptr if the given |id|
-  // does not define a type.
+  // does not define a type. When this manager canonicalizes into a shared
+  // pool, the returned type is the pooled representative.
   Type* GetType(uint32_t id) const;
   // Returns the id for the given |type|. Returns 0 if can not find the given
   // |type|.
@@ -57,6 +64,24 @@ class TypeManager {
   IdToTypeMap::const_iterator begin() const { return id_to_type_.cbegin(); }
   IdToTypeMap::const_iterator end() const { return id_to_type_.cend(); }
 
+  // Returns the canonical representative of the given |type|. All
+  // structurally identical types registered in this manager share one
+  // representative, so two types are equivalent exactly when their canonical
+  // pointers compare equal; no recursive walk is needed. Returns nullptr if
+  // the given type is not managed by this manager.
+  Type* GetCanonicalType(const Type* type) const;
+  // Returns true if the two given types managed by this manager are
+  // structurally identical, including decorations. This is a constant-time
+  // pointer comparison of canonical representatives.
+  bool AreSameType(const Type* a, const Type* b) const {
+    return GetCanonicalType(a) == GetCanonicalType(b);
+  }
+
+  // Returns true if every registered type has a representative in the shared
+  // pool, so all type pointers handed out by this manager outlive the
+  // module. Always false without a pool.
+  bool AllTypesPooled() const { return all_types_pooled_; }
+
   // Returns the forward pointer type at the given |index|.
   ForwardPointer* GetForwardPointer(uint32_t index) const;
   // Returns the number of forward pointer types hold in this manager.
@@ -69,6 +94,16 @@ class TypeManager {
   // Analyzes the types and decorations on types in the given |module|.
   void AnalyzeTypes(const spvtools::ir::Module& module);
 
+  // Assigns every registered type its canonical representative. Types are
+  // bucketed by a structural fingerprint first, so the deep IsSame
+  // comparison only runs between fingerprint-identical candidates.
+  void CanonicalizeTypes();
+
+  // Interns every registered type into the shared pool and redirects the
+  // canonical representatives to the pooled copies. Falls back to the
+  // module-local representatives when some type cannot be pooled.
+  void PoolTypes();
+
   // Creates and returns a type from the given SPIR-V |inst|. Returns nullptr if
   // the given instruction is not for defining a type.
   Type* RecordIfTypeDefinition(const spvtools::ir::Instruction& inst);
@@ -77,8 +112,23 @@ class TypeManager {
   void AttachIfTypeDecoration(const spvtools::ir::Instruction& inst);
 
   const MessageConsumer& consumer_;  // Message consumer.
+  // The shared pool to canonicalize into, if any.
+  TypePool* pool_;
+  // Backing storage for the Type objects this manager creates.  Declared
+  // before the containers below so it is destroyed after them: deleting an
+  // arena-backed type still reads its allocation header.
+  spvtools::ir::Arena arena_;
   IdToTypeMap id_to_type_;  // Mapping from ids to their type representations.
   TypeToIdMap type_to_id_;  // Mapping from types to their defining ids.
+  // Ids of type definitions in the order they appear in the module.
+  std::vector<uint32_t> type_definition_order_;
+  // Mapping from each registered type to its canonical representative.
+  std::unordered_map<const Type*, Type*> canonical_types_;
+  // Mapping from ids to the pooled representatives; empty unless every
+  // registered type could be pooled.
+  std::unordered_map<uint32_t, Type*> id_to_pooled_;
+  // True when GetType() hands out pooled representatives for all ids.
+  bool all_types_pooled_ = false;
   ForwardPointerVector forward_pointers_;  // All forward pointer declarations.
   // All unresolved forward pointer declarations.
   // Refers the contents in the above vector.
@@ -86,8 +136,12 @@ class TypeManager {
 };
 
 inline TypeManager::TypeManager(const spvtools::MessageConsumer& consumer,
-                                const spvtools::ir::Module& module)
-    : consumer_(consumer) {
+                                const spvtools::ir::Module& module,
+                                TypePool* pool)
+    : consumer_(consumer), pool_(pool) {
+  // Place the Type objects built during the analysis in this manager's
+  // arena; they are all torn down together with the manager.
+  ir::ArenaScope arena_scope(&arena_);
   AnalyzeTypes(module);
 }
 
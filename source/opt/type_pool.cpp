@@ -0,0 +1,145 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "type_pool.h"
+
+#include <utility>
+
+#include "make_unique.h"
+
+namespace spvtools {
+namespace opt {
+namespace analysis {
+
+Type* TypePool::GetRegisteredType(const Type* type) {
+  if (type == nullptr || type->AsForwardPointer()) return nullptr;
+  // Pooled copies built below (including those of the recursive calls, whose
+  // scopes nest) are placed in the pool's own arena.
+  ir::ArenaScope arena_scope(&arena_);
+  // References into an unordered_map stay valid over the insertions the
+  // recursive rebuild below may perform.
+  auto& bucket = buckets_[type->str() + "|" + type->GetDecorationStr()];
+  for (auto& candidate : bucket) {
+    // IsSame takes a mutable pointer but only inspects its argument.
+    if (candidate->IsSame(const_cast<Type*>(type))) return candidate.get();
+  }
+  std::unique_ptr<Type> pooled = RebuildType(*type);
+  if (pooled == nullptr) return nullptr;
+  bucket.push_back(std::move(pooled));
+  ++num_types_;
+  return bucket.back().get();
+}
+
+std::unique_ptr<Type> TypePool::RebuildType(const Type& type) {
+  std::unique_ptr<Type> rebuilt;
+  // Composite kinds are rebuilt over the pooled copies of their subtypes;
+  // the remaining kinds carry no type references and can be copied whole,
+  // decorations included.
+  if (const Vector* vec = type.AsVector()) {
+    Type* element = GetRegisteredType(vec->element_type());
+    if (element == nullptr) return nullptr;
+    rebuilt = MakeUnique<Vector>(element, vec->element_count());
+  } else if (const Matrix* mat = type.AsMatrix()) {
+    Type* element = GetRegisteredType(mat->element_type());
+    if (element == nullptr) return nullptr;
+    rebuilt = MakeUnique<Matrix>(element, mat->element_count());
+  } else if (const Image* image = type.AsImage()) {
+    Type* sampled = GetRegisteredType(image->sampled_type());
+    if (sampled == nullptr) return nullptr;
+    rebuilt = MakeUnique<Image>(sampled, image->dim(), image->depth(),
+                                image->arrayed(), image->ms(),
+                                image->sampled(), image->format(),
+                                image->access_qualifier());
+  } else if (const SampledImage* sampled_image = type.AsSampledImage()) {
+    // |image| from the branch above stays in scope here; use another name.
+    Type* pooled_image = GetRegisteredType(sampled_image->image_type());
+    if (pooled_image == nullptr) return nullptr;
+    rebuilt = MakeUnique<SampledImage>(pooled_image);
+  } else if (const Array* array = type.AsArray()) {
+    Type* element = GetRegisteredType(array->element_type());
+    if (element == nullptr) return nullptr;
+    rebuilt = MakeUnique<Array>(element, array->LengthId());
+  } else if (const RuntimeArray* runtime_array = type.AsRuntimeArray()) {
+    Type* element = GetRegisteredType(runtime_array->element_type());
+    if (element == nullptr) return nullptr;
+    rebuilt = MakeUnique<RuntimeArray>(element);
+  } else if (const Struct* st = type.AsStruct()) {
+    std::vector<Type*> element_types;
+    for (const Type* element : st->element_types()) {
+      Type* pooled_element = GetRegisteredType(element);
+      if (pooled_element == nullptr) return nullptr;
+      element_types.push_back(pooled_element);
+    }
+    auto pooled_struct = MakeUnique<Struct>(element_types);
+    for (const auto& member : st->element_decorations()) {
+      for (const auto& decoration : member.second) {
+        pooled_struct->AddMemberDecoration(
+            member.first, std::vector<uint32_t>(decoration));
+      }
+    }
+    rebuilt = std::move(pooled_struct);
+  } else if (const Pointer* pointer = type.AsPointer()) {
+    Type* pointee = GetRegisteredType(pointer->pointee_type());
+    if (pointee == nullptr) return nullptr;
+    rebuilt = MakeUnique<Pointer>(pointee, pointer->storage_class());
+  } else if (const Function* function = type.AsFunction()) {
+    Type* return_type = GetRegisteredType(function->return_type());
+    if (return_type == nullptr) return nullptr;
+    std::vector<Type*> param_types;
+    for (const Type* param : function->param_types()) {
+      Type* pooled_param = GetRegisteredType(param);
+      if (pooled_param == nullptr) return nullptr;
+      param_types.push_back(pooled_param);
+    }
+    rebuilt = MakeUnique<Function>(return_type, param_types);
+  } else if (const Integer* integer = type.AsInteger()) {
+    return MakeUnique<Integer>(*integer);
+  } else if (const Float* flt = type.AsFloat()) {
+    return MakeUnique<Float>(*flt);
+  } else if (const Opaque* opaque = type.AsOpaque()) {
+    return MakeUnique<Opaque>(*opaque);
+  } else if (const Pipe* pipe = type.AsPipe()) {
+    return MakeUnique<Pipe>(*pipe);
+  } else if (type.AsVoid()) {
+    return MakeUnique<Void>(*type.AsVoid());
+  } else if (type.AsBool()) {
+    return MakeUnique<Bool>(*type.AsBool());
+  } else if (type.AsSampler()) {
+    return MakeUnique<Sampler>(*type.AsSampler());
+  } else if (type.AsEvent()) {
+    return MakeUnique<Event>(*type.AsEvent());
+  } else if (type.AsDeviceEvent()) {
+    return MakeUnique<DeviceEvent>(*type.AsDeviceEvent());
+  } else if (type.AsReserveId()) {
+    return MakeUnique<ReserveId>(*type.AsReserveId());
+  } else if (type.AsQueue()) {
+    return MakeUnique<Queue>(*type.AsQueue());
+  } else if (type.AsPipeStorage()) {
+    return MakeUnique<PipeStorage>(*type.AsPipeStorage());
+  } else if (type.AsNamedBarrier()) {
+    return MakeUnique<NamedBarrier>(*type.AsNamedBarrier());
+  } else {
+    return nullptr;  // An unknown kind; leave it unpooled.
+  }
+  // The constructors above do not carry over the decorations attached
+  // directly on the source type.
+  for (const auto& decoration : type.decorations()) {
+    rebuilt->AddDecoration(std::vector<uint32_t>(decoration));
+  }
+  return rebuilt;
+}
+
+}  // namespace analysis
+}  // namespace opt
+}  // namespace spvtools
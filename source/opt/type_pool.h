@@ -0,0 +1,77 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_TYPE_POOL_H_
+#define LIBSPIRV_OPT_TYPE_POOL_H_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "arena.h"
+#include "types.h"
+
+namespace spvtools {
+namespace opt {
+namespace analysis {
+
+// Owns one self-contained copy of every distinct type registered with it, so
+// structurally identical types from different modules share a single
+// representative whose lifetime is that of the pool, not of any module. A
+// TypeManager constructed over a pool canonicalizes into it, which lets
+// type-keyed state — most notably the hash-consed constants of a
+// ConstantManager — carry over from one module to the next when many
+// structurally similar modules are optimized by the same pipeline.
+class TypePool {
+ public:
+  TypePool() {}
+
+  TypePool(const TypePool&) = delete;
+  TypePool& operator=(const TypePool&) = delete;
+
+  // Returns the pooled representative of |type|, registering a copy on first
+  // sight. The representative is structurally identical to |type|, including
+  // decorations, but references only pooled subtypes, so it stays valid
+  // after the module that defined |type| is gone. Returns nullptr for the
+  // rare types that cannot be pooled: forward pointer declarations, and any
+  // type reaching a subtype hole left by an unresolved forward reference.
+  Type* GetRegisteredType(const Type* type);
+
+  // Returns the number of distinct types pooled so far.
+  size_t NumTypes() const { return num_types_; }
+
+ private:
+  // Builds the pool-owned copy of |type| over pooled subtypes. Returns
+  // nullptr when |type| cannot be pooled.
+  std::unique_ptr<Type> RebuildType(const Type& type);
+
+  // Backing storage for the pooled copies.  Declared before the buckets so
+  // it is destroyed after them: deleting an arena-backed type still reads
+  // its allocation header.
+  spvtools::ir::Arena arena_;
+  // Pooled types bucketed by the same structural fingerprint that
+  // TypeManager::CanonicalizeTypes uses. The fingerprint does not cover
+  // struct member decorations or decorations on subtypes, so IsSame decides
+  // within a bucket.
+  std::unordered_map<std::string, std::vector<std::unique_ptr<Type>>> buckets_;
+  // The number of types owned across all buckets.
+  size_t num_types_ = 0;
+};
+
+}  // namespace analysis
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_TYPE_POOL_H_
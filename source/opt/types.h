@@ -21,6 +21,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "arena.h"
 #include "spirv-tools/libspirv.h"
 #include "spirv/1.2/spirv.h"
 
@@ -54,7 +55,11 @@ class NamedBarrier;
 
 // Abstract class for a SPIR-V type. It has a bunch of As<sublcass>() methods,
 // which is used as a way to probe the actual <subclass>.
-class Type {
+//
+// Types are ArenaAllocated, so instances created with `new` inside an
+// ArenaScope (as TypeManager and TypePool do) are bump-allocated from the
+// scope's arena and their storage is reclaimed wholesale with it.
+class Type : public ir::ArenaAllocated {
  public:
   virtual ~Type() {}
 
@@ -62,6 +67,10 @@ class Type {
   void AddDecoration(std::vector<uint32_t>&& d) {
     decorations_.push_back(std::move(d));
   }
+  // Returns the decorations attached directly on this type.
+  const std::vector<std::vector<uint32_t>>& decorations() const {
+    return decorations_;
+  }
   // Returns the decorations on this type as a string.
   std::string GetDecorationStr() const;
   // Returns true if this type has exactly the same decorations as |that| type.
@@ -197,6 +206,15 @@ class Image : public Type {
   Image* AsImage() override { return this; }
   const Image* AsImage() const override { return this; }
 
+  const Type* sampled_type() const { return sampled_type_; }
+  SpvDim dim() const { return dim_; }
+  uint32_t depth() const { return depth_; }
+  uint32_t arrayed() const { return arrayed_; }
+  uint32_t ms() const { return ms_; }
+  uint32_t sampled() const { return sampled_; }
+  SpvImageFormat format() const { return format_; }
+  SpvAccessQualifier access_qualifier() const { return access_qualifier_; }
+
  private:
   Type* sampled_type_;
   SpvDim dim_;
@@ -215,6 +233,7 @@ class SampledImage : public Type {
 
   bool IsSame(Type* that) const override;
   std::string str() const override;
+  const Type* image_type() const { return image_type_; }
 
   SampledImage* AsSampledImage() override { return this; }
   const SampledImage* AsSampledImage() const override { return this; }
@@ -269,6 +288,10 @@ class Struct : public Type {
   bool IsSame(Type* that) const override;
   std::string str() const override;
   const std::vector<Type*>& element_types() const { return element_types_; }
+  const std::unordered_map<uint32_t, std::vector<std::vector<uint32_t>>>&
+  element_decorations() const {
+    return element_decorations_;
+  }
   bool decoration_empty() const override {
     return decorations_.empty() && element_decorations_.empty();
   }
@@ -292,6 +315,7 @@ class Opaque : public Type {
 
   bool IsSame(Type* that) const override;
   std::string str() const override;
+  const std::string& name() const { return name_; }
 
   Opaque* AsOpaque() override { return this; }
   const Opaque* AsOpaque() const override { return this; }
@@ -308,6 +332,7 @@ class Pointer : public Type {
   bool IsSame(Type* that) const override;
   std::string str() const override;
   const Type* pointee_type() const { return pointee_type_; }
+  SpvStorageClass storage_class() const { return storage_class_; }
 
   Pointer* AsPointer() override { return this; }
   const Pointer* AsPointer() const override { return this; }
@@ -324,6 +349,8 @@ class Function : public Type {
 
   bool IsSame(Type* that) const override;
   std::string str() const override;
+  const Type* return_type() const { return return_type_; }
+  const std::vector<Type*>& param_types() const { return param_types_; }
 
   Function* AsFunction() override { return this; }
   const Function* AsFunction() const override { return this; }
@@ -341,6 +368,7 @@ class Pipe : public Type {
 
   bool IsSame(Type* that) const override;
   std::string str() const override;
+  SpvAccessQualifier access_qualifier() const { return access_qualifier_; }
 
   Pipe* AsPipe() override { return this; }
   const Pipe* AsPipe() const override { return this; }
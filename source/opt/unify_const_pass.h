@@ -26,6 +26,13 @@ class UnifyConstantPass : public Pass {
  public:
   const char* name() const override { return "unify-const"; }
   Status Process(ir::Module*) override;
+
+  // Duplicates are removed through DefUseManager; control flow and types are
+  // untouched. A cached constant analysis would be stale, so it is dropped.
+  uint32_t GetPreservedAnalyses() const override {
+    return AnalysisManager::kAnalysisDefUse | AnalysisManager::kAnalysisCfg |
+           AnalysisManager::kAnalysisTypes;
+  }
 };
 
 }  // namespace opt
@@ -17,10 +17,33 @@
 #include "parsed_operand.h"
 
 #include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
 #include "util/hex_float.h"
 
 namespace libspirv {
 
+namespace {
+
+// Writes the given zero or normal float to the stream as preformatted
+// characters, sidestepping the stream's numeric formatting machinery.  The
+// %g conversion produces the same text as the default floatfield at the
+// same precision.  Returns false for values that need the hex-float path.
+template <typename T>
+bool EmitDecimalFloat(std::ostream* out, T value) {
+  const int value_class = std::fpclassify(value);
+  if (value_class != FP_ZERO && value_class != FP_NORMAL) return false;
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "%.*g", std::numeric_limits<T>::digits10,
+           double(value));
+  *out << buffer;
+  return true;
+}
+
+}  // anonymous namespace
+
 void EmitNumericLiteral(std::ostream* out, const spv_parsed_instruction_t& inst,
                         const spv_parsed_operand_t& operand) {
   assert(operand.type == SPV_OPERAND_TYPE_LITERAL_INTEGER ||
@@ -43,7 +66,8 @@ void EmitNumericLiteral(std::ostream* out, const spv_parsed_instruction_t& inst,
               uint16_t(word & 0xFFFF));
         } else {
           // Assume 32-bit floats.
-          *out << spvutils::FloatProxy<float>(word);
+          const spvutils::FloatProxy<float> value(word);
+          if (!EmitDecimalFloat(out, value.getAsFloat())) *out << value;
         }
         break;
       default:
@@ -60,10 +84,11 @@ void EmitNumericLiteral(std::ostream* out, const spv_parsed_instruction_t& inst,
       case SPV_NUMBER_UNSIGNED_INT:
         *out << bits;
         break;
-      case SPV_NUMBER_FLOATING:
+      case SPV_NUMBER_FLOATING: {
         // Assume only 64-bit floats.
-        *out << spvutils::FloatProxy<double>(bits);
-        break;
+        const spvutils::FloatProxy<double> value(bits);
+        if (!EmitDecimalFloat(out, value.getAsFloat())) *out << value;
+      } break;
       default:
         assert(false && "Unreachable");
     }
@@ -0,0 +1,527 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "spirv_compression.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "diagnostic.h"
+#include "opcode.h"
+#include "spirv-tools/libspirv.h"
+#include "table.h"
+#include "util/bit_stream.h"
+#include "util/huffman_codec.h"
+
+namespace libspirv {
+namespace {
+
+// Magic word and version identifying the compressed stream format.
+const uint32_t kCompressedMagic = 0x43565053;  // "SPVC" in little-endian.
+const uint32_t kCompressedVersion = 2;
+// Version 1 is the original single-stream layout; its instruction coding is
+// identical, so the decoder still accepts it.
+const uint32_t kCompressedVersionSingleStream = 1;
+
+// Chunk lengths for the variable-width encodings.  Word counts and id deltas
+// are typically tiny; operand words and histogram entries skew larger.
+const size_t kWordCountChunkLength = 4;
+const size_t kIdDeltaChunkLength = 4;
+const size_t kOperandChunkLength = 8;
+const size_t kHistogramChunkLength = 8;
+
+// Number of instructions per framing chunk in a version 2 stream.  Small
+// enough that typical pipeline-cache modules split into several chunks and
+// decompression spreads across cores; large enough that the per-chunk delta
+// reset and directory entry cost stay in the noise.
+const size_t kInstructionsPerChunk = 4096;
+
+// Every segment of a version 2 stream is padded to this many bytes, so each
+// chunk's BitReaderWord64 starts on a 64-bit word boundary and reads full
+// words from a cache-friendly contiguous run.
+const size_t kSegmentAlignment = 8;
+
+// Accumulates the parsed module: header fields, instruction words, and the
+// opcode histogram the Huffman codes are derived from.
+struct ParsedModule {
+  uint32_t version = 0;
+  uint32_t generator = 0;
+  uint32_t id_bound = 0;
+  uint32_t schema = 0;
+  uint32_t num_instructions = 0;
+  std::vector<uint32_t> inst_words;
+  std::unordered_map<uint32_t, uint32_t> opcode_hist;
+};
+
+spv_result_t HandleHeader(void* user_data, spv_endianness_t /* endian */,
+                          uint32_t /* magic */, uint32_t version,
+                          uint32_t generator, uint32_t id_bound,
+                          uint32_t schema) {
+  ParsedModule* module = static_cast<ParsedModule*>(user_data);
+  module->version = version;
+  module->generator = generator;
+  module->id_bound = id_bound;
+  module->schema = schema;
+  return SPV_SUCCESS;
+}
+
+spv_result_t HandleInstruction(void* user_data,
+                               const spv_parsed_instruction_t* inst) {
+  ParsedModule* module = static_cast<ParsedModule*>(user_data);
+  module->inst_words.insert(module->inst_words.end(), inst->words,
+                            inst->words + inst->num_words);
+  ++module->opcode_hist[inst->opcode];
+  ++module->num_instructions;
+  return SPV_SUCCESS;
+}
+
+// Returns the histogram as a vector sorted by opcode: the canonical order in
+// which it is written to the stream, and from which both the encoder and the
+// decoder build identical Huffman trees.
+std::vector<std::pair<uint32_t, uint32_t>> SortedHistogram(
+    const std::unordered_map<uint32_t, uint32_t>& hist) {
+  std::vector<std::pair<uint32_t, uint32_t>> sorted(hist.begin(), hist.end());
+  std::sort(sorted.begin(), sorted.end());
+  return sorted;
+}
+
+// Encodes |num_insts| instructions from |inst_words| starting at word
+// |start| into |writer|, with the delta-coding state starting from zero.
+// Returns nullptr on success, otherwise a static description of the error.
+// Runs on worker threads: the opcode table is only read, and everything
+// written is thread-local.
+const char* EncodeInstructions(const spv_opcode_table opcode_table,
+                               const std::vector<uint32_t>& inst_words,
+                               size_t start, size_t num_insts,
+                               const spvutils::HuffmanCodec<uint32_t>& codec,
+                               spvutils::BitWriterWord64* writer) {
+  uint32_t prev_type_id = 0;
+  uint32_t prev_result_id = 0;
+  size_t index = start;
+  for (size_t i = 0; i < num_insts; ++i) {
+    const uint32_t first_word = inst_words[index];
+    const uint32_t opcode = first_word & 0xffff;
+    const uint32_t inst_num_words = first_word >> 16;
+
+    spv_opcode_desc desc = nullptr;
+    if (spvOpcodeTableValueLookup(opcode_table, static_cast<SpvOp>(opcode),
+                                  &desc))
+      return "Opcode accepted by the parser is missing from the opcode table.";
+
+    if (!codec.Write(opcode, writer))
+      return "Opcode is missing from its own histogram.";
+    writer->WriteVariableWidthU32(inst_num_words, kWordCountChunkLength);
+
+    // Result type and result id, when present, sit right after the opcode
+    // word and correlate strongly with those of the previous instruction,
+    // so both are delta coded.
+    size_t operand = index + 1;
+    if (desc->hasType) {
+      const uint32_t type_id = inst_words[operand++];
+      writer->WriteVariableWidthS64(
+          static_cast<int64_t>(type_id) - static_cast<int64_t>(prev_type_id),
+          kIdDeltaChunkLength, 0);
+      prev_type_id = type_id;
+    }
+    if (desc->hasResult) {
+      const uint32_t result_id = inst_words[operand++];
+      writer->WriteVariableWidthS64(
+          static_cast<int64_t>(result_id) -
+              static_cast<int64_t>(prev_result_id),
+          kIdDeltaChunkLength, 0);
+      prev_result_id = result_id;
+    }
+    for (; operand < index + inst_num_words; ++operand)
+      writer->WriteVariableWidthU32(inst_words[operand],
+                                    kOperandChunkLength);
+
+    index += inst_num_words;
+  }
+  return nullptr;
+}
+
+// Decodes |num_insts| instructions from |reader| and appends their words to
+// |words|, with the delta-coding state starting from zero.  Returns nullptr
+// on success, otherwise a static description of the error.  Runs on worker
+// threads under the same constraints as EncodeInstructions().
+const char* DecodeInstructions(const spv_opcode_table opcode_table,
+                               spvutils::BitReaderWord64* reader,
+                               const spvutils::HuffmanCodec<uint32_t>& codec,
+                               uint32_t num_insts,
+                               std::vector<uint32_t>* words) {
+  uint32_t prev_type_id = 0;
+  uint32_t prev_result_id = 0;
+  for (uint32_t i = 0; i < num_insts; ++i) {
+    uint32_t opcode = 0;
+    if (!codec.Read(reader, &opcode))
+      return "Unexpected end of stream reading an opcode.";
+    uint32_t inst_num_words = 0;
+    if (!reader->ReadVariableWidthU32(&inst_num_words, kWordCountChunkLength))
+      return "Unexpected end of stream reading a word count.";
+
+    spv_opcode_desc desc = nullptr;
+    if (spvOpcodeTableValueLookup(opcode_table, static_cast<SpvOp>(opcode),
+                                  &desc))
+      return "Compressed module contains an unknown opcode.";
+    const uint32_t num_id_words =
+        1u + (desc->hasType ? 1u : 0u) + (desc->hasResult ? 1u : 0u);
+    if (inst_num_words > 0xffff || inst_num_words < num_id_words)
+      return "Invalid instruction word count.";
+
+    words->push_back((inst_num_words << 16) | opcode);
+    if (desc->hasType) {
+      int64_t delta = 0;
+      if (!reader->ReadVariableWidthS64(&delta, kIdDeltaChunkLength, 0))
+        return "Unexpected end of stream reading a result type id.";
+      const int64_t type_id = static_cast<int64_t>(prev_type_id) + delta;
+      if (type_id <= 0 || type_id > 0xffffffffll)
+        return "Result type id delta out of range.";
+      prev_type_id = static_cast<uint32_t>(type_id);
+      words->push_back(prev_type_id);
+    }
+    if (desc->hasResult) {
+      int64_t delta = 0;
+      if (!reader->ReadVariableWidthS64(&delta, kIdDeltaChunkLength, 0))
+        return "Unexpected end of stream reading a result id.";
+      const int64_t result_id = static_cast<int64_t>(prev_result_id) + delta;
+      if (result_id <= 0 || result_id > 0xffffffffll)
+        return "Result id delta out of range.";
+      prev_result_id = static_cast<uint32_t>(result_id);
+      words->push_back(prev_result_id);
+    }
+    for (uint32_t w = num_id_words; w < inst_num_words; ++w) {
+      uint32_t word = 0;
+      if (!reader->ReadVariableWidthU32(&word, kOperandChunkLength))
+        return "Unexpected end of stream reading operand words.";
+      words->push_back(word);
+    }
+  }
+  return nullptr;
+}
+
+// Appends the bits accumulated in |writer| to |out|, zero-padded to the
+// segment alignment.
+void AppendSegment(const spvutils::BitWriterWord64& writer,
+                   std::vector<uint8_t>* out) {
+  const uint8_t* data = writer.GetData();
+  out->insert(out->end(), data, data + writer.GetDataSizeBytes());
+  while (out->size() % kSegmentAlignment != 0) out->push_back(0);
+}
+
+// The directory at the tail of a version 2 stream is plain little-endian
+// 32-bit words, readable without a bit reader.
+void AppendU32(uint32_t value, std::vector<uint8_t>* out) {
+  out->push_back(static_cast<uint8_t>(value));
+  out->push_back(static_cast<uint8_t>(value >> 8));
+  out->push_back(static_cast<uint8_t>(value >> 16));
+  out->push_back(static_cast<uint8_t>(value >> 24));
+}
+
+uint32_t ReadU32(const uint8_t* data) {
+  return static_cast<uint32_t>(data[0]) |
+         (static_cast<uint32_t>(data[1]) << 8) |
+         (static_cast<uint32_t>(data[2]) << 16) |
+         (static_cast<uint32_t>(data[3]) << 24);
+}
+
+// Runs |task| for every index in [0, num_tasks), spread over at most
+// |num_threads| worker threads.  Workers draw indices from a shared counter,
+// so a worker that finishes a small chunk moves on to the next unclaimed
+// one.
+void RunChunkTasks(size_t num_tasks, size_t num_threads,
+                   const std::function<void(size_t)>& task) {
+  const size_t num_workers = std::min(num_threads, num_tasks);
+  if (num_workers < 2) {
+    for (size_t i = 0; i < num_tasks; ++i) task(i);
+    return;
+  }
+  std::atomic<size_t> next_index(0);
+  std::vector<std::thread> workers;
+  workers.reserve(num_workers);
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers.emplace_back([num_tasks, &next_index, &task] {
+      for (size_t ci = next_index++; ci < num_tasks; ci = next_index++)
+        task(ci);
+    });
+  }
+  for (auto& worker : workers) worker.join();
+}
+
+}  // namespace
+
+spv_result_t SpirvCompress(const spv_context_t& context, const uint32_t* words,
+                           const size_t num_words,
+                           std::vector<uint8_t>* output,
+                           spv_diagnostic* pDiagnostic, size_t num_threads) {
+  spv_context_t hijack_context = context;
+  if (pDiagnostic) {
+    *pDiagnostic = nullptr;
+    UseDiagnosticAsMessageConsumer(&hijack_context, pDiagnostic);
+  }
+  spv_position_t position = {};
+  if (!output)
+    return DiagnosticStream(position, hijack_context.consumer,
+                            SPV_ERROR_INVALID_POINTER)
+           << "Missing output vector.";
+
+  ParsedModule module;
+  if (spv_result_t error =
+          spvBinaryParse(&hijack_context, &module, words, num_words,
+                         HandleHeader, HandleInstruction, pDiagnostic))
+    return error;
+
+  const std::vector<std::pair<uint32_t, uint32_t>> hist =
+      SortedHistogram(module.opcode_hist);
+  const spvutils::HuffmanCodec<uint32_t> codec(hist);
+
+  // The prologue carries everything the chunk decoders share: the module
+  // header fields and the opcode histogram the Huffman tree is built from.
+  spvutils::BitWriterWord64 prologue(1024);
+  prologue.WriteBits(kCompressedMagic, 32);
+  prologue.WriteVariableWidthU32(kCompressedVersion, kOperandChunkLength);
+  prologue.WriteBits(module.version, 32);
+  prologue.WriteBits(module.generator, 32);
+  prologue.WriteVariableWidthU32(module.id_bound, kOperandChunkLength);
+  prologue.WriteVariableWidthU32(module.schema, kOperandChunkLength);
+  prologue.WriteVariableWidthU32(module.num_instructions,
+                                 kOperandChunkLength);
+
+  prologue.WriteVariableWidthU32(static_cast<uint32_t>(hist.size()),
+                                 kHistogramChunkLength);
+  for (const auto& entry : hist) {
+    prologue.WriteVariableWidthU32(entry.first, kHistogramChunkLength);
+    prologue.WriteVariableWidthU32(entry.second, kHistogramChunkLength);
+  }
+
+  // Carve the instruction stream into chunks of kInstructionsPerChunk.
+  // Each records its starting word and instruction count so the encoders
+  // below need no shared state.
+  struct Chunk {
+    size_t start_word;
+    uint32_t num_instructions;
+  };
+  std::vector<Chunk> chunks;
+  {
+    size_t index = 0;
+    uint32_t insts_left = module.num_instructions;
+    while (insts_left > 0) {
+      const uint32_t in_chunk = static_cast<uint32_t>(
+          std::min<size_t>(insts_left, kInstructionsPerChunk));
+      chunks.push_back({index, in_chunk});
+      for (uint32_t i = 0; i < in_chunk; ++i)
+        index += module.inst_words[index] >> 16;
+      insts_left -= in_chunk;
+    }
+  }
+
+  // Each chunk is an independent bit stream with its own delta-coding
+  // state, so the encoders run concurrently.
+  std::vector<std::vector<uint8_t>> payloads(chunks.size());
+  std::vector<const char*> errors(chunks.size(), nullptr);
+  RunChunkTasks(
+      chunks.size(), num_threads,
+      [&hijack_context, &module, &codec, &chunks, &payloads,
+       &errors](size_t ci) {
+        // A compressed instruction rarely exceeds half the size of its
+        // binary form; reserving 16 bits per binary word avoids most growth
+        // copies.
+        spvutils::BitWriterWord64 writer(kInstructionsPerChunk * 64);
+        errors[ci] = EncodeInstructions(
+            hijack_context.opcode_table, module.inst_words,
+            chunks[ci].start_word, chunks[ci].num_instructions, codec,
+            &writer);
+        if (!errors[ci]) AppendSegment(writer, &payloads[ci]);
+      });
+  for (const char* error : errors) {
+    if (error)
+      return DiagnosticStream(position, hijack_context.consumer,
+                              SPV_ERROR_INTERNAL)
+             << error;
+  }
+
+  // Assemble the stream: prologue segment, chunk payload segments, then the
+  // directory the decoder reads back from the tail.
+  std::vector<uint8_t> out;
+  AppendSegment(prologue, &out);
+  const uint32_t prologue_bytes = static_cast<uint32_t>(out.size());
+  for (const auto& payload : payloads)
+    out.insert(out.end(), payload.begin(), payload.end());
+  for (size_t ci = 0; ci < chunks.size(); ++ci) {
+    AppendU32(chunks[ci].num_instructions, &out);
+    AppendU32(static_cast<uint32_t>(payloads[ci].size()), &out);
+  }
+  AppendU32(static_cast<uint32_t>(chunks.size()), &out);
+  AppendU32(prologue_bytes, &out);
+
+  output->insert(output->end(), out.begin(), out.end());
+  return SPV_SUCCESS;
+}
+
+spv_result_t SpirvDecompress(const spv_context_t& context, const uint8_t* data,
+                             const size_t num_bytes,
+                             std::vector<uint32_t>* words,
+                             spv_diagnostic* pDiagnostic, size_t num_threads) {
+  spv_context_t hijack_context = context;
+  if (pDiagnostic) {
+    *pDiagnostic = nullptr;
+    UseDiagnosticAsMessageConsumer(&hijack_context, pDiagnostic);
+  }
+  spv_position_t position = {};
+  const auto fail = [&position,
+                     &hijack_context](const char* message) -> spv_result_t {
+    return DiagnosticStream(position, hijack_context.consumer,
+                            SPV_ERROR_INVALID_BINARY)
+           << message;
+  };
+  if (!words)
+    return DiagnosticStream(position, hijack_context.consumer,
+                            SPV_ERROR_INVALID_POINTER)
+           << "Missing output vector.";
+  if (!data || num_bytes == 0) return fail("Missing compressed data.");
+
+  spvutils::BitReaderWord64 reader(
+      std::vector<uint8_t>(data, data + num_bytes));
+
+  uint64_t magic = 0;
+  if (reader.ReadBits(&magic, 32) != 32 || magic != kCompressedMagic)
+    return fail("Invalid compressed module magic number.");
+  uint32_t format_version = 0;
+  if (!reader.ReadVariableWidthU32(&format_version, kOperandChunkLength) ||
+      (format_version != kCompressedVersion &&
+       format_version != kCompressedVersionSingleStream))
+    return fail("Unsupported compressed module version.");
+
+  // In a version 2 stream the reader above only covers the prologue; the
+  // chunk payloads behind it are decoded from their own readers, located
+  // through the directory at the tail of the stream.
+  struct Chunk {
+    size_t start_byte;
+    size_t num_payload_bytes;
+    uint32_t num_instructions;
+  };
+  std::vector<Chunk> chunks;
+  if (format_version == kCompressedVersion) {
+    if (num_bytes < 8) return fail("Compressed stream directory is missing.");
+    const uint32_t num_chunks = ReadU32(data + num_bytes - 8);
+    const uint32_t prologue_bytes = ReadU32(data + num_bytes - 4);
+    const size_t directory_bytes = 8u + 8u * size_t(num_chunks);
+    if (prologue_bytes % kSegmentAlignment != 0 ||
+        prologue_bytes < kSegmentAlignment || prologue_bytes > num_bytes ||
+        directory_bytes > num_bytes - prologue_bytes)
+      return fail("Invalid compressed stream directory.");
+
+    size_t start_byte = prologue_bytes;
+    const uint8_t* entry = data + num_bytes - directory_bytes;
+    for (uint32_t ci = 0; ci < num_chunks; ++ci, entry += 8) {
+      const uint32_t num_insts = ReadU32(entry);
+      const uint32_t payload_bytes = ReadU32(entry + 4);
+      if (payload_bytes % kSegmentAlignment != 0 ||
+          payload_bytes > num_bytes - directory_bytes - start_byte)
+        return fail("Invalid compressed chunk directory entry.");
+      chunks.push_back({start_byte, payload_bytes, num_insts});
+      start_byte += payload_bytes;
+    }
+    if (start_byte + directory_bytes != num_bytes)
+      return fail("Compressed chunk payloads do not fill the stream.");
+  }
+
+  uint64_t version = 0;
+  uint64_t generator = 0;
+  uint32_t id_bound = 0;
+  uint32_t schema = 0;
+  uint32_t num_instructions = 0;
+  if (reader.ReadBits(&version, 32) != 32 ||
+      reader.ReadBits(&generator, 32) != 32 ||
+      !reader.ReadVariableWidthU32(&id_bound, kOperandChunkLength) ||
+      !reader.ReadVariableWidthU32(&schema, kOperandChunkLength) ||
+      !reader.ReadVariableWidthU32(&num_instructions, kOperandChunkLength))
+    return fail("Unexpected end of stream in compressed module header.");
+
+  uint32_t num_hist_entries = 0;
+  if (!reader.ReadVariableWidthU32(&num_hist_entries, kHistogramChunkLength))
+    return fail("Unexpected end of stream in opcode histogram.");
+  if (num_hist_entries > 0xffff)
+    return fail("Opcode histogram has more entries than opcodes exist.");
+
+  std::vector<std::pair<uint32_t, uint32_t>> hist;
+  hist.reserve(num_hist_entries);
+  for (uint32_t i = 0; i < num_hist_entries; ++i) {
+    uint32_t opcode = 0;
+    uint32_t count = 0;
+    if (!reader.ReadVariableWidthU32(&opcode, kHistogramChunkLength) ||
+        !reader.ReadVariableWidthU32(&count, kHistogramChunkLength))
+      return fail("Unexpected end of stream in opcode histogram.");
+    if (opcode > 0xffff || count == 0 ||
+        (!hist.empty() && opcode <= hist.back().first))
+      return fail("Invalid opcode histogram entry.");
+    hist.emplace_back(opcode, count);
+  }
+  const spvutils::HuffmanCodec<uint32_t> codec(hist);
+
+  words->push_back(SpvMagicNumber);
+  words->push_back(static_cast<uint32_t>(version));
+  words->push_back(static_cast<uint32_t>(generator));
+  words->push_back(id_bound);
+  words->push_back(schema);
+
+  if (format_version == kCompressedVersionSingleStream) {
+    if (const char* error = DecodeInstructions(
+            hijack_context.opcode_table, &reader, codec, num_instructions,
+            words))
+      return fail(error);
+    if (!reader.OnlyZeroesLeft())
+      return fail("Trailing data after the last instruction.");
+    return SPV_SUCCESS;
+  }
+
+  uint64_t chunk_insts = 0;
+  for (const Chunk& chunk : chunks) chunk_insts += chunk.num_instructions;
+  if (chunk_insts != num_instructions)
+    return fail("Chunk directory disagrees with the instruction count.");
+
+  // Chunks carry independent bit streams and delta-coding state, so they
+  // decode concurrently, each into its own output run spliced in order
+  // afterwards.
+  std::vector<std::vector<uint32_t>> decoded(chunks.size());
+  std::vector<const char*> errors(chunks.size(), nullptr);
+  RunChunkTasks(chunks.size(), num_threads,
+                [&hijack_context, &codec, &chunks, &decoded, &errors,
+                 data](size_t ci) {
+                  const Chunk& chunk = chunks[ci];
+                  const uint8_t* payload = data + chunk.start_byte;
+                  spvutils::BitReaderWord64 chunk_reader(std::vector<uint8_t>(
+                      payload, payload + chunk.num_payload_bytes));
+                  errors[ci] = DecodeInstructions(
+                      hijack_context.opcode_table, &chunk_reader, codec,
+                      chunk.num_instructions, &decoded[ci]);
+                  if (!errors[ci] && !chunk_reader.OnlyZeroesLeft())
+                    errors[ci] = "Trailing data after a chunk's instructions.";
+                });
+  for (const char* error : errors) {
+    if (error) return fail(error);
+  }
+  for (const auto& run : decoded)
+    words->insert(words->end(), run.begin(), run.end());
+
+  return SPV_SUCCESS;
+}
+
+}  // namespace libspirv
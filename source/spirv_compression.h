@@ -0,0 +1,65 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_SPIRV_COMPRESSION_H_
+#define LIBSPIRV_SPIRV_COMPRESSION_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "spirv-tools/libspirv.hpp"
+
+namespace libspirv {
+
+// Compressed SPIR-V module format, version 2.
+//
+// The stream begins with a prologue segment: a format magic and version, the
+// module header fields, and the module's own opcode histogram, so the stream
+// is self-describing and the decoder rebuilds the identical Huffman code
+// tree from it.  The instructions follow in chunked framing: runs of
+// consecutive instructions are coded as independent bit-stream segments,
+// each starting on a 64-bit boundary with its own delta-coding state, and a
+// directory at the tail of the stream records every chunk's instruction
+// count and byte size.  Chunks therefore compress and decompress in
+// parallel.  Within a chunk, each instruction is stored as its Huffman-coded
+// opcode and variable-width word count, then its result type and result id
+// (when the opcode has them) as zigzag deltas against the previous
+// instruction's, and finally the remaining operand words variable-width
+// coded.  Decompression reconstructs the original binary bit for bit.
+// Version 1 streams (a single unframed segment) still decompress.
+
+// Compresses the SPIR-V module in |words| and appends the result to
+// |output|.  Returns SPV_SUCCESS on success; on failure emits a diagnostic
+// and leaves |output| in an unspecified state.  If |num_threads| is two or
+// more, chunks are encoded concurrently on worker threads.
+spv_result_t SpirvCompress(const spv_context_t& context, const uint32_t* words,
+                           const size_t num_words,
+                           std::vector<uint8_t>* output,
+                           spv_diagnostic* pDiagnostic,
+                           size_t num_threads = 1);
+
+// Decompresses a module compressed with SpirvCompress and appends the
+// reconstructed binary to |words|.  Returns SPV_SUCCESS on success; on
+// failure emits a diagnostic and leaves |words| in an unspecified state.
+// If |num_threads| is two or more, chunks are decoded concurrently on
+// worker threads.
+spv_result_t SpirvDecompress(const spv_context_t& context, const uint8_t* data,
+                             const size_t num_bytes,
+                             std::vector<uint32_t>* words,
+                             spv_diagnostic* pDiagnostic,
+                             size_t num_threads = 1);
+
+}  // namespace libspirv
+
+#endif  // LIBSPIRV_SPIRV_COMPRESSION_H_
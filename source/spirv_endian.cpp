@@ -16,6 +16,12 @@
 
 #include <cstring>
 
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 enum {
   I32_ENDIAN_LITTLE = 0x03020100ul,
   I32_ENDIAN_BIG = 0x00010203ul,
@@ -46,6 +52,41 @@ uint64_t spvFixDoubleWord(const uint32_t low, const uint32_t high,
   return (uint64_t(spvFixWord(high, endian)) << 32) | spvFixWord(low, endian);
 }
 
+void spvFixWords(const uint32_t* words, size_t num_words,
+                 const spv_endianness_t endian, uint32_t* out) {
+  if (!((SPV_ENDIANNESS_LITTLE == endian &&
+         I32_ENDIAN_HOST == I32_ENDIAN_BIG) ||
+        (SPV_ENDIANNESS_BIG == endian &&
+         I32_ENDIAN_HOST == I32_ENDIAN_LITTLE))) {
+    if (out != words) memcpy(out, words, num_words * sizeof(uint32_t));
+    return;
+  }
+
+  size_t i = 0;
+#if defined(__SSSE3__)
+  // Swap four words at a time with a byte shuffle.
+  const __m128i mask = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7,
+                                    0, 1, 2, 3);
+  for (; i + 4 <= num_words; i += 4) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_shuffle_epi8(v, mask));
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  // Swap four words at a time with a byte reversal within each word.
+  for (; i + 4 <= num_words; i += 4) {
+    vst1q_u8(reinterpret_cast<uint8_t*>(out + i),
+             vrev32q_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(words + i))));
+  }
+#endif
+  for (; i < num_words; ++i) {
+    const uint32_t word = words[i];
+    out[i] = (word & 0x000000ff) << 24 | (word & 0x0000ff00) << 8 |
+             (word & 0x00ff0000) >> 8 | (word & 0xff000000) >> 24;
+  }
+}
+
 spv_result_t spvBinaryEndianness(spv_const_binary binary,
                                  spv_endianness_t* pEndian) {
   if (!binary->code || !binary->wordCount) return SPV_ERROR_INVALID_BINARY;
@@ -25,6 +25,12 @@ uint32_t spvFixWord(const uint32_t word, const spv_endianness_t endianness);
 uint64_t spvFixDoubleWord(const uint32_t low, const uint32_t high,
                           const spv_endianness_t endianness);
 
+// Converts a sequence of num_words words in the specified endianness to the
+// host native endianness, writing the result to out.  The output may alias
+// the input.  Uses a vectorized byte shuffle where the host supports one.
+void spvFixWords(const uint32_t* words, size_t num_words,
+                 spv_endianness_t endianness, uint32_t* out);
+
 // Gets the endianness of the SPIR-V module given in the binary parameter.
 // Returns SPV_ENDIANNESS_UNKNOWN if the SPIR-V magic number is invalid,
 // otherwise writes the determined endianness into *endian.
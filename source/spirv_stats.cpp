@@ -15,6 +15,7 @@
 #include "spirv_stats.h"
 
 #include <cassert>
+#include <cstring>
 
 #include <algorithm>
 #include <memory>
@@ -29,6 +30,7 @@
 #include "opcode.h"
 #include "operand.h"
 #include "spirv-tools/libspirv.h"
+#include "spirv_constant.h"
 #include "spirv_endian.h"
 #include "spirv_validator_options.h"
 #include "validate.h"
@@ -101,11 +103,11 @@ class StatsAggregator {
     ++stats_->opcode_hist[opcode];
 
     ++inst_it;
-    auto step_it = stats_->opcode_markov_hist.begin();
+    uint32_t gap = 0;
     for (; inst_it != vstate_->ordered_instructions().rend() &&
-         step_it != stats_->opcode_markov_hist.end(); ++inst_it, ++step_it) {
-      auto& hist = (*step_it)[inst_it->opcode()];
-      ++hist[opcode];
+         gap < stats_->opcode_markov_steps; ++inst_it, ++gap) {
+      ++stats_->opcode_markov_hist[libspirv::MakeMarkovKey(
+          gap, inst_it->opcode(), opcode)];
     }
   }
 
@@ -114,9 +116,9 @@ class StatsAggregator {
     const Instruction& inst = GetCurrentInstruction();
     if (inst.opcode() != SpvOpConstant) return;
     const uint32_t type_id = inst.GetOperandAs<uint32_t>(0);
-    const auto type_decl_it = vstate_->all_definitions().find(type_id);
-    assert(type_decl_it != vstate_->all_definitions().end());
-    const Instruction& type_decl_inst = *type_decl_it->second;
+    const Instruction* type_decl = vstate_->FindDef(type_id);
+    assert(type_decl);
+    const Instruction& type_decl_inst = *type_decl;
     const SpvOp type_op = type_decl_inst.opcode();
     if (type_op == SpvOpTypeInt) {
       const uint32_t bit_width = type_decl_inst.GetOperandAs<uint32_t>(1);
@@ -184,13 +186,240 @@ spv_result_t ProcessInstruction(
   return stats_aggregator->ProcessInstruction(inst);
 }
 
+// Walks the word stream directly, updating the histograms that need only
+// the opcode and word count of each instruction plus the fixed-position
+// operands of OpCapability and OpExtension. Several times faster than a
+// full parse since no operand decoding or validation happens.
+spv_result_t AggregateStatsRawScan(const spv_context_t& context,
+                                   const uint32_t* words,
+                                   const size_t num_words,
+                                   const spv_endianness_t endian,
+                                   const spv_header_t& header,
+                                   SpirvStats* stats) {
+  ++stats->version_hist[header.version];
+  ++stats->generator_hist[header.generator];
+
+  const size_t num_markov_steps = stats->opcode_markov_steps;
+  // Opcodes of the last |num_markov_steps| instructions, most recent last.
+  std::vector<uint32_t> recent_opcodes;
+  recent_opcodes.reserve(num_markov_steps);
+
+  size_t word_index = SPV_INDEX_INSTRUCTION;
+  while (word_index < num_words) {
+    const uint32_t first_word = spvFixWord(words[word_index], endian);
+    uint16_t inst_word_count = 0;
+    uint16_t opcode = 0;
+    spvOpcodeSplit(first_word, &inst_word_count, &opcode);
+    if (inst_word_count == 0 || word_index + inst_word_count > num_words) {
+      spv_position_t position = {};
+      position.index = word_index;
+      return libspirv::DiagnosticStream(position, context.consumer,
+                                        SPV_ERROR_INVALID_BINARY)
+             << "Invalid instruction word count: " << inst_word_count;
+    }
+
+    ++stats->opcode_hist[opcode];
+    for (size_t step = 0;
+         step < num_markov_steps && step < recent_opcodes.size(); ++step) {
+      const uint32_t prev = recent_opcodes[recent_opcodes.size() - 1 - step];
+      ++stats->opcode_markov_hist[libspirv::MakeMarkovKey(uint32_t(step),
+                                                          prev, opcode)];
+    }
+    if (num_markov_steps > 0) {
+      if (recent_opcodes.size() == num_markov_steps)
+        recent_opcodes.erase(recent_opcodes.begin());
+      recent_opcodes.push_back(opcode);
+    }
+
+    if (opcode == SpvOpCapability && inst_word_count >= 2) {
+      ++stats->capability_hist[spvFixWord(words[word_index + 1], endian)];
+    } else if (opcode == SpvOpExtension && inst_word_count >= 2) {
+      // The operand is a nul-terminated literal string, one word of it
+      // holding up to four characters starting at the low byte.
+      std::string extension;
+      bool terminated = false;
+      for (uint16_t i = 1; i < inst_word_count && !terminated; ++i) {
+        const uint32_t word = spvFixWord(words[word_index + i], endian);
+        for (uint32_t shift = 0; shift < 32; shift += 8) {
+          const char c = static_cast<char>((word >> shift) & 0xff);
+          if (c == '\0') {
+            terminated = true;
+            break;
+          }
+          extension.push_back(c);
+        }
+      }
+      ++stats->extension_hist[extension];
+    }
+
+    word_index += inst_word_count;
+  }
+  return SPV_SUCCESS;
+}
+
+// Adds every count in |src| to the corresponding entry in |dst|.
+template <typename Key>
+void MergeHist(const std::unordered_map<Key, uint32_t>& src,
+               std::unordered_map<Key, uint32_t>* dst) {
+  for (const auto& pair : src) {
+    (*dst)[pair.first] += pair.second;
+  }
+}
+
+// The snapshot format: a stream of 32-bit words starting with the magic
+// number and format version, followed by every histogram in a fixed order.
+// Each histogram is its entry count followed by (key, count) records; keys
+// wider than a word take two words, low word first, and strings are emitted
+// as a word count followed by nul-terminated, zero-padded characters.
+const uint32_t kStatsMagic = 0x53565053u;  // "SPVS" as little-endian bytes.
+// Version 2 re-keyed the markov section flat on packed 64-bit keys.
+const uint32_t kStatsVersion = 2u;
+
+// Key emission for each histogram key type, as one or two words.
+void EmitKey(uint32_t key, std::vector<uint32_t>* out) { out->push_back(key); }
+void EmitKey(uint16_t key, std::vector<uint32_t>* out) { out->push_back(key); }
+void EmitKey(uint64_t key, std::vector<uint32_t>* out) {
+  out->push_back(uint32_t(key & 0xffffffffu));
+  out->push_back(uint32_t(key >> 32));
+}
+void EmitKey(int16_t key, std::vector<uint32_t>* out) {
+  EmitKey(uint16_t(key), out);
+}
+void EmitKey(int32_t key, std::vector<uint32_t>* out) {
+  EmitKey(uint32_t(key), out);
+}
+void EmitKey(int64_t key, std::vector<uint32_t>* out) {
+  EmitKey(uint64_t(key), out);
+}
+void EmitKey(float key, std::vector<uint32_t>* out) {
+  uint32_t bits;
+  std::memcpy(&bits, &key, sizeof(bits));
+  out->push_back(bits);
+}
+void EmitKey(double key, std::vector<uint32_t>* out) {
+  uint64_t bits;
+  std::memcpy(&bits, &key, sizeof(bits));
+  EmitKey(bits, out);
+}
+void EmitKey(const std::string& key, std::vector<uint32_t>* out) {
+  // Nul-terminated and zero-padded to a word boundary, like literal
+  // strings in a SPIR-V module, but preceded by the word count so a
+  // reader can bounds-check before touching the characters.
+  const uint32_t num_string_words = uint32_t(key.size() / 4 + 1);
+  out->push_back(num_string_words);
+  const size_t start = out->size();
+  out->resize(start + num_string_words, 0);
+  std::memcpy(out->data() + start, key.data(), key.size());
+}
+
+template <typename Key>
+void EmitHist(const std::unordered_map<Key, uint32_t>& hist,
+              std::vector<uint32_t>* out) {
+  out->push_back(uint32_t(hist.size()));
+  for (const auto& pair : hist) {
+    EmitKey(pair.first, out);
+    out->push_back(pair.second);
+  }
+}
+
+// A bounds-checked cursor over the words of a snapshot.
+class StatsReader {
+ public:
+  StatsReader(const uint32_t* words, size_t num_words)
+      : words_(words), num_words_(num_words) {}
+
+  bool AtEnd() const { return pos_ == num_words_; }
+
+  bool ReadWord(uint32_t* word) {
+    if (pos_ >= num_words_) return false;
+    *word = words_[pos_++];
+    return true;
+  }
+
+  bool ReadKey(uint32_t* key) { return ReadWord(key); }
+  bool ReadKey(uint16_t* key) {
+    uint32_t word;
+    if (!ReadWord(&word) || word > 0xffffu) return false;
+    *key = uint16_t(word);
+    return true;
+  }
+  bool ReadKey(uint64_t* key) {
+    uint32_t low, high;
+    if (!ReadWord(&low) || !ReadWord(&high)) return false;
+    *key = (uint64_t(high) << 32) | low;
+    return true;
+  }
+  bool ReadKey(int16_t* key) {
+    uint16_t bits;
+    if (!ReadKey(&bits)) return false;
+    *key = int16_t(bits);
+    return true;
+  }
+  bool ReadKey(int32_t* key) {
+    uint32_t bits;
+    if (!ReadWord(&bits)) return false;
+    *key = int32_t(bits);
+    return true;
+  }
+  bool ReadKey(int64_t* key) {
+    uint64_t bits;
+    if (!ReadKey(&bits)) return false;
+    *key = int64_t(bits);
+    return true;
+  }
+  bool ReadKey(float* key) {
+    uint32_t bits;
+    if (!ReadWord(&bits)) return false;
+    std::memcpy(key, &bits, sizeof(*key));
+    return true;
+  }
+  bool ReadKey(double* key) {
+    uint64_t bits;
+    if (!ReadKey(&bits)) return false;
+    std::memcpy(key, &bits, sizeof(*key));
+    return true;
+  }
+  bool ReadKey(std::string* key) {
+    uint32_t num_string_words;
+    if (!ReadWord(&num_string_words)) return false;
+    if (num_string_words == 0 || num_string_words > num_words_ - pos_)
+      return false;
+    const char* chars = reinterpret_cast<const char*>(words_ + pos_);
+    const size_t num_bytes = size_t(num_string_words) * sizeof(uint32_t);
+    // The padding guarantees a terminating nul in the last byte.
+    if (chars[num_bytes - 1] != 0) return false;
+    *key = chars;
+    pos_ += num_string_words;
+    return true;
+  }
+
+  template <typename Map>
+  bool ReadHist(Map* hist) {
+    uint32_t num_entries;
+    if (!ReadWord(&num_entries)) return false;
+    for (uint32_t i = 0; i < num_entries; ++i) {
+      typename Map::key_type key;
+      uint32_t count;
+      if (!ReadKey(&key) || !ReadWord(&count)) return false;
+      (*hist)[key] += count;
+    }
+    return true;
+  }
+
+ private:
+  const uint32_t* words_;
+  size_t num_words_;
+  size_t pos_ = 0;
+};
+
 }  // namespace
 
 namespace libspirv {
 
 spv_result_t AggregateStats(
     const spv_context_t& context, const uint32_t* words, const size_t num_words,
-    spv_diagnostic* pDiagnostic, SpirvStats* stats) {
+    spv_diagnostic* pDiagnostic, SpirvStats* stats,
+    StatsAggregationMode mode) {
   spv_const_binary_t binary = {words, num_words};
 
   spv_endianness_t endian;
@@ -208,10 +437,99 @@ spv_result_t AggregateStats(
         << "Invalid SPIR-V header.";
   }
 
+  // Pre-size the markov table: corpus runs settle on a few thousand
+  // distinct (gap, cue, later) triples per step, so reserving up front
+  // avoids rehashing the hottest container in the aggregation loop.
+  if (stats->opcode_markov_steps > 0) {
+    const size_t kMarkovTriplesPerStep = 4096;
+    const size_t want = kMarkovTriplesPerStep * stats->opcode_markov_steps;
+    if (stats->opcode_markov_hist.bucket_count() < want)
+      stats->opcode_markov_hist.reserve(want);
+  }
+
+  if (mode == StatsAggregationMode::kRawScan) {
+    return AggregateStatsRawScan(context, words, num_words, endian, header,
+                                 stats);
+  }
+
   StatsAggregator stats_aggregator(stats, &context);
 
   return spvBinaryParse(&context, &stats_aggregator, words, num_words,
                         ProcessHeader, ProcessInstruction, pDiagnostic);
 }
 
+void MergeStats(const SpirvStats& src, SpirvStats* dst) {
+  MergeHist(src.version_hist, &dst->version_hist);
+  MergeHist(src.generator_hist, &dst->generator_hist);
+  MergeHist(src.capability_hist, &dst->capability_hist);
+  MergeHist(src.extension_hist, &dst->extension_hist);
+  MergeHist(src.opcode_hist, &dst->opcode_hist);
+  MergeHist(src.u16_constant_hist, &dst->u16_constant_hist);
+  MergeHist(src.u32_constant_hist, &dst->u32_constant_hist);
+  MergeHist(src.u64_constant_hist, &dst->u64_constant_hist);
+  MergeHist(src.s16_constant_hist, &dst->s16_constant_hist);
+  MergeHist(src.s32_constant_hist, &dst->s32_constant_hist);
+  MergeHist(src.s64_constant_hist, &dst->s64_constant_hist);
+  MergeHist(src.f32_constant_hist, &dst->f32_constant_hist);
+  MergeHist(src.f64_constant_hist, &dst->f64_constant_hist);
+
+  dst->opcode_markov_steps =
+      std::max(dst->opcode_markov_steps, src.opcode_markov_steps);
+  MergeHist(src.opcode_markov_hist, &dst->opcode_markov_hist);
+}
+
+void SerializeStats(const SpirvStats& stats, std::vector<uint32_t>* out) {
+  out->push_back(kStatsMagic);
+  out->push_back(kStatsVersion);
+  EmitHist(stats.version_hist, out);
+  EmitHist(stats.generator_hist, out);
+  EmitHist(stats.capability_hist, out);
+  EmitHist(stats.extension_hist, out);
+  EmitHist(stats.opcode_hist, out);
+  EmitHist(stats.u16_constant_hist, out);
+  EmitHist(stats.u32_constant_hist, out);
+  EmitHist(stats.u64_constant_hist, out);
+  EmitHist(stats.s16_constant_hist, out);
+  EmitHist(stats.s32_constant_hist, out);
+  EmitHist(stats.s64_constant_hist, out);
+  EmitHist(stats.f32_constant_hist, out);
+  EmitHist(stats.f64_constant_hist, out);
+  out->push_back(stats.opcode_markov_steps);
+  EmitHist(stats.opcode_markov_hist, out);
+}
+
+bool DeserializeStats(const uint32_t* words, size_t num_words,
+                      SpirvStats* stats) {
+  StatsReader reader(words, num_words);
+  uint32_t magic = 0, version = 0;
+  if (!reader.ReadWord(&magic) || magic != kStatsMagic) return false;
+  if (!reader.ReadWord(&version) || version != kStatsVersion) return false;
+
+  // Parse into a scratch SpirvStats so a malformed snapshot leaves the
+  // caller's histograms untouched, then merge on success.
+  SpirvStats parsed;
+  if (!reader.ReadHist(&parsed.version_hist)) return false;
+  if (!reader.ReadHist(&parsed.generator_hist)) return false;
+  if (!reader.ReadHist(&parsed.capability_hist)) return false;
+  if (!reader.ReadHist(&parsed.extension_hist)) return false;
+  if (!reader.ReadHist(&parsed.opcode_hist)) return false;
+  if (!reader.ReadHist(&parsed.u16_constant_hist)) return false;
+  if (!reader.ReadHist(&parsed.u32_constant_hist)) return false;
+  if (!reader.ReadHist(&parsed.u64_constant_hist)) return false;
+  if (!reader.ReadHist(&parsed.s16_constant_hist)) return false;
+  if (!reader.ReadHist(&parsed.s32_constant_hist)) return false;
+  if (!reader.ReadHist(&parsed.s64_constant_hist)) return false;
+  if (!reader.ReadHist(&parsed.f32_constant_hist)) return false;
+  if (!reader.ReadHist(&parsed.f64_constant_hist)) return false;
+
+  if (!reader.ReadWord(&parsed.opcode_markov_steps)) return false;
+  if (!reader.ReadHist(&parsed.opcode_markov_hist)) return false;
+  // A snapshot is exactly one serialized SpirvStats; trailing words mean
+  // the input is not one of ours.
+  if (!reader.AtEnd()) return false;
+
+  MergeStats(parsed, stats);
+  return true;
+}
+
 }  // namespace libspirv
@@ -23,6 +23,21 @@
 
 namespace libspirv {
 
+// Packs a Markov histogram key from the gap between two instructions, the
+// cue opcode and the later opcode.  Opcodes are 16 bits in the instruction
+// encoding, so each component keeps its full range.
+inline uint64_t MakeMarkovKey(uint32_t gap, uint32_t cue, uint32_t later) {
+  return (uint64_t(gap) << 32) | (uint64_t(cue & 0xffffu) << 16) |
+         uint64_t(later & 0xffffu);
+}
+
+// Extract the components of a packed Markov key.
+inline uint32_t MarkovKeyGap(uint64_t key) { return uint32_t(key >> 32); }
+inline uint32_t MarkovKeyCue(uint64_t key) {
+  return uint32_t(key >> 16) & 0xffffu;
+}
+inline uint32_t MarkovKeyLater(uint64_t key) { return uint32_t(key) & 0xffffu; }
+
 struct SpirvStats {
   // Version histogram, version_word -> count.
   std::unordered_map<uint32_t, uint32_t> version_hist;
@@ -63,25 +78,61 @@ struct SpirvStats {
   // OpConstant f64 histogram, value -> count.
   std::unordered_map<double, uint32_t> f64_constant_hist;
 
+  // How many Markov steps (gaps between instructions) to collect.  An input
+  // parameter: set opcode_markov_steps = 1 before aggregation to collect
+  // data for one step only; 0 collects nothing.
+  uint32_t opcode_markov_steps = 0;
+
   // Used to collect statistics on opcodes triggering other opcodes.
-  // Container scheme: gap between instructions -> cue opcode -> later opcode
-  // -> count.
-  // For example opcode_markov_hist[2][OpFMul][OpFAdd] corresponds to
-  // the number of times an OpMul appears, followed by 2 other instructions,
-  // followed by OpFAdd.
-  // opcode_markov_hist[0][OpFMul][OpFAdd] corresponds to how many times
-  // OpFMul appears, directly followed by OpFAdd.
-  // The size of the outer std::vector also serves as an input parameter,
-  // determining how many steps will be collected.
-  // I.e. do opcode_markov_hist.resize(1) to collect data for one step only.
-  std::vector<std::unordered_map<uint32_t,
-      std::unordered_map<uint32_t, uint32_t>>> opcode_markov_hist;
+  // A single flat histogram keyed on the packed (gap, cue opcode, later
+  // opcode) triple, so recording a transition costs one hash lookup instead
+  // of three dependent ones through nested maps.
+  // For example opcode_markov_hist[MakeMarkovKey(2, OpFMul, OpFAdd)]
+  // corresponds to the number of times an OpFMul appears, followed by 2
+  // other instructions, followed by OpFAdd.
+  // opcode_markov_hist[MakeMarkovKey(0, OpFMul, OpFAdd)] corresponds to how
+  // many times OpFMul appears, directly followed by OpFAdd.
+  std::unordered_map<uint64_t, uint32_t> opcode_markov_hist;
+};
+
+// Selects how much work AggregateStats does per module.
+enum class StatsAggregationMode {
+  // Full parse through the generic operand machinery. Fills every histogram,
+  // and fails on binaries the validator rejects.
+  kFull,
+  // Raw scan over the word stream. The opcode and word count are in the
+  // first word of every instruction, so this fills the histograms that do
+  // not need decoded operands: version, generator, opcode, opcode markov,
+  // capability and extension. The constant literal histograms are left
+  // untouched (they need the operand types), and only the instruction
+  // framing is checked, not instruction validity.
+  kRawScan,
 };
 
 // Aggregates existing |stats| with new stats extracted from |binary|.
 spv_result_t AggregateStats(
     const spv_context_t& context, const uint32_t* words, const size_t num_words,
-    spv_diagnostic* pDiagnostic, SpirvStats* stats);
+    spv_diagnostic* pDiagnostic, SpirvStats* stats,
+    StatsAggregationMode mode = StatsAggregationMode::kFull);
+
+// Adds all counts accumulated in |src| to |dst|.  Merging per-thread stats
+// this way produces the same histograms as aggregating every module into a
+// single SpirvStats, regardless of how the modules were distributed.
+void MergeStats(const SpirvStats& src, SpirvStats* dst);
+
+// Appends a versioned binary snapshot of |stats| to |out| as a stream of
+// 32-bit words, starting with a magic number and a format version.  The
+// snapshot covers every histogram, including the markov data.  Entry order
+// within a histogram is unspecified, so two snapshots of equal stats need
+// not be byte-identical.
+void SerializeStats(const SpirvStats& stats, std::vector<uint32_t>* out);
+
+// Parses a snapshot produced by SerializeStats and adds its counts to
+// |stats|, as if the snapshot's histograms were merged with MergeStats.
+// Returns false without modifying |stats| if the words are not a well-formed
+// snapshot of a supported version.
+bool DeserializeStats(const uint32_t* words, size_t num_words,
+                      SpirvStats* stats);
 
 }  // namespace libspirv
 
@@ -75,3 +75,28 @@ void spvValidatorOptionsSetUniversalLimit(spv_validator_options options,
 #undef LIMIT
   }
 }
+
+void spvValidatorOptionsSetChecks(spv_validator_options options,
+                                  uint32_t checks) {
+  assert(options && "Validator options object may not be Null");
+  options->checks_ = checks;
+}
+
+void spvValidatorOptionsSetValidationCache(spv_validator_options options,
+                                           spv_validation_cache_t* cache) {
+  assert(options && "Validator options object may not be Null");
+  options->validation_cache_ = cache;
+}
+
+void spvValidatorOptionsSetBudget(spv_validator_options options,
+                                  const spv_validator_budget_t* budget) {
+  assert(options && "Validator options object may not be Null");
+  assert(budget && "Validator budget may not be Null");
+  options->budget_ = *budget;
+}
+
+void spvValidatorOptionsSetPipelinedChecks(spv_validator_options options,
+                                           bool pipelined) {
+  assert(options && "Validator options object may not be Null");
+  options->pipelined_checks_ = pipelined;
+}
@@ -38,9 +38,19 @@ struct validator_universal_limits_t {
 // members may be added for any new option.
 struct spv_validator_options_t {
   spv_validator_options_t()
-      : universal_limits_() {}
+      : universal_limits_(),
+        validation_cache_(nullptr),
+        checks_(SPV_VALIDATOR_CHECK_ALL),
+        budget_(),
+        pipelined_checks_(false) {}
 
   validator_universal_limits_t universal_limits_;
+  spv_validation_cache_t* validation_cache_;
+  uint32_t checks_;
+  // Work budget; all-zero (the default) means unlimited.
+  spv_validator_budget_t budget_;
+  // Run the per-instruction checks on a worker thread fed by the decoder.
+  bool pipelined_checks_;
 };
 
 #endif  // LIBSPIRV_SPIRV_VALIDATOR_OPTIONS_H_
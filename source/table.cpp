@@ -43,11 +43,21 @@ spv_context spvContextCreate(spv_target_env env) {
   spvExtInstTableGet(&ext_inst_table, env);
 
   return new spv_context_t{env, opcode_table, operand_table, ext_inst_table,
-                           nullptr /* a null default consumer */};
+                           nullptr /* a null default consumer */,
+                           {nullptr, nullptr, nullptr} /* the global heap */};
 }
 
 void spvContextDestroy(spv_context context) { delete context; }
 
+void spvContextSetAllocator(spv_context context,
+                            const spv_allocator_t* allocator) {
+  if (allocator) {
+    context->allocator = *allocator;
+  } else {
+    context->allocator = {nullptr, nullptr, nullptr};
+  }
+}
+
 void SetContextMessageConsumer(spv_context context,
                                spvtools::MessageConsumer consumer) {
   context->consumer = std::move(consumer);
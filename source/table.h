@@ -21,6 +21,15 @@
 #include "message.h"
 #include "spirv-tools/libspirv.hpp"
 
+// Bits identifying the grammar versions an entry of the unified opcode
+// table belongs to.  See spv_opcode_desc_t::versions and
+// spv_opcode_table_t::version.
+enum spv_opcode_version_bit_t {
+  SPV_OPCODE_VERSION_BIT_1_0 = 1 << 0,
+  SPV_OPCODE_VERSION_BIT_1_1 = 1 << 1,
+  SPV_OPCODE_VERSION_BIT_1_2 = 1 << 2,
+};
+
 typedef struct spv_opcode_desc_t {
   const char* name;
   const SpvOp opcode;
@@ -32,6 +41,10 @@ typedef struct spv_opcode_desc_t {
   spv_operand_type_t operandTypes[16];  // TODO: Smaller/larger?
   const bool hasResult;  // Does the instruction have a result ID operand?
   const bool hasType;    // Does the instruction have a type ID operand?
+  // Bitmask of the grammar versions that define this entry, so all versions
+  // can share one immutable table.  An instruction whose description changed
+  // between versions has one entry per distinct description.
+  const uint32_t versions;
 } spv_opcode_desc_t;
 
 typedef struct spv_operand_desc_t {
@@ -68,6 +81,10 @@ typedef struct spv_ext_inst_group_t {
 typedef struct spv_opcode_table_t {
   const uint32_t count;
   const spv_opcode_desc_t* entries;
+  // The single version bit selecting this table's entries out of the shared
+  // unified entry array; lookups skip entries whose versions mask does not
+  // include it.
+  const uint32_t version;
 } spv_opcode_table_t;
 
 typedef struct spv_operand_table_t {
@@ -88,12 +105,22 @@ typedef const spv_opcode_table_t* spv_opcode_table;
 typedef const spv_operand_table_t* spv_operand_table;
 typedef const spv_ext_inst_table_t* spv_ext_inst_table;
 
+// A context is a cheap, trivially copyable view of the statically allocated
+// grammar tables above, which are immutable and shared by every context for
+// the same target environment.  The message consumer is the only mutable
+// member: concurrent use of a single context is safe as long as the consumer
+// is not replaced or invoked from more than one thread at a time.  The API
+// entry points that report through a spv_diagnostic redirect messages via a
+// local copy of the context, so they never touch the shared consumer.
 struct spv_context_t {
   const spv_target_env target_env;
   const spv_opcode_table opcode_table;
   const spv_operand_table operand_table;
   const spv_ext_inst_table ext_inst_table;
   spvtools::MessageConsumer consumer;
+  // The caller-supplied memory allocator, or all-zero for the global heap.
+  // See spvContextSetAllocator.
+  spv_allocator_t allocator;
 };
 
 // Sets the message consumer to |consumer| in the given |context|. The original
@@ -26,8 +26,10 @@
 #include <unordered_map>
 #include <vector>
 
+#include "allocator.h"
 #include "assembly_grammar.h"
 #include "binary.h"
+#include "call_trace.h"
 #include "diagnostic.h"
 #include "ext_inst.h"
 #include "instruction.h"
@@ -102,16 +104,30 @@ spv_result_t spvTextToLiteral(const char* textValue, spv_literal_t* pLiteral) {
   if (isString || numPeriods > 1 || (isSigned && len == 1)) {
     if (len < 2 || textValue[0] != '"' || textValue[len - 1] != '"')
       return SPV_FAILED_MATCH;
-    bool escaping = false;
-    for (const char* val = textValue + 1; val != textValue + len - 1; ++val) {
-      if ((*val == '\\') && (!escaping)) {
-        escaping = true;
-      } else {
-        // Have to save space for the null-terminator
-        if (pLiteral->str.size() >= SPV_LIMIT_LITERAL_STRING_BYTES_MAX)
-          return SPV_ERROR_OUT_OF_MEMORY;
-        pLiteral->str.push_back(*val);
-        escaping = false;
+    // Copy the contents in runs delimited by backslash escapes rather than
+    // byte at a time.  A backslash drops out and the character after it is
+    // taken literally; a trailing lone backslash is dropped.
+    const char* val = textValue + 1;
+    const char* const end = textValue + len - 1;
+    pLiteral->str.reserve(static_cast<size_t>(end - val));
+    while (val != end) {
+      const char* backslash =
+          static_cast<const char*>(memchr(val, '\\', end - val));
+      const char* run_end = backslash ? backslash : end;
+      // Have to save space for the null-terminator.
+      if (pLiteral->str.size() + (run_end - val) >
+          SPV_LIMIT_LITERAL_STRING_BYTES_MAX)
+        return SPV_ERROR_OUT_OF_MEMORY;
+      pLiteral->str.append(val, run_end);
+      val = run_end;
+      if (backslash) {
+        ++val;  // Skip the backslash.
+        if (val != end) {
+          if (pLiteral->str.size() >= SPV_LIMIT_LITERAL_STRING_BYTES_MAX)
+            return SPV_ERROR_OUT_OF_MEMORY;
+          pLiteral->str.push_back(*val);
+          ++val;
+        }
       }
     }
 
@@ -161,7 +177,7 @@ spv_result_t encodeImmediate(libspirv::AssemblyContext* context,
                              const char* text, spv_instruction_t* pInst) {
   assert(*text == '!');
   uint32_t parse_result;
-  if (!spvutils::ParseNumber(text + 1, &parse_result)) {
+  if (!spvutils::ParseNumberFast(text + 1, &parse_result)) {
     return context->diagnostic(SPV_ERROR_INVALID_TEXT)
            << "Invalid immediate integer: !" << text + 1;
   }
@@ -222,6 +238,12 @@ spv_result_t spvTextEncodeOperand(const libspirv::AssemblyGrammar& grammar,
       const uint32_t id = context->spvNamedIdAssignOrGet(textValue);
       if (type == SPV_OPERAND_TYPE_TYPE_ID) pInst->resultTypeId = id;
       spvInstructionAddWord(pInst, id);
+      // The result id is not reported to the sink: the memo cache derives
+      // its word index from the opcode's layout instead.
+      if (context->id_position_sink() && type != SPV_OPERAND_TYPE_RESULT_ID) {
+        context->id_position_sink()->push_back(
+            static_cast<uint32_t>(pInst->words.size() - 1));
+      }
 
       // Set the extended instruction type.
       // The import set id is the 3rd operand of OpExtInst.
@@ -444,13 +466,14 @@ spv_result_t encodeInstructionStartingWithImmediate(
   if ((error = encodeImmediate(context, firstWord.c_str(), pInst))) {
     return error;
   }
+  // Reused across iterations so its capacity is only allocated once.
+  std::string operandValue;
   while (context->advance() != SPV_END_OF_STREAM) {
     // A beginning of a new instruction means we're done.
     if (context->isStartOfNewInst()) return SPV_SUCCESS;
 
     // Otherwise, there must be an operand that's either a literal, an ID, or
     // an immediate.
-    std::string operandValue;
     if ((error = context->getWord(&operandValue, &nextPosition)))
       return context->diagnostic(error) << "Internal Error";
 
@@ -557,6 +580,8 @@ spv_result_t spvTextEncodeOpcode(const libspirv::AssemblyGrammar& grammar,
       opcodeEntry->operandTypes,
       opcodeEntry->operandTypes + opcodeEntry->numTypes);
 
+  // Reused across iterations so its capacity is only allocated once.
+  std::string operandValue;
   while (!expectedOperands.empty()) {
     const spv_operand_type_t type = expectedOperands.front();
     expectedOperands.pop_front();
@@ -600,7 +625,6 @@ spv_result_t spvTextEncodeOpcode(const libspirv::AssemblyGrammar& grammar,
         }
       }
 
-      std::string operandValue;
       error = context->getWord(&operandValue, &nextPosition);
       if (error) return context->diagnostic(error) << "Internal Error";
 
@@ -641,6 +665,209 @@ spv_result_t spvTextEncodeOpcode(const libspirv::AssemblyGrammar& grammar,
   return SPV_SUCCESS;
 }
 
+// Returns true if instructions with this opcode may be memoized by
+// InstructionMemoCache: their encoding must depend only on the token shape,
+// and assembling them must have no side effects beyond id assignment and
+// the value-type record.
+bool opcodeIsMemoizable(SpvOp opcode) {
+  // Type-generating instructions feed recordTypeDefinition().
+  if (spvOpcodeGeneratesType(opcode)) return false;
+  switch (opcode) {
+    case SpvOpConstant:
+    case SpvOpSpecConstant:
+    case SpvOpSpecConstantOp:
+    case SpvOpSwitch:
+      // Typed literal operands: the encoded width depends on a type looked
+      // up at encode time, not on the token shape alone.
+      return false;
+    case SpvOpExtInst:
+    case SpvOpExtInstImport:
+      // Extended-instruction bookkeeping beyond plain id assignment.
+      return false;
+    default:
+      return true;
+  }
+}
+
+// Memoizes the encoded form of instructions across structurally identical
+// assembly lines.  Generated assembly repeats the same shapes thousands of
+// times -- OpDecorate/OpMemberDecorate/OpName lines differing only in an id
+// or literal -- so most lines reduce to a hash probe plus stamping resolved
+// ids into a cached word template, instead of grammar-driven encoding.
+//
+// The cache key is the line's token sequence with every id token replaced
+// by a placeholder; the template records the word index of each id slot.
+// Only opcodes accepted by opcodeIsMemoizable() participate, which keeps a
+// template's words a pure function of its key.
+class InstructionMemoCache {
+ public:
+  // Attempts to encode the instruction at |context|'s cursor from a cached
+  // template.  On a hit fills |*pInst|, advances the cursor past the
+  // instruction, and returns SPV_SUCCESS.  Returns SPV_FAILED_MATCH when
+  // the line must take the grammar-driven path, leaving the cursor
+  // untouched and arming the capture that Remember() completes.  Any other
+  // status is an error already reported through the context's diagnostic.
+  spv_result_t TryEncode(const libspirv::AssemblyGrammar& grammar,
+                         libspirv::AssemblyContext* context,
+                         spv_instruction_t* pInst) {
+    armed_ = false;
+    context->SetIdPositionSink(nullptr);
+
+    // Scan the line's tokens without consuming them; the probe must not
+    // disturb the context's cursor (or its token pipeline) while the
+    // grammar-driven path may still be taken.
+    spv_position_t pos = context->position();
+    std::string token;
+    std::string opcode_name;
+    std::vector<std::string> id_tokens;
+    bool has_result = false;
+
+    if (context->getWordAt(&token, &pos)) return SPV_FAILED_MATCH;
+    if (token.empty() || '!' == token[0]) return SPV_FAILED_MATCH;
+    if ('%' == token[0]) {
+      has_result = true;
+      id_tokens.push_back(token);
+      if (context->advanceAt(&pos)) return SPV_FAILED_MATCH;
+      if (context->getWordAt(&token, &pos) || "=" != token)
+        return SPV_FAILED_MATCH;
+      if (context->advanceAt(&pos)) return SPV_FAILED_MATCH;
+      if (context->getWordAt(&opcode_name, &pos)) return SPV_FAILED_MATCH;
+    } else {
+      opcode_name = token;
+    }
+    if (opcode_name.size() <= 2 || 'O' != opcode_name[0] ||
+        'p' != opcode_name[1])
+      return SPV_FAILED_MATCH;
+
+    spv_opcode_desc entry = nullptr;
+    if (grammar.lookupOpcode(opcode_name.c_str() + 2, &entry))
+      return SPV_FAILED_MATCH;
+    if (!opcodeIsMemoizable(static_cast<SpvOp>(entry->opcode)))
+      return SPV_FAILED_MATCH;
+    if (has_result != (entry->hasResult != 0)) return SPV_FAILED_MATCH;
+
+    std::string key(has_result ? "%=" : "=");
+    key += opcode_name;
+    while (true) {
+      if (context->advanceAt(&pos)) break;          // End of stream.
+      if (context->isStartOfNewInstAt(pos)) break;  // The next line begins.
+      if (context->getWordAt(&token, &pos)) return SPV_FAILED_MATCH;
+      if (token.empty() || '!' == token[0] || "=" == token)
+        return SPV_FAILED_MATCH;
+      key.push_back('\0');  // Tokens never contain a NUL byte.
+      if ('%' == token[0]) {
+        id_tokens.push_back(token);
+        key.push_back('%');
+      } else {
+        key += token;
+      }
+    }
+
+    const auto it = templates_.find(key);
+    if (it == templates_.end()) {
+      // Miss: arm the capture so Remember() can build the template once the
+      // grammar-driven path has encoded the line.
+      armed_ = true;
+      key_.swap(key);
+      end_index_ = pos.index;
+      has_result_ = has_result;
+      record_value_type_ = entry->hasType != 0;
+      opcode_ = static_cast<SpvOp>(entry->opcode);
+      num_id_tokens_ = id_tokens.size();
+      captured_positions_.clear();
+      context->SetIdPositionSink(&captured_positions_);
+      return SPV_FAILED_MATCH;
+    }
+
+    const Template& tmpl = it->second;
+    if (id_tokens.size() !=
+        tmpl.id_positions.size() + (has_result ? 1u : 0u))
+      return SPV_FAILED_MATCH;
+
+    pInst->opcode = tmpl.opcode;
+    pInst->words = tmpl.words;
+    // Stamp the ids in ascending word order: the order the grammar-driven
+    // path resolves them in, so fresh names are assigned the same numbers.
+    size_t next_stream = 0;
+    bool result_done = !has_result;
+    while (!result_done || next_stream < tmpl.id_positions.size()) {
+      const bool take_result =
+          !result_done && (next_stream >= tmpl.id_positions.size() ||
+                           tmpl.result_position <
+                               tmpl.id_positions[next_stream]);
+      const std::string& id_token =
+          take_result ? id_tokens[0]
+                      : id_tokens[(has_result ? 1 : 0) + next_stream];
+      const char* name = id_token.c_str() + 1;
+      if (!spvIsValidID(name))
+        return context->diagnostic() << "Invalid ID " << name;
+      const uint32_t word_index = take_result
+                                      ? tmpl.result_position
+                                      : tmpl.id_positions[next_stream];
+      pInst->words[word_index] = context->spvNamedIdAssignOrGet(name);
+      if (take_result)
+        result_done = true;
+      else
+        ++next_stream;
+    }
+    if (tmpl.record_value_type)
+      context->recordTypeIdForValue(pInst->words[2], pInst->words[1]);
+
+    context->setPosition(pos);
+    return SPV_SUCCESS;
+  }
+
+  // Stores the template for the line TryEncode() last missed on, now that
+  // the grammar-driven path has encoded it into |inst|.  A line that did
+  // not consume exactly the probed tokens -- an optional operand bailed out
+  // early -- is not cached.
+  void Remember(libspirv::AssemblyContext* context,
+                const spv_instruction_t& inst) {
+    context->SetIdPositionSink(nullptr);
+    if (!armed_) return;
+    armed_ = false;
+    if (context->position().index != end_index_) return;
+    if (inst.opcode != opcode_) return;
+    if (captured_positions_.size() + (has_result_ ? 1u : 0u) !=
+        num_id_tokens_)
+      return;
+
+    Template tmpl;
+    tmpl.opcode = opcode_;
+    tmpl.words = inst.words;
+    tmpl.id_positions = captured_positions_;
+    // Per the SPIR-V layout the result id follows the type id, if any.
+    tmpl.result_position = has_result_ ? (record_value_type_ ? 2u : 1u) : 0u;
+    tmpl.record_value_type = record_value_type_;
+    templates_.emplace(std::move(key_), std::move(tmpl));
+  }
+
+ private:
+  struct Template {
+    SpvOp opcode;
+    // The encoded words; the id slots hold the ids of the line the
+    // template was built from and are overwritten on every hit.
+    std::vector<uint32_t> words;
+    // Word index of each id operand taken from the text stream, in token
+    // order.
+    std::vector<uint32_t> id_positions;
+    uint32_t result_position;  // Word index of the result id, 0 if none.
+    bool record_value_type;    // Whether the opcode has a result type.
+  };
+
+  std::unordered_map<std::string, Template> templates_;
+
+  // The pending capture from the last miss.
+  bool armed_ = false;
+  std::string key_;
+  size_t end_index_ = 0;
+  bool has_result_ = false;
+  bool record_value_type_ = false;
+  SpvOp opcode_ = SpvOpNop;
+  size_t num_id_tokens_ = 0;
+  std::vector<uint32_t> captured_positions_;
+};
+
 enum { kAssemblerVersion = 0 };
 
 // Populates a binary stream's |header|. The target environment is specified via
@@ -676,8 +903,14 @@ spv_result_t GetNumericIds(const libspirv::AssemblyGrammar& grammar,
   // Skip past whitespace and comments.
   context.advance();
 
+  // Reused across iterations so its words vector's capacity is only
+  // allocated once.
+  spv_instruction_t inst;
   while (context.hasText()) {
-    spv_instruction_t inst;
+    inst.opcode = SpvOpNop;
+    inst.extInstType = SPV_EXT_INST_TYPE_NONE;
+    inst.resultTypeId = 0;
+    inst.words.clear();
 
     if (spvTextEncodeOpcode(grammar, &context, &inst)) {
       return SPV_ERROR_INVALID_TEXT;
@@ -690,13 +923,32 @@ spv_result_t GetNumericIds(const libspirv::AssemblyGrammar& grammar,
   return SPV_SUCCESS;
 }
 
-// Translates a given assembly language module into binary form.
-// If a diagnostic is generated, it is not yet marked as being
+// Returns an estimate of the number of words the assembled form of the
+// given text will occupy, including the header.  One word per
+// whitespace-separated token is a good proxy: most tokens encode to exactly
+// one word, and the tokens that encode to none ('=' signs, comments) make
+// up for the few that encode to more (64-bit literals, strings).
+size_t EstimateModuleWordCount(const spv_text text) {
+  size_t num_tokens = 0;
+  bool in_token = false;
+  for (size_t i = 0; i < text->length; i++) {
+    const bool is_space =
+        0 != std::isspace(static_cast<unsigned char>(text->str[i]));
+    if (!is_space && !in_token) num_tokens++;
+    in_token = !is_space;
+  }
+  return SPV_INDEX_INSTRUCTION + num_tokens;
+}
+
+// Translates a given assembly language module into binary form, emitting
+// the encoded words through |sink|.  On success *pWordCount holds the
+// number of words written; the sink's buffer may have been grown beyond
+// that.  If a diagnostic is generated, it is not yet marked as being
 // for a text-based input.
-spv_result_t spvTextToBinaryInternal(
+spv_result_t spvTextToBinaryToSinkInternal(
     const libspirv::AssemblyGrammar& grammar,
     const spvtools::MessageConsumer& consumer, const spv_text text,
-    const uint32_t options, spv_binary* pBinary) {
+    const uint32_t options, spv_word_sink_t* sink, size_t* pWordCount) {
   // The ids in this set will have the same values both in source and binary.
   // All other ids will be generated by filling in the gaps.
   std::set<uint32_t> ids_to_preserve;
@@ -715,40 +967,139 @@ spv_result_t spvTextToBinaryInternal(
   if (!grammar.isValid()) {
     return SPV_ERROR_INVALID_TABLE;
   }
-  if (!pBinary) return SPV_ERROR_INVALID_POINTER;
+  if (!sink || !sink->grow || !pWordCount) return SPV_ERROR_INVALID_POINTER;
+
+  // Scan token boundaries on a second thread, overlapped with encoding on
+  // this one.  Below this input size the thread startup costs more than the
+  // scan itself, so small modules stay single-threaded.
+  const size_t kTokenPipelineThreshold = 64 * 1024;  // bytes
+  std::unique_ptr<libspirv::TokenPipeline> token_pipeline;
+  if (text->length >= kTokenPipelineThreshold) {
+    token_pipeline.reset(new libspirv::TokenPipeline(text));
+    context.SetTokenPipeline(token_pipeline.get());
+  }
 
-  std::vector<spv_instruction_t> instructions;
+  // Encode instructions directly into the output buffer, pre-sized from a
+  // cheap token-count estimate, rather than accumulating a word vector per
+  // instruction and coalescing them at the end.  The estimate keeps large
+  // modules from paying repeated growth copies, and the peak memory use
+  // stays near the size of the output.
+  size_t capacity = EstimateModuleWordCount(text);
+  uint32_t* data = sink->grow(sink->user_data, capacity);
+  if (!data) return SPV_ERROR_OUT_OF_MEMORY;
+  size_t totalSize = SPV_INDEX_INSTRUCTION;
 
   // Skip past whitespace and comments.
   context.advance();
 
-  while (context.hasText()) {
-    instructions.push_back({});
-    spv_instruction_t& inst = instructions.back();
+  // Structurally identical lines hit a template cache and skip the
+  // grammar-driven encoder; see InstructionMemoCache.
+  InstructionMemoCache memo;
 
-    if (spvTextEncodeOpcode(grammar, &context, &inst)) {
+  // Reused across iterations so its words vector's capacity is only
+  // allocated once.
+  spv_instruction_t inst;
+  while (context.hasText()) {
+    inst.opcode = SpvOpNop;
+    inst.extInstType = SPV_EXT_INST_TYPE_NONE;
+    inst.resultTypeId = 0;
+    inst.words.clear();
+
+    const spv_result_t memo_result = memo.TryEncode(grammar, &context, &inst);
+    if (memo_result == SPV_FAILED_MATCH) {
+      if (spvTextEncodeOpcode(grammar, &context, &inst)) {
+        return SPV_ERROR_INVALID_TEXT;
+      }
+      memo.Remember(&context, inst);
+    } else if (memo_result != SPV_SUCCESS) {
       return SPV_ERROR_INVALID_TEXT;
     }
 
+    if (totalSize + inst.words.size() > capacity) {
+      // The estimate fell short; double the buffer.
+      capacity = std::max(capacity * 2, totalSize + inst.words.size());
+      data = sink->grow(sink->user_data, capacity);
+      if (!data) return SPV_ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(data + totalSize, inst.words.data(),
+           sizeof(uint32_t) * inst.words.size());
+    totalSize += inst.words.size();
+
     if (context.advance()) break;
   }
 
-  size_t totalSize = SPV_INDEX_INSTRUCTION;
-  for (auto& inst : instructions) {
-    totalSize += inst.words.size();
+  if (auto error = SetHeader(grammar.target_env(), context.getBound(), data)) {
+    return error;
   }
 
-  uint32_t* data = new uint32_t[totalSize];
-  if (!data) return SPV_ERROR_OUT_OF_MEMORY;
-  uint64_t currentIndex = SPV_INDEX_INSTRUCTION;
-  for (auto& inst : instructions) {
-    memcpy(data + currentIndex, inst.words.data(),
-           sizeof(uint32_t) * inst.words.size());
-    currentIndex += inst.words.size();
+  *pWordCount = totalSize;
+  return SPV_SUCCESS;
+}
+
+// A heap-backed buffer satisfying the assembler's word sink interface; used
+// by the paths that return a freshly allocated spv_binary.
+struct HeapWordBuffer {
+  uint32_t* data = nullptr;
+  size_t capacity = 0;
+};
+
+// Grow callback for HeapWordBuffer.
+uint32_t* GrowHeapWordBuffer(void* user_data, size_t word_count) {
+  HeapWordBuffer* buffer = static_cast<HeapWordBuffer*>(user_data);
+  if (word_count <= buffer->capacity) return buffer->data;
+  uint32_t* bigger = new uint32_t[word_count];
+  if (buffer->data) {
+    memcpy(bigger, buffer->data, sizeof(uint32_t) * buffer->capacity);
+    delete[] buffer->data;
   }
+  buffer->data = bigger;
+  buffer->capacity = word_count;
+  return bigger;
+}
 
-  if (auto error = SetHeader(grammar.target_env(), context.getBound(), data))
-    return error;
+// Translates a given assembly language module into binary form.
+// If a diagnostic is generated, it is not yet marked as being
+// for a text-based input.
+spv_result_t spvTextToBinaryInternal(
+    const libspirv::AssemblyGrammar& grammar,
+    const spvtools::MessageConsumer& consumer, const spv_text text,
+    const uint32_t options, const spv_allocator_t& allocator,
+    spv_binary* pBinary) {
+  if (!pBinary) return SPV_ERROR_INVALID_POINTER;
+
+  HeapWordBuffer buffer;
+  spv_word_sink_t sink = {&buffer, GrowHeapWordBuffer};
+  size_t totalSize = 0;
+  const spv_result_t result = spvTextToBinaryToSinkInternal(
+      grammar, consumer, text, options, &sink, &totalSize);
+  if (result != SPV_SUCCESS) {
+    delete[] buffer.data;
+    return result;
+  }
+
+  if (spvtools::AllocatorIsSet(allocator)) {
+    // The words accumulated in a transient heap buffer; only the result
+    // itself comes from the caller's pool.
+    spv_binary pooled = spvtools::AllocateBinary(allocator, totalSize);
+    if (!pooled) {
+      delete[] buffer.data;
+      return SPV_ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(pooled->code, buffer.data, sizeof(uint32_t) * totalSize);
+    delete[] buffer.data;
+    *pBinary = pooled;
+    return SPV_SUCCESS;
+  }
+
+  uint32_t* data = buffer.data;
+  if (buffer.capacity > totalSize + totalSize / 4) {
+    // The estimate overshot by a lot, e.g. for heavily commented text.
+    // Don't make the returned binary carry the slack.
+    uint32_t* exact = new uint32_t[totalSize];
+    memcpy(exact, data, sizeof(uint32_t) * totalSize);
+    delete[] data;
+    data = exact;
+  }
 
   spv_binary binary = new spv_binary_t();
   if (!binary) {
@@ -763,8 +1114,41 @@ spv_result_t spvTextToBinaryInternal(
   return SPV_SUCCESS;
 }
 
+// Translates the given text with the given context, routing any diagnostic
+// through |pDiagnostic| if it is non-null.  |token_cache| may be null; when
+// set, name lookups go through the session's memo cache.
+spv_result_t TextToBinaryImpl(const spv_const_context context,
+                              libspirv::AssemblerTokenCache* token_cache,
+                              const char* input_text,
+                              const size_t input_text_size,
+                              const uint32_t options, spv_binary* pBinary,
+                              spv_diagnostic* pDiagnostic) {
+  spv_context_t hijack_context = *context;
+  if (pDiagnostic) {
+    *pDiagnostic = nullptr;
+    libspirv::UseDiagnosticAsMessageConsumer(&hijack_context, pDiagnostic);
+  }
+
+  spv_text_t text = {input_text, input_text_size, {}};
+  libspirv::AssemblyGrammar grammar(&hijack_context, token_cache);
+
+  spv_result_t result =
+      spvTextToBinaryInternal(grammar, hijack_context.consumer, &text, options,
+                              hijack_context.allocator, pBinary);
+  if (pDiagnostic && *pDiagnostic) (*pDiagnostic)->isTextSource = true;
+
+  return result;
+}
+
 }  // anonymous namespace
 
+// An assembler session: a context to assemble against plus the token lookup
+// memo retained across calls.  See spvAssemblerCreate in libspirv.h.
+struct spv_assembler_t {
+  spv_const_context context;
+  libspirv::AssemblerTokenCache token_cache;
+};
+
 spv_result_t spvTextToBinary(const spv_const_context context,
                              const char* input_text,
                              const size_t input_text_size, spv_binary* pBinary,
@@ -778,24 +1162,65 @@ spv_result_t spvTextToBinaryWithOptions(
     const spv_const_context context, const char* input_text,
     const size_t input_text_size, const uint32_t options, spv_binary* pBinary,
     spv_diagnostic* pDiagnostic) {
+  libspirv::CallTraceTextToBinary(context->target_env, input_text,
+                                  input_text_size, options);
+  return TextToBinaryImpl(context, nullptr, input_text, input_text_size,
+                          options, pBinary, pDiagnostic);
+}
+
+spv_result_t spvTextToBinaryToSink(const spv_const_context context,
+                                   const char* input_text,
+                                   const size_t input_text_size,
+                                   const uint32_t options,
+                                   spv_word_sink_t* sink, size_t* word_count,
+                                   spv_diagnostic* pDiagnostic) {
   spv_context_t hijack_context = *context;
   if (pDiagnostic) {
     *pDiagnostic = nullptr;
     libspirv::UseDiagnosticAsMessageConsumer(&hijack_context, pDiagnostic);
   }
 
-  spv_text_t text = {input_text, input_text_size};
-  libspirv::AssemblyGrammar grammar(&hijack_context);
+  spv_text_t text = {input_text, input_text_size, {}};
+  libspirv::AssemblyGrammar grammar(&hijack_context, nullptr);
 
-  spv_result_t result = spvTextToBinaryInternal(
-      grammar, hijack_context.consumer, &text, options, pBinary);
+  spv_result_t result = spvTextToBinaryToSinkInternal(
+      grammar, hijack_context.consumer, &text, options, sink, word_count);
   if (pDiagnostic && *pDiagnostic) (*pDiagnostic)->isTextSource = true;
 
   return result;
 }
 
+spv_assembler spvAssemblerCreate(const spv_const_context context) {
+  if (!context) return nullptr;
+  spv_assembler assembler = new spv_assembler_t();
+  assembler->context = context;
+  return assembler;
+}
+
+void spvAssemblerDestroy(spv_assembler assembler) { delete assembler; }
+
+spv_result_t spvAssemblerTextToBinary(spv_assembler assembler,
+                                      const char* input_text,
+                                      const size_t input_text_size,
+                                      const uint32_t options,
+                                      spv_binary* pBinary,
+                                      spv_diagnostic* pDiagnostic) {
+  if (!assembler) return SPV_ERROR_INVALID_POINTER;
+  return TextToBinaryImpl(assembler->context, &assembler->token_cache,
+                          input_text, input_text_size, options, pBinary,
+                          pDiagnostic);
+}
+
 void spvTextDestroy(spv_text text) {
   if (!text) return;
+  if (spvtools::AllocatorIsSet(text->allocator)) {
+    // Copy the allocator out before releasing the object that holds it.
+    const spv_allocator_t allocator = text->allocator;
+    spvtools::AllocatorFree(allocator, const_cast<char*>(text->str),
+                            text->length + 1);
+    spvtools::AllocatorFree(allocator, text, sizeof(spv_text_t));
+    return;
+  }
   delete[] text->str;
   delete text;
 }
@@ -20,6 +20,10 @@
 #include <cstring>
 #include <tuple>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "assembly_grammar.h"
 #include "binary.h"
 #include "ext_inst.h"
@@ -32,79 +36,122 @@
 
 namespace {
 // Advances |text| to the start of the next line and writes the new position to
-// |position|.
+// |position|.  The skipped characters cannot affect the scanner state, so the
+// newline search is delegated to memchr rather than stepping byte by byte.
+//
+// The scanners in this file maintain only the byte index of the position;
+// line and column are recovered on demand when a diagnostic is emitted.  See
+// AssemblyContext::positionForDiagnostic().
 spv_result_t advanceLine(spv_text text, spv_position position) {
+  if (position->index >= text->length) return SPV_END_OF_STREAM;
+  const char* start = text->str + position->index;
+  const size_t remaining = text->length - position->index;
+  const char* newline =
+      static_cast<const char*>(memchr(start, '\n', remaining));
+  const size_t searched = newline ? size_t(newline - start) : remaining;
+  const char* terminator = static_cast<const char*>(memchr(start, '\0', searched));
+  if (terminator) {
+    position->index += terminator - start;
+    return SPV_END_OF_STREAM;
+  }
+  if (!newline) {
+    position->index += remaining;
+    return SPV_END_OF_STREAM;
+  }
+  position->index += (newline - start) + 1;
+  return SPV_SUCCESS;
+}
+
+// Advances |text| to first non white space character and writes the new
+// position to |position|.
+// If a null terminator is found during the text advance, SPV_END_OF_STREAM is
+// returned, SPV_SUCCESS otherwise. No error checking is performed on the
+// parameters, its the users responsibility to ensure these are non null.
+spv_result_t advance(spv_text text, spv_position position) {
+  // NOTE: Consume white space, otherwise don't advance.
   while (true) {
     if (position->index >= text->length) return SPV_END_OF_STREAM;
     switch (text->str[position->index]) {
       case '\0':
         return SPV_END_OF_STREAM;
+      case ';':
+        if (spv_result_t error = advanceLine(text, position)) return error;
+        break;
+      case ' ':
+      case '\t':
+      case '\r':
       case '\n':
-        position->column = 0;
-        position->line++;
-        position->index++;
-        return SPV_SUCCESS;
-      default:
-        position->column++;
         position->index++;
         break;
+      default:
+        return SPV_SUCCESS;
     }
   }
 }
 
-// Advances |text| to first non white space character and writes the new
-// position to |position|.
-// If a null terminator is found during the text advance, SPV_END_OF_STREAM is
-// returned, SPV_SUCCESS otherwise. No error checking is performed on the
-// parameters, its the users responsibility to ensure these are non null.
-spv_result_t advance(spv_text text, spv_position position) {
-  // NOTE: Consume white space, otherwise don't advance.
-  if (position->index >= text->length) return SPV_END_OF_STREAM;
-  switch (text->str[position->index]) {
+// Returns true for a character at which the bulk-skip loop in scanWord must
+// stop: the characters that can end a word, plus the quote and escape
+// characters that change the scanner state.
+inline bool isWordStopChar(char ch) {
+  switch (ch) {
     case '\0':
-      return SPV_END_OF_STREAM;
-    case ';':
-      if (spv_result_t error = advanceLine(text, position)) return error;
-      return advance(text, position);
-    case ' ':
     case '\t':
-    case '\r':
-      position->column++;
-      position->index++;
-      return advance(text, position);
     case '\n':
-      position->column = 0;
-      position->line++;
-      position->index++;
-      return advance(text, position);
+    case '\r':
+    case ' ':
+    case ';':
+    case '"':
+    case '\\':
+      return true;
     default:
-      break;
+      return false;
   }
-  return SPV_SUCCESS;
 }
 
-// Fetches the next word from the given text stream starting from the given
-// *position. On success, writes the decoded word into *word and updates
-// *position to the location past the returned word.
+// Advances *position past the end of the word that starts there.
 //
 // A word ends at the next comment or whitespace.  However, double-quoted
 // strings remain intact, and a backslash always escapes the next character.
-spv_result_t getWord(spv_text text, spv_position position, std::string* word) {
-  if (!text->str || !text->length) return SPV_ERROR_INVALID_TEXT;
-  if (!position) return SPV_ERROR_INVALID_POINTER;
-
-  const size_t start_index = position->index;
-
+//
+// Plain word characters are skipped in bulk -- sixteen at a time where SSE2
+// is available -- and the quote/escape state machine only runs on the
+// characters that can affect it.
+void scanWord(spv_text text, spv_position position) {
   bool quoting = false;
   bool escaping = false;
+  const char* str = text->str;
+  const size_t length = text->length;
+  size_t index = position->index;
 
   // NOTE: Assumes first character is not white space!
-  while (true) {
-    if (position->index >= text->length) {
-      word->assign(text->str + start_index, text->str + position->index);
-      return SPV_SUCCESS;
+  while (index < length) {
+    if (!quoting && !escaping) {
+#if defined(__SSE2__)
+      while (index + 16 <= length) {
+        const __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + index));
+        __m128i stop = _mm_cmpeq_epi8(chunk, _mm_setzero_si128());
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t')));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(';')));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')));
+        stop = _mm_or_si128(stop, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\')));
+        const int mask = _mm_movemask_epi8(stop);
+        if (mask) {
+          index += __builtin_ctz(mask);
+          break;
+        }
+        index += 16;
+      }
+#endif
+      while (index < length && !isWordStopChar(str[index])) index++;
+      if (index >= length) break;
     }
-    const char ch = text->str[position->index];
+
+    const char ch = str[index];
+    bool end_of_word = false;
     if (ch == '\\')
       escaping = !escaping;
     else {
@@ -119,19 +166,33 @@ spv_result_t getWord(spv_text text, spv_position position, std::string* word) {
         case '\r':
           if (escaping || quoting) break;
         // Fall through.
-        case '\0': {  // NOTE: End of word found!
-          word->assign(text->str + start_index, text->str + position->index);
-          return SPV_SUCCESS;
-        }
+        case '\0':
+          end_of_word = true;  // NOTE: End of word found!
+          break;
         default:
           break;
       }
       escaping = false;
     }
+    if (end_of_word) break;
 
-    position->column++;
-    position->index++;
+    index++;
   }
+
+  position->index = index;
+}
+
+// Fetches the next word from the given text stream starting from the given
+// *position. On success, writes the decoded word into *word and updates
+// *position to the location past the returned word.
+spv_result_t getWord(spv_text text, spv_position position, std::string* word) {
+  if (!text->str || !text->length) return SPV_ERROR_INVALID_TEXT;
+  if (!position) return SPV_ERROR_INVALID_POINTER;
+
+  const size_t start_index = position->index;
+  scanWord(text, position);
+  word->assign(text->str + start_index, text->str + position->index);
+  return SPV_SUCCESS;
 }
 
 // Returns true if the characters in the text as position represent
@@ -150,6 +211,62 @@ namespace libspirv {
 
 const IdType kUnknownType = {0, false, IdTypeClass::kBottom};
 
+TokenPipeline::TokenPipeline(spv_text text)
+    : text_(text), scanner_([this] { Scan(); }) {}
+
+TokenPipeline::~TokenPipeline() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cancelled_ = true;
+  }
+  space_available_.notify_one();
+  scanner_.join();
+}
+
+std::vector<AssemblyToken> TokenPipeline::NextBatch() {
+  std::vector<AssemblyToken> batch;
+  std::unique_lock<std::mutex> lock(mutex_);
+  batch_available_.wait(lock, [this] { return !batches_.empty() || done_; });
+  if (!batches_.empty()) {
+    batch = std::move(batches_.front());
+    batches_.pop_front();
+    lock.unlock();
+    space_available_.notify_one();
+  }
+  return batch;
+}
+
+void TokenPipeline::Scan() {
+  std::vector<AssemblyToken> batch;
+  batch.reserve(kTokensPerBatch);
+  spv_position_t position = {};
+  while (::advance(text_, &position) == SPV_SUCCESS) {
+    AssemblyToken token;
+    token.start = position;
+    scanWord(text_, &position);
+    token.length = static_cast<uint32_t>(position.index - token.start.index);
+    batch.push_back(token);
+    if (batch.size() == kTokensPerBatch) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      space_available_.wait(lock, [this] {
+        return batches_.size() < kMaxQueuedBatches || cancelled_;
+      });
+      if (cancelled_) return;
+      batches_.push_back(std::move(batch));
+      lock.unlock();
+      batch_available_.notify_one();
+      batch.clear();
+      batch.reserve(kTokensPerBatch);
+    }
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!batch.empty() && !cancelled_) batches_.push_back(std::move(batch));
+    done_ = true;
+  }
+  batch_available_.notify_one();
+}
+
 // TODO(dneto): Reorder AssemblyContext definitions to match declaration order.
 
 // This represents all of the data that is only valid for the duration of
@@ -157,7 +274,7 @@ const IdType kUnknownType = {0, false, IdTypeClass::kBottom};
 uint32_t AssemblyContext::spvNamedIdAssignOrGet(const char* textValue) {
   if (!ids_to_preserve_.empty()) {
     uint32_t id = 0;
-    if (spvutils::ParseNumber(textValue, &id)) {
+    if (spvutils::ParseNumberFast(textValue, &id)) {
       if (ids_to_preserve_.find(id) != ids_to_preserve_.end()) {
         bound_ = std::max(bound_, id + 1);
         return id;
@@ -165,7 +282,9 @@ uint32_t AssemblyContext::spvNamedIdAssignOrGet(const char* textValue) {
     }
   }
 
-  const auto it = named_ids_.find(textValue);
+  NamedIdKey key = {textValue, strlen(textValue), 0};
+  key.hash = hashText(key.data, key.length);
+  const auto it = named_ids_.find(key);
   if (it == named_ids_.end()) {
     uint32_t id = next_id_++;
     if (!ids_to_preserve_.empty()) {
@@ -174,7 +293,9 @@ uint32_t AssemblyContext::spvNamedIdAssignOrGet(const char* textValue) {
       }
     }
 
-    named_ids_.emplace(textValue, id);
+    // Intern the name so the stored key outlives the caller's buffer.
+    key.data = internString(key.data, key.length);
+    named_ids_.emplace(key, id);
     bound_ = std::max(bound_, id + 1);
     return id;
   }
@@ -182,29 +303,90 @@ uint32_t AssemblyContext::spvNamedIdAssignOrGet(const char* textValue) {
   return it->second;
 }
 
+const char* AssemblyContext::internString(const char* data, size_t length) {
+  const size_t bytes = length + 1;  // Keep names null-terminated.
+  if (bytes > arena_remaining_) {
+    const size_t block_size = std::max<size_t>(bytes, 4096);
+    arena_blocks_.emplace_back(new char[block_size]);
+    arena_next_ = arena_blocks_.back().get();
+    arena_remaining_ = block_size;
+  }
+  char* copy = arena_next_;
+  memcpy(copy, data, length);
+  copy[length] = '\0';
+  arena_next_ += bytes;
+  arena_remaining_ -= bytes;
+  return copy;
+}
+
 uint32_t AssemblyContext::getBound() const { return bound_; }
 
 spv_result_t AssemblyContext::advance() {
+  if (token_pipeline_) {
+    if (const AssemblyToken* token = currentToken()) {
+      current_position_ = token->start;
+      return SPV_SUCCESS;
+    }
+    return SPV_END_OF_STREAM;
+  }
   return ::advance(text_, &current_position_);
 }
 
 spv_result_t AssemblyContext::getWord(std::string* word,
                                       spv_position next_position) {
+  if (token_pipeline_) {
+    const AssemblyToken* token = currentToken();
+    if (token && token->start.index == current_position_.index) {
+      word->assign(text_->str + token->start.index, token->length);
+      *next_position = token->start;
+      next_position->index += token->length;
+      return SPV_SUCCESS;
+    }
+    // The current position is not on a token boundary, e.g. because the
+    // caller probed ahead on its own.  Scan directly instead.
+  }
   *next_position = current_position_;
   return ::getWord(text_, next_position, word);
 }
 
+const AssemblyToken* AssemblyContext::currentToken() {
+  while (true) {
+    if (next_token_ == token_batch_.size()) {
+      token_batch_ = token_pipeline_->NextBatch();
+      next_token_ = 0;
+      if (token_batch_.empty()) return nullptr;
+    }
+    // Tokens the cursor has already moved past are spent.
+    if (token_batch_[next_token_].start.index >= current_position_.index)
+      return &token_batch_[next_token_];
+    ++next_token_;
+  }
+}
+
 bool AssemblyContext::startsWithOp() {
   return ::startsWithOp(text_, &current_position_);
 }
 
 bool AssemblyContext::isStartOfNewInst() {
-  spv_position_t pos = current_position_;
+  return isStartOfNewInstAt(current_position_);
+}
+
+spv_result_t AssemblyContext::advanceAt(spv_position pos) const {
+  return ::advance(text_, pos);
+}
+
+spv_result_t AssemblyContext::getWordAt(std::string* word,
+                                        spv_position pos) const {
+  return ::getWord(text_, pos, word);
+}
+
+bool AssemblyContext::isStartOfNewInstAt(const spv_position_t& from) const {
+  spv_position_t pos = from;
   if (::advance(text_, &pos)) return false;
   if (::startsWithOp(text_, &pos)) return true;
 
   std::string word;
-  pos = current_position_;
+  pos = from;
   if (::getWord(text_, &pos, &word)) return false;
   if ('%' != word.front()) return false;
 
@@ -227,7 +409,30 @@ bool AssemblyContext::hasText() const {
 
 void AssemblyContext::seekForward(uint32_t size) {
   current_position_.index += size;
-  current_position_.column += size;
+}
+
+spv_position_t AssemblyContext::positionForDiagnostic() const {
+  // The scanners track only the byte index on the hot path.  Recover the
+  // line and column from an index of the newlines in the input, built once
+  // on the first diagnostic; successful assembly never pays for it.
+  if (line_starts_.empty()) {
+    line_starts_.push_back(0);
+    const char* str = text_->str;
+    const size_t length = text_->length;
+    size_t index = 0;
+    while (const char* newline = static_cast<const char*>(
+               memchr(str + index, '\n', length - index))) {
+      index = (newline - str) + 1;
+      line_starts_.push_back(index);
+    }
+  }
+  const auto line_it = std::upper_bound(
+      line_starts_.begin(), line_starts_.end(), current_position_.index);
+  const size_t line = (line_it - line_starts_.begin()) - 1;
+  spv_position_t position = current_position_;
+  position.line = line;
+  position.column = current_position_.index - line_starts_[line];
+  return position;
 }
 
 spv_result_t AssemblyContext::binaryEncodeU32(const uint32_t value,
@@ -312,8 +517,7 @@ spv_result_t AssemblyContext::binaryEncodeString(const char* value,
   // write a partial word at the end.
   pInst->words.back() = 0;
 
-  char* dest = (char*)&pInst->words[oldWordCount];
-  strncpy(dest, value, length);
+  memcpy(&pInst->words[oldWordCount], value, length);
 
   return SPV_SUCCESS;
 }
@@ -321,10 +525,12 @@ spv_result_t AssemblyContext::binaryEncodeString(const char* value,
 spv_result_t AssemblyContext::recordTypeDefinition(
     const spv_instruction_t* pInst) {
   uint32_t value = pInst->words[1];
-  if (types_.find(value) != types_.end()) {
+  if (value < types_.size() &&
+      types_[value].type_class != IdTypeClass::kBottom) {
     return diagnostic() << "Value " << value
                         << " has already been used to generate a type";
   }
+  if (value >= types_.size()) types_.resize(value + 1, kUnknownType);
 
   if (pInst->opcode == SpvOpTypeInt) {
     if (pInst->words.size() != 4)
@@ -342,11 +548,7 @@ spv_result_t AssemblyContext::recordTypeDefinition(
 }
 
 IdType AssemblyContext::getTypeOfTypeGeneratingValue(uint32_t value) const {
-  auto type = types_.find(value);
-  if (type == types_.end()) {
-    return kUnknownType;
-  }
-  return std::get<1>(*type);
+  return value < types_.size() ? types_[value] : kUnknownType;
 }
 
 IdType AssemblyContext::getTypeOfValueInstruction(uint32_t value) const {
@@ -369,27 +571,26 @@ spv_result_t AssemblyContext::recordTypeIdForValue(uint32_t value,
 
 spv_result_t AssemblyContext::recordIdAsExtInstImport(
     uint32_t id, spv_ext_inst_type_t type) {
-  bool successfully_inserted = false;
-  std::tie(std::ignore, successfully_inserted) =
-      import_id_to_ext_inst_type_.insert(std::make_pair(id, type));
-  if (!successfully_inserted)
+  if (id < import_id_to_ext_inst_type_.size() &&
+      import_id_to_ext_inst_type_[id] != SPV_EXT_INST_TYPE_NONE)
     return diagnostic() << "Import Id is being defined a second time";
+  if (id >= import_id_to_ext_inst_type_.size())
+    import_id_to_ext_inst_type_.resize(id + 1, SPV_EXT_INST_TYPE_NONE);
+  import_id_to_ext_inst_type_[id] = type;
   return SPV_SUCCESS;
 }
 
 spv_ext_inst_type_t AssemblyContext::getExtInstTypeForId(uint32_t id) const {
-  auto type = import_id_to_ext_inst_type_.find(id);
-  if (type == import_id_to_ext_inst_type_.end()) {
-    return SPV_EXT_INST_TYPE_NONE;
-  }
-  return std::get<1>(*type);
+  return id < import_id_to_ext_inst_type_.size()
+             ? import_id_to_ext_inst_type_[id]
+             : SPV_EXT_INST_TYPE_NONE;
 }
 
 std::set<uint32_t> AssemblyContext::GetNumericIds() const {
   std::set<uint32_t> ids;
   for (const auto& kv : named_ids_) {
     uint32_t id;
-    if (spvutils::ParseNumber(kv.first.c_str(), &id))
+    if (spvutils::ParseNumberFast(kv.first.data, &id))
       ids.insert(id);
   }
   return ids;
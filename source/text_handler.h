@@ -15,10 +15,17 @@
 #ifndef LIBSPIRV_TEXT_HANDLER_H_
 #define LIBSPIRV_TEXT_HANDLER_H_
 
+#include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <iomanip>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 #include "diagnostic.h"
 #include "instruction.h"
@@ -114,6 +121,52 @@ class ClampToZeroIfUnsignedType<
   }
 };
 
+// A single pre-scanned assembly token: where it starts in the input text and
+// how many characters it spans.  Tokens follow the same rules as
+// AssemblyContext::getWord(): a token ends at the next comment or whitespace,
+// except inside double quotes or after a backslash escape.
+struct AssemblyToken {
+  spv_position_t start;  // Position of the first character of the token.
+  uint32_t length;       // Number of characters in the token.
+};
+
+// Scans the input text for token boundaries on a background thread, handing
+// them to the consumer in batches through a bounded queue.  Token scanning
+// needs no grammar and never touches the named-id table, so the queue is the
+// only synchronization point between the scanner and the encoding thread.
+class TokenPipeline {
+ public:
+  // Starts the scanning thread over |text|, which must remain valid and
+  // unchanged for the lifetime of this object.
+  explicit TokenPipeline(spv_text text);
+  // Stops the scanning thread, discarding any tokens not yet consumed.
+  ~TokenPipeline();
+
+  // Disallow copying: the destructor joins the scanning thread.
+  TokenPipeline(const TokenPipeline&) = delete;
+  TokenPipeline& operator=(const TokenPipeline&) = delete;
+
+  // Returns the next batch of tokens, blocking until one is available.
+  // Returns an empty batch once the input is exhausted.
+  std::vector<AssemblyToken> NextBatch();
+
+ private:
+  // Body of the scanning thread.
+  void Scan();
+
+  static const size_t kTokensPerBatch = 4096;
+  static const size_t kMaxQueuedBatches = 4;
+
+  spv_text text_;
+  std::mutex mutex_;
+  std::condition_variable batch_available_;
+  std::condition_variable space_available_;
+  std::deque<std::vector<AssemblyToken>> batches_;
+  bool done_ = false;       // The scanner has exhausted the input.
+  bool cancelled_ = false;  // The consumer is shutting down early.
+  std::thread scanner_;     // Declared last: starts after the other members.
+};
+
 // Encapsulates the data used during the assembly of a SPIR-V module.
 class AssemblyContext {
  public:
@@ -144,11 +197,33 @@ class AssemblyContext {
   // instruction.
   bool isStartOfNewInst();
 
+  // Lookahead variants of advance(), getWord(), and isStartOfNewInst().
+  // They operate on |*pos| instead of the context's own cursor and never
+  // touch the token pipeline, whose tokens are consumed forward-only, so a
+  // caller may probe ahead and later decide not to consume the probed text.
+  spv_result_t advanceAt(spv_position pos) const;
+  spv_result_t getWordAt(std::string* word, spv_position pos) const;
+  bool isStartOfNewInstAt(const spv_position_t& pos) const;
+
+  // While set, records into |*sink| the index of the word each id operand
+  // taken from the text stream is encoded at.  The result id injected by the
+  // assembler is not reported; its word index is fixed by the opcode's
+  // layout.  Used to locate the id slots of a memoized instruction template.
+  void SetIdPositionSink(std::vector<uint32_t>* sink) {
+    id_position_sink_ = sink;
+  }
+  std::vector<uint32_t>* id_position_sink() const { return id_position_sink_; }
+
+  // Takes pre-scanned token boundaries from |pipeline| instead of scanning
+  // the text in advance() and getWord().  The pipeline must have been
+  // constructed over the same text as this context and must outlive it.
+  void SetTokenPipeline(TokenPipeline* pipeline) { token_pipeline_ = pipeline; }
+
   // Returns a diagnostic object initialized with current position in the input
   // stream, and for the given error code. Any data written to this object will
   // show up in pDiagnsotic on destruction.
   DiagnosticStream diagnostic(spv_result_t error) {
-    return DiagnosticStream(current_position_, consumer_, error);
+    return DiagnosticStream(positionForDiagnostic(), consumer_, error);
   }
 
   // Returns a diagnostic object with the default assembly error code.
@@ -171,9 +246,16 @@ class AssemblyContext {
     current_position_ = newPosition;
   }
 
-  // Returns the current position in the input stream.
+  // Returns the current position in the input stream.  Only the index field
+  // is maintained while scanning; use positionForDiagnostic() when the line
+  // and column are needed.
   const spv_position_t& position() const { return current_position_; }
 
+  // Returns the current position with its line and column recovered from the
+  // byte index.  The newline index used for the recovery is built lazily on
+  // the first call, so successful assembly never pays for position tracking.
+  spv_position_t positionForDiagnostic() const;
+
   // Appends the given 32-bit value to the given instruction.
   // Returns SPV_SUCCESS if the value could be correctly inserted in the
   // instruction.
@@ -232,19 +314,80 @@ class AssemblyContext {
   std::set<uint32_t> GetNumericIds() const;
 
  private:
+  // A view of a named id, carrying a precomputed hash so table lookups
+  // neither copy nor rehash the text.  Keys held in the table view
+  // null-terminated copies in the context's interning arena; lookup keys
+  // may view any caller-owned buffer.
+  struct NamedIdKey {
+    const char* data;
+    size_t length;
+    size_t hash;
+  };
+  struct NamedIdKeyHash {
+    size_t operator()(const NamedIdKey& key) const { return key.hash; }
+  };
+  struct NamedIdKeyEqual {
+    bool operator()(const NamedIdKey& lhs, const NamedIdKey& rhs) const {
+      return lhs.length == rhs.length &&
+             0 == memcmp(lhs.data, rhs.data, lhs.length);
+    }
+  };
+
+  // Returns the hash for the given text, as stored in a NamedIdKey.
+  // This is FNV-1a: simple, fast, and dependency-free.
+  static size_t hashText(const char* data, size_t length) {
+    uint64_t hash = 14695981039346656037ull;  // FNV-1a offset basis.
+    for (size_t i = 0; i < length; ++i) {
+      hash ^= static_cast<uint8_t>(data[i]);
+      hash *= 1099511628211ull;  // FNV-1a prime.
+    }
+    return static_cast<size_t>(hash);
+  }
+
+  // Copies the given text into the interning arena and returns the stable,
+  // null-terminated copy.
+  const char* internString(const char* data, size_t length);
+
+  // Returns the first pre-scanned token at or past the current position,
+  // fetching more batches from the token pipeline as needed.  Returns nullptr
+  // when the token stream is exhausted.  Only valid when a token pipeline has
+  // been set.
+  const AssemblyToken* currentToken();
+
   // Maps ID names to their corresponding numerical ids.
-  using spv_named_id_table = std::unordered_map<std::string, uint32_t>;
-  // Maps type-defining IDs to their IdType.
-  using spv_id_to_type_map = std::unordered_map<uint32_t, IdType>;
+  using spv_named_id_table =
+      std::unordered_map<NamedIdKey, uint32_t, NamedIdKeyHash, NamedIdKeyEqual>;
+  // Maps type-defining IDs to their IdType, indexed by the id.  Assembler
+  // ids are small and dense, so a flat array beats a hash map here.  Slots
+  // for ids that do not define a type hold IdTypeClass::kBottom.
+  using spv_id_to_type_map = std::vector<IdType>;
   // Maps Ids to the id of their type.
   using spv_id_to_type_id = std::unordered_map<uint32_t, uint32_t>;
 
   spv_named_id_table named_ids_;
+  // Block-allocated backing storage for the interned id names, so each
+  // name does not pay for its own heap allocation.
+  std::vector<std::unique_ptr<char[]>> arena_blocks_;
+  char* arena_next_ = nullptr;       // First free byte in the last block.
+  size_t arena_remaining_ = 0;       // Free bytes in the last block.
   spv_id_to_type_map types_;
   spv_id_to_type_id value_types_;
-  // Maps an extended instruction import Id to the extended instruction type.
-  std::unordered_map<uint32_t, spv_ext_inst_type_t> import_id_to_ext_inst_type_;
+  // Maps an extended instruction import Id to the extended instruction
+  // type, indexed by the id.  SPV_EXT_INST_TYPE_NONE marks ids that are
+  // not import results.
+  std::vector<spv_ext_inst_type_t> import_id_to_ext_inst_type_;
+  // Where id operand word positions are reported, if anywhere.
+  std::vector<uint32_t>* id_position_sink_ = nullptr;
+  // Source of pre-scanned token boundaries, if any.
+  TokenPipeline* token_pipeline_ = nullptr;
+  std::vector<AssemblyToken> token_batch_;  // The batch being consumed.
+  size_t next_token_ = 0;  // Index of the first unconsumed token in the batch.
+  // Only the index field is maintained while scanning; line and column are
+  // recovered by positionForDiagnostic() when an error is reported.
   spv_position_t current_position_;
+  // Byte offsets of the first character of each line, built on demand by
+  // positionForDiagnostic().
+  mutable std::vector<size_t> line_starts_;
   spvtools::MessageConsumer consumer_;
   spv_text text_;
   uint32_t bound_;
@@ -0,0 +1,111 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tracing.h"
+
+#ifdef SPIRV_TRACING
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace libspirv {
+namespace {
+
+// The trace sink is process-wide: spans are emitted from library internals
+// that have no tool state to hang a sink off, and one file per process is
+// what the trace viewer expects anyway.  g_enabled mirrors whether g_file is
+// open so TraceScope can skip disabled spans without taking the lock.
+std::mutex g_mutex;
+std::FILE* g_file = nullptr;
+std::atomic<bool> g_enabled(false);
+bool g_first_event = true;
+std::chrono::steady_clock::time_point g_epoch;
+
+// Appends |name| to |file| with the two characters JSON strings cannot
+// contain raw.  Span names are opcode-like identifiers, but pass names come
+// from virtual calls, so escape rather than trust every future pass.
+void WriteEscaped(const char* name, std::FILE* file) {
+  for (const char* p = name; *p; ++p) {
+    if (*p == '"' || *p == '\\') std::fputc('\\', file);
+    std::fputc(*p, file);
+  }
+}
+
+// Returns a stable small-ish id for the calling thread.  The viewer only
+// uses it to assign spans to rows, so a truncated hash is good enough.
+uint32_t CurrentThreadId() {
+  return static_cast<uint32_t>(
+      std::hash<std::thread::id>()(std::this_thread::get_id()) & 0xffffff);
+}
+
+}  // anonymous namespace
+
+bool TraceStart(const char* path) {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  if (g_file) return false;
+  g_file = std::fopen(path, "w");
+  if (!g_file) return false;
+  // chrome://tracing accepts a bare JSON array of events.
+  std::fputs("[", g_file);
+  g_first_event = true;
+  g_epoch = std::chrono::steady_clock::now();
+  g_enabled.store(true, std::memory_order_release);
+  return true;
+}
+
+void TraceStop() {
+  std::lock_guard<std::mutex> lock(g_mutex);
+  if (!g_file) return;
+  g_enabled.store(false, std::memory_order_release);
+  std::fputs("\n]\n", g_file);
+  std::fclose(g_file);
+  g_file = nullptr;
+}
+
+TraceScope::TraceScope(const char* name)
+    : name_(name), active_(g_enabled.load(std::memory_order_acquire)) {
+  if (active_) start_ = std::chrono::steady_clock::now();
+}
+
+TraceScope::~TraceScope() {
+  if (!active_) return;
+  const auto end = std::chrono::steady_clock::now();
+  const uint32_t tid = CurrentThreadId();
+  std::lock_guard<std::mutex> lock(g_mutex);
+  // The file may have been closed between the flag test and here; spans
+  // still open at TraceStop are simply dropped.
+  if (!g_file) return;
+  const uint64_t ts = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(start_ - g_epoch)
+          .count());
+  const uint64_t dur = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(end - start_)
+          .count());
+  if (!g_first_event) std::fputs(",", g_file);
+  g_first_event = false;
+  std::fputs("\n{\"name\":\"", g_file);
+  WriteEscaped(name_, g_file);
+  std::fprintf(g_file,
+               "\",\"ph\":\"X\",\"ts\":%" PRIu64 ",\"dur\":%" PRIu64
+               ",\"pid\":1,\"tid\":%u}",
+               ts, dur, tid);
+}
+
+}  // namespace libspirv
+
+#endif  // SPIRV_TRACING
@@ -0,0 +1,80 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_TRACING_H_
+#define LIBSPIRV_TRACING_H_
+
+// Chrome trace-event spans for the library's major stages.  When the build
+// enables SPIRV_TRACING (cmake -DSPIRV_TRACING=ON) and a tool has called
+// TraceStart, every SPIRV_TRACE_SCOPE below emits one complete event
+// ("ph":"X") into a JSON array that chrome://tracing and compatible viewers
+// load directly.  Spans cover the binary parse, each validator stage, each
+// optimizer pass and module serialization, and nest naturally in the viewer
+// because they carry real begin times and durations per thread.  In a normal
+// build the macro expands to nothing, so call sites stay unconditional.
+
+#ifdef SPIRV_TRACING
+
+#include <chrono>
+
+namespace libspirv {
+
+// Returns true in builds with tracing compiled in.
+inline bool TraceSupported() { return true; }
+
+// Starts recording trace events to the JSON file at |path|, truncating any
+// existing file.  Returns false if the file cannot be opened.  Events from
+// all threads in the process are recorded until TraceStop.
+bool TraceStart(const char* path);
+
+// Finishes the JSON array and closes the trace file.  No-op if tracing was
+// never started.
+void TraceStop();
+
+// Emits one complete event covering its own lifetime.  The span is dropped
+// entirely when no trace file is open, so instrumented code paths only pay
+// for a flag test.  |name| must stay valid for the scope's lifetime.
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name);
+  ~TraceScope();
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  const char* name_;
+  bool active_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace libspirv
+
+#define SPIRV_TRACE_SCOPE(name) libspirv::TraceScope spirv_trace_scope_(name)
+
+#else  // !SPIRV_TRACING
+
+namespace libspirv {
+
+inline bool TraceSupported() { return false; }
+inline bool TraceStart(const char*) { return false; }
+inline void TraceStop() {}
+
+}  // namespace libspirv
+
+#define SPIRV_TRACE_SCOPE(name) ((void)0)
+
+#endif  // SPIRV_TRACING
+
+#endif  // LIBSPIRV_TRACING_H_
@@ -276,6 +276,44 @@ void BitWriterWord64::WriteBits(uint64_t bits, size_t num_bits) {
   assert(buffer_.size() * 64 >= end_);
 }
 
+void BitWriterWord64::WriteBitsBulk(const uint64_t* values, size_t count,
+                                    size_t num_bits) {
+  assert(num_bits > 0);
+  assert(num_bits <= 64);
+  const bool is_little_endian = IsLittleEndian();
+  assert(is_little_endian && "Big-endian architecture support not implemented");
+  if (!is_little_endian) return;
+  if (count == 0) return;
+
+  // Size the buffer for all the bits up front, then pack values through a
+  // running word with funnel shifts, so the loop is register arithmetic with
+  // a single store per completed word instead of a push_back per value.
+  const size_t final_end = end_ + count * num_bits;
+  buffer_.resize(NumBitsToNumWords<64>(final_end), 0);
+
+  uint64_t* const words = buffer_.data();
+  size_t index = end_ / 64;
+  size_t offset = end_ % 64;
+  uint64_t current = words[index];
+
+  for (size_t i = 0; i < count; ++i) {
+    const uint64_t bits = GetLowerBits(values[i], num_bits);
+    current |= bits << offset;
+    offset += num_bits;
+    if (offset >= 64) {
+      words[index++] = current;
+      offset -= 64;
+      // The high |offset| bits of |bits| spill into the next word.  When
+      // |offset| is zero the shift would be invalid, but the spill is empty.
+      current = offset ? bits >> (num_bits - offset) : 0;
+    }
+  }
+  if (offset) words[index] = current;
+
+  end_ = final_end;
+  assert(buffer_.size() * 64 >= end_);
+}
+
 bool BitReaderInterface::ReadVariableWidthU64(uint64_t* val,
                                               size_t chunk_length) {
   return ReadVariableWidthUnsigned(this, val, chunk_length);
@@ -365,6 +403,33 @@ size_t BitReaderWord64::ReadBits(uint64_t* bits, size_t num_bits) {
   return num_bits;
 }
 
+size_t BitReaderWord64::ReadBitsBulk(uint64_t* values, size_t count,
+                                     size_t num_bits) {
+  assert(num_bits > 0);
+  assert(num_bits <= 64);
+  const bool is_little_endian = IsLittleEndian();
+  assert(is_little_endian && "Big-endian architecture support not implemented");
+  if (!is_little_endian) return 0;
+
+  const size_t total_bits = buffer_.size() * 64;
+  const uint64_t* const words = buffer_.data();
+
+  size_t num_read = 0;
+  for (; num_read < count; ++num_read) {
+    if (pos_ + num_bits > total_bits) break;
+    const size_t index = pos_ / 64;
+    const size_t offset = pos_ % 64;
+    uint64_t bits = words[index] >> offset;
+    if (offset + num_bits > 64) {
+      // The value continues in the next word.
+      bits |= words[index + 1] << (64 - offset);
+    }
+    values[num_read] = GetLowerBits(bits, num_bits);
+    pos_ += num_bits;
+  }
+  return num_read;
+}
+
 bool BitReaderWord64::ReachedEnd() const {
   return pos_ >= buffer_.size() * 64;
 }
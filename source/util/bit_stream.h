@@ -197,6 +197,20 @@ class BitWriterInterface {
   // |num_bits| must be no greater than 64.
   virtual void WriteBits(uint64_t bits, size_t num_bits) = 0;
 
+  // Writes the lower |num_bits| of each of the |count| values in |values| to
+  // the stream, as if by calling WriteBits on each in turn.  |num_bits| must
+  // be between 1 and 64.  Implementations may override this with a batched
+  // version that avoids per-value bookkeeping.
+  virtual void WriteBitsBulk(const uint64_t* values, size_t count,
+                             size_t num_bits) {
+    for (size_t i = 0; i < count; ++i) WriteBits(values[i], num_bits);
+  }
+
+  // Hints that at least |num_bits| more bits are about to be written, so the
+  // implementation can reserve buffer space up front.  Does nothing by
+  // default.
+  virtual void ReserveBits(size_t num_bits) { (void)num_bits; }
+
   // Writes left-to-right string of '0' and '1' to stream.
   // String length must be no greater than 64.
   // Note: "01" will be writen as 0x2, not 0x1. The string doesn't represent
@@ -259,6 +273,13 @@ class BitWriterWord64 : public BitWriterInterface {
 
   void WriteBits(uint64_t bits, size_t num_bits) override;
 
+  void WriteBitsBulk(const uint64_t* values, size_t count,
+                     size_t num_bits) override;
+
+  void ReserveBits(size_t num_bits) override {
+    buffer_.reserve(NumBitsToNumWords<64>(end_ + num_bits));
+  }
+
   size_t GetNumBits() const override {
     return end_;
   }
@@ -293,6 +314,21 @@ class BitReaderInterface {
   // Returns number of read bits. |num_bits| must be no greater than 64.
   virtual size_t ReadBits(uint64_t* bits, size_t num_bits) = 0;
 
+  // Reads |count| values of |num_bits| each from the stream into |values|.
+  // |num_bits| must be between 1 and 64.  Returns the number of whole values
+  // read; unlike ReadBits, a trailing value the stream cannot fill completely
+  // is neither stored nor consumed.  Implementations may override this with a
+  // batched version that avoids per-value bookkeeping.
+  virtual size_t ReadBitsBulk(uint64_t* values, size_t count,
+                              size_t num_bits) {
+    for (size_t i = 0; i < count; ++i) {
+      uint64_t bits = 0;
+      if (ReadBits(&bits, num_bits) != num_bits) return i;
+      values[i] = bits;
+    }
+    return count;
+  }
+
   // Reads |num_bits| from the stream, stores them in |bits|.
   // Returns number of read bits. |num_bits| must be no greater than 64.
   template <size_t N>
@@ -364,6 +400,8 @@ class BitReaderWord64 : public BitReaderInterface {
   explicit BitReaderWord64(const std::vector<uint8_t>& buffer);
 
   size_t ReadBits(uint64_t* bits, size_t num_bits) override;
+  size_t ReadBitsBulk(uint64_t* values, size_t count,
+                      size_t num_bits) override;
   bool ReachedEnd() const override;
   bool OnlyZeroesLeft() const override;
 
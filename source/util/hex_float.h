@@ -25,6 +25,12 @@
 
 #include "bitutils.h"
 
+#if defined(__F16C__)
+#include <immintrin.h>
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && (__ARM_FP & 0x2)
+#include <arm_neon.h>
+#endif
+
 namespace spvutils {
 
 class Float16 {
@@ -1071,6 +1077,136 @@ inline std::ostream& operator<<<Float16>(std::ostream& os,
   os << HexFloat<FloatProxy<Float16>>(value);
   return os;
 }
+
+// Converts a single 32-bit float to the bit pattern of a 16-bit float,
+// rounding in the given direction.  This is the HexFloat::castTo narrowing:
+// overflow saturates to infinity in every rounding mode and NaN payload
+// bits are carried across.
+inline uint16_t Float16FromFloat32(float value, round_direction round_dir) {
+  HexFloat<FloatProxy<float>> wide(value);
+  HexFloat<FloatProxy<Float16>> narrow(Float16(0));
+  wide.castTo(narrow, round_dir);
+  return narrow.value().getAsFloat().get_value();
+}
+
+// Converts the bit pattern of a 16-bit float to a 32-bit float through the
+// HexFloat::castTo widening, which is exact and carries NaN payload bits
+// across.
+inline float Float32FromFloat16(uint16_t value) {
+  const Float16 half(value);
+  HexFloat<FloatProxy<Float16>> narrow(half);
+  HexFloat<FloatProxy<float>> wide(0.0f);
+  // The rounding direction is ignored for a widening cast.
+  narrow.castTo(wide, round_direction::kToZero);
+  return wide.value().getAsFloat();
+}
+
+#if defined(__F16C__)
+// Narrows four floats at a time under the compile-time rounding |kRounding|.
+// Returns the number of values converted (a multiple of four).
+template <int kRounding>
+inline size_t Float32ToFloat16Quads(const float* input, uint16_t* output,
+                                    size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    _mm_storel_epi64(
+        reinterpret_cast<__m128i*>(output + i),
+        _mm_cvtps_ph(_mm_loadu_ps(input + i), kRounding | _MM_FROUND_NO_EXC));
+  }
+  return i;
+}
+#endif
+
+// Converts |count| 32-bit floats from |input| to 16-bit float bit patterns
+// in |output|, rounding each in the given direction.  Results are identical
+// to converting the values one at a time with HexFloat::castTo: hardware
+// conversion instructions handle the bulk of the lanes where available, and
+// the lanes they may round differently — NaN payloads, magnitudes at or
+// above 2^16 (which castTo saturates to infinity in every rounding mode),
+// and nonzero magnitudes below the smallest normal half (where castTo
+// rounds the significand before the denormalizing shift) — are re-run
+// through the template logic.
+inline void Float32ToFloat16Buffer(const float* input, uint16_t* output,
+                                   size_t count, round_direction round_dir) {
+  size_t converted = 0;
+#if defined(__F16C__)
+  switch (round_dir) {
+    case round_direction::kToZero:
+      converted = Float32ToFloat16Quads<_MM_FROUND_TO_ZERO>(input, output,
+                                                            count);
+      break;
+    case round_direction::kToNearestEven:
+      converted = Float32ToFloat16Quads<_MM_FROUND_TO_NEAREST_INT>(
+          input, output, count);
+      break;
+    case round_direction::kToPositiveInfinity:
+      converted = Float32ToFloat16Quads<_MM_FROUND_TO_POS_INF>(input, output,
+                                                               count);
+      break;
+    case round_direction::kToNegativeInfinity:
+      converted = Float32ToFloat16Quads<_MM_FROUND_TO_NEG_INF>(input, output,
+                                                               count);
+      break;
+  }
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && (__ARM_FP & 0x2)
+  // The NEON narrowing conversion rounds to nearest even (the default FPCR
+  // mode); other directions take the scalar path.
+  if (round_dir == round_direction::kToNearestEven) {
+    for (; converted + 4 <= count; converted += 4) {
+      vst1_u16(output + converted,
+               vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(input + converted))));
+    }
+  }
+#endif
+  // Redo the lanes the hardware may round differently from castTo.  The
+  // first comparison is false for NaN and for any magnitude reaching 2^16;
+  // the second catches nonzero magnitudes below the smallest normal half;
+  // the third catches values whose round-up can carry out of the half
+  // fraction (the ten kept fraction bits all ones), which castTo resolves
+  // without renormalizing.
+  const float min_normal_half = 0.00006103515625f;  // 2^-14
+  for (size_t i = 0; i < converted; ++i) {
+    const float magnitude = std::fabs(input[i]);
+    const uint32_t bits = BitwiseCast<uint32_t>(input[i]);
+    if (!(magnitude < 65536.0f) ||
+        (magnitude > 0.0f && magnitude < min_normal_half) ||
+        (bits & 0x007FE000) == 0x007FE000) {
+      output[i] = Float16FromFloat32(input[i], round_dir);
+    }
+  }
+  for (; converted < count; ++converted) {
+    output[converted] = Float16FromFloat32(input[converted], round_dir);
+  }
+}
+
+// Converts |count| 16-bit float bit patterns from |input| to 32-bit floats
+// in |output|.  Widening is exact, so hardware conversion instructions are
+// used directly where available; NaN lanes are re-run through the template
+// logic, which preserves signaling NaN payloads the hardware would quiet.
+inline void Float16ToFloat32Buffer(const uint16_t* input, float* output,
+                                   size_t count) {
+  size_t converted = 0;
+#if defined(__F16C__)
+  for (; converted + 4 <= count; converted += 4) {
+    _mm_storeu_ps(output + converted,
+                  _mm_cvtph_ps(_mm_loadl_epi64(
+                      reinterpret_cast<const __m128i*>(input + converted))));
+  }
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && (__ARM_FP & 0x2)
+  for (; converted + 4 <= count; converted += 4) {
+    vst1q_f32(output + converted,
+              vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(input + converted))));
+  }
+#endif
+  for (size_t i = 0; i < converted; ++i) {
+    if ((input[i] & 0x7C00) == 0x7C00 && (input[i] & 0x3FF) != 0) {
+      output[i] = Float32FromFloat16(input[i]);
+    }
+  }
+  for (; converted < count; ++converted) {
+    output[converted] = Float32FromFloat16(input[converted]);
+  }
+}
 }
 
 #endif  // LIBSPIRV_UTIL_HEX_FLOAT_H_
@@ -0,0 +1,168 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Contains a Huffman codec built on top of the bit stream utilities.
+
+#ifndef LIBSPIRV_UTIL_HUFFMAN_CODEC_H_
+#define LIBSPIRV_UTIL_HUFFMAN_CODEC_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "util/bit_stream.h"
+
+namespace spvutils {
+
+// Huffman-codes values from a histogram of occurrence counts.  The code tree
+// is fully determined by the histogram: leaves are seeded in order of
+// ascending value and ties in weight are broken by node creation order, so an
+// encoder and a decoder given equal histograms derive identical codes.
+// Codes are limited to 64 bits, which no histogram of 32-bit counts can
+// exceed.
+template <typename Val>
+class HuffmanCodec {
+ public:
+  // Builds the code tree from |hist|.  Entries are sorted by value
+  // internally, so iteration order of the map does not matter.
+  explicit HuffmanCodec(const std::unordered_map<Val, uint32_t>& hist) {
+    std::vector<std::pair<Val, uint32_t>> sorted(hist.begin(), hist.end());
+    std::sort(sorted.begin(), sorted.end(),
+              [](const std::pair<Val, uint32_t>& lhs,
+                 const std::pair<Val, uint32_t>& rhs) {
+                return lhs.first < rhs.first;
+              });
+    Build(sorted);
+  }
+
+  // Builds the code tree from histogram entries, which must be sorted by
+  // value and contain no duplicates.
+  explicit HuffmanCodec(
+      const std::vector<std::pair<Val, uint32_t>>& sorted_hist) {
+    assert(std::is_sorted(sorted_hist.begin(), sorted_hist.end(),
+                          [](const std::pair<Val, uint32_t>& lhs,
+                             const std::pair<Val, uint32_t>& rhs) {
+                            return lhs.first < rhs.first;
+                          }));
+    Build(sorted_hist);
+  }
+
+  // Writes the code for |val| to |writer|.  Returns false if |val| was not
+  // in the histogram.
+  bool Write(const Val& val, BitWriterInterface* writer) const {
+    const auto it = encoding_.find(val);
+    if (it == encoding_.end()) return false;
+    writer->WriteBits(it->second.bits, it->second.num_bits);
+    return true;
+  }
+
+  // Reads the next code from |reader| and stores the decoded value in |val|.
+  // Returns false if the stream ends mid-code or the histogram was empty.
+  bool Read(BitReaderInterface* reader, Val* val) const {
+    if (!root_) return false;
+    uint32_t node = root_;
+    // Interior nodes always have both children; a node without a left child
+    // is a leaf.  A histogram with a single entry produces a zero-bit code.
+    while (nodes_[node].left) {
+      uint64_t bit = 0;
+      if (reader->ReadBits(&bit, 1) != 1) return false;
+      node = bit ? nodes_[node].right : nodes_[node].left;
+    }
+    *val = nodes_[node].value;
+    return true;
+  }
+
+ private:
+  struct Node {
+    Val value = Val();
+    uint64_t weight = 0;
+    uint32_t left = 0;  // Child node ids; 0 means no child.
+    uint32_t right = 0;
+  };
+
+  struct Code {
+    uint64_t bits = 0;
+    size_t num_bits = 0;
+  };
+
+  void Build(const std::vector<std::pair<Val, uint32_t>>& hist) {
+    if (hist.empty()) return;
+
+    nodes_.resize(1);  // Node id 0 stands for no child.
+
+    // Min-queue of node ids ordered by (weight, id).  Breaking ties by id
+    // keeps the tree independent of priority queue implementation details.
+    const auto higher = [this](uint32_t lhs, uint32_t rhs) {
+      if (nodes_[lhs].weight != nodes_[rhs].weight)
+        return nodes_[lhs].weight > nodes_[rhs].weight;
+      return lhs > rhs;
+    };
+    std::priority_queue<uint32_t, std::vector<uint32_t>, decltype(higher)>
+        queue(higher);
+
+    for (const auto& pair : hist) {
+      const uint32_t id = static_cast<uint32_t>(nodes_.size());
+      nodes_.emplace_back();
+      nodes_.back().value = pair.first;
+      nodes_.back().weight = pair.second;
+      queue.push(id);
+    }
+
+    while (queue.size() > 1) {
+      const uint32_t left = queue.top();
+      queue.pop();
+      const uint32_t right = queue.top();
+      queue.pop();
+      const uint32_t id = static_cast<uint32_t>(nodes_.size());
+      nodes_.emplace_back();
+      nodes_.back().weight = nodes_[left].weight + nodes_[right].weight;
+      nodes_.back().left = left;
+      nodes_.back().right = right;
+      queue.push(id);
+    }
+
+    root_ = queue.top();
+    AssignCodes(root_, Code());
+  }
+
+  // Walks the subtree under |node| assigning codes: going left appends a 0
+  // bit, going right a 1.  The first branch taken occupies the lowest bit,
+  // matching the order in which WriteBits emits them.
+  void AssignCodes(uint32_t node, Code code) {
+    if (!nodes_[node].left) {
+      encoding_.emplace(nodes_[node].value, code);
+      return;
+    }
+    assert(code.num_bits < 64 && "Huffman code exceeds 64 bits");
+    Code left = code;
+    ++left.num_bits;
+    Code right = code;
+    right.bits |= uint64_t(1) << code.num_bits;
+    ++right.num_bits;
+    AssignCodes(nodes_[node].left, left);
+    AssignCodes(nodes_[node].right, right);
+  }
+
+  std::vector<Node> nodes_;
+  uint32_t root_ = 0;
+  std::unordered_map<Val, Code> encoding_;
+};
+
+}  // namespace spvutils
+
+#endif  // LIBSPIRV_UTIL_HUFFMAN_CODEC_H_
@@ -14,8 +14,11 @@
 
 #include "util/parse_number.h"
 
+#include <cerrno>
+#include <cstdlib>
 #include <functional>
 #include <iomanip>
+#include <limits>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -50,6 +53,135 @@ class ErrorMsgStream {
   // destructor is called.
   std::string* error_msg_sink_;
 };
+
+// Scans |text| as an unsigned integer magnitude, accepting decimal and
+// 0x/0X hexadecimal forms. The number should take up the entire string.
+// Returns false on an empty string, a stray character, or overflow of
+// uint64_t.
+bool ScanUnsignedInteger(const char* text, uint64_t* out) {
+  const char* p = text;
+  uint64_t value = 0;
+  if (p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+    p += 2;
+    if (!*p) return false;
+    for (; *p; ++p) {
+      uint64_t digit;
+      if (*p >= '0' && *p <= '9')
+        digit = uint64_t(*p - '0');
+      else if (*p >= 'a' && *p <= 'f')
+        digit = uint64_t(*p - 'a' + 10);
+      else if (*p >= 'A' && *p <= 'F')
+        digit = uint64_t(*p - 'A' + 10);
+      else
+        return false;
+      // The next shift would drop bits off the top.
+      if (value >> 60) return false;
+      value = (value << 4) | digit;
+    }
+  } else {
+    if (!*p) return false;
+    for (; *p; ++p) {
+      if (*p < '0' || *p > '9') return false;
+      const uint64_t digit = uint64_t(*p - '0');
+      if (value > (std::numeric_limits<uint64_t>::max() - digit) / 10)
+        return false;
+      value = value * 10 + digit;
+    }
+  }
+  *out = value;
+  return true;
+}
+
+// Returns true if |text| consists only of characters that can appear in a
+// plain decimal floating point literal: digits, signs, '.', and 'e'/'E',
+// with at least one digit present. Hex-float forms ("0x1.8p1") and keyword
+// forms ("NaN") are excluded so that they keep going through the
+// stream-based conversion in hex_float.h.
+bool IsPlainDecimalFloat(const char* text) {
+  bool has_digit = false;
+  for (const char* p = text; *p; ++p) {
+    if (*p >= '0' && *p <= '9')
+      has_digit = true;
+    else if (*p != '.' && *p != 'e' && *p != 'E' && *p != '+' && *p != '-')
+      return false;
+  }
+  return has_digit;
+}
+}
+
+bool ParseNumberFast(const char* text, uint64_t* value_pointer) {
+  if (!text) return false;
+  if (*text == '+') ++text;
+  return ScanUnsignedInteger(text, value_pointer);
+}
+
+bool ParseNumberFast(const char* text, int64_t* value_pointer) {
+  if (!text) return false;
+  bool is_negative = false;
+  if (*text == '+') {
+    ++text;
+  } else if (*text == '-') {
+    is_negative = true;
+    ++text;
+  }
+  uint64_t magnitude = 0;
+  if (!ScanUnsignedInteger(text, &magnitude)) return false;
+  if (is_negative) {
+    // The magnitude of int64_t min exceeds int64_t max by one.
+    const uint64_t min_magnitude =
+        uint64_t(std::numeric_limits<int64_t>::max()) + 1;
+    if (magnitude > min_magnitude) return false;
+    *value_pointer = int64_t(0 - magnitude);
+  } else {
+    if (magnitude > uint64_t(std::numeric_limits<int64_t>::max()))
+      return false;
+    *value_pointer = int64_t(magnitude);
+  }
+  return true;
+}
+
+bool ParseNumberFast(const char* text, uint32_t* value_pointer) {
+  uint64_t value = 0;
+  if (!ParseNumberFast(text, &value)) return false;
+  if (value > std::numeric_limits<uint32_t>::max()) return false;
+  *value_pointer = uint32_t(value);
+  return true;
+}
+
+bool ParseNumberFast(const char* text, int32_t* value_pointer) {
+  int64_t value = 0;
+  if (!ParseNumberFast(text, &value)) return false;
+  if (value > std::numeric_limits<int32_t>::max() ||
+      value < std::numeric_limits<int32_t>::min())
+    return false;
+  *value_pointer = int32_t(value);
+  return true;
+}
+
+bool ParseNumberFast(const char* text, float* value_pointer) {
+  if (!text || !IsPlainDecimalFloat(text)) return false;
+  errno = 0;
+  char* end = nullptr;
+  const float value = strtof(text, &end);
+  if (end == text || *end) return false;
+  // Match the stream-based conversion: overflow to infinity is a failure,
+  // while underflow to zero or a denormal is not.
+  if (errno == ERANGE && (value == HUGE_VALF || value == -HUGE_VALF))
+    return false;
+  *value_pointer = value;
+  return true;
+}
+
+bool ParseNumberFast(const char* text, double* value_pointer) {
+  if (!text || !IsPlainDecimalFloat(text)) return false;
+  errno = 0;
+  char* end = nullptr;
+  const double value = strtod(text, &end);
+  if (end == text || *end) return false;
+  if (errno == ERANGE && (value == HUGE_VAL || value == -HUGE_VAL))
+    return false;
+  *value_pointer = value;
+  return true;
 }
 
 EncodeNumberStatus ParseAndEncodeIntegerNumber(
@@ -89,7 +221,7 @@ EncodeNumberStatus ParseAndEncodeIntegerNumber(
   if (is_negative) {
     int64_t decoded_signed = 0;
 
-    if (!ParseNumber(text, &decoded_signed)) {
+    if (!ParseNumberFast(text, &decoded_signed)) {
       ErrorMsgStream(error_msg) << "Invalid signed integer literal: " << text;
       return EncodeNumberStatus::kInvalidText;
     }
@@ -105,7 +237,7 @@ EncodeNumberStatus ParseAndEncodeIntegerNumber(
     decoded_bits = decoded_signed;
   } else {
     // There's no leading minus sign, so parse it as an unsigned integer.
-    if (!ParseNumber(text, &decoded_bits)) {
+    if (!ParseNumberFast(text, &decoded_bits)) {
       ErrorMsgStream(error_msg) << "Invalid unsigned integer literal: " << text;
       return EncodeNumberStatus::kInvalidText;
     }
@@ -143,6 +275,47 @@ EncodeNumberStatus ParseAndEncodeFloatingPointNumber(
   }
 
   const auto bit_width = AssumedBitWidth(type);
+
+  // Fast path for plain decimal literals, which dominate generated assembly.
+  // Hex-float forms, overflowing values and malformed text fall through to
+  // the stream-based conversion below, which understands hex floats and
+  // already formats the diagnostics.
+  switch (bit_width) {
+    case 16: {
+      float parsed = 0.0f;
+      if (ParseNumberFast(text, &parsed)) {
+        // Round to 16 bits the same way the stream-based conversion does.
+        HexFloat<FloatProxy<float>> full_val(parsed);
+        HexFloat<FloatProxy<spvutils::Float16>> half_val(0);
+        full_val.castTo(half_val, round_direction::kToZero);
+        const Float16 half = half_val.value().getAsFloat();
+        if (!Float16::isInfinity(half)) {
+          emit(static_cast<uint32_t>(half.get_value()));
+          return EncodeNumberStatus::kSuccess;
+        }
+      }
+    } break;
+    case 32: {
+      float parsed = 0.0f;
+      if (ParseNumberFast(text, &parsed)) {
+        emit(BitwiseCast<uint32_t>(FloatProxy<float>(parsed)));
+        return EncodeNumberStatus::kSuccess;
+      }
+    } break;
+    case 64: {
+      double parsed = 0.0;
+      if (ParseNumberFast(text, &parsed)) {
+        const uint64_t decoded_val =
+            BitwiseCast<uint64_t>(FloatProxy<double>(parsed));
+        emit(uint32_t(0x00000000ffffffff & decoded_val));
+        emit(uint32_t((0xffffffff00000000 & decoded_val) >> 32));
+        return EncodeNumberStatus::kSuccess;
+      }
+    } break;
+    default:
+      break;
+  }
+
   switch (bit_width) {
     case 16: {
       HexFloat<FloatProxy<spvutils::Float16>> hVal(0);
@@ -193,6 +193,25 @@ bool ParseNumber(const char* text, T* value_pointer) {
   return ok;
 }
 
+// Parses a numeric value from the given text without routing through
+// iostreams. The number should take up the entire string and be within
+// bounds for the target type. On success, returns true and populates the
+// object referenced by |value_pointer|. On failure, returns false and leaves
+// the referenced object untouched.
+//
+// The integer overloads accept decimal and 0x/0X hexadecimal forms, with an
+// optional leading sign on the signed overloads. Octal is not recognized:
+// a leading zero reads as decimal. The floating point overloads accept only
+// plain decimal forms such as "-1.5e3"; hex-float forms ("0x1.8p1") are not
+// handled here and should keep going through ParseNumber, whose stream-based
+// conversion understands them.
+bool ParseNumberFast(const char* text, uint64_t* value_pointer);
+bool ParseNumberFast(const char* text, int64_t* value_pointer);
+bool ParseNumberFast(const char* text, uint32_t* value_pointer);
+bool ParseNumberFast(const char* text, int32_t* value_pointer);
+bool ParseNumberFast(const char* text, float* value_pointer);
+bool ParseNumberFast(const char* text, double* value_pointer);
+
 // Enum to indicate the parsing and encoding status.
 enum class EncodeNumberStatus {
   kSuccess = 0,
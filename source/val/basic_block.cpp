@@ -25,6 +25,10 @@ namespace libspirv {
 BasicBlock::BasicBlock(uint32_t label_id)
     : id_(label_id),
       immediate_dominator_(nullptr),
+      dom_interval_entry_(0),
+      dom_interval_exit_(0),
+      pdom_interval_entry_(0),
+      pdom_interval_exit_(0),
       immediate_post_dominator_(nullptr),
       predecessors_(),
       successors_(),
@@ -53,8 +57,12 @@ BasicBlock* BasicBlock::immediate_post_dominator() {
 }
 
 void BasicBlock::RegisterSuccessors(const vector<BasicBlock*>& next_blocks) {
+  // Predecessor lists are not built here: pushing onto every successor's
+  // predecessor vector as edges stream in reallocates heavily for large
+  // switch fan-outs. Function::RegisterFunctionEnd builds them in bulk once
+  // all edges are known.
+  successors_.reserve(successors_.size() + next_blocks.size());
   for (auto& block : next_blocks) {
-    block->predecessors_.push_back(this);
     successors_.push_back(block);
     if (block->reachable_ == false) block->set_reachable(reachable_);
   }
@@ -66,12 +74,23 @@ void BasicBlock::RegisterBranchInstruction(SpvOp branch_instruction) {
 }
 
 bool BasicBlock::dominates(const BasicBlock& other) const {
+  // When both blocks carry DFS intervals over the dominator tree, dominance
+  // is subtree containment: two integer comparisons instead of a walk up
+  // the other block's immediate-dominator chain.
+  if (dom_interval_exit_ != 0 && other.dom_interval_exit_ != 0) {
+    return dom_interval_entry_ <= other.dom_interval_entry_ &&
+           other.dom_interval_exit_ <= dom_interval_exit_;
+  }
   return (this == &other) ||
          !(other.dom_end() ==
            std::find(other.dom_begin(), other.dom_end(), this));
 }
 
 bool BasicBlock::postdominates(const BasicBlock& other) const {
+  if (pdom_interval_exit_ != 0 && other.pdom_interval_exit_ != 0) {
+    return pdom_interval_entry_ <= other.pdom_interval_entry_ &&
+           other.pdom_interval_exit_ <= pdom_interval_exit_;
+  }
   return (this == &other) ||
          !(other.pdom_end() ==
            std::find(other.pdom_begin(), other.pdom_end(), this));
@@ -82,6 +82,27 @@ class BasicBlock {
       type_.set(type);
   }
 
+  /// Records the DFS entry/exit interval of this block in the dominator
+  /// tree. Numbering starts at 1; blocks left at 0 were not reached by the
+  /// numbering pass and dominance queries on them fall back to walking the
+  /// immediate-dominator chain.
+  void SetDominatorInterval(uint32_t entry, uint32_t exit) {
+    dom_interval_entry_ = entry;
+    dom_interval_exit_ = exit;
+  }
+
+  /// Records the DFS entry/exit interval of this block in the post-dominator
+  /// tree.
+  void SetPostDominatorInterval(uint32_t entry, uint32_t exit) {
+    pdom_interval_entry_ = entry;
+    pdom_interval_exit_ = exit;
+  }
+
+  /// Returns the DFS entry number of this block in the dominator tree, or 0
+  /// if the block was not numbered. Entry numbers are dense, so they double
+  /// as indices into per-function arrays over the numbered blocks.
+  uint32_t dom_interval_entry() const { return dom_interval_entry_; }
+
   /// Sets the immedate dominator of this basic block
   ///
   /// @param[in] dom_block The dominator block
@@ -194,6 +215,16 @@ class BasicBlock {
   /// Pointer to the immediate dominator of the BasicBlock
   BasicBlock* immediate_dominator_;
 
+  /// DFS entry/exit interval of this block in the dominator tree, or 0 if
+  /// the block has not been numbered
+  uint32_t dom_interval_entry_;
+  uint32_t dom_interval_exit_;
+
+  /// DFS entry/exit interval of this block in the post-dominator tree, or 0
+  /// if the block has not been numbered
+  uint32_t pdom_interval_entry_;
+  uint32_t pdom_interval_exit_;
+
   /// Pointer to the immediate dominator of the BasicBlock
   BasicBlock* immediate_post_dominator_;
 
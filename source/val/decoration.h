@@ -15,6 +15,8 @@
 #ifndef LIBSPIRV_VAL_DECORATION_H_
 #define LIBSPIRV_VAL_DECORATION_H_
 
+#include <algorithm>
+#include <cstddef>
 #include <unordered_map>
 #include <vector>
 
@@ -81,6 +83,31 @@ class Decoration {
   int struct_member_index_;
 };
 
+// A read-only view of a contiguous run of Decoration objects. Ranges
+// returned by ValidationState_t point into its decoration pool; they stay
+// valid until the next decoration is registered.
+class DecorationRange {
+ public:
+  DecorationRange() : begin_(nullptr), end_(nullptr) {}
+  DecorationRange(const Decoration* begin, const Decoration* end)
+      : begin_(begin), end_(end) {}
+
+  const Decoration* begin() const { return begin_; }
+  const Decoration* end() const { return end_; }
+  size_t size() const { return static_cast<size_t>(end_ - begin_); }
+  bool empty() const { return begin_ == end_; }
+
+  // A range compares equal to a vector holding the same decorations in the
+  // same order.
+  bool operator==(const std::vector<Decoration>& that) const {
+    return size() == that.size() && std::equal(begin_, end_, that.begin());
+  }
+
+ private:
+  const Decoration* begin_;
+  const Decoration* end_;
+};
+
 }  // namespace libspirv
 
 #endif  /// LIBSPIRV_VAL_DECORATION_H_
@@ -184,10 +184,31 @@ void Function::RegisterFunctionEnd() {
   if (!end_has_been_registered_) {
     end_has_been_registered_ = true;
 
+    BuildPredecessorLists();
     ComputeAugmentedCFG();
   }
 }
 
+void Function::BuildPredecessorLists() {
+  // First sweep: count the exact in-degree of every block, so that each
+  // predecessor vector is sized once and never reallocates.
+  std::unordered_map<BasicBlock*, uint32_t> in_degree;
+  in_degree.reserve(blocks_.size());
+  for (BasicBlock* block : ordered_blocks_) {
+    for (BasicBlock* successor : *block->successors()) ++in_degree[successor];
+  }
+  for (auto& degree : in_degree) {
+    degree.first->predecessors()->reserve(degree.second);
+  }
+  // Second sweep: fill the lists. Walking ordered_blocks_ reproduces the
+  // order in which edges used to be registered, block end by block end.
+  for (BasicBlock* block : ordered_blocks_) {
+    for (BasicBlock* successor : *block->successors()) {
+      successor->predecessors()->push_back(block);
+    }
+  }
+}
+
 size_t Function::block_count() const { return blocks_.size(); }
 
 size_t Function::undefined_block_count() const {
@@ -284,6 +305,105 @@ void Function::ComputeAugmentedCFG() {
     pred_func);
 };
 
+namespace {
+
+// Numbers the (post)dominator tree described by |edges| with DFS entry/exit
+// intervals, making each dominance query in BasicBlock::dominates a pair of
+// integer comparisons instead of a walk up the immediate-dominator chain.
+// |edges| pairs each block with its immediate dominator; the tree root is
+// paired with itself.  Blocks absent from |edges| keep interval 0 and take
+// the chain-walking fallback.  If |preorder| is given, the blocks are
+// appended to it in dominator-tree preorder as they are numbered.
+void NumberDominatorIntervals(const vector<pair<BasicBlock*, BasicBlock*>>& edges,
+                              bool post_dominators,
+                              vector<BasicBlock*>* preorder = nullptr) {
+  std::unordered_map<BasicBlock*, vector<BasicBlock*>> children;
+  BasicBlock* root = nullptr;
+  for (const auto& edge : edges) {
+    if (edge.first == edge.second)
+      root = edge.first;
+    else
+      children[edge.second].push_back(edge.first);
+  }
+  if (root == nullptr) return;
+
+  struct Frame {
+    BasicBlock* block;
+    size_t next_child;
+    uint32_t entry;
+  };
+  uint32_t counter = 0;
+  vector<Frame> stack;
+  stack.push_back({root, 0, ++counter});
+  if (preorder) preorder->push_back(root);
+  while (!stack.empty()) {
+    Frame& frame = stack.back();
+    auto where = children.find(frame.block);
+    if (where != children.end() && frame.next_child < where->second.size()) {
+      BasicBlock* child = where->second[frame.next_child++];
+      stack.push_back({child, 0, ++counter});
+      if (preorder) preorder->push_back(child);
+    } else {
+      // All descendants are numbered; the counter now bounds the subtree.
+      if (post_dominators)
+        frame.block->SetPostDominatorInterval(frame.entry, counter);
+      else
+        frame.block->SetDominatorInterval(frame.entry, counter);
+      stack.pop_back();
+    }
+  }
+}
+
+}  // anonymous namespace
+
+const Function::CfgAnalysis& Function::GetCfgAnalysis() {
+  if (cfg_analysis_computed_) return cfg_analysis_;
+  cfg_analysis_computed_ = true;
+
+  auto ignore_block = [](const BasicBlock*) {};
+  auto ignore_edge = [](const BasicBlock*, const BasicBlock*) {};
+  if (!ordered_blocks_.empty()) {
+    /// calculate dominators
+    auto& postorder = cfg_analysis_.postorder;
+    spvtools::CFA<BasicBlock>::DepthFirstTraversal(
+        first_block(), AugmentedCFGSuccessorsFunction(), ignore_block,
+        [&](const BasicBlock* b) { postorder.push_back(b); }, ignore_edge);
+    auto edges = spvtools::CFA<BasicBlock>::CalculateDominators(
+        postorder, AugmentedCFGPredecessorsFunction());
+    for (auto edge : edges) {
+      edge.first->SetImmediateDominator(edge.second);
+    }
+    vector<BasicBlock*> dom_preorder;
+    NumberDominatorIntervals(edges, /* post_dominators = */ false,
+                             &dom_preorder);
+    LabelConstructs(dom_preorder);
+
+    /// calculate post dominators
+    auto& postdom_postorder = cfg_analysis_.postdom_postorder;
+    spvtools::CFA<BasicBlock>::DepthFirstTraversal(
+        pseudo_exit_block(), AugmentedCFGPredecessorsFunction(), ignore_block,
+        [&](const BasicBlock* b) { postdom_postorder.push_back(b); },
+        ignore_edge);
+    auto postdom_edges = spvtools::CFA<BasicBlock>::CalculateDominators(
+        postdom_postorder, AugmentedCFGSuccessorsFunction());
+    for (auto edge : postdom_edges) {
+      edge.first->SetImmediatePostDominator(edge.second);
+    }
+    NumberDominatorIntervals(postdom_edges, /* post_dominators = */ true);
+
+    /// calculate back edges.
+    auto& back_edges = cfg_analysis_.back_edges;
+    spvtools::CFA<BasicBlock>::DepthFirstTraversal(
+        pseudo_entry_block(),
+        AugmentedCFGSuccessorsFunctionIncludingHeaderToContinueEdge(),
+        ignore_block, ignore_block,
+        [&](const BasicBlock* from, const BasicBlock* to) {
+          back_edges.emplace_back(from->id(), to->id());
+        });
+  }
+  return cfg_analysis_;
+}
+
 Construct& Function::AddConstruct(const Construct& new_construct) {
   cfg_constructs_.push_back(new_construct);
   auto& result = cfg_constructs_.back();
@@ -294,62 +414,93 @@ Construct& Function::AddConstruct(const Construct& new_construct) {
 
 Construct& Function::FindConstructForEntryBlock(const BasicBlock* entry_block,
                                                 ConstructType type) {
-  auto where =
-      entry_block_to_construct_.find(std::make_pair(entry_block, type));
-  assert(where != entry_block_to_construct_.end());
-  auto construct_ptr = (*where).second;
+  auto construct_ptr = GetConstructForEntryBlock(entry_block, type);
   assert(construct_ptr);
   return *construct_ptr;
 }
 
+Construct* Function::GetConstructForEntryBlock(const BasicBlock* entry_block,
+                                               ConstructType type) {
+  auto where =
+      entry_block_to_construct_.find(std::make_pair(entry_block, type));
+  if (where == entry_block_to_construct_.end()) return nullptr;
+  return (*where).second;
+}
+
+void Function::LabelConstructs(const vector<BasicBlock*>& preorder) {
+  // One sweep in dominator-tree preorder: a block's immediate dominator, and
+  // in a structured CFG its merge header and loop header, are labelled before
+  // the block itself, so each label follows from a constant number of array
+  // reads.  The arrays are indexed by the block's DFS entry number in the
+  // dominator tree; slot 0 stands for every unnumbered block, which has no
+  // dominator and sits at depth 0 outside any construct.
+  block_depth_.assign(preorder.size() + 1, 0);
+  innermost_construct_.assign(preorder.size() + 1, nullptr);
+  for (BasicBlock* block : preorder) {
+    const uint32_t slot = block->dom_interval_entry();
+    BasicBlock* idom = block->immediate_dominator();
+    if (!idom || idom == block) {
+      // The tree root has no dominator, so it's at depth 0.
+      continue;
+    }
+    const uint32_t idom_slot = idom->dom_interval_entry();
+    if (block->is_type(kBlockTypeMerge)) {
+      // A merge block leaves the construct it merges: its depth and label are
+      // those of the header block.
+      auto header = merge_block_header_.find(block);
+      assert(header != merge_block_header_.end());
+      const uint32_t header_slot = header->second->dom_interval_entry();
+      block_depth_[slot] = block_depth_[header_slot];
+      innermost_construct_[slot] = innermost_construct_[header_slot];
+    } else if (block->is_type(kBlockTypeContinue)) {
+      // The depth of the continue block entry point is 1 + loop header depth.
+      Construct* continue_construct =
+          GetConstructForEntryBlock(block, ConstructType::kContinue);
+      assert(continue_construct);
+      // Continue construct has only 1 corresponding construct (loop header).
+      Construct* loop_construct =
+          continue_construct->corresponding_constructs()[0];
+      assert(loop_construct);
+      BasicBlock* loop_header = loop_construct->entry_block();
+      // The continue target may be the loop itself (while 1).
+      // In such cases, the depth of the continue block is: 1 + depth of the
+      // loop's dominator block.
+      if (loop_header == block) {
+        block_depth_[slot] = 1 + block_depth_[idom_slot];
+      } else {
+        block_depth_[slot] = 1 + block_depth_[loop_header->dom_interval_entry()];
+      }
+      innermost_construct_[slot] = continue_construct;
+    } else if (idom->is_type(kBlockTypeHeader) || idom->is_type(kBlockTypeLoop)) {
+      // The dominator of the given block is a header block. So, the nesting
+      // depth of this block is: 1 + nesting depth of the header, and the
+      // innermost construct is the one that header opens.
+      block_depth_[slot] = 1 + block_depth_[idom_slot];
+      innermost_construct_[slot] = GetConstructForEntryBlock(
+          idom, idom->is_type(kBlockTypeLoop) ? ConstructType::kLoop
+                                              : ConstructType::kSelection);
+    } else {
+      block_depth_[slot] = block_depth_[idom_slot];
+      innermost_construct_[slot] = innermost_construct_[idom_slot];
+    }
+  }
+}
+
 int Function::GetBlockDepth(BasicBlock* bb) {
   // Guard against nullptr.
   if (!bb) {
     return 0;
   }
-  // Only calculate the depth if it's not already calculated.
-  // This function uses memoization to avoid duplicate CFG depth calculations.
-  if (block_depth_.find(bb) != block_depth_.end()) {
-    return block_depth_[bb];
-  }
+  const uint32_t slot = bb->dom_interval_entry();
+  if (slot >= block_depth_.size()) return 0;
+  return block_depth_[slot];
+}
 
-  BasicBlock* bb_dom = bb->immediate_dominator();
-  if (!bb_dom || bb == bb_dom) {
-    // This block has no dominator, so it's at depth 0.
-    block_depth_[bb] = 0;
-  } else if (bb->is_type(kBlockTypeMerge)) {
-    // If this is a merge block, its depth is equal to the block before
-    // branching.
-    BasicBlock* header = merge_block_header_[bb];
-    assert(header);
-    block_depth_[bb] = GetBlockDepth(header);
-  } else if (bb->is_type(kBlockTypeContinue)) {
-    // The depth of the continue block entry point is 1 + loop header depth.
-    Construct* continue_construct =
-        entry_block_to_construct_[std::make_pair(bb, ConstructType::kContinue)];
-    assert(continue_construct);
-    // Continue construct has only 1 corresponding construct (loop header).
-    Construct* loop_construct =
-        continue_construct->corresponding_constructs()[0];
-    assert(loop_construct);
-    BasicBlock* loop_header = loop_construct->entry_block();
-    // The continue target may be the loop itself (while 1).
-    // In such cases, the depth of the continue block is: 1 + depth of the
-    // loop's dominator block.
-    if (loop_header == bb) {
-      block_depth_[bb] = 1 + GetBlockDepth(bb_dom);
-    } else {
-      block_depth_[bb] = 1 + GetBlockDepth(loop_header);
-    }
-  } else if (bb_dom->is_type(kBlockTypeHeader) ||
-             bb_dom->is_type(kBlockTypeLoop)) {
-    // The dominator of the given block is a header block. So, the nesting
-    // depth of this block is: 1 + nesting depth of the header.
-    block_depth_[bb] = 1 + GetBlockDepth(bb_dom);
-  } else {
-    block_depth_[bb] = GetBlockDepth(bb_dom);
-  }
-  return block_depth_[bb];
+Construct* Function::InnermostConstruct(const BasicBlock* bb) const {
+  if (!bb) return nullptr;
+  const uint32_t slot = bb->dom_interval_entry();
+  if (slot >= innermost_construct_.size()) return nullptr;
+  return innermost_construct_[slot];
 }
 
 }  /// namespace libspirv
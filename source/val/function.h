@@ -184,12 +184,45 @@ class Function {
   /// Returns the block predecessors function for the augmented CFG.
   GetBlocksFunction AugmentedCFGPredecessorsFunction() const;
 
+  /// Cached results of the control flow analyses over the augmented CFG.
+  struct CfgAnalysis {
+    /// Blocks in postorder of a forward traversal from the first block.
+    std::vector<const BasicBlock*> postorder;
+    /// Blocks in postorder of a backward traversal from the pseudo-exit
+    /// block, used for the post-dominator calculation.
+    std::vector<const BasicBlock*> postdom_postorder;
+    /// All back-edges, as (latch block id, loop header id) pairs.
+    std::vector<std::pair<uint32_t, uint32_t>> back_edges;
+  };
+
+  /// Returns the control flow analysis results for this function, computing
+  /// them on the first call and serving the cached results afterwards.  The
+  /// first computation also sets every block's immediate dominator and
+  /// immediate post-dominator, and labels every block with its nesting depth
+  /// and innermost construct, so dominance queries, GetBlockDepth and
+  /// InnermostConstruct are valid once this has returned.  This touches no
+  /// state outside the function, so it may be invoked for different functions
+  /// concurrently.
+  const CfgAnalysis& GetCfgAnalysis();
+
   /// Returns the control flow nesting depth of the given basic block.
   /// This function only works when you have structured control flow.
-  /// This function should only be called after the control flow constructs have
-  /// been identified and dominators have been computed.
+  /// This function should only be called after GetCfgAnalysis has run; it is
+  /// then a single array read.
   int GetBlockDepth(BasicBlock* bb);
 
+  /// Returns the innermost structured construct the given block nests in, or
+  /// nullptr if the block is outside every construct.  Header and merge
+  /// blocks are attributed to the construct enclosing the one they open or
+  /// close, mirroring GetBlockDepth.  Only valid after GetCfgAnalysis has
+  /// run.
+  Construct* InnermostConstruct(const BasicBlock* bb) const;
+
+  /// Returns the construct with the given entry block and type, or nullptr
+  /// if no such construct was registered.
+  Construct* GetConstructForEntryBlock(const BasicBlock* entry_block,
+                                       ConstructType t);
+
   /// Prints a GraphViz digraph of the CFG of the current funciton
   void PrintDotGraph() const;
 
@@ -197,6 +230,11 @@ class Function {
   void PrintBlocks() const;
 
  private:
+  // Builds every block's predecessor list in two linear sweeps over the
+  // registered edges: one to size each list exactly, one to fill it. Called
+  // once from RegisterFunctionEnd, when all edges are known.
+  void BuildPredecessorLists();
+
   // Computes the representation of the augmented CFG.
   // Populates augmented_successors_map_ and augmented_predecessors_map_.
   void ComputeAugmentedCFG();
@@ -206,10 +244,15 @@ class Function {
   Construct& AddConstruct(const Construct& new_construct);
 
   // Returns a reference to the construct corresponding to the given entry
-  // block.
+  // block.  Asserts that the construct exists.
   Construct& FindConstructForEntryBlock(const BasicBlock* entry_block,
                                         ConstructType t);
 
+  // Labels every block with its control flow nesting depth and innermost
+  // construct in one sweep over |preorder|, which lists the blocks in
+  // dominator-tree preorder.  Called from GetCfgAnalysis.
+  void LabelConstructs(const std::vector<BasicBlock*>& preorder);
+
   /// The result id of the OpLabel that defined this block
   uint32_t id_;
 
@@ -304,8 +347,17 @@ class Function {
   /// This map provides the header block for a given merge block.
   std::unordered_map<BasicBlock*, BasicBlock*> merge_block_header_;
 
-  /// Stores the control flow nesting depth of a given basic block
-  std::unordered_map<BasicBlock*, int> block_depth_;
+  /// Control flow nesting depth of every block and the innermost construct
+  /// containing it, indexed by the block's DFS entry number in the dominator
+  /// tree (slot 0 collects the blocks that were never numbered).  Both are
+  /// filled by LabelConstructs in one sweep.
+  std::vector<int> block_depth_;
+  std::vector<Construct*> innermost_construct_;
+
+  /// The cached control flow analysis results, and whether they have been
+  /// computed yet.
+  CfgAnalysis cfg_analysis_;
+  bool cfg_analysis_computed_ = false;
 };
 
 }  /// namespace libspirv
@@ -32,11 +32,16 @@ OPERATOR(==)
 #undef OPERATOR
 
 Instruction::Instruction(const spv_parsed_instruction_t* inst,
+                         const uint32_t* stable_words,
                          Function* defining_function,
                          BasicBlock* defining_block)
-    : words_(inst->words, inst->words + inst->num_words),
+    : own_words_(stable_words
+                     ? std::vector<uint32_t>()
+                     : std::vector<uint32_t>(inst->words,
+                                             inst->words + inst->num_words)),
       operands_(inst->operands, inst->operands + inst->num_operands),
-      inst_({words_.data(), inst->num_words, inst->opcode, inst->ext_inst_type,
+      inst_({stable_words ? stable_words : own_words_.data(),
+             inst->num_words, inst->opcode, inst->ext_inst_type,
              inst->type_id, inst->result_id, operands_.data(),
              inst->num_operands}),
       function_(defining_function),
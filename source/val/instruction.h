@@ -29,11 +29,35 @@ namespace libspirv {
 class BasicBlock;
 class Function;
 
+/// A non-owning view of the words that define an instruction.  Points either
+/// into the module word buffer held by ValidationState_t or into an
+/// instruction's own copy of its words.
+class WordRange {
+ public:
+  WordRange(const uint32_t* begin, const uint32_t* end)
+      : begin_(begin), end_(end) {}
+
+  const uint32_t* begin() const { return begin_; }
+  const uint32_t* end() const { return end_; }
+  size_t size() const { return static_cast<size_t>(end_ - begin_); }
+  bool empty() const { return begin_ == end_; }
+  uint32_t operator[](size_t index) const { return begin_[index]; }
+
+ private:
+  const uint32_t* begin_;
+  const uint32_t* end_;
+};
+
 /// Wraps the spv_parsed_instruction struct along with use and definition of the
 /// instruction's result id
 class Instruction {
  public:
+  /// If \p stable_words is not null it points at this instruction's words in
+  /// a buffer that outlives the Instruction (the module word buffer held by
+  /// ValidationState_t), and the instruction references it instead of
+  /// copying the words.
   explicit Instruction(const spv_parsed_instruction_t* inst,
+                       const uint32_t* stable_words = nullptr,
                        Function* defining_function = nullptr,
                        BasicBlock* defining_block = nullptr);
 
@@ -61,10 +85,12 @@ class Instruction {
   }
 
   /// The word used to define the Instruction
-  uint32_t word(size_t index) const { return words_[index]; }
+  uint32_t word(size_t index) const { return inst_.words[index]; }
 
   /// The words used to define the Instruction
-  const std::vector<uint32_t>& words() const { return words_; }
+  WordRange words() const {
+    return WordRange(inst_.words, inst_.words + inst_.num_words);
+  }
 
   /// The operands of the Instruction
   const std::vector<spv_parsed_operand_t>& operands() const {
@@ -82,11 +108,13 @@ class Instruction {
     const spv_parsed_operand_t& operand = operands_.at(index);
     assert(operand.num_words * 4 >= sizeof(T));
     assert(operand.offset + operand.num_words <= inst_.num_words);
-    return *reinterpret_cast<const T*>(&words_[operand.offset]);
+    return *reinterpret_cast<const T*>(&inst_.words[operand.offset]);
   }
 
  private:
-  const std::vector<uint32_t> words_;
+  /// Copy of the defining words; empty when the instruction references the
+  /// module word buffer instead.  inst_.words points at whichever holds them.
+  const std::vector<uint32_t> own_words_;
   const std::vector<spv_parsed_operand_t> operands_;
   spv_parsed_instruction_t inst_;
 
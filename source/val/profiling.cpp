@@ -0,0 +1,76 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "val/profiling.h"
+
+#ifdef SPIRV_VALIDATOR_PROFILING
+
+#include <sstream>
+
+#include "opcode.h"
+
+namespace libspirv {
+namespace {
+
+void AppendOpcodeCounts(const std::map<uint16_t, uint64_t>& counts,
+                        std::ostringstream* out) {
+  for (const auto& entry : counts) {
+    *out << "  Op" << spvOpcodeString(static_cast<SpvOp>(entry.first)) << ": "
+         << entry.second << "\n";
+  }
+}
+
+}  // anonymous namespace
+
+ValidatorProfile& ValidatorProfile::Instance() {
+  static ValidatorProfile profile;
+  return profile;
+}
+
+void ValidatorProfile::CountOpcode(uint16_t opcode) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++opcode_counts_[opcode];
+}
+
+void ValidatorProfile::CountIdUsageCheck(uint16_t opcode) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++id_usage_counts_[opcode];
+}
+
+void ValidatorProfile::CountCfgNodeVisit() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++cfg_node_visits_;
+}
+
+void ValidatorProfile::Report(const spvtools::MessageConsumer& consumer) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (consumer) {
+    std::ostringstream out;
+    out << "validator profile:\n";
+    out << "instructions validated, by opcode:\n";
+    AppendOpcodeCounts(opcode_counts_, &out);
+    out << "idUsage checks, by opcode:\n";
+    AppendOpcodeCounts(id_usage_counts_, &out);
+    out << "CFG traversal node visits: " << cfg_node_visits_ << "\n";
+    spv_position_t position = {};
+    consumer(SPV_MSG_INFO, "validator", position, out.str().c_str());
+  }
+  opcode_counts_.clear();
+  id_usage_counts_.clear();
+  cfg_node_visits_ = 0;
+}
+
+}  // namespace libspirv
+
+#endif  // SPIRV_VALIDATOR_PROFILING
@@ -0,0 +1,86 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_VAL_PROFILING_H_
+#define LIBSPIRV_VAL_PROFILING_H_
+
+// Lightweight instrumentation for the validator's hot paths.  When the
+// build enables SPIRV_VALIDATOR_PROFILING (cmake -DSPIRV_VALIDATOR_PROFILING=ON)
+// the SPIRV_VALIDATOR_PROFILE_* hooks below count instructions per opcode
+// validated, idUsage check invocations per opcode, and CFG traversal node
+// visits, and the report is dumped through the MessageConsumer when a
+// validation run completes.  In a normal build the hooks expand to nothing,
+// so call sites stay unconditional.
+
+#ifdef SPIRV_VALIDATOR_PROFILING
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+#include "spirv-tools/libspirv.hpp"
+
+namespace libspirv {
+
+// Process-wide counters for the validator.  The counters are shared by
+// every validation run in the process because the CFG traversal in cfa.h
+// has no ValidationState to hang per-run state off; Report() drains them,
+// so back-to-back runs still get per-run numbers when run serially.
+class ValidatorProfile {
+ public:
+  static ValidatorProfile& Instance();
+
+  // Records that the per-instruction validation passes saw |opcode|.
+  void CountOpcode(uint16_t opcode);
+
+  // Records an idUsage::isValid dispatch for |opcode|.
+  void CountIdUsageCheck(uint16_t opcode);
+
+  // Records one node visit in a depth-first CFG traversal.
+  void CountCfgNodeVisit();
+
+  // Formats the counters gathered so far, sends the report to |consumer|
+  // at SPV_MSG_INFO level, then resets the counters.
+  void Report(const spvtools::MessageConsumer& consumer);
+
+ private:
+  ValidatorProfile() : cfg_node_visits_(0) {}
+
+  std::mutex mutex_;
+  std::map<uint16_t, uint64_t> opcode_counts_;
+  std::map<uint16_t, uint64_t> id_usage_counts_;
+  uint64_t cfg_node_visits_;
+};
+
+}  // namespace libspirv
+
+#define SPIRV_VALIDATOR_PROFILE_OPCODE(opcode) \
+  libspirv::ValidatorProfile::Instance().CountOpcode(opcode)
+#define SPIRV_VALIDATOR_PROFILE_ID_USAGE_CHECK(opcode) \
+  libspirv::ValidatorProfile::Instance().CountIdUsageCheck(opcode)
+#define SPIRV_VALIDATOR_PROFILE_CFG_NODE_VISIT() \
+  libspirv::ValidatorProfile::Instance().CountCfgNodeVisit()
+#define SPIRV_VALIDATOR_PROFILE_REPORT(consumer) \
+  libspirv::ValidatorProfile::Instance().Report(consumer)
+
+#else  // !SPIRV_VALIDATOR_PROFILING
+
+#define SPIRV_VALIDATOR_PROFILE_OPCODE(opcode) ((void)0)
+#define SPIRV_VALIDATOR_PROFILE_ID_USAGE_CHECK(opcode) ((void)0)
+#define SPIRV_VALIDATOR_PROFILE_CFG_NODE_VISIT() ((void)0)
+#define SPIRV_VALIDATOR_PROFILE_REPORT(consumer) ((void)0)
+
+#endif  // SPIRV_VALIDATOR_PROFILING
+
+#endif  // LIBSPIRV_VAL_PROFILING_H_
@@ -16,7 +16,15 @@
 
 #include <cassert>
 
+#include <algorithm>
+#include <memory>
+#include <mutex>
+
 #include "opcode.h"
+#include "table.h"
+#include "spirv_constant.h"
+#include "spirv_endian.h"
+#include "spirv_validator_options.h"
 #include "val/basic_block.h"
 #include "val/construct.h"
 #include "val/function.h"
@@ -31,7 +39,17 @@ using std::vector;
 namespace libspirv {
 
 namespace {
-bool IsInstructionInLayoutSection(ModuleLayoutSection layout, SpvOp op) {
+
+// The spec's universal limit on the id bound.  A larger bound is only
+// plausible for a module big enough to actually define that many ids, so
+// setIdBound() uses this as the eager-sizing cap when the module words are
+// not available to derive a tighter one.
+const uint32_t kUniversalIdBoundLimit = 0x3FFFFF;
+
+// Decides whether |op| may appear in layout section |layout|. This is the
+// single source of truth for the layout rules; the hot path answers from the
+// flat table built from it below.
+bool LayoutSectionAdmits(ModuleLayoutSection layout, SpvOp op) {
   // See Section 2.4
   bool out = false;
   // clang-format off
@@ -127,6 +145,88 @@ bool IsInstructionInLayoutSection(ModuleLayoutSection layout, SpvOp op) {
   return out;
 }
 
+// The number of layout sections, for sizing the lookup table below.
+const int kNumLayoutSections = kLayoutFunctionDefinitions + 1;
+// Opcodes below this bound — all of SPIR-V 1.2 — answer from the table;
+// anything above falls back to the switch.
+const uint32_t kLayoutOpcodeBound = 512;
+
+// A flat [section][opcode] table of the layout rules, so the per-instruction
+// layout check is one array load instead of nested switches.
+struct LayoutSectionTable {
+  LayoutSectionTable() {
+    for (int section = 0; section < kNumLayoutSections; ++section) {
+      for (uint32_t op = 0; op < kLayoutOpcodeBound; ++op) {
+        admits[section][op] =
+            LayoutSectionAdmits(static_cast<ModuleLayoutSection>(section),
+                                static_cast<SpvOp>(op));
+      }
+    }
+  }
+  bool admits[kNumLayoutSections][kLayoutOpcodeBound];
+};
+
+bool IsInstructionInLayoutSection(ModuleLayoutSection layout, SpvOp op) {
+  static const LayoutSectionTable table;
+  if (static_cast<uint32_t>(op) < kLayoutOpcodeBound)
+    return table.admits[layout][op];
+  return LayoutSectionAdmits(layout, op);
+}
+
+// Initial bucket count for the unique-type-declaration registry; grows as
+// needed for type-heavy modules.
+const size_t kUniqueTypeInitialBuckets = 64;
+
+// Returns the implication closure of every capability the grammar for |env|
+// knows: the capability itself plus everything it transitively declares in
+// its Capability operand list.  The implications form a small static DAG, so
+// the closures are computed once per environment and registering a
+// capability becomes one set union instead of a recursive walk through the
+// operand table.
+const unordered_map<uint32_t, CapabilitySet>& CapabilityClosures(
+    spv_target_env env) {
+  static std::mutex mutex;
+  static auto* cache = new unordered_map<
+      int, std::unique_ptr<unordered_map<uint32_t, CapabilitySet>>>;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& closures = (*cache)[env];
+  if (closures) return *closures;
+
+  closures.reset(new unordered_map<uint32_t, CapabilitySet>);
+  spv_operand_table operand_table = nullptr;
+  if (spvOperandTableGet(&operand_table, env) != SPV_SUCCESS) return *closures;
+
+  // Index the capability entries by value, then flood each one's
+  // implications through that index.
+  unordered_map<uint32_t, const spv_operand_desc_t*> by_value;
+  for (uint32_t g = 0; g < operand_table->count; ++g) {
+    const spv_operand_desc_group_t& group = operand_table->types[g];
+    if (group.type != SPV_OPERAND_TYPE_CAPABILITY) continue;
+    for (uint32_t i = 0; i < group.count; ++i)
+      by_value.insert({group.entries[i].value, &group.entries[i]});
+  }
+
+  vector<uint32_t> worklist;
+  for (const auto& value_and_entry : by_value) {
+    CapabilitySet& closure = (*closures)[value_and_entry.first];
+    worklist.clear();
+    worklist.push_back(value_and_entry.first);
+    while (!worklist.empty()) {
+      const SpvCapability cap = static_cast<SpvCapability>(worklist.back());
+      worklist.pop_back();
+      if (closure.Contains(cap)) continue;
+      closure.Add(cap);
+      const auto implied = by_value.find(static_cast<uint32_t>(cap));
+      if (implied != by_value.end()) {
+        implied->second->capabilities.ForEach([&worklist](SpvCapability c) {
+          worklist.push_back(static_cast<uint32_t>(c));
+        });
+      }
+    }
+  }
+  return *closures;
+}
+
 }  // anonymous namespace
 
 ValidationState_t::ValidationState_t(const spv_const_context ctx,
@@ -134,17 +234,31 @@ ValidationState_t::ValidationState_t(const spv_const_context ctx,
     : context_(ctx),
       options_(opt),
       instruction_counter_(0),
-      unresolved_forward_ids_{},
+      validation_steps_(0),
+      id_flags_(spvtools::CAllocator<uint8_t>(ctx->allocator)),
+      all_ids_in_bounds_(false),
+      dense_id_limit_(0),
+      overflow_ids_(),
+      unresolved_forward_count_(0),
       operand_names_{},
+      operand_names_scanned_(0),
       current_layout_section_(kLayoutCapabilities),
       module_functions_(),
       module_capabilities_(),
       module_extensions_(),
+      module_words_(spvtools::CAllocator<uint32_t>(ctx->allocator)),
+      module_word_cursor_(0),
       ordered_instructions_(),
       all_definitions_(),
-      global_vars_(),
-      local_vars_(),
+      num_global_vars_(0),
+      num_local_vars_(0),
+      global_var_ids_(),
       struct_nesting_depth_(),
+      decoration_index_stale_(false),
+      type_key_arena_(),
+      unique_type_declarations_(kUniqueTypeInitialBuckets,
+                                TypeKeyHash(&type_key_arena_),
+                                TypeKeyEqual(&type_key_arena_)),
       grammar_(ctx),
       addressing_model_(SpvAddressingModelLogical),
       memory_model_(SpvMemoryModelSimple),
@@ -152,30 +266,103 @@ ValidationState_t::ValidationState_t(const spv_const_context ctx,
   assert(opt && "Validator options may not be Null.");
 }
 
+void ValidationState_t::Reset(const spv_const_context ctx,
+                              const spv_const_validator_options opt) {
+  assert(opt && "Validator options may not be Null.");
+  assert(ctx->target_env == grammar_.target_env() &&
+         "A pooled validation state may only be reused with a context "
+         "targeting the same environment.");
+  context_ = ctx;
+  options_ = opt;
+  instruction_counter_ = 0;
+  validation_steps_ = 0;
+  id_flags_.clear();
+  all_ids_in_bounds_ = false;
+  dense_id_limit_ = 0;
+  overflow_ids_.clear();
+  unresolved_forward_count_ = 0;
+  sampled_image_consumers_.clear();
+  operand_names_.clear();
+  operand_names_scanned_ = 0;
+  current_layout_section_ = kLayoutCapabilities;
+  module_functions_.clear();
+  module_capabilities_ = CapabilitySet();
+  module_extensions_ = ExtensionSet();
+  ordered_instructions_.clear();
+  module_words_.clear();
+  module_word_cursor_ = 0;
+  all_definitions_.clear();
+  entry_points_.clear();
+  entry_point_interfaces_.clear();
+  id_bound_ = 0;
+  num_global_vars_ = 0;
+  num_local_vars_ = 0;
+  global_var_ids_.clear();
+  struct_nesting_depth_.clear();
+  decoration_entries_.clear();
+  decoration_pool_.clear();
+  decoration_starts_.clear();
+  decoration_index_stale_ = false;
+  type_key_arena_.clear();
+  unique_type_declarations_.clear();
+  addressing_model_ = SpvAddressingModelLogical;
+  memory_model_ = SpvMemoryModelSimple;
+  in_function_ = false;
+  features_ = Feature();
+}
+
 spv_result_t ValidationState_t::ForwardDeclareId(uint32_t id) {
-  unresolved_forward_ids_.insert(id);
+  if (SetIdFlag(id, kIdFlagUnresolvedForward)) ++unresolved_forward_count_;
   return SPV_SUCCESS;
 }
 
 spv_result_t ValidationState_t::RemoveIfForwardDeclared(uint32_t id) {
-  unresolved_forward_ids_.erase(id);
+  if (ClearIdFlag(id, kIdFlagUnresolvedForward)) --unresolved_forward_count_;
   return SPV_SUCCESS;
 }
 
 spv_result_t ValidationState_t::RegisterForwardPointer(uint32_t id) {
-  forward_pointer_ids_.insert(id);
+  SetIdFlag(id, kIdFlagForwardPointer);
   return SPV_SUCCESS;
 }
 
 bool ValidationState_t::IsForwardPointer(uint32_t id) const {
-  return (forward_pointer_ids_.find(id) != forward_pointer_ids_.end());
-}
-
-void ValidationState_t::AssignNameToId(uint32_t id, string name) {
-  operand_names_[id] = name;
+  return HasIdFlag(id, kIdFlagForwardPointer);
+}
+
+void ValidationState_t::CollectOperandNames() const {
+  // Incremental: a diagnostic emitted mid-parse scans the instructions seen
+  // so far, and a later one picks up from where the last scan stopped.
+  for (; operand_names_scanned_ < ordered_instructions_.size();
+       ++operand_names_scanned_) {
+    const Instruction& inst = ordered_instructions_[operand_names_scanned_];
+    const SpvOp opcode = inst.opcode();
+    if (opcode != SpvOpName && opcode != SpvOpMemberName) continue;
+    const WordRange words = inst.words();
+    // The name is a nul-terminated literal string; it follows the target id
+    // for OpName and the target id and member index for OpMemberName.
+    const size_t string_index = (opcode == SpvOpName) ? 2 : 3;
+    if (words.size() <= string_index) continue;
+    std::string name;
+    for (size_t i = string_index; i < words.size(); ++i) {
+      const uint32_t word = words[i];
+      bool terminated = false;
+      for (uint32_t shift = 0; shift < 32; shift += 8) {
+        const char c = static_cast<char>((word >> shift) & 0xff);
+        if (c == '\0') {
+          terminated = true;
+          break;
+        }
+        name.push_back(c);
+      }
+      if (terminated) break;
+    }
+    operand_names_[words[1]] = name;
+  }
 }
 
 string ValidationState_t::getIdName(uint32_t id) const {
+  CollectOperandNames();
   std::stringstream out;
   out << id;
   if (operand_names_.find(id) != end(operand_names_)) {
@@ -185,6 +372,7 @@ string ValidationState_t::getIdName(uint32_t id) const {
 }
 
 string ValidationState_t::getIdOrName(uint32_t id) const {
+  CollectOperandNames();
   std::stringstream out;
   if (operand_names_.find(id) != end(operand_names_)) {
     out << operand_names_.at(id);
@@ -195,39 +383,41 @@ string ValidationState_t::getIdOrName(uint32_t id) const {
 }
 
 size_t ValidationState_t::unresolved_forward_id_count() const {
-  return unresolved_forward_ids_.size();
+  return unresolved_forward_count_;
 }
 
 vector<uint32_t> ValidationState_t::UnresolvedForwardIds() const {
-  vector<uint32_t> out(begin(unresolved_forward_ids_),
-                       end(unresolved_forward_ids_));
+  // Only reached when reporting an invalid module, so a scan over the flag
+  // pool is fine.
+  vector<uint32_t> out;
+  out.reserve(unresolved_forward_count_);
+  for (uint32_t id = 0; id < id_flags_.size(); ++id) {
+    if (id_flags_[id] & kIdFlagUnresolvedForward) out.push_back(id);
+  }
+  if (!overflow_ids_.empty()) {
+    for (const auto& overflow : overflow_ids_) {
+      if (overflow.second.flags & kIdFlagUnresolvedForward)
+        out.push_back(overflow.first);
+    }
+    std::sort(out.begin(), out.end());
+  }
   return out;
 }
 
 bool ValidationState_t::IsDefinedId(uint32_t id) const {
-  return all_definitions_.find(id) != end(all_definitions_);
+  return FindDef(id) != nullptr;
 }
 
 const Instruction* ValidationState_t::FindDef(uint32_t id) const {
-  if (all_definitions_.count(id) == 0) {
-    return nullptr;
-  } else {
-    /// We are in a const function, so we cannot use defs.operator[]().
-    /// Luckily we know the key exists, so defs_.at() won't throw an
-    /// exception.
-    return all_definitions_.at(id);
-  }
+  if (IsDenseId(id)) return all_definitions_[id];
+  auto where = overflow_ids_.find(id);
+  return where == overflow_ids_.end() ? nullptr : where->second.definition;
 }
 
 Instruction* ValidationState_t::FindDef(uint32_t id) {
-  if (all_definitions_.count(id) == 0) {
-    return nullptr;
-  } else {
-    /// We are in a const function, so we cannot use defs.operator[]().
-    /// Luckily we know the key exists, so defs_.at() won't throw an
-    /// exception.
-    return all_definitions_.at(id);
-  }
+  if (IsDenseId(id)) return all_definitions_[id];
+  auto where = overflow_ids_.find(id);
+  return where == overflow_ids_.end() ? nullptr : where->second.definition;
 }
 
 // Increments the instruction count. Used for diagnostic
@@ -235,6 +425,12 @@ int ValidationState_t::increment_instruction_count() {
   return instruction_counter_++;
 }
 
+bool ValidationState_t::CountValidationSteps(uint64_t count) {
+  validation_steps_ += count;
+  const uint64_t budget = options_->budget_.max_validation_steps;
+  return budget == 0 || validation_steps_ <= budget;
+}
+
 ModuleLayoutSection ValidationState_t::current_layout_section() const {
   return current_layout_section_;
 }
@@ -272,19 +468,25 @@ bool ValidationState_t::in_block() const {
 }
 
 void ValidationState_t::RegisterCapability(SpvCapability cap) {
-  // Avoid redundant work.  Otherwise the recursion could induce work
-  // quadrdatic in the capability dependency depth. (Ok, not much, but
-  // it's something.)
+  // Repeat declarations are common enough for the early out to matter.
   if (module_capabilities_.Contains(cap)) return;
 
-  module_capabilities_.Add(cap);
-  spv_operand_desc desc;
-  if (SPV_SUCCESS ==
-      grammar_.lookupOperand(SPV_OPERAND_TYPE_CAPABILITY, cap, &desc)) {
-    desc->capabilities.ForEach(
-        [this](SpvCapability c) { RegisterCapability(c); });
+  const auto& closures = CapabilityClosures(context_->target_env);
+  const auto where = closures.find(static_cast<uint32_t>(cap));
+  if (where == closures.end()) {
+    // The grammar doesn't know this capability, so it implies nothing.
+    module_capabilities_.Add(cap);
+    ApplyCapabilityFeatures(cap);
+    return;
   }
+  // The precomputed closure already contains the implied capabilities, so
+  // registration is one union plus the feature flags of the members.
+  module_capabilities_.AddAll(where->second);
+  where->second.ForEach(
+      [this](SpvCapability c) { ApplyCapabilityFeatures(c); });
+}
 
+void ValidationState_t::ApplyCapabilityFeatures(SpvCapability cap) {
   switch (cap) {
     case SpvCapabilityInt16:
       features_.declare_int16_type = true;
@@ -370,17 +572,43 @@ spv_result_t ValidationState_t::RegisterFunctionEnd() {
   return SPV_SUCCESS;
 }
 
+void ValidationState_t::CopyModuleWords(const uint32_t* words,
+                                        size_t num_words,
+                                        spv_endianness_t endian) {
+  assert(ordered_instructions_.empty() &&
+         "Instructions already reference the previous module words.");
+  module_words_.resize(num_words);
+  spvFixWords(words, num_words, endian, module_words_.data());
+  module_word_cursor_ = SPV_INDEX_INSTRUCTION;
+}
+
 void ValidationState_t::RegisterInstruction(
     const spv_parsed_instruction_t& inst) {
+  // Reference the module word buffer when this instruction's words are the
+  // next ones in it; otherwise (no buffer was copied, or the instruction
+  // comes from a delta or streaming buffer that does not line up) the
+  // Instruction keeps its own copy.  The first-word comparison guards
+  // against desynchronization: opcode and word count must match.
+  const uint32_t* stable_words = nullptr;
+  if (module_word_cursor_ + inst.num_words <= module_words_.size() &&
+      module_words_[module_word_cursor_] == inst.words[0]) {
+    stable_words = module_words_.data() + module_word_cursor_;
+    module_word_cursor_ += inst.num_words;
+  }
   if (in_function_body()) {
-    ordered_instructions_.emplace_back(&inst, &current_function(),
+    ordered_instructions_.emplace_back(&inst, stable_words,
+                                       &current_function(),
                                        current_function().current_block());
   } else {
-    ordered_instructions_.emplace_back(&inst, nullptr, nullptr);
+    ordered_instructions_.emplace_back(&inst, stable_words, nullptr, nullptr);
   }
   uint32_t id = ordered_instructions_.back().id();
   if (id) {
-    all_definitions_.insert(make_pair(id, &ordered_instructions_.back()));
+    if (IsDenseId(id)) {
+      all_definitions_[id] = &ordered_instructions_.back();
+    } else {
+      overflow_ids_[id].definition = &ordered_instructions_.back();
+    }
   }
 
   // If the instruction is using an OpTypeSampledImage as an operand, it should
@@ -413,14 +641,142 @@ void ValidationState_t::RegisterSampledImageConsumer(uint32_t sampled_image_id,
   sampled_image_consumers_[sampled_image_id].push_back(consumer_id);
 }
 
+size_t ValidationState_t::EstimateMemoryUsage() const {
+  // Assumed per-node overhead of the unordered containers: one next pointer
+  // and one cached hash per node, plus the bucket array counted separately.
+  const size_t kNodeOverhead = 2 * sizeof(void*);
+  size_t total = sizeof(*this);
+  total += id_flags_.capacity();
+  total += module_words_.capacity() * sizeof(uint32_t);
+  total += all_definitions_.capacity() * sizeof(Instruction*);
+  total += overflow_ids_.size() *
+           (sizeof(std::pair<uint32_t, OverflowIdData>) + kNodeOverhead);
+  total += overflow_ids_.bucket_count() * sizeof(void*);
+  total += entry_points_.capacity() * sizeof(uint32_t);
+  total += entry_point_interfaces_.capacity() * sizeof(std::vector<uint32_t>);
+  for (const auto& interface : entry_point_interfaces_)
+    total += interface.capacity() * sizeof(uint32_t);
+  total += global_var_ids_.capacity() * sizeof(uint32_t);
+  total += struct_nesting_depth_.capacity() * sizeof(uint32_t);
+  total += decoration_entries_.capacity() *
+           sizeof(std::pair<uint32_t, Decoration>);
+  for (const auto& entry : decoration_entries_)
+    total += entry.second.params().capacity() * sizeof(uint32_t);
+  total += decoration_pool_.capacity() * sizeof(Decoration);
+  for (const auto& dec : decoration_pool_)
+    total += dec.params().capacity() * sizeof(uint32_t);
+  total += decoration_starts_.capacity() * sizeof(uint32_t);
+  total += type_key_arena_.capacity() * sizeof(uint32_t);
+  total += unique_type_declarations_.size() *
+               (sizeof(TypeKeyRange) + kNodeOverhead) +
+           unique_type_declarations_.bucket_count() * sizeof(void*);
+  // The deque holds the instructions by value; the operand and use vectors
+  // are their out-of-line storage.  The words themselves live in
+  // module_words_ and are already counted above.
+  total += ordered_instructions_.size() * sizeof(Instruction);
+  for (const auto& inst : ordered_instructions_) {
+    total += inst.operands().capacity() * sizeof(spv_parsed_operand_t);
+    total += inst.uses().capacity() *
+             sizeof(std::pair<const Instruction*, uint32_t>);
+  }
+  for (const auto& consumer : sampled_image_consumers_) {
+    total += sizeof(consumer) + kNodeOverhead +
+             consumer.second.capacity() * sizeof(uint32_t);
+  }
+  total += sampled_image_consumers_.bucket_count() * sizeof(void*);
+  for (const auto& name : operand_names_)
+    total += sizeof(name) + kNodeOverhead + name.second.capacity();
+  total += operand_names_.bucket_count() * sizeof(void*);
+  total += module_functions_.size() * sizeof(Function);
+  for (const auto& function : module_functions_)
+    total += function.ordered_blocks().capacity() * sizeof(BasicBlock*);
+  return total;
+}
+
 uint32_t ValidationState_t::getIdBound() const { return id_bound_; }
 
-void ValidationState_t::setIdBound(const uint32_t bound) { id_bound_ = bound; }
+void ValidationState_t::setIdBound(const uint32_t bound) {
+  id_bound_ = bound;
+  // Valid ids are dense and smaller than the bound, so the id-indexed
+  // containers are sized once up front instead of hashing on every lookup.
+  // The header bound alone is not trusted, though: a module a few dozen
+  // bytes long can claim a bound near 2^32, and sizing to it would be an
+  // allocation bomb before any instruction is validated.  A module of N
+  // words cannot mention more than N distinct ids, so the dense storage
+  // stops there (or at the universal id bound limit when the module words
+  // are not at hand, as in the delta and streaming paths); the rare ids
+  // beyond the cap live in overflow_ids_ instead.
+  uint64_t dense = bound;
+  if (!module_words_.empty()) {
+    if (dense > module_words_.size()) dense = module_words_.size();
+  } else if (dense > kUniversalIdBoundLimit) {
+    dense = kUniversalIdBoundLimit;
+  }
+  dense_id_limit_ = static_cast<uint32_t>(dense);
+  all_definitions_.resize(dense_id_limit_, nullptr);
+  struct_nesting_depth_.resize(dense_id_limit_, 0u);
+  id_flags_.resize(dense_id_limit_, 0u);
+  ReserveModuleStorage();
+}
+
+void ValidationState_t::ReserveModuleStorage() {
+  const size_t num_words = module_words_.size();
+  if (num_words == 0) return;
+  // Real modules average about four words per instruction, so words/4 is a
+  // close upper-end estimate of the instruction count.  The fractions below
+  // reflect how much of a typical module each instruction kind makes up;
+  // they only set capacities, so a module that defies them merely grows.
+  const size_t est_instructions = num_words / 4 + 1;
+  // Result-id-carrying instructions are additionally bounded by the id
+  // bound, which counts every id in the module exactly once.
+  const size_t max_result_ids =
+      id_bound_ ? std::min<size_t>(id_bound_ - 1, est_instructions)
+                : est_instructions;
+  // Annotations commonly account for a quarter of a shader's instructions.
+  decoration_entries_.reserve(est_instructions / 4 + 1);
+  // Give the type-deduplication set an eighth of the result ids, and its
+  // key arena four words per type, the typical declaration size.
+  const size_t est_types = max_result_ids / 8 + 1;
+  unique_type_declarations_.reserve(est_types);
+  type_key_arena_.reserve(est_types * 4);
+  global_var_ids_.reserve(max_result_ids / 16 + 1);
+}
+
+void ValidationState_t::BuildDecorationIndex() {
+  const size_t num_entries = decoration_entries_.size();
+  uint32_t max_id = 0;
+  for (const auto& entry : decoration_entries_) {
+    if (entry.first > max_id) max_id = entry.first;
+  }
+  // Counting pass: size each id's run, then turn the counts into offsets.
+  decoration_starts_.assign(max_id + 2, 0u);
+  for (const auto& entry : decoration_entries_) {
+    ++decoration_starts_[entry.first + 1];
+  }
+  for (size_t id = 1; id < decoration_starts_.size(); ++id) {
+    decoration_starts_[id] += decoration_starts_[id - 1];
+  }
+  // Scatter pass: place each entry in its id's run, keeping registration
+  // order within the run. Decoration has no default constructor, so compute
+  // the slot-to-entry permutation first and fill the pool by appending.
+  std::vector<uint32_t> cursor(decoration_starts_.begin(),
+                               decoration_starts_.end() - 1);
+  std::vector<size_t> entry_of_slot(num_entries);
+  for (size_t index = 0; index < num_entries; ++index) {
+    entry_of_slot[cursor[decoration_entries_[index].first]++] = index;
+  }
+  decoration_pool_.clear();
+  decoration_pool_.reserve(num_entries);
+  for (size_t slot = 0; slot < num_entries; ++slot) {
+    decoration_pool_.push_back(decoration_entries_[entry_of_slot[slot]].second);
+  }
+  decoration_index_stale_ = false;
+}
 
 bool ValidationState_t::RegisterUniqueTypeDeclaration(
     const spv_parsed_instruction_t& inst) {
-  std::vector<uint32_t> key;
-  key.push_back(static_cast<uint32_t>(inst.opcode));
+  const uint32_t begin = static_cast<uint32_t>(type_key_arena_.size());
+  type_key_arena_.push_back(static_cast<uint32_t>(inst.opcode));
   for (int index = 0; index < inst.num_operands; ++index) {
     const spv_parsed_operand_t& operand = inst.operands[index];
 
@@ -430,9 +786,17 @@ bool ValidationState_t::RegisterUniqueTypeDeclaration(
     const int words_end = words_begin + operand.num_words;
     assert(words_end <= static_cast<int>(inst.num_words));
 
-    key.insert(key.end(), inst.words + words_begin, inst.words + words_end);
+    type_key_arena_.insert(type_key_arena_.end(), inst.words + words_begin,
+                           inst.words + words_end);
   }
 
-  return unique_type_declarations_.insert(std::move(key)).second;
+  const TypeKeyRange key = {
+      begin, static_cast<uint32_t>(type_key_arena_.size()) - begin};
+  const bool inserted = unique_type_declarations_.insert(key).second;
+  if (!inserted) {
+    // Duplicated declaration: discard the key appended for it.
+    type_key_arena_.resize(begin);
+  }
+  return inserted;
 }
 }  /// namespace libspirv
@@ -15,13 +15,15 @@
 #ifndef LIBSPIRV_VAL_VALIDATIONSTATE_H_
 #define LIBSPIRV_VAL_VALIDATIONSTATE_H_
 
+#include <algorithm>
 #include <deque>
-#include <set>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include "allocator.h"
 #include "assembly_grammar.h"
 #include "decoration.h"
 #include "diagnostic.h"
@@ -73,9 +75,27 @@ class ValidationState_t {
   ValidationState_t(const spv_const_context context,
                     const spv_const_validator_options opt);
 
+  /// Clears all module state accumulated by a previous validation while
+  /// keeping container capacity, so this instance can validate another
+  /// module without reallocating its machinery. |context| must target the
+  /// same environment as the one this state was constructed with, since the
+  /// grammar tables are retained. |opt| must be a valid options object.
+  void Reset(const spv_const_context context,
+             const spv_const_validator_options opt);
+
   /// Returns the context
   spv_const_context context() const { return context_; }
 
+  /// Replaces the context and returns the previous one. The pipelined
+  /// validation path temporarily points the state at a context whose
+  /// consumer buffers messages emitted on the check thread; the grammar
+  /// tables of the replacement must match the original's.
+  spv_const_context ReplaceContext(spv_const_context context) {
+    const spv_const_context previous = context_;
+    context_ = context;
+    return previous;
+  }
+
   /// Returns the command line options
   spv_const_validator_options options() const { return options_; }
 
@@ -91,9 +111,6 @@ class ValidationState_t {
   /// Returns whether or not an ID is a forward pointer
   bool IsForwardPointer(uint32_t id) const;
 
-  /// Assigns a name to an ID
-  void AssignNameToId(uint32_t id, std::string name);
-
   /// Returns a string representation of the ID in the format <id>[Name] where
   /// the <id> is the numeric valid of the id and the Name is a name assigned by
   /// the OpName instruction
@@ -105,6 +122,22 @@ class ValidationState_t {
   /// Mutator function for ID bound.
   void setIdBound(uint32_t bound);
 
+  /// Returns true when every id-typed operand word registered so far has
+  /// been range-checked against the header id bound, so the id-indexed
+  /// lookups may skip their per-access range tests.
+  bool all_ids_in_bounds() const { return all_ids_in_bounds_; }
+
+  /// Records whether id operands are pre-validated against the id bound.
+  /// Only enable this when every instruction fed to this state first goes
+  /// through a sweep that rejects out-of-bound id words.
+  void set_all_ids_in_bounds(bool value) { all_ids_in_bounds_ = value; }
+
+  /// Returns true when the dense id-indexed containers cover every id below
+  /// the header bound.  set_all_ids_in_bounds(true) additionally requires
+  /// this, since the fast path indexes them without range tests; an
+  /// oversized header bound leaves some ids in overflow storage instead.
+  bool IdStorageCoversBound() const { return dense_id_limit_ >= id_bound_; }
+
   /// Like getIdName but does not display the id if the \p id has a name
   std::string getIdOrName(uint32_t id) const;
 
@@ -121,6 +154,10 @@ class ValidationState_t {
   /// Increments the instruction count. Used for diagnostic
   int increment_instruction_count();
 
+  /// Counts |count| units of validation work against the step budget in the
+  /// validator options.  Returns false once the budget is exhausted.
+  bool CountValidationSteps(uint64_t count);
+
   /// Returns the current layout section which is being processed
   ModuleLayoutSection current_layout_section() const;
 
@@ -149,7 +186,7 @@ class ValidationState_t {
   /// Registers the given <id> as an Entry Point.
   void RegisterEntryPointId(const uint32_t id) {
     entry_points_.push_back(id);
-    entry_point_interfaces_.insert(std::make_pair(id, std::vector<uint32_t>()));
+    entry_point_interfaces_.push_back(std::vector<uint32_t>());
   }
 
   /// Returns a list of entry point function ids
@@ -158,24 +195,25 @@ class ValidationState_t {
   /// Adds a new interface id to the interfaces of the given entry point.
   void RegisterInterfaceForEntryPoint(uint32_t entry_point,
                                       uint32_t interface) {
-    entry_point_interfaces_[entry_point].push_back(interface);
+    entry_point_interfaces_.at(EntryPointIndex(entry_point))
+        .push_back(interface);
   }
 
   /// Returns the interfaces of a given entry point. If the given id is not a
   /// valid Entry Point id, std::out_of_range exception is thrown.
   const std::vector<uint32_t>& entry_point_interfaces(
       uint32_t entry_point) const {
-    return entry_point_interfaces_.at(entry_point);
+    return entry_point_interfaces_.at(EntryPointIndex(entry_point));
   }
 
   /// Inserts an <id> to the set of functions that are target of OpFunctionCall.
   void AddFunctionCallTarget(const uint32_t id) {
-    function_call_targets_.insert(id);
+    SetIdFlag(id, kIdFlagFunctionCallTarget);
   }
 
   /// Returns whether or not a function<id> is the target of OpFunctionCall.
-  bool IsFunctionCallTarget(const uint32_t id) {
-    return (function_call_targets_.find(id) != function_call_targets_.end());
+  bool IsFunctionCallTarget(const uint32_t id) const {
+    return HasIdFlag(id, kIdFlagFunctionCallTarget);
   }
 
   /// Registers the capability and its dependent capabilities
@@ -225,38 +263,57 @@ class ValidationState_t {
 
   const AssemblyGrammar& grammar() const { return grammar_; }
 
+  /// Copies the endian-fixed module words so that registered instructions
+  /// can reference them instead of holding per-instruction copies.  Must be
+  /// called before the parse whose instructions will be registered; callers
+  /// that feed instructions from short-lived buffers (delta and streaming
+  /// validation) simply skip it and get copying instructions.
+  void CopyModuleWords(const uint32_t* words, size_t num_words,
+                       spv_endianness_t endian);
+
   /// Registers the instruction
   void RegisterInstruction(const spv_parsed_instruction_t& inst);
 
   /// Registers the decoration for the given <id>
   void RegisterDecorationForId(uint32_t id, const Decoration& dec) {
-    id_decorations_[id].push_back(dec);
+    decoration_entries_.push_back(std::make_pair(id, dec));
+    decoration_index_stale_ = true;
   }
 
   /// Registers the list of decorations for the given <id>
   template <class InputIt>
   void RegisterDecorationsForId(uint32_t id, InputIt begin, InputIt end) {
-    std::vector<Decoration>& cur_decs = id_decorations_[id];
-    cur_decs.insert(cur_decs.end(), begin, end);
+    for (InputIt iter = begin; iter != end; ++iter) {
+      decoration_entries_.push_back(std::make_pair(id, *iter));
+    }
+    decoration_index_stale_ = true;
   }
 
   /// Registers the list of decorations for the given member of the given
-  /// structure.
+  /// structure. The registered copies carry the member index; decorations
+  /// already attached to the structure are not modified.
   template <class InputIt>
   void RegisterDecorationsForStructMember(uint32_t struct_id,
                                           uint32_t member_index, InputIt begin,
                                           InputIt end) {
-    RegisterDecorationsForId(struct_id, begin, end);
-    for (auto& decoration : id_decorations_[struct_id]) {
-      decoration.set_struct_member_index(member_index);
+    for (InputIt iter = begin; iter != end; ++iter) {
+      Decoration dec = *iter;
+      dec.set_struct_member_index(member_index);
+      decoration_entries_.push_back(std::make_pair(struct_id, dec));
     }
+    decoration_index_stale_ = true;
   }
 
   /// Returns all the decorations for the given <id>. If no decorations exist
-  /// for the <id>, it registers an empty vector for it in the map and
-  /// returns the empty vector.
-  std::vector<Decoration>& id_decorations(uint32_t id) {
-    return id_decorations_[id];
+  /// for the <id>, returns an empty range. The range points into the shared
+  /// decoration pool, which is regrouped on the first query after a
+  /// registration; registering another decoration invalidates it.
+  DecorationRange id_decorations(uint32_t id) {
+    if (decoration_index_stale_) BuildDecorationIndex();
+    if (id + 1 >= decoration_starts_.size()) return DecorationRange();
+    const Decoration* pool = decoration_pool_.data();
+    return DecorationRange(pool + decoration_starts_[id],
+                           pool + decoration_starts_[id + 1]);
   }
 
   /// Finds id's def, if it exists.  If found, returns the definition otherwise
@@ -272,11 +329,20 @@ class ValidationState_t {
     return ordered_instructions_;
   }
 
-  /// Returns a map of instructions mapped by their result id
-  const std::unordered_map<uint32_t, Instruction*>& all_definitions() const {
+  /// Returns the instructions with a result id, indexed by that id. Slots
+  /// for ids without a definition hold nullptr.
+  const std::vector<Instruction*>& all_definitions() const {
     return all_definitions_;
   }
 
+  /// Returns an estimate in bytes of the memory retained by this state: the
+  /// object itself, the module word copy, the instruction deque and each
+  /// instruction's operand and use vectors, the id-indexed tables, and the
+  /// decoration and type-uniqueness stores.  Node overhead of the unordered
+  /// containers is approximated, so treat the result as a floor rather than
+  /// an exact footprint.
+  size_t EstimateMemoryUsage() const;
+
   /// Returns a vector containing the Ids of instructions that consume the given
   /// SampledImage id.
   std::vector<uint32_t> getSampledImageConsumers(uint32_t id) const;
@@ -285,42 +351,53 @@ class ValidationState_t {
   void RegisterSampledImageConsumer(uint32_t sampled_image_id,
                                     uint32_t cons_id);
 
-  /// Returns the set of Global Variables.
-  std::unordered_set<uint32_t>& global_vars() { return global_vars_; }
-
-  /// Returns the set of Local Variables.
-  std::unordered_set<uint32_t>& local_vars() { return local_vars_; }
+  /// Returns the ids of the Global Variables, in registration order.
+  const std::vector<uint32_t>& global_vars() const { return global_var_ids_; }
 
   /// Returns the number of Global Variables.
-  size_t num_global_vars() { return global_vars_.size(); }
+  size_t num_global_vars() const { return num_global_vars_; }
 
   /// Returns the number of Local Variables.
-  size_t num_local_vars() { return local_vars_.size(); }
+  size_t num_local_vars() const { return num_local_vars_; }
 
   /// Inserts a new <id> to the set of Global Variables.
-  void registerGlobalVariable(const uint32_t id) { global_vars_.insert(id); }
+  void registerGlobalVariable(const uint32_t id) {
+    if (SetIdFlag(id, kIdFlagGlobalVar)) {
+      ++num_global_vars_;
+      global_var_ids_.push_back(id);
+    }
+  }
 
   /// Inserts a new <id> to the set of Local Variables.
-  void registerLocalVariable(const uint32_t id) { local_vars_.insert(id); }
+  void registerLocalVariable(const uint32_t id) {
+    if (SetIdFlag(id, kIdFlagLocalVar)) ++num_local_vars_;
+  }
 
   /// Sets the struct nesting depth for a given struct ID
   void set_struct_nesting_depth(uint32_t id, uint32_t depth) {
-    struct_nesting_depth_[id] = depth;
+    if (IsDenseId(id)) {
+      struct_nesting_depth_[id] = depth;
+    } else {
+      overflow_ids_[id].struct_nesting_depth = depth;
+    }
   }
 
   /// Returns the nesting depth of a given structure ID
   uint32_t struct_nesting_depth(uint32_t id) {
-    return struct_nesting_depth_[id];
+    if (IsDenseId(id)) return struct_nesting_depth_[id];
+    auto where = overflow_ids_.find(id);
+    return where == overflow_ids_.end() ? 0u
+                                        : where->second.struct_nesting_depth;
   }
 
   /// Records that the structure type has a member decorated with a built-in.
   void RegisterStructTypeWithBuiltInMember(uint32_t id) {
-    builtin_structs_.insert(id);
+    SetIdFlag(id, kIdFlagBuiltInStruct);
   }
 
   /// Returns true if the struct type with the given Id has a BuiltIn member.
   bool IsStructTypeWithBuiltInMember(uint32_t id) const {
-    return (builtin_structs_.find(id) != builtin_structs_.end());
+    return HasIdFlag(id, kIdFlagBuiltInStruct);
   }
 
   // Returns the state of optional features.
@@ -333,26 +410,171 @@ class ValidationState_t {
  private:
   ValidationState_t(const ValidationState_t&);
 
-  const spv_const_context context_;
+  /// Turns on the optional features enabled by the given capability.
+  void ApplyCapabilityFeatures(SpvCapability cap);
+
+  /// Returns the index of the given id in entry_points_, or the number of
+  /// entry points if the id is not a registered entry point. Modules declare
+  /// few entry points, so a linear scan suffices.
+  size_t EntryPointIndex(uint32_t entry_point) const {
+    size_t index = 0;
+    while (index < entry_points_.size() && entry_points_[index] != entry_point)
+      ++index;
+    return index;
+  }
+
+  /// Returns true when the given id indexes the dense id-indexed vectors,
+  /// which setIdBound() sizes up to dense_id_limit_.  Ids at or above the
+  /// limit -- possible only when the header claimed a bound larger than the
+  /// module could plausibly use -- live in overflow_ids_ instead, so a
+  /// hostile bound can never force a huge eager allocation.
+  bool IsDenseId(uint32_t id) const {
+    return all_ids_in_bounds_ || id < dense_id_limit_;
+  }
+
+  /// Per-id membership bits kept in id_flags_, one byte per id.  Together
+  /// with the id-indexed vectors above these replace what used to be one
+  /// hash set per property: a membership test is a single indexed load and
+  /// registration allocates nothing once the pool is sized from the
+  /// header's id bound.
+  enum IdFlagBits {
+    kIdFlagGlobalVar = 1 << 0,
+    kIdFlagLocalVar = 1 << 1,
+    kIdFlagBuiltInStruct = 1 << 2,
+    kIdFlagForwardPointer = 1 << 3,
+    kIdFlagFunctionCallTarget = 1 << 4,
+    kIdFlagUnresolvedForward = 1 << 5,
+  };
+
+  /// Sets the given flag for the given id.  Returns true if the flag was
+  /// not set before.
+  bool SetIdFlag(uint32_t id, uint8_t flag) {
+    uint8_t& flags =
+        IsDenseId(id) ? id_flags_[id] : overflow_ids_[id].flags;
+    const bool was_set = (flags & flag) != 0;
+    flags = static_cast<uint8_t>(flags | flag);
+    return !was_set;
+  }
+
+  /// Returns true if the given flag is set for the given id.
+  bool HasIdFlag(uint32_t id, uint8_t flag) const {
+    if (IsDenseId(id)) return (id_flags_[id] & flag) != 0;
+    auto where = overflow_ids_.find(id);
+    return where != overflow_ids_.end() && (where->second.flags & flag) != 0;
+  }
+
+  /// Clears the given flag for the given id.  Returns true if the flag was
+  /// set before.
+  bool ClearIdFlag(uint32_t id, uint8_t flag) {
+    uint8_t* flags = nullptr;
+    if (IsDenseId(id)) {
+      flags = &id_flags_[id];
+    } else {
+      auto where = overflow_ids_.find(id);
+      if (where == overflow_ids_.end()) return false;
+      flags = &where->second.flags;
+    }
+    const bool was_set = (*flags & flag) != 0;
+    *flags = static_cast<uint8_t>(*flags & ~flag);
+    return was_set;
+  }
+
+  /// Regroups decoration_entries_ into decoration_pool_ so that the
+  /// decorations of each <id> occupy one contiguous run, located by
+  /// decoration_starts_.
+  void BuildDecorationIndex();
+
+  /// Reserves the per-instruction containers from capacity estimates derived
+  /// from the module word count and the header id bound, so registration
+  /// during the parse appends without reallocating or rehashing.  Called
+  /// once, when the header's id bound arrives; a no-op when the module words
+  /// were not copied in (delta and streaming validation).
+  void ReserveModuleStorage();
+
+  /// A view of one type-declaration key inside type_key_arena_.
+  struct TypeKeyRange {
+    uint32_t begin;
+    uint32_t length;
+  };
+
+  struct TypeKeyHash {
+    explicit TypeKeyHash(const std::vector<uint32_t>* arena) : arena_(arena) {}
+    size_t operator()(const TypeKeyRange& range) const {
+      uint64_t hash = 0xcbf29ce484222325ull;
+      for (uint32_t i = 0; i < range.length; ++i) {
+        hash = (hash ^ (*arena_)[range.begin + i]) * 0x100000001b3ull;
+      }
+      return static_cast<size_t>(hash);
+    }
+    const std::vector<uint32_t>* arena_;
+  };
+
+  struct TypeKeyEqual {
+    explicit TypeKeyEqual(const std::vector<uint32_t>* arena) : arena_(arena) {}
+    bool operator()(const TypeKeyRange& lhs, const TypeKeyRange& rhs) const {
+      return lhs.length == rhs.length &&
+             std::equal(arena_->begin() + lhs.begin,
+                        arena_->begin() + lhs.begin + lhs.length,
+                        arena_->begin() + rhs.begin);
+    }
+    const std::vector<uint32_t>* arena_;
+  };
+
+  /// Reseated by Reset when this state is pooled across validations.
+  spv_const_context context_;
 
   /// Stores the Validator command line options. Must be a valid options object.
-  const spv_const_validator_options options_;
+  spv_const_validator_options options_;
 
   /// Tracks the number of instructions evaluated by the validator
   int instruction_counter_;
 
-  /// IDs which have been forward declared but have not been defined
-  std::unordered_set<uint32_t> unresolved_forward_ids_;
+  /// Validation work performed so far, compared by CountValidationSteps
+  /// against the step budget in the options.
+  uint64_t validation_steps_;
+
+  /// One flag byte per id, holding IdFlagBits.  Sized from the header's id
+  /// bound along with the other id-indexed containers.  Like module_words_,
+  /// drawn from the allocator of the context the state was created with.
+  std::vector<uint8_t, spvtools::CAllocator<uint8_t>> id_flags_;
+
+  /// True once id operands are guaranteed to be range-checked against the
+  /// header id bound before reaching any lookup; see all_ids_in_bounds().
+  bool all_ids_in_bounds_;
+
+  /// First id value not covered by the dense id-indexed containers.  Set by
+  /// setIdBound() to the header bound capped by what the module could
+  /// plausibly mention; see IsDenseId().
+  uint32_t dense_id_limit_;
+
+  /// State for the rare ids at or above dense_id_limit_.  Value-initialized
+  /// to all zero on first touch.
+  struct OverflowIdData {
+    Instruction* definition;
+    uint32_t struct_nesting_depth;
+    uint8_t flags;
+  };
+  std::unordered_map<uint32_t, OverflowIdData> overflow_ids_;
 
-  /// IDs that have been declared as forward pointers.
-  std::unordered_set<uint32_t> forward_pointer_ids_;
+  /// Number of ids carrying kIdFlagUnresolvedForward.
+  size_t unresolved_forward_count_;
 
   /// Stores a vector of instructions that use the result of a given
   /// OpSampledImage instruction.
   std::unordered_map<uint32_t, std::vector<uint32_t>> sampled_image_consumers_;
 
-  /// A map of operand IDs and their names defined by the OpName instruction
-  std::unordered_map<uint32_t, std::string> operand_names_;
+  /// Scans the OpName and OpMemberName instructions registered since the
+  /// last scan into operand_names_. Only diagnostics need the names, so the
+  /// scan runs on the first name request instead of during the parse; a
+  /// successful validation never allocates name strings.
+  void CollectOperandNames() const;
+
+  /// A map of operand IDs and their names defined by the OpName instruction.
+  /// Filled lazily by CollectOperandNames(), hence mutable.
+  mutable std::unordered_map<uint32_t, std::string> operand_names_;
+
+  /// The number of ordered_instructions_ already scanned for names.
+  mutable size_t operand_names_scanned_;
 
   /// The section of the code being processed
   ModuleLayoutSection current_layout_section_;
@@ -366,44 +588,63 @@ class ValidationState_t {
   /// Extensions declared in the module
   libspirv::ExtensionSet module_extensions_;
 
+  /// Endian-fixed copy of the module words, referenced by the ordered
+  /// instructions.  Never resized while instructions point into it.  As the
+  /// largest scratch buffer, drawn from the allocator of the context the
+  /// state was created with; see spvContextSetAllocator.
+  std::vector<uint32_t, spvtools::CAllocator<uint32_t>> module_words_;
+
+  /// Index into module_words_ of the next instruction to be registered.
+  size_t module_word_cursor_;
+
   /// List of all instructions in the order they appear in the binary
   std::deque<Instruction> ordered_instructions_;
 
-  /// Instructions that can be referenced by Ids
-  std::unordered_map<uint32_t, Instruction*> all_definitions_;
+  /// Instructions that can be referenced by Ids, indexed by result id.
+  /// Sized from the header's id bound; undefined ids map to nullptr.
+  std::vector<Instruction*> all_definitions_;
 
   /// IDs that are entry points, ie, arguments to OpEntryPoint.
   std::vector<uint32_t> entry_points_;
 
-  /// Maps an entry point id to its interfaces.
-  std::unordered_map<uint32_t, std::vector<uint32_t>> entry_point_interfaces_;
-
-  /// Functions IDs that are target of OpFunctionCall.
-  std::unordered_set<uint32_t> function_call_targets_;
+  /// The interfaces of each entry point, parallel to entry_points_.
+  std::vector<std::vector<uint32_t>> entry_point_interfaces_;
 
   /// ID Bound from the Header
   uint32_t id_bound_;
 
-  /// Set of Global Variable IDs (Storage Class other than 'Function')
-  std::unordered_set<uint32_t> global_vars_;
+  /// Numbers of ids carrying kIdFlagGlobalVar and kIdFlagLocalVar.
+  size_t num_global_vars_;
+  size_t num_local_vars_;
+
+  /// Ids of the Global Variables, in registration order, for enumeration.
+  std::vector<uint32_t> global_var_ids_;
 
-  /// Set of Local Variable IDs ('Function' Storage Class)
-  std::unordered_set<uint32_t> local_vars_;
+  /// Structure Nesting Depth, indexed by struct id
+  std::vector<uint32_t> struct_nesting_depth_;
 
-  /// Set of struct types that have members with a BuiltIn decoration.
-  std::unordered_set<uint32_t> builtin_structs_;
+  /// Decorations in the order they were registered, each tagged with the
+  /// target <id>. Registration only appends; queries read the grouped pool.
+  std::vector<std::pair<uint32_t, Decoration>> decoration_entries_;
 
-  /// Structure Nesting Depth
-  std::unordered_map<uint32_t, uint32_t> struct_nesting_depth_;
+  /// One contiguous store of decorations regrouped per <id>: the decorations
+  /// of <id> occupy slots [decoration_starts_[id], decoration_starts_[id+1]).
+  /// Rebuilt from decoration_entries_ by BuildDecorationIndex.
+  std::vector<Decoration> decoration_pool_;
+  std::vector<uint32_t> decoration_starts_;
 
-  /// Stores the list of decorations for a given <id>
-  std::unordered_map<uint32_t, std::vector<Decoration>> id_decorations_;
+  /// Set by registration; cleared when the pool is regrouped.
+  bool decoration_index_stale_;
 
   /// Stores type declarations which need to be unique (i.e. non-aggregates),
-  /// in the form [opcode, operand words], result_id is not stored.
-  /// Using ordered set to avoid the need for a vector hash function.
-  /// The size of this container is expected not to exceed double-digits.
-  std::set<std::vector<uint32_t>> unique_type_declarations_;
+  /// in the form [opcode, operand words], result_id is not stored.  Every
+  /// key is appended to one contiguous arena and the set holds views into
+  /// it, so registering a declaration costs a single hash probe and a
+  /// duplicate allocates nothing.  The hash and equality functors point at
+  /// the arena; this is safe because this class is never copied or moved.
+  std::vector<uint32_t> type_key_arena_;
+  std::unordered_set<TypeKeyRange, TypeKeyHash, TypeKeyEqual>
+      unique_type_declarations_;
 
   AssemblyGrammar grammar_;
 
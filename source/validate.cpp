@@ -18,13 +18,17 @@
 #include <cstdio>
 
 #include <algorithm>
+#include <atomic>
 #include <functional>
 #include <iterator>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "binary.h"
+#include "call_trace.h"
 #include "diagnostic.h"
 #include "enum_string_mapping.h"
 #include "extensions.h"
@@ -35,8 +39,10 @@
 #include "spirv_constant.h"
 #include "spirv_endian.h"
 #include "spirv_validator_options.h"
+#include "tracing.h"
 #include "val/construct.h"
 #include "val/function.h"
+#include "val/profiling.h"
 #include "val/validation_state.h"
 
 using std::function;
@@ -81,6 +87,12 @@ spv_result_t setHeader(void* user_data, spv_endianness_t endian, uint32_t magic,
   // Record the ID bound so that the validator can ensure no ID is out of bound.
   ValidationState_t& _ = *(reinterpret_cast<ValidationState_t*>(user_data));
   _.setIdBound(id_bound);
+  // The sweep at the top of ProcessInstruction rejects any id-typed operand
+  // word at or above the bound before it reaches a pass, so the id-indexed
+  // containers sized above may be indexed without per-lookup range tests --
+  // but only when they cover the whole bound.  An oversized bound leaves
+  // some ids in overflow storage, so the fast path stays off.
+  if (id_bound > 0 && _.IdStorageCoversBound()) _.set_all_ids_in_bounds(true);
 
   (void)endian;
   (void)magic;
@@ -91,35 +103,6 @@ spv_result_t setHeader(void* user_data, spv_endianness_t endian, uint32_t magic,
   return SPV_SUCCESS;
 }
 
-// Improves diagnostic messages by collecting names of IDs
-// NOTE: This function returns void and is not involved in validation
-void DebugInstructionPass(ValidationState_t& _,
-                          const spv_parsed_instruction_t* inst) {
-  switch (inst->opcode) {
-    case SpvOpName: {
-      const uint32_t target = *(inst->words + inst->operands[0].offset);
-      const char* str =
-          reinterpret_cast<const char*>(inst->words + inst->operands[1].offset);
-      _.AssignNameToId(target, str);
-    } break;
-    case SpvOpMemberName: {
-      const uint32_t target = *(inst->words + inst->operands[0].offset);
-      const char* str =
-          reinterpret_cast<const char*>(inst->words + inst->operands[2].offset);
-      _.AssignNameToId(target, str);
-    } break;
-    case SpvOpSourceContinued:
-    case SpvOpSource:
-    case SpvOpSourceExtension:
-    case SpvOpString:
-    case SpvOpLine:
-    case SpvOpNoLine:
-
-    default:
-      break;
-  }
-}
-
 // Parses OpExtension instruction and registers extension.
 void RegisterExtension(ValidationState_t& _,
                        const spv_parsed_instruction_t* inst) {
@@ -154,31 +137,186 @@ spv_result_t ProcessExtensions(
   return SPV_REQUESTED_TERMINATION;
 }
 
+// Registers the extensions declared in the module preamble by scanning the
+// raw word stream, stopping at the first instruction that is neither
+// OpCapability nor OpExtension.  This replaces a full spvBinaryParse of the
+// module: only the instruction framing and the OpExtension string operand
+// are decoded, and framing errors are left for the validation parse that
+// follows to diagnose.
+void RegisterExtensionsRawScan(ValidationState_t& _, const uint32_t* words,
+                               const size_t num_words,
+                               const spv_endianness_t endian) {
+  size_t word_index = SPV_INDEX_INSTRUCTION;
+  while (word_index < num_words) {
+    const uint32_t first_word = spvFixWord(words[word_index], endian);
+    uint16_t inst_word_count = 0;
+    uint16_t opcode = 0;
+    spvOpcodeSplit(first_word, &inst_word_count, &opcode);
+    if (inst_word_count == 0 || word_index + inst_word_count > num_words)
+      return;
+
+    if (opcode == SpvOpExtension) {
+      // The operand is a nul-terminated literal string, one word of it
+      // holding up to four characters starting at the low byte.
+      std::string extension_str;
+      bool terminated = false;
+      for (uint16_t i = 1; i < inst_word_count && !terminated; ++i) {
+        const uint32_t word = spvFixWord(words[word_index + i], endian);
+        for (uint32_t shift = 0; shift < 32; shift += 8) {
+          const char c = static_cast<char>((word >> shift) & 0xff);
+          if (c == '\0') {
+            terminated = true;
+            break;
+          }
+          extension_str.push_back(c);
+        }
+      }
+      Extension extension;
+      // Unrecognized extensions produce their error in the
+      // ProcessInstruction pass.
+      if (GetExtensionFromString(extension_str, &extension))
+        _.RegisterExtension(extension);
+    } else if (opcode != SpvOpCapability) {
+      // According to the SPIR-V spec extensions are declared after
+      // capabilities and before everything else.
+      return;
+    }
+
+    word_index += inst_word_count;
+  }
+}
+
+// Bit per validation stage that only does work for a few opcodes. The
+// per-instruction dispatcher loads one mask per instruction and skips the
+// deselected stages, instead of letting each pass re-dispatch on the opcode
+// only to fall through its default case.
+enum : uint8_t {
+  kStageCapability = 1 << 0,
+  kStageDataRules = 1 << 1,
+  kStageCfg = 1 << 2,
+  kStageTypeUnique = 1 << 3,
+};
+
+// Covers all opcodes in the current specification; opcodes past the bound
+// take the conservative slow path and run every stage.
+const uint32_t kStageOpcodeBound = 512;
+
+struct StageTable {
+  explicit StageTable(bool capability_rules) {
+    for (uint32_t op = 0; op < kStageOpcodeBound; ++op) {
+      const SpvOp opcode = static_cast<SpvOp>(op);
+      uint8_t mask = 0;
+      if (capability_rules && opcode == SpvOpCapability)
+        mask |= kStageCapability;
+      if (libspirv::DataRulesPassHandles(opcode)) mask |= kStageDataRules;
+      if (libspirv::CfgPassHandles(opcode)) mask |= kStageCfg;
+      if (spvOpcodeGeneratesType(opcode)) mask |= kStageTypeUnique;
+      masks[op] = mask;
+    }
+  }
+  uint8_t masks[kStageOpcodeBound];
+};
+
+uint8_t StageMaskFor(spv_target_env env, SpvOp opcode) {
+  // The tables are pruned per target environment: the capability rules are
+  // the only environment-specific per-instruction checks, so environments
+  // without any drop that stage from every mask and never even test the
+  // opcode for it.
+  static const StageTable env_rules_table(/* capability_rules = */ true);
+  static const StageTable no_env_rules_table(/* capability_rules = */ false);
+  const StageTable& table = libspirv::CapabilityPassHasEnvRules(env)
+                                ? env_rules_table
+                                : no_env_rules_table;
+  if (static_cast<uint32_t>(opcode) < kStageOpcodeBound)
+    return table.masks[opcode];
+  return 0xff;
+}
+
 spv_result_t ProcessInstruction(void* user_data,
                                 const spv_parsed_instruction_t* inst) {
   ValidationState_t& _ = *(reinterpret_cast<ValidationState_t*>(user_data));
-  _.increment_instruction_count();
-  if (static_cast<SpvOp>(inst->opcode) == SpvOpEntryPoint) {
-    const auto entry_point = inst->words[2];
-    _.RegisterEntryPointId(entry_point);
-    // Operand 3 and later are the <id> of interfaces for the entry point.
-    for (int i = 3; i < inst->num_operands; ++i) {
-      _.RegisterInterfaceForEntryPoint(entry_point,
-                                       inst->words[inst->operands[i].offset]);
+  const int instruction_index = _.increment_instruction_count();
+  SPIRV_VALIDATOR_PROFILE_OPCODE(inst->opcode);
+
+  // Enforce the work budget, if one was set, before validating anything.
+  const spv_validator_budget_t& budget = _.options()->budget_;
+  if (budget.max_instructions &&
+      static_cast<uint64_t>(instruction_index) >= budget.max_instructions) {
+    return _.diag(SPV_ERROR_EXCEEDED_BUDGET)
+           << "Module contains more than the validation budget of "
+           << budget.max_instructions << " instructions";
+  }
+  if (!_.CountValidationSteps(1)) {
+    return _.diag(SPV_ERROR_EXCEEDED_BUDGET)
+           << "Validation step budget of " << budget.max_validation_steps
+           << " exhausted";
+  }
+
+  // Range-check every id-typed operand word against the header id bound up
+  // front.  The id-indexed containers in the validation state are sized from
+  // the bound, so once an instruction passes this sweep the per-id lookups
+  // downstream index them without range tests of their own.
+  for (unsigned i = 0; i < inst->num_operands; ++i) {
+    const spv_parsed_operand_t& operand = inst->operands[i];
+    if (!spvIsIdType(operand.type)) continue;
+    const uint32_t id = inst->words[operand.offset];
+    if (id >= _.getIdBound()) {
+      return _.diag(SPV_ERROR_INVALID_BINARY)
+             << (operand.type == SPV_OPERAND_TYPE_RESULT_ID ? "Result <id> '"
+                                                            : "ID '")
+             << id << "' must be less than the ID bound '" << _.getIdBound()
+             << "'.";
     }
   }
-  if (static_cast<SpvOp>(inst->opcode) == SpvOpFunctionCall) {
-    _.AddFunctionCallTarget(inst->words[3]);
+
+  switch (static_cast<SpvOp>(inst->opcode)) {
+    case SpvOpEntryPoint: {
+      const auto entry_point = inst->words[2];
+      _.RegisterEntryPointId(entry_point);
+      // Operand 3 and later are the <id> of interfaces for the entry point.
+      for (int i = 3; i < inst->num_operands; ++i) {
+        _.RegisterInterfaceForEntryPoint(entry_point,
+                                         inst->words[inst->operands[i].offset]);
+      }
+      break;
+    }
+    case SpvOpFunctionCall:
+      _.AddFunctionCallTarget(inst->words[3]);
+      break;
+    default:
+      break;
   }
 
-  DebugInstructionPass(_, inst);
-  if (auto error = CapabilityPass(_, inst)) return error;
-  if (auto error = DataRulesPass(_, inst)) return error;
-  if (auto error = IdPass(_, inst)) return error;
-  if (auto error = ModuleLayoutPass(_, inst)) return error;
-  if (auto error = CfgPass(_, inst)) return error;
-  if (auto error = InstructionPass(_, inst)) return error;
-  if (auto error = TypeUniquePass(_, inst)) return error;
+  // Id names for diagnostics are not collected here: ValidationState_t scans
+  // the registered OpName/OpMemberName instructions the first time an error
+  // message asks for a name, so known-good modules never pay for them.
+
+  // Deselected stages cost one mask test each. The layout pass also drives
+  // function and block registration, and the CFG pass builds the block
+  // structures the id dominance checks walk, so both stay on whenever a
+  // stage downstream of them is requested. Stages that only act on a few
+  // opcodes are additionally gated on the per-opcode stage mask, so a
+  // typical instruction runs just the id, layout, and instruction passes.
+  const uint32_t checks = _.options()->checks_;
+  const uint8_t stages =
+      StageMaskFor(_.context()->target_env, static_cast<SpvOp>(inst->opcode));
+  if ((stages & kStageCapability) && (checks & SPV_VALIDATOR_CHECK_CAPABILITIES))
+    if (auto error = CapabilityPass(_, inst)) return error;
+  if ((stages & kStageDataRules) && (checks & SPV_VALIDATOR_CHECK_DATA_RULES))
+    if (auto error = DataRulesPass(_, inst)) return error;
+  if (checks & SPV_VALIDATOR_CHECK_IDS)
+    if (auto error = IdPass(_, inst)) return error;
+  if (checks & (SPV_VALIDATOR_CHECK_LAYOUT | SPV_VALIDATOR_CHECK_CFG |
+                SPV_VALIDATOR_CHECK_IDS))
+    if (auto error = ModuleLayoutPass(_, inst)) return error;
+  if ((stages & kStageCfg) && (checks & (SPV_VALIDATOR_CHECK_CFG |
+                                         SPV_VALIDATOR_CHECK_IDS)))
+    if (auto error = CfgPass(_, inst)) return error;
+  if (checks & SPV_VALIDATOR_CHECK_INSTRUCTIONS) {
+    if (auto error = InstructionPass(_, inst)) return error;
+    if (stages & kStageTypeUnique)
+      if (auto error = TypeUniquePass(_, inst)) return error;
+  }
 
   return SPV_SUCCESS;
 }
@@ -224,48 +362,25 @@ UNUSED(void PrintDotGraph(ValidationState_t& _, libspirv::Function func)) {
     printf("}\n");
   }
 }
-}  // anonymous namespace
-
-spv_result_t spvValidate(const spv_const_context context,
-                         const spv_const_binary binary,
-                         spv_diagnostic* pDiagnostic) {
-  return spvValidateBinary(context, binary->code, binary->wordCount,
-                           pDiagnostic);
-}
-
-spv_result_t ValidateBinaryUsingContextAndValidationState(
-    const spv_context_t& context, const uint32_t* words, const size_t num_words,
-    spv_diagnostic* pDiagnostic, ValidationState_t* vstate) {
-  spv_const_binary binary = new spv_const_binary_t{words, num_words};
-
-  spv_endianness_t endian;
-  spv_position_t position = {};
-  if (spvBinaryEndianness(binary, &endian)) {
-    return libspirv::DiagnosticStream(position, context.consumer,
-                                      SPV_ERROR_INVALID_BINARY)
-           << "Invalid SPIR-V magic number.";
-  }
-
-  spv_header_t header;
-  if (spvBinaryHeaderGet(binary, endian, &header)) {
-    return libspirv::DiagnosticStream(position, context.consumer,
-                                      SPV_ERROR_INVALID_BINARY)
-           << "Invalid SPIR-V header.";
-  }
 
-  // Look for OpExtension instructions and register extensions.
-  // Diagnostics if any will be produced in the next pass (ProcessInstruction).
-  spvBinaryParse(&context, vstate, words, num_words,
-                 /* parsed_header = */ nullptr, ProcessExtensions,
-                 /* diagnostic = */ nullptr);
+// Runs the validation checks that need the fully parsed module: layout of
+// the module tail, forward references, CFG, id use, decorations and entry
+// points.  Assumes the per-instruction passes have already run over every
+// instruction in |words|.  The id checks only cover instructions starting at
+// word index |id_check_start|; callers validating a whole module pass
+// SPV_INDEX_INSTRUCTION, while incremental callers pass the index of the
+// first instruction that has not been id-checked before.
+spv_result_t ValidateParsedModule(const spv_context_t& context,
+                                  const uint32_t* words,
+                                  const size_t num_words,
+                                  const spv_endianness_t endian,
+                                  const size_t id_check_start,
+                                  ValidationState_t* vstate) {
+  const uint32_t checks = vstate->options()->checks_;
 
-  // NOTE: Parse the module and perform inline validation checks. These
-  // checks do not require the the knowledge of the whole module.
-  if (auto error = spvBinaryParse(&context, vstate, words, num_words,
-                                  setHeader, ProcessInstruction, pDiagnostic))
-    return error;
-
-  if (vstate->in_function_body())
+  if ((checks & (SPV_VALIDATOR_CHECK_LAYOUT | SPV_VALIDATOR_CHECK_CFG |
+                 SPV_VALIDATOR_CHECK_IDS)) &&
+      vstate->in_function_body())
     return vstate->diag(SPV_ERROR_INVALID_LAYOUT)
            << "Missing OpFunctionEnd at end of module.";
 
@@ -287,10 +402,19 @@ spv_result_t ValidateBinaryUsingContextAndValidationState(
 
   // CFG checks are performed after the binary has been parsed
   // and the CFGPass has collected information about the control flow
-  if (auto error = PerformCfgChecks(*vstate)) return error;
-  if (auto error = UpdateIdUse(*vstate)) return error;
-  if (auto error = CheckIdDefinitionDominateUse(*vstate)) return error;
-  if (auto error = ValidateDecorations(*vstate))  return error;
+  if (checks & (SPV_VALIDATOR_CHECK_CFG | SPV_VALIDATOR_CHECK_IDS)) {
+    SPIRV_TRACE_SCOPE("validate/cfg");
+    if (auto error = PerformCfgChecks(*vstate)) return error;
+  }
+  if (checks & SPV_VALIDATOR_CHECK_IDS) {
+    SPIRV_TRACE_SCOPE("validate/id-use");
+    if (auto error = UpdateIdUse(*vstate)) return error;
+    if (auto error = CheckIdDefinitionDominateUse(*vstate)) return error;
+  }
+  if (checks & SPV_VALIDATOR_CHECK_DECORATIONS) {
+    SPIRV_TRACE_SCOPE("validate/decorations");
+    if (auto error = ValidateDecorations(*vstate)) return error;
+  }
 
   // Entry point validation. Based on 2.16.1 (Universal Validation Rules) of the
   // SPIRV spec:
@@ -298,36 +422,42 @@ spv_result_t ValidateBinaryUsingContextAndValidationState(
   // capability is being used.
   // * No function can be targeted by both an OpEntryPoint instruction and an
   // OpFunctionCall instruction.
-  if (vstate->entry_points().empty() &&
-      !vstate->HasCapability(SpvCapabilityLinkage)) {
-    return vstate->diag(SPV_ERROR_INVALID_BINARY)
-           << "No OpEntryPoint instruction was found. This is only allowed if "
-              "the Linkage capability is being used.";
-  }
-  for (const auto& entry_point : vstate->entry_points()) {
-    if (vstate->IsFunctionCallTarget(entry_point)) {
+  if (checks & SPV_VALIDATOR_CHECK_LAYOUT) {
+    if (vstate->entry_points().empty() &&
+        !vstate->HasCapability(SpvCapabilityLinkage)) {
       return vstate->diag(SPV_ERROR_INVALID_BINARY)
-             << "A function (" << entry_point
-             << ") may not be targeted by both an OpEntryPoint instruction and "
-                "an OpFunctionCall instruction.";
+             << "No OpEntryPoint instruction was found. This is only allowed "
+                "if the Linkage capability is being used.";
+    }
+    for (const auto& entry_point : vstate->entry_points()) {
+      if (vstate->IsFunctionCallTarget(entry_point)) {
+        return vstate->diag(SPV_ERROR_INVALID_BINARY)
+               << "A function (" << entry_point
+               << ") may not be targeted by both an OpEntryPoint instruction "
+                  "and an OpFunctionCall instruction.";
+      }
     }
   }
 
+  if (!(checks & SPV_VALIDATOR_CHECK_IDS)) return SPV_SUCCESS;
+
+  SPIRV_TRACE_SCOPE("validate/ids");
+
   // NOTE: Copy each instruction for easier processing
   std::vector<spv_instruction_t> instructions;
-  uint64_t index = SPV_INDEX_INSTRUCTION;
-  while (index < binary->wordCount) {
+  uint64_t index = id_check_start;
+  while (index < num_words) {
     uint16_t wordCount;
     uint16_t opcode;
-    spvOpcodeSplit(spvFixWord(binary->code[index], endian), &wordCount,
-                   &opcode);
+    spvOpcodeSplit(spvFixWord(words[index], endian), &wordCount, &opcode);
     spv_instruction_t inst;
-    spvInstructionCopy(&binary->code[index], static_cast<SpvOp>(opcode),
-                       wordCount, endian, &inst);
+    spvInstructionCopy(&words[index], static_cast<SpvOp>(opcode), wordCount,
+                       endian, &inst);
     instructions.push_back(inst);
     index += wordCount;
   }
 
+  spv_position_t position = {};
   position.index = SPV_INDEX_INSTRUCTION;
   return spvValidateIDs(instructions.data(), instructions.size(),
                         context.opcode_table,
@@ -335,9 +465,375 @@ spv_result_t ValidateBinaryUsingContextAndValidationState(
                         context.ext_inst_table, *vstate, &position);
 }
 
+// Computes the validation cache key for the given binary: a 64-bit FNV-1a
+// hash over the binary words, folded with the target environment and every
+// validator limit, so a hit guarantees an identical validation outcome.
+uint64_t ComputeValidationCacheKey(spv_target_env env,
+                                   spv_const_validator_options options,
+                                   const uint32_t* words, size_t num_words) {
+  const uint64_t kPrime = 0x100000001b3;
+  uint64_t hash = 0xcbf29ce484222325;
+  const auto mix = [&hash, kPrime](uint32_t value) {
+    hash = (hash ^ value) * kPrime;
+  };
+  mix(static_cast<uint32_t>(env));
+  mix(options->checks_);
+  const validator_universal_limits_t& limits = options->universal_limits_;
+  mix(limits.max_struct_members);
+  mix(limits.max_struct_depth);
+  mix(limits.max_local_variables);
+  mix(limits.max_global_variables);
+  mix(limits.max_switch_branches);
+  mix(limits.max_function_args);
+  mix(limits.max_control_flow_nesting_depth);
+  mix(limits.max_access_chain_indexes);
+  mix(static_cast<uint32_t>(num_words));
+  for (size_t i = 0; i < num_words; ++i) mix(words[i]);
+  return hash;
+}
+}  // anonymous namespace
+
+spv_result_t spvValidate(const spv_const_context context,
+                         const spv_const_binary binary,
+                         spv_diagnostic* pDiagnostic) {
+  return spvValidateBinary(context, binary->code, binary->wordCount,
+                           pDiagnostic);
+}
+
+namespace {
+
+// Bundles the validation state with an optional second parse sink, so the
+// single spvBinaryParse in ValidateBinaryInternal can feed the validator
+// and another in-memory representation at once.
+struct ForwardingParseData {
+  ValidationState_t* vstate;
+  spv_parsed_header_fn_t forward_header;
+  spv_parsed_instruction_fn_t forward_instruction;
+  void* forward_user_data;
+};
+
+spv_result_t ForwardingSetHeader(void* user_data, spv_endianness_t endian,
+                                 uint32_t magic, uint32_t version,
+                                 uint32_t generator, uint32_t id_bound,
+                                 uint32_t reserved) {
+  auto* data = static_cast<ForwardingParseData*>(user_data);
+  if (auto error = setHeader(data->vstate, endian, magic, version, generator,
+                             id_bound, reserved))
+    return error;
+  if (data->forward_header)
+    return data->forward_header(data->forward_user_data, endian, magic,
+                                version, generator, id_bound, reserved);
+  return SPV_SUCCESS;
+}
+
+spv_result_t ForwardingProcessInstruction(void* user_data,
+                                          const spv_parsed_instruction_t* inst) {
+  auto* data = static_cast<ForwardingParseData*>(user_data);
+  if (auto error = ProcessInstruction(data->vstate, inst)) return error;
+  if (data->forward_instruction)
+    return data->forward_instruction(data->forward_user_data, inst);
+  return SPV_SUCCESS;
+}
+
+// Deep copies of a run of parsed instructions, flattened into three arrays
+// so a batch recycles its storage between trips through the ring below.
+struct ParsedInstructionBatch {
+  struct Entry {
+    // The words and operands pointers are rebased onto the batch arrays
+    // when the entry is consumed; the parser reuses its own storage.
+    spv_parsed_instruction_t inst;
+    size_t words_offset;
+    size_t operands_offset;
+  };
+  std::vector<uint32_t> words;
+  std::vector<spv_parsed_operand_t> operands;
+  std::vector<Entry> entries;
+
+  void clear() {
+    words.clear();
+    operands.clear();
+    entries.clear();
+  }
+};
+
+// Runs the per-instruction validation passes on a dedicated thread, fed
+// parsed instructions through a bounded lock-free single-producer
+// single-consumer ring of batches.  The decode inside spvBinaryParse and
+// the checks in ProcessInstruction then overlap even when the module is one
+// enormous function and the per-function parallelism of the whole-module
+// checks has nothing to split.  The validation state is only ever touched
+// from the check thread; the decode thread just copies parsed operands.
+class PipelinedChecker {
+ public:
+  explicit PipelinedChecker(ValidationState_t* vstate)
+      : vstate_(vstate),
+        buffered_context_(*vstate->context()),
+        original_context_(nullptr),
+        head_(0),
+        tail_(0),
+        error_(SPV_SUCCESS),
+        input_complete_(false),
+        batch_open_(false) {
+    // The checks report through the state's consumer, which for the C API
+    // writes the caller's spv_diagnostic — the same object spvBinaryParse
+    // may write on the decode thread.  Point the state at a context that
+    // only buffers messages; Finish() replays them through the real
+    // consumer once the threads have joined, so the caller's consumer is
+    // never invoked concurrently.
+    buffered_context_.consumer = [this](spv_message_level_t level,
+                                        const char* source,
+                                        const spv_position_t& position,
+                                        const char* message) {
+      std::lock_guard<std::mutex> lock(message_mutex_);
+      messages_.push_back(
+          {level, source ? source : "", position, message ? message : ""});
+    };
+    original_context_ = vstate_->ReplaceContext(&buffered_context_);
+    checker_ = std::thread(&PipelinedChecker::Check, this);
+  }
+
+  ~PipelinedChecker() {
+    // Finish() already joined in the normal flow; this covers early exits.
+    if (checker_.joinable()) {
+      input_complete_.store(true, std::memory_order_release);
+      checker_.join();
+    }
+    if (original_context_ != nullptr) {
+      vstate_->ReplaceContext(original_context_);
+    }
+  }
+
+  ValidationState_t* vstate() { return vstate_; }
+
+  // Appends a deep copy of |inst| to the current batch, publishing the
+  // batch once it is full.  Called on the decode thread.  A pending error
+  // from the check thread is returned instead, which aborts the parse.
+  spv_result_t Add(const spv_parsed_instruction_t* inst) {
+    const spv_result_t error =
+        static_cast<spv_result_t>(error_.load(std::memory_order_acquire));
+    if (error != SPV_SUCCESS) return error;
+
+    ParsedInstructionBatch& batch = ClaimSlot();
+    ParsedInstructionBatch::Entry entry;
+    entry.inst = *inst;
+    entry.words_offset = batch.words.size();
+    entry.operands_offset = batch.operands.size();
+    batch.words.insert(batch.words.end(), inst->words,
+                       inst->words + inst->num_words);
+    batch.operands.insert(batch.operands.end(), inst->operands,
+                          inst->operands + inst->num_operands);
+    batch.entries.push_back(entry);
+    if (batch.entries.size() >= kBatchInstructions) Publish();
+    return SPV_SUCCESS;
+  }
+
+  // Publishes any partial batch, waits for the check thread to drain the
+  // ring, replays the buffered messages, and returns the first error the
+  // check thread reported, if any.
+  spv_result_t Finish() {
+    if (batch_open_) Publish();
+    input_complete_.store(true, std::memory_order_release);
+    checker_.join();
+    // Both threads are done, so the caller's consumer is safe to invoke
+    // again.  A check error arrives here after any parse diagnostic, which
+    // is the order the caller expects: the check error belongs to an
+    // earlier instruction and supersedes the parse result.
+    const spv_const_context context = original_context_;
+    original_context_ = nullptr;
+    vstate_->ReplaceContext(context);
+    if (context->consumer) {
+      for (const auto& m : messages_) {
+        context->consumer(m.level, m.source.c_str(), m.position,
+                          m.message.c_str());
+      }
+    }
+    messages_.clear();
+    return static_cast<spv_result_t>(error_.load(std::memory_order_relaxed));
+  }
+
+ private:
+  // Instructions per batch; amortizes the ring handshake without letting
+  // the check thread fall an entire module behind.
+  static const size_t kBatchInstructions = 256;
+  // Ring slots; must be a power of two.
+  static const uint64_t kRingSize = 8;
+  static const uint64_t kRingMask = kRingSize - 1;
+
+  // Returns the batch under construction, waiting for the check thread to
+  // free its slot when the ring is full.
+  ParsedInstructionBatch& ClaimSlot() {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    if (!batch_open_) {
+      while (head - tail_.load(std::memory_order_acquire) >= kRingSize)
+        std::this_thread::yield();
+      batch_open_ = true;
+    }
+    return ring_[head & kRingMask];
+  }
+
+  // Hands the batch under construction to the check thread.
+  void Publish() {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    head_.store(head + 1, std::memory_order_release);
+    batch_open_ = false;
+  }
+
+  // Body of the check thread: runs the per-instruction passes over each
+  // published batch in order.  After an error the remaining batches are
+  // still drained (so the decode thread never blocks on a full ring) but
+  // their instructions are not processed.
+  void Check() {
+    uint64_t tail = 0;
+    for (;;) {
+      while (head_.load(std::memory_order_acquire) == tail) {
+        if (input_complete_.load(std::memory_order_acquire) &&
+            head_.load(std::memory_order_acquire) == tail)
+          return;
+        std::this_thread::yield();
+      }
+      ParsedInstructionBatch& batch = ring_[tail & kRingMask];
+      if (error_.load(std::memory_order_relaxed) == SPV_SUCCESS) {
+        for (const auto& entry : batch.entries) {
+          spv_parsed_instruction_t inst = entry.inst;
+          inst.words = batch.words.data() + entry.words_offset;
+          inst.operands = batch.operands.data() + entry.operands_offset;
+          const spv_result_t result = ProcessInstruction(vstate_, &inst);
+          if (result != SPV_SUCCESS) {
+            error_.store(result, std::memory_order_release);
+            break;
+          }
+        }
+      }
+      batch.clear();
+      tail_.store(tail + 1, std::memory_order_release);
+      ++tail;
+    }
+  }
+
+  // One message captured by the buffering consumer, to be replayed through
+  // the caller's consumer after the join.
+  struct BufferedMessage {
+    spv_message_level_t level;
+    std::string source;
+    spv_position_t position;
+    std::string message;
+  };
+
+  ValidationState_t* vstate_;
+  // A copy of the caller's context whose consumer buffers into |messages_|.
+  // The state points at it between construction and Finish().
+  spv_context_t buffered_context_;
+  spv_const_context original_context_;
+  // Guards |messages_|: the check thread buffers instruction diagnostics
+  // while the decode thread may buffer a header diagnostic.
+  std::mutex message_mutex_;
+  std::vector<BufferedMessage> messages_;
+  ParsedInstructionBatch ring_[kRingSize];
+  std::atomic<uint64_t> head_;  // Next slot the decode thread publishes.
+  std::atomic<uint64_t> tail_;  // Next slot the check thread consumes.
+  std::atomic<int> error_;
+  std::atomic<bool> input_complete_;
+  bool batch_open_;  // Only touched by the decode thread.
+  std::thread checker_;
+};
+
+spv_result_t PipelinedSetHeader(void* user_data, spv_endianness_t endian,
+                                uint32_t magic, uint32_t version,
+                                uint32_t generator, uint32_t id_bound,
+                                uint32_t reserved) {
+  return setHeader(static_cast<PipelinedChecker*>(user_data)->vstate(), endian,
+                   magic, version, generator, id_bound, reserved);
+}
+
+spv_result_t PipelinedAddInstruction(void* user_data,
+                                     const spv_parsed_instruction_t* inst) {
+  return static_cast<PipelinedChecker*>(user_data)->Add(inst);
+}
+
+// Performs the complete validation of the |words| binary against |vstate|,
+// forwarding the header and each parsed instruction to the given callbacks
+// (either of which may be null) during the single decode.
+spv_result_t ValidateBinaryInternal(
+    const spv_context_t& context, const uint32_t* words,
+    const size_t num_words, spv_diagnostic* pDiagnostic,
+    ValidationState_t* vstate, spv_parsed_header_fn_t forward_header,
+    spv_parsed_instruction_fn_t forward_instruction, void* forward_user_data) {
+  SPIRV_TRACE_SCOPE("validate");
+  // The decode below reuses spvBinaryParse; without this the call recorder
+  // would log it as a second, caller-issued parse.
+  libspirv::CallTraceSuppressor suppress_call_trace;
+  spv_const_binary_t binary{words, num_words};
+
+  spv_endianness_t endian;
+  spv_position_t position = {};
+  if (spvBinaryEndianness(&binary, &endian)) {
+    return libspirv::DiagnosticStream(position, context.consumer,
+                                      SPV_ERROR_INVALID_BINARY)
+           << "Invalid SPIR-V magic number.";
+  }
+
+  spv_header_t header;
+  if (spvBinaryHeaderGet(&binary, endian, &header)) {
+    return libspirv::DiagnosticStream(position, context.consumer,
+                                      SPV_ERROR_INVALID_BINARY)
+           << "Invalid SPIR-V header.";
+  }
+
+  // Look for OpExtension instructions and register extensions.  Capability
+  // validation consults them, and OpExtension instructions come later in the
+  // module than OpCapability, so they must be registered before the main
+  // parse below.  A raw scan of the preamble keeps this from costing a
+  // second full decode of the module.
+  RegisterExtensionsRawScan(*vstate, words, num_words, endian);
+
+  // Keep one endian-fixed copy of the module alive in the validation state;
+  // the instructions registered during the parse below reference it instead
+  // of copying their words.
+  vstate->CopyModuleWords(words, num_words, endian);
+
+  // NOTE: Parse the module and perform inline validation checks. These
+  // checks do not require the the knowledge of the whole module.
+  if (vstate->options()->pipelined_checks_ && !forward_header &&
+      !forward_instruction) {
+    // Decode and check overlap as producer and consumer.  Forwarding
+    // callers expect their callbacks synchronously with the parse, so they
+    // keep the sequential path below.
+    PipelinedChecker checker(vstate);
+    const spv_result_t parse_result =
+        spvBinaryParse(&context, &checker, words, num_words, PipelinedSetHeader,
+                       PipelinedAddInstruction, pDiagnostic);
+    // A check failure surfaced after the parse moved on supersedes the
+    // parse result: it belongs to an earlier instruction.
+    if (auto error = checker.Finish()) return error;
+    if (parse_result != SPV_SUCCESS) return parse_result;
+  } else {
+    ForwardingParseData parse_data = {vstate, forward_header,
+                                      forward_instruction, forward_user_data};
+    if (auto error = spvBinaryParse(&context, &parse_data, words, num_words,
+                                    ForwardingSetHeader,
+                                    ForwardingProcessInstruction, pDiagnostic))
+      return error;
+  }
+
+  const spv_result_t result = ValidateParsedModule(
+      context, words, num_words, endian, SPV_INDEX_INSTRUCTION, vstate);
+  SPIRV_VALIDATOR_PROFILE_REPORT(context.consumer);
+  return result;
+}
+
+}  // anonymous namespace
+
+spv_result_t ValidateBinaryUsingContextAndValidationState(
+    const spv_context_t& context, const uint32_t* words, const size_t num_words,
+    spv_diagnostic* pDiagnostic, ValidationState_t* vstate) {
+  return ValidateBinaryInternal(context, words, num_words, pDiagnostic, vstate,
+                                nullptr, nullptr, nullptr);
+}
+
 spv_result_t spvValidateBinary(const spv_const_context context,
                                const uint32_t* words, const size_t num_words,
                                spv_diagnostic* pDiagnostic) {
+  libspirv::CallTraceValidate(context->target_env, nullptr, words, num_words);
   spv_context_t hijack_context = *context;
   if (pDiagnostic) {
     *pDiagnostic = nullptr;
@@ -361,17 +857,36 @@ spv_result_t spvValidateWithOptions(const spv_const_context context,
                                     spv_const_validator_options options,
                                     const spv_const_binary binary,
                                     spv_diagnostic* pDiagnostic) {
+  libspirv::CallTraceValidate(context->target_env, options, binary->code,
+                              binary->wordCount);
   spv_context_t hijack_context = *context;
   if (pDiagnostic) {
     *pDiagnostic = nullptr;
     libspirv::UseDiagnosticAsMessageConsumer(&hijack_context, pDiagnostic);
   }
 
+  // Consult the validation cache, if the caller plugged one in.
+  spv_validation_cache_t* cache =
+      options ? options->validation_cache_ : nullptr;
+  uint64_t cache_key = 0;
+  if (cache) {
+    cache_key = ComputeValidationCacheKey(context->target_env, options,
+                                          binary->code, binary->wordCount);
+    if (cache->lookup && cache->lookup(cache->user_data, cache_key))
+      return SPV_SUCCESS;
+  }
+
   // Create the ValidationState using the context.
   ValidationState_t vstate(&hijack_context, options);
 
-  return ValidateBinaryUsingContextAndValidationState(
+  const spv_result_t result = ValidateBinaryUsingContextAndValidationState(
       hijack_context, binary->code, binary->wordCount, pDiagnostic, &vstate);
+
+  // Only clean validations are recorded; failures are typically followed by
+  // a fix and would otherwise pollute persistent stores.
+  if (result == SPV_SUCCESS && cache && cache->insert)
+    cache->insert(cache->user_data, cache_key);
+  return result;
 }
 
 namespace spvtools {
@@ -397,4 +912,128 @@ spv_result_t ValidateInstructionAndUpdateValidationState(
   return ProcessInstruction(vstate, inst);
 }
 
+spv_result_t ValidateBinaryAndForwardParse(
+    const spv_const_context context, spv_const_validator_options options,
+    const uint32_t* words, const size_t num_words, spv_diagnostic* pDiagnostic,
+    std::unique_ptr<ValidationState_t>* vstate,
+    spv_parsed_header_fn_t forward_header,
+    spv_parsed_instruction_fn_t forward_instruction, void* forward_user_data) {
+  spv_context_t hijack_context = *context;
+  if (pDiagnostic) {
+    *pDiagnostic = nullptr;
+    libspirv::UseDiagnosticAsMessageConsumer(&hijack_context, pDiagnostic);
+  }
+
+  vstate->reset(new ValidationState_t(&hijack_context, options));
+
+  return ValidateBinaryInternal(hijack_context, words, num_words, pDiagnostic,
+                                vstate->get(), forward_header,
+                                forward_instruction, forward_user_data);
+}
+
+spv_result_t ValidateBinaryDelta(const spv_const_context context,
+                                 const uint32_t* words, const size_t num_words,
+                                 const size_t baseline_num_words,
+                                 spv_diagnostic* pDiagnostic,
+                                 ValidationState_t* vstate) {
+  spv_context_t hijack_context = *context;
+  if (pDiagnostic) {
+    *pDiagnostic = nullptr;
+    libspirv::UseDiagnosticAsMessageConsumer(&hijack_context, pDiagnostic);
+  }
+
+  spv_position_t position = {};
+  if (baseline_num_words < SPV_INDEX_INSTRUCTION ||
+      baseline_num_words > num_words) {
+    return libspirv::DiagnosticStream(position, hijack_context.consumer,
+                                      SPV_ERROR_INVALID_BINARY)
+           << "Baseline word count does not lie within the binary.";
+  }
+
+  spv_const_binary_t binary{words, num_words};
+  spv_endianness_t endian;
+  if (spvBinaryEndianness(&binary, &endian)) {
+    return libspirv::DiagnosticStream(position, hijack_context.consumer,
+                                      SPV_ERROR_INVALID_BINARY)
+           << "Invalid SPIR-V magic number.";
+  }
+
+  // Parse a synthetic binary made of the patched header followed by only the
+  // appended instructions.  The header refreshes the id bound, which a patch
+  // may raise, and the per-instruction passes run against the retained
+  // state, whose module layout position is already inside the
+  // function-definition section.
+  std::vector<uint32_t> delta_binary(words, words + SPV_INDEX_INSTRUCTION);
+  delta_binary.insert(delta_binary.end(), words + baseline_num_words,
+                      words + num_words);
+  if (auto error =
+          spvBinaryParse(&hijack_context, vstate, delta_binary.data(),
+                         delta_binary.size(), setHeader, ProcessInstruction,
+                         pDiagnostic))
+    return error;
+
+  // The whole-module checks must still see the updated state, but the id
+  // checks only walk the appended instructions.
+  return ValidateParsedModule(hijack_context, words, num_words, endian,
+                              baseline_num_words, vstate);
+}
+
+StreamingValidator::StreamingValidator(spv_const_context context,
+                                       spv_const_validator_options options,
+                                       spv_diagnostic* pDiagnostic)
+    : hijack_context_(*context), extensions_scanned_(false),
+      status_(SPV_SUCCESS) {
+  if (pDiagnostic) {
+    *pDiagnostic = nullptr;
+    libspirv::UseDiagnosticAsMessageConsumer(&hijack_context_, pDiagnostic);
+  }
+  vstate_.reset(new ValidationState_t(&hijack_context_, options));
+  extension_parser_.reset(new libspirv::StreamingBinaryParser(
+      &hijack_context_, vstate_.get(), /* parsed_header = */ nullptr,
+      ProcessExtensions));
+  instruction_parser_.reset(new libspirv::StreamingBinaryParser(
+      &hijack_context_, vstate_.get(), setHeader, ProcessInstruction));
+}
+
+StreamingValidator::~StreamingValidator() {}
+
+spv_result_t StreamingValidator::ProcessBufferedWords(bool input_complete) {
+  // The extension scan must reach the end of the OpCapability/OpExtension
+  // block before the main pass starts.  The scan requests termination at the
+  // first instruction past that block; parse errors, if any, are left for
+  // the main pass to diagnose, as in the batch path.
+  if (!extensions_scanned_) {
+    const spv_result_t scan_result = extension_parser_->Parse(
+        words_.data(), words_.size(), input_complete);
+    if (scan_result == SPV_SUCCESS && !input_complete)
+      return SPV_SUCCESS;  // Still inside the block; wait for more words.
+    extensions_scanned_ = true;
+  }
+  return instruction_parser_->Parse(words_.data(), words_.size(),
+                                    input_complete);
+}
+
+spv_result_t StreamingValidator::Feed(const uint32_t* words,
+                                      size_t num_words) {
+  if (status_ != SPV_SUCCESS) return status_;
+  words_.insert(words_.end(), words, words + num_words);
+  status_ = ProcessBufferedWords(/* input_complete = */ false);
+  return status_;
+}
+
+spv_result_t StreamingValidator::Finish() {
+  if (status_ != SPV_SUCCESS) return status_;
+  status_ = ProcessBufferedWords(/* input_complete = */ true);
+  if (status_ != SPV_SUCCESS) return status_;
+
+  // The parse above checked the magic number, so this cannot fail.
+  spv_const_binary_t binary{words_.data(), words_.size()};
+  spv_endianness_t endian;
+  spvBinaryEndianness(&binary, &endian);
+
+  status_ = ValidateParsedModule(hijack_context_, words_.data(), words_.size(),
+                                 endian, SPV_INDEX_INSTRUCTION, vstate_.get());
+  return status_;
+}
+
 }  // namespace spvtools
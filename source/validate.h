@@ -16,9 +16,11 @@
 #define LIBSPIRV_VALIDATE_H_
 
 #include <functional>
+#include <memory>
 #include <utility>
 #include <vector>
 
+#include "binary.h"
 #include "instruction.h"
 #include "message.h"
 #include "spirv-tools/libspirv.h"
@@ -89,6 +91,10 @@ spv_result_t ModuleLayoutPass(ValidationState_t& _,
 spv_result_t CfgPass(ValidationState_t& _,
                      const spv_parsed_instruction_t* inst);
 
+/// Returns true if CfgPass does any work for the given opcode. Lets the
+/// per-instruction dispatcher skip the pass for everything else.
+bool CfgPassHandles(SpvOp opcode);
+
 /// Performs Id and SSA validation of a module
 spv_result_t IdPass(ValidationState_t& _, const spv_parsed_instruction_t* inst);
 
@@ -98,6 +104,9 @@ spv_result_t IdPass(ValidationState_t& _, const spv_parsed_instruction_t* inst);
 spv_result_t DataRulesPass(ValidationState_t& _,
                            const spv_parsed_instruction_t* inst);
 
+/// Returns true if DataRulesPass does any work for the given opcode.
+bool DataRulesPassHandles(SpvOp opcode);
+
 /// Performs instruction validation.
 spv_result_t InstructionPass(ValidationState_t& _,
                              const spv_parsed_instruction_t* inst);
@@ -116,6 +125,11 @@ spv_result_t TypeUniquePass(ValidationState_t& _,
 spv_result_t CapabilityPass(ValidationState_t& _,
                             const spv_parsed_instruction_t* inst);
 
+/// Returns true if CapabilityPass has any rules for the given target
+/// environment. Environments without rules can drop the pass from their
+/// per-instruction dispatch entirely.
+bool CapabilityPassHasEnvRules(spv_target_env env);
+
 }  // namespace libspirv
 
 /// @brief Validate the ID usage of the instruction stream
@@ -155,6 +169,13 @@ spv_result_t spvValidateIDs(const spv_instruction_t* pInstructions,
                             spv_position position,
                             const spvtools::MessageConsumer& consumer);
 
+// Performs the complete validation of the |words| binary using an already
+// constructed validation state, which the caller owns and may pool across
+// calls (see ValidationState_t::Reset).
+spv_result_t ValidateBinaryUsingContextAndValidationState(
+    const spv_context_t& context, const uint32_t* words, const size_t num_words,
+    spv_diagnostic* pDiagnostic, libspirv::ValidationState_t* vstate);
+
 namespace spvtools {
 // Performs validation for the SPIRV-V module binary.
 // The main difference between this API and spvValidateBinary is that the
@@ -170,6 +191,91 @@ spv_result_t ValidateBinaryAndKeepValidationState(
 spv_result_t ValidateInstructionAndUpdateValidationState(
     libspirv::ValidationState_t* vstate, const spv_parsed_instruction_t* inst);
 
+// Validates the |words| binary like ValidateBinaryAndKeepValidationState,
+// but additionally forwards the module header and every parsed instruction
+// to the given callbacks during the single decode.  This lets a caller
+// build a second in-memory representation (e.g. the optimizer's IR) from
+// the same parse that validation uses, instead of decoding the binary
+// twice.  Each forwarding callback runs after the corresponding
+// per-instruction validation step, so it only sees instructions that passed
+// those checks; the whole-module checks run after the parse as usual.
+// Either callback may be null.
+spv_result_t ValidateBinaryAndForwardParse(
+    const spv_const_context context, spv_const_validator_options options,
+    const uint32_t* words, const size_t num_words, spv_diagnostic* pDiagnostic,
+    std::unique_ptr<libspirv::ValidationState_t>* vstate,
+    spv_parsed_header_fn_t forward_header,
+    spv_parsed_instruction_fn_t forward_instruction, void* forward_user_data);
+
+// Incrementally validates a module that has grown since a baseline run.
+// |words|/|num_words| describe the complete patched binary, whose first
+// |baseline_num_words| words must be the module previously validated into
+// |vstate| by ValidateBinaryAndKeepValidationState; the appended words must
+// start at a function-definition boundary.  The per-instruction and id
+// checks run only over the appended instructions, then the whole-module
+// checks (CFG, id dominance, decorations, entry points) run over the updated
+// state.  The patched header may carry a raised id bound.  |vstate| is
+// updated in place, so a failed delta leaves it unsuitable for further
+// incremental runs.
+spv_result_t ValidateBinaryDelta(const spv_const_context context,
+                                 const uint32_t* words, const size_t num_words,
+                                 const size_t baseline_num_words,
+                                 spv_diagnostic* pDiagnostic,
+                                 libspirv::ValidationState_t* vstate);
+
+// Validates a SPIR-V module that arrives in chunks, e.g. over the network.
+// The per-instruction checks run as soon as each instruction's words have
+// arrived, so a malformed module is rejected without waiting for the rest of
+// the transfer; the checks that need the whole module (CFG, id use,
+// decorations, entry points) run in Finish.  Typical use:
+//
+//   StreamingValidator validator(context, options, &diagnostic);
+//   while (another chunk of words arrives)
+//     if (validator.Feed(chunk, chunk_num_words)) break;
+//   spv_result_t result = validator.Finish();
+//
+// The context and options must outlive the validator.
+class StreamingValidator {
+ public:
+  // If |pDiagnostic| is not null, diagnostics are recorded there as they are
+  // produced, as with spvValidateBinary; it must stay valid for the lifetime
+  // of this object.
+  StreamingValidator(spv_const_context context,
+                     spv_const_validator_options options,
+                     spv_diagnostic* pDiagnostic);
+  ~StreamingValidator();
+
+  StreamingValidator(const StreamingValidator&) = delete;
+  StreamingValidator& operator=(const StreamingValidator&) = delete;
+
+  // Appends |num_words| words of the module and validates every instruction
+  // that is now complete.  Returns SPV_SUCCESS or the first error
+  // encountered; after an error, further calls return that same error.
+  spv_result_t Feed(const uint32_t* words, size_t num_words);
+
+  // Declares the end of the module, validates any remaining instructions and
+  // runs the whole-module checks.  Returns the final validation result.
+  spv_result_t Finish();
+
+ private:
+  // Runs the parsers over the words buffered so far.
+  spv_result_t ProcessBufferedWords(bool input_complete);
+
+  spv_context_t hijack_context_;
+  std::unique_ptr<libspirv::ValidationState_t> vstate_;
+  // Scans the OpCapability/OpExtension block ahead of the main pass, since
+  // the capability checks consult the declared extensions.
+  std::unique_ptr<libspirv::StreamingBinaryParser> extension_parser_;
+  // Runs the per-instruction validation passes.
+  std::unique_ptr<libspirv::StreamingBinaryParser> instruction_parser_;
+  // The module words received so far.
+  std::vector<uint32_t> words_;
+  // Has the extension scan reached the end of the extension block?
+  bool extensions_scanned_;
+  // The first error reported, or SPV_SUCCESS.
+  spv_result_t status_;
+};
+
 }  // namespace spvtools
 
 #endif  // LIBSPIRV_VALIDATE_H_
@@ -127,4 +127,9 @@ spv_result_t CapabilityPass(ValidationState_t& _,
   return SPV_SUCCESS;
 }
 
+bool CapabilityPassHasEnvRules(spv_target_env env) {
+  // Keep in step with the environment dispatch in CapabilityPass above.
+  return env == SPV_ENV_VULKAN_1_0;
+}
+
 }  // namespace libspirv
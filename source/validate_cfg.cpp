@@ -13,14 +13,15 @@
 // limitations under the License.
 
 #include "validate.h"
-#include "cfa.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <functional>
 #include <iostream>
 #include <map>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
@@ -96,28 +97,27 @@ spv_result_t MergeBlockAssert(ValidationState_t& _, uint32_t merge_block) {
 /// identified in the CFG.
 void UpdateContinueConstructExitBlocks(
     Function& function, const vector<pair<uint32_t, uint32_t>>& back_edges) {
-  auto& constructs = function.constructs();
-  // TODO(umar): Think of a faster way to do this
   for (auto& edge : back_edges) {
     uint32_t back_edge_block_id;
     uint32_t loop_header_block_id;
     tie(back_edge_block_id, loop_header_block_id) = edge;
-    auto is_this_header = [=](Construct& c) {
-      return c.type() == ConstructType::kLoop &&
-             c.entry_block()->id() == loop_header_block_id;
-    };
-
-    for (auto construct : constructs) {
-      if (is_this_header(construct)) {
-        Construct* continue_construct =
-            construct.corresponding_constructs().back();
-        assert(continue_construct->type() == ConstructType::kContinue);
-
-        BasicBlock* back_edge_block;
-        tie(back_edge_block, ignore) = function.GetBlock(back_edge_block_id);
-        continue_construct->set_exit(back_edge_block);
-      }
-    }
+
+    // Loop constructs are tracked by their header block, so the loop this
+    // back edge closes is a single lookup away.  A back edge whose target
+    // never issued an OpLoopMerge has no construct to update.
+    BasicBlock* header_block;
+    tie(header_block, ignore) = function.GetBlock(loop_header_block_id);
+    Construct* loop_construct =
+        function.GetConstructForEntryBlock(header_block, ConstructType::kLoop);
+    if (!loop_construct) continue;
+
+    Construct* continue_construct =
+        loop_construct->corresponding_constructs().back();
+    assert(continue_construct->type() == ConstructType::kContinue);
+
+    BasicBlock* back_edge_block;
+    tie(back_edge_block, ignore) = function.GetBlock(back_edge_block_id);
+    continue_construct->set_exit(back_edge_block);
   }
 }
 
@@ -257,7 +257,58 @@ spv_result_t StructuredControlFlowChecks(
 }
 
 spv_result_t PerformCfgChecks(ValidationState_t& _) {
-  for (auto& function : _.functions()) {
+  auto& functions = _.functions();
+
+  // Enforce the work budget, if one was set, before any traversal runs, so
+  // an adversarial CFG is rejected before it can cost anything.
+  const spv_validator_budget_t& budget = _.options()->budget_;
+  for (auto& function : functions) {
+    const size_t num_blocks = function.block_count();
+    if (budget.max_blocks_per_function &&
+        num_blocks > budget.max_blocks_per_function) {
+      return _.diag(SPV_ERROR_EXCEEDED_BUDGET)
+             << "Function " << _.getIdName(function.id()) << " has "
+             << num_blocks << " blocks, more than the validation budget of "
+             << budget.max_blocks_per_function << " blocks per function";
+    }
+    if (!_.CountValidationSteps(num_blocks)) {
+      return _.diag(SPV_ERROR_EXCEEDED_BUDGET)
+             << "Validation step budget of " << budget.max_validation_steps
+             << " exhausted";
+    }
+  }
+
+  // First run every function's CFG analyses, populating each function's
+  // cache.  The analyses are independent per function, so spread them over
+  // the available cores.  Functions with undefined blocks are skipped here;
+  // the serial check phase below reports them before their (missing)
+  // analysis results would be consulted.
+  const size_t num_workers = std::min<size_t>(
+      std::max(1u, std::thread::hardware_concurrency()), functions.size());
+  if (num_workers > 1) {
+    std::atomic<size_t> next_function(0);
+    vector<std::thread> workers;
+    for (size_t i = 0; i < num_workers; ++i) {
+      workers.emplace_back([&functions, &next_function] {
+        for (size_t fi = next_function++; fi < functions.size();
+             fi = next_function++) {
+          if (functions[fi].undefined_block_count() == 0)
+            functions[fi].GetCfgAnalysis();
+        }
+      });
+    }
+    for (auto& worker : workers) worker.join();
+  } else {
+    for (size_t fi = 0; fi < functions.size(); ++fi) {
+      if (functions[fi].undefined_block_count() == 0)
+        functions[fi].GetCfgAnalysis();
+    }
+  }
+
+  // Then run the checks serially, so diagnostics stay deterministic and the
+  // message consumer is only invoked from one thread.
+  for (size_t fi = 0; fi < functions.size(); ++fi) {
+    auto& function = functions[fi];
     // Check all referenced blocks are defined within a function
     if (function.undefined_block_count() != 0) {
       string undef_blocks("{");
@@ -270,48 +321,7 @@ spv_result_t PerformCfgChecks(ValidationState_t& _) {
              << _.getIdName(function.id());
     }
 
-    // Set each block's immediate dominator and immediate postdominator,
-    // and find all back-edges.
-    //
-    // We want to analyze all the blocks in the function, even in degenerate
-    // control flow cases including unreachable blocks.  So use the augmented
-    // CFG to ensure we cover all the blocks.
-    vector<const BasicBlock*> postorder;
-    vector<const BasicBlock*> postdom_postorder;
-    vector<pair<uint32_t, uint32_t>> back_edges;
-    auto ignore_block = [](cbb_ptr) {};
-    auto ignore_edge = [](cbb_ptr, cbb_ptr) {};
-    if (!function.ordered_blocks().empty()) {
-      /// calculate dominators
-      spvtools::CFA<libspirv::BasicBlock>::DepthFirstTraversal(
-          function.first_block(), function.AugmentedCFGSuccessorsFunction(),
-          ignore_block, [&](cbb_ptr b) { postorder.push_back(b); },
-          ignore_edge);
-      auto edges = spvtools::CFA<libspirv::BasicBlock>::CalculateDominators(
-          postorder, function.AugmentedCFGPredecessorsFunction());
-      for (auto edge : edges) {
-        edge.first->SetImmediateDominator(edge.second);
-      }
-
-      /// calculate post dominators
-      spvtools::CFA<libspirv::BasicBlock>::DepthFirstTraversal(
-          function.pseudo_exit_block(),
-          function.AugmentedCFGPredecessorsFunction(), ignore_block,
-          [&](cbb_ptr b) { postdom_postorder.push_back(b); }, ignore_edge);
-      auto postdom_edges = spvtools::CFA<libspirv::BasicBlock>::CalculateDominators(
-          postdom_postorder, function.AugmentedCFGSuccessorsFunction());
-      for (auto edge : postdom_edges) {
-        edge.first->SetImmediatePostDominator(edge.second);
-      }
-      /// calculate back edges.
-      spvtools::CFA<libspirv::BasicBlock>::DepthFirstTraversal(
-          function.pseudo_entry_block(),
-          function
-              .AugmentedCFGSuccessorsFunctionIncludingHeaderToContinueEdge(),
-          ignore_block, ignore_block, [&](cbb_ptr from, cbb_ptr to) {
-            back_edges.emplace_back(from->id(), to->id());
-          });
-    }
+    const auto& back_edges = function.GetCfgAnalysis().back_edges;
     UpdateContinueConstructExitBlocks(function, back_edges);
 
     auto& blocks = function.ordered_blocks();
@@ -412,4 +422,23 @@ spv_result_t CfgPass(ValidationState_t& _,
   }
   return SPV_SUCCESS;
 }
+
+bool CfgPassHandles(SpvOp opcode) {
+  // Keep in step with the switch in CfgPass above.
+  switch (opcode) {
+    case SpvOpLabel:
+    case SpvOpLoopMerge:
+    case SpvOpSelectionMerge:
+    case SpvOpBranch:
+    case SpvOpBranchConditional:
+    case SpvOpSwitch:
+    case SpvOpKill:
+    case SpvOpReturn:
+    case SpvOpReturnValue:
+    case SpvOpUnreachable:
+      return true;
+    default:
+      return false;
+  }
+}
 }  // namespace libspirv
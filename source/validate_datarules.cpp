@@ -270,4 +270,22 @@ spv_result_t DataRulesPass(ValidationState_t& _,
   return SPV_SUCCESS;
 }
 
+bool DataRulesPassHandles(SpvOp opcode) {
+  // Keep in step with the switch in DataRulesPass above.
+  switch (opcode) {
+    case SpvOpTypeVector:
+    case SpvOpTypeFloat:
+    case SpvOpTypeInt:
+    case SpvOpTypeMatrix:
+    case SpvOpSpecConstant:
+    case SpvOpSpecConstantFalse:
+    case SpvOpSpecConstantTrue:
+    case SpvOpTypeForwardPointer:
+    case SpvOpTypeStruct:
+      return true;
+    default:
+      return false;
+  }
+}
+
 }  // namespace libspirv
@@ -25,6 +25,7 @@
 #include "diagnostic.h"
 #include "instruction.h"
 #include "message.h"
+#include "val/profiling.h"
 #include "opcode.h"
 #include "spirv_validator_options.h"
 #include "spirv-tools/libspirv.h"
@@ -33,6 +34,7 @@
 
 using libspirv::ValidationState_t;
 using libspirv::Decoration;
+using libspirv::WordRange;
 using std::function;
 using std::ignore;
 using std::make_pair;
@@ -69,6 +71,12 @@ class idUsage {
   template <SpvOp>
   bool isValid(const spv_instruction_t* inst, const spv_opcode_desc);
 
+  // Type of a per-opcode check.  isValid dispatches through an
+  // opcode-indexed table of these; opcodes without an implemented check
+  // map to nullptr and are accepted.
+  using CheckFn = bool (idUsage::*)(const spv_instruction_t*,
+                                    const spv_opcode_desc);
+
  private:
   const spv_opcode_table opcodeTable;
   const spv_operand_table operandTable;
@@ -325,8 +333,7 @@ bool idUsage::isValid<SpvOpTypeSampler>(const spv_instruction_t*,
 // constant-defining instruction (either OpConstant or
 // OpSpecConstant). typeWords are the words of the constant's-type-defining
 // OpTypeInt.
-bool aboveZero(const vector<uint32_t>& constWords,
-               const vector<uint32_t>& typeWords) {
+bool aboveZero(const WordRange& constWords, const WordRange& typeWords) {
   const uint32_t width = typeWords[2];
   const bool is_signed = typeWords[3] > 0;
   const uint32_t loWord = constWords[3];
@@ -755,7 +762,7 @@ bool idUsage::isValid<SpvOpConstantSampler>(const spv_instruction_t* inst,
 // True if instruction defines a type that can have a null value, as defined by
 // the SPIR-V spec.  Tracks composite-type components through module to check
 // nullability transitively.
-bool IsTypeNullable(const vector<uint32_t>& instruction,
+bool IsTypeNullable(const WordRange& instruction,
                     const ValidationState_t& module) {
   uint16_t opcode;
   uint16_t word_count;
@@ -1298,7 +1305,7 @@ template <>
 bool idUsage::isValid<SpvOpAccessChain>(const spv_instruction_t* inst,
                                         const spv_opcode_desc) {
   std::string instr_name =
-      "Op" + std::string(spvOpcodeString(static_cast<SpvOp>(inst->opcode)));
+      std::string(spvOpcodeStringPrefixed(static_cast<SpvOp>(inst->opcode)));
 
   // The result type must be OpTypePointer. Result Type is at word 1.
   auto resultTypeIndex = 1;
@@ -1782,7 +1789,7 @@ bool idUsage::isValid<SpvOpCompositeExtract>(const spv_instruction_t* inst,
                                              const spv_opcode_desc) {
   auto instr_name = [&inst]() {
     std::string name =
-        "Op" + std::string(spvOpcodeString(static_cast<SpvOp>(inst->opcode)));
+        std::string(spvOpcodeStringPrefixed(static_cast<SpvOp>(inst->opcode)));
     return name;
   };
 
@@ -1840,7 +1847,7 @@ bool idUsage::isValid<SpvOpCompositeInsert>(const spv_instruction_t* inst,
                                             const spv_opcode_desc) {
   auto instr_name = [&inst]() {
     std::string name =
-        "Op" + std::string(spvOpcodeString(static_cast<SpvOp>(inst->opcode)));
+        std::string(spvOpcodeStringPrefixed(static_cast<SpvOp>(inst->opcode)));
     return name;
   };
 
@@ -2830,17 +2837,23 @@ bool idUsage::isValid<OpGroupCommitWritePipe>(
 
 #undef DIAG
 
-bool idUsage::isValid(const spv_instruction_t* inst) {
-  spv_opcode_desc opcodeEntry = nullptr;
-  if (spvOpcodeTableValueLookup(opcodeTable, inst->opcode, &opcodeEntry))
-    return false;
+// Records fn as the check for opcode, growing the table as needed.
+void AddCheck(vector<idUsage::CheckFn>* table, SpvOp opcode,
+              idUsage::CheckFn fn) {
+  if (table->size() <= static_cast<size_t>(opcode))
+    table->resize(opcode + 1, nullptr);
+  (*table)[opcode] = fn;
+}
+
+// Builds the opcode-indexed table of id-usage checks.  The TODO entries
+// document opcodes whose checks are not implemented yet; their table slots
+// stay nullptr and the instructions are accepted.
+vector<idUsage::CheckFn> BuildIdUsageCheckTable() {
+  vector<idUsage::CheckFn> table;
 #define CASE(OpCode) \
-  case Spv##OpCode:  \
-    return isValid<Spv##OpCode>(inst, opcodeEntry);
-#define TODO(OpCode) \
-  case Spv##OpCode:  \
-    return true;
-  switch (inst->opcode) {
+  AddCheck(&table, Spv##OpCode, &idUsage::isValid<Spv##OpCode>);
+#define TODO(OpCode)
+  {
     TODO(OpUndef)
     CASE(OpMemberName)
     CASE(OpLine)
@@ -3048,11 +3061,24 @@ bool idUsage::isValid(const spv_instruction_t* inst) {
     TODO(OpGroupReserveWritePipePackets)
     TODO(OpGroupCommitReadPipe)
     TODO(OpGroupCommitWritePipe)
-    default:
-      return true;
   }
 #undef TODO
 #undef CASE
+  return table;
+}
+
+bool idUsage::isValid(const spv_instruction_t* inst) {
+  spv_opcode_desc opcodeEntry = nullptr;
+  if (spvOpcodeTableValueLookup(opcodeTable, inst->opcode, &opcodeEntry))
+    return false;
+  SPIRV_VALIDATOR_PROFILE_ID_USAGE_CHECK(inst->opcode);
+  static const vector<CheckFn> table = BuildIdUsageCheckTable();
+  const CheckFn check = static_cast<size_t>(inst->opcode) < table.size()
+                            ? table[inst->opcode]
+                            : nullptr;
+  // Opcodes without an implemented check are accepted.
+  if (!check) return true;
+  return (this->*check)(inst, opcodeEntry);
 }
 // This function takes the opcode of an instruction and returns
 // a function object that will return true if the index
@@ -3120,6 +3146,11 @@ namespace libspirv {
 
 spv_result_t UpdateIdUse(ValidationState_t& _) {
   for (const auto& inst : _.ordered_instructions()) {
+    if (!_.CountValidationSteps(1)) {
+      return _.diag(SPV_ERROR_EXCEEDED_BUDGET)
+             << "Validation step budget of "
+             << _.options()->budget_.max_validation_steps << " exhausted";
+    }
     for (auto& operand : inst.operands()) {
       const spv_operand_type_t& type = operand.type;
       const uint32_t operand_id = inst.word(operand.offset);
@@ -3142,14 +3173,17 @@ spv_result_t UpdateIdUse(ValidationState_t& _) {
 /// checked during the initial binary parse in the IdPass below
 spv_result_t CheckIdDefinitionDominateUse(const ValidationState_t& _) {
   unordered_set<const Instruction*> phi_instructions;
-  for (const auto& definition : _.all_definitions()) {
+  const vector<Instruction*>& definitions = _.all_definitions();
+  for (uint32_t id = 0; id < definitions.size(); ++id) {
+    const Instruction* definition = definitions[id];
+    if (!definition) continue;
     // Check only those definitions defined in a function
-    if (const Function* func = definition.second->function()) {
-      if (const BasicBlock* block = definition.second->block()) {
+    if (const Function* func = definition->function()) {
+      if (const BasicBlock* block = definition->block()) {
         if (!block->reachable()) continue;
         // If the Id is defined within a block then make sure all references to
         // that Id appear in a blocks that are dominated by the defining block
-        for (auto& use_index_pair : definition.second->uses()) {
+        for (auto& use_index_pair : definition->uses()) {
           const Instruction* use = use_index_pair.first;
           if (const BasicBlock* use_block = use->block()) {
             if (use_block->reachable() == false) continue;
@@ -3157,7 +3191,7 @@ spv_result_t CheckIdDefinitionDominateUse(const ValidationState_t& _) {
               phi_instructions.insert(use);
             } else if (!block->dominates(*use->block())) {
               return _.diag(SPV_ERROR_INVALID_ID)
-                     << "ID " << _.getIdName(definition.first)
+                     << "ID " << _.getIdName(id)
                      << " defined in block " << _.getIdName(block->id())
                      << " does not dominate its use in block "
                      << _.getIdName(use_block->id());
@@ -3168,11 +3202,11 @@ spv_result_t CheckIdDefinitionDominateUse(const ValidationState_t& _) {
         // If the Ids defined within a function but not in a block(i.e. function
         // parameters, block ids), then make sure all references to that Id
         // appear within the same function
-        for (auto use : definition.second->uses()) {
+        for (auto use : definition->uses()) {
           const Instruction* inst = use.first;
           if (inst->function() && inst->function() != func) {
             return _.diag(SPV_ERROR_INVALID_ID)
-                   << "ID " << _.getIdName(definition.first)
+                   << "ID " << _.getIdName(id)
                    << " used in function "
                    << _.getIdName(inst->function()->id())
                    << " is used outside of it's defining function "
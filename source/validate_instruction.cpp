@@ -19,8 +19,12 @@
 #include <algorithm>
 #include <cassert>
 
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "binary.h"
 #include "diagnostic.h"
@@ -37,6 +41,7 @@
 
 using libspirv::AssemblyGrammar;
 using libspirv::CapabilitySet;
+using libspirv::DecorationRange;
 using libspirv::DiagnosticStream;
 using libspirv::ExtensionSet;
 using libspirv::ValidationState_t;
@@ -121,22 +126,109 @@ ExtensionSet RequiredExtensions(const ValidationState_t& state,
   return ExtensionSet();
 }
 
+// Capability and extension requirements of one grammar, reorganized for the
+// per-instruction path: the opcode table is flattened into a dense
+// by-opcode-value array of its capability-bearing entries, and each operand
+// type is tagged with whether any of its values carries capabilities or
+// extensions.  Instructions made only of untagged parts skip the grammar
+// lookups entirely, which covers nearly every instruction of a core-profile
+// module.
+class InstructionGates {
+ public:
+  explicit InstructionGates(spv_target_env env) {
+    spv_opcode_table opcode_table = nullptr;
+    if (spvOpcodeTableGet(&opcode_table, env) == SPV_SUCCESS) {
+      for (uint32_t i = 0; i < opcode_table->count; ++i) {
+        const spv_opcode_desc_t& entry = opcode_table->entries[i];
+        if (!(entry.versions & opcode_table->version)) continue;
+        if (entry.capabilities.IsEmpty()) continue;
+        if (opcode_capability_descs_.size() <= uint32_t(entry.opcode))
+          opcode_capability_descs_.resize(entry.opcode + 1, nullptr);
+        opcode_capability_descs_[entry.opcode] = &entry;
+      }
+    }
+    spv_operand_table operand_table = nullptr;
+    if (spvOperandTableGet(&operand_table, env) == SPV_SUCCESS) {
+      for (uint32_t i = 0; i < operand_table->count; ++i) {
+        const spv_operand_desc_group_t& group = operand_table->types[i];
+        bool has_capabilities = false;
+        bool has_extensions = false;
+        for (uint32_t j = 0; j < group.count; ++j) {
+          has_capabilities |= !group.entries[j].capabilities.IsEmpty();
+          has_extensions |= !group.entries[j].extensions.IsEmpty();
+        }
+        if (!has_capabilities && !has_extensions) continue;
+        const uint32_t type = group.type;
+        if (type_has_capabilities_.size() <= type) {
+          type_has_capabilities_.resize(type + 1, false);
+          type_has_extensions_.resize(type + 1, false);
+        }
+        type_has_capabilities_[type] = has_capabilities;
+        type_has_extensions_[type] = has_extensions;
+      }
+    }
+  }
+
+  // Returns the grammar entry for |opcode| if the opcode requires
+  // capabilities, and nullptr otherwise.
+  const spv_opcode_desc_t* OpcodeCapabilityDesc(SpvOp opcode) const {
+    const uint32_t value = opcode;
+    return value < opcode_capability_descs_.size()
+               ? opcode_capability_descs_[value]
+               : nullptr;
+  }
+
+  // Returns true if some value of the given operand type requires
+  // capabilities.
+  bool TypeHasCapabilities(spv_operand_type_t type) const {
+    const uint32_t value = type;
+    return value < type_has_capabilities_.size() &&
+           type_has_capabilities_[value];
+  }
+
+  // Returns true if some value of the given operand type is gated on
+  // extensions.
+  bool TypeHasExtensions(spv_operand_type_t type) const {
+    const uint32_t value = type;
+    return value < type_has_extensions_.size() && type_has_extensions_[value];
+  }
+
+ private:
+  std::vector<const spv_opcode_desc_t*> opcode_capability_descs_;
+  std::vector<bool> type_has_capabilities_;
+  std::vector<bool> type_has_extensions_;
+};
+
+// Returns the gate table for the grammar of |env|, building it on first use.
+// The grammar tables are static, so gate tables are cached for the lifetime
+// of the process.
+const InstructionGates& GatesFor(spv_target_env env) {
+  static std::mutex mutex;
+  static auto* cache =
+      new std::unordered_map<int, std::unique_ptr<InstructionGates>>;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& gates = (*cache)[env];
+  if (!gates) gates.reset(new InstructionGates(env));
+  return *gates;
+}
+
 }  // namespace
 
 namespace libspirv {
 
 spv_result_t CapabilityCheck(ValidationState_t& _,
-                             const spv_parsed_instruction_t* inst) {
-  spv_opcode_desc opcode_desc;
+                             const spv_parsed_instruction_t* inst,
+                             const InstructionGates& gates) {
   const SpvOp opcode = static_cast<SpvOp>(inst->opcode);
-  if (SPV_SUCCESS == _.grammar().lookupOpcode(opcode, &opcode_desc) &&
-      !_.HasAnyOfCapabilities(opcode_desc->capabilities))
+  const spv_opcode_desc_t* opcode_desc = gates.OpcodeCapabilityDesc(opcode);
+  if (opcode_desc && !_.HasAnyOfCapabilities(opcode_desc->capabilities))
     return _.diag(SPV_ERROR_INVALID_CAPABILITY)
            << "Opcode " << spvOpcodeString(opcode)
            << " requires one of these capabilities: "
            << ToString(opcode_desc->capabilities, _.grammar());
   for (int i = 0; i < inst->num_operands; ++i) {
     const auto& operand = inst->operands[i];
+    if (!gates.TypeHasCapabilities(operand.type)) continue;
     const auto word = inst->words[operand.offset];
     if (spvOperandIsConcreteMask(operand.type)) {
       // Check for required capabilities for each bit position of the mask.
@@ -166,11 +258,13 @@ spv_result_t CapabilityCheck(ValidationState_t& _,
 
 // Checks that all required extensions were declared in the module.
 spv_result_t ExtensionCheck(ValidationState_t& _,
-                            const spv_parsed_instruction_t* inst) {
+                            const spv_parsed_instruction_t* inst,
+                            const InstructionGates& gates) {
   const SpvOp opcode = static_cast<SpvOp>(inst->opcode);
   for (size_t operand_index = 0; operand_index < inst->num_operands;
        ++operand_index) {
     const auto& operand = inst->operands[operand_index];
+    if (!gates.TypeHasExtensions(operand.type)) continue;
     const uint32_t word = inst->words[operand.offset];
     const ExtensionSet required_extensions =
         RequiredExtensions(_, operand.type, word);
@@ -201,17 +295,6 @@ spv_result_t ReservedCheck(ValidationState_t& _,
   }
 }
 
-// Checks that the Resuld <id> is within the valid bound.
-spv_result_t LimitCheckIdBound(ValidationState_t& _,
-                               const spv_parsed_instruction_t* inst) {
-  if (inst->result_id >= _.getIdBound()) {
-    return _.diag(SPV_ERROR_INVALID_BINARY)
-           << "Result <id> '" << inst->result_id
-           << "' must be less than the ID bound '" << _.getIdBound() << "'.";
-  }
-  return SPV_SUCCESS;
-}
-
 // Checks that the number of OpTypeStruct members is within the limit.
 spv_result_t LimitCheckStruct(ValidationState_t& _,
                               const spv_parsed_instruction_t* inst) {
@@ -344,7 +427,9 @@ spv_result_t RegisterDecorations(ValidationState_t& _,
       // Word 1 is the group <id>. All subsequent words are target <id>s that
       // are going to be decorated with the decorations.
       const uint32_t decoration_group_id = inst->words[1];
-      std::vector<Decoration>& group_decorations =
+      // The range stays valid across the registrations below: registration
+      // appends to the entry log and does not regroup the pool.
+      const DecorationRange group_decorations =
           _.id_decorations(decoration_group_id);
       for (int i = 2; i < inst->num_words; ++i) {
         const uint32_t target_id = inst->words[i];
@@ -358,7 +443,7 @@ spv_result_t RegisterDecorations(ValidationState_t& _,
       // pairs. All decorations of the group should be applied to all the struct
       // members that are specified in the instructions.
       const uint32_t decoration_group_id = inst->words[1];
-      std::vector<Decoration>& group_decorations =
+      const DecorationRange group_decorations =
           _.id_decorations(decoration_group_id);
       // Grammar checks ensures that the number of arguments to this instruction
       // is an odd number: 1 decoration group + (id,literal) pairs.
@@ -448,9 +533,11 @@ spv_result_t InstructionPass(ValidationState_t& _,
   // that are applied to any given <id>.
   RegisterDecorations(_, inst);
 
-  if (auto error = ExtensionCheck(_, inst)) return error;
-  if (auto error = CapabilityCheck(_, inst)) return error;
-  if (auto error = LimitCheckIdBound(_, inst)) return error;
+  const InstructionGates& gates = GatesFor(_.context()->target_env);
+  if (auto error = ExtensionCheck(_, inst, gates)) return error;
+  if (auto error = CapabilityCheck(_, inst, gates)) return error;
+  // The result id's bound check is covered by the id-operand sweep that runs
+  // before any pass; see ProcessInstruction in validate.cpp.
   if (auto error = LimitCheckStruct(_, inst)) return error;
   if (auto error = LimitCheckSwitch(_, inst)) return error;
   if (auto error = ReservedCheck(_, inst)) return error;
@@ -0,0 +1,152 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for caller-supplied memory allocators; see spvContextSetAllocator.
+
+#include <cstring>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "spirv-tools/libspirv.h"
+
+namespace {
+
+// An allocator that counts its traffic, so tests can observe whether the
+// library's allocations flow through it and whether they are all returned.
+struct TrackingAllocator {
+  size_t num_allocations = 0;
+  size_t live_bytes = 0;
+
+  static void* Allocate(void* user_data, size_t num_bytes) {
+    TrackingAllocator* self = static_cast<TrackingAllocator*>(user_data);
+    ++self->num_allocations;
+    self->live_bytes += num_bytes;
+    return ::operator new(num_bytes);
+  }
+
+  static void Deallocate(void* user_data, void* pointer, size_t num_bytes) {
+    TrackingAllocator* self = static_cast<TrackingAllocator*>(user_data);
+    self->live_bytes -= num_bytes;
+    ::operator delete(pointer);
+  }
+
+  spv_allocator_t c_allocator() { return {this, &Allocate, &Deallocate}; }
+};
+
+const char kModuleText[] =
+    "OpCapability Shader\n"
+    "OpCapability Linkage\n"
+    "OpMemoryModel Logical GLSL450\n";
+
+TEST(Allocator, AssembledBinaryComesFromTheContextAllocator) {
+  TrackingAllocator tracker;
+  spv_context context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  const spv_allocator_t allocator = tracker.c_allocator();
+  spvContextSetAllocator(context, &allocator);
+
+  spv_binary binary = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(context, kModuleText,
+                                         strlen(kModuleText), &binary,
+                                         nullptr));
+  EXPECT_GT(tracker.num_allocations, 0u);
+  EXPECT_GT(tracker.live_bytes, 0u);
+  EXPECT_NE(nullptr, binary->code);
+
+  // The binary outlives its context; the recorded allocator releases it.
+  spvContextDestroy(context);
+  spvBinaryDestroy(binary);
+  EXPECT_EQ(0u, tracker.live_bytes);
+}
+
+TEST(Allocator, DisassembledTextComesFromTheContextAllocator) {
+  spv_context plain_context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  spv_binary binary = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(plain_context, kModuleText,
+                                         strlen(kModuleText), &binary,
+                                         nullptr));
+
+  TrackingAllocator tracker;
+  spv_context context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  const spv_allocator_t allocator = tracker.c_allocator();
+  spvContextSetAllocator(context, &allocator);
+
+  spv_text text = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryToText(context, binary->code, binary->wordCount,
+                            SPV_BINARY_TO_TEXT_OPTION_NONE, &text, nullptr));
+  EXPECT_GT(tracker.num_allocations, 0u);
+  EXPECT_NE(nullptr, text->str);
+
+  spvTextDestroy(text);
+  EXPECT_EQ(0u, tracker.live_bytes);
+
+  spvContextDestroy(context);
+  spvBinaryDestroy(binary);
+  spvContextDestroy(plain_context);
+}
+
+TEST(Allocator, ValidatorScratchComesFromTheContextAllocator) {
+  spv_context plain_context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  spv_binary binary = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(plain_context, kModuleText,
+                                         strlen(kModuleText), &binary,
+                                         nullptr));
+
+  TrackingAllocator tracker;
+  spv_context context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  const spv_allocator_t allocator = tracker.c_allocator();
+  spvContextSetAllocator(context, &allocator);
+
+  spv_const_binary_t const_binary{binary->code, binary->wordCount};
+  EXPECT_EQ(SPV_SUCCESS, spvValidate(context, &const_binary, nullptr));
+  EXPECT_GT(tracker.num_allocations, 0u);
+  // The validation state is gone, so its scratch buffers came back.
+  EXPECT_EQ(0u, tracker.live_bytes);
+
+  spvContextDestroy(context);
+  spvBinaryDestroy(binary);
+  spvContextDestroy(plain_context);
+}
+
+TEST(Allocator, UnsetAllocatorUsesTheGlobalHeap) {
+  spv_context context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  spv_binary binary = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(context, kModuleText,
+                                         strlen(kModuleText), &binary,
+                                         nullptr));
+  // No allocator is recorded in the result.
+  EXPECT_EQ(nullptr, binary->allocator.allocate);
+  EXPECT_EQ(nullptr, binary->allocator.deallocate);
+  spvBinaryDestroy(binary);
+  spvContextDestroy(context);
+}
+
+TEST(Allocator, PassingNullRestoresTheGlobalHeap) {
+  TrackingAllocator tracker;
+  spv_context context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  const spv_allocator_t allocator = tracker.c_allocator();
+  spvContextSetAllocator(context, &allocator);
+  spvContextSetAllocator(context, nullptr);
+
+  spv_binary binary = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(context, kModuleText,
+                                         strlen(kModuleText), &binary,
+                                         nullptr));
+  EXPECT_EQ(0u, tracker.num_allocations);
+  spvBinaryDestroy(binary);
+  spvContextDestroy(context);
+}
+
+}  // anonymous namespace
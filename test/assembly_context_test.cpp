@@ -14,10 +14,12 @@
 
 #include "unit_spirv.h"
 
+#include <string>
 #include <vector>
 #include <gmock/gmock.h>
 
 #include "source/instruction.h"
+#include "test_fixture.h"
 
 using libspirv::AssemblyContext;
 using spvtest::AutoText;
@@ -73,4 +75,70 @@ INSTANTIATE_TEST_CASE_P(
     }),);
 // clang-format on
 
+// A context fed by a token pipeline must visit exactly the same tokens at
+// exactly the same positions as one scanning the text itself, including
+// through comments, quoted strings with spaces, and escaped quotes.
+TEST(TokenPipeline, MatchesDirectScanning) {
+  AutoText text(
+      "OpCapability Shader ; trailing comment\n"
+      "; a full-line comment\n"
+      "%1 = OpString \"quoted ; text with spaces\"\n"
+      "%2 = OpString \"escaped \\\" quote\"\n"
+      "\t  OpNop\n");
+  AssemblyContext direct(text, nullptr);
+  AssemblyContext piped(text, nullptr);
+  libspirv::TokenPipeline pipeline(text);
+  piped.SetTokenPipeline(&pipeline);
+
+  while (true) {
+    const spv_result_t status = direct.advance();
+    ASSERT_EQ(status, piped.advance());
+    if (status != SPV_SUCCESS) break;
+    ASSERT_EQ(direct.position().index, piped.position().index);
+    EXPECT_EQ(direct.position().line, piped.position().line);
+    EXPECT_EQ(direct.position().column, piped.position().column);
+    std::string direct_word, piped_word;
+    spv_position_t direct_next = {}, piped_next = {};
+    ASSERT_EQ(SPV_SUCCESS, direct.getWord(&direct_word, &direct_next));
+    ASSERT_EQ(SPV_SUCCESS, piped.getWord(&piped_word, &piped_next));
+    EXPECT_EQ(direct_word, piped_word);
+    EXPECT_EQ(direct_next.index, piped_next.index);
+    direct.setPosition(direct_next);
+    piped.setPosition(piped_next);
+  }
+}
+
+// Destroying a pipeline before its tokens are consumed must release the
+// scanning thread, even if it is blocked on a full queue.
+TEST(TokenPipeline, AbandonedPipelineShutsDownCleanly) {
+  std::string source;
+  for (int i = 0; i < 100000; ++i) source += "OpNop\n";
+  AutoText text(source);
+  libspirv::TokenPipeline pipeline(text);
+  // Consume nothing; the destructor joins the scanner.
+}
+
+// Assembles a module large enough to cross the pipeline threshold in
+// spvTextToBinary, checking the pipelined path end to end.
+TEST(TokenPipeline, AssemblesLargeModuleThroughPipeline) {
+  std::string text = "OpCapability Linkage\nOpMemoryModel Logical GLSL450\n";
+  const uint32_t kNumStrings = 4000;
+  for (uint32_t i = 0; i < kNumStrings; ++i) {
+    text += "%s" + std::to_string(i) + " = OpString \"payload payload\"\n";
+  }
+  ASSERT_GT(text.size(), 64u * 1024u);
+
+  spvtest::ScopedContext ctx;
+  spv_binary binary = nullptr;
+  spv_diagnostic diagnostic = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(ctx.context, text.data(), text.size(),
+                                         &binary, &diagnostic));
+  // Header, OpCapability, OpMemoryModel, then per OpString: the opcode word,
+  // the result id, and four words of string payload ("payload payload" is
+  // 15 characters plus the terminator).
+  EXPECT_EQ(5u + 2u + 3u + kNumStrings * 6u, binary->wordCount);
+  spvBinaryDestroy(binary);
+  if (diagnostic) spvDiagnosticDestroy(diagnostic);
+}
+
 }  // anonymous namespace
@@ -0,0 +1,275 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks for the assembler, binary parser, disassembler, validator and
+// optimizer, driven by synthesized modules of parameterized size.  The
+// project does not vendor a benchmarking library, so a small self-contained
+// harness below scales the iteration count until the measurement is long
+// enough to be stable and reports the mean time per run.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#define SPIRV_TOOLS_BENCHMARK_PERF_EVENT
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+#include "spirv-tools/libspirv.h"
+#include "spirv-tools/optimizer.hpp"
+
+namespace {
+
+// Hardware counter values accumulated over one measurement.  |valid| is
+// false when the counters could not be read, e.g. on platforms without
+// perf_event or when access to it is restricted.
+struct PerfSample {
+  double cycles = 0;
+  double instructions = 0;
+  double cache_misses = 0;
+  double branch_misses = 0;
+  bool valid = false;
+};
+
+#if defined(SPIRV_TOOLS_BENCHMARK_PERF_EVENT)
+
+// Reads the hardware counters that distinguish allocator stalls from real
+// compute: raw cycle and instruction counts give IPC, and cache/branch miss
+// counts attribute the gap.  Each counter is opened separately so a machine
+// with fewer programmable counters still reports the ones it can schedule.
+class PerfCounters {
+ public:
+  PerfCounters() {
+    fds_[0] = Open(PERF_COUNT_HW_CPU_CYCLES);
+    fds_[1] = Open(PERF_COUNT_HW_INSTRUCTIONS);
+    fds_[2] = Open(PERF_COUNT_HW_CACHE_MISSES);
+    fds_[3] = Open(PERF_COUNT_HW_BRANCH_MISSES);
+  }
+
+  ~PerfCounters() {
+    for (int fd : fds_) {
+      if (fd >= 0) close(fd);
+    }
+  }
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  void Start() {
+    for (int fd : fds_) {
+      if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+  }
+
+  PerfSample Stop() {
+    PerfSample sample;
+    uint64_t values[4] = {0, 0, 0, 0};
+    for (size_t i = 0; i < 4; ++i) {
+      if (fds_[i] < 0) continue;
+      ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fds_[i], &values[i], sizeof(values[i])) ==
+          static_cast<ssize_t>(sizeof(values[i]))) {
+        sample.valid = true;
+      }
+    }
+    sample.cycles = double(values[0]);
+    sample.instructions = double(values[1]);
+    sample.cache_misses = double(values[2]);
+    sample.branch_misses = double(values[3]);
+    return sample;
+  }
+
+ private:
+  static int Open(uint64_t config) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(
+        syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  int fds_[4];
+};
+
+#else
+
+// No-op stand-in for platforms without perf_event; the report then carries
+// wall time only.
+class PerfCounters {
+ public:
+  void Start() {}
+  PerfSample Stop() { return PerfSample(); }
+};
+
+#endif  // SPIRV_TOOLS_BENCHMARK_PERF_EVENT
+
+// Runs |body| repeatedly, growing the iteration count until at least a
+// quarter of a second of work has been measured, then prints the mean time
+// per run.  Hardware counters are sampled around the same loop that
+// provides the final timing, so the per-run counter values describe exactly
+// the measured runs.  A single warm-up run is excluded from the measurement.
+template <typename F>
+void RunBenchmark(const std::string& name, F&& body) {
+  using Clock = std::chrono::steady_clock;
+  body();
+  PerfCounters counters;
+  size_t runs = 1;
+  for (;;) {
+    counters.Start();
+    const Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < runs; ++i) body();
+    const double elapsed_ns =
+        std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    const PerfSample sample = counters.Stop();
+    if (elapsed_ns >= 250.0 * 1000.0 * 1000.0) {
+      std::printf("%-48s %14.2f us/run  (%zu runs)\n", name.c_str(),
+                  elapsed_ns / 1000.0 / double(runs), runs);
+      if (sample.valid) {
+        // Per-run counter values; IPC separates frontend work from stalls,
+        // and the miss counts say whether a layout change moved the needle.
+        const double ipc =
+            sample.cycles > 0 ? sample.instructions / sample.cycles : 0;
+        std::printf(
+            "%-48s %14.0f cycles  %.0f insts  (ipc %.2f)  "
+            "%.0f cache-miss  %.0f branch-miss\n",
+            "", sample.cycles / double(runs),
+            sample.instructions / double(runs), ipc,
+            sample.cache_misses / double(runs),
+            sample.branch_misses / double(runs));
+      }
+      return;
+    }
+    runs *= 4;
+  }
+}
+
+std::string BenchmarkName(const char* operation, size_t num_functions) {
+  std::ostringstream name;
+  name << operation << "/functions:" << num_functions;
+  return name.str();
+}
+
+// Synthesizes the assembly text of a module with |num_functions| small
+// functions.  Each function contains a few arithmetic instructions and a
+// conditional branch, so every stage under test gets real per-function work:
+// operand parsing, id tracking, CFG construction and constant analysis.
+std::string MakeModuleText(size_t num_functions) {
+  std::ostringstream text;
+  text << "OpCapability Shader\n"
+          "OpCapability Linkage\n"
+          "OpMemoryModel Logical GLSL450\n"
+          "%void = OpTypeVoid\n"
+          "%void_fn = OpTypeFunction %void\n"
+          "%float = OpTypeFloat 32\n"
+          "%bool = OpTypeBool\n"
+          "%float_1 = OpConstant %float 1\n";
+  for (size_t i = 0; i < num_functions; ++i) {
+    text << "%fn_" << i << " = OpFunction %void None %void_fn\n"
+         << "%entry_" << i << " = OpLabel\n"
+         << "%sum_" << i << " = OpFAdd %float %float_1 %float_1\n"
+         << "%prod_" << i << " = OpFMul %float %sum_" << i << " %sum_" << i
+         << "\n"
+         << "%cond_" << i << " = OpFOrdLessThan %bool %sum_" << i << " %prod_"
+         << i << "\n"
+         << "OpSelectionMerge %merge_" << i << " None\n"
+         << "OpBranchConditional %cond_" << i << " %then_" << i << " %merge_"
+         << i << "\n"
+         << "%then_" << i << " = OpLabel\n"
+         << "%extra_" << i << " = OpFAdd %float %prod_" << i << " %float_1\n"
+         << "OpBranch %merge_" << i << "\n"
+         << "%merge_" << i << " = OpLabel\n"
+         << "OpReturn\n"
+         << "OpFunctionEnd\n";
+  }
+  return text.str();
+}
+
+// Assembles |text|, aborting on failure since the corpus is expected to be
+// valid by construction.
+std::vector<uint32_t> Assemble(spv_context context, const std::string& text) {
+  spv_binary binary = nullptr;
+  if (spvTextToBinary(context, text.c_str(), text.size(), &binary, nullptr) !=
+      SPV_SUCCESS) {
+    std::fprintf(stderr, "error: failed to assemble the benchmark corpus\n");
+    std::exit(1);
+  }
+  std::vector<uint32_t> words(binary->code, binary->code + binary->wordCount);
+  spvBinaryDestroy(binary);
+  return words;
+}
+
+void BenchmarkModuleSize(spv_context context, size_t num_functions) {
+  const std::string text = MakeModuleText(num_functions);
+  const std::vector<uint32_t> words = Assemble(context, text);
+
+  RunBenchmark(BenchmarkName("spvTextToBinary", num_functions), [&] {
+    spv_binary binary = nullptr;
+    spvTextToBinary(context, text.c_str(), text.size(), &binary, nullptr);
+    spvBinaryDestroy(binary);
+  });
+
+  RunBenchmark(BenchmarkName("spvBinaryParse", num_functions), [&] {
+    spvBinaryParse(context, nullptr, words.data(), words.size(), nullptr,
+                   nullptr, nullptr);
+  });
+
+  RunBenchmark(BenchmarkName("spvBinaryToText", num_functions), [&] {
+    spv_text disassembly = nullptr;
+    spvBinaryToText(context, words.data(), words.size(),
+                    SPV_BINARY_TO_TEXT_OPTION_NONE, &disassembly, nullptr);
+    spvTextDestroy(disassembly);
+  });
+
+  RunBenchmark(BenchmarkName("spvValidate", num_functions), [&] {
+    spv_const_binary_t binary{words.data(), words.size()};
+    spvValidate(context, &binary, nullptr);
+  });
+
+  spvtools::Optimizer optimizer(SPV_ENV_UNIVERSAL_1_2);
+  optimizer.RegisterPass(spvtools::CreateStripDebugInfoPass())
+      .RegisterPass(spvtools::CreateUnifyConstantPass())
+      .RegisterPass(spvtools::CreateEliminateDeadConstantPass());
+  RunBenchmark(BenchmarkName("Optimizer::Run", num_functions), [&] {
+    std::vector<uint32_t> optimized;
+    optimizer.Run(words.data(), words.size(), &optimized);
+  });
+}
+
+}  // anonymous namespace
+
+int main() {
+  spv_context context = spvContextCreate(SPV_ENV_UNIVERSAL_1_2);
+  const size_t corpus_sizes[] = {16, 256, 2048};
+  for (size_t num_functions : corpus_sizes) {
+    BenchmarkModuleSize(context, num_functions);
+  }
+  spvContextDestroy(context);
+  return 0;
+}
@@ -49,4 +49,31 @@ TEST(BinaryEndianness, Big) {
   ASSERT_EQ(SPV_ENDIANNESS_BIG, endian);
 }
 
+TEST(FixWords, SameEndianCopies) {
+  const uint32_t input[] = {0x01020304, 0x05060708, 0x090a0b0c, 0x0d0e0f10,
+                            0x11121314};
+  const spv_endianness_t host_endian = (I32_ENDIAN_HOST == I32_ENDIAN_LITTLE)
+                                           ? SPV_ENDIANNESS_LITTLE
+                                           : SPV_ENDIANNESS_BIG;
+  uint32_t output[5] = {};
+  spvFixWords(input, 5, host_endian, output);
+  for (int i = 0; i < 5; i++) EXPECT_EQ(input[i], output[i]);
+}
+
+TEST(FixWords, OtherEndianSwapsEveryWord) {
+  const spv_endianness_t other_endian = (I32_ENDIAN_HOST == I32_ENDIAN_LITTLE)
+                                            ? SPV_ENDIANNESS_BIG
+                                            : SPV_ENDIANNESS_LITTLE;
+  // Long enough to exercise both a vectorized main loop and a scalar tail.
+  uint32_t words[7];
+  for (uint32_t i = 0; i < 7; i++) words[i] = 0x01020304 + i;
+  uint32_t output[7] = {};
+  spvFixWords(words, 7, other_endian, output);
+  for (uint32_t i = 0; i < 7; i++)
+    EXPECT_EQ(spvFixWord(words[i], other_endian), output[i]);
+  // The output may alias the input.
+  spvFixWords(words, 7, other_endian, words);
+  for (uint32_t i = 0; i < 7; i++) EXPECT_EQ(output[i], words[i]);
+}
+
 }  // anonymous namespace
@@ -0,0 +1,106 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for spvBinaryGetFingerprint.
+
+#include "test_fixture.h"
+#include "unit_spirv.h"
+
+namespace {
+
+using BinaryGetFingerprint = spvtest::TextToBinaryTest;
+using SpirvVector = BinaryGetFingerprint::SpirvVector;
+
+const char kModule[] = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+%void = OpTypeVoid
+%voidfn = OpTypeFunction %void
+%main = OpFunction %void None %voidfn
+%entry = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+TEST_F(BinaryGetFingerprint, CountsAndHeaderFields) {
+  const SpirvVector code = CompileSuccessfully(kModule);
+  spv_module_fingerprint_t fingerprint;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryGetFingerprint(code.data(), code.size(), &fingerprint));
+  EXPECT_EQ(10u, fingerprint.num_instructions);
+  EXPECT_EQ(1u, fingerprint.num_functions);
+  EXPECT_EQ(1u, fingerprint.num_entry_points);
+  EXPECT_EQ(1u, fingerprint.num_debug_instructions);  // The OpName.
+  EXPECT_EQ(code[1], fingerprint.version);    // SPV_INDEX_VERSION_NUMBER
+  EXPECT_EQ(code[2], fingerprint.generator);  // SPV_INDEX_GENERATOR_NUMBER
+  EXPECT_EQ(code[3], fingerprint.id_bound);   // SPV_INDEX_BOUND
+  EXPECT_NE(0u, fingerprint.hash);
+}
+
+TEST_F(BinaryGetFingerprint, HashSeparatesModulesWithEqualCounts) {
+  const SpirvVector code_a = CompileSuccessfully(kModule);
+  // Same shape, different entry point name.
+  std::string other(kModule);
+  const size_t name_at = other.find("\"main\"");
+  ASSERT_NE(std::string::npos, name_at);
+  other.replace(name_at, 6, "\"principale\"");
+  const SpirvVector code_b = CompileSuccessfully(other);
+
+  spv_module_fingerprint_t fingerprint_a, fingerprint_b;
+  ASSERT_EQ(SPV_SUCCESS, spvBinaryGetFingerprint(code_a.data(), code_a.size(),
+                                                 &fingerprint_a));
+  ASSERT_EQ(SPV_SUCCESS, spvBinaryGetFingerprint(code_b.data(), code_b.size(),
+                                                 &fingerprint_b));
+  EXPECT_EQ(fingerprint_a.num_instructions, fingerprint_b.num_instructions);
+  EXPECT_NE(fingerprint_a.hash, fingerprint_b.hash);
+
+  // The hash is a pure function of the words.
+  spv_module_fingerprint_t again;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryGetFingerprint(code_a.data(), code_a.size(), &again));
+  EXPECT_EQ(fingerprint_a.hash, again.hash);
+}
+
+TEST_F(BinaryGetFingerprint, RejectsTruncatedModule) {
+  const SpirvVector code = CompileSuccessfully(kModule);
+  spv_module_fingerprint_t fingerprint;
+  // The last instruction's word count now runs off the end of the buffer.
+  EXPECT_EQ(SPV_ERROR_INVALID_BINARY,
+            spvBinaryGetFingerprint(code.data(), code.size() - 1,
+                                    &fingerprint));
+  // A buffer shorter than the header can't be fingerprinted at all.
+  EXPECT_EQ(SPV_ERROR_INVALID_BINARY,
+            spvBinaryGetFingerprint(code.data(), 3, &fingerprint));
+}
+
+TEST_F(BinaryGetFingerprint, RejectsZeroWordCountInstruction) {
+  SpirvVector code = CompileSuccessfully(kModule);
+  code.push_back(0u);  // An "instruction" with word count zero.
+  spv_module_fingerprint_t fingerprint;
+  EXPECT_EQ(SPV_ERROR_INVALID_BINARY,
+            spvBinaryGetFingerprint(code.data(), code.size(), &fingerprint));
+}
+
+TEST_F(BinaryGetFingerprint, RejectsNullArguments) {
+  const SpirvVector code = CompileSuccessfully(kModule);
+  spv_module_fingerprint_t fingerprint;
+  EXPECT_EQ(SPV_ERROR_INVALID_POINTER,
+            spvBinaryGetFingerprint(nullptr, code.size(), &fingerprint));
+  EXPECT_EQ(SPV_ERROR_INVALID_POINTER,
+            spvBinaryGetFingerprint(code.data(), code.size(), nullptr));
+}
+
+}  // anonymous namespace
@@ -0,0 +1,159 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for spvBinaryParseToSoa.
+
+#include <vector>
+
+#include "test_fixture.h"
+#include "unit_spirv.h"
+
+namespace {
+
+using BinaryParseToSoa = spvtest::TextToBinaryTest;
+using SpirvVector = BinaryParseToSoa::SpirvVector;
+using spvtest::ScopedContext;
+
+const char kModule[] = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+%void = OpTypeVoid
+%voidfn = OpTypeFunction %void
+%main = OpFunction %void None %voidfn
+%entry = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+// Reference record built from the single-instruction callback, for
+// comparing attribute by attribute against the SoA view.
+struct ReferenceInstruction {
+  uint16_t opcode;
+  spv_ext_inst_type_t ext_inst_type;
+  uint32_t type_id;
+  uint32_t result_id;
+  uint16_t num_words;
+  std::vector<spv_parsed_operand_t> operands;
+};
+
+spv_result_t CollectReference(void* user_data,
+                              const spv_parsed_instruction_t* inst) {
+  auto* reference = static_cast<std::vector<ReferenceInstruction>*>(user_data);
+  reference->push_back({inst->opcode, inst->ext_inst_type, inst->type_id,
+                        inst->result_id, inst->num_words,
+                        std::vector<spv_parsed_operand_t>(
+                            inst->operands, inst->operands + inst->num_operands)});
+  return SPV_SUCCESS;
+}
+
+TEST_F(BinaryParseToSoa, AttributesMatchSingleInstructionParse) {
+  const SpirvVector code = CompileSuccessfully(kModule);
+
+  std::vector<ReferenceInstruction> reference;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryParse(ScopedContext().context, &reference, code.data(),
+                           code.size(), nullptr, CollectReference, nullptr));
+
+  spv_instruction_soa soa = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryParseToSoa(ScopedContext().context, code.data(),
+                                code.size(), &soa, nullptr));
+  ASSERT_NE(nullptr, soa);
+  ASSERT_EQ(reference.size(), soa->num_instructions);
+
+  uint32_t word_offset = SPV_INDEX_INSTRUCTION;
+  uint32_t operand_offset = 0;
+  for (uint32_t i = 0; i < soa->num_instructions; ++i) {
+    const ReferenceInstruction& expected = reference[i];
+    EXPECT_EQ(expected.opcode, soa->opcodes[i]) << "instruction " << i;
+    EXPECT_EQ(expected.ext_inst_type, soa->ext_inst_types[i]);
+    EXPECT_EQ(expected.type_id, soa->type_ids[i]);
+    EXPECT_EQ(expected.result_id, soa->result_ids[i]);
+    EXPECT_EQ(word_offset, soa->word_offsets[i]);
+    word_offset += expected.num_words;
+    ASSERT_EQ(operand_offset, soa->operand_offsets[i]);
+    for (const spv_parsed_operand_t& operand : expected.operands) {
+      const spv_parsed_operand_t& actual = soa->operands[operand_offset++];
+      EXPECT_EQ(operand.offset, actual.offset);
+      EXPECT_EQ(operand.num_words, actual.num_words);
+      EXPECT_EQ(operand.type, actual.type);
+      EXPECT_EQ(operand.number_kind, actual.number_kind);
+      EXPECT_EQ(operand.number_bit_width, actual.number_bit_width);
+    }
+  }
+  // The trailing offsets close the last instruction's spans.
+  EXPECT_EQ(code.size(), soa->word_offsets[soa->num_instructions]);
+  EXPECT_EQ(operand_offset, soa->operand_offsets[soa->num_instructions]);
+
+  spvInstructionSoaDestroy(soa);
+}
+
+TEST_F(BinaryParseToSoa, ScansOneAttributeAcrossInstructions) {
+  const SpirvVector code = CompileSuccessfully(kModule);
+  spv_instruction_soa soa = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryParseToSoa(ScopedContext().context, code.data(),
+                                code.size(), &soa, nullptr));
+  // The kind of loop the layout is for: one pass over just the opcodes.
+  uint32_t num_functions = 0;
+  for (uint32_t i = 0; i < soa->num_instructions; ++i) {
+    num_functions += (soa->opcodes[i] == SpvOpFunction);
+  }
+  EXPECT_EQ(1u, num_functions);
+  spvInstructionSoaDestroy(soa);
+}
+
+TEST_F(BinaryParseToSoa, EmptyModuleHasEmptyArrays) {
+  const SpirvVector code = CompileSuccessfully("");
+  spv_instruction_soa soa = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryParseToSoa(ScopedContext().context, code.data(),
+                                code.size(), &soa, nullptr));
+  EXPECT_EQ(0u, soa->num_instructions);
+  EXPECT_EQ(nullptr, soa->opcodes);
+  EXPECT_EQ(nullptr, soa->operands);
+  // The offset arrays keep their leading entries.
+  ASSERT_NE(nullptr, soa->word_offsets);
+  EXPECT_EQ(static_cast<uint32_t>(SPV_INDEX_INSTRUCTION),
+            soa->word_offsets[0]);
+  ASSERT_NE(nullptr, soa->operand_offsets);
+  EXPECT_EQ(0u, soa->operand_offsets[0]);
+  spvInstructionSoaDestroy(soa);
+}
+
+TEST_F(BinaryParseToSoa, RejectsInvalidBinaryWithDiagnostic) {
+  SpirvVector code = CompileSuccessfully(kModule);
+  code[0] = 0xdeadbeef;  // Not the SPIR-V magic number.
+  spv_instruction_soa soa = nullptr;
+  spv_diagnostic diagnostic = nullptr;
+  EXPECT_NE(SPV_SUCCESS,
+            spvBinaryParseToSoa(ScopedContext().context, code.data(),
+                                code.size(), &soa, &diagnostic));
+  EXPECT_EQ(nullptr, soa);
+  ASSERT_NE(nullptr, diagnostic);
+  spvDiagnosticDestroy(diagnostic);
+}
+
+TEST_F(BinaryParseToSoa, RejectsNullOutputPointer) {
+  const SpirvVector code = CompileSuccessfully(kModule);
+  EXPECT_EQ(SPV_ERROR_INVALID_POINTER,
+            spvBinaryParseToSoa(ScopedContext().context, code.data(),
+                                code.size(), nullptr, nullptr));
+}
+
+TEST_F(BinaryParseToSoa, DestroyNullIsNoop) { spvInstructionSoaDestroy(nullptr); }
+
+}  // anonymous namespace
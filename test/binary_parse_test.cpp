@@ -547,6 +547,124 @@ TEST_F(BinaryParseTest, ExtendedInstruction) {
   EXPECT_EQ(nullptr, diagnostic_);
 }
 
+TEST_F(BinaryParseTest, InstructionWithRunOfIdOperands) {
+  // OpFunctionCall decodes through the flattened fast path: a simple
+  // prefix of single-word operands followed by a run of argument Ids.
+  const auto instruction =
+      MakeInstruction(SpvOpFunctionCall, {2, 3, 4, 5, 6, 7});
+  const auto words = Concatenate({ExpectedHeaderForBound(8), instruction});
+  InSequence calls_expected_in_specific_order;
+  EXPECT_HEADER(8).WillOnce(Return(SPV_SUCCESS));
+  const auto operands = std::vector<spv_parsed_operand_t>{
+      MakeSimpleOperand(1, SPV_OPERAND_TYPE_TYPE_ID),
+      MakeSimpleOperand(2, SPV_OPERAND_TYPE_RESULT_ID),
+      MakeSimpleOperand(3, SPV_OPERAND_TYPE_ID),  // Function Id
+      MakeSimpleOperand(4, SPV_OPERAND_TYPE_ID),  // First argument
+      MakeSimpleOperand(5, SPV_OPERAND_TYPE_ID),
+      MakeSimpleOperand(6, SPV_OPERAND_TYPE_ID)};
+  EXPECT_CALL(client_,
+              Instruction(ParsedInstruction(spv_parsed_instruction_t{
+                  instruction.data(), static_cast<uint16_t>(instruction.size()),
+                  SpvOpFunctionCall, SPV_EXT_INST_TYPE_NONE, 2 /*type id*/,
+                  3 /*result id*/, operands.data(),
+                  static_cast<uint16_t>(operands.size())})))
+      .WillOnce(Return(SPV_SUCCESS));
+  // Since we are actually checking the output, don't test the
+  // endian-swapped version.
+  Parse(words, SPV_SUCCESS, false);
+  EXPECT_EQ(nullptr, diagnostic_);
+}
+
+// Accumulates the instructions delivered by either callback flavor, so a
+// batched parse can be compared against a one-at-a-time parse of the same
+// module.
+struct InstructionCollector {
+  std::vector<ParsedInstruction> instructions;
+  std::vector<size_t> batch_sizes;  // Instruction count of each batch.
+  spv_result_t result_for_batch = SPV_SUCCESS;  // Returned from each batch.
+};
+
+spv_result_t CollectInstruction(void* user_data,
+                                const spv_parsed_instruction_t* inst) {
+  static_cast<InstructionCollector*>(user_data)
+      ->instructions.emplace_back(*inst);
+  return SPV_SUCCESS;
+}
+
+spv_result_t CollectBatch(void* user_data,
+                          const spv_parsed_instruction_t* instructions,
+                          size_t num_instructions) {
+  auto* collector = static_cast<InstructionCollector*>(user_data);
+  collector->batch_sizes.push_back(num_instructions);
+  for (size_t i = 0; i < num_instructions; ++i) {
+    // The operands of every instruction in the batch live in one contiguous
+    // slab, in delivery order.
+    if (i > 0 && instructions[i - 1].num_operands > 0) {
+      EXPECT_EQ(instructions[i - 1].operands + instructions[i - 1].num_operands,
+                instructions[i].operands);
+    }
+    collector->instructions.emplace_back(instructions[i]);
+  }
+  return collector->result_for_batch;
+}
+
+using BinaryParseBatchTest = spvtest::TextToBinaryTestBase<::testing::Test>;
+
+TEST_F(BinaryParseBatchTest, BatchedParseMatchesSingleInstructionParse) {
+  // Use enough instructions to force several full batches plus a remainder.
+  std::ostringstream input;
+  input << "%1 = OpTypeVoid\n";
+  for (int i = 0; i < 600; ++i) input << "OpName %1 \"a name\"\n";
+  const auto words = CompileSuccessfully(input.str());
+
+  InstructionCollector single;
+  EXPECT_EQ(SPV_SUCCESS,
+            spvBinaryParse(ScopedContext().context, &single, words.data(),
+                           words.size(), nullptr, CollectInstruction, nullptr));
+  InstructionCollector batched;
+  EXPECT_EQ(SPV_SUCCESS,
+            spvBinaryParseBatched(ScopedContext().context, &batched,
+                                  words.data(), words.size(), nullptr,
+                                  CollectBatch, nullptr));
+
+  EXPECT_EQ(601u, single.instructions.size());
+  EXPECT_EQ(single.instructions, batched.instructions);
+  // Every batch was delivered, and it took more than one of them.
+  size_t total = 0;
+  for (size_t size : batched.batch_sizes) total += size;
+  EXPECT_EQ(batched.instructions.size(), total);
+  EXPECT_LT(1u, batched.batch_sizes.size());
+}
+
+TEST_F(BinaryParseBatchTest, BatchedParseOfSmallModuleDeliversOneBatch) {
+  const auto words = CompileSuccessfully(
+      "%1 = OpTypeVoid "
+      "%2 = OpTypeInt 32 1");
+  InstructionCollector batched;
+  EXPECT_EQ(SPV_SUCCESS,
+            spvBinaryParseBatched(ScopedContext().context, &batched,
+                                  words.data(), words.size(), nullptr,
+                                  CollectBatch, nullptr));
+  EXPECT_THAT(batched.batch_sizes, Eq(std::vector<size_t>{2}));
+  EXPECT_EQ(2u, batched.instructions.size());
+}
+
+TEST_F(BinaryParseBatchTest, EarlyReturnFromBatchCallback) {
+  const auto words = CompileSuccessfully(
+      "%1 = OpTypeVoid "
+      "%2 = OpTypeInt 32 1");
+  InstructionCollector batched;
+  batched.result_for_batch = SPV_REQUESTED_TERMINATION;
+  spv_diagnostic diagnostic = nullptr;
+  EXPECT_EQ(SPV_REQUESTED_TERMINATION,
+            spvBinaryParseBatched(ScopedContext().context, &batched,
+                                  words.data(), words.size(), nullptr,
+                                  CollectBatch, &diagnostic));
+  // On early termination, the binary parser doesn't generate its own
+  // diagnostics.
+  EXPECT_EQ(nullptr, diagnostic);
+}
+
 // A binary parser diagnostic test case where we provide the words array
 // pointer and word count explicitly.
 struct WordsAndCountDiagnosticCase {
@@ -26,6 +26,7 @@ namespace {
 using ::testing::Combine;
 using ::testing::Eq;
 using ::testing::HasSubstr;
+using ::testing::Not;
 using spvtest::AutoText;
 using spvtest::ScopedContext;
 using spvtest::TextToBinaryTest;
@@ -59,7 +60,7 @@ class BinaryToText : public ::testing::Test {
 %14 = OpTypeFloat 64
 %15 = OpTypeVector %4 2
 )";
-    spv_text_t text = {textStr, strlen(textStr)};
+    spv_text_t text = {textStr, strlen(textStr), {}};
     spv_diagnostic diagnostic = nullptr;
     spv_result_t error =
         spvTextToBinary(context, text.str, text.length, &binary, &diagnostic);
@@ -544,4 +545,78 @@ INSTANTIATE_TEST_CASE_P(GeneratorStrings, GeneratorStringTest,
                             {65535, 32767, "Unknown(65535); 32767"},
                         }), );
 
+// Returns the assembly text for a module with the given number of small
+// functions, suitable for exercising the parallel disassembly partitioner.
+std::string ManyFunctionsModule(int num_functions) {
+  std::stringstream source;
+  source << "OpMemoryModel Logical GLSL450\n";
+  source << "%void = OpTypeVoid\n";
+  source << "%fn = OpTypeFunction %void\n";
+  for (int i = 0; i < num_functions; ++i) {
+    source << "%f" << i << " = OpFunction %void None %fn\n";
+    source << "%entry" << i << " = OpLabel\n";
+    source << "OpReturn\n";
+    source << "OpFunctionEnd\n";
+  }
+  return source.str();
+}
+
+// Disassembles 'binary' with the given options and returns the text.
+std::string Disassemble(spv_context context, spv_binary binary,
+                        uint32_t options) {
+  spv_text text = nullptr;
+  spv_diagnostic diagnostic = nullptr;
+  EXPECT_EQ(SPV_SUCCESS,
+            spvBinaryToText(context, binary->code, binary->wordCount, options,
+                            &text, &diagnostic));
+  spvDiagnosticDestroy(diagnostic);
+  std::string result = text ? text->str : "";
+  spvTextDestroy(text);
+  return result;
+}
+
+TEST_F(BinaryToText, ParallelMatchesSequential) {
+  CompileSuccessfully(ManyFunctionsModule(17));
+  for (uint32_t options :
+       {uint32_t(SPV_BINARY_TO_TEXT_OPTION_NONE),
+        uint32_t(SPV_BINARY_TO_TEXT_OPTION_INDENT |
+                 SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES |
+                 SPV_BINARY_TO_TEXT_OPTION_SHOW_BYTE_OFFSET)}) {
+    EXPECT_EQ(Disassemble(context, binary, options),
+              Disassemble(context, binary,
+                          options | SPV_BINARY_TO_TEXT_OPTION_PARALLEL));
+  }
+}
+
+TEST_F(BinaryToText, RawIdsMatchesDefault) {
+  // Raw-id mode skips the name mapper and the per-id name cache, but the
+  // text is the same as default disassembly, which also prints ids as %N.
+  CompileSuccessfully(ManyFunctionsModule(3));
+  for (uint32_t options : {uint32_t(SPV_BINARY_TO_TEXT_OPTION_NONE),
+                           uint32_t(SPV_BINARY_TO_TEXT_OPTION_INDENT)}) {
+    EXPECT_EQ(Disassemble(context, binary, options),
+              Disassemble(context, binary,
+                          options | SPV_BINARY_TO_TEXT_OPTION_RAW_IDS));
+  }
+}
+
+TEST_F(BinaryToText, RawIdsOverrideFriendlyNames) {
+  CompileSuccessfully(
+      "OpMemoryModel Logical GLSL450\n%1 = OpTypeInt 32 0\n");
+  const std::string text = Disassemble(
+      context, binary,
+      SPV_BINARY_TO_TEXT_OPTION_RAW_IDS |
+          SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES);
+  EXPECT_THAT(text, HasSubstr("%1 = OpTypeInt 32 0"));
+  EXPECT_THAT(text, Not(HasSubstr("%uint")));
+}
+
+TEST_F(BinaryToText, ParallelWithoutFunctions) {
+  // With no function bodies to partition, the parallel option falls back
+  // to sequential disassembly.
+  CompileSuccessfully("OpMemoryModel Logical GLSL450\n%1 = OpTypeVoid\n");
+  EXPECT_EQ(Disassemble(context, binary, SPV_BINARY_TO_TEXT_OPTION_NONE),
+            Disassemble(context, binary, SPV_BINARY_TO_TEXT_OPTION_PARALLEL));
+}
+
 }  // anonymous namespace
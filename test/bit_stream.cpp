@@ -1135,4 +1135,87 @@ TEST(VariableWidthWriteRead, VariedNumbersChunkLength8) {
   EXPECT_EQ(expected_values, actual_values);
 }
 
+TEST(BitWriterWord64, WriteBitsBulkMatchesWriteBits) {
+  std::vector<uint64_t> values;
+  for (uint64_t i = 0; i < 1000; ++i)
+    values.push_back(i * 2654435761u);
+
+  for (size_t num_bits : {1, 3, 8, 13, 31, 33, 64}) {
+    BitWriterWord64 writer1;
+    BitWriterWord64 writer2;
+    // Start both at an unaligned position.
+    writer1.WriteBits(0x15, 5);
+    writer2.WriteBits(0x15, 5);
+
+    for (uint64_t val : values)
+      writer1.WriteBits(val, num_bits);
+    writer2.WriteBitsBulk(values.data(), values.size(), num_bits);
+
+    ASSERT_EQ(writer1.GetNumBits(), writer2.GetNumBits());
+    ASSERT_EQ(writer1.GetDataCopy(), writer2.GetDataCopy());
+
+    // Writes after a bulk write continue where it left off.
+    writer1.WriteBits(0x3, 2);
+    writer2.WriteBits(0x3, 2);
+    ASSERT_EQ(writer1.GetDataCopy(), writer2.GetDataCopy());
+  }
+}
+
+TEST(BitWriterWord64, ReserveBitsKeepsContentIntact) {
+  BitWriterWord64 writer1;
+  BitWriterWord64 writer2;
+  writer1.WriteBits(0x3, 2);
+  writer2.WriteBits(0x3, 2);
+  writer2.ReserveBits(100000);
+  EXPECT_EQ(2u, writer2.GetNumBits());
+  writer1.WriteBits(0xFF, 8);
+  writer2.WriteBits(0xFF, 8);
+  EXPECT_EQ(writer1.GetDataCopy(), writer2.GetDataCopy());
+}
+
+TEST(BitReaderWord64, ReadBitsBulkRoundTrip) {
+  const size_t num_bits = 13;
+  std::vector<uint64_t> values;
+  for (uint64_t i = 0; i < 10; ++i)
+    values.push_back((i * 997) & 0x1FFF);
+
+  BitWriterWord64 writer;
+  writer.WriteBitsBulk(values.data(), values.size(), num_bits);
+
+  BitReaderWord64 reader(writer.GetDataCopy());
+  std::vector<uint64_t> read_values(20, 0xDEAD);
+  // The buffer is padded to a whole number of 64-bit words (192 bits), so
+  // the reader sees 14 whole 13-bit values: ours plus four of padding
+  // zeroes.  The trailing 10 bits are not enough for a 15th value.
+  EXPECT_EQ(14u, reader.ReadBitsBulk(read_values.data(), read_values.size(),
+                                     num_bits));
+  for (size_t i = 0; i < values.size(); ++i)
+    EXPECT_EQ(values[i], read_values[i]);
+  for (size_t i = values.size(); i < 14; ++i)
+    EXPECT_EQ(0u, read_values[i]);
+  EXPECT_EQ(0xDEADu, read_values[14]);
+
+  // The partial tail was not consumed by the bulk read.
+  uint64_t tail = 1;
+  EXPECT_EQ(10u, reader.ReadBits(&tail, num_bits));
+  EXPECT_EQ(0u, tail);
+}
+
+TEST(BitReaderWord64, ReadBitsBulkMatchesReadBits) {
+  BitWriterWord64 writer;
+  for (uint64_t i = 0; i < 1000; ++i)
+    writer.WriteBits(i * 2654435761u, 23);
+
+  BitReaderWord64 reader1(writer.GetDataCopy());
+  BitReaderWord64 reader2(writer.GetDataCopy());
+
+  std::vector<uint64_t> bulk_values(1000, 0);
+  ASSERT_EQ(1000u, reader2.ReadBitsBulk(bulk_values.data(), 1000, 23));
+  for (size_t i = 0; i < 1000; ++i) {
+    uint64_t val = 0;
+    ASSERT_EQ(23u, reader1.ReadBits(&val, 23));
+    ASSERT_EQ(val, bulk_values[i]);
+  }
+}
+
 }  // anonymous namespace
@@ -12,10 +12,16 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "message.h"
 #include "spirv-tools/libspirv.h"
+#include "spirv/1.2/spirv.h"
 #include "table.h"
 
 namespace {
@@ -280,4 +286,566 @@ TEST(CInterface, SpecifyConsumerSpecifyDiagnosticForValidating) {
   spvContextDestroy(context);
 }
 
+TEST(CInterface, AssemblerSessionRepeatedCalls) {
+  auto context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  spv_assembler assembler = spvAssemblerCreate(context);
+  ASSERT_NE(nullptr, assembler);
+  const char input_text[] =
+      "OpCapability Shader\n"
+      "OpCapability Linkage\n"
+      "OpMemoryModel Logical GLSL450";
+
+  // Assemble the same module several times through one session.  The second
+  // and later calls resolve every token from the session's memo cache and
+  // must produce the same binary as a sessionless call.
+  spv_binary reference = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(context, input_text,
+                                         sizeof(input_text), &reference,
+                                         nullptr));
+  for (int i = 0; i < 3; ++i) {
+    spv_binary binary = nullptr;
+    EXPECT_EQ(SPV_SUCCESS,
+              spvAssemblerTextToBinary(assembler, input_text,
+                                       sizeof(input_text), 0, &binary,
+                                       nullptr));
+    ASSERT_NE(nullptr, binary);
+    ASSERT_EQ(reference->wordCount, binary->wordCount);
+    EXPECT_EQ(0, memcmp(reference->code, binary->code,
+                        sizeof(uint32_t) * binary->wordCount));
+    spvBinaryDestroy(binary);
+  }
+
+  spvBinaryDestroy(reference);
+  spvAssemblerDestroy(assembler);
+  spvContextDestroy(context);
+}
+
+TEST(CInterface, AssemblerSessionReportsErrors) {
+  auto context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  spv_assembler assembler = spvAssemblerCreate(context);
+  ASSERT_NE(nullptr, assembler);
+
+  // A failed assembly must not poison the session for later calls.
+  const char bad_text[] = "OpThisIsNotAnOpcode";
+  spv_binary binary = nullptr;
+  spv_diagnostic diagnostic = nullptr;
+  EXPECT_EQ(SPV_ERROR_INVALID_TEXT,
+            spvAssemblerTextToBinary(assembler, bad_text, sizeof(bad_text), 0,
+                                     &binary, &diagnostic));
+  spvDiagnosticDestroy(diagnostic);
+
+  const char good_text[] = "OpMemoryModel Logical GLSL450";
+  EXPECT_EQ(SPV_SUCCESS,
+            spvAssemblerTextToBinary(assembler, good_text, sizeof(good_text),
+                                     0, &binary, nullptr));
+  spvBinaryDestroy(binary);
+  spvAssemblerDestroy(assembler);
+  spvContextDestroy(context);
+}
+
+// Grow callback backing spvTextToBinaryToSink with a std::vector.
+uint32_t* GrowVectorSink(void* user_data, size_t word_count) {
+  auto* words = static_cast<std::vector<uint32_t>*>(user_data);
+  if (words->size() < word_count) words->resize(word_count);
+  return words->data();
+}
+
+TEST(CInterface, TextToBinaryToSinkMatchesSpvBinary) {
+  auto context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  const char input_text[] =
+      "OpCapability Shader\n"
+      "OpCapability Linkage\n"
+      "OpMemoryModel Logical GLSL450";
+
+  spv_binary reference = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(context, input_text,
+                                         sizeof(input_text), &reference,
+                                         nullptr));
+
+  // The sink path must produce the identical words, reporting the exact
+  // count even if the sink's buffer was grown beyond it.
+  std::vector<uint32_t> words;
+  spv_word_sink_t sink = {&words, GrowVectorSink};
+  size_t word_count = 0;
+  EXPECT_EQ(SPV_SUCCESS,
+            spvTextToBinaryToSink(context, input_text, sizeof(input_text), 0,
+                                  &sink, &word_count, nullptr));
+  ASSERT_EQ(reference->wordCount, word_count);
+  ASSERT_LE(word_count, words.size());
+  EXPECT_EQ(0, memcmp(reference->code, words.data(),
+                      sizeof(uint32_t) * word_count));
+
+  spvBinaryDestroy(reference);
+  spvContextDestroy(context);
+}
+
+TEST(CInterface, TextToBinaryToSinkReportsErrors) {
+  auto context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  const char bad_text[] = "OpThisIsNotAnOpcode";
+  std::vector<uint32_t> words;
+  spv_word_sink_t sink = {&words, GrowVectorSink};
+  size_t word_count = 0;
+  spv_diagnostic diagnostic = nullptr;
+  EXPECT_EQ(SPV_ERROR_INVALID_TEXT,
+            spvTextToBinaryToSink(context, bad_text, sizeof(bad_text), 0,
+                                  &sink, &word_count, &diagnostic));
+  EXPECT_NE(nullptr, diagnostic);
+  spvDiagnosticDestroy(diagnostic);
+  spvContextDestroy(context);
+}
+
+// A streaming disassembler only supports printing, and rejects options
+// that need the whole module before the first line of text.
+TEST(CInterface, StreamingDisassemblerRejectsWholeModuleOptions) {
+  auto context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  EXPECT_EQ(nullptr, spvStreamingDisassemblerCreate(
+                         context, SPV_BINARY_TO_TEXT_OPTION_NONE));
+  EXPECT_EQ(nullptr, spvStreamingDisassemblerCreate(
+                         context, SPV_BINARY_TO_TEXT_OPTION_PRINT |
+                                      SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES));
+  EXPECT_EQ(nullptr, spvStreamingDisassemblerCreate(
+                         context, SPV_BINARY_TO_TEXT_OPTION_PRINT |
+                                      SPV_BINARY_TO_TEXT_OPTION_PARALLEL));
+  spvStreamingDisassemblerDestroy(nullptr);  // Should not crash.
+  spvContextDestroy(context);
+}
+
+TEST(CInterface, StreamingDisassemblerMatchesBinaryToText) {
+  auto context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  const char input_text[] =
+      "OpCapability Shader\n"
+      "OpCapability Linkage\n"
+      "OpMemoryModel Logical GLSL450\n"
+      "%1 = OpTypeVoid\n";
+
+  spv_binary binary = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(context, input_text,
+                                         sizeof(input_text), &binary, nullptr));
+
+  spv_text reference = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryToText(context, binary->code, binary->wordCount,
+                            SPV_BINARY_TO_TEXT_OPTION_NONE, &reference,
+                            nullptr));
+
+  // Feed the module one word at a time, capturing what the session prints.
+  // The streamed text must equal whole-module disassembly with the same
+  // formatting options.
+  spv_streaming_disassembler stream = spvStreamingDisassemblerCreate(
+      context, SPV_BINARY_TO_TEXT_OPTION_PRINT);
+  ASSERT_NE(nullptr, stream);
+  std::ostringstream captured;
+  std::streambuf* saved_buf = std::cout.rdbuf(captured.rdbuf());
+  spv_result_t error = SPV_SUCCESS;
+  for (size_t i = 1; i <= binary->wordCount && !error; ++i) {
+    error = spvStreamingDisassemblerParse(stream, binary->code, i,
+                                          i == binary->wordCount, nullptr);
+  }
+  std::cout.rdbuf(saved_buf);
+  EXPECT_EQ(SPV_SUCCESS, error);
+  EXPECT_EQ(reference->str, captured.str());
+
+  spvStreamingDisassemblerDestroy(stream);
+  spvTextDestroy(reference);
+  spvBinaryDestroy(binary);
+  spvContextDestroy(context);
+}
+
+TEST(CInterface, StreamingDisassemblerReportsErrors) {
+  auto context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  spv_streaming_disassembler stream = spvStreamingDisassemblerCreate(
+      context, SPV_BINARY_TO_TEXT_OPTION_PRINT);
+  ASSERT_NE(nullptr, stream);
+  const uint32_t not_a_module[] = {0xdeadbeef, 0, 0, 0, 0};
+  spv_diagnostic diagnostic = nullptr;
+  EXPECT_NE(SPV_SUCCESS,
+            spvStreamingDisassemblerParse(stream, not_a_module, 5, true,
+                                          &diagnostic));
+  EXPECT_NE(nullptr, diagnostic);
+  spvDiagnosticDestroy(diagnostic);
+  spvStreamingDisassemblerDestroy(stream);
+  spvContextDestroy(context);
+}
+
+TEST(CInterface, SpecConstantIndexAndSpecialize) {
+  auto context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  const char input_text[] =
+      "OpCapability Shader\n"
+      "OpCapability Linkage\n"
+      "OpMemoryModel Logical GLSL450\n"
+      "OpDecorate %narrow SpecId 100\n"
+      "OpDecorate %wide SpecId 101\n"
+      "OpDecorate %flag SpecId 102\n"
+      "%uint = OpTypeInt 32 0\n"
+      "%ulong = OpTypeInt 64 0\n"
+      "%bool = OpTypeBool\n"
+      "%narrow = OpSpecConstant %uint 42\n"
+      "%wide = OpSpecConstant %ulong 99\n"
+      "%flag = OpSpecConstantTrue %bool\n"
+      "%plain = OpConstant %uint 7\n";
+  spv_binary binary = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(context, input_text,
+                                         sizeof(input_text), &binary, nullptr));
+
+  spv_spec_constant_index index = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryBuildSpecConstantIndex(context, binary->code,
+                                            binary->wordCount, &index,
+                                            nullptr));
+  ASSERT_NE(nullptr, index);
+  // Only the three decorated spec constants are indexed; the ordinary
+  // OpConstant is not.
+  ASSERT_EQ(3u, index->num_constants);
+  EXPECT_EQ(100u, index->constants[0].spec_id);
+  EXPECT_EQ(1u, index->constants[0].num_literal_words);
+  EXPECT_EQ(101u, index->constants[1].spec_id);
+  EXPECT_EQ(2u, index->constants[1].num_literal_words);
+  EXPECT_EQ(102u, index->constants[2].spec_id);
+  EXPECT_EQ(0u, index->constants[2].num_literal_words);
+
+  // Patch a copy of the module: one value set per permutation, applied
+  // without re-parsing.  An unknown spec id is ignored.
+  std::vector<uint32_t> permutation(binary->code,
+                                    binary->code + binary->wordCount);
+  const spv_spec_constant_value_t new_values[] = {
+      {100, 5}, {101, 0x0000000a00000009ull}, {102, 0}, {999, 1}};
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinarySpecialize(index, permutation.data(), permutation.size(),
+                                new_values, 4));
+  EXPECT_EQ(5u, permutation[index->constants[0].literal_offset]);
+  EXPECT_EQ(9u, permutation[index->constants[1].literal_offset]);
+  EXPECT_EQ(10u, permutation[index->constants[1].literal_offset + 1]);
+  EXPECT_EQ(uint32_t(SpvOpSpecConstantFalse),
+            permutation[index->constants[2].opcode_offset] & 0xffffu);
+  // Untouched words are bit-identical to the original.
+  EXPECT_EQ(42u, binary->code[index->constants[0].literal_offset]);
+  EXPECT_EQ(uint32_t(SpvOpSpecConstantTrue),
+            binary->code[index->constants[2].opcode_offset] & 0xffffu);
+
+  // The patched copy still disassembles, with the substituted values.
+  spv_text text = nullptr;
+  EXPECT_EQ(SPV_SUCCESS,
+            spvBinaryToText(context, permutation.data(), permutation.size(),
+                            SPV_BINARY_TO_TEXT_OPTION_NONE, &text, nullptr));
+  EXPECT_NE(nullptr, strstr(text->str, "OpSpecConstantFalse"));
+  spvTextDestroy(text);
+
+  spvSpecConstantIndexDestroy(index);
+  spvBinaryDestroy(binary);
+  spvContextDestroy(context);
+}
+
+TEST(CInterface, SpecializeBatchProducesOneBinaryPerValueSet) {
+  auto context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  const char input_text[] =
+      "OpCapability Shader\n"
+      "OpCapability Linkage\n"
+      "OpMemoryModel Logical GLSL450\n"
+      "OpDecorate %width SpecId 7\n"
+      "%uint = OpTypeInt 32 0\n"
+      "%width = OpSpecConstant %uint 1\n";
+  spv_binary binary = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(context, input_text,
+                                         sizeof(input_text), &binary, nullptr));
+
+  // Three permutations of the same module, differing only in the patched
+  // value; the middle one leaves the default in place.
+  const spv_spec_constant_value_t first[] = {{7, 16}};
+  const spv_spec_constant_value_t third[] = {{7, 64}};
+  const spv_spec_constant_value_set_t sets[] = {
+      {first, 1}, {nullptr, 0}, {third, 1}};
+  spv_binary results[3] = {nullptr, nullptr, nullptr};
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinarySpecializeBatch(context, binary->code, binary->wordCount,
+                                     sets, 3, results, nullptr));
+
+  spv_spec_constant_index index = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryBuildSpecConstantIndex(context, binary->code,
+                                            binary->wordCount, &index,
+                                            nullptr));
+  ASSERT_EQ(1u, index->num_constants);
+  const uint32_t literal_offset = index->constants[0].literal_offset;
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, results[i]);
+    EXPECT_EQ(binary->wordCount, results[i]->wordCount);
+  }
+  EXPECT_EQ(16u, results[0]->code[literal_offset]);
+  EXPECT_EQ(1u, results[1]->code[literal_offset]);
+  EXPECT_EQ(64u, results[2]->code[literal_offset]);
+
+  spvSpecConstantIndexDestroy(index);
+  for (int i = 0; i < 3; ++i) spvBinaryDestroy(results[i]);
+  spvBinaryDestroy(binary);
+  spvContextDestroy(context);
+}
+
+TEST(CInterface, StripDebugInfoMatchesModuleWithoutDebugInstructions) {
+  auto context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  const char input_text[] =
+      "OpCapability Shader\n"
+      "OpCapability Linkage\n"
+      "%src = OpString \"shader.frag\"\n"
+      "OpSource GLSL 450\n"
+      "OpName %v \"value\"\n"
+      "OpMemoryModel Logical GLSL450\n"
+      "%uint = OpTypeInt 32 0\n"
+      "OpLine %src 1 1\n"
+      "%v = OpConstant %uint 3\n"
+      "OpNoLine\n";
+  spv_binary binary = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(context, input_text,
+                                         sizeof(input_text), &binary, nullptr));
+
+  spv_binary stripped = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryStripDebugInfo(context, binary->code, binary->wordCount,
+                                    &stripped, nullptr));
+  ASSERT_NE(nullptr, stripped);
+  // Stripping only drops instructions: the header, including the original
+  // id bound, is untouched, and the surviving instructions keep their ids.
+  ASSERT_LT(stripped->wordCount, binary->wordCount);
+  EXPECT_EQ(0, memcmp(binary->code, stripped->code, 5 * sizeof(uint32_t)));
+
+  spv_text text = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryToText(context, stripped->code, stripped->wordCount,
+                            SPV_BINARY_TO_TEXT_OPTION_NO_HEADER, &text,
+                            nullptr));
+  EXPECT_EQ(nullptr, strstr(text->str, "OpString"));
+  EXPECT_EQ(nullptr, strstr(text->str, "OpSource"));
+  EXPECT_EQ(nullptr, strstr(text->str, "OpName"));
+  EXPECT_EQ(nullptr, strstr(text->str, "OpLine"));
+  EXPECT_EQ(nullptr, strstr(text->str, "OpNoLine"));
+  EXPECT_NE(nullptr, strstr(text->str, "OpConstant"));
+
+  spvTextDestroy(text);
+  spvBinaryDestroy(stripped);
+  spvBinaryDestroy(binary);
+  spvContextDestroy(context);
+}
+
+TEST(CInterface, BinaryToTextFunctionDisassemblesOneFunction) {
+  auto context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  const char input_text[] =
+      "OpCapability Shader\n"
+      "OpCapability Linkage\n"
+      "OpMemoryModel Logical GLSL450\n"
+      "%void = OpTypeVoid\n"
+      "%uint = OpTypeInt 32 0\n"
+      "%c = OpConstant %uint 42\n"
+      "%fnty = OpTypeFunction %void\n"
+      "%f = OpFunction %void None %fnty\n"
+      "%fb = OpLabel\n"
+      "OpReturn\n"
+      "OpFunctionEnd\n"
+      "%g = OpFunction %void None %fnty\n"
+      "%gb = OpLabel\n"
+      "OpReturn\n"
+      "OpFunctionEnd\n";
+  spv_binary binary = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(context, input_text,
+                                         sizeof(input_text), &binary, nullptr));
+
+  spv_function_index index = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryBuildFunctionIndex(context, binary->code,
+                                        binary->wordCount, &index, nullptr));
+  ASSERT_EQ(2u, index->num_functions);
+  const uint32_t second_id = index->functions[1].id;
+  spvFunctionIndexDestroy(index);
+
+  spv_text text = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryToTextFunction(context, binary->code, binary->wordCount,
+                                    SPV_BINARY_TO_TEXT_OPTION_NO_HEADER,
+                                    second_id, &text, nullptr));
+  // Only the requested function appears: no global instructions and a
+  // single OpFunction/OpFunctionEnd pair.
+  EXPECT_EQ(nullptr, strstr(text->str, "OpCapability"));
+  EXPECT_EQ(nullptr, strstr(text->str, "OpConstant"));
+  const char* first_function = strstr(text->str, "OpFunction ");
+  ASSERT_NE(nullptr, first_function);
+  EXPECT_EQ(nullptr, strstr(first_function + 1, "OpFunction "));
+  EXPECT_NE(nullptr, strstr(text->str, "OpFunctionEnd"));
+  spvTextDestroy(text);
+
+  // An id that is not a function is a lookup failure.
+  spv_diagnostic diagnostic = nullptr;
+  EXPECT_EQ(SPV_ERROR_INVALID_LOOKUP,
+            spvBinaryToTextFunction(context, binary->code, binary->wordCount,
+                                    SPV_BINARY_TO_TEXT_OPTION_NO_HEADER,
+                                    9999u, &text, &diagnostic));
+  EXPECT_NE(nullptr, diagnostic);
+  spvDiagnosticDestroy(diagnostic);
+
+  spvBinaryDestroy(binary);
+  spvContextDestroy(context);
+}
+
+TEST(CInterface, BinaryToTextRangeRejectsBadBounds) {
+  auto context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  const char input_text[] =
+      "OpCapability Shader\n"
+      "OpCapability Linkage\n"
+      "OpMemoryModel Logical GLSL450\n";
+  spv_binary binary = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(context, input_text,
+                                         sizeof(input_text), &binary, nullptr));
+
+  spv_text text = nullptr;
+  spv_diagnostic diagnostic = nullptr;
+  EXPECT_EQ(SPV_ERROR_INVALID_BINARY,
+            spvBinaryToTextRange(context, binary->code, binary->wordCount,
+                                 SPV_BINARY_TO_TEXT_OPTION_NO_HEADER, 5,
+                                 binary->wordCount + 10, &text, &diagnostic));
+  EXPECT_NE(nullptr, diagnostic);
+  spvDiagnosticDestroy(diagnostic);
+
+  spvBinaryDestroy(binary);
+  spvContextDestroy(context);
+}
+
+TEST(CInterface, BinaryDiffAndApplyRoundTrip) {
+  auto context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  const char base_text[] =
+      "OpCapability Shader\n"
+      "OpCapability Linkage\n"
+      "OpMemoryModel Logical GLSL450\n"
+      "%uint = OpTypeInt 32 0\n"
+      "%a = OpConstant %uint 100\n"
+      "%b = OpConstant %uint 200\n"
+      "%c = OpConstant %uint 300\n";
+  // Same module with only one constant's value changed.
+  const char target_text[] =
+      "OpCapability Shader\n"
+      "OpCapability Linkage\n"
+      "OpMemoryModel Logical GLSL450\n"
+      "%uint = OpTypeInt 32 0\n"
+      "%a = OpConstant %uint 100\n"
+      "%b = OpConstant %uint 201\n"
+      "%c = OpConstant %uint 300\n";
+  spv_binary base = nullptr;
+  spv_binary target = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(context, base_text, sizeof(base_text),
+                                         &base, nullptr));
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(context, target_text,
+                                         sizeof(target_text), &target,
+                                         nullptr));
+
+  spv_binary delta = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryDiff(context, base->code, base->wordCount, target->code,
+                          target->wordCount, &delta, nullptr));
+  ASSERT_NE(nullptr, delta);
+  // Only one instruction changed, so the delta should be well under the
+  // size of the target it reconstructs.
+  EXPECT_LT(delta->wordCount, target->wordCount);
+
+  spv_binary rebuilt = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryApplyDelta(base->code, base->wordCount, delta->code,
+                                delta->wordCount, &rebuilt));
+  ASSERT_NE(nullptr, rebuilt);
+  ASSERT_EQ(target->wordCount, rebuilt->wordCount);
+  EXPECT_EQ(0, memcmp(target->code, rebuilt->code,
+                      target->wordCount * sizeof(uint32_t)));
+
+  spvBinaryDestroy(rebuilt);
+  spvBinaryDestroy(delta);
+  spvBinaryDestroy(target);
+  spvBinaryDestroy(base);
+  spvContextDestroy(context);
+}
+
+TEST(CInterface, ApplyDeltaRejectsCorruptInput) {
+  auto context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  const char text[] =
+      "OpCapability Shader\n"
+      "OpCapability Linkage\n"
+      "OpMemoryModel Logical GLSL450\n"
+      "%uint = OpTypeInt 32 0\n"
+      "%a = OpConstant %uint 42\n";
+  spv_binary binary = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvTextToBinary(context, text, sizeof(text), &binary, nullptr));
+
+  spv_binary delta = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryDiff(context, binary->code, binary->wordCount,
+                          binary->code, binary->wordCount, &delta, nullptr));
+
+  // A SPIR-V module is not a delta.
+  spv_binary rebuilt = nullptr;
+  EXPECT_EQ(SPV_ERROR_INVALID_BINARY,
+            spvBinaryApplyDelta(binary->code, binary->wordCount, binary->code,
+                                binary->wordCount, &rebuilt));
+
+  // A copy directive pointing past the end of the base must be rejected.
+  std::vector<uint32_t> corrupt(delta->code, delta->code + delta->wordCount);
+  corrupt.back() = static_cast<uint32_t>(binary->wordCount);
+  EXPECT_EQ(SPV_ERROR_INVALID_BINARY,
+            spvBinaryApplyDelta(binary->code, binary->wordCount,
+                                corrupt.data(), corrupt.size(), &rebuilt));
+
+  spvBinaryDestroy(delta);
+  spvBinaryDestroy(binary);
+  spvContextDestroy(context);
+}
+
+TEST(CInterface, FunctionIndexAndPartialParse) {
+  auto context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  const char input_text[] =
+      "OpCapability Shader\n"
+      "OpCapability Linkage\n"
+      "OpMemoryModel Logical GLSL450\n"
+      "%void = OpTypeVoid\n"
+      "%fnty = OpTypeFunction %void\n"
+      "%f = OpFunction %void None %fnty\n"
+      "%fb = OpLabel\n"
+      "OpReturn\n"
+      "OpFunctionEnd\n"
+      "%g = OpFunction %void None %fnty\n"
+      "%gb1 = OpLabel\n"
+      "OpBranch %gb2\n"
+      "%gb2 = OpLabel\n"
+      "OpReturn\n"
+      "OpFunctionEnd\n";
+  spv_binary binary = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(context, input_text,
+                                         sizeof(input_text), &binary, nullptr));
+
+  spv_function_index index = nullptr;
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryBuildFunctionIndex(context, binary->code,
+                                        binary->wordCount, &index, nullptr));
+  ASSERT_EQ(2u, index->num_functions);
+  EXPECT_EQ(1u, index->functions[0].num_blocks);
+  EXPECT_EQ(2u, index->functions[1].num_blocks);
+  // The functions cover the tail of the module with no gap between them.
+  EXPECT_EQ(index->functions[0].end, index->functions[1].begin);
+  EXPECT_EQ(binary->wordCount, index->functions[1].end);
+
+  // Parse only the second function and record the reported opcodes.
+  std::vector<uint16_t> opcodes;
+  auto record_opcode = [](void* user_data,
+                          const spv_parsed_instruction_t* inst) {
+    static_cast<std::vector<uint16_t>*>(user_data)->push_back(inst->opcode);
+    return SPV_SUCCESS;
+  };
+  ASSERT_EQ(SPV_SUCCESS,
+            spvBinaryParseFunction(context, &opcodes, binary->code,
+                                   binary->wordCount,
+                                   index->functions[1].begin,
+                                   index->functions[1].end, record_opcode,
+                                   nullptr));
+  ASSERT_EQ(6u, opcodes.size());
+  EXPECT_EQ(uint16_t(SpvOpFunction), opcodes.front());
+  EXPECT_EQ(uint16_t(SpvOpFunctionEnd), opcodes.back());
+
+  spvFunctionIndexDestroy(index);
+  spvBinaryDestroy(binary);
+  spvContextDestroy(context);
+}
+
 }  // anonymous namespace
@@ -87,6 +87,41 @@ TEST(CppInterface, AssembleOverloads) {
   }
 }
 
+TEST(CppInterface, AssembleIntoOwnedBinary) {
+  const std::string input_text = "%2 = OpSizeOf %1 %3\n";
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+
+  OwnedBinary binary;
+  EXPECT_TRUE(t.Assemble(input_text, &binary));
+  EXPECT_TRUE(binary.size() > 5u);
+  EXPECT_EQ(SpvMagicNumber, binary.data()[0]);
+  EXPECT_EQ(SpvVersion, binary.data()[1]);
+
+  // Failed assembly leaves the previous contents in place.
+  OwnedBinary moved = std::move(binary);
+  EXPECT_EQ(nullptr, binary.data());
+  EXPECT_EQ(0u, binary.size());
+  EXPECT_FALSE(t.Assemble("!badbang", &moved));
+  EXPECT_TRUE(moved.size() > 5u);
+  EXPECT_EQ(SpvMagicNumber, moved.data()[0]);
+}
+
+TEST(CppInterface, DisassembleIntoOwnedText) {
+  const std::string input_text = "%2 = OpSizeOf %1 %3\n";
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+
+  std::vector<uint32_t> binary;
+  EXPECT_TRUE(t.Assemble(input_text, &binary));
+
+  OwnedText output_text;
+  EXPECT_TRUE(t.Disassemble(binary, &output_text));
+  EXPECT_EQ(input_text, std::string(output_text.data(), output_text.size()));
+
+  // Failed disassembly leaves the previous contents in place.
+  EXPECT_FALSE(t.Disassemble(nullptr, 0, &output_text));
+  EXPECT_EQ(input_text, std::string(output_text.data(), output_text.size()));
+}
+
 TEST(CppInterface, AssembleWithWrongTargetEnv) {
   const std::string input_text = "%r = OpSizeOf %type %pointer";
   SpirvTools t(SPV_ENV_UNIVERSAL_1_0);
@@ -262,6 +297,182 @@ TEST(CppInterface, ValidateWithOptionsFail) {
           "Number of OpTypeStruct members (10) has exceeded the limit (9)"));
 }
 
+TEST(CppInterface, ValidatePooledRepeatedCalls) {
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  std::vector<uint32_t> valid_binary;
+  ASSERT_TRUE(t.Assemble(R"(
+    OpCapability Shader
+    OpCapability Linkage
+    OpMemoryModel Logical GLSL450)",
+                         &valid_binary));
+  // This cannot pass validation since %1 is not defined.
+  std::vector<uint32_t> invalid_binary;
+  ASSERT_TRUE(t.Assemble("%2 = OpSizeOf %1 %3", &invalid_binary));
+
+  // The pooled state must produce the same answers on every reuse,
+  // regardless of what the previous call left behind.
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_TRUE(t.ValidatePooled(valid_binary.data(), valid_binary.size()));
+    EXPECT_FALSE(
+        t.ValidatePooled(invalid_binary.data(), invalid_binary.size()));
+  }
+}
+
+TEST(CppInterface, ValidatePooledWithOptions) {
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  std::vector<uint32_t> binary;
+  EXPECT_TRUE(t.Assemble(MakeModuleHavingStruct(10), &binary));
+  spvtools::ValidatorOptions strict_opts;
+  strict_opts.SetUniversalLimit(spv_validator_limit_max_struct_members, 9);
+  const spvtools::ValidatorOptions default_opts;
+
+  EXPECT_FALSE(t.ValidatePooled(binary.data(), binary.size(), strict_opts));
+  // The previous failure must not linger in the reused state.
+  EXPECT_TRUE(t.ValidatePooled(binary.data(), binary.size(), default_opts));
+}
+
+TEST(CppInterface, AssembleBatchMatchesSingleModuleAssembly) {
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  std::vector<std::string> texts;
+  for (int i = 0; i < 20; ++i) {
+    std::stringstream os;
+    os << "%" << i + 2 << " = OpSizeOf %1 %" << i + 30 << "\n";
+    texts.push_back(os.str());
+  }
+
+  std::vector<std::vector<uint32_t>> binaries;
+  EXPECT_TRUE(t.AssembleBatch(texts, &binaries));
+  ASSERT_EQ(texts.size(), binaries.size());
+  for (size_t i = 0; i < texts.size(); ++i) {
+    std::vector<uint32_t> single;
+    EXPECT_TRUE(t.Assemble(texts[i], &single));
+    EXPECT_THAT(binaries[i], ContainerEq(single));
+  }
+}
+
+TEST(CppInterface, AssembleBatchReportsFailuresInOrder) {
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<std::string> messages;
+  t.SetMessageConsumer(
+      [&messages](spv_message_level_t level, const char* source,
+                  const spv_position_t&, const char* message) {
+        EXPECT_EQ(SPV_MSG_ERROR, level);
+        EXPECT_STREQ("input", source);
+        messages.push_back(message);
+      });
+
+  // OpSizeOf needs SPIR-V 1.1, so those modules fail in a 1.0 environment.
+  const std::vector<std::string> texts = {
+      "OpSource GLSL 450", "%r = OpSizeOf %type %pointer", "OpNothing",
+      "OpSource GLSL 450"};
+  std::vector<std::vector<uint32_t>> binaries;
+  EXPECT_FALSE(t.AssembleBatch(texts, &binaries));
+  ASSERT_EQ(texts.size(), binaries.size());
+  EXPECT_FALSE(binaries[0].empty());
+  EXPECT_TRUE(binaries[1].empty());
+  EXPECT_TRUE(binaries[2].empty());
+  EXPECT_FALSE(binaries[3].empty());
+  ASSERT_EQ(2u, messages.size());
+  EXPECT_EQ("Invalid Opcode name 'OpSizeOf'", messages[0]);
+  EXPECT_EQ("Invalid Opcode name 'OpNothing'", messages[1]);
+}
+
+TEST(CppInterface, ValidateBatch) {
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  std::vector<uint32_t> valid_binary;
+  ASSERT_TRUE(t.Assemble(R"(
+    OpCapability Shader
+    OpCapability Linkage
+    OpMemoryModel Logical GLSL450)",
+                         &valid_binary));
+  // This cannot pass validation since %1 is not defined.
+  std::vector<uint32_t> invalid_binary;
+  ASSERT_TRUE(t.Assemble("%2 = OpSizeOf %1 %3", &invalid_binary));
+
+  std::vector<bool> results;
+  EXPECT_FALSE(t.ValidateBatch({valid_binary, invalid_binary}, &results));
+  ASSERT_EQ(2u, results.size());
+  EXPECT_TRUE(results[0]);
+  EXPECT_FALSE(results[1]);
+
+  // The per-module results are optional.
+  EXPECT_TRUE(t.ValidateBatch({valid_binary, valid_binary}));
+}
+
+TEST(CppInterface, FunctionHashesIgnoreIdsAndLineInfo) {
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  // Two modules holding the same two functions: the second module renames
+  // every id and adds line debug info to the first function, and swaps the
+  // bodies so the ids land in a different numeric range.
+  const std::string module_a = R"(
+    OpCapability Addresses
+    OpCapability Kernel
+    OpCapability Linkage
+    OpMemoryModel Physical32 OpenCL
+    %str = OpString "a.cl"
+    %void = OpTypeVoid
+    %uint = OpTypeInt 32 0
+    %fnty = OpTypeFunction %void
+    %c1 = OpConstant %uint 1
+    %f = OpFunction %void None %fnty
+    %fb = OpLabel
+    %fv = OpIAdd %uint %c1 %c1
+    OpReturn
+    OpFunctionEnd
+    %g = OpFunction %void None %fnty
+    %gb = OpLabel
+    %gv = OpIMul %uint %c1 %c1
+    OpReturn
+    OpFunctionEnd)";
+  const std::string module_b = R"(
+    OpCapability Addresses
+    OpCapability Kernel
+    OpCapability Linkage
+    OpMemoryModel Physical32 OpenCL
+    %str = OpString "b.cl"
+    %void2 = OpTypeVoid
+    %uint2 = OpTypeInt 32 0
+    %fnty2 = OpTypeFunction %void2
+    %one = OpConstant %uint2 1
+    %g2 = OpFunction %void2 None %fnty2
+    %gb2 = OpLabel
+    %gv2 = OpIMul %uint2 %one %one
+    OpReturn
+    OpFunctionEnd
+    %f2 = OpFunction %void2 None %fnty2
+    %fb2 = OpLabel
+    OpLine %str 1 1
+    %fv2 = OpIAdd %uint2 %one %one
+    OpNoLine
+    OpReturn
+    OpFunctionEnd)";
+  std::vector<uint32_t> binary_a, binary_b;
+  ASSERT_TRUE(t.Assemble(module_a, &binary_a));
+  ASSERT_TRUE(t.Assemble(module_b, &binary_b));
+
+  std::vector<spvtools::FunctionHash> hashes_a, hashes_b;
+  ASSERT_TRUE(t.ComputeFunctionHashes(binary_a, &hashes_a));
+  ASSERT_TRUE(t.ComputeFunctionHashes(binary_b, &hashes_b));
+  ASSERT_EQ(2u, hashes_a.size());
+  ASSERT_EQ(2u, hashes_b.size());
+  // The IAdd function and the IMul function match across the modules
+  // despite renamed ids, the added line info, and the swapped order.
+  EXPECT_EQ(hashes_a[0].hash, hashes_b[1].hash);
+  EXPECT_EQ(hashes_a[1].hash, hashes_b[0].hash);
+  // Different bodies yield different hashes.
+  EXPECT_NE(hashes_a[0].hash, hashes_a[1].hash);
+}
+
+TEST(CppInterface, FunctionHashesRejectInvalidBinary) {
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  const std::vector<uint32_t> garbage = {0xdeadbeef, 1, 2, 3, 4};
+  std::vector<spvtools::FunctionHash> hashes = {{42u, 42u}};
+  EXPECT_FALSE(t.ComputeFunctionHashes(garbage, &hashes));
+  // An unparsable module leaves the output untouched.
+  ASSERT_EQ(1u, hashes.size());
+  EXPECT_EQ(42u, hashes[0].id);
+}
+
 // Checks that after running the given optimizer |opt| on the given |original|
 // source code, we can get the given |optimized| source code.
 void CheckOptimization(const char* original, const char* optimized,
@@ -75,4 +75,32 @@ TEST(DiagnosticStream, ConversionToResultType) {
             spv_result_t(DiagnosticStream({}, nullptr, SPV_FAILED_MATCH)));
 }
 
+TEST(DiagnosticStream, MovedFromStreamDoesNotEmitAgain) {
+  int emissions = 0;
+  std::string last_message;
+  spvtools::MessageConsumer consumer =
+      [&emissions, &last_message](spv_message_level_t, const char*,
+                                  const spv_position_t&, const char* message) {
+        ++emissions;
+        last_message = message;
+      };
+  {
+    DiagnosticStream first({}, consumer, SPV_ERROR_INVALID_TEXT);
+    first << "oops";
+    DiagnosticStream second(std::move(first));
+    second << "!";
+  }
+  EXPECT_EQ(1, emissions);
+  EXPECT_EQ("oops!", last_message);
+}
+
+TEST(DiagnosticStream, FailedMatchEmitsNothing) {
+  int emissions = 0;
+  spvtools::MessageConsumer consumer =
+      [&emissions](spv_message_level_t, const char*, const spv_position_t&,
+                   const char*) { ++emissions; };
+  { DiagnosticStream({}, consumer, SPV_FAILED_MATCH) << "dropped"; }
+  EXPECT_EQ(0, emissions);
+}
+
 }  // anonymous namespace
@@ -177,6 +177,67 @@ TEST(EnumSet, DefaultIsEmpty) {
   }
 }
 
+TEST(EnumSet, MultiWordMaskCoversItsRangeInline) {
+  // With two mask words, values up to 127 are inline; 128 overflows.
+  EnumSet<uint32_t, 2> set;
+  set.Add(63);
+  set.Add(64);
+  set.Add(127);
+  set.Add(128);
+  EXPECT_TRUE(set.Contains(63));
+  EXPECT_TRUE(set.Contains(64));
+  EXPECT_TRUE(set.Contains(127));
+  EXPECT_TRUE(set.Contains(128));
+  EXPECT_FALSE(set.Contains(65));
+  EXPECT_FALSE(set.Contains(129));
+}
+
+TEST(EnumSet, MultiWordMaskHasAnyOf) {
+  EnumSet<uint32_t, 4> set({70, 150, 300});
+  EXPECT_TRUE(set.HasAnyOf(EnumSet<uint32_t, 4>(150)));
+  EXPECT_TRUE(set.HasAnyOf(EnumSet<uint32_t, 4>({1, 2, 300})));
+  EXPECT_FALSE(set.HasAnyOf(EnumSet<uint32_t, 4>({71, 149, 151})));
+  EXPECT_TRUE(set.HasAnyOf(EnumSet<uint32_t, 4>()));
+}
+
+// Returns the members of the set, in increasing order.
+std::vector<uint32_t> MembersOf(const EnumSet<uint32_t>& set) {
+  std::vector<uint32_t> result;
+  set.ForEach([&result](uint32_t c) { result.push_back(c); });
+  return result;
+}
+
+TEST(EnumSet, UnionOperatorMergesInlineAndOverflow) {
+  EnumSet<uint32_t> set({1, 63, 200});
+  set |= EnumSet<uint32_t>({2, 63, 300});
+  EXPECT_THAT(MembersOf(set), Eq(std::vector<uint32_t>{1, 2, 63, 200, 300}));
+}
+
+TEST(EnumSet, IntersectOperatorKeepsCommonMembers) {
+  EnumSet<uint32_t> set({1, 2, 63, 200, 300});
+  set &= EnumSet<uint32_t>({2, 3, 300, 400});
+  EXPECT_THAT(MembersOf(set), Eq(std::vector<uint32_t>{2, 300}));
+}
+
+TEST(EnumSet, IntersectOperatorDropsOverflowAgainstInlineOnlySet) {
+  EnumSet<uint32_t> set({5, 200});
+  set &= EnumSet<uint32_t>({5, 6});
+  EXPECT_THAT(MembersOf(set), Eq(std::vector<uint32_t>{5}));
+  EXPECT_FALSE(set.Contains(200));
+}
+
+TEST(CapabilitySet, ExtensionRangeValuesStayInline) {
+  // Capability values from the 4xxx and 5xxx extension ranges are covered
+  // by the inline bitset, and intersect without touching the overflow set.
+  CapabilitySet s({static_cast<SpvCapability>(4423),
+                   static_cast<SpvCapability>(5254)});
+  EXPECT_TRUE(s.Contains(static_cast<SpvCapability>(4423)));
+  EXPECT_TRUE(s.Contains(static_cast<SpvCapability>(5254)));
+  EXPECT_FALSE(s.Contains(static_cast<SpvCapability>(4424)));
+  EXPECT_TRUE(s.HasAnyOf(CapabilitySet(static_cast<SpvCapability>(5254))));
+  EXPECT_FALSE(s.HasAnyOf(CapabilitySet(static_cast<SpvCapability>(5255))));
+}
+
 TEST(CapabilitySet, ConstructSingleMemberMatrix) {
   CapabilitySet s(SpvCapabilityMatrix);
   EXPECT_TRUE(s.Contains(SpvCapabilityMatrix));
@@ -194,7 +255,8 @@ TEST(CapabilitySet, ConstructSingleMemberMaxInMask) {
 }
 
 TEST(CapabilitySet, ConstructSingleMemberMinOverflow) {
-  // Check the first one that forces overflow beyond the mask.
+  // The first value beyond the original single-word mask; it now lands in
+  // the wider inline bitset but must behave the same.
   CapabilitySet s(static_cast<SpvCapability>(64));
   EXPECT_FALSE(s.Contains(SpvCapabilityMatrix));
   EXPECT_FALSE(s.Contains(SpvCapabilityShader));
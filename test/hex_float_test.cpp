@@ -1230,5 +1230,51 @@ TEST(FloatProxy, Lowest) {
               Eq(std::numeric_limits<double>::lowest()));
 }
 
+TEST(Float16BufferConversion, NarrowingMatchesCastTo) {
+  const uint32_t inputs[] = {
+      0x00000000, 0x80000000, 0x3f800000, 0xbf800000,
+      0x477fe000,  // Largest finite half.
+      0x47800000,  // 2^16, saturates to infinity.
+      0x7f800000, 0xff800000, 0x7fc00000,
+      0x7f800001,  // Signaling NaN.
+      0x3f7fffff,  // Rounds up across a power of two.
+      0x33800001,  // Becomes a denormal half.
+      0x40490fdb, 0xc2f6e979, 0x3c003c00,
+  };
+  const size_t count = sizeof(inputs) / sizeof(inputs[0]);
+  float values[count];
+  for (size_t i = 0; i < count; ++i) values[i] = BitwiseCast<float>(inputs[i]);
+
+  const spvutils::round_direction rounding[] = {
+      spvutils::round_direction::kToZero,
+      spvutils::round_direction::kToNearestEven,
+      spvutils::round_direction::kToPositiveInfinity,
+      spvutils::round_direction::kToNegativeInfinity};
+  for (spvutils::round_direction round : rounding) {
+    uint16_t halves[count];
+    spvutils::Float32ToFloat16Buffer(values, halves, count, round);
+    for (size_t i = 0; i < count; ++i) {
+      EXPECT_THAT(halves[i], Eq(spvutils::Float16FromFloat32(values[i], round)))
+          << " input: " << std::hex << inputs[i];
+    }
+  }
+}
+
+TEST(Float16BufferConversion, WideningMatchesCastTo) {
+  // Covers zeroes, denormals, normals, infinities, and NaNs, including a
+  // signaling NaN whose payload the conversion must preserve.
+  const uint16_t inputs[] = {0x0000, 0x8000, 0x0001, 0x83ff, 0x3c00,
+                             0xbc00, 0x7bff, 0xfbff, 0x7c00, 0xfc00,
+                             0x7e00, 0x7c01, 0xfdab};
+  const size_t count = sizeof(inputs) / sizeof(inputs[0]);
+  float widened[count];
+  spvutils::Float16ToFloat32Buffer(inputs, widened, count);
+  for (size_t i = 0; i < count; ++i) {
+    EXPECT_THAT(BitwiseCast<uint32_t>(widened[i]),
+                Eq(BitwiseCast<uint32_t>(spvutils::Float32FromFloat16(inputs[i]))))
+        << " input: " << std::hex << inputs[i];
+  }
+}
+
 // TODO(awoloszyn): Add fp16 tests and HexFloatTraits.
 }  // anonymous namespace
@@ -0,0 +1,135 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "util/bit_stream.h"
+#include "util/huffman_codec.h"
+
+namespace {
+
+using spvutils::BitReaderWord64;
+using spvutils::BitWriterWord64;
+using spvutils::HuffmanCodec;
+
+TEST(HuffmanCodec, RoundTrip) {
+  const std::unordered_map<uint32_t, uint32_t> hist = {
+      {1, 100}, {2, 40}, {3, 40}, {4, 10}, {5, 1},
+  };
+  HuffmanCodec<uint32_t> codec(hist);
+
+  const std::vector<uint32_t> sequence = {1, 1, 5, 3, 2, 4, 1, 2, 3, 5, 4, 1};
+  BitWriterWord64 writer;
+  for (uint32_t val : sequence) {
+    ASSERT_TRUE(codec.Write(val, &writer));
+  }
+
+  BitReaderWord64 reader(writer.GetDataCopy());
+  for (uint32_t expected : sequence) {
+    uint32_t val = 0;
+    ASSERT_TRUE(codec.Read(&reader, &val));
+    EXPECT_EQ(expected, val);
+  }
+}
+
+TEST(HuffmanCodec, FrequentValuesGetShorterCodes) {
+  const std::unordered_map<uint32_t, uint32_t> hist = {
+      {10, 1000}, {20, 10}, {30, 10}, {40, 10},
+  };
+  HuffmanCodec<uint32_t> codec(hist);
+
+  BitWriterWord64 frequent;
+  for (int i = 0; i < 8; ++i) EXPECT_TRUE(codec.Write(10, &frequent));
+  BitWriterWord64 rare;
+  for (int i = 0; i < 8; ++i) EXPECT_TRUE(codec.Write(40, &rare));
+
+  EXPECT_LT(frequent.GetNumBits(), rare.GetNumBits());
+}
+
+TEST(HuffmanCodec, MapAndSortedVectorProduceIdenticalCodes) {
+  const std::unordered_map<uint32_t, uint32_t> hist_map = {
+      {7, 5}, {8, 5}, {9, 5}, {100, 17}, {200, 1},
+  };
+  const std::vector<std::pair<uint32_t, uint32_t>> hist_sorted = {
+      {7, 5}, {8, 5}, {9, 5}, {100, 17}, {200, 1},
+  };
+  HuffmanCodec<uint32_t> from_map(hist_map);
+  HuffmanCodec<uint32_t> from_vector(hist_sorted);
+
+  BitWriterWord64 writer1, writer2;
+  for (uint32_t val : {7, 100, 200, 9, 8, 100}) {
+    EXPECT_TRUE(from_map.Write(val, &writer1));
+    EXPECT_TRUE(from_vector.Write(val, &writer2));
+  }
+  EXPECT_EQ(writer1.GetDataCopy(), writer2.GetDataCopy());
+}
+
+TEST(HuffmanCodec, SingleValueUsesZeroBits) {
+  const std::unordered_map<uint32_t, uint32_t> hist = {{42, 1000}};
+  HuffmanCodec<uint32_t> codec(hist);
+
+  BitWriterWord64 writer;
+  EXPECT_TRUE(codec.Write(42, &writer));
+  EXPECT_EQ(0u, writer.GetNumBits());
+
+  // Reading consumes no bits either, so an empty buffer decodes repeatedly.
+  BitReaderWord64 reader(std::vector<uint64_t>(1, 0));
+  for (int i = 0; i < 3; ++i) {
+    uint32_t val = 0;
+    EXPECT_TRUE(codec.Read(&reader, &val));
+    EXPECT_EQ(42u, val);
+  }
+  EXPECT_FALSE(reader.ReachedEnd());
+}
+
+TEST(HuffmanCodec, WriteUnknownValueFails) {
+  const std::unordered_map<uint32_t, uint32_t> hist = {{1, 1}, {2, 1}};
+  HuffmanCodec<uint32_t> codec(hist);
+
+  BitWriterWord64 writer;
+  EXPECT_FALSE(codec.Write(3, &writer));
+  EXPECT_EQ(0u, writer.GetNumBits());
+}
+
+TEST(HuffmanCodec, ReadFromEmptyHistogramFails) {
+  HuffmanCodec<uint32_t> codec(std::unordered_map<uint32_t, uint32_t>());
+  BitReaderWord64 reader(std::vector<uint64_t>(1, 0));
+  uint32_t val = 0;
+  EXPECT_FALSE(codec.Read(&reader, &val));
+}
+
+TEST(HuffmanCodec, StringValuesRoundTrip) {
+  const std::unordered_map<std::string, uint32_t> hist = {
+      {"alpha", 10}, {"beta", 5}, {"gamma", 1},
+  };
+  HuffmanCodec<std::string> codec(hist);
+
+  BitWriterWord64 writer;
+  for (const char* val : {"gamma", "alpha", "alpha", "beta"}) {
+    ASSERT_TRUE(codec.Write(val, &writer));
+  }
+
+  BitReaderWord64 reader(writer.GetDataCopy());
+  for (const char* expected : {"gamma", "alpha", "alpha", "beta"}) {
+    std::string val;
+    ASSERT_TRUE(codec.Read(&reader, &val));
+    EXPECT_EQ(expected, val);
+  }
+}
+
+}  // anonymous namespace
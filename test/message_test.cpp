@@ -0,0 +1,116 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for the asynchronous message consumer.
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "message.h"
+
+namespace {
+
+using spvtools::AsyncMessageConsumer;
+using spvtools::MessageConsumer;
+
+TEST(AsyncMessageConsumer, DeliversInOrder) {
+  std::vector<std::string> received;
+  {
+    AsyncMessageConsumer async(
+        [&received](spv_message_level_t, const char*, const spv_position_t&,
+                    const char* message) { received.push_back(message); });
+    MessageConsumer consumer = async.GetConsumer();
+    spv_position_t position = {};
+    for (int i = 0; i < 100; ++i) {
+      std::ostringstream oss;
+      oss << "message " << i;
+      consumer(SPV_MSG_ERROR, "test", position, oss.str().c_str());
+    }
+  }  // The destructor drains the ring and joins the drainer thread.
+  ASSERT_EQ(100u, received.size());
+  for (int i = 0; i < 100; ++i) {
+    std::ostringstream oss;
+    oss << "message " << i;
+    EXPECT_EQ(oss.str(), received[i]);
+  }
+}
+
+TEST(AsyncMessageConsumer, PassesLevelPositionAndNullSource) {
+  spv_message_level_t received_level = SPV_MSG_DEBUG;
+  const char* received_source = "sentinel";
+  spv_position_t received_position = {};
+  {
+    AsyncMessageConsumer async(
+        [&](spv_message_level_t level, const char* source,
+            const spv_position_t& position, const char*) {
+          received_level = level;
+          received_source = source;
+          received_position = position;
+        });
+    spv_position_t position = {4, 2, 77};
+    async.GetConsumer()(SPV_MSG_WARNING, nullptr, position, "hello");
+  }
+  EXPECT_EQ(SPV_MSG_WARNING, received_level);
+  EXPECT_EQ(nullptr, received_source);
+  EXPECT_EQ(4u, received_position.line);
+  EXPECT_EQ(2u, received_position.column);
+  EXPECT_EQ(77u, received_position.index);
+}
+
+TEST(AsyncMessageConsumer, TruncatesLongMessages) {
+  std::string received;
+  {
+    AsyncMessageConsumer async(
+        [&received](spv_message_level_t, const char*, const spv_position_t&,
+                    const char* message) { received = message; });
+    const std::string long_message(1000, 'x');
+    spv_position_t position = {};
+    async.GetConsumer()(SPV_MSG_ERROR, nullptr, position,
+                        long_message.c_str());
+  }
+  EXPECT_LT(received.size(), 1000u);
+  EXPECT_EQ(std::string(received.size(), 'x'), received);
+}
+
+TEST(AsyncMessageConsumer, ManyProducers) {
+  const size_t kNumThreads = 4;
+  const size_t kPerThread = 500;
+  size_t count = 0;
+  {
+    // The ring is sized to hold every message, so none may be dropped.
+    AsyncMessageConsumer async(
+        [&count](spv_message_level_t, const char*, const spv_position_t&,
+                 const char*) { ++count; },
+        kNumThreads * kPerThread);
+    MessageConsumer consumer = async.GetConsumer();
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < kNumThreads; ++i) {
+      workers.emplace_back([consumer]() {
+        spv_position_t position = {};
+        for (size_t j = 0; j < kPerThread; ++j) {
+          consumer(SPV_MSG_INFO, "worker", position, "ping");
+        }
+      });
+    }
+    for (auto& worker : workers) worker.join();
+  }
+  EXPECT_EQ(kNumThreads * kPerThread, count);
+}
+
+}  // anonymous namespace
@@ -0,0 +1,33 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for spvOpcodeString and spvOpcodeStringPrefixed.
+
+#include "unit_spirv.h"
+
+namespace {
+
+TEST(OpcodeString, NameWithoutPrefix) {
+  EXPECT_STREQ("Nop", spvOpcodeString(SpvOpNop));
+  EXPECT_STREQ("TypeInt", spvOpcodeString(SpvOpTypeInt));
+  EXPECT_STREQ("Function", spvOpcodeString(SpvOpFunction));
+}
+
+TEST(OpcodeString, NameWithPrefix) {
+  EXPECT_STREQ("OpNop", spvOpcodeStringPrefixed(SpvOpNop));
+  EXPECT_STREQ("OpTypeInt", spvOpcodeStringPrefixed(SpvOpTypeInt));
+  EXPECT_STREQ("OpFunction", spvOpcodeStringPrefixed(SpvOpFunction));
+}
+
+}  // anonymous namespace
@@ -0,0 +1,173 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using AggressiveDCETest = PassTest<::testing::Test>;
+
+TEST_F(AggressiveDCETest, RemovesDeadArithmetic) {
+  const std::string before = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%5 = OpTypeFunction %void
+%main = OpFunction %void None %5
+%6 = OpLabel
+%7 = OpFAdd %float %float_1 %float_1
+%8 = OpFMul %float %7 %7
+OpReturn
+OpFunctionEnd
+)";
+  const std::string after = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%5 = OpTypeFunction %void
+%main = OpFunction %void None %5
+%6 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::AggressiveDCEPass>(before, after,
+                                                /* skip_nop = */ true);
+}
+
+TEST_F(AggressiveDCETest, KeepsCodeContributingToStore) {
+  const std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %out_var
+OpName %main "main"
+OpName %out_var "out_var"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%_ptr_Output_float = OpTypePointer Output %float
+%out_var = OpVariable %_ptr_Output_float Output
+%7 = OpTypeFunction %void
+%main = OpFunction %void None %7
+%8 = OpLabel
+%9 = OpFAdd %float %float_1 %float_1
+OpStore %out_var %9
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::AggressiveDCEPass>(text, text,
+                                                /* skip_nop = */ true);
+}
+
+TEST_F(AggressiveDCETest, RemovesDeadLoad) {
+  const std::string before = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %in_var
+OpName %main "main"
+OpName %in_var "in_var"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%_ptr_Input_float = OpTypePointer Input %float
+%in_var = OpVariable %_ptr_Input_float Input
+%6 = OpTypeFunction %void
+%main = OpFunction %void None %6
+%7 = OpLabel
+%8 = OpLoad %float %in_var
+OpReturn
+OpFunctionEnd
+)";
+  const std::string after = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %in_var
+OpName %main "main"
+OpName %in_var "in_var"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%_ptr_Input_float = OpTypePointer Input %float
+%in_var = OpVariable %_ptr_Input_float Input
+%6 = OpTypeFunction %void
+%main = OpFunction %void None %6
+%7 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::AggressiveDCEPass>(before, after,
+                                                /* skip_nop = */ true);
+}
+
+TEST_F(AggressiveDCETest, KeepsUnusedVolatileLoad) {
+  // A volatile load must execute even when its result is unused; the
+  // MemoryAccess operand makes it a live root.
+  const std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %in_var
+OpName %main "main"
+OpName %in_var "in_var"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%_ptr_Input_float = OpTypePointer Input %float
+%in_var = OpVariable %_ptr_Input_float Input
+%6 = OpTypeFunction %void
+%main = OpFunction %void None %6
+%7 = OpLabel
+%8 = OpLoad %float %in_var Volatile
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::AggressiveDCEPass>(text, text,
+                                                /* skip_nop = */ true);
+}
+
+TEST_F(AggressiveDCETest, RemovesNamesAndDecorationsOfDeadCode) {
+  const std::string before = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+OpName %sum "sum"
+OpDecorate %sum RelaxedPrecision
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%6 = OpTypeFunction %void
+%main = OpFunction %void None %6
+%7 = OpLabel
+%sum = OpFAdd %float %float_1 %float_1
+OpReturn
+OpFunctionEnd
+)";
+  const std::string after = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%6 = OpTypeFunction %void
+%main = OpFunction %void None %6
+%7 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::AggressiveDCEPass>(before, after,
+                                                /* skip_nop = */ true);
+}
+
+}  // anonymous namespace
@@ -0,0 +1,136 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "opt/analysis_manager.h"
+#include "opt/build_module.h"
+#include "opt/make_unique.h"
+#include "opt/pass_manager.h"
+
+namespace {
+
+using namespace spvtools;
+
+const char kModuleText[] = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+%void = OpTypeVoid
+%4 = OpTypeFunction %void
+%main = OpFunction %void None %4
+%entry = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+// A pass that records the def-use manager it was handed out.
+class ProbePass : public opt::Pass {
+ public:
+  explicit ProbePass(opt::analysis::DefUseManager** seen) : seen_(seen) {}
+
+  const char* name() const override { return "probe"; }
+
+  uint32_t GetPreservedAnalyses() const override {
+    return opt::AnalysisManager::kAnalysisAll;
+  }
+
+  Status Process(ir::Module* module) override {
+    *seen_ = analyses(module)->GetDefUse();
+    return Status::SuccessWithChange;
+  }
+
+ private:
+  opt::analysis::DefUseManager** seen_;
+};
+
+TEST(AnalysisManager, CachesAnalyses) {
+  std::unique_ptr<ir::Module> module =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, kModuleText);
+  ASSERT_NE(nullptr, module);
+
+  MessageConsumer consumer = nullptr;
+  opt::AnalysisManager analyses(consumer, module.get());
+  EXPECT_EQ(module.get(), analyses.module());
+
+  // Repeated requests return the same instance.
+  opt::analysis::DefUseManager* def_use = analyses.GetDefUse();
+  EXPECT_EQ(def_use, analyses.GetDefUse());
+  opt::analysis::CfgManager* cfgs = analyses.GetCfgs();
+  EXPECT_EQ(cfgs, analyses.GetCfgs());
+
+  // A preserved analysis survives invalidation.
+  analyses.Invalidate(opt::AnalysisManager::kAnalysisDefUse);
+  EXPECT_EQ(def_use, analyses.GetDefUse());
+}
+
+TEST(AnalysisManager, SharedAcrossPipeline) {
+  std::unique_ptr<ir::Module> module =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, kModuleText);
+  ASSERT_NE(nullptr, module);
+
+  // Both passes preserve everything, so the second sees the def-use
+  // analysis built for the first instead of a rebuild.
+  opt::analysis::DefUseManager* first = nullptr;
+  opt::analysis::DefUseManager* second = nullptr;
+  opt::PassManager manager;
+  manager.AddPass<ProbePass>(&first);
+  manager.AddPass<ProbePass>(&second);
+  EXPECT_EQ(opt::Pass::Status::SuccessWithChange, manager.Run(module.get()));
+  EXPECT_NE(nullptr, first);
+  EXPECT_EQ(first, second);
+}
+
+TEST(AnalysisManager, SessionSharesTypesAndConstants) {
+  std::unique_ptr<ir::Module> module1 =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, kModuleText);
+  std::unique_ptr<ir::Module> module2 =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, kModuleText);
+  ASSERT_NE(nullptr, module1);
+  ASSERT_NE(nullptr, module2);
+
+  MessageConsumer consumer = nullptr;
+  opt::AnalysisSession session;
+  opt::AnalysisManager analyses1(consumer, module1.get(), &session);
+  opt::AnalysisManager analyses2(consumer, module2.get(), &session);
+
+  // Both managers hand out the session's constant manager, and the types of
+  // the two modules resolve to the same pooled representatives.
+  EXPECT_TRUE(analyses1.GetTypes()->AllTypesPooled());
+  EXPECT_EQ(analyses1.GetConstants(), analyses2.GetConstants());
+  EXPECT_EQ(analyses1.GetTypes()->GetType(2),
+            analyses2.GetTypes()->GetType(2));
+
+  // Session-held constants survive invalidation: they are keyed on types
+  // owned by the pool, not by the dropped type analysis.
+  opt::analysis::ConstantManager* constants = analyses1.GetConstants();
+  analyses1.Invalidate(opt::AnalysisManager::kAnalysisNone);
+  EXPECT_EQ(constants, analyses1.GetConstants());
+}
+
+TEST(AnalysisManager, StandalonePassBuildsItsOwn) {
+  std::unique_ptr<ir::Module> module =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, kModuleText);
+  ASSERT_NE(nullptr, module);
+
+  // Outside a PassManager the pass falls back to a private manager.
+  opt::analysis::DefUseManager* seen = nullptr;
+  ProbePass pass(&seen);
+  EXPECT_EQ(opt::Pass::Status::SuccessWithChange, pass.Process(module.get()));
+  EXPECT_NE(nullptr, seen);
+}
+
+}  // anonymous namespace
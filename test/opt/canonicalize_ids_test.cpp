@@ -0,0 +1,125 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using CanonicalizeIdsTest = PassTest<::testing::Test>;
+
+TEST_F(CanonicalizeIdsTest, NumbersFromSemanticSectionsNotDebugOrder) {
+  // The OpName order references ids "backwards", which would perturb a
+  // first-appearance numbering; canonical numbering follows the types and
+  // constants section instead.
+  const std::string before =
+      R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpName %30 "b"
+OpName %20 "a"
+%99 = OpTypeInt 32 0
+%20 = OpConstant %99 1
+%30 = OpConstant %99 2
+)";
+
+  const std::string after =
+      R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpName %3 "b"
+OpName %2 "a"
+%1 = OpTypeInt 32 0
+%2 = OpConstant %1 1
+%3 = OpConstant %1 2
+)";
+
+  SetAssembleOptions(SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  SetDisassembleOptions(SPV_BINARY_TO_TEXT_OPTION_NO_HEADER);
+  SinglePassRunAndCheck<opt::CanonicalizeIdsPass>(before, after, false, false);
+}
+
+TEST_F(CanonicalizeIdsTest, EntryPointsSeedBeforeFunctionBodies) {
+  const std::string before =
+      R"(OpCapability Addresses
+OpCapability Kernel
+OpCapability Linkage
+OpMemoryModel Physical32 OpenCL
+OpEntryPoint Kernel %3 "k"
+OpName %70 "entry"
+%99 = OpTypeInt 32 0
+%40 = OpTypeVoid
+%50 = OpTypeFunction %40
+%3 = OpFunction %40 None %50
+%70 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(OpCapability Addresses
+OpCapability Kernel
+OpCapability Linkage
+OpMemoryModel Physical32 OpenCL
+OpEntryPoint Kernel %1 "k"
+OpName %5 "entry"
+%2 = OpTypeInt 32 0
+%3 = OpTypeVoid
+%4 = OpTypeFunction %3
+%1 = OpFunction %3 None %4
+%5 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SetAssembleOptions(SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  SetDisassembleOptions(SPV_BINARY_TO_TEXT_OPTION_NO_HEADER);
+  SinglePassRunAndCheck<opt::CanonicalizeIdsPass>(before, after, false, false);
+}
+
+TEST_F(CanonicalizeIdsTest, DebugOrderDoesNotChangeNumbering) {
+  // Same module as NumbersFromSemanticSectionsNotDebugOrder but with the
+  // OpName lines swapped: every id maps to the same canonical value.
+  const std::string before =
+      R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpName %20 "a"
+OpName %30 "b"
+%99 = OpTypeInt 32 0
+%20 = OpConstant %99 1
+%30 = OpConstant %99 2
+)";
+
+  const std::string after =
+      R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpName %2 "a"
+OpName %3 "b"
+%1 = OpTypeInt 32 0
+%2 = OpConstant %1 1
+%3 = OpConstant %1 2
+)";
+
+  SetAssembleOptions(SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  SetDisassembleOptions(SPV_BINARY_TO_TEXT_OPTION_NO_HEADER);
+  SinglePassRunAndCheck<opt::CanonicalizeIdsPass>(before, after, false, false);
+}
+
+}  // anonymous namespace
@@ -0,0 +1,124 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "opt/build_module.h"
+#include "opt/cfg.h"
+
+namespace {
+
+using namespace spvtools;
+
+TEST(CfgAnalysis, LoopFunction) {
+  const std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+%void = OpTypeVoid
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%5 = OpTypeFunction %void
+%main = OpFunction %void None %5
+%entry = OpLabel
+OpBranch %header
+%header = OpLabel
+OpLoopMerge %merge %continue None
+OpBranch %body
+%body = OpLabel
+OpBranchConditional %true %merge %continue
+%continue = OpLabel
+OpBranch %header
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  std::unique_ptr<ir::Module> module =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text);
+  ASSERT_NE(nullptr, module);
+  ir::Function* func = &*module->begin();
+  std::vector<ir::BasicBlock*> blocks;
+  for (auto& block : *func) blocks.push_back(&block);
+  ASSERT_EQ(5u, blocks.size());
+  ir::BasicBlock* entry = blocks[0];
+  ir::BasicBlock* header = blocks[1];
+  ir::BasicBlock* body = blocks[2];
+  ir::BasicBlock* cont = blocks[3];
+  ir::BasicBlock* merge = blocks[4];
+
+  opt::analysis::CfgManager cfgs(module.get());
+  const opt::analysis::FunctionCfg& cfg = cfgs.GetCfg(func);
+
+  // Every block is reachable and the entry finishes the postorder.
+  EXPECT_EQ(5u, cfg.postorder().size());
+  EXPECT_EQ(entry, cfg.postorder().back());
+  EXPECT_TRUE(cfg.IsReachable(body));
+
+  // Adjacency.
+  ASSERT_EQ(1u, cfg.successors(entry).size());
+  EXPECT_EQ(header, *cfg.successors(entry).begin());
+  EXPECT_EQ(2u, cfg.predecessors(header).size());
+  EXPECT_EQ(2u, cfg.successors(body).size());
+  ASSERT_EQ(1u, cfg.predecessors(merge).size());
+  EXPECT_EQ(body, *cfg.predecessors(merge).begin());
+
+  // Dominators.
+  EXPECT_EQ(entry, cfg.ImmediateDominator(entry));
+  EXPECT_EQ(entry, cfg.ImmediateDominator(header));
+  EXPECT_EQ(header, cfg.ImmediateDominator(body));
+  EXPECT_EQ(body, cfg.ImmediateDominator(cont));
+  EXPECT_EQ(body, cfg.ImmediateDominator(merge));
+
+  // The natural loop of the back edge continue->header.
+  EXPECT_EQ(0u, cfg.LoopDepth(entry));
+  EXPECT_EQ(1u, cfg.LoopDepth(header));
+  EXPECT_EQ(1u, cfg.LoopDepth(body));
+  EXPECT_EQ(1u, cfg.LoopDepth(cont));
+  EXPECT_EQ(0u, cfg.LoopDepth(merge));
+
+  // The analysis is cached across requests.
+  EXPECT_EQ(&cfg, &cfgs.GetCfg(func));
+}
+
+TEST(CfgAnalysis, UnreachableBlock) {
+  const std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+%void = OpTypeVoid
+%4 = OpTypeFunction %void
+%main = OpFunction %void None %4
+%entry = OpLabel
+OpReturn
+%dead = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  std::unique_ptr<ir::Module> module =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text);
+  ASSERT_NE(nullptr, module);
+  ir::Function* func = &*module->begin();
+  std::vector<ir::BasicBlock*> blocks;
+  for (auto& block : *func) blocks.push_back(&block);
+  ASSERT_EQ(2u, blocks.size());
+
+  opt::analysis::CfgManager cfgs(module.get());
+  const opt::analysis::FunctionCfg& cfg = cfgs.GetCfg(func);
+  EXPECT_EQ(1u, cfg.postorder().size());
+  EXPECT_TRUE(cfg.IsReachable(blocks[0]));
+  EXPECT_FALSE(cfg.IsReachable(blocks[1]));
+}
+
+}  // anonymous namespace
@@ -14,6 +14,7 @@
 
 #include <gmock/gmock.h>
 
+#include "opt/id_remap.h"
 #include "pass_fixture.h"
 #include "pass_utils.h"
 
@@ -87,4 +88,15 @@ OpFunctionEnd
   SinglePassRunAndCheck<opt::CompactIdsPass>(before, after, false, false);
 }
 
+TEST(DenseIdRemapper, AssignsDenseIdsInOrderOfFirstUse) {
+  opt::DenseIdRemapper remapper(100);
+  EXPECT_EQ(1u, remapper.MapId(99));
+  EXPECT_EQ(2u, remapper.MapId(10));
+  // Repeated queries return the assigned id.
+  EXPECT_EQ(1u, remapper.MapId(99));
+  EXPECT_EQ(3u, remapper.MapId(20));
+  EXPECT_EQ(2u, remapper.MapId(10));
+  EXPECT_EQ(4u, remapper.NextId());
+}
+
 }  // anonymous namespace
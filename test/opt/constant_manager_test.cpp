@@ -0,0 +1,162 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "opt/constant_manager.h"
+#include "opt/make_unique.h"
+
+namespace {
+
+using namespace spvtools::opt::analysis;
+using spvtools::MakeUnique;
+
+// Fixture class providing some element types and a constant manager.
+class ConstantManagerTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() override {
+    bool_t_.reset(new Bool());
+    u32_t_.reset(new Integer(32, false));
+    s32_t_.reset(new Integer(32, true));
+    u64_t_.reset(new Integer(64, false));
+    s64_t_.reset(new Integer(64, true));
+    v2u32_t_.reset(new Vector(u32_t_.get(), 2));
+  }
+
+  // Returns the canonical 32-bit constant for the given value.
+  const Constant* GetU32(uint32_t value) {
+    return mgr_.GetCanonical(
+        MakeUnique<IntConstant>(u32_t_.get(), std::vector<uint32_t>{value}));
+  }
+
+  // Returns the canonical 64-bit constant for the given value, stored
+  // low-order word first.
+  const Constant* GetU64(const Integer* type, uint64_t value) {
+    return mgr_.GetCanonical(MakeUnique<IntConstant>(
+        type,
+        std::vector<uint32_t>{uint32_t(value), uint32_t(value >> 32)}));
+  }
+
+  std::unique_ptr<Bool> bool_t_;
+  std::unique_ptr<Integer> u32_t_;
+  std::unique_ptr<Integer> s32_t_;
+  std::unique_ptr<Integer> u64_t_;
+  std::unique_ptr<Integer> s64_t_;
+  std::unique_ptr<Vector> v2u32_t_;
+
+  ConstantManager mgr_;
+};
+
+TEST_F(ConstantManagerTest, EqualConstantsShareOneInstance) {
+  const Constant* a = GetU32(42);
+  const Constant* b = GetU32(42);
+  const Constant* c = GetU32(43);
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+}
+
+TEST_F(ConstantManagerTest, EqualCompositesShareOneInstance) {
+  const Constant* x = GetU32(1);
+  const Constant* y = GetU32(2);
+  const Constant* v1 = mgr_.GetCanonical(MakeUnique<VectorConstant>(
+      v2u32_t_.get(), std::vector<const Constant*>{x, y}));
+  const Constant* v2 = mgr_.GetCanonical(MakeUnique<VectorConstant>(
+      v2u32_t_.get(), std::vector<const Constant*>{x, y}));
+  const Constant* v3 = mgr_.GetCanonical(MakeUnique<VectorConstant>(
+      v2u32_t_.get(), std::vector<const Constant*>{y, x}));
+  EXPECT_EQ(v1, v2);
+  EXPECT_NE(v1, v3);
+}
+
+TEST_F(ConstantManagerTest, Folds32BitArithmetic) {
+  const Constant* folded =
+      mgr_.Fold(SpvOpIAdd, {GetU32(40), GetU32(2)}, u32_t_.get());
+  ASSERT_NE(nullptr, folded);
+  EXPECT_EQ(folded, GetU32(42));
+}
+
+TEST_F(ConstantManagerTest, Folds64BitArithmeticWithCarry) {
+  // 0xffffffff + 1 must carry into the high word.
+  const Constant* folded = mgr_.Fold(
+      SpvOpIAdd, {GetU64(u64_t_.get(), 0xffffffffull), GetU64(u64_t_.get(), 1)},
+      u64_t_.get());
+  ASSERT_NE(nullptr, folded);
+  EXPECT_EQ(folded, GetU64(u64_t_.get(), 0x100000000ull));
+}
+
+TEST_F(ConstantManagerTest, Folds64BitSignedDivision) {
+  const Constant* minus_six = GetU64(s64_t_.get(), uint64_t(-6));
+  const Constant* two = GetU64(s64_t_.get(), 2);
+  const Constant* folded =
+      mgr_.Fold(SpvOpSDiv, {minus_six, two}, s64_t_.get());
+  ASSERT_NE(nullptr, folded);
+  EXPECT_EQ(folded, GetU64(s64_t_.get(), uint64_t(-3)));
+}
+
+TEST_F(ConstantManagerTest, FoldsComparisonToBool) {
+  const Constant* folded =
+      mgr_.Fold(SpvOpULessThan, {GetU32(1), GetU32(2)}, bool_t_.get());
+  ASSERT_NE(nullptr, folded);
+  ASSERT_NE(nullptr, folded->AsBoolConstant());
+  EXPECT_TRUE(folded->AsBoolConstant()->value());
+}
+
+TEST_F(ConstantManagerTest, FoldsComponentWiseOverVectors) {
+  const Constant* v1 = mgr_.GetCanonical(MakeUnique<VectorConstant>(
+      v2u32_t_.get(), std::vector<const Constant*>{GetU32(1), GetU32(2)}));
+  const Constant* v2 = mgr_.GetCanonical(MakeUnique<VectorConstant>(
+      v2u32_t_.get(), std::vector<const Constant*>{GetU32(10), GetU32(20)}));
+  const Constant* folded = mgr_.Fold(SpvOpIAdd, {v1, v2}, v2u32_t_.get());
+  ASSERT_NE(nullptr, folded);
+  const VectorConstant* vec = folded->AsVectorConstant();
+  ASSERT_NE(nullptr, vec);
+  ASSERT_EQ(2u, vec->GetComponents().size());
+  EXPECT_EQ(GetU32(11), vec->GetComponents()[0]);
+  EXPECT_EQ(GetU32(22), vec->GetComponents()[1]);
+}
+
+TEST_F(ConstantManagerTest, NullOperandEvaluatesAsZero) {
+  const Constant* null_u32 =
+      mgr_.GetCanonical(MakeUnique<NullConstant>(u32_t_.get()));
+  const Constant* folded =
+      mgr_.Fold(SpvOpIAdd, {null_u32, GetU32(5)}, u32_t_.get());
+  ASSERT_NE(nullptr, folded);
+  EXPECT_EQ(folded, GetU32(5));
+}
+
+TEST_F(ConstantManagerTest, DivisionByZeroDoesNotFold) {
+  EXPECT_EQ(nullptr,
+            mgr_.Fold(SpvOpUDiv, {GetU32(1), GetU32(0)}, u32_t_.get()));
+  EXPECT_EQ(nullptr,
+            mgr_.Fold(SpvOpSDiv, {GetU32(1), GetU32(0)}, s32_t_.get()));
+}
+
+TEST_F(ConstantManagerTest, UnsupportedOpcodeDoesNotFold) {
+  EXPECT_EQ(nullptr,
+            mgr_.Fold(SpvOpFAdd, {GetU32(1), GetU32(2)}, u32_t_.get()));
+}
+
+TEST_F(ConstantManagerTest, RepeatedFoldsReturnTheSameInstance) {
+  const Constant* first =
+      mgr_.Fold(SpvOpIMul, {GetU32(6), GetU32(7)}, u32_t_.get());
+  const Constant* second =
+      mgr_.Fold(SpvOpIMul, {GetU32(6), GetU32(7)}, u32_t_.get());
+  ASSERT_NE(nullptr, first);
+  EXPECT_EQ(first, second);
+}
+
+}  // anonymous namespace
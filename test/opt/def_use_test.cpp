@@ -1403,6 +1403,35 @@ INSTANTIATE_TEST_CASE_P(
       }));
 // clang-format on
 
+TEST(DefUseTest, AnnotationSpanTracksMutations) {
+  const char text[] =
+      "OpDecorate %1 Block "
+      "OpDecorate %1 RelaxedPrecision "
+      "%3 = OpTypeInt 32 0 "
+      "%1 = OpTypeStruct %3";
+
+  std::unique_ptr<ir::Module> module =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text);
+  ASSERT_NE(nullptr, module);
+
+  opt::analysis::DefUseManager manager(nullptr, module.get());
+  ASSERT_EQ(2u, manager.GetAnnotationSpan(1).size());
+
+  // Redirecting the decorated id moves the annotation records with it.
+  manager.ReplaceAllUsesWith(1, 100);
+  EXPECT_TRUE(manager.GetAnnotationSpan(1).empty());
+  ASSERT_EQ(2u, manager.GetAnnotationSpan(100).size());
+
+  // Killing a decoration removes only its own records.
+  manager.KillInst(manager.GetAnnotationSpan(100)[0]);
+  ASSERT_EQ(1u, manager.GetAnnotationSpan(100).size());
+  EXPECT_EQ("OpDecorate %100 RelaxedPrecision",
+            DisassembleInst(manager.GetAnnotationSpan(100)[0]));
+  manager.KillInst(manager.GetAnnotationSpan(100)[0]);
+  EXPECT_TRUE(manager.GetAnnotationSpan(100).empty());
+  EXPECT_FALSE(manager.HasAnnotations(100));
+}
+
 struct GetAnnotationsTestCase {
   const char* code;
   uint32_t id;
@@ -1423,6 +1452,11 @@ TEST_P(GetAnnotationsTest, Case) {
   opt::analysis::DefUseManager manager(nullptr, module.get());
   auto insts = manager.GetAnnotations(tc.id);
 
+  // The span view must agree with the vector-returning shim.
+  const auto& span = manager.GetAnnotationSpan(tc.id);
+  EXPECT_EQ(insts, std::vector<ir::Instruction*>(span.begin(), span.end()));
+  EXPECT_EQ(!insts.empty(), manager.HasAnnotations(tc.id));
+
   // Check
   ASSERT_EQ(tc.annotations.size(), insts.size())
       << "wrong number of annotation instructions";
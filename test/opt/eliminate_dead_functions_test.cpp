@@ -0,0 +1,134 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using EliminateDeadFunctionsTest = PassTest<::testing::Test>;
+
+TEST_F(EliminateDeadFunctionsTest, RemovesUnreachableFunction) {
+  const std::string before = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+OpName %dead "dead"
+%void = OpTypeVoid
+%5 = OpTypeFunction %void
+%main = OpFunction %void None %5
+%6 = OpLabel
+OpReturn
+OpFunctionEnd
+%dead = OpFunction %void None %5
+%7 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  const std::string after = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+%void = OpTypeVoid
+%5 = OpTypeFunction %void
+%main = OpFunction %void None %5
+%6 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::EliminateDeadFunctionsPass>(before, after,
+                                                         /* skip_nop = */ true);
+}
+
+TEST_F(EliminateDeadFunctionsTest, KeepsTransitivelyCalledFunctions) {
+  const std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+OpName %helper "helper"
+OpName %leaf "leaf"
+%void = OpTypeVoid
+%7 = OpTypeFunction %void
+%main = OpFunction %void None %7
+%8 = OpLabel
+%9 = OpFunctionCall %void %helper
+OpReturn
+OpFunctionEnd
+%helper = OpFunction %void None %7
+%10 = OpLabel
+%11 = OpFunctionCall %void %leaf
+OpReturn
+OpFunctionEnd
+%leaf = OpFunction %void None %7
+%12 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::EliminateDeadFunctionsPass>(text, text,
+                                                         /* skip_nop = */ true);
+}
+
+TEST_F(EliminateDeadFunctionsTest, KeepsExportedFunction) {
+  const std::string text = R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpName %exported "exported"
+OpDecorate %exported LinkageAttributes "exported" Export
+%void = OpTypeVoid
+%4 = OpTypeFunction %void
+%exported = OpFunction %void None %4
+%5 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::EliminateDeadFunctionsPass>(text, text,
+                                                         /* skip_nop = */ true);
+}
+
+TEST_F(EliminateDeadFunctionsTest, RemovesNamesAndDecorationsOfDeadFunction) {
+  const std::string before = R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+OpName %dead "dead"
+OpDecorate %dead LinkageAttributes "dead" Import
+%void = OpTypeVoid
+%6 = OpTypeFunction %void
+%main = OpFunction %void None %6
+%7 = OpLabel
+OpReturn
+OpFunctionEnd
+%dead = OpFunction %void None %6
+OpFunctionEnd
+)";
+  const std::string after = R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+%void = OpTypeVoid
+%6 = OpTypeFunction %void
+%main = OpFunction %void None %6
+%7 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::EliminateDeadFunctionsPass>(before, after,
+                                                         /* skip_nop = */ true);
+}
+
+}  // anonymous namespace
@@ -114,7 +114,7 @@ TEST(InstructionTest, OperandConstIterators) {
   EXPECT_EQ(cend, inst.cend());
 
   // Check arithmetic.
-  const Operand& operand2 = *(inst.cbegin() + 2);
+  const auto operand2 = *(inst.cbegin() + 2);
   EXPECT_EQ(SPV_OPERAND_TYPE_LITERAL_INTEGER, operand2.type);
 }
 
@@ -140,12 +140,105 @@ TEST(InstructionTest, OperandIterators) {
   EXPECT_EQ(end, inst.end());
 
   // Check arithmetic.
-  Operand& operand2 = *(inst.begin() + 2);
+  const auto operand2 = *(inst.begin() + 2);
   EXPECT_EQ(SPV_OPERAND_TYPE_LITERAL_INTEGER, operand2.type);
+}
+
+TEST(InstructionTest, CreateWithMovedOperands) {
+  std::vector<Operand> operands;
+  operands.emplace_back(SPV_OPERAND_TYPE_LITERAL_INTEGER,
+                        std::vector<uint32_t>{32});
+  operands.emplace_back(SPV_OPERAND_TYPE_LITERAL_INTEGER,
+                        std::vector<uint32_t>{1});
+  Instruction inst(SpvOpTypeInt, 0, 44, std::move(operands));
+  EXPECT_EQ(3u, inst.NumOperands());
+  EXPECT_THAT(inst.GetOperand(0).words, Eq(std::vector<uint32_t>{44}));
+  EXPECT_THAT(inst.GetInOperand(0).words, Eq(std::vector<uint32_t>{32}));
+  EXPECT_THAT(inst.GetInOperand(1).words, Eq(std::vector<uint32_t>{1}));
+  // All operand words sit back to back in one flat buffer.
+  EXPECT_EQ(inst.GetOperand(0).words.data() + 1,
+            inst.GetInOperand(0).words.data());
+  EXPECT_EQ(inst.GetInOperand(0).words.data() + 1,
+            inst.GetInOperand(1).words.data());
+}
+
+TEST(InstructionTest, AddOperand) {
+  Instruction inst(SpvOpTypeInt, 0, 44, {});
+  inst.AddOperand(SPV_OPERAND_TYPE_LITERAL_INTEGER, {32});
+  inst.AddOperand(SPV_OPERAND_TYPE_LITERAL_INTEGER, {1});
+  EXPECT_EQ(3u, inst.NumOperands());
+  EXPECT_EQ(2u, inst.NumInOperands());
+  EXPECT_THAT(inst.GetInOperand(0).words, Eq(std::vector<uint32_t>{32}));
+  EXPECT_THAT(inst.GetInOperand(1).words, Eq(std::vector<uint32_t>{1}));
+}
+
+TEST(InstructionTest, SetInOperandWithDifferentWidth) {
+  // OpSpecConstant-style instruction with a two-word literal followed by
+  // another operand, so the trailing descriptor has to be rebased.
+  Instruction inst(SpvOpSpecConstant, 42, 43,
+                   {{SPV_OPERAND_TYPE_LITERAL_INTEGER, {7, 8}},
+                    {SPV_OPERAND_TYPE_LITERAL_INTEGER, {9}}});
+  inst.SetInOperand(0, {1});
+  EXPECT_EQ(3u, inst.NumInOperandWords());
+  EXPECT_THAT(inst.GetInOperand(0).words, Eq(std::vector<uint32_t>{1}));
+  EXPECT_THAT(inst.GetInOperand(1).words, Eq(std::vector<uint32_t>{9}));
+
+  inst.SetInOperand(0, {5, 6});
+  EXPECT_EQ(4u, inst.NumInOperandWords());
+  EXPECT_THAT(inst.GetInOperand(0).words, Eq(std::vector<uint32_t>{5, 6}));
+  EXPECT_THAT(inst.GetInOperand(1).words, Eq(std::vector<uint32_t>{9}));
+
+  std::vector<uint32_t> binary;
+  inst.ToBinaryWithoutAttachedDebugInsts(&binary);
+  EXPECT_THAT(binary, Eq(std::vector<uint32_t>{
+                          (6u << 16) | uint32_t(SpvOpSpecConstant), 42, 43, 5,
+                          6, 9}));
+}
+
+TEST(InstructionTest, ForEachIdUsesPrecomputedOffsets) {
+  // Mixed id and literal operands: only the id words may be visited.
+  Instruction inst(SpvOpExtInst, 42, 43,
+                   {{SPV_OPERAND_TYPE_ID, {10}},
+                    {SPV_OPERAND_TYPE_LITERAL_INTEGER, {7}},
+                    {SPV_OPERAND_TYPE_ID, {11}}});
+  std::vector<uint32_t> ids;
+  inst.ForEachId([&ids](uint32_t* id) { ids.push_back(*id); });
+  EXPECT_THAT(ids, Eq(std::vector<uint32_t>{42, 43, 10, 11}));
+
+  // Appended id operands join the precomputed list.
+  inst.AddOperand(SPV_OPERAND_TYPE_ID, {12});
+  ids.clear();
+  inst.ForEachId([&ids](uint32_t* id) { ids.push_back(*id); });
+  EXPECT_THAT(ids, Eq(std::vector<uint32_t>{42, 43, 10, 11, 12}));
+
+  // A width-changing operand update shifts every trailing id word; the
+  // offsets must follow.
+  inst.SetInOperand(1, {7, 8, 9});
+  ids.clear();
+  inst.ForEachId([&ids](uint32_t* id) { ids.push_back(*id); });
+  EXPECT_THAT(ids, Eq(std::vector<uint32_t>{42, 43, 10, 11, 12}));
+
+  // Rewriting through ForEachId lands in the operand words.
+  inst.ForEachId([](uint32_t* id) { *id += 100; });
+  EXPECT_EQ(142u, inst.type_id());
+  EXPECT_EQ(143u, inst.result_id());
+  EXPECT_THAT(inst.GetInOperand(0).words, Eq(std::vector<uint32_t>{110}));
+  EXPECT_THAT(inst.GetInOperand(3).words, Eq(std::vector<uint32_t>{112}));
+}
 
-  // Check mutation through an iterator.
-  operand2.type = SPV_OPERAND_TYPE_TYPE_ID;
-  EXPECT_EQ(SPV_OPERAND_TYPE_TYPE_ID, (*(inst.cbegin() + 2)).type);
+TEST(InstructionTest, CloneWithMappedIds) {
+  Instruction inst(SpvOpIAdd, 42, 43,
+                   {{SPV_OPERAND_TYPE_ID, {10}}, {SPV_OPERAND_TYPE_ID, {11}}});
+  Instruction clone =
+      inst.CloneWithMappedIds([](uint32_t id) { return id + 100; });
+  // In-operand ids are remapped; type id and result id are left alone.
+  EXPECT_EQ(42u, clone.type_id());
+  EXPECT_EQ(43u, clone.result_id());
+  EXPECT_THAT(clone.GetInOperand(0).words, Eq(std::vector<uint32_t>{110}));
+  EXPECT_THAT(clone.GetInOperand(1).words, Eq(std::vector<uint32_t>{111}));
+  // The original is untouched.
+  EXPECT_THAT(inst.GetInOperand(0).words, Eq(std::vector<uint32_t>{10}));
+  EXPECT_THAT(inst.GetInOperand(1).words, Eq(std::vector<uint32_t>{11}));
 }
 
 }  // anonymous namespace
@@ -0,0 +1,107 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "opt/build_module.h"
+#include "opt/ir_journal.h"
+#include "opt/make_unique.h"
+
+namespace {
+
+using namespace spvtools;
+
+const char kModuleText[] = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+%void = OpTypeVoid
+%fnty = OpTypeFunction %void
+%uint = OpTypeInt 32 0
+%uint_1 = OpConstant %uint 1
+%main = OpFunction %void None %fnty
+%entry = OpLabel
+%sum = OpIAdd %uint %uint_1 %uint_1
+%sum2 = OpIAdd %uint %sum %sum
+OpReturn
+OpFunctionEnd
+)";
+
+TEST(IrJournal, RollbackRestoresTheModule) {
+  std::unique_ptr<ir::Module> module =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, kModuleText);
+  ASSERT_NE(nullptr, module);
+  std::vector<uint32_t> before;
+  module->ToBinary(&before, /* skip_nop = */ true);
+
+  ir::BasicBlock* block = &*module->begin()->begin();
+  ir::ModuleCheckpoint checkpoint(module.get());
+
+  // Speculate: drop both additions and insert a fresh instruction.
+  auto inst = block->begin();
+  inst = inst.Erase();
+  inst = inst.Erase();
+  inst.InsertBefore(MakeUnique<ir::Instruction>(SpvOpNop));
+  EXPECT_EQ(3u, checkpoint.NumChanges());
+
+  checkpoint.Rollback();
+  EXPECT_EQ(0u, checkpoint.NumChanges());
+  std::vector<uint32_t> after;
+  module->ToBinary(&after, /* skip_nop = */ true);
+  EXPECT_EQ(before, after);
+}
+
+TEST(IrJournal, DestructionWithoutRollbackCommits) {
+  std::unique_ptr<ir::Module> module =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, kModuleText);
+  ASSERT_NE(nullptr, module);
+  const uint32_t words_before = module->ComputeBinaryWordCount(true);
+
+  ir::BasicBlock* block = &*module->begin()->begin();
+  {
+    ir::ModuleCheckpoint checkpoint(module.get());
+    auto inst = block->begin();
+    inst = inst.Erase();
+    inst.Erase();
+  }  // The checkpoint dies without a rollback: the erasures stick.
+
+  EXPECT_LT(module->ComputeBinaryWordCount(true), words_before);
+  size_t num_iadds = 0;
+  module->ForEachInst([&num_iadds](ir::Instruction* inst) {
+    if (inst->opcode() == SpvOpIAdd) ++num_iadds;
+  });
+  EXPECT_EQ(0u, num_iadds);
+}
+
+TEST(IrJournal, ArenaRollbackReclaimsStorage) {
+  ir::Arena arena;
+  arena.Allocate(16);
+  const size_t bytes_at_mark = arena.TotalBytes();
+  const ir::Arena::Checkpoint mark = arena.Mark();
+
+  // Fill the rest of the current chunk and force extra chunks.
+  void* speculative = arena.Allocate(64);
+  arena.Allocate(size_t(256) << 10);
+  EXPECT_GT(arena.TotalBytes(), bytes_at_mark);
+
+  arena.Rollback(mark);
+  EXPECT_EQ(bytes_at_mark, arena.TotalBytes());
+  // The bytes handed out since the mark serve later allocations again.
+  EXPECT_EQ(speculative, arena.Allocate(64));
+}
+
+}  // anonymous namespace
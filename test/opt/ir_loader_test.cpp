@@ -358,6 +358,121 @@ TEST(IrBuilder, TerminatorOutsideBasicBlock) {
                       "outside basic block");
 }
 
+TEST(IrBuilder, DeferredFunctionBodies) {
+  // Same module as in the RoundTrip test: two functions, one of which will
+  // be materialized while the other one stays as a raw word range.
+  const std::string text =
+      // clang-format off
+               "OpCapability Shader\n"
+          "%1 = OpExtInstImport \"GLSL.std.450\"\n"
+               "OpMemoryModel Logical GLSL450\n"
+               "OpEntryPoint Vertex %main \"main\"\n"
+       "%void = OpTypeVoid\n"
+          "%6 = OpTypeFunction %void\n"
+        "%int = OpTypeInt 32 1\n"
+ "%_ptr_Function_int = OpTypePointer Function %int\n"
+          "%9 = OpTypeFunction %int %_ptr_Function_int %_ptr_Function_int\n"
+       "%main = OpFunction %void None %6\n"
+         "%10 = OpLabel\n"
+               "OpReturn\n"
+               "OpFunctionEnd\n"
+ "%add_i1_i1_ = OpFunction %int None %9\n"
+          "%a = OpFunctionParameter %_ptr_Function_int\n"
+          "%b = OpFunctionParameter %_ptr_Function_int\n"
+         "%11 = OpLabel\n"
+         "%12 = OpLoad %int %a\n"
+         "%13 = OpLoad %int %b\n"
+         "%14 = OpIAdd %int %12 %13\n"
+               "OpReturnValue %14\n"
+               "OpFunctionEnd\n";
+  // clang-format on
+
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  std::vector<uint32_t> binary;
+  ASSERT_TRUE(t.Assemble(text, &binary));
+
+  std::unique_ptr<ir::Module> module =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, binary.data(), binary.size(),
+                  /* defer_function_bodies = */ true);
+  ASSERT_NE(nullptr, module);
+
+  // Both functions start out as raw word ranges and are written back
+  // verbatim.
+  auto fn = module->begin();
+  EXPECT_TRUE(fn->HasDeferredBody());
+  EXPECT_TRUE((++fn)->HasDeferredBody());
+
+  std::vector<uint32_t> lazy_binary;
+  module->ToBinary(&lazy_binary, /* skip_nop = */ false);
+  EXPECT_EQ(binary, lazy_binary);
+
+  // Iterating the second function's blocks forces its IR to be built; the
+  // first function stays deferred, and serialization still round-trips.
+  fn = ++module->begin();
+  uint32_t num_blocks = 0;
+  for (auto& bb : *fn) {
+    bb.ForEachInst([](ir::Instruction*) {});
+    ++num_blocks;
+  }
+  EXPECT_EQ(1u, num_blocks);
+  EXPECT_FALSE(fn->HasDeferredBody());
+  EXPECT_TRUE(module->begin()->HasDeferredBody());
+
+  std::vector<uint32_t> mixed_binary;
+  module->ToBinary(&mixed_binary, /* skip_nop = */ false);
+  EXPECT_EQ(binary, mixed_binary);
+}
+
+TEST(IrBuilder, ParallelFunctionLoading) {
+  // Same module as in the DeferredFunctionBodies test.  With a thread count
+  // of two or more, both function bodies are built by worker threads into
+  // per-function arenas, and the result round-trips like an eager load.
+  const std::string text =
+      // clang-format off
+               "OpCapability Shader\n"
+          "%1 = OpExtInstImport \"GLSL.std.450\"\n"
+               "OpMemoryModel Logical GLSL450\n"
+               "OpEntryPoint Vertex %main \"main\"\n"
+       "%void = OpTypeVoid\n"
+          "%6 = OpTypeFunction %void\n"
+        "%int = OpTypeInt 32 1\n"
+ "%_ptr_Function_int = OpTypePointer Function %int\n"
+          "%9 = OpTypeFunction %int %_ptr_Function_int %_ptr_Function_int\n"
+       "%main = OpFunction %void None %6\n"
+         "%10 = OpLabel\n"
+               "OpReturn\n"
+               "OpFunctionEnd\n"
+ "%add_i1_i1_ = OpFunction %int None %9\n"
+          "%a = OpFunctionParameter %_ptr_Function_int\n"
+          "%b = OpFunctionParameter %_ptr_Function_int\n"
+         "%11 = OpLabel\n"
+         "%12 = OpLoad %int %a\n"
+         "%13 = OpLoad %int %b\n"
+         "%14 = OpIAdd %int %12 %13\n"
+               "OpReturnValue %14\n"
+               "OpFunctionEnd\n";
+  // clang-format on
+
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  std::vector<uint32_t> binary;
+  ASSERT_TRUE(t.Assemble(text, &binary));
+
+  std::unique_ptr<ir::Module> module =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, binary.data(), binary.size(),
+                  /* defer_function_bodies = */ false, /* num_threads = */ 4);
+  ASSERT_NE(nullptr, module);
+
+  // Both bodies are already built, each in its own arena.
+  for (auto& fn : *module) {
+    EXPECT_FALSE(fn.HasDeferredBody());
+    EXPECT_NE(nullptr, fn.body_arena());
+  }
+
+  std::vector<uint32_t> round_trip;
+  module->ToBinary(&round_trip, /* skip_nop = */ false);
+  EXPECT_EQ(binary, round_trip);
+}
+
 TEST(IrBuilder, NotAllowedInstAppearingInFunction) {
   DoErrorMessageCheck("%2 = OpFunction %1 None %3\n%5 = OpVariable %4 Function",
                       "error: <instruction>:2:0:0: Non-OpFunctionParameter "
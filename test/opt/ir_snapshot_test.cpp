@@ -0,0 +1,114 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "opt/ir_snapshot.h"
+#include "spirv-tools/libspirv.hpp"
+
+namespace {
+
+using namespace spvtools;
+
+const char kModule[] =
+    "OpCapability Shader\n"
+    "OpMemoryModel Logical GLSL450\n"
+    "OpEntryPoint Vertex %main \"main\"\n"
+    "OpName %main \"main\"\n"
+    "%void = OpTypeVoid\n"
+    "%voidfn = OpTypeFunction %void\n"
+    "%uint = OpTypeInt 32 0\n"
+    "%uint_1 = OpConstant %uint 1\n"
+    "%main = OpFunction %void None %voidfn\n"
+    "%entry = OpLabel\n"
+    "OpReturn\n"
+    "OpFunctionEnd\n";
+
+std::vector<uint32_t> Assemble(const std::string& text) {
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  std::vector<uint32_t> binary;
+  EXPECT_TRUE(t.Assemble(text, &binary)) << "Failed to assemble\n" << text;
+  return binary;
+}
+
+TEST(IrSnapshot, RoundTrip) {
+  const std::vector<uint32_t> binary = Assemble(kModule);
+  std::vector<uint32_t> snapshot;
+  ASSERT_TRUE(SaveModuleSnapshot(SPV_ENV_UNIVERSAL_1_1, nullptr, binary.data(),
+                                 binary.size(), &snapshot));
+  EXPECT_GT(snapshot.size(), binary.size());
+
+  std::unique_ptr<ir::Module> module = BuildModuleFromSnapshot(
+      nullptr, binary.data(), binary.size(), snapshot.data(), snapshot.size());
+  ASSERT_NE(nullptr, module);
+
+  std::vector<uint32_t> rebuilt;
+  module->ToBinary(&rebuilt, /* skip_nop = */ false);
+  EXPECT_EQ(binary, rebuilt);
+}
+
+TEST(IrSnapshot, RejectsChangedBinary) {
+  const std::vector<uint32_t> binary = Assemble(kModule);
+  std::vector<uint32_t> snapshot;
+  ASSERT_TRUE(SaveModuleSnapshot(SPV_ENV_UNIVERSAL_1_1, nullptr, binary.data(),
+                                 binary.size(), &snapshot));
+
+  // The shader was edited since the snapshot was written: same word count,
+  // different content.
+  std::string other(kModule);
+  const size_t constant_at = other.find("OpConstant %uint 1");
+  ASSERT_NE(std::string::npos, constant_at);
+  other.replace(constant_at, 18, "OpConstant %uint 2");
+  const std::vector<uint32_t> edited = Assemble(other);
+  ASSERT_EQ(binary.size(), edited.size());
+
+  EXPECT_EQ(nullptr,
+            BuildModuleFromSnapshot(nullptr, edited.data(), edited.size(),
+                                    snapshot.data(), snapshot.size()));
+}
+
+TEST(IrSnapshot, RejectsCorruptHeader) {
+  const std::vector<uint32_t> binary = Assemble(kModule);
+  std::vector<uint32_t> snapshot;
+  ASSERT_TRUE(SaveModuleSnapshot(SPV_ENV_UNIVERSAL_1_1, nullptr, binary.data(),
+                                 binary.size(), &snapshot));
+
+  std::vector<uint32_t> bad_magic = snapshot;
+  bad_magic[0] ^= 1;
+  EXPECT_EQ(nullptr,
+            BuildModuleFromSnapshot(nullptr, binary.data(), binary.size(),
+                                    bad_magic.data(), bad_magic.size()));
+
+  // A snapshot from a future format version is not guessed at.
+  std::vector<uint32_t> bad_version = snapshot;
+  bad_version[1] += 1;
+  EXPECT_EQ(nullptr,
+            BuildModuleFromSnapshot(nullptr, binary.data(), binary.size(),
+                                    bad_version.data(), bad_version.size()));
+}
+
+TEST(IrSnapshot, RejectsTruncatedSnapshot) {
+  const std::vector<uint32_t> binary = Assemble(kModule);
+  std::vector<uint32_t> snapshot;
+  ASSERT_TRUE(SaveModuleSnapshot(SPV_ENV_UNIVERSAL_1_1, nullptr, binary.data(),
+                                 binary.size(), &snapshot));
+
+  for (size_t size : {snapshot.size() - 1, snapshot.size() / 2, size_t(3)}) {
+    EXPECT_EQ(nullptr, BuildModuleFromSnapshot(nullptr, binary.data(),
+                                               binary.size(), snapshot.data(),
+                                               size));
+  }
+}
+
+}  // anonymous namespace
@@ -17,6 +17,7 @@
 
 #include "gmock/gmock.h"
 
+#include "opt/basic_block.h"
 #include "opt/iterator.h"
 #include "opt/make_unique.h"
 
@@ -25,6 +26,21 @@ namespace {
 using namespace spvtools;
 using ::testing::ContainerEq;
 
+// Returns an instruction with the given |result_id|, for identification in
+// InstructionList tests.
+std::unique_ptr<ir::Instruction> MakeInst(uint32_t result_id) {
+  return MakeUnique<ir::Instruction>(SpvOpUndef, 0u, result_id,
+                                     std::vector<ir::Operand>{});
+}
+
+// Returns the result ids of the instructions in |list|, in list order.
+std::vector<uint32_t> IdsOf(ir::InstructionList& list) {
+  std::vector<uint32_t> ids;
+  for (auto it = list.begin(); it != list.end(); ++it)
+    ids.push_back(it->result_id());
+  return ids;
+}
+
 TEST(Iterator, IncrementDeref) {
   const int count = 100;
   std::vector<std::unique_ptr<int>> data;
@@ -214,4 +230,65 @@ TEST(IteratorRange, Interface) {
   EXPECT_EQ(count, range.size());
 }
 
+TEST(InstructionList, PushBackAndIterate) {
+  ir::InstructionList list;
+  EXPECT_TRUE(list.empty());
+  for (uint32_t id = 1; id <= 3; ++id) list.push_back(MakeInst(id));
+
+  EXPECT_FALSE(list.empty());
+  EXPECT_EQ(3u, list.back().result_id());
+  EXPECT_THAT(IdsOf(list), ContainerEq(std::vector<uint32_t>{1, 2, 3}));
+
+  // Decrementing from end() walks the list backwards.
+  auto it = list.end();
+  for (uint32_t id = 3; id >= 1; --id) {
+    --it;
+    EXPECT_EQ(id, it->result_id());
+  }
+  EXPECT_EQ(list.begin(), it);
+}
+
+TEST(InstructionList, InsertBefore) {
+  ir::InstructionList list;
+  list.push_back(MakeInst(1));
+  list.push_back(MakeInst(3));
+
+  // Insert in the middle; the returned iterator points at the new element.
+  auto it = list.begin();
+  ++it;
+  it = it.InsertBefore(MakeInst(2));
+  EXPECT_EQ(2u, it->result_id());
+
+  // Insert a whole vector at the end.
+  std::vector<std::unique_ptr<ir::Instruction>> tail;
+  tail.push_back(MakeInst(4));
+  tail.push_back(MakeInst(5));
+  auto first = list.end().InsertBefore(&tail);
+  EXPECT_EQ(4u, first->result_id());
+
+  EXPECT_THAT(IdsOf(list), ContainerEq(std::vector<uint32_t>{1, 2, 3, 4, 5}));
+  EXPECT_EQ(5u, list.back().result_id());
+}
+
+TEST(InstructionList, Erase) {
+  ir::InstructionList list;
+  for (uint32_t id = 1; id <= 3; ++id) list.push_back(MakeInst(id));
+
+  // Erasing the middle element returns an iterator to its successor and
+  // leaves other iterators valid.
+  auto begin = list.begin();
+  auto it = list.begin();
+  ++it;
+  it = it.Erase();
+  EXPECT_EQ(3u, it->result_id());
+  EXPECT_EQ(1u, begin->result_id());
+  EXPECT_THAT(IdsOf(list), ContainerEq(std::vector<uint32_t>{1, 3}));
+
+  // Erase down to an empty list.
+  it = list.begin().Erase();
+  it = it.Erase();
+  EXPECT_EQ(list.end(), it);
+  EXPECT_TRUE(list.empty());
+}
+
 }  // anonymous namespace
@@ -0,0 +1,237 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using LicmTest = PassTest<::testing::Test>;
+
+TEST_F(LicmTest, HoistsInvariantComputation) {
+  // The multiply only reads loop-external constants and moves to the
+  // preheader; the induction increment reads the phi and stays.
+  const std::string before = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+%void = OpTypeVoid
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%int = OpTypeInt 32 1
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%8 = OpTypeFunction %void
+%main = OpFunction %void None %8
+%9 = OpLabel
+OpBranch %10
+%10 = OpLabel
+%11 = OpPhi %int %int_1 %9 %12 %13
+OpLoopMerge %14 %13 None
+OpBranchConditional %true %15 %14
+%15 = OpLabel
+%16 = OpIMul %int %int_2 %int_2
+%12 = OpIAdd %int %11 %int_1
+OpBranch %13
+%13 = OpLabel
+OpBranch %10
+%14 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  const std::string after = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+%void = OpTypeVoid
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%int = OpTypeInt 32 1
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%8 = OpTypeFunction %void
+%main = OpFunction %void None %8
+%9 = OpLabel
+%17 = OpIMul %int %int_2 %int_2
+OpBranch %10
+%10 = OpLabel
+%11 = OpPhi %int %int_1 %9 %12 %13
+OpLoopMerge %14 %13 None
+OpBranchConditional %true %15 %14
+%15 = OpLabel
+%12 = OpIAdd %int %11 %int_1
+OpBranch %13
+%13 = OpLabel
+OpBranch %10
+%14 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::LicmPass>(before, after, /* skip_nop = */ true);
+}
+
+TEST_F(LicmTest, HoistsInputLoadAndDependentComputation) {
+  // The load reads Input storage, which the shader cannot write, so it is
+  // invariant; once hoisted, the multiply depending on it follows.
+  const std::string before = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %in_var
+OpName %main "main"
+OpName %in_var "in_var"
+%void = OpTypeVoid
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%float = OpTypeFloat 32
+%_ptr_Input_float = OpTypePointer Input %float
+%in_var = OpVariable %_ptr_Input_float Input
+%9 = OpTypeFunction %void
+%main = OpFunction %void None %9
+%10 = OpLabel
+OpBranch %11
+%11 = OpLabel
+OpLoopMerge %12 %13 None
+OpBranchConditional %true %14 %12
+%14 = OpLabel
+%15 = OpLoad %float %in_var
+%16 = OpFMul %float %15 %15
+OpBranch %13
+%13 = OpLabel
+OpBranch %11
+%12 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  const std::string after = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %in_var
+OpName %main "main"
+OpName %in_var "in_var"
+%void = OpTypeVoid
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%float = OpTypeFloat 32
+%_ptr_Input_float = OpTypePointer Input %float
+%in_var = OpVariable %_ptr_Input_float Input
+%9 = OpTypeFunction %void
+%main = OpFunction %void None %9
+%10 = OpLabel
+%17 = OpLoad %float %in_var
+%18 = OpFMul %float %17 %17
+OpBranch %11
+%11 = OpLabel
+OpLoopMerge %12 %13 None
+OpBranchConditional %true %14 %12
+%14 = OpLabel
+OpBranch %13
+%13 = OpLabel
+OpBranch %11
+%12 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::LicmPass>(before, after, /* skip_nop = */ true);
+}
+
+TEST_F(LicmTest, LeavesStorageBufferLoadAlone) {
+  // The pointee struct is a BufferBlock, so the memory is writable and the
+  // load must stay inside the loop.
+  const std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+OpName %S "S"
+OpName %ssbo "ssbo"
+OpMemberDecorate %S 0 Offset 0
+OpDecorate %S BufferBlock
+OpDecorate %ssbo DescriptorSet 0
+OpDecorate %ssbo Binding 0
+%void = OpTypeVoid
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%float = OpTypeFloat 32
+%S = OpTypeStruct %float
+%_ptr_Uniform_S = OpTypePointer Uniform %S
+%ssbo = OpVariable %_ptr_Uniform_S Uniform
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%_ptr_Uniform_float = OpTypePointer Uniform %float
+%12 = OpTypeFunction %void
+%main = OpFunction %void None %12
+%13 = OpLabel
+%14 = OpAccessChain %_ptr_Uniform_float %ssbo %uint_0
+OpBranch %15
+%15 = OpLabel
+OpLoopMerge %16 %17 None
+OpBranchConditional %true %18 %16
+%18 = OpLabel
+%19 = OpLoad %float %14
+OpBranch %17
+%17 = OpLabel
+OpBranch %15
+%16 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::LicmPass>(text, text, /* skip_nop = */ true);
+}
+
+TEST_F(LicmTest, LeavesArrayedStorageBufferLoadAlone) {
+  // The variable points at an array of BufferBlock structs; the decoration
+  // sits on the element type, but the memory is just as writable and the
+  // load must stay inside the loop.
+  const std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+OpName %S "S"
+OpName %ssbos "ssbos"
+OpMemberDecorate %S 0 Offset 0
+OpDecorate %S BufferBlock
+OpDecorate %ssbos DescriptorSet 0
+OpDecorate %ssbos Binding 0
+%void = OpTypeVoid
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%float = OpTypeFloat 32
+%S = OpTypeStruct %float
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%uint_2 = OpConstant %uint 2
+%_arr_S_uint_2 = OpTypeArray %S %uint_2
+%_ptr_Uniform__arr_S_uint_2 = OpTypePointer Uniform %_arr_S_uint_2
+%ssbos = OpVariable %_ptr_Uniform__arr_S_uint_2 Uniform
+%_ptr_Uniform_float = OpTypePointer Uniform %float
+%14 = OpTypeFunction %void
+%main = OpFunction %void None %14
+%15 = OpLabel
+%16 = OpAccessChain %_ptr_Uniform_float %ssbos %uint_0 %uint_0
+OpBranch %17
+%17 = OpLabel
+OpLoopMerge %18 %19 None
+OpBranchConditional %true %20 %18
+%20 = OpLabel
+%21 = OpLoad %float %16
+OpBranch %19
+%19 = OpLabel
+OpBranch %17
+%18 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::LicmPass>(text, text, /* skip_nop = */ true);
+}
+
+}  // anonymous namespace
@@ -0,0 +1,158 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "opt/build_module.h"
+#include "opt/link.h"
+#include "spirv-tools/libspirv.hpp"
+
+namespace {
+
+using namespace spvtools;
+
+// Returns the number of occurrences of |substring| in |text|.
+size_t Count(const std::string& text, const std::string& substring) {
+  size_t count = 0;
+  for (size_t pos = text.find(substring); pos != std::string::npos;
+       pos = text.find(substring, pos + substring.size())) {
+    ++count;
+  }
+  return count;
+}
+
+// Builds the given modules, links them, and returns the disassembly of the
+// result through |linked_text|.  Returns false if building or linking fails.
+bool AssembleAndLink(const std::vector<std::string>& texts,
+                     std::string* linked_text) {
+  std::vector<std::unique_ptr<ir::Module>> modules;
+  std::vector<ir::Module*> module_ptrs;
+  for (const std::string& text : texts) {
+    modules.push_back(BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text));
+    if (!modules.back()) return false;
+    module_ptrs.push_back(modules.back().get());
+  }
+  std::vector<uint32_t> linked_binary;
+  if (!Link(module_ptrs, &linked_binary, nullptr)) return false;
+
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  return t.Disassemble(linked_binary, linked_text);
+}
+
+TEST(Link, DeduplicatesTypesConstantsAndCapabilities) {
+  const std::string module_a = R"(
+    OpCapability Shader
+    OpCapability Linkage
+    OpMemoryModel Logical GLSL450
+    %uint = OpTypeInt 32 0
+    %shared = OpConstant %uint 42
+    %only_a = OpConstant %uint 100)";
+  const std::string module_b = R"(
+    OpCapability Shader
+    OpCapability Linkage
+    OpMemoryModel Logical GLSL450
+    %uint = OpTypeInt 32 0
+    %shared = OpConstant %uint 42
+    %only_b = OpConstant %uint 200)";
+
+  std::string linked;
+  ASSERT_TRUE(AssembleAndLink({module_a, module_b}, &linked));
+  EXPECT_EQ(1u, Count(linked, "OpCapability Shader"));
+  EXPECT_EQ(1u, Count(linked, "OpMemoryModel"));
+  EXPECT_EQ(1u, Count(linked, "OpTypeInt 32 0"));
+  EXPECT_EQ(1u, Count(linked, "OpConstant %uint 42"));
+  EXPECT_EQ(1u, Count(linked, "OpConstant %uint 100"));
+  EXPECT_EQ(1u, Count(linked, "OpConstant %uint 200"));
+}
+
+TEST(Link, ResolvesLinkageImports) {
+  const std::string exporter = R"(
+    OpCapability Linkage
+    OpCapability Shader
+    OpMemoryModel Logical GLSL450
+    OpDecorate %foo LinkageAttributes "foo" Export
+    %uint = OpTypeInt 32 0
+    %c = OpConstant %uint 42
+    %fnty = OpTypeFunction %uint
+    %foo = OpFunction %uint None %fnty
+    %fb = OpLabel
+    OpReturnValue %c
+    OpFunctionEnd)";
+  const std::string importer = R"(
+    OpCapability Linkage
+    OpCapability Shader
+    OpMemoryModel Logical GLSL450
+    OpDecorate %foo LinkageAttributes "foo" Import
+    OpDecorate %bar LinkageAttributes "bar" Export
+    %uint = OpTypeInt 32 0
+    %fnty = OpTypeFunction %uint
+    %foo = OpFunction %uint None %fnty
+    OpFunctionEnd
+    %bar = OpFunction %uint None %fnty
+    %bb = OpLabel
+    %call = OpFunctionCall %uint %foo
+    OpReturnValue %call
+    OpFunctionEnd)";
+
+  std::string linked;
+  ASSERT_TRUE(AssembleAndLink({exporter, importer}, &linked));
+  // The importing declaration is gone: only the exported definition and the
+  // caller remain, and the call goes to the exported function.
+  EXPECT_EQ(2u, Count(linked, "OpFunction "));
+  EXPECT_EQ(0u, Count(linked, "Import"));
+  EXPECT_EQ(1u, Count(linked, "LinkageAttributes \"foo\" Export"));
+  EXPECT_EQ(1u, Count(linked, "OpFunctionCall"));
+
+  // The linked module must itself be valid.
+  std::vector<uint32_t> linked_binary;
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  ASSERT_TRUE(t.Assemble(linked, &linked_binary));
+  EXPECT_TRUE(t.Validate(linked_binary));
+}
+
+TEST(Link, KeepsUnresolvedImports) {
+  const std::string importer = R"(
+    OpCapability Linkage
+    OpCapability Shader
+    OpMemoryModel Logical GLSL450
+    OpDecorate %foo LinkageAttributes "foo" Import
+    %uint = OpTypeInt 32 0
+    %fnty = OpTypeFunction %uint
+    %foo = OpFunction %uint None %fnty
+    OpFunctionEnd)";
+
+  std::string linked;
+  ASSERT_TRUE(AssembleAndLink({importer}, &linked));
+  // Without a matching export the declaration stays, so the result can be
+  // linked again later.
+  EXPECT_EQ(1u, Count(linked, "LinkageAttributes \"foo\" Import"));
+  EXPECT_EQ(1u, Count(linked, "OpFunction "));
+}
+
+TEST(Link, MemoryModelMismatchFails) {
+  const std::string module_a = R"(
+    OpCapability Shader
+    OpCapability Linkage
+    OpMemoryModel Logical GLSL450)";
+  const std::string module_b = R"(
+    OpCapability Kernel
+    OpCapability Addresses
+    OpCapability Linkage
+    OpMemoryModel Physical32 OpenCL)";
+
+  std::string linked;
+  EXPECT_FALSE(AssembleAndLink({module_a, module_b}, &linked));
+}
+
+}  // anonymous namespace
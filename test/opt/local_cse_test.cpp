@@ -0,0 +1,206 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using LocalCSETest = PassTest<::testing::Test>;
+
+TEST_F(LocalCSETest, ReusesRepeatedArithmetic) {
+  const std::string before = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %out_var
+OpName %main "main"
+OpName %out_var "out_var"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%_ptr_Output_float = OpTypePointer Output %float
+%out_var = OpVariable %_ptr_Output_float Output
+%7 = OpTypeFunction %void
+%main = OpFunction %void None %7
+%8 = OpLabel
+%9 = OpFAdd %float %float_1 %float_1
+%10 = OpFAdd %float %float_1 %float_1
+%11 = OpFMul %float %9 %10
+OpStore %out_var %11
+OpReturn
+OpFunctionEnd
+)";
+  const std::string after = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %out_var
+OpName %main "main"
+OpName %out_var "out_var"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%_ptr_Output_float = OpTypePointer Output %float
+%out_var = OpVariable %_ptr_Output_float Output
+%7 = OpTypeFunction %void
+%main = OpFunction %void None %7
+%8 = OpLabel
+%9 = OpFAdd %float %float_1 %float_1
+%11 = OpFMul %float %9 %9
+OpStore %out_var %11
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::LocalCSEPass>(before, after,
+                                           /* skip_nop = */ true);
+}
+
+TEST_F(LocalCSETest, MatchesCommutedOperands) {
+  const std::string before = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %out_var
+OpName %main "main"
+OpName %out_var "out_var"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%float_2 = OpConstant %float 2
+%_ptr_Output_float = OpTypePointer Output %float
+%out_var = OpVariable %_ptr_Output_float Output
+%8 = OpTypeFunction %void
+%main = OpFunction %void None %8
+%9 = OpLabel
+%10 = OpFAdd %float %float_1 %float_2
+%11 = OpFAdd %float %float_2 %float_1
+%12 = OpFMul %float %10 %11
+OpStore %out_var %12
+OpReturn
+OpFunctionEnd
+)";
+  const std::string after = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %out_var
+OpName %main "main"
+OpName %out_var "out_var"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%float_2 = OpConstant %float 2
+%_ptr_Output_float = OpTypePointer Output %float
+%out_var = OpVariable %_ptr_Output_float Output
+%8 = OpTypeFunction %void
+%main = OpFunction %void None %8
+%9 = OpLabel
+%10 = OpFAdd %float %float_1 %float_2
+%12 = OpFMul %float %10 %10
+OpStore %out_var %12
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::LocalCSEPass>(before, after,
+                                           /* skip_nop = */ true);
+}
+
+TEST_F(LocalCSETest, ReusesRepeatedLoad) {
+  const std::string before = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+OpName %var "var"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%_ptr_Private_float = OpTypePointer Private %float
+%var = OpVariable %_ptr_Private_float Private
+%6 = OpTypeFunction %void
+%main = OpFunction %void None %6
+%7 = OpLabel
+%8 = OpLoad %float %var
+%9 = OpLoad %float %var
+%10 = OpFAdd %float %8 %9
+OpStore %var %10
+OpReturn
+OpFunctionEnd
+)";
+  const std::string after = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+OpName %var "var"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%_ptr_Private_float = OpTypePointer Private %float
+%var = OpVariable %_ptr_Private_float Private
+%6 = OpTypeFunction %void
+%main = OpFunction %void None %6
+%7 = OpLabel
+%8 = OpLoad %float %var
+%10 = OpFAdd %float %8 %8
+OpStore %var %10
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::LocalCSEPass>(before, after,
+                                           /* skip_nop = */ true);
+}
+
+TEST_F(LocalCSETest, DoesNotCombineVolatileLoads) {
+  // Two identical volatile loads must both execute; neither may be
+  // replaced by the other's result.
+  const std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+OpName %var "var"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%_ptr_Private_float = OpTypePointer Private %float
+%var = OpVariable %_ptr_Private_float Private
+%6 = OpTypeFunction %void
+%main = OpFunction %void None %6
+%7 = OpLabel
+%8 = OpLoad %float %var Volatile
+%9 = OpLoad %float %var Volatile
+%10 = OpFAdd %float %8 %9
+OpStore %var %10
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::LocalCSEPass>(text, text,
+                                           /* skip_nop = */ true);
+}
+
+TEST_F(LocalCSETest, StoreInvalidatesLoad) {
+  const std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+OpName %var "var"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%_ptr_Private_float = OpTypePointer Private %float
+%var = OpVariable %_ptr_Private_float Private
+%6 = OpTypeFunction %void
+%main = OpFunction %void None %6
+%7 = OpLabel
+%8 = OpLoad %float %var
+OpStore %var %8
+%9 = OpLoad %float %var
+OpStore %var %9
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::LocalCSEPass>(text, text,
+                                           /* skip_nop = */ true);
+}
+
+}  // anonymous namespace
@@ -69,4 +69,212 @@ TEST(ModuleTest, ComputeIdBound) {
                 ->ComputeIdBound());
 }
 
+TEST(ModuleTest, ToBinaryExactSizeAndCallerBuffer) {
+  const std::string text =
+      "OpCapability Shader\n"
+      "OpMemoryModel Logical GLSL450\n"
+      "%void = OpTypeVoid\n"
+      "%3 = OpTypeFunction %void\n"
+      "%4 = OpFunction %void None %3\n"
+      "%5 = OpLabel\n"
+      "OpReturn\n"
+      "OpFunctionEnd\n";
+  std::unique_ptr<Module> module = BuildModule(text);
+  ASSERT_NE(nullptr, module);
+
+  std::vector<uint32_t> binary;
+  module->ToBinary(&binary, /* skip_nop = */ false);
+  EXPECT_EQ(binary.size(), module->ComputeBinaryWordCount(false));
+
+  // The raw-buffer overload produces the same words in place.
+  std::vector<uint32_t> buffer(module->ComputeBinaryWordCount(false));
+  EXPECT_EQ(buffer.size(),
+            module->ToBinary(buffer.data(), /* skip_nop = */ false));
+  EXPECT_EQ(binary, buffer);
+}
+
+TEST(ModuleTest, ToBinaryParallel) {
+  const std::string text =
+      "OpCapability Shader\n"
+      "OpMemoryModel Logical GLSL450\n"
+      "%void = OpTypeVoid\n"
+      "%3 = OpTypeFunction %void\n"
+      "%4 = OpFunction %void None %3\n"
+      "%5 = OpLabel\n"
+      "OpReturn\n"
+      "OpFunctionEnd\n"
+      "%6 = OpFunction %void None %3\n"
+      "%7 = OpLabel\n"
+      "OpReturn\n"
+      "OpFunctionEnd\n";
+  std::unique_ptr<Module> module = BuildModule(text);
+  ASSERT_NE(nullptr, module);
+
+  // Worker threads writing into their own slices produce the same words as
+  // the serial append.
+  std::vector<uint32_t> serial;
+  module->ToBinary(&serial, /* skip_nop = */ false);
+  std::vector<uint32_t> parallel;
+  module->ToBinary(&parallel, /* skip_nop = */ false, /* num_threads = */ 4);
+  EXPECT_EQ(serial, parallel);
+}
+
+TEST(ModuleTest, CachedTypeAndConstantViews) {
+  const std::string text =
+      "%uint = OpTypeInt 32 0\n"
+      "%float = OpTypeFloat 32\n"
+      "%one = OpConstant %uint 1\n"
+      "%pi = OpConstant %float 3.14159\n";
+  std::unique_ptr<Module> module = BuildModule(text);
+  ASSERT_NE(nullptr, module);
+
+  const std::vector<spvtools::ir::Instruction*>& types = module->GetTypes();
+  const std::vector<spvtools::ir::Instruction*>& constants =
+      module->GetConstants();
+  EXPECT_EQ(2u, types.size());
+  EXPECT_EQ(2u, constants.size());
+  EXPECT_EQ(SpvOpTypeInt, types[0]->opcode());
+  EXPECT_EQ(SpvOpTypeFloat, types[1]->opcode());
+  EXPECT_EQ(SpvOpConstant, constants[0]->opcode());
+
+  // Repeated calls return the same cached view.
+  EXPECT_EQ(&types, &module->GetTypes());
+
+  // Mutating the global section refreshes the view.
+  module->AddGlobalValue(SpvOpConstantNull, 42u, types[0]->result_id());
+  EXPECT_EQ(3u, module->GetConstants().size());
+  EXPECT_EQ(SpvOpConstantNull, module->GetConstants()[2]->opcode());
+  EXPECT_EQ(2u, module->GetTypes().size());
+}
+
+TEST(ModuleTest, EstimateMemoryUsage) {
+  const std::string text =
+      "OpCapability Shader\n"
+      "OpMemoryModel Logical GLSL450\n"
+      "%void = OpTypeVoid\n"
+      "%3 = OpTypeFunction %void\n"
+      "%4 = OpFunction %void None %3\n"
+      "%5 = OpLabel\n"
+      "OpReturn\n"
+      "OpFunctionEnd\n";
+  std::unique_ptr<Module> module = BuildModule(text);
+  ASSERT_NE(nullptr, module);
+
+  // The estimate covers at least the module object and its arena.
+  const size_t usage = module->EstimateMemoryUsage();
+  EXPECT_GE(usage, sizeof(Module) + module->arena().TotalBytes());
+
+  // Measuring must not change the footprint.
+  EXPECT_EQ(usage, module->EstimateMemoryUsage());
+
+  // A larger module reports a larger footprint.
+  EXPECT_LT(BuildModule("")->EstimateMemoryUsage(), usage);
+}
+
+// An allocator that counts its live bytes, so the test can observe the
+// module arena drawing from it and handing everything back.
+struct TrackingAllocator {
+  size_t num_allocations = 0;
+  size_t live_bytes = 0;
+
+  static void* Allocate(void* user_data, size_t num_bytes) {
+    TrackingAllocator* self = static_cast<TrackingAllocator*>(user_data);
+    ++self->num_allocations;
+    self->live_bytes += num_bytes;
+    return ::operator new(num_bytes);
+  }
+
+  static void Deallocate(void* user_data, void* pointer, size_t num_bytes) {
+    TrackingAllocator* self = static_cast<TrackingAllocator*>(user_data);
+    self->live_bytes -= num_bytes;
+    ::operator delete(pointer);
+  }
+
+  spv_allocator_t c_allocator() { return {this, &Allocate, &Deallocate}; }
+};
+
+TEST(ModuleTest, BuildModuleWithCallerAllocator) {
+  const std::string text =
+      "OpCapability Shader\n"
+      "OpMemoryModel Logical GLSL450\n"
+      "%void = OpTypeVoid\n"
+      "%3 = OpTypeFunction %void\n"
+      "%4 = OpFunction %void None %3\n"
+      "%5 = OpLabel\n"
+      "OpReturn\n"
+      "OpFunctionEnd\n";
+  spvtools::SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  std::vector<uint32_t> binary;
+  ASSERT_TRUE(t.Assemble(text, &binary));
+
+  TrackingAllocator tracker;
+  const spv_allocator_t allocator = tracker.c_allocator();
+  std::unique_ptr<Module> module =
+      spvtools::BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, binary.data(),
+                            binary.size(), false, 1, &allocator);
+  ASSERT_NE(nullptr, module);
+
+  // The arena's chunks came from the tracker and are still outstanding.
+  EXPECT_GT(module->arena().TotalBytes(), 0u);
+  EXPECT_GE(tracker.live_bytes, module->arena().TotalBytes());
+
+  // Destroying the module returns every chunk.
+  module.reset();
+  EXPECT_EQ(0u, tracker.live_bytes);
+}
+
+TEST(ModuleTest, CompactPreservesBinaryAndDropsNops) {
+  const std::string text =
+      "OpCapability Shader\n"
+      "OpMemoryModel Logical GLSL450\n"
+      "%void = OpTypeVoid\n"
+      "%3 = OpTypeFunction %void\n"
+      "%4 = OpFunction %void None %3\n"
+      "%5 = OpLabel\n"
+      "OpNop\n"
+      "OpReturn\n"
+      "OpFunctionEnd\n";
+  std::unique_ptr<Module> module = BuildModule(text);
+  ASSERT_NE(nullptr, module);
+
+  std::vector<uint32_t> before;
+  module->ToBinary(&before, /* skip_nop = */ true);
+  const uint32_t bound_before = module->id_bound();
+
+  ASSERT_TRUE(module->Compact(SPV_ENV_UNIVERSAL_1_1));
+
+  // The live instructions round-trip exactly; the OpNop slot is gone even
+  // from the unfiltered serialization.
+  std::vector<uint32_t> after;
+  module->ToBinary(&after, /* skip_nop = */ true);
+  EXPECT_EQ(before, after);
+  EXPECT_EQ(before.size(), module->ComputeBinaryWordCount(false));
+  EXPECT_EQ(bound_before, module->id_bound());
+}
+
+TEST(ModuleTest, CompactKeepsCallerAllocator) {
+  const std::string text =
+      "OpCapability Shader\n"
+      "OpMemoryModel Logical GLSL450\n"
+      "%void = OpTypeVoid\n";
+  spvtools::SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  std::vector<uint32_t> binary;
+  ASSERT_TRUE(t.Assemble(text, &binary));
+
+  TrackingAllocator tracker;
+  const spv_allocator_t allocator = tracker.c_allocator();
+  std::unique_ptr<Module> module =
+      spvtools::BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, binary.data(),
+                            binary.size(), false, 1, &allocator);
+  ASSERT_NE(nullptr, module);
+
+  // The compacted arena's chunks still come from the tracker, and the
+  // fragmented arena's chunks went back to it.
+  ASSERT_TRUE(module->Compact(SPV_ENV_UNIVERSAL_1_1));
+  EXPECT_GT(module->arena().TotalBytes(), 0u);
+  EXPECT_GE(tracker.live_bytes, module->arena().TotalBytes());
+  module.reset();
+  EXPECT_EQ(0u, tracker.live_bytes);
+}
+
 }  // anonymous namespace
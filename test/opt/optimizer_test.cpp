@@ -106,4 +106,91 @@ TEST(Optimizer, CanRunTransformingPassWithAliasedVectors) {
   EXPECT_THAT(disassembly, Eq("%void = OpTypeVoid\n"));
 }
 
+TEST(Optimizer, CanRunTransformingPassOnSingleVectorInPlace) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary;
+  tools.Assemble("OpName %foo \"foo\"\n%foo = OpTypeVoid", &binary);
+
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  opt.RegisterPass(CreateStripDebugInfoPass());
+  EXPECT_TRUE(opt.Run(&binary));  // This is the key.
+
+  std::string disassembly;
+  tools.Disassemble(binary.data(), binary.size(), &disassembly);
+  EXPECT_THAT(disassembly, Eq("%void = OpTypeVoid\n"));
+}
+
+TEST(Optimizer, CanRunNullPassOnSingleVectorInPlace) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary;
+  tools.Assemble("OpName %foo \"foo\"\n%foo = OpTypeVoid", &binary);
+  const uint32_t* orig_data = binary.data();
+
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  opt.RegisterPass(CreateNullPass());
+  EXPECT_TRUE(opt.Run(&binary));
+  // An unchanged module keeps the original storage.
+  EXPECT_THAT(binary.data(), Eq(orig_data));
+
+  std::string disassembly;
+  tools.Disassemble(binary.data(), binary.size(), &disassembly);
+  EXPECT_THAT(disassembly, Eq("OpName %foo \"foo\"\n%foo = OpTypeVoid\n"));
+}
+
+TEST(Optimizer, CanRunShrinkingPassOnRawBufferInPlace) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary;
+  tools.Assemble("OpName %foo \"foo\"\n%foo = OpTypeVoid", &binary);
+  const size_t orig_size = binary.size();
+
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  opt.RegisterPass(CreateStripDebugInfoPass());
+  size_t num_words = binary.size();
+  // Stripping debug info only shrinks the module, so no overflow storage
+  // is needed.
+  EXPECT_TRUE(opt.Run(binary.data(), &num_words, nullptr));
+  EXPECT_TRUE(num_words > 0 && num_words < orig_size);
+
+  std::string disassembly;
+  tools.Disassemble(binary.data(), num_words, &disassembly);
+  EXPECT_THAT(disassembly, Eq("%void = OpTypeVoid\n"));
+}
+
+TEST(Optimizer, RunValidatedOptimizesValidModule) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary_in;
+  tools.Assemble(
+      "OpCapability Shader\n"
+      "OpCapability Linkage\n"
+      "OpMemoryModel Logical GLSL450\n"
+      "OpName %foo \"foo\"\n"
+      "%foo = OpTypeVoid",
+      &binary_in);
+
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  opt.RegisterPass(CreateStripDebugInfoPass());
+  std::vector<uint32_t> binary_out;
+  EXPECT_TRUE(opt.RunValidated(binary_in.data(), binary_in.size(),
+                               &binary_out));
+
+  // The single decode feeds both validation and optimization, so the result
+  // matches a plain Run() on the same module.
+  std::vector<uint32_t> expected;
+  EXPECT_TRUE(opt.Run(binary_in.data(), binary_in.size(), &expected));
+  EXPECT_THAT(binary_out, Eq(expected));
+}
+
+TEST(Optimizer, RunValidatedRejectsInvalidModule) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary_in;
+  // Assembles, but fails layout validation: no OpMemoryModel.
+  tools.Assemble("OpCapability Shader\n%foo = OpTypeVoid", &binary_in);
+
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  opt.RegisterPass(CreateNullPass());
+  std::vector<uint32_t> binary_out;
+  EXPECT_FALSE(opt.RunValidated(binary_in.data(), binary_in.size(),
+                                &binary_out));
+}
+
 }  // namespace
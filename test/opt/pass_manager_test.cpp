@@ -14,9 +14,12 @@
 
 #include "gmock/gmock.h"
 
+#include <atomic>
 #include <initializer_list>
+#include <string>
 
 #include "module_utils.h"
+#include "opt/build_module.h"
 #include "opt/make_unique.h"
 #include "pass_fixture.h"
 
@@ -180,4 +183,131 @@ TEST(PassManager, RecomputeIdBoundAutomatically) {
   EXPECT_THAT(GetIdBound(module), Eq(201u));
 }
 
+TEST(PassManager, PassStatsCallback) {
+  ir::Module module;
+
+  opt::PassManager manager;
+  manager.AddPass<AppendOpNopPass>();
+  manager.AddPass<opt::NullPass>();
+
+  std::vector<opt::PassManager::PassStats> stats;
+  manager.SetPassStatsCallback(
+      [&stats](const opt::PassManager::PassStats& s) { stats.push_back(s); });
+  manager.Run(&module);
+
+  ASSERT_EQ(2u, stats.size());
+  EXPECT_STREQ("AppendOpNop", stats[0].pass_name);
+  EXPECT_EQ(0u, stats[0].instructions_before);
+  EXPECT_EQ(1u, stats[0].instructions_after);
+  EXPECT_STREQ("null", stats[1].pass_name);
+  EXPECT_EQ(1u, stats[1].instructions_before);
+  EXPECT_EQ(1u, stats[1].instructions_after);
+
+  // Without the callback installed, nothing further is recorded.
+  manager.SetPassStatsCallback(nullptr);
+  manager.Run(&module);
+  EXPECT_EQ(2u, stats.size());
+}
+
+// An instruction-visitor pass that appends its tag to a log for every
+// instruction it is shown; used to observe whether adjacent visitor passes
+// share one walk.
+class LogVisitPass : public opt::InstVisitorPass {
+ public:
+  LogVisitPass(char tag, std::string* log) : tag_(tag), log_(log) {}
+
+  const char* name() const override { return "log-visit"; }
+  bool VisitInst(ir::Instruction*) override {
+    log_->push_back(tag_);
+    return false;
+  }
+
+ private:
+  char tag_;
+  std::string* log_;
+};
+
+TEST(PassManager, FusesAdjacentInstVisitorPasses) {
+  ir::Module module;
+  module.AddDebugInst(MakeUnique<ir::Instruction>());
+  module.AddDebugInst(MakeUnique<ir::Instruction>());
+
+  std::string log;
+  opt::PassManager manager;
+  manager.AddPass(MakeUnique<LogVisitPass>('a', &log));
+  manager.AddPass(MakeUnique<LogVisitPass>('b', &log));
+  manager.Run(&module);
+  // A fused walk shows each instruction to both passes before advancing.
+  EXPECT_EQ("abab", log);
+
+  // With a stats callback installed the passes run (and are measured)
+  // one at a time.
+  log.clear();
+  manager.SetPassStatsCallback([](const opt::PassManager::PassStats&) {});
+  manager.Run(&module);
+  EXPECT_EQ("aabb", log);
+}
+
+// A function pass that counts the functions it processes and tags each
+// function's label count; used to check the parallel driver visits every
+// function exactly once.
+class CountFunctionsPass : public opt::FunctionPass {
+ public:
+  explicit CountFunctionsPass(std::atomic<uint32_t>* num_processed)
+      : num_processed_(num_processed) {}
+
+  const char* name() const override { return "count-functions"; }
+  Status ProcessModuleScope(ir::Module*) override {
+    module_scope_runs_++;
+    return Status::SuccessWithoutChange;
+  }
+  Status ProcessFunction(ir::Function* function) override {
+    uint32_t num_blocks = 0;
+    for (auto& bb : *function) {
+      (void)bb;
+      ++num_blocks;
+    }
+    (*num_processed_)++;
+    return num_blocks > 0 ? Status::SuccessWithChange
+                          : Status::SuccessWithoutChange;
+  }
+  uint32_t module_scope_runs() const { return module_scope_runs_; }
+
+ private:
+  std::atomic<uint32_t>* num_processed_;
+  uint32_t module_scope_runs_ = 0;
+};
+
+TEST(PassManager, RunsFunctionPassOverEveryFunctionInParallel) {
+  std::string text = "OpMemoryModel Logical GLSL450\n";
+  for (int i = 0; i < 8; ++i) {
+    const std::string n = std::to_string(i);
+    text += "%fn" + n + " = OpFunction %void None %fnty" + n + "\n" +
+            "%bb" + n + " = OpLabel\nOpReturn\nOpFunctionEnd\n";
+  }
+  std::unique_ptr<ir::Module> module =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text);
+  ASSERT_NE(nullptr, module);
+
+  std::atomic<uint32_t> num_processed(0);
+  auto pass = MakeUnique<CountFunctionsPass>(&num_processed);
+  CountFunctionsPass* raw_pass = pass.get();
+
+  opt::PassManager manager;
+  manager.SetNumThreads(4);
+  manager.AddPass(std::move(pass));
+  EXPECT_EQ(opt::Pass::Status::SuccessWithChange, manager.Run(module.get()));
+  EXPECT_EQ(8u, num_processed.load());
+  EXPECT_EQ(1u, raw_pass->module_scope_runs());
+
+  // A single thread takes the serial path through FunctionPass::Process.
+  num_processed = 0;
+  opt::PassManager serial_manager;
+  serial_manager.SetNumThreads(1);
+  serial_manager.AddPass(MakeUnique<CountFunctionsPass>(&num_processed));
+  EXPECT_EQ(opt::Pass::Status::SuccessWithChange,
+            serial_manager.Run(module.get()));
+  EXPECT_EQ(8u, num_processed.load());
+}
+
 }  // anonymous namespace
@@ -0,0 +1,135 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "opt/build_module.h"
+#include "opt/pass_manager.h"
+#include "opt/pass_profile.h"
+
+namespace {
+
+using namespace spvtools;
+
+const char kModuleText[] = R"(
+    OpCapability Shader
+    OpMemoryModel Logical GLSL450
+    %uint = OpTypeInt 32 0
+    %one = OpConstant %uint 1)";
+
+// A pass that counts its runs and never changes the module.
+class CountingNullPass : public opt::Pass {
+ public:
+  explicit CountingNullPass(uint32_t* run_count) : run_count_(run_count) {}
+  const char* name() const override { return "counting-null"; }
+  Status Process(ir::Module*) override {
+    ++*run_count_;
+    return Status::SuccessWithoutChange;
+  }
+
+ private:
+  uint32_t* run_count_;
+};
+
+// A pass that counts its runs and always reports a change.
+class CountingChangePass : public opt::Pass {
+ public:
+  explicit CountingChangePass(uint32_t* run_count) : run_count_(run_count) {}
+  const char* name() const override { return "counting-change"; }
+  Status Process(ir::Module*) override {
+    ++*run_count_;
+    return Status::SuccessWithChange;
+  }
+
+ private:
+  uint32_t* run_count_;
+};
+
+TEST(PassProfile, SkipsPassOncePredictedIneffective) {
+  opt::PassProfile profile;
+  profile.set_min_samples(2);
+  uint32_t run_count = 0;
+  opt::PassManager manager;
+  manager.AddPass<CountingNullPass>(&run_count);
+  manager.SetPassProfile(&profile);
+
+  for (int i = 0; i < 5; ++i) {
+    auto module = BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, kModuleText);
+    ASSERT_NE(nullptr, module);
+    EXPECT_EQ(opt::Pass::Status::SuccessWithoutChange,
+              manager.Run(module.get()));
+  }
+  // The first two runs feed the profile; the remaining three are skipped.
+  EXPECT_EQ(2u, run_count);
+}
+
+TEST(PassProfile, EffectivePassKeepsRunning) {
+  opt::PassProfile profile;
+  profile.set_min_samples(2);
+  uint32_t run_count = 0;
+  opt::PassManager manager;
+  manager.AddPass<CountingChangePass>(&run_count);
+  manager.SetPassProfile(&profile);
+
+  for (int i = 0; i < 5; ++i) {
+    auto module = BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, kModuleText);
+    ASSERT_NE(nullptr, module);
+    manager.Run(module.get());
+  }
+  EXPECT_EQ(5u, run_count);
+}
+
+TEST(PassProfile, PredictionNeedsEnoughSamples) {
+  auto module = BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, kModuleText);
+  ASSERT_NE(nullptr, module);
+  const auto cls = opt::PassProfile::ClassifyModule(*module);
+
+  opt::PassProfile profile;
+  profile.set_min_samples(3);
+  profile.RecordRun(cls, "quiet", false, 1.0);
+  profile.RecordRun(cls, "quiet", false, 1.0);
+  EXPECT_FALSE(profile.PredictsNoChange(cls, "quiet"));
+  profile.RecordRun(cls, "quiet", false, 1.0);
+  EXPECT_TRUE(profile.PredictsNoChange(cls, "quiet"));
+  // One observed change anywhere in the class disables the prediction.
+  profile.RecordRun(cls, "quiet", true, 1.0);
+  EXPECT_FALSE(profile.PredictsNoChange(cls, "quiet"));
+}
+
+TEST(PassProfile, SerializeRoundTripCarriesPredictions) {
+  auto module = BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, kModuleText);
+  ASSERT_NE(nullptr, module);
+  const auto cls = opt::PassProfile::ClassifyModule(*module);
+
+  opt::PassProfile warm;
+  warm.set_min_samples(2);
+  warm.RecordRun(cls, "quiet", false, 0.5);
+  warm.RecordRun(cls, "quiet", false, 0.5);
+  warm.RecordRun(cls, "busy", true, 2.0);
+
+  opt::PassProfile fresh;
+  fresh.set_min_samples(2);
+  ASSERT_TRUE(fresh.Deserialize(warm.Serialize()));
+  EXPECT_EQ(warm.NumRecords(), fresh.NumRecords());
+  EXPECT_TRUE(fresh.PredictsNoChange(cls, "quiet"));
+  EXPECT_FALSE(fresh.PredictsNoChange(cls, "busy"));
+}
+
+TEST(PassProfile, DeserializeRejectsMalformedText) {
+  opt::PassProfile profile;
+  EXPECT_FALSE(profile.Deserialize("not a profile"));
+  EXPECT_EQ(0u, profile.NumRecords());
+}
+
+}  // anonymous namespace
@@ -0,0 +1,163 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using PromoteLocalsTest = PassTest<::testing::Test>;
+
+TEST_F(PromoteLocalsTest, PromotesSingleBlockVariable) {
+  const std::string before = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %out_var
+OpName %main "main"
+OpName %out_var "out_var"
+OpName %local "local"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%_ptr_Function_float = OpTypePointer Function %float
+%_ptr_Output_float = OpTypePointer Output %float
+%out_var = OpVariable %_ptr_Output_float Output
+%9 = OpTypeFunction %void
+%main = OpFunction %void None %9
+%10 = OpLabel
+%local = OpVariable %_ptr_Function_float Function
+OpStore %local %float_1
+%11 = OpLoad %float %local
+OpStore %out_var %11
+OpReturn
+OpFunctionEnd
+)";
+  const std::string after = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %out_var
+OpName %main "main"
+OpName %out_var "out_var"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%_ptr_Function_float = OpTypePointer Function %float
+%_ptr_Output_float = OpTypePointer Output %float
+%out_var = OpVariable %_ptr_Output_float Output
+%9 = OpTypeFunction %void
+%main = OpFunction %void None %9
+%10 = OpLabel
+OpStore %out_var %float_1
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::PromoteLocalsPass>(before, after,
+                                                /* skip_nop = */ true);
+}
+
+TEST_F(PromoteLocalsTest, InsertsPhiAtMerge) {
+  const std::string before = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %out_var
+OpName %main "main"
+OpName %out_var "out_var"
+OpName %local "local"
+%void = OpTypeVoid
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%float_2 = OpConstant %float 2
+%_ptr_Function_float = OpTypePointer Function %float
+%_ptr_Output_float = OpTypePointer Output %float
+%out_var = OpVariable %_ptr_Output_float Output
+%12 = OpTypeFunction %void
+%main = OpFunction %void None %12
+%13 = OpLabel
+%local = OpVariable %_ptr_Function_float Function
+OpSelectionMerge %16 None
+OpBranchConditional %true %14 %15
+%14 = OpLabel
+OpStore %local %float_1
+OpBranch %16
+%15 = OpLabel
+OpStore %local %float_2
+OpBranch %16
+%16 = OpLabel
+%17 = OpLoad %float %local
+OpStore %out_var %17
+OpReturn
+OpFunctionEnd
+)";
+  const std::string after = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %out_var
+OpName %main "main"
+OpName %out_var "out_var"
+%void = OpTypeVoid
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%float_2 = OpConstant %float 2
+%_ptr_Function_float = OpTypePointer Function %float
+%_ptr_Output_float = OpTypePointer Output %float
+%out_var = OpVariable %_ptr_Output_float Output
+%12 = OpTypeFunction %void
+%main = OpFunction %void None %12
+%13 = OpLabel
+OpSelectionMerge %16 None
+OpBranchConditional %true %14 %15
+%14 = OpLabel
+OpBranch %16
+%15 = OpLabel
+OpBranch %16
+%16 = OpLabel
+%18 = OpPhi %float %float_1 %14 %float_2 %15
+OpStore %out_var %18
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::PromoteLocalsPass>(before, after,
+                                                /* skip_nop = */ true);
+}
+
+TEST_F(PromoteLocalsTest, LeavesAccessChainUsersAlone) {
+  const std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+OpName %main "main"
+OpName %local "local"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%v2float = OpTypeVector %float 2
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%float_1 = OpConstant %float 1
+%_ptr_Function_v2float = OpTypePointer Function %v2float
+%_ptr_Function_float = OpTypePointer Function %float
+%11 = OpTypeFunction %void
+%main = OpFunction %void None %11
+%12 = OpLabel
+%local = OpVariable %_ptr_Function_v2float Function
+%13 = OpAccessChain %_ptr_Function_float %local %uint_0
+OpStore %13 %float_1
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::PromoteLocalsPass>(text, text,
+                                                /* skip_nop = */ true);
+}
+
+}  // anonymous namespace
@@ -0,0 +1,154 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "opt/shard.h"
+#include "spirv-tools/libspirv.hpp"
+
+namespace {
+
+using namespace spvtools;
+
+// Returns the number of occurrences of |substring| in |text|.
+size_t Count(const std::string& text, const std::string& substring) {
+  size_t count = 0;
+  for (size_t pos = text.find(substring); pos != std::string::npos;
+       pos = text.find(substring, pos + substring.size())) {
+    ++count;
+  }
+  return count;
+}
+
+// Assembles |text| and shards the result, returning the disassembly of each
+// shard through |shard_texts|.  Returns false if any step fails.
+bool AssembleAndShard(const std::string& text, size_t max_shards,
+                      uint32_t fresh_ids_per_shard,
+                      std::vector<std::string>* shard_texts) {
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  std::vector<uint32_t> binary;
+  if (!t.Assemble(text, &binary)) return false;
+  std::vector<std::vector<uint32_t>> shards;
+  if (!ShardModule(binary, max_shards, fresh_ids_per_shard, &shards, nullptr))
+    return false;
+  for (const std::vector<uint32_t>& shard : shards) {
+    shard_texts->push_back("");
+    if (!t.Disassemble(shard, &shard_texts->back())) return false;
+  }
+  return true;
+}
+
+// Two entry points whose call trees are disjoint: %main_a calls %helper,
+// %main_b stands alone.
+const char kTwoClusterModule[] = R"(
+    OpCapability Shader
+    OpMemoryModel Logical GLSL450
+    OpEntryPoint GLCompute %main_a "main_a"
+    OpEntryPoint GLCompute %main_b "main_b"
+    OpExecutionMode %main_a LocalSize 1 1 1
+    OpExecutionMode %main_b LocalSize 2 2 2
+    %void = OpTypeVoid
+    %fnty = OpTypeFunction %void
+    %main_a = OpFunction %void None %fnty
+    %entry_a = OpLabel
+    %call = OpFunctionCall %void %helper
+    OpReturn
+    OpFunctionEnd
+    %helper = OpFunction %void None %fnty
+    %entry_h = OpLabel
+    OpReturn
+    OpFunctionEnd
+    %main_b = OpFunction %void None %fnty
+    %entry_b = OpLabel
+    OpReturn
+    OpFunctionEnd)";
+
+TEST(Shard, SplitsDisjointCallClustersAcrossShards) {
+  std::vector<std::string> shards;
+  ASSERT_TRUE(AssembleAndShard(kTwoClusterModule, 2, 1000, &shards));
+  ASSERT_EQ(2u, shards.size());
+  for (const std::string& shard : shards) {
+    // Every shard carries the whole global section...
+    EXPECT_EQ(1u, Count(shard, "OpCapability Shader"));
+    EXPECT_EQ(1u, Count(shard, "OpMemoryModel"));
+    EXPECT_EQ(1u, Count(shard, "OpTypeFunction"));
+    // ...but only the entry point and execution mode of its own functions.
+    EXPECT_EQ(1u, Count(shard, "OpEntryPoint"));
+    EXPECT_EQ(1u, Count(shard, "OpExecutionMode"));
+  }
+  // The caller and its callee stay together, apart from the other cluster.
+  const size_t two_function_shard =
+      Count(shards[0], "OpFunctionCall") == 1 ? 0 : 1;
+  EXPECT_EQ(2u, Count(shards[two_function_shard], "OpFunction "));
+  EXPECT_EQ(1u, Count(shards[1 - two_function_shard], "OpFunction "));
+  EXPECT_EQ(0u, Count(shards[1 - two_function_shard], "OpFunctionCall"));
+}
+
+TEST(Shard, ShardCountIsCappedByClusterCount) {
+  std::vector<std::string> shards;
+  ASSERT_TRUE(AssembleAndShard(kTwoClusterModule, 8, 1000, &shards));
+  EXPECT_EQ(2u, shards.size());
+}
+
+TEST(Shard, ShardBoundsReserveDisjointIdRanges) {
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  std::vector<uint32_t> binary;
+  ASSERT_TRUE(t.Assemble(kTwoClusterModule, &binary));
+  std::vector<std::vector<uint32_t>> shards;
+  ASSERT_TRUE(ShardModule(binary, 2, 1000, &shards, nullptr));
+  ASSERT_EQ(2u, shards.size());
+  EXPECT_EQ(binary[3], shards[0][3]);
+  EXPECT_EQ(binary[3] + 1000u, shards[1][3]);
+}
+
+TEST(Shard, MergeRoundTripKeepsOneCopyOfEverything) {
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  std::vector<uint32_t> binary;
+  ASSERT_TRUE(t.Assemble(kTwoClusterModule, &binary));
+  std::vector<std::vector<uint32_t>> shards;
+  ASSERT_TRUE(ShardModule(binary, 2, 1000, &shards, nullptr));
+  std::vector<uint32_t> merged;
+  ASSERT_TRUE(MergeShards(shards, &merged, nullptr));
+
+  std::string text;
+  ASSERT_TRUE(t.Disassemble(merged, &text));
+  // The global section shared by both shards collapses back to one copy.
+  EXPECT_EQ(1u, Count(text, "OpCapability Shader"));
+  EXPECT_EQ(1u, Count(text, "OpMemoryModel"));
+  EXPECT_EQ(1u, Count(text, "OpTypeVoid"));
+  EXPECT_EQ(1u, Count(text, "OpTypeFunction"));
+  // Both entry points and all three functions come back.
+  EXPECT_EQ(2u, Count(text, "OpEntryPoint"));
+  EXPECT_EQ(2u, Count(text, "OpExecutionMode"));
+  EXPECT_EQ(3u, Count(text, "OpFunction "));
+  // The merged bound covers the largest reserved range.
+  EXPECT_EQ(binary[3] + 1000u, merged[3]);
+}
+
+TEST(Shard, RejectsInvalidBinary) {
+  std::vector<uint32_t> not_spirv(10, 0xdeadbeef);
+  std::vector<std::vector<uint32_t>> shards;
+  EXPECT_FALSE(ShardModule(not_spirv, 2, 1000, &shards, nullptr));
+  EXPECT_TRUE(shards.empty());
+}
+
+TEST(Shard, RejectsZeroShards) {
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  std::vector<uint32_t> binary;
+  ASSERT_TRUE(t.Assemble(kTwoClusterModule, &binary));
+  std::vector<std::vector<uint32_t>> shards;
+  EXPECT_FALSE(ShardModule(binary, 0, 1000, &shards, nullptr));
+}
+
+}  // anonymous namespace
@@ -0,0 +1,212 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using SimplifyTest = PassTest<::testing::Test>;
+
+TEST_F(SimplifyTest, FoldsArithmeticIdentities) {
+  // x + 0 and then (x + 0) * 1 both collapse to the loaded value.
+  const std::string before = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %in_var %out_var
+OpName %main "main"
+OpName %in_var "in_var"
+OpName %out_var "out_var"
+%void = OpTypeVoid
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in_var = OpVariable %_ptr_Input_int Input
+%out_var = OpVariable %_ptr_Output_int Output
+%10 = OpTypeFunction %void
+%main = OpFunction %void None %10
+%11 = OpLabel
+%12 = OpLoad %int %in_var
+%13 = OpIAdd %int %12 %int_0
+%14 = OpIMul %int %13 %int_1
+OpStore %out_var %14
+OpReturn
+OpFunctionEnd
+)";
+  const std::string after = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %in_var %out_var
+OpName %main "main"
+OpName %in_var "in_var"
+OpName %out_var "out_var"
+%void = OpTypeVoid
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in_var = OpVariable %_ptr_Input_int Input
+%out_var = OpVariable %_ptr_Output_int Output
+%10 = OpTypeFunction %void
+%main = OpFunction %void None %10
+%11 = OpLabel
+%12 = OpLoad %int %in_var
+OpStore %out_var %12
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::SimplifyPass>(before, after,
+                                           /* skip_nop = */ true);
+}
+
+TEST_F(SimplifyTest, CollapsesBitcastChain) {
+  // float -> uint -> float returns to the original value; the intermediate
+  // bitcast goes dead and is left for dead code elimination.
+  const std::string before = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %in_var %out_var
+OpName %main "main"
+OpName %in_var "in_var"
+OpName %out_var "out_var"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%uint = OpTypeInt 32 0
+%_ptr_Input_float = OpTypePointer Input %float
+%_ptr_Output_float = OpTypePointer Output %float
+%in_var = OpVariable %_ptr_Input_float Input
+%out_var = OpVariable %_ptr_Output_float Output
+%10 = OpTypeFunction %void
+%main = OpFunction %void None %10
+%11 = OpLabel
+%12 = OpLoad %float %in_var
+%13 = OpBitcast %uint %12
+%14 = OpBitcast %float %13
+OpStore %out_var %14
+OpReturn
+OpFunctionEnd
+)";
+  const std::string after = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %in_var %out_var
+OpName %main "main"
+OpName %in_var "in_var"
+OpName %out_var "out_var"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%uint = OpTypeInt 32 0
+%_ptr_Input_float = OpTypePointer Input %float
+%_ptr_Output_float = OpTypePointer Output %float
+%in_var = OpVariable %_ptr_Input_float Input
+%out_var = OpVariable %_ptr_Output_float Output
+%10 = OpTypeFunction %void
+%main = OpFunction %void None %10
+%11 = OpLabel
+%12 = OpLoad %float %in_var
+%13 = OpBitcast %uint %12
+OpStore %out_var %12
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::SimplifyPass>(before, after,
+                                           /* skip_nop = */ true);
+}
+
+TEST_F(SimplifyTest, FoldsCompositeRoundTrip) {
+  // Reassembling every component of a vector in order is the vector itself.
+  const std::string before = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %in_var %out_var
+OpName %main "main"
+OpName %in_var "in_var"
+OpName %out_var "out_var"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%v2float = OpTypeVector %float 2
+%_ptr_Input_v2float = OpTypePointer Input %v2float
+%_ptr_Output_v2float = OpTypePointer Output %v2float
+%in_var = OpVariable %_ptr_Input_v2float Input
+%out_var = OpVariable %_ptr_Output_v2float Output
+%11 = OpTypeFunction %void
+%main = OpFunction %void None %11
+%12 = OpLabel
+%13 = OpLoad %v2float %in_var
+%14 = OpCompositeExtract %float %13 0
+%15 = OpCompositeExtract %float %13 1
+%16 = OpCompositeConstruct %v2float %14 %15
+OpStore %out_var %16
+OpReturn
+OpFunctionEnd
+)";
+  const std::string after = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %in_var %out_var
+OpName %main "main"
+OpName %in_var "in_var"
+OpName %out_var "out_var"
+%void = OpTypeVoid
+%float = OpTypeFloat 32
+%v2float = OpTypeVector %float 2
+%_ptr_Input_v2float = OpTypePointer Input %v2float
+%_ptr_Output_v2float = OpTypePointer Output %v2float
+%in_var = OpVariable %_ptr_Input_v2float Input
+%out_var = OpVariable %_ptr_Output_v2float Output
+%11 = OpTypeFunction %void
+%main = OpFunction %void None %11
+%12 = OpLabel
+%13 = OpLoad %v2float %in_var
+%14 = OpCompositeExtract %float %13 0
+%15 = OpCompositeExtract %float %13 1
+OpStore %out_var %13
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::SimplifyPass>(before, after,
+                                           /* skip_nop = */ true);
+}
+
+TEST_F(SimplifyTest, KeepsAddWhenOperandSignednessDiffers) {
+  // OpIAdd allows operands whose signedness differs from the result type;
+  // forwarding the signed operand for the unsigned result would change the
+  // type of its uses, so the add must stay.
+  const std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main" %in_var %out_var
+OpName %main "main"
+OpName %in_var "in_var"
+OpName %out_var "out_var"
+%void = OpTypeVoid
+%int = OpTypeInt 32 1
+%uint = OpTypeInt 32 0
+%uint_0 = OpConstant %uint 0
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_uint = OpTypePointer Output %uint
+%in_var = OpVariable %_ptr_Input_int Input
+%out_var = OpVariable %_ptr_Output_uint Output
+%10 = OpTypeFunction %void
+%main = OpFunction %void None %10
+%11 = OpLabel
+%12 = OpLoad %int %in_var
+%13 = OpIAdd %uint %12 %uint_0
+OpStore %out_var %13
+OpReturn
+OpFunctionEnd
+)";
+  SinglePassRunAndCheck<opt::SimplifyPass>(text, text,
+                                           /* skip_nop = */ true);
+}
+
+}  // anonymous namespace
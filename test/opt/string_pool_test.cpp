@@ -0,0 +1,85 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "opt/build_module.h"
+#include "opt/string_pool.h"
+#include "spirv-tools/libspirv.hpp"
+
+namespace {
+
+using namespace spvtools;
+
+TEST(StringPool, InternDeduplicates) {
+  ir::StringPool pool;
+  const uint32_t hello[] = {0x6c6c6568, 0x0000006f};  // "hello"
+  const uint32_t world[] = {0x6c726f77, 0x00000064};  // "world"
+
+  const uint32_t hello_id = pool.Intern(hello, 2);
+  const uint32_t world_id = pool.Intern(world, 2);
+  EXPECT_NE(hello_id, world_id);
+  EXPECT_EQ(2u, pool.size());
+
+  // Interning the same words again yields the same id and adds nothing.
+  EXPECT_EQ(hello_id, pool.Intern(hello, 2));
+  EXPECT_EQ(world_id, pool.Intern(world, 2));
+  EXPECT_EQ(2u, pool.size());
+
+  // The canonical copies round-trip.
+  EXPECT_EQ(std::vector<uint32_t>(hello, hello + 2), pool.words(hello_id));
+  EXPECT_EQ(std::vector<uint32_t>(world, world + 2), pool.words(world_id));
+}
+
+TEST(StringPool, ModuleInternsDebugStringsOnLoad) {
+  const std::string text =
+      // clang-format off
+               "OpCapability Shader\n"
+               "OpMemoryModel Logical GLSL450\n"
+               "OpEntryPoint Vertex %main \"main\"\n"
+               "OpName %main \"main\"\n"
+               "OpName %param \"param\"\n"
+               "OpName %param_0 \"param\"\n"
+       "%void = OpTypeVoid\n"
+          "%5 = OpTypeFunction %void\n"
+      "%float = OpTypeFloat 32\n"
+ "%_ptr_Function_float = OpTypePointer Function %float\n"
+       "%main = OpFunction %void None %5\n"
+          "%8 = OpLabel\n"
+      "%param = OpVariable %_ptr_Function_float Function\n"
+    "%param_0 = OpVariable %_ptr_Function_float Function\n"
+               "OpReturn\n"
+               "OpFunctionEnd\n";
+  // clang-format on
+  std::unique_ptr<ir::Module> module =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text);
+  ASSERT_NE(nullptr, module);
+
+  // The loader interned every debug instruction, and the two repeated
+  // "param" strings share one pool entry with "main" as the other.
+  for (const auto& inst : module->debugs()) {
+    EXPECT_TRUE(inst.HasInternedStrings());
+  }
+  EXPECT_EQ(2u, module->debug_strings().size());
+
+  // Serialization re-expands the strings, so the module round-trips.
+  std::vector<uint32_t> binary;
+  module->ToBinary(&binary, /* skip_nop = */ false);
+  std::string disassembled_text;
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  EXPECT_TRUE(t.Disassemble(binary, &disassembled_text));
+  EXPECT_EQ(text, disassembled_text);
+}
+
+}  // anonymous namespace
@@ -274,4 +274,37 @@ TEST(TypeManager, BeginEnd) {
   }
 }
 
+TEST(TypeManager, CanonicalTypes) {
+  const std::string text = R"(
+    OpDecorate %struct3 Block         ; %struct3 gets id 1
+
+    %u32 = OpTypeInt 32 0             ; id: 2
+    %f32 = OpTypeFloat 32             ; id: 3
+    %struct1 = OpTypeStruct %u32 %f32 ; id: 4, base
+    %struct2 = OpTypeStruct %u32 %f32 ; id: 5, structurally identical
+    %struct3 = OpTypeStruct %u32 %f32 ; same members, decorated
+    %ptr1 = OpTypePointer Uniform %struct1 ; id: 6
+    %ptr2 = OpTypePointer Uniform %struct2 ; id: 7
+  )";
+  std::unique_ptr<ir::Module> module =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text);
+  opt::analysis::TypeManager manager(nullptr, *module);
+
+  ASSERT_EQ(7u, manager.NumTypes());
+
+  // Structurally identical types share one canonical representative.
+  EXPECT_EQ(manager.GetCanonicalType(manager.GetType(4)),
+            manager.GetCanonicalType(manager.GetType(5)));
+  EXPECT_TRUE(manager.AreSameType(manager.GetType(4), manager.GetType(5)));
+  // Pointers to equivalent pointees are equivalent too.
+  EXPECT_TRUE(manager.AreSameType(manager.GetType(6), manager.GetType(7)));
+  // A decoration makes the type distinct.
+  EXPECT_FALSE(manager.AreSameType(manager.GetType(4), manager.GetType(1)));
+  // Unrelated types stay distinct.
+  EXPECT_FALSE(manager.AreSameType(manager.GetType(2), manager.GetType(3)));
+  // A type not managed by this manager has no canonical representative.
+  opt::analysis::Bool unmanaged;
+  EXPECT_EQ(nullptr, manager.GetCanonicalType(&unmanaged));
+}
+
 }  // anonymous namespace
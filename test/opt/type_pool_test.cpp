@@ -0,0 +1,122 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "opt/build_module.h"
+#include "opt/type_manager.h"
+#include "opt/type_pool.h"
+
+namespace {
+
+using namespace spvtools;
+
+TEST(TypePool, SharedAcrossModules) {
+  const std::string text1 = R"(
+    %u32   = OpTypeInt 32 0      ; id 1
+    %f32   = OpTypeFloat 32      ; id 2
+    %v4f32 = OpTypeVector %f32 4 ; id 3
+    %st    = OpTypeStruct %u32 %v4f32 ; id 4
+  )";
+  const std::string text2 = R"(
+    %f32   = OpTypeFloat 32      ; id 1
+    %v4f32 = OpTypeVector %f32 4 ; id 2
+    %u32   = OpTypeInt 32 0      ; id 3
+    %st    = OpTypeStruct %u32 %v4f32 ; id 4
+    %f64   = OpTypeFloat 64      ; id 5
+  )";
+  std::unique_ptr<ir::Module> module1 =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text1);
+  std::unique_ptr<ir::Module> module2 =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text2);
+
+  opt::analysis::TypePool pool;
+  opt::analysis::TypeManager manager1(nullptr, *module1, &pool);
+  opt::analysis::TypeManager manager2(nullptr, *module2, &pool);
+
+  EXPECT_TRUE(manager1.AllTypesPooled());
+  EXPECT_TRUE(manager2.AllTypesPooled());
+  // The five distinct types are pooled once each.
+  EXPECT_EQ(5u, pool.NumTypes());
+
+  // Structurally identical types resolve to the same pointer in both
+  // modules, different definition orders notwithstanding.
+  EXPECT_EQ(manager1.GetType(1), manager2.GetType(3));
+  EXPECT_EQ(manager1.GetType(2), manager2.GetType(1));
+  EXPECT_EQ(manager1.GetType(3), manager2.GetType(2));
+  EXPECT_EQ(manager1.GetType(4), manager2.GetType(4));
+  EXPECT_NE(manager1.GetType(1), manager1.GetType(2));
+
+  // Ids still resolve per module.
+  EXPECT_EQ(1u, manager1.GetId(manager1.GetType(1)));
+  EXPECT_EQ(3u, manager2.GetId(manager2.GetType(3)));
+  EXPECT_EQ(5u, manager2.GetId(manager2.GetType(5)));
+}
+
+TEST(TypePool, DecorationsKeepTypesDistinct) {
+  const std::string text = R"(
+    OpDecorate %block Block           ; %block gets id 1
+    OpMemberDecorate %block 0 Offset 0
+
+    %u32   = OpTypeInt 32 0    ; id 2
+    %plain = OpTypeStruct %u32 ; id 3
+    %block = OpTypeStruct %u32
+  )";
+  std::unique_ptr<ir::Module> module =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text);
+
+  opt::analysis::TypePool pool;
+  opt::analysis::TypeManager manager(nullptr, *module, &pool);
+
+  ASSERT_TRUE(manager.AllTypesPooled());
+  EXPECT_EQ(3u, pool.NumTypes());
+  EXPECT_NE(manager.GetType(1), manager.GetType(3));
+
+  // The pooled copy carries both the type and the member decorations.
+  EXPECT_FALSE(manager.GetType(1)->decoration_empty());
+  EXPECT_EQ(1u, manager.GetType(1)->AsStruct()->element_decorations().size());
+  EXPECT_TRUE(manager.GetType(3)->decoration_empty());
+}
+
+TEST(TypePool, PooledTypesOutliveTheModule) {
+  opt::analysis::TypePool pool;
+  const opt::analysis::Type* vector = nullptr;
+  {
+    const std::string text = R"(
+      %f32   = OpTypeFloat 32
+      %v3f32 = OpTypeVector %f32 3
+    )";
+    std::unique_ptr<ir::Module> module =
+        BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text);
+    opt::analysis::TypeManager manager(nullptr, *module, &pool);
+    ASSERT_TRUE(manager.AllTypesPooled());
+    vector = manager.GetType(2);
+  }
+  // The pooled copy is self-contained: it references the pooled scalar, not
+  // a type owned by the destroyed manager.
+  ASSERT_NE(nullptr, vector);
+  EXPECT_EQ("<float32, 3>", vector->str());
+  const opt::analysis::Type* element = vector->AsVector()->element_type();
+  {
+    std::unique_ptr<ir::Module> module =
+        BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, "%f32 = OpTypeFloat 32");
+    opt::analysis::TypeManager manager(nullptr, *module, &pool);
+    EXPECT_EQ(element, manager.GetType(1));
+  }
+}
+
+}  // anonymous namespace
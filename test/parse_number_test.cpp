@@ -23,6 +23,7 @@ namespace {
 using spvutils::NumberType;
 using spvutils::EncodeNumberStatus;
 using spvutils::ParseNumber;
+using spvutils::ParseNumberFast;
 using spvutils::ParseAndEncodeIntegerNumber;
 using spvutils::ParseAndEncodeFloatingPointNumber;
 using spvutils::ParseAndEncodeNumber;
@@ -134,6 +135,70 @@ TEST(ParseUnsignedIntegers, Sample) {
   EXPECT_FALSE(ParseNumber("-1", &u32));
 }
 
+TEST(ParseNumberFast, Integers) {
+  uint64_t u64;
+  int64_t i64;
+  uint32_t u32;
+  int32_t i32;
+
+  // Invalid parse.
+  EXPECT_FALSE(ParseNumberFast(nullptr, &u64));
+  EXPECT_FALSE(ParseNumberFast("", &u64));
+  EXPECT_FALSE(ParseNumberFast("0=", &u64));
+  EXPECT_FALSE(ParseNumberFast("0x", &u64));
+  EXPECT_FALSE(ParseNumberFast("-1", &u64));
+
+  // Decimal values, including the 64-bit extremes.
+  EXPECT_TRUE(ParseNumberFast("0", &u64));
+  EXPECT_EQ(0u, u64);
+  EXPECT_TRUE(ParseNumberFast("18446744073709551615", &u64));
+  EXPECT_EQ(std::numeric_limits<uint64_t>::max(), u64);
+  EXPECT_FALSE(ParseNumberFast("18446744073709551616", &u64));
+  EXPECT_TRUE(ParseNumberFast("-9223372036854775808", &i64));
+  EXPECT_EQ(std::numeric_limits<int64_t>::min(), i64);
+  EXPECT_FALSE(ParseNumberFast("-9223372036854775809", &i64));
+  EXPECT_TRUE(ParseNumberFast("9223372036854775807", &i64));
+  EXPECT_EQ(std::numeric_limits<int64_t>::max(), i64);
+  EXPECT_FALSE(ParseNumberFast("9223372036854775808", &i64));
+
+  // Hex values.
+  EXPECT_TRUE(ParseNumberFast("0xffffffffffffffff", &u64));
+  EXPECT_EQ(std::numeric_limits<uint64_t>::max(), u64);
+  EXPECT_FALSE(ParseNumberFast("0x10000000000000000", &u64));
+  EXPECT_TRUE(ParseNumberFast("-0x001", &i64));
+  EXPECT_EQ(-1, i64);
+
+  // Narrow overloads apply their own range checks.
+  EXPECT_TRUE(ParseNumberFast("4294967295", &u32));
+  EXPECT_EQ(std::numeric_limits<uint32_t>::max(), u32);
+  EXPECT_FALSE(ParseNumberFast("4294967296", &u32));
+  EXPECT_TRUE(ParseNumberFast("-2147483648", &i32));
+  EXPECT_EQ(std::numeric_limits<int32_t>::min(), i32);
+  EXPECT_FALSE(ParseNumberFast("-2147483649", &i32));
+}
+
+TEST(ParseNumberFast, Floats) {
+  float f;
+  double d;
+
+  EXPECT_TRUE(ParseNumberFast("1.5", &f));
+  EXPECT_EQ(1.5f, f);
+  EXPECT_TRUE(ParseNumberFast("-2.5e2", &f));
+  EXPECT_EQ(-250.0f, f);
+  EXPECT_TRUE(ParseNumberFast("1e40", &d));
+  EXPECT_EQ(1e40, d);
+
+  // Overflow to infinity is a failure, like the stream-based conversion.
+  EXPECT_FALSE(ParseNumberFast("1e40", &f));
+
+  // Forms the fast scanner does not handle: hex floats and keyword values
+  // stay with ParseNumber's stream-based conversion.
+  EXPECT_FALSE(ParseNumberFast("0x1.8p1", &f));
+  EXPECT_FALSE(ParseNumberFast("NaN", &f));
+  EXPECT_FALSE(ParseNumberFast("1e", &f));
+  EXPECT_FALSE(ParseNumberFast(".", &f));
+}
+
 TEST(ParseWideSignedIntegers, Sample) {
   int64_t i64;
   EXPECT_FALSE(ParseNumber(nullptr, &i64));
@@ -0,0 +1,216 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for the compressed SPIR-V module codec.
+
+#include <string>
+#include <vector>
+
+#include "source/spirv_compression.h"
+#include "test_fixture.h"
+#include "unit_spirv.h"
+
+namespace {
+
+using libspirv::SpirvCompress;
+using libspirv::SpirvDecompress;
+using spvtest::ScopedContext;
+
+// Assembles |code| and returns the SPIR-V binary words.
+std::vector<uint32_t> Compile(const std::string& code,
+                              spv_target_env env = SPV_ENV_UNIVERSAL_1_1) {
+  ScopedContext ctx(env);
+  spv_binary binary;
+  EXPECT_EQ(SPV_SUCCESS, spvTextToBinary(ctx.context, code.c_str(),
+                                         code.size(), &binary, nullptr));
+  std::vector<uint32_t> words(binary->code, binary->code + binary->wordCount);
+  spvBinaryDestroy(binary);
+  return words;
+}
+
+// Compresses |original|, decompresses the result, and expects the round trip
+// to reproduce |original| bit for bit.
+void ExpectRoundTrip(const std::vector<uint32_t>& original,
+                     spv_target_env env = SPV_ENV_UNIVERSAL_1_1) {
+  ScopedContext ctx(env);
+
+  std::vector<uint8_t> compressed;
+  ASSERT_EQ(SPV_SUCCESS, SpirvCompress(*ctx.context, original.data(),
+                                       original.size(), &compressed, nullptr));
+
+  std::vector<uint32_t> decompressed;
+  ASSERT_EQ(SPV_SUCCESS,
+            SpirvDecompress(*ctx.context, compressed.data(), compressed.size(),
+                            &decompressed, nullptr));
+  EXPECT_EQ(original, decompressed);
+}
+
+const char kShader[] = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpName %f32 "f32"
+%void = OpTypeVoid
+%voidfn = OpTypeFunction %void
+%f32 = OpTypeFloat 32
+%u32 = OpTypeInt 32 0
+%f32_1 = OpConstant %f32 1
+%u32_2 = OpConstant %u32 2
+%fn = OpFunction %void None %voidfn
+%entry = OpLabel
+%sum = OpFAdd %f32 %f32_1 %f32_1
+OpReturn
+OpFunctionEnd
+)";
+
+TEST(SpirvCompression, RoundTripShader) {
+  ExpectRoundTrip(Compile(kShader));
+}
+
+TEST(SpirvCompression, RoundTripSmallestModule) {
+  ExpectRoundTrip(Compile(R"(
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+)"));
+}
+
+TEST(SpirvCompression, RoundTripOpenCL) {
+  ExpectRoundTrip(Compile(R"(
+OpCapability Addresses
+OpCapability Kernel
+OpCapability GenericPointer
+OpCapability Linkage
+OpMemoryModel Physical32 OpenCL
+%void = OpTypeVoid
+%voidfn = OpTypeFunction %void
+%fn = OpFunction %void None %voidfn
+%entry = OpLabel
+OpReturn
+OpFunctionEnd
+)"));
+}
+
+TEST(SpirvCompression, CompressedIsSmallerThanBinary) {
+  const std::vector<uint32_t> original = Compile(kShader);
+  ScopedContext ctx(SPV_ENV_UNIVERSAL_1_1);
+
+  std::vector<uint8_t> compressed;
+  ASSERT_EQ(SPV_SUCCESS, SpirvCompress(*ctx.context, original.data(),
+                                       original.size(), &compressed, nullptr));
+  EXPECT_LT(compressed.size(), original.size() * sizeof(uint32_t));
+}
+
+TEST(SpirvCompression, RejectsBadMagic) {
+  const std::vector<uint32_t> original = Compile(kShader);
+  ScopedContext ctx(SPV_ENV_UNIVERSAL_1_1);
+
+  std::vector<uint8_t> compressed;
+  ASSERT_EQ(SPV_SUCCESS, SpirvCompress(*ctx.context, original.data(),
+                                       original.size(), &compressed, nullptr));
+  compressed[0] ^= 0xff;
+
+  std::vector<uint32_t> decompressed;
+  spv_diagnostic diagnostic = nullptr;
+  EXPECT_EQ(SPV_ERROR_INVALID_BINARY,
+            SpirvDecompress(*ctx.context, compressed.data(), compressed.size(),
+                            &decompressed, &diagnostic));
+  ASSERT_NE(nullptr, diagnostic);
+  spvDiagnosticDestroy(diagnostic);
+}
+
+TEST(SpirvCompression, RejectsTruncatedStream) {
+  const std::vector<uint32_t> original = Compile(kShader);
+  ScopedContext ctx(SPV_ENV_UNIVERSAL_1_1);
+
+  std::vector<uint8_t> compressed;
+  ASSERT_EQ(SPV_SUCCESS, SpirvCompress(*ctx.context, original.data(),
+                                       original.size(), &compressed, nullptr));
+  compressed.resize(compressed.size() / 2);
+
+  std::vector<uint32_t> decompressed;
+  spv_diagnostic diagnostic = nullptr;
+  EXPECT_EQ(SPV_ERROR_INVALID_BINARY,
+            SpirvDecompress(*ctx.context, compressed.data(), compressed.size(),
+                            &decompressed, &diagnostic));
+  ASSERT_NE(nullptr, diagnostic);
+  spvDiagnosticDestroy(diagnostic);
+}
+
+// Returns a module with enough instructions to span several framing chunks.
+std::vector<uint32_t> CompileManyInstructions() {
+  std::string text = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%u32 = OpTypeInt 32 0
+)";
+  for (int i = 0; i < 5000; ++i) {
+    text += "%c" + std::to_string(i) + " = OpConstant %u32 " +
+            std::to_string(i) + "\n";
+  }
+  return Compile(text);
+}
+
+// Like ExpectRoundTrip, but with explicit thread counts on both sides.
+void ExpectRoundTripThreaded(const std::vector<uint32_t>& original,
+                             size_t encode_threads, size_t decode_threads) {
+  ScopedContext ctx(SPV_ENV_UNIVERSAL_1_1);
+
+  std::vector<uint8_t> compressed;
+  ASSERT_EQ(SPV_SUCCESS,
+            SpirvCompress(*ctx.context, original.data(), original.size(),
+                          &compressed, nullptr, encode_threads));
+
+  std::vector<uint32_t> decompressed;
+  ASSERT_EQ(SPV_SUCCESS,
+            SpirvDecompress(*ctx.context, compressed.data(), compressed.size(),
+                            &decompressed, nullptr, decode_threads));
+  EXPECT_EQ(original, decompressed);
+}
+
+TEST(SpirvCompression, RoundTripChunkedSingleThreaded) {
+  ExpectRoundTripThreaded(CompileManyInstructions(), 1, 1);
+}
+
+TEST(SpirvCompression, RoundTripChunkedParallel) {
+  const std::vector<uint32_t> original = CompileManyInstructions();
+  // The framing is thread-count agnostic: a stream written on any number of
+  // threads decompresses on any other.
+  ExpectRoundTripThreaded(original, 4, 4);
+  ExpectRoundTripThreaded(original, 4, 1);
+  ExpectRoundTripThreaded(original, 1, 4);
+}
+
+TEST(SpirvCompression, ParallelAndSerialStreamsAreIdentical) {
+  const std::vector<uint32_t> original = CompileManyInstructions();
+  ScopedContext ctx(SPV_ENV_UNIVERSAL_1_1);
+
+  std::vector<uint8_t> serial;
+  ASSERT_EQ(SPV_SUCCESS, SpirvCompress(*ctx.context, original.data(),
+                                       original.size(), &serial, nullptr, 1));
+  std::vector<uint8_t> parallel;
+  ASSERT_EQ(SPV_SUCCESS,
+            SpirvCompress(*ctx.context, original.data(), original.size(),
+                          &parallel, nullptr, 4));
+  EXPECT_EQ(serial, parallel);
+}
+
+TEST(SpirvCompression, RejectsEmptyInput) {
+  ScopedContext ctx(SPV_ENV_UNIVERSAL_1_1);
+  std::vector<uint32_t> decompressed;
+  EXPECT_EQ(SPV_ERROR_INVALID_BINARY,
+            SpirvDecompress(*ctx.context, nullptr, 0, &decompressed, nullptr));
+}
+
+}  // namespace
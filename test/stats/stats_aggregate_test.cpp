@@ -14,6 +14,7 @@
 
 // Tests for unique type declaration rules validator.
 
+#include <set>
 #include <string>
 
 #include "source/spirv_stats.h"
@@ -47,9 +48,40 @@ void DiagnosticsMessageHandler(spv_message_level_t level, const char*,
   }
 }
 
+// Returns the Markov count collected for the (gap, cue, later) triple.
+uint32_t MarkovCount(const SpirvStats& stats, uint32_t gap, uint32_t cue,
+                     uint32_t later) {
+  const auto it =
+      stats.opcode_markov_hist.find(libspirv::MakeMarkovKey(gap, cue, later));
+  return it == stats.opcode_markov_hist.end() ? 0 : it->second;
+}
+
+// Returns the number of distinct cue opcodes collected at the given gap.
+size_t MarkovStepSize(const SpirvStats& stats, uint32_t gap) {
+  std::set<uint32_t> cues;
+  for (const auto& pair : stats.opcode_markov_hist) {
+    if (libspirv::MarkovKeyGap(pair.first) == gap)
+      cues.insert(libspirv::MarkovKeyCue(pair.first));
+  }
+  return cues.size();
+}
+
+// Returns the number of distinct later opcodes collected for (gap, cue).
+size_t MarkovCueSize(const SpirvStats& stats, uint32_t gap, uint32_t cue) {
+  size_t count = 0;
+  for (const auto& pair : stats.opcode_markov_hist) {
+    if (libspirv::MarkovKeyGap(pair.first) == gap &&
+        libspirv::MarkovKeyCue(pair.first) == cue)
+      ++count;
+  }
+  return count;
+}
+
 // Calls libspirv::AggregateStats for binary compiled from |code|.
-void CompileAndAggregateStats(const std::string& code, SpirvStats* stats,
-                    spv_target_env env = SPV_ENV_UNIVERSAL_1_1) {
+void CompileAndAggregateStats(
+    const std::string& code, SpirvStats* stats,
+    spv_target_env env = SPV_ENV_UNIVERSAL_1_1,
+    libspirv::StatsAggregationMode mode = libspirv::StatsAggregationMode::kFull) {
   ScopedContext ctx(env);
   SetContextMessageConsumer(ctx.context, DiagnosticsMessageHandler);
   spv_binary binary;
@@ -57,7 +89,8 @@ void CompileAndAggregateStats(const std::string& code, SpirvStats* stats,
       ctx.context, code.c_str(), code.size(), &binary, nullptr));
 
   ASSERT_EQ(SPV_SUCCESS, AggregateStats(*ctx.context, binary->code,
-                                        binary->wordCount, nullptr, stats));
+                                        binary->wordCount, nullptr, stats,
+                                        mode));
   spvBinaryDestroy(binary);
 }
 
@@ -278,65 +311,47 @@ OpMemoryModel Physical32 OpenCL
 )";
 
   SpirvStats stats;
-  stats.opcode_markov_hist.resize(2);
+  stats.opcode_markov_steps = 2;
 
   CompileAndAggregateStats(code1, &stats);
-  ASSERT_EQ(2u, stats.opcode_markov_hist.size());
-  EXPECT_EQ(2u, stats.opcode_markov_hist[0].size());
-  EXPECT_EQ(2u, stats.opcode_markov_hist[0].at(SpvOpCapability).size());
-  EXPECT_EQ(1u, stats.opcode_markov_hist[0].at(SpvOpExtension).size());
-  EXPECT_EQ(
-      1u, stats.opcode_markov_hist[0].at(SpvOpCapability).at(SpvOpCapability));
-  EXPECT_EQ(
-      1u, stats.opcode_markov_hist[0].at(SpvOpCapability).at(SpvOpExtension));
-  EXPECT_EQ(
-      1u, stats.opcode_markov_hist[0].at(SpvOpExtension).at(SpvOpMemoryModel));
-
-  EXPECT_EQ(1u, stats.opcode_markov_hist[1].size());
-  EXPECT_EQ(2u, stats.opcode_markov_hist[1].at(SpvOpCapability).size());
-  EXPECT_EQ(
-      1u, stats.opcode_markov_hist[1].at(SpvOpCapability).at(SpvOpExtension));
-  EXPECT_EQ(
-      1u, stats.opcode_markov_hist[1].at(SpvOpCapability).at(SpvOpMemoryModel));
+  ASSERT_EQ(2u, stats.opcode_markov_steps);
+  EXPECT_EQ(2u, MarkovStepSize(stats, 0));
+  EXPECT_EQ(2u, MarkovCueSize(stats, 0, SpvOpCapability));
+  EXPECT_EQ(1u, MarkovCueSize(stats, 0, SpvOpExtension));
+  EXPECT_EQ(1u, MarkovCount(stats, 0, SpvOpCapability, SpvOpCapability));
+  EXPECT_EQ(1u, MarkovCount(stats, 0, SpvOpCapability, SpvOpExtension));
+  EXPECT_EQ(1u, MarkovCount(stats, 0, SpvOpExtension, SpvOpMemoryModel));
+
+  EXPECT_EQ(1u, MarkovStepSize(stats, 1));
+  EXPECT_EQ(2u, MarkovCueSize(stats, 1, SpvOpCapability));
+  EXPECT_EQ(1u, MarkovCount(stats, 1, SpvOpCapability, SpvOpExtension));
+  EXPECT_EQ(1u, MarkovCount(stats, 1, SpvOpCapability, SpvOpMemoryModel));
 
   CompileAndAggregateStats(code2, &stats);
-  ASSERT_EQ(2u, stats.opcode_markov_hist.size());
-  EXPECT_EQ(4u, stats.opcode_markov_hist[0].size());
-  EXPECT_EQ(3u, stats.opcode_markov_hist[0].at(SpvOpCapability).size());
-  EXPECT_EQ(1u, stats.opcode_markov_hist[0].at(SpvOpExtension).size());
-  EXPECT_EQ(1u, stats.opcode_markov_hist[0].at(SpvOpMemoryModel).size());
-  EXPECT_EQ(2u, stats.opcode_markov_hist[0].at(SpvOpTypeInt).size());
-  EXPECT_EQ(
-      4u, stats.opcode_markov_hist[0].at(SpvOpCapability).at(SpvOpCapability));
-  EXPECT_EQ(
-      1u, stats.opcode_markov_hist[0].at(SpvOpCapability).at(SpvOpExtension));
-  EXPECT_EQ(
-      1u, stats.opcode_markov_hist[0].at(SpvOpCapability).at(SpvOpMemoryModel));
-  EXPECT_EQ(
-      1u, stats.opcode_markov_hist[0].at(SpvOpExtension).at(SpvOpMemoryModel));
-  EXPECT_EQ(
-      1u, stats.opcode_markov_hist[0].at(SpvOpMemoryModel).at(SpvOpTypeInt));
-  EXPECT_EQ(
-      1u, stats.opcode_markov_hist[0].at(SpvOpTypeInt).at(SpvOpTypeInt));
-  EXPECT_EQ(
-      1u, stats.opcode_markov_hist[0].at(SpvOpTypeInt).at(SpvOpTypeFloat));
-
-  EXPECT_EQ(3u, stats.opcode_markov_hist[1].size());
-  EXPECT_EQ(4u, stats.opcode_markov_hist[1].at(SpvOpCapability).size());
-  EXPECT_EQ(1u, stats.opcode_markov_hist[1].at(SpvOpMemoryModel).size());
-  EXPECT_EQ(1u, stats.opcode_markov_hist[1].at(SpvOpTypeInt).size());
-  EXPECT_EQ(
-      2u, stats.opcode_markov_hist[1].at(SpvOpCapability).at(SpvOpCapability));
-  EXPECT_EQ(
-      1u, stats.opcode_markov_hist[1].at(SpvOpCapability).at(SpvOpExtension));
-  EXPECT_EQ(
-      2u, stats.opcode_markov_hist[1].at(SpvOpCapability).at(SpvOpMemoryModel));
-  EXPECT_EQ(
-      1u, stats.opcode_markov_hist[1].at(SpvOpCapability).at(SpvOpTypeInt));
-  EXPECT_EQ(
-      1u, stats.opcode_markov_hist[1].at(SpvOpMemoryModel).at(SpvOpTypeInt));
-  EXPECT_EQ(
-      1u, stats.opcode_markov_hist[1].at(SpvOpTypeInt).at(SpvOpTypeFloat));
+  ASSERT_EQ(2u, stats.opcode_markov_steps);
+  EXPECT_EQ(4u, MarkovStepSize(stats, 0));
+  EXPECT_EQ(3u, MarkovCueSize(stats, 0, SpvOpCapability));
+  EXPECT_EQ(1u, MarkovCueSize(stats, 0, SpvOpExtension));
+  EXPECT_EQ(1u, MarkovCueSize(stats, 0, SpvOpMemoryModel));
+  EXPECT_EQ(2u, MarkovCueSize(stats, 0, SpvOpTypeInt));
+  EXPECT_EQ(4u, MarkovCount(stats, 0, SpvOpCapability, SpvOpCapability));
+  EXPECT_EQ(1u, MarkovCount(stats, 0, SpvOpCapability, SpvOpExtension));
+  EXPECT_EQ(1u, MarkovCount(stats, 0, SpvOpCapability, SpvOpMemoryModel));
+  EXPECT_EQ(1u, MarkovCount(stats, 0, SpvOpExtension, SpvOpMemoryModel));
+  EXPECT_EQ(1u, MarkovCount(stats, 0, SpvOpMemoryModel, SpvOpTypeInt));
+  EXPECT_EQ(1u, MarkovCount(stats, 0, SpvOpTypeInt, SpvOpTypeInt));
+  EXPECT_EQ(1u, MarkovCount(stats, 0, SpvOpTypeInt, SpvOpTypeFloat));
+
+  EXPECT_EQ(3u, MarkovStepSize(stats, 1));
+  EXPECT_EQ(4u, MarkovCueSize(stats, 1, SpvOpCapability));
+  EXPECT_EQ(1u, MarkovCueSize(stats, 1, SpvOpMemoryModel));
+  EXPECT_EQ(1u, MarkovCueSize(stats, 1, SpvOpTypeInt));
+  EXPECT_EQ(2u, MarkovCount(stats, 1, SpvOpCapability, SpvOpCapability));
+  EXPECT_EQ(1u, MarkovCount(stats, 1, SpvOpCapability, SpvOpExtension));
+  EXPECT_EQ(2u, MarkovCount(stats, 1, SpvOpCapability, SpvOpMemoryModel));
+  EXPECT_EQ(1u, MarkovCount(stats, 1, SpvOpCapability, SpvOpTypeInt));
+  EXPECT_EQ(1u, MarkovCount(stats, 1, SpvOpMemoryModel, SpvOpTypeInt));
+  EXPECT_EQ(1u, MarkovCount(stats, 1, SpvOpTypeInt, SpvOpTypeFloat));
 }
 
 TEST(AggregateStats, ConstantLiteralsHistogram) {
@@ -433,4 +448,168 @@ OpMemoryModel Logical GLSL450
   EXPECT_EQ(1u, stats.s64_constant_hist.at(-64));
 }
 
+TEST(MergeStats, MatchesSequentialAggregation) {
+  const std::string code1 = R"(
+OpCapability Addresses
+OpCapability Kernel
+OpCapability GenericPointer
+OpCapability Linkage
+OpExtension "SPV_KHR_16bit_storage"
+OpMemoryModel Physical32 OpenCL
+%u32 = OpTypeInt 32 0
+%f32 = OpTypeFloat 32
+%1 = OpConstant %u32 32
+%2 = OpConstant %f32 0.1
+)";
+
+  const std::string code2 = R"(
+OpCapability Shader
+OpCapability Linkage
+OpExtension "SPV_NV_viewport_array2"
+OpMemoryModel Logical GLSL450
+%u32 = OpTypeInt 32 0
+%1 = OpConstant %u32 32
+%2 = OpConstant %u32 2
+)";
+
+  SpirvStats sequential;
+  sequential.opcode_markov_steps = 2;
+  CompileAndAggregateStats(code1, &sequential);
+  CompileAndAggregateStats(code2, &sequential);
+
+  SpirvStats partial1;
+  partial1.opcode_markov_steps = 2;
+  CompileAndAggregateStats(code1, &partial1);
+
+  SpirvStats partial2;
+  partial2.opcode_markov_steps = 2;
+  CompileAndAggregateStats(code2, &partial2);
+
+  SpirvStats merged;
+  MergeStats(partial1, &merged);
+  MergeStats(partial2, &merged);
+
+  EXPECT_EQ(sequential.version_hist, merged.version_hist);
+  EXPECT_EQ(sequential.generator_hist, merged.generator_hist);
+  EXPECT_EQ(sequential.capability_hist, merged.capability_hist);
+  EXPECT_EQ(sequential.extension_hist, merged.extension_hist);
+  EXPECT_EQ(sequential.opcode_hist, merged.opcode_hist);
+  EXPECT_EQ(sequential.u32_constant_hist, merged.u32_constant_hist);
+  EXPECT_EQ(sequential.f32_constant_hist, merged.f32_constant_hist);
+  EXPECT_EQ(sequential.opcode_markov_hist, merged.opcode_markov_hist);
+}
+
+TEST(AggregateStats, RawScanMatchesFullParse) {
+  const std::string code = R"(
+OpCapability Addresses
+OpCapability Kernel
+OpCapability GenericPointer
+OpCapability Linkage
+OpExtension "SPV_KHR_16bit_storage"
+OpExtension "SPV_NV_viewport_array2"
+OpMemoryModel Physical32 OpenCL
+%u32 = OpTypeInt 32 0
+%f32 = OpTypeFloat 32
+%1 = OpConstant %u32 32
+%2 = OpConstant %f32 0.5
+)";
+
+  SpirvStats full;
+  full.opcode_markov_steps = 2;
+  CompileAndAggregateStats(code, &full);
+
+  SpirvStats raw;
+  raw.opcode_markov_steps = 2;
+  CompileAndAggregateStats(code, &raw, SPV_ENV_UNIVERSAL_1_1,
+                           libspirv::StatsAggregationMode::kRawScan);
+
+  EXPECT_EQ(full.version_hist, raw.version_hist);
+  EXPECT_EQ(full.generator_hist, raw.generator_hist);
+  EXPECT_EQ(full.capability_hist, raw.capability_hist);
+  EXPECT_EQ(full.extension_hist, raw.extension_hist);
+  EXPECT_EQ(full.opcode_hist, raw.opcode_hist);
+  EXPECT_EQ(full.opcode_markov_hist, raw.opcode_markov_hist);
+
+  // The raw scan does not decode operands, so no constant literals.
+  EXPECT_TRUE(raw.u32_constant_hist.empty());
+  EXPECT_TRUE(raw.f32_constant_hist.empty());
+}
+
+TEST(SerializeStats, RoundTrip) {
+  const std::string code = R"(
+OpCapability Addresses
+OpCapability Kernel
+OpCapability GenericPointer
+OpCapability Linkage
+OpExtension "SPV_KHR_16bit_storage"
+OpMemoryModel Physical32 OpenCL
+%u16 = OpTypeInt 16 0
+%u32 = OpTypeInt 32 0
+%u64 = OpTypeInt 64 0
+%s32 = OpTypeInt 32 1
+%f32 = OpTypeFloat 32
+%f64 = OpTypeFloat 64
+%1 = OpConstant %u16 16
+%2 = OpConstant %u32 32
+%3 = OpConstant %u64 64
+%4 = OpConstant %s32 -32
+%5 = OpConstant %f32 0.1
+%6 = OpConstant %f64 -0.2
+)";
+
+  SpirvStats stats;
+  stats.opcode_markov_steps = 2;
+  CompileAndAggregateStats(code, &stats);
+
+  std::vector<uint32_t> snapshot;
+  libspirv::SerializeStats(stats, &snapshot);
+
+  SpirvStats loaded;
+  ASSERT_TRUE(libspirv::DeserializeStats(snapshot.data(), snapshot.size(),
+                                         &loaded));
+  EXPECT_EQ(stats.version_hist, loaded.version_hist);
+  EXPECT_EQ(stats.generator_hist, loaded.generator_hist);
+  EXPECT_EQ(stats.capability_hist, loaded.capability_hist);
+  EXPECT_EQ(stats.extension_hist, loaded.extension_hist);
+  EXPECT_EQ(stats.opcode_hist, loaded.opcode_hist);
+  EXPECT_EQ(stats.u16_constant_hist, loaded.u16_constant_hist);
+  EXPECT_EQ(stats.u32_constant_hist, loaded.u32_constant_hist);
+  EXPECT_EQ(stats.u64_constant_hist, loaded.u64_constant_hist);
+  EXPECT_EQ(stats.s32_constant_hist, loaded.s32_constant_hist);
+  EXPECT_EQ(stats.f32_constant_hist, loaded.f32_constant_hist);
+  EXPECT_EQ(stats.f64_constant_hist, loaded.f64_constant_hist);
+  EXPECT_EQ(stats.opcode_markov_hist, loaded.opcode_markov_hist);
+
+  // Loading a second copy doubles every count, matching MergeStats.
+  ASSERT_TRUE(libspirv::DeserializeStats(snapshot.data(), snapshot.size(),
+                                         &loaded));
+  SpirvStats doubled;
+  libspirv::MergeStats(stats, &doubled);
+  libspirv::MergeStats(stats, &doubled);
+  EXPECT_EQ(doubled.opcode_hist, loaded.opcode_hist);
+  EXPECT_EQ(doubled.extension_hist, loaded.extension_hist);
+}
+
+TEST(SerializeStats, RejectsMalformedSnapshot) {
+  SpirvStats stats;
+  stats.opcode_hist[42] = 7;
+  std::vector<uint32_t> snapshot;
+  libspirv::SerializeStats(stats, &snapshot);
+
+  SpirvStats loaded;
+  // Wrong magic.
+  std::vector<uint32_t> bad = snapshot;
+  bad[0] ^= 1;
+  EXPECT_FALSE(libspirv::DeserializeStats(bad.data(), bad.size(), &loaded));
+  // Truncated.
+  EXPECT_FALSE(libspirv::DeserializeStats(snapshot.data(),
+                                          snapshot.size() - 1, &loaded));
+  // Trailing garbage.
+  bad = snapshot;
+  bad.push_back(0);
+  EXPECT_FALSE(libspirv::DeserializeStats(bad.data(), bad.size(), &loaded));
+  // A failed load leaves the output untouched.
+  EXPECT_TRUE(loaded.opcode_hist.empty());
+}
+
 }  // namespace
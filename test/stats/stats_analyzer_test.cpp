@@ -148,12 +148,12 @@ TEST(StatsAnalyzer, OpcodeMarkov) {
   stats.opcode_hist[SpvOpFAdd] = 200;
   stats.opcode_hist[SpvOpFSub] = 400;
 
-  stats.opcode_markov_hist.resize(1);
-  auto& hist = stats.opcode_markov_hist[0];
-  hist[SpvOpFMul][SpvOpFAdd] = 100;
-  hist[SpvOpFMul][SpvOpFSub] = 300;
-  hist[SpvOpFAdd][SpvOpFMul] = 100;
-  hist[SpvOpFAdd][SpvOpFAdd] = 100;
+  stats.opcode_markov_steps = 1;
+  auto& hist = stats.opcode_markov_hist;
+  hist[libspirv::MakeMarkovKey(0, SpvOpFMul, SpvOpFAdd)] = 100;
+  hist[libspirv::MakeMarkovKey(0, SpvOpFMul, SpvOpFSub)] = 300;
+  hist[libspirv::MakeMarkovKey(0, SpvOpFAdd, SpvOpFMul)] = 100;
+  hist[libspirv::MakeMarkovKey(0, SpvOpFAdd, SpvOpFAdd)] = 100;
 
   StatsAnalyzer analyzer(stats);
 
@@ -40,7 +40,7 @@ class TextToBinaryTestBase : public T {
 
   TextToBinaryTestBase() : diagnostic(nullptr), text(), binary(nullptr) {
     char textStr[] = "substitute the text member variable with your test";
-    text = {textStr, strlen(textStr)};
+    text = {textStr, strlen(textStr), {}};
   }
 
   virtual ~TextToBinaryTestBase() {
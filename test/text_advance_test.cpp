@@ -23,45 +23,45 @@ TEST(TextAdvance, LeadingNewLines) {
   AutoText input("\n\nWord");
   AssemblyContext data(input, nullptr);
   ASSERT_EQ(SPV_SUCCESS, data.advance());
-  ASSERT_EQ(0u, data.position().column);
-  ASSERT_EQ(2u, data.position().line);
   ASSERT_EQ(2u, data.position().index);
+  ASSERT_EQ(0u, data.positionForDiagnostic().column);
+  ASSERT_EQ(2u, data.positionForDiagnostic().line);
 }
 
 TEST(TextAdvance, LeadingSpaces) {
   AutoText input("    Word");
   AssemblyContext data(input, nullptr);
   ASSERT_EQ(SPV_SUCCESS, data.advance());
-  ASSERT_EQ(4u, data.position().column);
-  ASSERT_EQ(0u, data.position().line);
   ASSERT_EQ(4u, data.position().index);
+  ASSERT_EQ(4u, data.positionForDiagnostic().column);
+  ASSERT_EQ(0u, data.positionForDiagnostic().line);
 }
 
 TEST(TextAdvance, LeadingTabs) {
   AutoText input("\t\t\tWord");
   AssemblyContext data(input, nullptr);
   ASSERT_EQ(SPV_SUCCESS, data.advance());
-  ASSERT_EQ(3u, data.position().column);
-  ASSERT_EQ(0u, data.position().line);
   ASSERT_EQ(3u, data.position().index);
+  ASSERT_EQ(3u, data.positionForDiagnostic().column);
+  ASSERT_EQ(0u, data.positionForDiagnostic().line);
 }
 
 TEST(TextAdvance, LeadingNewLinesSpacesAndTabs) {
   AutoText input("\n\n\t  Word");
   AssemblyContext data(input, nullptr);
   ASSERT_EQ(SPV_SUCCESS, data.advance());
-  ASSERT_EQ(3u, data.position().column);
-  ASSERT_EQ(2u, data.position().line);
   ASSERT_EQ(5u, data.position().index);
+  ASSERT_EQ(3u, data.positionForDiagnostic().column);
+  ASSERT_EQ(2u, data.positionForDiagnostic().line);
 }
 
 TEST(TextAdvance, LeadingWhitespaceAfterCommentLine) {
   AutoText input("; comment\n \t \tWord");
   AssemblyContext data(input, nullptr);
   ASSERT_EQ(SPV_SUCCESS, data.advance());
-  ASSERT_EQ(4u, data.position().column);
-  ASSERT_EQ(1u, data.position().line);
   ASSERT_EQ(14u, data.position().index);
+  ASSERT_EQ(4u, data.positionForDiagnostic().column);
+  ASSERT_EQ(1u, data.positionForDiagnostic().line);
 }
 
 TEST(TextAdvance, EOFAfterCommentLine) {
@@ -78,14 +78,14 @@ TEST(TextAdvance, NullTerminator) {
 
 TEST(TextAdvance, NoNullTerminatorAfterCommentLine) {
   std::string input = "; comment|padding beyond the end";
-  spv_text_t text = {input.data(), 9};
+  spv_text_t text = {input.data(), 9, {}};
   AssemblyContext data(&text, nullptr);
   ASSERT_EQ(SPV_END_OF_STREAM, data.advance());
   EXPECT_EQ(9u, data.position().index);
 }
 
 TEST(TextAdvance, NoNullTerminator) {
-  spv_text_t text = {"OpNop\nSomething else in memory", 6};
+  spv_text_t text = {"OpNop\nSomething else in memory", 6, {}};
   AssemblyContext data(&text, nullptr);
   const spv_position_t line_break = {1u, 5u, 5u};
   data.setPosition(line_break);
@@ -93,12 +93,13 @@ TEST(TextAdvance, NoNullTerminator) {
 }
 
 // Invokes AssemblyContext::advance() on text, asserts success, and returns
-// AssemblyContext::position().
+// AssemblyContext::positionForDiagnostic(), which carries the line and
+// column recovered from the byte index.
 spv_position_t PositionAfterAdvance(const char* text) {
   AutoText input(text);
   AssemblyContext data(input, nullptr);
   EXPECT_EQ(SPV_SUCCESS, data.advance());
-  return data.position();
+  return data.positionForDiagnostic();
 }
 
 TEST(TextAdvance, SkipOverCR) {
@@ -0,0 +1,105 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for the assembler's instruction memo cache: repeated structurally
+// identical lines must encode exactly as they would one at a time.
+
+#include "unit_spirv.h"
+
+#include "test_fixture.h"
+#include "gmock/gmock.h"
+
+namespace {
+
+using spvtest::MakeInstruction;
+using spvtest::TextToBinaryTest;
+using ::testing::Eq;
+
+TEST_F(TextToBinaryTest, RepeatedDecorationsStampFreshIds) {
+  // The second and third lines have the same token shape as the first and
+  // come out of the template cache; each still gets its own id.
+  const SpirvVector code = CompiledInstructions(
+      "OpDecorate %a Block\n"
+      "OpDecorate %b Block\n"
+      "OpDecorate %c Block\n");
+  EXPECT_THAT(code,
+              Eq(spvtest::Concatenate(
+                  {MakeInstruction(SpvOpDecorate, {1, SpvDecorationBlock}),
+                   MakeInstruction(SpvOpDecorate, {2, SpvDecorationBlock}),
+                   MakeInstruction(SpvOpDecorate, {3, SpvDecorationBlock})})));
+}
+
+TEST_F(TextToBinaryTest, RepeatedMemberDecorationsReuseNames) {
+  // A repeated name must resolve to its already-assigned id, not a new one.
+  const SpirvVector code = CompiledInstructions(
+      "OpMemberDecorate %s 0 Offset 0\n"
+      "OpMemberDecorate %s 1 Offset 16\n"
+      "OpMemberDecorate %t 0 Offset 0\n");
+  EXPECT_THAT(
+      code,
+      Eq(spvtest::Concatenate(
+          {MakeInstruction(SpvOpMemberDecorate, {1, 0, SpvDecorationOffset, 0}),
+           MakeInstruction(SpvOpMemberDecorate,
+                           {1, 1, SpvDecorationOffset, 16}),
+           MakeInstruction(SpvOpMemberDecorate,
+                           {2, 0, SpvDecorationOffset, 0})})));
+}
+
+TEST_F(TextToBinaryTest, RepeatedResultLinesRoundTrip) {
+  // Lines with result ids share templates too; the round trip proves the
+  // stamped ids and the recorded value types line up with the slow path.
+  const std::string input =
+      "%void = OpTypeVoid\n"
+      "%fn = OpTypeFunction %void\n"
+      "%f = OpFunction %void None %fn\n"
+      "%entry = OpLabel\n"
+      "%l2 = OpLabel\n"
+      "%l3 = OpLabel\n"
+      "OpReturn\n"
+      "OpFunctionEnd\n";
+  EXPECT_EQ(
+      "%1 = OpTypeVoid\n"
+      "%2 = OpTypeFunction %1\n"
+      "%3 = OpFunction %1 None %2\n"
+      "%4 = OpLabel\n"
+      "%5 = OpLabel\n"
+      "%6 = OpLabel\n"
+      "OpReturn\n"
+      "OpFunctionEnd\n",
+      EncodeAndDecodeSuccessfully(input));
+}
+
+TEST_F(TextToBinaryTest, RepeatedShapeWithBadIdStillFails) {
+  // A line matching a cached shape is still subject to id validation.
+  EXPECT_THAT(CompileFailure("OpDecorate %a Block\n"
+                             "OpDecorate %@ Block\n"),
+              Eq("Invalid ID @"));
+}
+
+TEST_F(TextToBinaryTest, RepeatedNamesKeepDistinctStrings) {
+  // The string literal is part of the cache key, so lines differing only
+  // in the string do not share a template.
+  const SpirvVector code = CompiledInstructions(
+      "OpName %a \"alpha\"\n"
+      "OpName %b \"beta\"\n"
+      "OpName %c \"alpha\"\n");
+  EXPECT_THAT(code,
+              Eq(spvtest::Concatenate(
+                  {MakeInstruction(SpvOpName, {1}, spvtest::MakeVector("alpha")),
+                   MakeInstruction(SpvOpName, {2}, spvtest::MakeVector("beta")),
+                   MakeInstruction(SpvOpName, {3},
+                                   spvtest::MakeVector("alpha"))})));
+}
+
+}  // anonymous namespace
@@ -160,7 +160,7 @@ inline std::vector<uint32_t> MakeVector(std::string input) {
 // spv_text.
 struct AutoText {
   explicit AutoText(const std::string& value)
-      : str(value), text({str.data(), str.size()}) {}
+      : str(value), text({str.data(), str.size(), {}}) {}
   operator spv_text() { return &text; }
   std::string str;
   spv_text_t text;
@@ -0,0 +1,102 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for the validation work budget on the validator options.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "test_fixture.h"
+#include "unit_spirv.h"
+#include "val_fixtures.h"
+
+namespace {
+
+using spvtest::ScopedContext;
+
+spv_result_t ValidateWithBudget(const std::string& code,
+                                const spv_validator_budget_t& budget) {
+  ScopedContext ctx;
+  spv_binary binary = nullptr;
+  EXPECT_EQ(SPV_SUCCESS, spvTextToBinary(ctx.context, code.c_str(),
+                                         code.size(), &binary, nullptr));
+
+  spv_validator_options options = spvValidatorOptionsCreate();
+  spvValidatorOptionsSetBudget(options, &budget);
+  spv_const_binary_t const_binary{binary->code, binary->wordCount};
+  spv_diagnostic diagnostic = nullptr;
+  const spv_result_t result =
+      spvValidateWithOptions(ctx.context, options, &const_binary, &diagnostic);
+  spvDiagnosticDestroy(diagnostic);
+  spvValidatorOptionsDestroy(options);
+  spvBinaryDestroy(binary);
+  return result;
+}
+
+// A valid module with one function of two blocks.
+const char kValidModule[] = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%void = OpTypeVoid
+%voidfn = OpTypeFunction %void
+%fn = OpFunction %void None %voidfn
+%entry = OpLabel
+OpBranch %next
+%next = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+TEST(ValidationBudget, AllZeroBudgetIsUnlimited) {
+  const spv_validator_budget_t budget = {};
+  EXPECT_EQ(SPV_SUCCESS, ValidateWithBudget(kValidModule, budget));
+}
+
+TEST(ValidationBudget, SufficientBudgetPasses) {
+  spv_validator_budget_t budget = {};
+  budget.max_instructions = 100;
+  budget.max_blocks_per_function = 100;
+  budget.max_validation_steps = 10000;
+  EXPECT_EQ(SPV_SUCCESS, ValidateWithBudget(kValidModule, budget));
+}
+
+TEST(ValidationBudget, MaxInstructionsExceeded) {
+  spv_validator_budget_t budget = {};
+  budget.max_instructions = 4;
+  EXPECT_EQ(SPV_ERROR_EXCEEDED_BUDGET,
+            ValidateWithBudget(kValidModule, budget));
+}
+
+TEST(ValidationBudget, MaxBlocksPerFunctionExceeded) {
+  spv_validator_budget_t budget = {};
+  budget.max_blocks_per_function = 1;
+  EXPECT_EQ(SPV_ERROR_EXCEEDED_BUDGET,
+            ValidateWithBudget(kValidModule, budget));
+}
+
+TEST(ValidationBudget, MaxBlocksPerFunctionSufficient) {
+  spv_validator_budget_t budget = {};
+  budget.max_blocks_per_function = 2;
+  EXPECT_EQ(SPV_SUCCESS, ValidateWithBudget(kValidModule, budget));
+}
+
+TEST(ValidationBudget, MaxValidationStepsExceeded) {
+  spv_validator_budget_t budget = {};
+  budget.max_validation_steps = 3;
+  EXPECT_EQ(SPV_ERROR_EXCEEDED_BUDGET,
+            ValidateWithBudget(kValidModule, budget));
+}
+
+}  // anonymous namespace
@@ -0,0 +1,141 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for selecting validator check stages via the options check mask.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "test_fixture.h"
+#include "unit_spirv.h"
+#include "val_fixtures.h"
+
+namespace {
+
+using spvtest::ScopedContext;
+
+// The check mask used by a load path that trusts everything but structure
+// and id use.
+const uint32_t kStructuralChecks = SPV_VALIDATOR_CHECK_LAYOUT |
+                                   SPV_VALIDATOR_CHECK_CFG |
+                                   SPV_VALIDATOR_CHECK_IDS;
+
+spv_result_t ValidateWithChecks(const std::string& code, uint32_t checks) {
+  ScopedContext ctx;
+  spv_binary binary = nullptr;
+  EXPECT_EQ(SPV_SUCCESS, spvTextToBinary(ctx.context, code.c_str(),
+                                         code.size(), &binary, nullptr));
+
+  spv_validator_options options = spvValidatorOptionsCreate();
+  spvValidatorOptionsSetChecks(options, checks);
+  spv_diagnostic diagnostic = nullptr;
+  const spv_result_t result =
+      spvValidateWithOptions(ctx.context, options, binary, &diagnostic);
+  spvDiagnosticDestroy(diagnostic);
+  spvValidatorOptionsDestroy(options);
+  spvBinaryDestroy(binary);
+  return result;
+}
+
+const char kValidModule[] = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%void = OpTypeVoid
+%voidfn = OpTypeFunction %void
+%fn = OpFunction %void None %voidfn
+%entry = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+// Declares a 64-bit float without the Float64 capability.
+const char kMissingCapabilityModule[] = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%f64 = OpTypeFloat 64
+)";
+
+// A function declaration without the required linkage attributes decoration.
+const char kMissingLinkageDecorationModule[] = R"(
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%void = OpTypeVoid
+%voidfn = OpTypeFunction %void
+%fn = OpFunction %void None %voidfn
+OpFunctionEnd
+)";
+
+TEST(ValidatorCheckSelection, DefaultRunsAllChecks) {
+  EXPECT_EQ(SPV_SUCCESS,
+            ValidateWithChecks(kValidModule, SPV_VALIDATOR_CHECK_ALL));
+  EXPECT_NE(SPV_SUCCESS, ValidateWithChecks(kMissingCapabilityModule,
+                                            SPV_VALIDATOR_CHECK_ALL));
+  EXPECT_NE(SPV_SUCCESS, ValidateWithChecks(kMissingLinkageDecorationModule,
+                                            SPV_VALIDATOR_CHECK_ALL));
+}
+
+TEST(ValidatorCheckSelection, StructuralChecksAcceptValidModule) {
+  EXPECT_EQ(SPV_SUCCESS, ValidateWithChecks(kValidModule, kStructuralChecks));
+}
+
+TEST(ValidatorCheckSelection, StructuralChecksSkipCapabilityRules) {
+  EXPECT_EQ(SPV_SUCCESS,
+            ValidateWithChecks(kMissingCapabilityModule, kStructuralChecks));
+}
+
+TEST(ValidatorCheckSelection, DeselectedDecorationRulesAreSkipped) {
+  EXPECT_EQ(
+      SPV_SUCCESS,
+      ValidateWithChecks(kMissingLinkageDecorationModule,
+                         SPV_VALIDATOR_CHECK_ALL &
+                             ~uint32_t(SPV_VALIDATOR_CHECK_DECORATIONS)));
+}
+
+TEST(ValidatorCheckSelection, StructuralChecksStillCatchIdErrors) {
+  // %undef is never defined, so the id checks must still reject this even
+  // on the reduced mask.
+  const std::string code = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%void = OpTypeVoid
+%voidfn = OpTypeFunction %void
+%fn = OpFunction %void None %voidfn
+%entry = OpLabel
+OpBranch %undef
+OpFunctionEnd
+)";
+  EXPECT_NE(SPV_SUCCESS, ValidateWithChecks(code, kStructuralChecks));
+}
+
+TEST(ValidatorCheckSelection, StructuralChecksStillCatchLayoutErrors) {
+  // OpTypeVoid may not appear inside a function body.
+  const std::string code = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%void = OpTypeVoid
+%voidfn = OpTypeFunction %void
+%fn = OpFunction %void None %voidfn
+%entry = OpLabel
+%bad = OpTypeVoid
+OpReturn
+OpFunctionEnd
+)";
+  EXPECT_NE(SPV_SUCCESS, ValidateWithChecks(code, kStructuralChecks));
+}
+
+}  // anonymous namespace
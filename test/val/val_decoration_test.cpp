@@ -49,6 +49,30 @@ TEST_F(ValidateDecorations, ValidateOpDecorateRegistration) {
                                     Decoration(SpvDecorationUniform)}));
 }
 
+TEST_F(ValidateDecorations, ValidateInterleavedDecorateRegistration) {
+  string spirv = R"(
+    OpCapability Shader
+    OpCapability Linkage
+    OpMemoryModel Logical GLSL450
+    OpDecorate %1 ArrayStride 4
+    OpDecorate %3 ArrayStride 8
+    OpDecorate %1 Uniform
+    %2 = OpTypeFloat 32
+    %1 = OpTypeRuntimeArray %2
+    %3 = OpTypeRuntimeArray %2
+)";
+  CompileSuccessfully(spirv);
+  EXPECT_EQ(SPV_SUCCESS, ValidateAndRetrieveValidationState());
+  // Decorations of an id group together even when the OpDecorate
+  // instructions targeting it are not adjacent.
+  EXPECT_THAT(vstate_->id_decorations(1),
+              Eq(vector<Decoration>{Decoration(SpvDecorationArrayStride, {4}),
+                                    Decoration(SpvDecorationUniform)}));
+  EXPECT_THAT(
+      vstate_->id_decorations(3),
+      Eq(vector<Decoration>{Decoration(SpvDecorationArrayStride, {8})}));
+}
+
 TEST_F(ValidateDecorations, ValidateOpMemberDecorateRegistration) {
   string spirv = R"(
     OpCapability Shader
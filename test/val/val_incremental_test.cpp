@@ -0,0 +1,118 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for incrementally validating a module that grew after a baseline run.
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "source/spirv_constant.h"
+#include "source/validate.h"
+#include "test_fixture.h"
+#include "unit_spirv.h"
+#include "val_fixtures.h"
+
+namespace {
+
+using spvtest::ScopedContext;
+using std::string;
+using std::vector;
+
+using ValidateIncremental = spvtest::ValidateBase<bool>;
+
+const char kHeader[] =
+    " OpCapability Shader"
+    " OpCapability Linkage"
+    " OpMemoryModel Logical GLSL450 ";
+
+const char kVoidFVoid[] =
+    " %void   = OpTypeVoid"
+    " %void_f = OpTypeFunction %void"
+    " %func   = OpFunction %void None %void_f"
+    " %label  = OpLabel"
+    "           OpReturn"
+    "           OpFunctionEnd ";
+
+const char kAppendedFunction[] =
+    " %func2  = OpFunction %void None %void_f"
+    " %label2 = OpLabel"
+    "           OpReturn"
+    "           OpFunctionEnd ";
+
+vector<uint32_t> Words(const spv_const_binary binary) {
+  return vector<uint32_t>(binary->code, binary->code + binary->wordCount);
+}
+
+// A function appended to a validated module passes the delta validation.
+TEST_F(ValidateIncremental, ValidAppendedFunction) {
+  CompileSuccessfully(string(kHeader) + kVoidFVoid);
+  const vector<uint32_t> baseline = Words(binary_);
+  CompileSuccessfully(string(kHeader) + kVoidFVoid + kAppendedFunction);
+  const vector<uint32_t> patched = Words(binary_);
+  // The patched binary must extend the baseline; only the id bound in the
+  // header may differ.
+  ASSERT_TRUE(std::equal(baseline.begin() + SPV_INDEX_INSTRUCTION,
+                         baseline.end(),
+                         patched.begin() + SPV_INDEX_INSTRUCTION));
+
+  ScopedContext ctx;
+  std::unique_ptr<libspirv::ValidationState_t> vstate;
+  ASSERT_EQ(SPV_SUCCESS, spvtools::ValidateBinaryAndKeepValidationState(
+                             ctx.context, options_, baseline.data(),
+                             baseline.size(), &diagnostic_, &vstate));
+  EXPECT_EQ(SPV_SUCCESS, spvtools::ValidateBinaryDelta(
+                             ctx.context, patched.data(), patched.size(),
+                             baseline.size(), &diagnostic_, vstate.get()));
+}
+
+// Instructions in the delta are still checked against the module layout the
+// retained state has reached: a type definition cannot follow the function
+// definitions.
+TEST_F(ValidateIncremental, RejectsLayoutViolationInDelta) {
+  CompileSuccessfully(string(kHeader) + kVoidFVoid);
+  const vector<uint32_t> baseline = Words(binary_);
+  CompileSuccessfully(string(kHeader) + kVoidFVoid + " %int = OpTypeInt 32 1 ");
+  const vector<uint32_t> patched = Words(binary_);
+
+  ScopedContext ctx;
+  std::unique_ptr<libspirv::ValidationState_t> vstate;
+  ASSERT_EQ(SPV_SUCCESS, spvtools::ValidateBinaryAndKeepValidationState(
+                             ctx.context, options_, baseline.data(),
+                             baseline.size(), &diagnostic_, &vstate));
+  EXPECT_EQ(SPV_ERROR_INVALID_LAYOUT,
+            spvtools::ValidateBinaryDelta(ctx.context, patched.data(),
+                                          patched.size(), baseline.size(),
+                                          &diagnostic_, vstate.get()));
+}
+
+// A baseline word count outside the binary is rejected up front.
+TEST_F(ValidateIncremental, RejectsBaselineOutsideBinary) {
+  CompileSuccessfully(string(kHeader) + kVoidFVoid);
+  const vector<uint32_t> baseline = Words(binary_);
+
+  ScopedContext ctx;
+  std::unique_ptr<libspirv::ValidationState_t> vstate;
+  ASSERT_EQ(SPV_SUCCESS, spvtools::ValidateBinaryAndKeepValidationState(
+                             ctx.context, options_, baseline.data(),
+                             baseline.size(), &diagnostic_, &vstate));
+  EXPECT_EQ(SPV_ERROR_INVALID_BINARY,
+            spvtools::ValidateBinaryDelta(ctx.context, baseline.data(),
+                                          baseline.size(), baseline.size() + 1,
+                                          &diagnostic_, vstate.get()));
+}
+
+}  // anonymous namespace
@@ -78,6 +78,52 @@ TEST_F(ValidateLimits, IdEqualToBoundBad) {
       HasSubstr("Result <id> '64' must be less than the ID bound '64'."));
 }
 
+TEST_F(ValidateLimits, IdOperandLargerThanBoundBad) {
+  string str = header + R"(
+;  %i32 has ID 1
+%i32    = OpTypeInt 32 1
+
+; Fake an OpConstantNull whose type <id> is 64.
+; !2 = OpConstantNull !64
+!0x3002e !64 !2
+)";
+
+  CompileSuccessfully(str);
+  ASSERT_EQ(SPV_ERROR_INVALID_BINARY, ValidateInstructions());
+  EXPECT_THAT(getDiagnosticString(),
+              HasSubstr("ID '64' must be less than the ID bound '2'."));
+}
+
+TEST_F(ValidateLimits, HugeIdBoundHeaderDoesNotExhaustMemory) {
+  string str = header + R"(
+%i32    = OpTypeInt 32 1
+%c      = OpConstant %i32 100
+)";
+  CompileSuccessfully(str);
+
+  // A hostile module a few dozen bytes long can claim a bound near 2^32;
+  // the validator must not size its id-indexed storage from the bound
+  // alone.  Every id here is small and valid, so validation still passes.
+  OverwriteAssembledBinary(3, 0xFFFFFF00u);
+  EXPECT_EQ(SPV_SUCCESS, ValidateInstructions());
+}
+
+TEST_F(ValidateLimits, IdAboveDenseStorageCapStillValidates) {
+  string str = header + R"(
+%i32    = OpTypeInt 32 1
+
+; Fake an OpConstantNull with a result id far above the module word count,
+; so it lands in the validator's overflow id storage once the oversized
+; bound caps the dense containers.
+; !1000 = OpConstantNull %i32
+!0x3002e !1 !1000
+)";
+  CompileSuccessfully(str);
+
+  OverwriteAssembledBinary(3, 0xFFFFFF00u);
+  EXPECT_EQ(SPV_SUCCESS, ValidateInstructions());
+}
+
 TEST_F(ValidateLimits, StructNumMembersGood) {
   std::ostringstream spirv;
   spirv << header << R"(
@@ -0,0 +1,115 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for pipelined validation, where the per-instruction checks run on
+// a worker thread fed by the decoder.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "test_fixture.h"
+#include "unit_spirv.h"
+#include "val_fixtures.h"
+
+namespace {
+
+using spvtest::ScopedContext;
+using ::testing::HasSubstr;
+
+spv_result_t ValidatePipelined(const std::string& code, std::string* error) {
+  ScopedContext ctx;
+  spv_binary binary = nullptr;
+  EXPECT_EQ(SPV_SUCCESS, spvTextToBinary(ctx.context, code.c_str(),
+                                         code.size(), &binary, nullptr));
+
+  spv_validator_options options = spvValidatorOptionsCreate();
+  spvValidatorOptionsSetPipelinedChecks(options, true);
+  spv_const_binary_t const_binary{binary->code, binary->wordCount};
+  spv_diagnostic diagnostic = nullptr;
+  const spv_result_t result =
+      spvValidateWithOptions(ctx.context, options, &const_binary, &diagnostic);
+  if (diagnostic && error) *error = diagnostic->error;
+  spvDiagnosticDestroy(diagnostic);
+  spvValidatorOptionsDestroy(options);
+  spvBinaryDestroy(binary);
+  return result;
+}
+
+// A valid module with one function of two blocks.
+const char kValidModule[] = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%void = OpTypeVoid
+%voidfn = OpTypeFunction %void
+%fn = OpFunction %void None %voidfn
+%entry = OpLabel
+OpBranch %next
+%next = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+TEST(ValidationPipeline, ValidModulePasses) {
+  EXPECT_EQ(SPV_SUCCESS, ValidatePipelined(kValidModule, nullptr));
+}
+
+TEST(ValidationPipeline, ManyInstructionsSpanSeveralBatches) {
+  // More than a thousand instructions in one function, so the module
+  // crosses several batch boundaries on its way to the check thread.
+  std::string str = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%void = OpTypeVoid
+%voidfn = OpTypeFunction %void
+%fn = OpFunction %void None %voidfn
+%entry = OpLabel
+)";
+  for (int i = 0; i < 1200; ++i) {
+    str += "%v" + std::to_string(i) + " = OpIAdd %int %int_0 %int_0\n";
+  }
+  str += R"(
+OpReturn
+OpFunctionEnd
+)";
+  EXPECT_EQ(SPV_SUCCESS, ValidatePipelined(str, nullptr));
+}
+
+TEST(ValidationPipeline, CheckErrorSurfaces) {
+  // The undefined operand id is detected on the check thread and must come
+  // back with the same diagnostic as sequential validation.
+  const std::string str = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%void = OpTypeVoid
+%voidfn = OpTypeFunction %void
+%fn = OpFunction %void None %voidfn
+%entry = OpLabel
+%sum = OpIAdd %int %int_0 %nope
+OpReturn
+OpFunctionEnd
+%nope = OpConstant %int 1
+)";
+  std::string error;
+  EXPECT_EQ(SPV_ERROR_INVALID_ID, ValidatePipelined(str, &error));
+  EXPECT_THAT(error, HasSubstr("has not been defined"));
+}
+
+}  // anonymous namespace
@@ -0,0 +1,134 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for validating a module that arrives in chunks.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "source/spirv_constant.h"
+#include "source/validate.h"
+#include "test_fixture.h"
+#include "unit_spirv.h"
+#include "val_fixtures.h"
+
+namespace {
+
+using spvtest::ScopedContext;
+using std::string;
+using ::testing::HasSubstr;
+
+using ValidateStreaming = spvtest::ValidateBase<bool>;
+
+const char kHeader[] =
+    " OpCapability Shader"
+    " OpCapability Linkage"
+    " OpMemoryModel Logical GLSL450 ";
+
+const char kVoidFVoid[] =
+    " %void   = OpTypeVoid"
+    " %void_f = OpTypeFunction %void"
+    " %func   = OpFunction %void None %void_f"
+    " %label  = OpLabel"
+    "           OpReturn"
+    "           OpFunctionEnd ";
+
+// A valid module accepted in one chunk validates like the batch API.
+TEST_F(ValidateStreaming, ValidModuleSingleChunk) {
+  CompileSuccessfully(string(kHeader) + kVoidFVoid);
+  ScopedContext ctx;
+  spvtools::StreamingValidator validator(ctx.context, options_, &diagnostic_);
+  EXPECT_EQ(SPV_SUCCESS, validator.Feed(binary_->code, binary_->wordCount));
+  EXPECT_EQ(SPV_SUCCESS, validator.Finish());
+}
+
+// Delivering the module one word at a time exercises every partial-header and
+// partial-instruction boundary.
+TEST_F(ValidateStreaming, ValidModuleWordAtATime) {
+  CompileSuccessfully(string(kHeader) + kVoidFVoid);
+  ScopedContext ctx;
+  spvtools::StreamingValidator validator(ctx.context, options_, &diagnostic_);
+  for (size_t i = 0; i < binary_->wordCount; ++i) {
+    ASSERT_EQ(SPV_SUCCESS, validator.Feed(&binary_->code[i], 1))
+        << "unexpected error after feeding word " << i;
+  }
+  EXPECT_EQ(SPV_SUCCESS, validator.Finish());
+}
+
+// A module that violates the logical layout is rejected as soon as the
+// offending instruction arrives, before the rest of the module is fed.
+TEST_F(ValidateStreaming, RejectsBadInstructionBeforeEndOfStream) {
+  // The OpEntryPoint before the memory model assembles fine but violates
+  // the logical layout.
+  CompileSuccessfully(
+      " OpCapability Shader"
+      " OpCapability Linkage"
+      " OpEntryPoint Vertex %func \"shader\""
+      " OpMemoryModel Logical GLSL450"
+      " %void = OpTypeVoid ");
+  ScopedContext ctx;
+  spvtools::StreamingValidator validator(ctx.context, options_, &diagnostic_);
+  size_t words_fed = 0;
+  spv_result_t result = SPV_SUCCESS;
+  while (words_fed < binary_->wordCount && result == SPV_SUCCESS) {
+    result = validator.Feed(&binary_->code[words_fed], 1);
+    ++words_fed;
+  }
+  EXPECT_EQ(SPV_ERROR_INVALID_LAYOUT, result);
+  EXPECT_LT(words_fed, size_t(binary_->wordCount));
+  EXPECT_THAT(
+      getDiagnosticString(),
+      HasSubstr("EntryPoint cannot appear before the memory model"));
+}
+
+// A transfer that ends mid-instruction is diagnosed as truncation by Finish.
+TEST_F(ValidateStreaming, TruncatedModuleDiagnosedAtFinish) {
+  CompileSuccessfully(string(kHeader) + kVoidFVoid);
+  ScopedContext ctx;
+  spvtools::StreamingValidator validator(ctx.context, options_, &diagnostic_);
+  // The header plus the first word of the two-word OpCapability.
+  EXPECT_EQ(SPV_SUCCESS,
+            validator.Feed(binary_->code, SPV_INDEX_INSTRUCTION + 1));
+  EXPECT_EQ(SPV_ERROR_INVALID_BINARY, validator.Finish());
+}
+
+// A transfer that ends cleanly but too early still fails the whole-module
+// checks run by Finish.
+TEST_F(ValidateStreaming, MissingFunctionEndDiagnosedAtFinish) {
+  CompileSuccessfully(string(kHeader) + kVoidFVoid);
+  ScopedContext ctx;
+  spvtools::StreamingValidator validator(ctx.context, options_, &diagnostic_);
+  // Everything except the single-word OpFunctionEnd.
+  EXPECT_EQ(SPV_SUCCESS,
+            validator.Feed(binary_->code, binary_->wordCount - 1));
+  EXPECT_EQ(SPV_ERROR_INVALID_LAYOUT, validator.Finish());
+  EXPECT_THAT(getDiagnosticString(), HasSubstr("Missing OpFunctionEnd"));
+}
+
+// After an error is reported, further calls return that same error.
+TEST_F(ValidateStreaming, ErrorIsSticky) {
+  CompileSuccessfully(
+      " OpCapability Shader"
+      " OpCapability Linkage"
+      " OpEntryPoint Vertex %func \"shader\""
+      " OpMemoryModel Logical GLSL450 ");
+  ScopedContext ctx;
+  spvtools::StreamingValidator validator(ctx.context, options_, &diagnostic_);
+  EXPECT_EQ(SPV_ERROR_INVALID_LAYOUT,
+            validator.Feed(binary_->code, binary_->wordCount));
+  EXPECT_EQ(SPV_ERROR_INVALID_LAYOUT, validator.Feed(binary_->code, 1));
+  EXPECT_EQ(SPV_ERROR_INVALID_LAYOUT, validator.Finish());
+}
+
+}  // anonymous namespace
@@ -0,0 +1,162 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for the pluggable validation result cache.
+
+#include <set>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "test_fixture.h"
+#include "unit_spirv.h"
+#include "val_fixtures.h"
+
+namespace {
+
+using spvtest::ScopedContext;
+
+// An in-memory key-value store tracking how often it was consulted.
+struct TestCacheStore {
+  std::set<uint64_t> keys;
+  int num_lookups = 0;
+  int num_hits = 0;
+  int num_inserts = 0;
+};
+
+bool TestCacheLookup(void* user_data, uint64_t key) {
+  TestCacheStore* store = static_cast<TestCacheStore*>(user_data);
+  ++store->num_lookups;
+  const bool hit = store->keys.count(key) != 0;
+  if (hit) ++store->num_hits;
+  return hit;
+}
+
+void TestCacheInsert(void* user_data, uint64_t key) {
+  TestCacheStore* store = static_cast<TestCacheStore*>(user_data);
+  ++store->num_inserts;
+  store->keys.insert(key);
+}
+
+spv_validation_cache_t MakeCache(TestCacheStore* store) {
+  spv_validation_cache_t cache = {};
+  cache.user_data = store;
+  cache.lookup = TestCacheLookup;
+  cache.insert = TestCacheInsert;
+  return cache;
+}
+
+const char kValidModule[] = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%void = OpTypeVoid
+%voidfn = OpTypeFunction %void
+%fn = OpFunction %void None %voidfn
+%entry = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+spv_binary Assemble(const ScopedContext& ctx, const std::string& code) {
+  spv_binary binary = nullptr;
+  EXPECT_EQ(SPV_SUCCESS, spvTextToBinary(ctx.context, code.c_str(),
+                                         code.size(), &binary, nullptr));
+  return binary;
+}
+
+TEST(ValidationCache, SecondValidationHitsCache) {
+  ScopedContext ctx;
+  spv_binary binary = Assemble(ctx, kValidModule);
+
+  TestCacheStore store;
+  spv_validation_cache_t cache = MakeCache(&store);
+  spv_validator_options options = spvValidatorOptionsCreate();
+  spvValidatorOptionsSetValidationCache(options, &cache);
+
+  EXPECT_EQ(SPV_SUCCESS,
+            spvValidateWithOptions(ctx.context, options, binary, nullptr));
+  EXPECT_EQ(1, store.num_lookups);
+  EXPECT_EQ(0, store.num_hits);
+  EXPECT_EQ(1, store.num_inserts);
+
+  EXPECT_EQ(SPV_SUCCESS,
+            spvValidateWithOptions(ctx.context, options, binary, nullptr));
+  EXPECT_EQ(2, store.num_lookups);
+  EXPECT_EQ(1, store.num_hits);
+  EXPECT_EQ(1, store.num_inserts);
+
+  spvValidatorOptionsDestroy(options);
+  spvBinaryDestroy(binary);
+}
+
+TEST(ValidationCache, DifferentLimitsUseDifferentKeys) {
+  ScopedContext ctx;
+  spv_binary binary = Assemble(ctx, kValidModule);
+
+  TestCacheStore store;
+  spv_validation_cache_t cache = MakeCache(&store);
+  spv_validator_options options = spvValidatorOptionsCreate();
+  spvValidatorOptionsSetValidationCache(options, &cache);
+
+  EXPECT_EQ(SPV_SUCCESS,
+            spvValidateWithOptions(ctx.context, options, binary, nullptr));
+  EXPECT_EQ(1u, store.keys.size());
+
+  // Changing a limit must miss the cache and record a second key.
+  spvValidatorOptionsSetUniversalLimit(
+      options, spv_validator_limit_max_function_args, 17);
+  EXPECT_EQ(SPV_SUCCESS,
+            spvValidateWithOptions(ctx.context, options, binary, nullptr));
+  EXPECT_EQ(0, store.num_hits);
+  EXPECT_EQ(2u, store.keys.size());
+
+  spvValidatorOptionsDestroy(options);
+  spvBinaryDestroy(binary);
+}
+
+TEST(ValidationCache, FailedValidationIsNotRecorded) {
+  ScopedContext ctx;
+  // Missing OpMemoryModel.
+  spv_binary binary = Assemble(ctx, "OpCapability Linkage\n");
+
+  TestCacheStore store;
+  spv_validation_cache_t cache = MakeCache(&store);
+  spv_validator_options options = spvValidatorOptionsCreate();
+  spvValidatorOptionsSetValidationCache(options, &cache);
+
+  spv_diagnostic diagnostic = nullptr;
+  EXPECT_NE(SPV_SUCCESS,
+            spvValidateWithOptions(ctx.context, options, binary, &diagnostic));
+  EXPECT_EQ(1, store.num_lookups);
+  EXPECT_EQ(0, store.num_inserts);
+  EXPECT_TRUE(store.keys.empty());
+  spvDiagnosticDestroy(diagnostic);
+
+  spvValidatorOptionsDestroy(options);
+  spvBinaryDestroy(binary);
+}
+
+TEST(ValidationCache, NoCacheValidatesNormally) {
+  ScopedContext ctx;
+  spv_binary binary = Assemble(ctx, kValidModule);
+
+  spv_validator_options options = spvValidatorOptionsCreate();
+  EXPECT_EQ(SPV_SUCCESS,
+            spvValidateWithOptions(ctx.context, options, binary, nullptr));
+
+  spvValidatorOptionsDestroy(options);
+  spvBinaryDestroy(binary);
+}
+
+}  // anonymous namespace
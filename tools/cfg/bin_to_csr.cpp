@@ -0,0 +1,195 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bin_to_csr.h"
+
+#include <cassert>
+#include <unordered_map>
+
+#include "spirv/1.2/spirv.h"
+
+namespace {
+
+const uint32_t kCsrMagic = 0x47565053u;  // "SPVG" as little-endian bytes.
+const uint32_t kCsrVersion = 1u;
+const uint32_t kUnknownBlock = 0xffffffffu;
+
+// Collects functions, basic blocks and branch edges from a single binary
+// parse, then serializes them in compressed sparse row form.  The opcode
+// handling mirrors the dot converter: a block is recorded when its
+// terminator is seen.
+class CsrCollector {
+ public:
+  explicit CsrCollector(const std::unordered_set<uint32_t>* functions)
+      : functions_(functions) {}
+
+  // Records the control flow effects of the given instruction.
+  spv_result_t HandleInstruction(const spv_parsed_instruction_t& inst);
+
+  // Appends the collected graph to the output in the documented layout.
+  void Serialize(std::vector<uint32_t>* out) const;
+
+ private:
+  struct Function {
+    uint32_t id;
+    uint32_t first_block;
+    uint32_t num_blocks;
+  };
+  struct Block {
+    uint32_t id;
+    uint32_t merge;
+    uint32_t continue_target;
+  };
+
+  // Ends processing for the current block, recording it and its successors.
+  void FlushBlock(const std::vector<uint32_t>& successors);
+
+  // The ID of the current basic block, or 0 if outside of a block.
+  uint32_t current_block_id_ = 0;
+  // Should blocks of the current function be recorded?
+  bool collect_current_function_ = true;
+  // The Id of the merge block for this block if it exists, or 0 otherwise.
+  uint32_t merge_ = 0;
+  // The Id of the continue target block for this block if it exists, or 0
+  // otherwise.
+  uint32_t continue_target_ = 0;
+
+  // When non-null and non-empty, the ids of the functions to collect.
+  const std::unordered_set<uint32_t>* functions_;
+
+  std::vector<Function> function_table_;
+  std::vector<Block> block_table_;
+  // The index of each block's first edge word; one entry per block.
+  std::vector<uint32_t> edge_offsets_;
+  // Successor block ids, mapped to block indices when serializing.
+  std::vector<uint32_t> edge_targets_;
+  // Maps a block id to its index in the block table.
+  std::unordered_map<uint32_t, uint32_t> block_index_;
+};
+
+spv_result_t CsrCollector::HandleInstruction(
+    const spv_parsed_instruction_t& inst) {
+  switch (inst.opcode) {
+    case SpvOpFunction:
+      collect_current_function_ = !functions_ || functions_->empty() ||
+                                  functions_->count(inst.result_id) != 0;
+      if (collect_current_function_) {
+        function_table_.push_back(
+            {inst.result_id, uint32_t(block_table_.size()), 0});
+      }
+      break;
+
+    case SpvOpLabel:
+      current_block_id_ = inst.result_id;
+      break;
+
+    case SpvOpBranch:
+      FlushBlock({inst.words[1]});
+      break;
+    case SpvOpBranchConditional:
+      FlushBlock({inst.words[2], inst.words[3]});
+      break;
+    case SpvOpSwitch: {
+      std::vector<uint32_t> successors{inst.words[2]};
+      for (size_t i = 3; i < inst.num_operands; i += 2) {
+        successors.push_back(inst.words[inst.operands[i].offset]);
+      }
+      FlushBlock(successors);
+    } break;
+
+    case SpvOpKill:
+    case SpvOpReturn:
+    case SpvOpUnreachable:
+    case SpvOpReturnValue:
+      FlushBlock({});
+      break;
+
+    case SpvOpLoopMerge:
+      merge_ = inst.words[1];
+      continue_target_ = inst.words[2];
+      break;
+    case SpvOpSelectionMerge:
+      merge_ = inst.words[1];
+      break;
+    default:
+      break;
+  }
+  return SPV_SUCCESS;
+}
+
+void CsrCollector::FlushBlock(const std::vector<uint32_t>& successors) {
+  if (collect_current_function_) {
+    block_index_[current_block_id_] = uint32_t(block_table_.size());
+    block_table_.push_back({current_block_id_, merge_, continue_target_});
+    edge_offsets_.push_back(uint32_t(edge_targets_.size()));
+    edge_targets_.insert(edge_targets_.end(), successors.begin(),
+                         successors.end());
+    assert(!function_table_.empty());
+    ++function_table_.back().num_blocks;
+  }
+  merge_ = 0;
+  continue_target_ = 0;
+}
+
+void CsrCollector::Serialize(std::vector<uint32_t>* out) const {
+  out->reserve(out->size() + 5 + 3 * function_table_.size() +
+               4 * block_table_.size() + edge_targets_.size() + 1);
+  out->push_back(kCsrMagic);
+  out->push_back(kCsrVersion);
+  out->push_back(uint32_t(function_table_.size()));
+  out->push_back(uint32_t(block_table_.size()));
+  out->push_back(uint32_t(edge_targets_.size()));
+  for (const Function& fn : function_table_) {
+    out->push_back(fn.id);
+    out->push_back(fn.first_block);
+    out->push_back(fn.num_blocks);
+  }
+  for (const Block& block : block_table_) {
+    out->push_back(block.id);
+    out->push_back(block.merge);
+    out->push_back(block.continue_target);
+  }
+  out->insert(out->end(), edge_offsets_.begin(), edge_offsets_.end());
+  out->push_back(uint32_t(edge_targets_.size()));
+  for (uint32_t target_id : edge_targets_) {
+    const auto where = block_index_.find(target_id);
+    out->push_back(where == block_index_.end() ? kUnknownBlock
+                                               : where->second);
+  }
+}
+
+spv_result_t HandleInstruction(
+    void* user_data, const spv_parsed_instruction_t* parsed_instruction) {
+  assert(user_data);
+  auto collector = static_cast<CsrCollector*>(user_data);
+  return collector->HandleInstruction(*parsed_instruction);
+}
+
+}  // anonymous namespace
+
+spv_result_t BinaryToCsr(const spv_const_context context, const uint32_t* words,
+                         size_t num_words,
+                         const std::unordered_set<uint32_t>* functions,
+                         std::vector<uint32_t>* out,
+                         spv_diagnostic* diagnostic) {
+  if (!diagnostic) return SPV_ERROR_INVALID_DIAGNOSTIC;
+
+  CsrCollector collector(functions);
+  if (auto error = spvBinaryParse(context, &collector, words, num_words,
+                                  nullptr, HandleInstruction, diagnostic)) {
+    return error;
+  }
+  collector.Serialize(out);
+  return SPV_SUCCESS;
+}
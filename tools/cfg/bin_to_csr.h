@@ -0,0 +1,57 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BIN_TO_CSR_H_
+#define BIN_TO_CSR_H_
+
+#include <unordered_set>
+#include <vector>
+
+#include "spirv-tools/libspirv.h"
+
+// Appends a compact binary encoding of the module's control flow graph to
+// out, suitable for memory-mapping by analysis tools that would otherwise
+// have to parse dot text.  All quantities are 32-bit words in host order:
+//
+//   word 0   magic number 0x47565053 ("SPVG" as bytes, little-endian)
+//   word 1   format version, currently 1
+//   word 2   number of functions
+//   word 3   number of basic blocks
+//   word 4   number of edges
+//
+//   Function table: three words per function, in module order:
+//   {function id, index of its first block, number of blocks}.  The blocks
+//   of one function are contiguous in the block table.
+//
+//   Block table: three words per block, in module order:
+//   {block id, merge block id or 0, continue target id or 0}.
+//
+//   Edge offsets: one word per block, plus a final sentinel equal to the
+//   number of edges.  The successors of block i are the edge words in
+//   [offsets[i], offsets[i+1]) -- compressed sparse row adjacency.
+//
+//   Edge words: the index of the successor block in the block table, not
+//   its id, so a consumer can walk the graph without an id lookup.
+//   0xffffffff marks a target with no block record (only possible in a
+//   malformed module).
+//
+// When functions is non-null and non-empty, only the listed function ids
+// contribute blocks and edges.  Returns SPV_SUCCESS on success.
+spv_result_t BinaryToCsr(const spv_const_context context, const uint32_t* words,
+                         size_t num_words,
+                         const std::unordered_set<uint32_t>* functions,
+                         std::vector<uint32_t>* out,
+                         spv_diagnostic* diagnostic);
+
+#endif // BIN_TO_CSR_H_
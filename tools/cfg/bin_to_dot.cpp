@@ -15,7 +15,6 @@
 #include "bin_to_dot.h"
 
 #include <cassert>
-#include <iostream>
 #include <utility>
 #include <vector>
 
@@ -27,28 +26,44 @@ namespace {
 const char* kMergeStyle = "style=dashed";
 const char* kContinueStyle = "style=dotted";
 
+// Appends the decimal representation of the given value to the output.
+void AppendUnsigned(uint32_t value, std::string* out) {
+  char digits[10];  // Enough for 2**32 - 1.
+  size_t pos = sizeof(digits);
+  do {
+    digits[--pos] = char('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  out->append(digits + pos, sizeof(digits) - pos);
+}
+
 // A DotConverter can be used to dump the GraphViz "dot" graph for
 // a SPIR-V module.
 class DotConverter {
  public:
-  DotConverter(libspirv::NameMapper name_mapper, std::iostream* out)
-      : name_mapper_(std::move(name_mapper)), out_(*out) {}
+  DotConverter(libspirv::NameMapper name_mapper,
+               const std::unordered_set<uint32_t>* functions, std::string* out)
+      : name_mapper_(std::move(name_mapper)),
+        functions_(functions),
+        out_(*out) {}
 
   // Emits the graph preamble.
   void Begin() const {
-    out_ << "digraph {\n";
+    out_ += "digraph {\n";
     // Emit a simple legend
-    out_ << "legend_merge_src [shape=plaintext, label=\"\"];\n"
-         << "legend_merge_dest [shape=plaintext, label=\"\"];\n"
-         << "legend_merge_src -> legend_merge_dest [label=\" merge\","
-         << kMergeStyle << "];\n"
-         << "legend_continue_src [shape=plaintext, label=\"\"];\n"
-         << "legend_continue_dest [shape=plaintext, label=\"\"];\n"
-         << "legend_continue_src -> legend_continue_dest [label=\" continue\","
-         << kContinueStyle << "];\n";
+    out_ += "legend_merge_src [shape=plaintext, label=\"\"];\n";
+    out_ += "legend_merge_dest [shape=plaintext, label=\"\"];\n";
+    out_ += "legend_merge_src -> legend_merge_dest [label=\" merge\",";
+    out_ += kMergeStyle;
+    out_ += "];\n";
+    out_ += "legend_continue_src [shape=plaintext, label=\"\"];\n";
+    out_ += "legend_continue_dest [shape=plaintext, label=\"\"];\n";
+    out_ += "legend_continue_src -> legend_continue_dest [label=\" continue\",";
+    out_ += kContinueStyle;
+    out_ += "];\n";
   }
   // Emits the graph postamble.
-  void End() const { out_ << "}\n"; }
+  void End() const { out_ += "}\n"; }
 
   // Emits the Dot commands for the given instruction.
   spv_result_t HandleInstruction(const spv_parsed_instruction_t& inst);
@@ -66,6 +81,9 @@ class DotConverter {
   // Have we completed processing for the entry block to this fuction?
   bool seen_function_entry_block_ = false;
 
+  // Should blocks of the current function produce any output?
+  bool emit_current_function_ = true;
+
   // The Id of the merge block for this block if it exists, or 0 otherwise.
   uint32_t merge_ = 0;
   // The Id of the continue target block for this block if it exists, or 0
@@ -75,8 +93,11 @@ class DotConverter {
   // An object for mapping Ids to names.
   libspirv::NameMapper name_mapper_;
 
-  // The output stream.
-  std::ostream& out_;
+  // When non-null and non-empty, the ids of the functions to emit.
+  const std::unordered_set<uint32_t>* functions_;
+
+  // The output buffer.
+  std::string& out_;
 };
 
 spv_result_t DotConverter::HandleInstruction(
@@ -85,6 +106,8 @@ spv_result_t DotConverter::HandleInstruction(
     case SpvOpFunction:
       current_function_id_ = inst.result_id;
       seen_function_entry_block_ = false;
+      emit_current_function_ = !functions_ || functions_->empty() ||
+                               functions_->count(inst.result_id) != 0;
       break;
     case SpvOpFunctionEnd:
       current_function_id_ = 0;
@@ -129,25 +152,49 @@ spv_result_t DotConverter::HandleInstruction(
 }
 
 void DotConverter::FlushBlock(const std::vector<uint32_t>& successors) {
-  out_ << current_block_id_;
+  if (!emit_current_function_) {
+    // Keep the block book-keeping in step even when producing no output.
+    seen_function_entry_block_ = true;
+    merge_ = 0;
+    continue_target_ = 0;
+    return;
+  }
+
+  AppendUnsigned(current_block_id_, &out_);
   if (!seen_function_entry_block_) {
-    out_ << " [label=\"" << name_mapper_(current_block_id_) << "\nFn "
-         << name_mapper_(current_function_id_) << " entry\", shape=box];\n";
+    out_ += " [label=\"";
+    out_ += name_mapper_(current_block_id_);
+    out_ += "\nFn ";
+    out_ += name_mapper_(current_function_id_);
+    out_ += " entry\", shape=box];\n";
   } else {
-    out_ << " [label=\"" << name_mapper_(current_block_id_) << "\"];\n";
+    out_ += " [label=\"";
+    out_ += name_mapper_(current_block_id_);
+    out_ += "\"];\n";
   }
 
   for (auto successor : successors) {
-    out_ << current_block_id_ << " -> " << successor << ";\n";
+    AppendUnsigned(current_block_id_, &out_);
+    out_ += " -> ";
+    AppendUnsigned(successor, &out_);
+    out_ += ";\n";
   }
 
   if (merge_) {
-    out_ << current_block_id_ << " -> " << merge_ << " [" << kMergeStyle
-         << "];\n";
+    AppendUnsigned(current_block_id_, &out_);
+    out_ += " -> ";
+    AppendUnsigned(merge_, &out_);
+    out_ += " [";
+    out_ += kMergeStyle;
+    out_ += "];\n";
   }
   if (continue_target_) {
-    out_ << current_block_id_ << " -> " << continue_target_ << " ["
-         << kContinueStyle << "];\n";
+    AppendUnsigned(current_block_id_, &out_);
+    out_ += " -> ";
+    AppendUnsigned(continue_target_, &out_);
+    out_ += " [";
+    out_ += kContinueStyle;
+    out_ += "];\n";
   }
 
   // Reset the book-keeping for a block.
@@ -166,16 +213,20 @@ spv_result_t HandleInstruction(
 }  // anonymous namespace
 
 spv_result_t BinaryToDot(const spv_const_context context, const uint32_t* words,
-                         size_t num_words, std::iostream* out,
-                         spv_diagnostic* diagnostic) {
+                         size_t num_words,
+                         const std::unordered_set<uint32_t>* functions,
+                         std::string* out, spv_diagnostic* diagnostic) {
   // Invalid arguments return error codes, but don't necessarily generate
   // diagnostics.  These are programmer errors, not user errors.
   if (!diagnostic) return SPV_ERROR_INVALID_DIAGNOSTIC;
   const libspirv::AssemblyGrammar grammar(context);
   if (!grammar.isValid()) return SPV_ERROR_INVALID_TABLE;
 
+  // Dot output runs a few characters per input word.
+  out->reserve(out->size() + num_words * 4 + 512);
+
   libspirv::FriendlyNameMapper friendly_mapper(context, words, num_words);
-  DotConverter converter(friendly_mapper.GetNameMapper(), out);
+  DotConverter converter(friendly_mapper.GetNameMapper(), functions, out);
   converter.Begin();
   if (auto error = spvBinaryParse(context, &converter, words, num_words,
                                   nullptr, HandleInstruction, diagnostic)) {
@@ -15,13 +15,19 @@
 #ifndef BIN_TO_DOT_H_
 #define BIN_TO_DOT_H_
 
-#include <iostream>
+#include <string>
+#include <unordered_set>
+
 #include "spirv-tools/libspirv.h"
 
-// Dumps the control flow graph for the given module to the output stream.
-// Returns SPV_SUCCESS on succes.
+// Appends the GraphViz "dot" form of the module's control flow graph to
+// out.  The text accumulates in a single string buffer sized up front, so
+// large modules do not pay for per-token stream formatting.  When functions
+// is non-null and non-empty, only blocks belonging to the listed function
+// ids are emitted.  Returns SPV_SUCCESS on succes.
 spv_result_t BinaryToDot(const spv_const_context context, const uint32_t* words,
-                         size_t num_words, std::iostream* out,
-                         spv_diagnostic* diagnostic);
+                         size_t num_words,
+                         const std::unordered_set<uint32_t>* functions,
+                         std::string* out, spv_diagnostic* diagnostic);
 
 #endif // BIN_TO_DOT_H_
@@ -13,14 +13,16 @@
 // limitations under the License.
 
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
-#include <sstream>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "spirv-tools/libspirv.h"
 #include "tools/io.h"
 
+#include "bin_to_csr.h"
 #include "bin_to_dot.h"
 
 // Prints a program usage message to stdout.
@@ -41,6 +43,14 @@ Options:
   -o <filename>   Set the output filename.
                   Output goes to standard output if this option is
                   not specified, or if the filename is "-".
+
+  --function <id> Only emit the function with the given result id.
+                  May be repeated to select several functions.
+
+  --binary        Emit a compact binary graph instead of dot text:
+                  CSR adjacency plus block metadata, as 32-bit words.
+                  Analysis tools can map the file directly rather than
+                  parse dot.  See tools/cfg/bin_to_csr.h for the layout.
 )",
       argv0, argv0);
 }
@@ -50,6 +60,8 @@ static const auto kDefaultEnvironment = SPV_ENV_UNIVERSAL_1_2;
 int main(int argc, char** argv) {
   const char* inFile = nullptr;
   const char* outFile = nullptr; // Stays nullptr if printing to stdout.
+  std::unordered_set<uint32_t> functions;
+  bool binary_output = false;
 
   for (int argi = 1; argi < argc; ++argi) {
     if ('-' == argv[argi][0]) {
@@ -67,7 +79,23 @@ int main(int argc, char** argv) {
         } break;
         case '-': {
           // Long options
-          if (0 == strcmp(argv[argi], "--help")) {
+          if (0 == strcmp(argv[argi], "--function")) {
+            if (argi + 1 < argc) {
+              char* end = nullptr;
+              const unsigned long id = strtoul(argv[++argi], &end, 10);
+              if (!end || *end != 0 || id == 0 || id > 0xffffffffu) {
+                fprintf(stderr, "error: Invalid function id: %s\n",
+                        argv[argi]);
+                return 1;
+              }
+              functions.insert(uint32_t(id));
+            } else {
+              print_usage(argv[0]);
+              return 1;
+            }
+          } else if (0 == strcmp(argv[argi], "--binary")) {
+            binary_output = true;
+          } else if (0 == strcmp(argv[argi], "--help")) {
             print_usage(argv[0]);
             return 0;
           } else if (0 == strcmp(argv[argi], "--version")) {
@@ -109,16 +137,29 @@ int main(int argc, char** argv) {
   spv_context context = spvContextCreate(kDefaultEnvironment);
   spv_diagnostic diagnostic = nullptr;
 
-  std::stringstream ss;
-  auto error = BinaryToDot(context, contents.data(), contents.size(), &ss, &diagnostic);
-  if (error) {
-    spvDiagnosticPrint(diagnostic);
-    spvDiagnosticDestroy(diagnostic);
-    spvContextDestroy(context);
-    return error;
+  if (binary_output) {
+    std::vector<uint32_t> graph;
+    auto error = BinaryToCsr(context, contents.data(), contents.size(),
+                             &functions, &graph, &diagnostic);
+    if (error) {
+      spvDiagnosticPrint(diagnostic);
+      spvDiagnosticDestroy(diagnostic);
+      spvContextDestroy(context);
+      return error;
+    }
+    WriteFile(outFile, "wb", graph.data(), graph.size());
+  } else {
+    std::string str;
+    auto error = BinaryToDot(context, contents.data(), contents.size(),
+                             &functions, &str, &diagnostic);
+    if (error) {
+      spvDiagnosticPrint(diagnostic);
+      spvDiagnosticDestroy(diagnostic);
+      spvContextDestroy(context);
+      return error;
+    }
+    WriteFile(outFile, "w", str.data(), str.size());
   }
-  std::string str = ss.str();
-  WriteFile(outFile, "w", str.data(), str.size());
 
   spvDiagnosticDestroy(diagnostic);
   spvContextDestroy(context);
@@ -0,0 +1,125 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "source/spirv_compression.h"
+#include "spirv-tools/libspirv.h"
+#include "tools/io.h"
+
+void print_usage(char* argv0) {
+  printf(
+      R"(%s - Decompress a module compressed by spirv-encode
+
+Usage: %s [options] [<filename>]
+
+The compressed module is read from <filename>.  If no file is specified,
+or if the filename is "-", then it is read from standard input.
+The SPIR-V binary module is written to file "out.spv", unless the -o option
+is used.
+
+Options:
+
+  -h, --help      Print this help.
+
+  -o <filename>   Set the output filename. Use '-' to mean stdout.
+  --version       Display decoder version information.
+)",
+      argv0, argv0);
+}
+
+static const auto kDefaultEnvironment = SPV_ENV_UNIVERSAL_1_2;
+
+int main(int argc, char** argv) {
+  const char* inFile = nullptr;
+  const char* outFile = nullptr;
+  for (int argi = 1; argi < argc; ++argi) {
+    if ('-' == argv[argi][0]) {
+      switch (argv[argi][1]) {
+        case 'h': {
+          print_usage(argv[0]);
+          return 0;
+        }
+        case 'o': {
+          if (!outFile && argi + 1 < argc) {
+            outFile = argv[++argi];
+          } else {
+            print_usage(argv[0]);
+            return 1;
+          }
+        } break;
+        case 0: {
+          // Setting a filename of "-" to indicate stdin.
+          if (!inFile) {
+            inFile = argv[argi];
+          } else {
+            fprintf(stderr, "error: More than one input file specified\n");
+            return 1;
+          }
+        } break;
+        case '-': {
+          // Long options
+          if (0 == strcmp(argv[argi], "--version")) {
+            printf("%s\n", spvSoftwareVersionDetailsString());
+            printf("Target: %s\n",
+                   spvTargetEnvDescription(kDefaultEnvironment));
+            return 0;
+          }
+          if (0 == strcmp(argv[argi], "--help")) {
+            print_usage(argv[0]);
+            return 0;
+          }
+        } break;
+        default:
+          print_usage(argv[0]);
+          return 1;
+      }
+    } else {
+      if (!inFile) {
+        inFile = argv[argi];
+      } else {
+        fprintf(stderr, "error: More than one input file specified\n");
+        return 1;
+      }
+    }
+  }
+
+  if (!outFile) {
+    outFile = "out.spv";
+  }
+
+  // Read the compressed input, memory-mapping it when possible.
+  MappedInput<uint8_t> contents;
+  if (!contents.Read(inFile)) return 1;
+
+  std::vector<uint32_t> words;
+  spv_diagnostic diagnostic = nullptr;
+  spv_context context = spvContextCreate(kDefaultEnvironment);
+  spv_result_t error = libspirv::SpirvDecompress(
+      *context, contents.data(), contents.size(), &words, &diagnostic);
+  spvContextDestroy(context);
+  if (error) {
+    spvDiagnosticPrint(diagnostic);
+    spvDiagnosticDestroy(diagnostic);
+    return error;
+  }
+
+  if (!WriteFile<uint32_t>(outFile, "wb", words.data(), words.size())) {
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,403 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "source/opcode.h"
+#include "source/operand.h"
+#include "spirv-tools/libspirv.h"
+#include "spirv-tools/libspirv.hpp"
+#include "spirv/1.2/spirv.h"
+#include "tools/io.h"
+
+namespace {
+
+// Exit codes follow the diff/cmp convention.
+const int kExitSame = 0;
+const int kExitDifferent = 1;
+const int kExitError = 2;
+
+void PrintUsage(const char* program) {
+  printf(
+      R"(%s - Compare two SPIR-V binary files semantically.
+
+USAGE: %s [options] <baseline> <updated>
+
+Both inputs are SPIR-V binaries; "-" reads that input from standard
+input. The modules are compared directly on their binaries: functions
+are matched by an id-normalized, debug-insensitive content hash, so id
+renumbering and line info produce no differences, and changed functions
+are aligned instruction by instruction rather than textually.
+
+The exit status is 0 when the modules are semantically identical, 1 when
+differences are found, and 2 on error.
+
+Options:
+  -q, --quiet  Report only through the exit status.
+  -h, --help   Print this help.
+  --version    Display diff tool version information.
+)",
+      program, program);
+}
+
+struct ScopedContext {
+  ScopedContext(spv_target_env env) : context(spvContextCreate(env)) {}
+  ~ScopedContext() { spvContextDestroy(context); }
+  spv_context context;
+};
+
+// Returns true for instructions that carry only debug information.
+bool IsDebugOpcode(uint16_t opcode) {
+  return (opcode >= SpvOpSourceContinued && opcode <= SpvOpLine) ||
+         opcode == SpvOpNoLine || opcode == SpvOpModuleProcessed;
+}
+
+// One instruction's alignment key: the opcode, all non-id words, and each
+// id operand replaced by its first-use index within the instruction.  Keys
+// are insensitive to id renumbering but still distinguish structure.
+uint64_t StructuralKey(const spv_parsed_instruction_t* inst) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  const auto mix = [&hash](uint32_t word) {
+    hash = (hash ^ word) * 0x100000001b3ull;
+  };
+  mix(inst->opcode);
+  std::unordered_map<uint32_t, uint32_t> local_ids;
+  for (uint16_t i = 0; i < inst->num_operands; ++i) {
+    const spv_parsed_operand_t& operand = inst->operands[i];
+    if (spvIsIdType(operand.type)) {
+      const uint32_t id = inst->words[operand.offset];
+      const auto insertion =
+          local_ids.insert({id, static_cast<uint32_t>(local_ids.size() + 1)});
+      mix(insertion.first->second);
+    } else {
+      for (uint16_t w = 0; w < operand.num_words; ++w) {
+        mix(inst->words[operand.offset + w]);
+      }
+    }
+  }
+  return hash;
+}
+
+// What the parse below collects about one module.
+struct ModuleSummary {
+  // Friendly names from OpName, keyed by id.
+  std::map<uint32_t, std::string> names;
+  // Alignment keys of the instructions of each function, in module order.
+  std::vector<std::vector<uint64_t>> function_keys;
+  // Opcodes matching function_keys, for reporting.
+  std::vector<std::vector<uint16_t>> function_opcodes;
+  // Alignment key -> occurrence count for module-level (non-function,
+  // non-debug) instructions.
+  std::map<uint64_t, int> global_keys;
+  // Opcode of one representative instruction per global key.
+  std::map<uint64_t, uint16_t> global_opcodes;
+
+  bool in_function = false;
+};
+
+spv_result_t SummarizeInstruction(void* user_data,
+                                  const spv_parsed_instruction_t* inst) {
+  auto* summary = static_cast<ModuleSummary*>(user_data);
+  const uint16_t opcode = inst->opcode;
+  if (opcode == SpvOpName) {
+    const char* name = reinterpret_cast<const char*>(&inst->words[2]);
+    summary->names[inst->words[1]] = name;
+  }
+  if (opcode == SpvOpFunction) {
+    summary->in_function = true;
+    summary->function_keys.emplace_back();
+    summary->function_opcodes.emplace_back();
+  }
+  if (IsDebugOpcode(opcode)) return SPV_SUCCESS;
+  if (summary->in_function) {
+    summary->function_keys.back().push_back(StructuralKey(inst));
+    summary->function_opcodes.back().push_back(opcode);
+  } else {
+    const uint64_t key = StructuralKey(inst);
+    ++summary->global_keys[key];
+    summary->global_opcodes[key] = opcode;
+  }
+  if (opcode == SpvOpFunctionEnd) summary->in_function = false;
+  return SPV_SUCCESS;
+}
+
+// Returns a printable label for the function at |index|: its result id,
+// plus its OpName when the module has one.
+std::string FunctionLabel(const ModuleSummary& summary,
+                          const spv_function_index index, size_t i) {
+  const uint32_t id = index->functions[i].id;
+  std::string label = "%" + std::to_string(id);
+  const auto name = summary.names.find(id);
+  if (name != summary.names.end()) label += " \"" + name->second + "\"";
+  return label;
+}
+
+// Prints a line-based diff of two key sequences, labelling each line with
+// the instruction's opcode.  Uses a longest-common-subsequence alignment
+// after trimming the common prefix and suffix; when the remaining middle is
+// too large for that, falls back to counting.  Returns the number of
+// differing instructions.
+int DiffInstructions(const std::vector<uint64_t>& base_keys,
+                     const std::vector<uint16_t>& base_ops,
+                     const std::vector<uint64_t>& updated_keys,
+                     const std::vector<uint16_t>& updated_ops, bool quiet) {
+  size_t prefix = 0;
+  while (prefix < base_keys.size() && prefix < updated_keys.size() &&
+         base_keys[prefix] == updated_keys[prefix]) {
+    ++prefix;
+  }
+  size_t base_end = base_keys.size(), updated_end = updated_keys.size();
+  while (base_end > prefix && updated_end > prefix &&
+         base_keys[base_end - 1] == updated_keys[updated_end - 1]) {
+    --base_end;
+    --updated_end;
+  }
+  const size_t n = base_end - prefix, m = updated_end - prefix;
+  if (n * m > (size_t(1) << 24)) {
+    // Too large to align exactly; every middle instruction counts as
+    // changed.
+    if (!quiet) {
+      printf("    (bodies differ in %zu vs %zu instructions; too large to "
+             "align)\n",
+             n, m);
+    }
+    return static_cast<int>(n + m);
+  }
+
+  // lcs[i][j]: length of the longest common subsequence of the first i
+  // middle instructions of the baseline and the first j of the update.
+  std::vector<std::vector<uint32_t>> lcs(n + 1,
+                                         std::vector<uint32_t>(m + 1, 0));
+  for (size_t i = 1; i <= n; ++i) {
+    for (size_t j = 1; j <= m; ++j) {
+      if (base_keys[prefix + i - 1] == updated_keys[prefix + j - 1]) {
+        lcs[i][j] = lcs[i - 1][j - 1] + 1;
+      } else {
+        lcs[i][j] = std::max(lcs[i - 1][j], lcs[i][j - 1]);
+      }
+    }
+  }
+  // Walk back through the table, collecting the edit script in reverse.
+  std::vector<std::pair<char, uint16_t>> edits;  // {'-' or '+', opcode}
+  size_t i = n, j = m;
+  while (i > 0 || j > 0) {
+    if (i > 0 && j > 0 &&
+        base_keys[prefix + i - 1] == updated_keys[prefix + j - 1]) {
+      --i;
+      --j;
+    } else if (j > 0 && (i == 0 || lcs[i][j - 1] >= lcs[i - 1][j])) {
+      edits.push_back({'+', updated_ops[prefix + --j]});
+    } else {
+      edits.push_back({'-', base_ops[prefix + --i]});
+    }
+  }
+  if (!quiet) {
+    for (auto it = edits.rbegin(); it != edits.rend(); ++it) {
+      printf("    %c %s\n", it->first,
+             spvOpcodeString(static_cast<SpvOp>(it->second)));
+    }
+  }
+  return static_cast<int>(edits.size());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const char* base_file = nullptr;
+  const char* updated_file = nullptr;
+  bool quiet = false;
+
+  for (int argi = 1; argi < argc; ++argi) {
+    const char* cur_arg = argv[argi];
+    if ('-' == cur_arg[0] && '\0' != cur_arg[1]) {
+      if (0 == strcmp(cur_arg, "--version")) {
+        printf("%s\n", spvSoftwareVersionDetailsString());
+        return kExitSame;
+      } else if (0 == strcmp(cur_arg, "--help") || 0 == strcmp(cur_arg, "-h")) {
+        PrintUsage(argv[0]);
+        return kExitSame;
+      } else if (0 == strcmp(cur_arg, "--quiet") || 0 == strcmp(cur_arg, "-q")) {
+        quiet = true;
+      } else {
+        PrintUsage(argv[0]);
+        return kExitError;
+      }
+    } else if (!base_file) {
+      base_file = cur_arg;
+    } else if (!updated_file) {
+      updated_file = cur_arg;
+    } else {
+      fprintf(stderr, "error: More than two input files specified\n");
+      return kExitError;
+    }
+  }
+  if (!base_file || !updated_file) {
+    PrintUsage(argv[0]);
+    return kExitError;
+  }
+
+  MappedInput<uint32_t> base_binary, updated_binary;
+  if (!base_binary.Read(base_file)) return kExitError;
+  if (!updated_binary.Read(updated_file)) return kExitError;
+
+  ScopedContext ctx(SPV_ENV_UNIVERSAL_1_2);
+  spvtools::SpirvTools tools(SPV_ENV_UNIVERSAL_1_2);
+
+  // Parse both modules once for names, global instructions and the
+  // per-instruction alignment keys of every function.
+  ModuleSummary base, updated;
+  spv_diagnostic diagnostic = nullptr;
+  if (spvBinaryParse(ctx.context, &base, base_binary.data(),
+                     base_binary.size(), nullptr, SummarizeInstruction,
+                     &diagnostic) != SPV_SUCCESS ||
+      spvBinaryParse(ctx.context, &updated, updated_binary.data(),
+                     updated_binary.size(), nullptr, SummarizeInstruction,
+                     &diagnostic) != SPV_SUCCESS) {
+    spvDiagnosticPrint(diagnostic);
+    spvDiagnosticDestroy(diagnostic);
+    return kExitError;
+  }
+
+  // Function content hashes and offsets, both in module order.
+  std::vector<spvtools::FunctionHash> base_hashes, updated_hashes;
+  spv_function_index base_index = nullptr, updated_index = nullptr;
+  if (!tools.ComputeFunctionHashes(base_binary.data(), base_binary.size(),
+                                   &base_hashes) ||
+      !tools.ComputeFunctionHashes(updated_binary.data(),
+                                   updated_binary.size(), &updated_hashes) ||
+      spvBinaryBuildFunctionIndex(ctx.context, base_binary.data(),
+                                  base_binary.size(), &base_index,
+                                  nullptr) != SPV_SUCCESS ||
+      spvBinaryBuildFunctionIndex(ctx.context, updated_binary.data(),
+                                  updated_binary.size(), &updated_index,
+                                  nullptr) != SPV_SUCCESS) {
+    spvFunctionIndexDestroy(base_index);
+    spvFunctionIndexDestroy(updated_index);
+    return kExitError;
+  }
+
+  int differences = 0;
+
+  // Module-level instructions: compare the key multisets.
+  for (const auto& entry : base.global_keys) {
+    const auto other = updated.global_keys.find(entry.first);
+    const int removed =
+        entry.second - (other == updated.global_keys.end() ? 0 : other->second);
+    for (int k = 0; k < removed; ++k) {
+      if (!quiet) {
+        printf("module: - %s\n",
+               spvOpcodeString(static_cast<SpvOp>(
+                   base.global_opcodes[entry.first])));
+      }
+      ++differences;
+    }
+  }
+  for (const auto& entry : updated.global_keys) {
+    const auto other = base.global_keys.find(entry.first);
+    const int added =
+        entry.second - (other == base.global_keys.end() ? 0 : other->second);
+    for (int k = 0; k < added; ++k) {
+      if (!quiet) {
+        printf("module: + %s\n",
+               spvOpcodeString(static_cast<SpvOp>(
+                   updated.global_opcodes[entry.first])));
+      }
+      ++differences;
+    }
+  }
+
+  // Hash-join the functions: equal content hashes pair up as unchanged,
+  // regardless of position or id numbering.
+  std::multimap<uint64_t, size_t> base_by_hash;
+  for (size_t i = 0; i < base_hashes.size(); ++i) {
+    base_by_hash.insert({base_hashes[i].hash, i});
+  }
+  std::vector<bool> base_matched(base_hashes.size(), false);
+  std::vector<size_t> updated_unmatched;
+  for (size_t i = 0; i < updated_hashes.size(); ++i) {
+    const auto match = base_by_hash.find(updated_hashes[i].hash);
+    if (match != base_by_hash.end()) {
+      base_matched[match->second] = true;
+      base_by_hash.erase(match);
+    } else {
+      updated_unmatched.push_back(i);
+    }
+  }
+  std::vector<size_t> base_unmatched;
+  for (size_t i = 0; i < base_hashes.size(); ++i) {
+    if (!base_matched[i]) base_unmatched.push_back(i);
+  }
+
+  // Pair the leftovers by OpName when both sides know the name, so a
+  // changed function reports as a change rather than a remove/add pair.
+  std::map<std::string, size_t> updated_by_name;
+  for (const size_t i : updated_unmatched) {
+    const auto name = updated.names.find(updated_index->functions[i].id);
+    if (name != updated.names.end()) updated_by_name[name->second] = i;
+  }
+  std::vector<bool> updated_paired(updated_hashes.size(), false);
+  for (const size_t bi : base_unmatched) {
+    const auto name = base.names.find(base_index->functions[bi].id);
+    size_t ui = 0;
+    bool paired = false;
+    if (name != base.names.end()) {
+      const auto match = updated_by_name.find(name->second);
+      if (match != updated_by_name.end() && !updated_paired[match->second]) {
+        ui = match->second;
+        paired = true;
+      }
+    }
+    if (paired) {
+      updated_paired[ui] = true;
+      if (!quiet) {
+        printf("function %s: changed\n",
+               FunctionLabel(base, base_index, bi).c_str());
+      }
+      differences +=
+          DiffInstructions(base.function_keys[bi], base.function_opcodes[bi],
+                           updated.function_keys[ui],
+                           updated.function_opcodes[ui], quiet);
+      // Structurally identical bodies can still differ in how operands
+      // refer to earlier results; the content hash catches that.
+      if (base.function_keys[bi] == updated.function_keys[ui]) {
+        if (!quiet) printf("    (operand references changed)\n");
+        ++differences;
+      }
+    } else {
+      if (!quiet) {
+        printf("function %s: removed\n",
+               FunctionLabel(base, base_index, bi).c_str());
+      }
+      ++differences;
+    }
+  }
+  for (const size_t ui : updated_unmatched) {
+    if (updated_paired[ui]) continue;
+    if (!quiet) {
+      printf("function %s: added\n",
+             FunctionLabel(updated, updated_index, ui).c_str());
+    }
+    ++differences;
+  }
+
+  spvFunctionIndexDestroy(base_index);
+  spvFunctionIndexDestroy(updated_index);
+  return differences ? kExitDifferent : kExitSame;
+}
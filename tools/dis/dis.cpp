@@ -46,8 +46,17 @@ Options:
   --no-header     Don't output the header as leading comments.
 
   --raw-id        Show raw Id values instead of friendly names.
+                  Ids print as plain numbers with no name mapping at
+                  all, which is noticeably faster on large modules.
+                  With input from standard input and output to standard
+                  output, this also makes the disassembler print each
+                  instruction as soon as it is read, so a pipeline does
+                  not wait for the whole module.
 
   --offsets       Show byte offsets for each instruction.
+
+  --parallel      Disassemble function bodies on multiple threads.
+                  Ignored when printing to standard output.
 )",
       argv0, argv0);
 }
@@ -66,6 +75,7 @@ int main(int argc, char** argv) {
   bool show_byte_offsets = false;
   bool no_header = false;
   bool friendly_names = true;
+  bool parallel = false;
 
   for (int argi = 1; argi < argc; ++argi) {
     if ('-' == argv[argi][0]) {
@@ -93,6 +103,8 @@ int main(int argc, char** argv) {
             no_header = true;
           } else if (0 == strcmp(argv[argi], "--raw-id")) {
             friendly_names = false;
+          } else if (0 == strcmp(argv[argi], "--parallel")) {
+            parallel = true;
           } else if (0 == strcmp(argv[argi], "--help")) {
             print_usage(argv[0]);
             return 0;
@@ -137,7 +149,14 @@ int main(int argc, char** argv) {
 
   if (no_header) options |= SPV_BINARY_TO_TEXT_OPTION_NO_HEADER;
 
-  if (friendly_names) options |= SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES;
+  // With --raw-id, skip name mapping entirely rather than just falling back
+  // to the trivial mapper: the output is the same, minus the mapper cost.
+  if (friendly_names)
+    options |= SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES;
+  else
+    options |= SPV_BINARY_TO_TEXT_OPTION_RAW_IDS;
+
+  if (parallel) options |= SPV_BINARY_TO_TEXT_OPTION_PARALLEL;
 
   if (!outFile || (0 == strcmp("-", outFile))) {
     // Print to standard output.
@@ -147,9 +166,60 @@ int main(int argc, char** argv) {
     }
   }
 
-  // Read the input binary.
-  std::vector<uint32_t> contents;
-  if (!ReadFile<uint32_t>(inFile, "rb", &contents)) return 1;
+  const bool print_to_stdout = SPV_BINARY_TO_TEXT_OPTION_PRINT & options;
+  const bool read_from_stdin = !inFile || 0 == strcmp("-", inFile);
+
+  // When both ends are pipes and no option needs the whole module up
+  // front, disassemble in streaming mode: read standard input in chunks
+  // and print each instruction as soon as its words have arrived, so this
+  // stage of a pipeline overlaps with the stage producing the binary.
+  // Friendly names need a whole-module pre-pass, so this only applies
+  // with --raw-id.
+  if (read_from_stdin && print_to_stdout && !friendly_names && !parallel) {
+    spv_context context = spvContextCreate(kDefaultEnvironment);
+    spv_streaming_disassembler stream =
+        spvStreamingDisassemblerCreate(context, options);
+    if (!stream) {
+      fprintf(stderr, "error: could not create disassembler\n");
+      spvContextDestroy(context);
+      return 1;
+    }
+    std::vector<uint32_t> binary;
+    spv_diagnostic diagnostic = nullptr;
+    spv_result_t error = SPV_SUCCESS;
+    uint32_t buf[4096];
+    while (size_t len = fread(buf, sizeof(uint32_t), 4096, stdin)) {
+      binary.insert(binary.end(), buf, buf + len);
+      error = spvStreamingDisassemblerParse(stream, binary.data(),
+                                            binary.size(), false, &diagnostic);
+      if (error) break;
+      // Push the text of complete instructions downstream now rather than
+      // when the output buffer happens to fill.
+      fflush(stdout);
+    }
+    if (!error) {
+      if (ferror(stdin)) {
+        fprintf(stderr, "error: error reading from standard input\n");
+        spvStreamingDisassemblerDestroy(stream);
+        spvContextDestroy(context);
+        return 1;
+      }
+      error = spvStreamingDisassemblerParse(stream, binary.data(),
+                                            binary.size(), true, &diagnostic);
+    }
+    spvStreamingDisassemblerDestroy(stream);
+    spvContextDestroy(context);
+    if (error) {
+      spvDiagnosticPrint(diagnostic);
+      spvDiagnosticDestroy(diagnostic);
+      return error;
+    }
+    return 0;
+  }
+
+  // Read the input binary, memory-mapping it when possible.
+  MappedInput<uint32_t> contents;
+  if (!contents.Read(inFile)) return 1;
 
   // If printing to standard output, then spvBinaryToText should
   // do the printing.  In particular, colour printing on Windows is
@@ -158,7 +228,6 @@ int main(int argc, char** argv) {
   // into the output stream.
   // If the printing option is off, then save the text in memory, so
   // it can be emitted later in this function.
-  const bool print_to_stdout = SPV_BINARY_TO_TEXT_OPTION_PRINT & options;
   spv_text text = nullptr;
   spv_text* textOrNull = print_to_stdout ? nullptr : &text;
   spv_diagnostic diagnostic = nullptr;
@@ -19,13 +19,23 @@
 #include <cstdio>
 #include <vector>
 
+#if defined(SPIRV_LINUX) || defined(SPIRV_ANDROID) || defined(SPIRV_MAC) || \
+    defined(SPIRV_FREEBSD)
+#define SPIRV_TOOLS_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 // Appends the content from the file named as |filename| to |data|, assuming
 // each element in the file is of type |T|. The file is opened with the given
 // |mode|. If |filename| is nullptr or "-", reads from the standard input. If
 // any error occurs, writes error messages to standard error and returns false.
 template <typename T>
 bool ReadFile(const char* filename, const char* mode, std::vector<T>* data) {
-  const int buf_size = 1024;
+  // Read in large chunks so the pipe/file is drained with few syscalls.
+  const int buf_size = 16384;
   const bool use_file = filename && strcmp("-", filename);
   if (FILE* fp = (use_file ? fopen(filename, mode) : stdin)) {
     T buf[buf_size];
@@ -51,6 +61,168 @@ bool ReadFile(const char* filename, const char* mode, std::vector<T>* data) {
   return true;
 }
 
+// Provides read-only access to the contents of an input file, viewed as an
+// array of elements of type |T|.  On platforms that support it, a regular
+// file is memory-mapped instead of being copied into heap memory, so page-in
+// I/O overlaps with whatever consumes the data.  Standard input, non-regular
+// files, and other platforms fall back to ReadFile above.
+template <typename T>
+class MappedInput {
+ public:
+  MappedInput() {}
+  ~MappedInput() {
+#ifdef SPIRV_TOOLS_USE_MMAP
+    if (mapping_) munmap(mapping_, num_bytes_);
+#endif
+  }
+
+  // Disallow copying: the destructor releases the mapping.
+  MappedInput(const MappedInput&) = delete;
+  MappedInput& operator=(const MappedInput&) = delete;
+
+  // Reads the file named as |filename|.  If |filename| is nullptr or "-",
+  // reads from the standard input.  If any error occurs, writes error
+  // messages to standard error and returns false.
+  bool Read(const char* filename) {
+#ifdef SPIRV_TOOLS_USE_MMAP
+    if (filename && strcmp("-", filename)) {
+      const int fd = open(filename, O_RDONLY);
+      if (fd >= 0) {
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) &&
+            info.st_size > 0) {
+          if (info.st_size % sizeof(T)) {
+            fprintf(stderr, "error: corrupted word found in file '%s'\n",
+                    filename);
+            close(fd);
+            return false;
+          }
+          void* data = mmap(nullptr, static_cast<size_t>(info.st_size),
+                            PROT_READ, MAP_PRIVATE, fd, 0);
+          if (data != MAP_FAILED) {
+            // Ask the kernel to start paging the whole file in now.  The
+            // call returns immediately, so the readahead overlaps with the
+            // parsing that walks the mapping front to back; on high-latency
+            // storage this hides most of the input transfer time.
+            madvise(data, static_cast<size_t>(info.st_size), MADV_WILLNEED);
+            madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+            mapping_ = data;
+            num_bytes_ = static_cast<size_t>(info.st_size);
+            close(fd);
+            return true;
+          }
+        }
+        close(fd);
+      }
+      // Fall through to the portable path, which reports its own errors.
+    }
+#endif
+    return ReadFile<T>(filename, "rb", &buffer_);
+  }
+
+  // Returns a pointer to the first element of the input.
+  const T* data() const {
+    return mapping_ ? static_cast<const T*>(mapping_) : buffer_.data();
+  }
+  // Returns the number of elements in the input.
+  size_t size() const {
+    return mapping_ ? num_bytes_ / sizeof(T) : buffer_.size();
+  }
+
+ private:
+  std::vector<T> buffer_;     // Storage for the fallback path.
+  void* mapping_ = nullptr;   // Mapped region, if memory-mapped.
+  size_t num_bytes_ = 0;      // Size of the mapped region in bytes.
+};
+
+#ifdef SPIRV_TOOLS_USE_MMAP
+// Provides write access to an output file through a growable memory
+// mapping.  Producers write straight into the mapping, so the bytes land in
+// the page cache with no intermediate heap buffer; Finish() then truncates
+// the file to its exact final size.  Only regular files can be mapped:
+// callers must fall back to a buffered path such as WriteFile when Open()
+// returns false.
+class MappedOutput {
+ public:
+  MappedOutput() {}
+  ~MappedOutput() {
+    if (mapping_) munmap(mapping_, num_bytes_);
+    if (fd_ >= 0) close(fd_);
+  }
+
+  // Disallow copying: the destructor releases the mapping and the file.
+  MappedOutput(const MappedOutput&) = delete;
+  MappedOutput& operator=(const MappedOutput&) = delete;
+
+  // Creates (or truncates) the file named |filename|.  Returns false
+  // without reporting an error if |filename| means standard output or the
+  // file cannot be created as a regular file.
+  bool Open(const char* filename) {
+    if (!filename || !strcmp("-", filename)) return false;
+    fd_ = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd_ < 0) return false;
+    struct stat info;
+    if (fstat(fd_, &info) != 0 || !S_ISREG(info.st_mode)) {
+      close(fd_);
+      fd_ = -1;
+      return false;
+    }
+    return true;
+  }
+
+  // Ensures the mapping covers at least |num_bytes|, extending the file and
+  // remapping as needed.  Returns the (possibly moved) base of the mapping,
+  // or null on failure.  Previously written bytes are preserved: they live
+  // in the file's page cache, not in the mapping itself.
+  void* Grow(size_t num_bytes) {
+    if (mapping_ && num_bytes <= num_bytes_) return mapping_;
+    if (ftruncate(fd_, static_cast<off_t>(num_bytes)) != 0) return nullptr;
+    if (mapping_) munmap(mapping_, num_bytes_);
+    mapping_ =
+        mmap(nullptr, num_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapping_ == MAP_FAILED) {
+      mapping_ = nullptr;
+      return nullptr;
+    }
+    num_bytes_ = num_bytes;
+    return mapping_;
+  }
+
+  // Unmaps the file, truncates it to exactly |final_bytes| and closes it.
+  // Returns false if any step fails.
+  bool Finish(size_t final_bytes) {
+    bool ok = true;
+    if (mapping_) {
+      ok = munmap(mapping_, num_bytes_) == 0 && ok;
+      mapping_ = nullptr;
+    }
+    ok = ftruncate(fd_, static_cast<off_t>(final_bytes)) == 0 && ok;
+    ok = close(fd_) == 0 && ok;
+    fd_ = -1;
+    return ok;
+  }
+
+  // Closes and removes the file named |filename|; for use when production
+  // fails partway, so no truncated output is left behind.
+  void Discard(const char* filename) {
+    if (mapping_) {
+      munmap(mapping_, num_bytes_);
+      mapping_ = nullptr;
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+    remove(filename);
+  }
+
+ private:
+  void* mapping_ = nullptr;  // Mapped region, or null if none yet.
+  size_t num_bytes_ = 0;     // Size of the mapped region in bytes.
+  int fd_ = -1;              // The output file, or -1 once closed.
+};
+#endif  // SPIRV_TOOLS_USE_MMAP
+
 // Writes the given |data| into the file named as |filename| using the given
 // |mode|, assuming |data| is an array of |count| elements of type |T|. If
 // |filename| is nullptr or "-", writes to standard output. If any error occurs,
@@ -23,10 +23,37 @@
 #include "spirv-tools/optimizer.hpp"
 
 #include "message.h"
+#include "source/tracing.h"
 #include "tools/io.h"
 
 using namespace spvtools;
 
+// Returns true if the file named |filename| already holds exactly the
+// |count| words at |data|. Any problem reading the file counts as a
+// mismatch; the caller then writes as usual.
+bool OutputAlreadyMatches(const char* filename, const uint32_t* data,
+                          size_t count) {
+  if (!filename || !strcmp("-", filename)) return false;
+  FILE* fp = fopen(filename, "rb");
+  if (!fp) return false;
+  bool matches = true;
+  const size_t buf_words = 16384;
+  std::vector<uint32_t> buf(buf_words);
+  size_t offset = 0;
+  while (matches) {
+    const size_t len = fread(buf.data(), sizeof(uint32_t), buf_words, fp);
+    if (len == 0) break;
+    if (offset + len > count ||
+        memcmp(buf.data(), data + offset, len * sizeof(uint32_t)) != 0) {
+      matches = false;
+    }
+    offset += len;
+  }
+  if (ferror(fp) || offset != count) matches = false;
+  fclose(fp);
+  return matches;
+}
+
 void PrintUsage(const char* program) {
   printf(
       R"(%s - Optimize a SPIR-V binary file.
@@ -48,6 +75,12 @@ Options:
                values.
   --eliminate-dead-const
                Eliminate dead constants.
+  --eliminate-dead-code-aggressive
+               Remove all instructions whose results provably do not
+               contribute to any side effect or control flow.
+  --eliminate-dead-functions
+               Remove functions that cannot be reached from an entry point
+               or from an exported function.
   --fold-spec-const-op-composite
                Fold the spec constants defined by OpSpecConstantOp or
                OpSpecConstantComposite instructions to front-end constants
@@ -65,12 +98,44 @@ Options:
                Exhaustively inline all function calls in entry point functions.
                Currently does not inline calls to functions with multiple
                returns.
+  --promote-locals
+               Rewrite function-local variables that are only loaded and
+               stored whole into SSA values, inserting phis where needed.
+  --local-cse
+               Replace repeated computations and loads inside each basic
+               block with the first equivalent result. Most effective after
+               --inline-entry-points-exhaustive.
+  --licm
+               Move loop-invariant computations and loads from read-only
+               storage into the loop preheader so they execute once. Most
+               effective after --inline-entry-points-exhaustive.
+  --simplify
+               Rewrite algebraic identities (x+0, x*1, bitcast chains,
+               composite construct/extract round-trips) to reuse existing
+               values, leaving the replaced instructions for dead code
+               elimination.
   --flatten-decorations
                Replace decoration groups with repeated OpDecorate and
                OpMemberDecorate instructions.
   --compact-ids
                Remap result ids to a compact range starting from %%1 and without
                any gaps.
+  --canonicalize-ids
+               Remap result ids to a compact range numbered from a structural
+               traversal of the module, so that equivalent code serializes to
+               identical bytes regardless of debug names or decoration order.
+  --preset=release
+               Register the standard cleanup pipeline: strip-debug,
+               eliminate-dead-const, unify-const and compact-ids, in that
+               order. May be combined with individual pass flags; passes run
+               in the order their flags appear.
+  --time-report
+               Print the wall time, instruction counts, IR memory growth and
+               estimated module footprint of each pass to standard error as
+               it runs.
+  --trace <file>
+               Write chrome://tracing span output for the run to <file>.
+               Only available when the tools were built with SPIRV_TRACING=ON.
   -h, --help   Print this help.
   --version    Display optimizer version information.
 )",
@@ -80,6 +145,7 @@ Options:
 int main(int argc, char** argv) {
   const char* in_file = nullptr;
   const char* out_file = nullptr;
+  const char* trace_file = nullptr;
 
   spv_target_env target_env = SPV_ENV_UNIVERSAL_1_2;
 
@@ -135,14 +201,48 @@ int main(int argc, char** argv) {
         optimizer.RegisterPass(CreateInlinePass());
       } else if (0 == strcmp(cur_arg, "--eliminate-dead-const")) {
         optimizer.RegisterPass(CreateEliminateDeadConstantPass());
+      } else if (0 == strcmp(cur_arg, "--eliminate-dead-code-aggressive")) {
+        optimizer.RegisterPass(CreateAggressiveDCEPass());
+      } else if (0 == strcmp(cur_arg, "--eliminate-dead-functions")) {
+        optimizer.RegisterPass(CreateEliminateDeadFunctionsPass());
       } else if (0 == strcmp(cur_arg, "--fold-spec-const-op-composite")) {
         optimizer.RegisterPass(CreateFoldSpecConstantOpAndCompositePass());
       } else if (0 == strcmp(cur_arg, "--unify-const")) {
         optimizer.RegisterPass(CreateUnifyConstantPass());
+      } else if (0 == strcmp(cur_arg, "--promote-locals")) {
+        optimizer.RegisterPass(CreatePromoteLocalsPass());
+      } else if (0 == strcmp(cur_arg, "--local-cse")) {
+        optimizer.RegisterPass(CreateLocalCSEPass());
+      } else if (0 == strcmp(cur_arg, "--licm")) {
+        optimizer.RegisterPass(CreateLicmPass());
+      } else if (0 == strcmp(cur_arg, "--simplify")) {
+        optimizer.RegisterPass(CreateSimplifyPass());
       } else if (0 == strcmp(cur_arg, "--flatten-decorations")) {
         optimizer.RegisterPass(CreateFlattenDecorationPass());
       } else if (0 == strcmp(cur_arg, "--compact-ids")) {
         optimizer.RegisterPass(CreateCompactIdsPass());
+      } else if (0 == strcmp(cur_arg, "--canonicalize-ids")) {
+        optimizer.RegisterPass(CreateCanonicalizeIdsPass());
+      } else if (0 == strncmp(cur_arg, "--preset=", strlen("--preset="))) {
+        const char* preset = cur_arg + strlen("--preset=");
+        if (0 == strcmp(preset, "release")) {
+          optimizer.RegisterPass(CreateStripDebugInfoPass())
+              .RegisterPass(CreateEliminateDeadConstantPass())
+              .RegisterPass(CreateUnifyConstantPass())
+              .RegisterPass(CreateCompactIdsPass());
+        } else {
+          fprintf(stderr, "error: Unknown preset: %s\n", preset);
+          return 1;
+        }
+      } else if (0 == strcmp(cur_arg, "--time-report")) {
+        optimizer.SetTimeReport(&std::cerr);
+      } else if (0 == strcmp(cur_arg, "--trace")) {
+        if (argi + 1 < argc) {
+          trace_file = argv[++argi];
+        } else {
+          fprintf(stderr, "error: Missing argument to --trace\n");
+          return 1;
+        }
       } else if ('\0' == cur_arg[1]) {
         // Setting a filename of "-" to indicate stdin.
         if (!in_file) {
@@ -170,8 +270,21 @@ int main(int argc, char** argv) {
     return 1;
   }
 
-  std::vector<uint32_t> binary;
-  if (!ReadFile<uint32_t>(in_file, "rb", &binary)) return 1;
+  if (trace_file) {
+    if (!libspirv::TraceSupported()) {
+      fprintf(stderr,
+              "error: --trace requires building with SPIRV_TRACING=ON\n");
+      return 1;
+    }
+    if (!libspirv::TraceStart(trace_file)) {
+      fprintf(stderr, "error: failed to open trace file: %s\n", trace_file);
+      return 1;
+    }
+  }
+
+  // Read the input binary, memory-mapping it when possible.
+  MappedInput<uint32_t> binary;
+  if (!binary.Read(in_file)) return 1;
 
   // Let's do validation first.
   spv_context context = spvContextCreate(target_env);
@@ -182,16 +295,24 @@ int main(int argc, char** argv) {
     spvDiagnosticPrint(diagnostic);
     spvDiagnosticDestroy(diagnostic);
     spvContextDestroy(context);
+    libspirv::TraceStop();
     return error;
   }
   spvDiagnosticDestroy(diagnostic);
   spvContextDestroy(context);
 
-  // By using the same vector as input and output, we save time in the case
-  // that there was no change.
-  bool ok = optimizer.Run(binary.data(), binary.size(), &binary);
+  // The optimizer reads straight from the (possibly memory-mapped) input and
+  // serializes the result into a separate output vector.
+  std::vector<uint32_t> optimized;
+  bool ok = optimizer.Run(binary.data(), binary.size(), &optimized);
+  libspirv::TraceStop();
 
-  if (!WriteFile<uint32_t>(out_file, "wb", binary.data(), binary.size())) {
+  // Most modules in incremental builds come through unchanged. Leaving an
+  // identical output file untouched preserves its timestamp, so build steps
+  // depending on it do not rerun.
+  if (!OutputAlreadyMatches(out_file, optimized.data(), optimized.size()) &&
+      !WriteFile<uint32_t>(out_file, "wb", optimized.data(),
+                           optimized.size())) {
     return 1;
   }
 
@@ -0,0 +1,246 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Replays a call trace recorded with SPIRV_TOOLS_CALL_TRACE against this
+// build of the library and reports per-call-kind timing.  Running the same
+// trace under two builds gives an apples-to-apples comparison on a real
+// workload's call pattern: the same module mix, context environments and
+// option combinations as production.
+
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "call_trace.h"
+#include "spirv-tools/libspirv.h"
+
+#include "tools/io.h"
+
+namespace {
+
+// One decoded trace record, pointing into the loaded trace words.
+struct TraceRecord {
+  uint32_t kind;
+  spv_target_env env;
+  const uint32_t* option_words;
+  uint32_t num_option_words;
+  const uint32_t* payload;
+  uint32_t num_payload_words;
+};
+
+// Decodes the trace in |words| into |records|.  Returns false and prints an
+// error if the trace is malformed.
+bool DecodeTrace(const std::vector<uint32_t>& words,
+                 std::vector<TraceRecord>* records) {
+  if (words.size() < 2 || words[0] != libspirv::kCallTraceMagic) {
+    fprintf(stderr, "error: not a call trace file\n");
+    return false;
+  }
+  if (words[1] != libspirv::kCallTraceVersion) {
+    fprintf(stderr, "error: unsupported trace version %u\n", words[1]);
+    return false;
+  }
+  size_t pos = 2;
+  while (pos < words.size()) {
+    if (words.size() - pos < 4) {
+      fprintf(stderr, "error: truncated record header\n");
+      return false;
+    }
+    TraceRecord record;
+    record.kind = words[pos];
+    record.env = static_cast<spv_target_env>(words[pos + 1]);
+    record.num_option_words = words[pos + 2];
+    record.num_payload_words = words[pos + 3];
+    pos += 4;
+    if (words.size() - pos <
+        size_t(record.num_option_words) + record.num_payload_words) {
+      fprintf(stderr, "error: truncated record body\n");
+      return false;
+    }
+    record.option_words = words.data() + pos;
+    pos += record.num_option_words;
+    record.payload = words.data() + pos;
+    pos += record.num_payload_words;
+    records->push_back(record);
+  }
+  return true;
+}
+
+// Rebuilds the validator options serialized by the recorder: eight
+// universal limits, the check mask, then the budget.
+spv_validator_options MakeValidatorOptions(const uint32_t* words,
+                                           uint32_t num_words) {
+  spv_validator_options options = spvValidatorOptionsCreate();
+  if (num_words < 14) return options;  // Defaults for short records.
+  for (uint32_t i = 0; i < 8; ++i) {
+    spvValidatorOptionsSetUniversalLimit(
+        options, static_cast<spv_validator_limit>(i), words[i]);
+  }
+  spvValidatorOptionsSetChecks(options, words[8]);
+  spv_validator_budget_t budget;
+  budget.max_instructions = uint64_t(words[9]) | (uint64_t(words[10]) << 32);
+  budget.max_blocks_per_function = words[11];
+  budget.max_validation_steps =
+      uint64_t(words[12]) | (uint64_t(words[13]) << 32);
+  spvValidatorOptionsSetBudget(options, &budget);
+  return options;
+}
+
+const char* KindName(uint32_t kind) {
+  switch (kind) {
+    case libspirv::kCallTextToBinary:
+      return "spvTextToBinary";
+    case libspirv::kCallValidate:
+      return "spvValidateWithOptions";
+    case libspirv::kCallBinaryParse:
+      return "spvBinaryParse";
+    default:
+      return "(unknown)";
+  }
+}
+
+// Accumulated replay results for one call kind.
+struct KindStats {
+  size_t calls = 0;
+  size_t failures = 0;
+  double total_ms = 0;
+};
+
+void PrintUsage(const char* program) {
+  printf(
+      R"(%s - Replay a recorded SPIR-V Tools call trace.
+
+USAGE: %s [options] <trace-file>
+
+Re-executes the spvTextToBinary, spvValidateWithOptions and spvBinaryParse
+calls recorded in <trace-file> (see the SPIRV_TOOLS_CALL_TRACE environment
+variable) and reports call counts, failures and timing per call kind.
+
+Options:
+  --runs <n>   Replay the whole trace <n> times and report the totals
+               (default 1). More runs smooth out timing noise.
+  -h, --help   Print this help.
+)",
+      program, program);
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  const char* trace_file = nullptr;
+  size_t num_runs = 1;
+
+  for (int argi = 1; argi < argc; ++argi) {
+    const char* cur_arg = argv[argi];
+    if (0 == strcmp(cur_arg, "--help") || 0 == strcmp(cur_arg, "-h")) {
+      PrintUsage(argv[0]);
+      return 0;
+    } else if (0 == strcmp(cur_arg, "--runs")) {
+      if (argi + 1 < argc) {
+        num_runs = strtoull(argv[++argi], nullptr, 10);
+        if (num_runs == 0) num_runs = 1;
+      } else {
+        fprintf(stderr, "error: missing argument to --runs\n");
+        return 1;
+      }
+    } else if (!trace_file) {
+      trace_file = cur_arg;
+    } else {
+      fprintf(stderr, "error: more than one trace file specified\n");
+      return 1;
+    }
+  }
+  if (trace_file == nullptr) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  std::vector<uint32_t> words;
+  if (!ReadFile<uint32_t>(trace_file, "rb", &words)) return 1;
+  std::vector<TraceRecord> records;
+  if (!DecodeTrace(words, &records)) return 1;
+
+  // Contexts are created once per environment and reused, matching how
+  // long-running producers hold on to their contexts.
+  std::map<uint32_t, spv_context> contexts;
+  for (const TraceRecord& record : records) {
+    if (!contexts.count(record.env)) {
+      contexts[record.env] = spvContextCreate(record.env);
+    }
+  }
+
+  using Clock = std::chrono::steady_clock;
+  std::map<uint32_t, KindStats> stats;
+  for (size_t run = 0; run < num_runs; ++run) {
+    for (const TraceRecord& record : records) {
+      spv_context context = contexts[record.env];
+      KindStats& kind_stats = stats[record.kind];
+      spv_result_t result = SPV_SUCCESS;
+      const Clock::time_point start = Clock::now();
+      switch (record.kind) {
+        case libspirv::kCallTextToBinary: {
+          const uint32_t assemble_options = record.option_words[0];
+          const size_t num_bytes = record.option_words[1];
+          spv_binary binary = nullptr;
+          result = spvTextToBinaryWithOptions(
+              context, reinterpret_cast<const char*>(record.payload),
+              num_bytes, assemble_options, &binary, nullptr);
+          spvBinaryDestroy(binary);
+          break;
+        }
+        case libspirv::kCallValidate: {
+          spv_validator_options options = MakeValidatorOptions(
+              record.option_words, record.num_option_words);
+          spv_const_binary_t binary{record.payload,
+                                    record.num_payload_words};
+          result = spvValidateWithOptions(context, options, &binary, nullptr);
+          spvValidatorOptionsDestroy(options);
+          break;
+        }
+        case libspirv::kCallBinaryParse: {
+          result = spvBinaryParse(context, nullptr, record.payload,
+                                  record.num_payload_words, nullptr, nullptr,
+                                  nullptr);
+          break;
+        }
+        default:
+          fprintf(stderr, "error: unknown record kind %u\n", record.kind);
+          return 1;
+      }
+      kind_stats.total_ms +=
+          std::chrono::duration<double, std::milli>(Clock::now() - start)
+              .count();
+      ++kind_stats.calls;
+      // A recorded call may well have failed in production too (e.g. a
+      // validation error); failures are counted, not fatal.
+      if (result != SPV_SUCCESS) ++kind_stats.failures;
+    }
+  }
+
+  printf("%-24s %10s %10s %14s %14s\n", "call", "calls", "failures",
+         "total ms", "mean us");
+  for (const auto& entry : stats) {
+    const KindStats& kind_stats = entry.second;
+    printf("%-24s %10zu %10zu %14.2f %14.2f\n", KindName(entry.first),
+           kind_stats.calls, kind_stats.failures, kind_stats.total_ms,
+           kind_stats.total_ms * 1000.0 / double(kind_stats.calls));
+  }
+
+  for (const auto& entry : contexts) spvContextDestroy(entry.second);
+  return 0;
+}
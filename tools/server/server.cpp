@@ -0,0 +1,537 @@
+// Copyright (c) 2017 The Khronos Group Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A daemon hosting the assembler, disassembler, and validator behind a
+// Unix-domain socket, so build systems that invoke the tools many
+// thousands of times per build pay process startup, dynamic linking, and
+// grammar table setup once instead of per shader.  The same binary is the
+// thin client: "spirv-tools-server --client" connects, ships one request,
+// and exits with the status the server reported.
+//
+// The wire protocol is deliberately minimal.  A connection carries a
+// sequence of requests; each request is a fixed header followed by a
+// payload, and each response likewise.  All fields are in the host's byte
+// order, which both ends of a Unix socket share.
+//
+//   request:  uint32 command, uint32 target_env, uint32 options,
+//             uint64 payload_bytes, then the payload
+//   response: uint32 status (an spv_result_t), uint32 reserved,
+//             uint64 payload_bytes, then the payload
+//
+// The payload is assembly text for kCmdAssemble and binary words for
+// kCmdDisassemble and kCmdValidate.  On success the response payload is
+// the produced binary or text (empty for validation); on failure it is
+// the diagnostic message.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "source/spirv_target_env.h"
+#include "spirv-tools/libspirv.h"
+#include "tools/io.h"
+
+static void print_usage(char* argv0) {
+  printf(
+      R"(%s - Host SPIR-V tools in a daemon to amortize startup costs
+
+Usage: %s [options] <socket-path>
+
+Server mode (the default) listens on the Unix-domain socket at
+<socket-path> and serves assemble, disassemble, and validate requests
+from warm contexts, so repeated tool invocations become lightweight
+RPCs instead of process spawns.
+
+Options:
+
+  -h, --help      Print this help.
+  --version       Display server version information.
+
+  --client <command>
+                  Run as a client instead: connect to <socket-path>,
+                  send one request, and exit with the resulting status.
+                  <command> is one of:
+                    assemble      Read assembly text, output a binary.
+                    disassemble   Read a binary, output assembly text.
+                    validate      Read a binary; report errors only.
+                    shutdown      Ask the server to exit.
+
+  -o <filename>   Client mode: set the output filename.  Output goes to
+                  standard output if this option is not specified, or if
+                  the filename is "-".
+  --target-env {vulkan1.0|spv1.0|spv1.1|spv1.2}
+                  Client mode: use Vulkan1.0/SPIR-V1.0/SPIR-V1.1/SPIR-V1.2.
+
+The client reads its input from the trailing <filename> argument, or
+from standard input if none is given or the filename is "-".
+)",
+      argv0, argv0);
+}
+
+static const auto kDefaultEnvironment = SPV_ENV_UNIVERSAL_1_2;
+
+#if defined(SPIRV_LINUX) || defined(SPIRV_ANDROID) || defined(SPIRV_MAC) || \
+    defined(SPIRV_FREEBSD)
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+namespace {
+
+// Commands understood by the server.
+enum Command : uint32_t {
+  kCmdAssemble = 1,
+  kCmdDisassemble = 2,
+  kCmdValidate = 3,
+  kCmdShutdown = 4,
+};
+
+struct RequestHeader {
+  uint32_t command;
+  uint32_t target_env;  // An spv_target_env value.
+  uint32_t options;     // Option bits for the requested command.
+  uint32_t reserved;
+  uint64_t payload_bytes;
+};
+
+struct ResponseHeader {
+  uint32_t status;  // An spv_result_t value.
+  uint32_t reserved;
+  uint64_t payload_bytes;
+};
+
+// Reads exactly |num_bytes| from |fd| into |data|.  Returns false on EOF
+// or error.
+bool ReadAll(int fd, void* data, size_t num_bytes) {
+  char* p = static_cast<char*>(data);
+  while (num_bytes) {
+    const ssize_t n = read(fd, p, num_bytes);
+    if (n <= 0) return false;
+    p += n;
+    num_bytes -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+// Writes exactly |num_bytes| from |data| to |fd|.  Returns false on error.
+bool WriteAll(int fd, const void* data, size_t num_bytes) {
+  const char* p = static_cast<const char*>(data);
+  while (num_bytes) {
+    const ssize_t n = write(fd, p, num_bytes);
+    if (n <= 0) return false;
+    p += n;
+    num_bytes -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+// Renders the given diagnostic the way spvDiagnosticPrint would, so the
+// client can forward it to its own standard error verbatim.
+std::string RenderDiagnostic(spv_diagnostic diagnostic) {
+  if (!diagnostic) return "error: (no diagnostic)";
+  std::string message = "error: ";
+  if (diagnostic->isTextSource) {
+    message += std::to_string(diagnostic->position.line + 1) + ": " +
+               std::to_string(diagnostic->position.column + 1) + ": ";
+  } else {
+    message += std::to_string(diagnostic->position.index) + ": ";
+  }
+  message += diagnostic->error;
+  return message;
+}
+
+// The warm per-thread tool state.  Each worker owns one host, so no
+// synchronization is needed around the contexts or assembler sessions,
+// which are not thread safe.  Contexts and sessions are created on first
+// use per target environment and kept for the life of the server, so a
+// request on a warm worker pays only for its actual work.
+class ToolHost {
+ public:
+  ~ToolHost() {
+    for (auto& entry : assemblers_) spvAssemblerDestroy(entry.second);
+    for (auto& entry : contexts_) spvContextDestroy(entry.second);
+  }
+
+  spv_context ContextFor(spv_target_env env) {
+    auto iter = contexts_.find(env);
+    if (iter != contexts_.end()) return iter->second;
+    spv_context context = spvContextCreate(env);
+    if (context) contexts_[env] = context;
+    return context;
+  }
+
+  // Returns the assembler session for the given environment.  The session
+  // memoizes token lookups, so assembling many similar shaders through one
+  // worker approaches pure encode speed.
+  spv_assembler AssemblerFor(spv_target_env env) {
+    auto iter = assemblers_.find(env);
+    if (iter != assemblers_.end()) return iter->second;
+    spv_context context = ContextFor(env);
+    if (!context) return nullptr;
+    spv_assembler assembler = spvAssemblerCreate(context);
+    if (assembler) assemblers_[env] = assembler;
+    return assembler;
+  }
+
+ private:
+  std::map<spv_target_env, spv_context> contexts_;
+  std::map<spv_target_env, spv_assembler> assemblers_;
+};
+
+// Executes one request against the given host.  On success returns
+// SPV_SUCCESS and fills *reply with the result payload; on failure
+// returns the error and fills *reply with the diagnostic message.
+spv_result_t HandleRequest(ToolHost* host, const RequestHeader& request,
+                           const std::vector<char>& payload,
+                           std::vector<char>* reply) {
+  reply->clear();
+  const spv_target_env env = static_cast<spv_target_env>(request.target_env);
+  spv_context context = host->ContextFor(env);
+  if (!context) {
+    const char message[] = "error: unrecognized target environment";
+    reply->assign(message, message + sizeof(message) - 1);
+    return SPV_ERROR_INVALID_VALUE;
+  }
+
+  spv_diagnostic diagnostic = nullptr;
+  spv_result_t status = SPV_SUCCESS;
+  switch (request.command) {
+    case kCmdAssemble: {
+      spv_assembler assembler = host->AssemblerFor(env);
+      spv_binary binary = nullptr;
+      status = spvAssemblerTextToBinary(assembler, payload.data(),
+                                        payload.size(), request.options,
+                                        &binary, &diagnostic);
+      if (status == SPV_SUCCESS) {
+        const char* bytes = reinterpret_cast<const char*>(binary->code);
+        reply->assign(bytes, bytes + binary->wordCount * sizeof(uint32_t));
+      }
+      spvBinaryDestroy(binary);
+    } break;
+    case kCmdDisassemble: {
+      spv_text text = nullptr;
+      status = spvBinaryToText(
+          context, reinterpret_cast<const uint32_t*>(payload.data()),
+          payload.size() / sizeof(uint32_t), request.options, &text,
+          &diagnostic);
+      if (status == SPV_SUCCESS) {
+        reply->assign(text->str, text->str + text->length);
+      }
+      spvTextDestroy(text);
+    } break;
+    case kCmdValidate: {
+      spv_const_binary_t binary = {
+          reinterpret_cast<const uint32_t*>(payload.data()),
+          payload.size() / sizeof(uint32_t)};
+      status = spvValidate(context, &binary, &diagnostic);
+    } break;
+    default: {
+      const char message[] = "error: unrecognized command";
+      reply->assign(message, message + sizeof(message) - 1);
+      return SPV_ERROR_INVALID_VALUE;
+    }
+  }
+
+  if (status != SPV_SUCCESS) {
+    const std::string message = RenderDiagnostic(diagnostic);
+    reply->assign(message.begin(), message.end());
+  }
+  spvDiagnosticDestroy(diagnostic);
+  return status;
+}
+
+// Serves requests on the given connection until the peer closes it.
+// Returns true if the peer asked the server to shut down.
+bool ServeConnection(ToolHost* host, int fd) {
+  for (;;) {
+    RequestHeader request;
+    if (!ReadAll(fd, &request, sizeof(request))) return false;
+    std::vector<char> payload(request.payload_bytes);
+    if (!ReadAll(fd, payload.data(), payload.size())) return false;
+
+    if (request.command == kCmdShutdown) {
+      const ResponseHeader response = {SPV_SUCCESS, 0, 0};
+      WriteAll(fd, &response, sizeof(response));
+      return true;
+    }
+
+    std::vector<char> reply;
+    const spv_result_t status = HandleRequest(host, request, payload, &reply);
+    const ResponseHeader response = {static_cast<uint32_t>(status), 0,
+                                     reply.size()};
+    if (!WriteAll(fd, &response, sizeof(response))) return false;
+    if (!WriteAll(fd, reply.data(), reply.size())) return false;
+  }
+}
+
+// Accepted connections waiting for a worker, plus the coordination needed
+// to drain and stop the pool.
+struct ConnectionQueue {
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::queue<int> fds;
+  bool done = false;
+};
+
+int RunServer(const char* socket_path) {
+  const int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd < 0) {
+    fprintf(stderr, "error: could not create socket\n");
+    return 1;
+  }
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (strlen(socket_path) >= sizeof(address.sun_path)) {
+    fprintf(stderr, "error: socket path too long '%s'\n", socket_path);
+    close(listen_fd);
+    return 1;
+  }
+  strncpy(address.sun_path, socket_path, sizeof(address.sun_path) - 1);
+  // Remove a socket left behind by an earlier server, then claim the path.
+  remove(socket_path);
+  if (bind(listen_fd, reinterpret_cast<struct sockaddr*>(&address),
+           sizeof(address)) != 0 ||
+      listen(listen_fd, 64) != 0) {
+    fprintf(stderr, "error: could not listen on '%s'\n", socket_path);
+    close(listen_fd);
+    return 1;
+  }
+
+  // One warm worker per core.  Each worker keeps its own contexts and
+  // assembler sessions, so concurrent requests never contend on them.
+  const size_t num_workers = std::max(1u, std::thread::hardware_concurrency());
+  ConnectionQueue queue;
+  std::atomic<bool> shutdown_requested(false);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers.emplace_back([&queue, &shutdown_requested, listen_fd] {
+      ToolHost host;
+      for (;;) {
+        int fd;
+        {
+          std::unique_lock<std::mutex> lock(queue.mutex);
+          queue.ready.wait(lock,
+                           [&queue] { return queue.done || !queue.fds.empty(); });
+          if (queue.fds.empty()) return;
+          fd = queue.fds.front();
+          queue.fds.pop();
+        }
+        const bool stop = ServeConnection(&host, fd);
+        close(fd);
+        if (stop && !shutdown_requested.exchange(true)) {
+          // Wake the accept loop so it notices the shutdown.
+          shutdown(listen_fd, SHUT_RDWR);
+        }
+      }
+    });
+  }
+
+  for (;;) {
+    const int fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0) break;  // Interrupted by shutdown, or a fatal error.
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    queue.fds.push(fd);
+    queue.ready.notify_one();
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    queue.done = true;
+    queue.ready.notify_all();
+  }
+  for (auto& worker : workers) worker.join();
+  close(listen_fd);
+  remove(socket_path);
+  return 0;
+}
+
+int RunClient(const char* socket_path, uint32_t command,
+              spv_target_env target_env, uint32_t options, const char* in_file,
+              const char* out_file) {
+  std::vector<char> input;
+  if (command != kCmdShutdown && !ReadFile<char>(in_file, "rb", &input))
+    return 1;
+
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    fprintf(stderr, "error: could not create socket\n");
+    return 1;
+  }
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (strlen(socket_path) >= sizeof(address.sun_path)) {
+    fprintf(stderr, "error: socket path too long '%s'\n", socket_path);
+    close(fd);
+    return 1;
+  }
+  strncpy(address.sun_path, socket_path, sizeof(address.sun_path) - 1);
+  if (connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+              sizeof(address)) != 0) {
+    fprintf(stderr, "error: could not connect to server at '%s'\n",
+            socket_path);
+    close(fd);
+    return 1;
+  }
+
+  const RequestHeader request = {command, static_cast<uint32_t>(target_env),
+                                 options, 0, input.size()};
+  ResponseHeader response;
+  std::vector<char> reply;
+  if (!WriteAll(fd, &request, sizeof(request)) ||
+      !WriteAll(fd, input.data(), input.size()) ||
+      !ReadAll(fd, &response, sizeof(response))) {
+    fprintf(stderr, "error: lost connection to server\n");
+    close(fd);
+    return 1;
+  }
+  reply.resize(response.payload_bytes);
+  if (!ReadAll(fd, reply.data(), reply.size())) {
+    fprintf(stderr, "error: lost connection to server\n");
+    close(fd);
+    return 1;
+  }
+  close(fd);
+
+  if (response.status != SPV_SUCCESS) {
+    fprintf(stderr, "%.*s\n", static_cast<int>(reply.size()), reply.data());
+    return static_cast<int>(response.status);
+  }
+  if (!reply.empty()) {
+    const char* mode = command == kCmdAssemble ? "wb" : "w";
+    if (!WriteFile<char>(out_file, mode, reply.data(), reply.size())) return 1;
+  }
+  return 0;
+}
+
+}  // anonymous namespace
+
+#endif  // Unix-like platforms
+
+int main(int argc, char** argv) {
+  const char* socket_path = nullptr;
+  const char* client_command = nullptr;
+  const char* in_file = nullptr;
+  const char* out_file = nullptr;
+  spv_target_env target_env = kDefaultEnvironment;
+
+  for (int argi = 1; argi < argc; ++argi) {
+    if ('-' == argv[argi][0] && argv[argi][1]) {
+      switch (argv[argi][1]) {
+        case 'h':
+          print_usage(argv[0]);
+          return 0;
+        case 'o': {
+          if (!out_file && argi + 1 < argc) {
+            out_file = argv[++argi];
+          } else {
+            print_usage(argv[0]);
+            return 1;
+          }
+        } break;
+        case '-': {
+          // Long options
+          if (0 == strcmp(argv[argi], "--help")) {
+            print_usage(argv[0]);
+            return 0;
+          } else if (0 == strcmp(argv[argi], "--version")) {
+            printf("%s\n", spvSoftwareVersionDetailsString());
+            printf("Target: %s\n",
+                   spvTargetEnvDescription(kDefaultEnvironment));
+            return 0;
+          } else if (0 == strcmp(argv[argi], "--client")) {
+            if (argi + 1 < argc) {
+              client_command = argv[++argi];
+            } else {
+              fprintf(stderr, "error: Missing argument to --client\n");
+              return 1;
+            }
+          } else if (0 == strcmp(argv[argi], "--target-env")) {
+            if (argi + 1 < argc) {
+              const auto env_str = argv[++argi];
+              if (!spvParseTargetEnv(env_str, &target_env)) {
+                fprintf(stderr, "error: Unrecognized target env: %s\n",
+                        env_str);
+                return 1;
+              }
+            } else {
+              fprintf(stderr, "error: Missing argument to --target-env\n");
+              return 1;
+            }
+          } else {
+            print_usage(argv[0]);
+            return 1;
+          }
+        } break;
+        default:
+          print_usage(argv[0]);
+          return 1;
+      }
+    } else if (!socket_path) {
+      socket_path = argv[argi];
+    } else if (!in_file) {
+      in_file = argv[argi];
+    } else {
+      fprintf(stderr, "error: Too many arguments\n");
+      return 1;
+    }
+  }
+
+  if (!socket_path) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+#if defined(SPIRV_LINUX) || defined(SPIRV_ANDROID) || defined(SPIRV_MAC) || \
+    defined(SPIRV_FREEBSD)
+  if (!client_command) return RunServer(socket_path);
+
+  uint32_t command;
+  if (0 == strcmp(client_command, "assemble")) {
+    command = kCmdAssemble;
+  } else if (0 == strcmp(client_command, "disassemble")) {
+    command = kCmdDisassemble;
+  } else if (0 == strcmp(client_command, "validate")) {
+    command = kCmdValidate;
+  } else if (0 == strcmp(client_command, "shutdown")) {
+    command = kCmdShutdown;
+  } else {
+    fprintf(stderr, "error: Unrecognized client command: %s\n",
+            client_command);
+    return 1;
+  }
+  return RunClient(socket_path, command, target_env, 0, in_file, out_file);
+#else
+  (void)client_command;
+  (void)target_env;
+  (void)in_file;
+  (void)out_file;
+  fprintf(stderr,
+          "error: daemon mode requires Unix-domain sockets, which this "
+          "platform does not provide\n");
+  return 1;
+#endif
+}
@@ -12,15 +12,24 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
+#include "source/diagnostic.h"
 #include "source/spirv_stats.h"
 #include "source/table.h"
 #include "spirv-tools/libspirv.h"
 #include "stats_analyzer.h"
+#include "stats_index.h"
 #include "tools/io.h"
 
 using libspirv::SpirvStats;
@@ -44,6 +53,27 @@ find . -name "*.spv" -print0 | xargs -0 -s 2000000 %s
 
 Options:
   -h, --help                       Print this help.
+  -j <count>                       Process input files on <count> worker
+                                   threads and merge the per-thread statistics
+                                   at the end.  Defaults to 1 (sequential).
+  --raw-scan                       Scan the word stream directly instead of
+                                   fully parsing each module.  Several times
+                                   faster, but the constant literal histograms
+                                   are not collected and the modules are not
+                                   validated.
+  --snapshot <file>                Write the collected statistics to <file>
+                                   as a versioned binary snapshot instead of
+                                   printing the text report.  Snapshots can
+                                   be combined later with --merge.
+  --merge                          Treat the input files as snapshots written
+                                   by --snapshot rather than SPIR-V modules,
+                                   and combine their histograms.
+  --index <file>                   Keep a persistent per-file index in <file>
+                                   and process incrementally: files whose size
+                                   and content hash match their index entry
+                                   reuse the cached per-file snapshot instead
+                                   of being re-aggregated.  The index is
+                                   rewritten at the end of the run.
   -v, --verbose                    Print additional info to stderr.
 )",
       argv0, argv0, argv0);
@@ -78,6 +108,11 @@ int main(int argc, char** argv) {
   int return_code = 0;
 
   bool verbose = false;
+  bool merge_snapshots = false;
+  const char* snapshot_file = nullptr;
+  const char* index_file = nullptr;
+  size_t num_threads = 1;
+  libspirv::StatsAggregationMode mode = libspirv::StatsAggregationMode::kFull;
 
   std::vector<const char*> paths;
 
@@ -90,6 +125,36 @@ int main(int argc, char** argv) {
         return_code = 0;
       } else if (0 == strcmp(cur_arg, "--verbose") || 0 == strcmp(cur_arg, "-v")) {
         verbose = true;
+      } else if (0 == strcmp(cur_arg, "--raw-scan")) {
+        mode = libspirv::StatsAggregationMode::kRawScan;
+      } else if (0 == strcmp(cur_arg, "--merge")) {
+        merge_snapshots = true;
+      } else if (0 == strcmp(cur_arg, "--snapshot")) {
+        if (argi + 1 < argc) {
+          snapshot_file = argv[++argi];
+        } else {
+          PrintUsage(argv[0]);
+          continue_processing = false;
+          return_code = 1;
+        }
+      } else if (0 == strcmp(cur_arg, "--index")) {
+        if (argi + 1 < argc) {
+          index_file = argv[++argi];
+        } else {
+          PrintUsage(argv[0]);
+          continue_processing = false;
+          return_code = 1;
+        }
+      } else if (0 == strcmp(cur_arg, "-j")) {
+        num_threads = 0;
+        if (argi + 1 < argc) {
+          num_threads = static_cast<size_t>(atoi(argv[++argi]));
+        }
+        if (num_threads == 0) {
+          PrintUsage(argv[0]);
+          continue_processing = false;
+          return_code = 1;
+        }
       } else {
         PrintUsage(argv[0]);
         continue_processing = false;
@@ -105,30 +170,232 @@ int main(int argc, char** argv) {
     return return_code;
   }
 
+  if (merge_snapshots && index_file) {
+    std::cerr << "error: --index applies to module processing, not --merge"
+              << std::endl;
+    return 1;
+  }
+
+  StatsIndex stats_index;
+  if (index_file && !stats_index.Load(index_file)) {
+    std::cerr << "error: " << index_file << " is not a stats index"
+              << std::endl;
+    return 1;
+  }
+
   std::cerr << "Processing " << paths.size() << " files..." << std::endl;
 
   ScopedContext ctx(SPV_ENV_UNIVERSAL_1_1);
   SetContextMessageConsumer(ctx.context, DiagnosticsMessageHandler);
 
   libspirv::SpirvStats stats;
-  stats.opcode_markov_hist.resize(1);
+  stats.opcode_markov_steps = 1;
+
+  const size_t kMilestonePeriod = 1000;
+  const size_t num_workers = std::min(num_threads, paths.size());
 
-  for (size_t index = 0; index < paths.size(); ++index) {
-    const size_t kMilestonePeriod = 1000;
-    if (verbose) {
-      if (index % kMilestonePeriod == kMilestonePeriod - 1)
-        std::cerr << "Processed " << index + 1 << " files..." << std::endl;
+  if (merge_snapshots) {
+    // The inputs are snapshots, not modules: no parsing, just combine.
+    for (const char* path : paths) {
+      MappedInput<uint32_t> contents;
+      if (!contents.Read(path)) return 1;
+      if (!libspirv::DeserializeStats(contents.data(), contents.size(),
+                                      &stats)) {
+        std::cerr << "error: " << path << " is not a stats snapshot"
+                  << std::endl;
+        return 1;
+      }
     }
+  } else if (num_workers > 1) {
+    // Each worker claims the next unprocessed file from a shared counter and
+    // aggregates it into its own SpirvStats, so no synchronization is needed
+    // on the histograms.  Diagnostics are redirected into a local context
+    // copy, so the shared message consumer is never invoked from a worker.
+    std::vector<libspirv::SpirvStats> worker_stats(num_workers);
+    std::vector<std::string> worker_errors(num_workers);
+    // Index updates are collected per worker and applied after the join,
+    // so the shared index needs no locking.
+    struct PendingIndexUpdate {
+      std::string path;
+      uint64_t size;
+      uint64_t hash;
+      std::vector<uint32_t> snapshot;
+    };
+    std::vector<std::vector<PendingIndexUpdate>> worker_updates(num_workers);
+    std::atomic<size_t> next_index(0);
+    std::atomic<size_t> num_processed(0);
+    std::atomic<bool> ok(true);
 
-    const char* path = paths[index];
-    std::vector<uint32_t> contents;
-    if (!ReadFile<uint32_t>(path, "rb", &contents)) return 1;
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < num_workers; ++i) {
+      worker_stats[i].opcode_markov_steps = 1;
+      workers.emplace_back([&, i]() {
+        for (size_t index = next_index++; index < paths.size() && ok;
+             index = next_index++) {
+          const char* path = paths[index];
+          MappedInput<uint32_t> contents;
+          if (!contents.Read(path)) {
+            worker_errors[i] =
+                std::string("error: Failed to read ") + path;
+            ok = false;
+            return;
+          }
 
-    if (SPV_SUCCESS != libspirv::AggregateStats(
-        *ctx.context, contents.data(), contents.size(), nullptr, &stats)) {
-      std::cerr << "error: Failed to aggregate stats for " << path << std::endl;
-      return 1;
+          const uint64_t content_size =
+              uint64_t(contents.size()) * sizeof(uint32_t);
+          const uint64_t content_hash =
+              index_file
+                  ? StatsIndex::HashWords(contents.data(), contents.size())
+                  : 0;
+          bool used_cache = false;
+          if (index_file) {
+            if (const std::vector<uint32_t>* cached = stats_index.Find(
+                    path, content_size, content_hash)) {
+              if (!libspirv::DeserializeStats(cached->data(), cached->size(),
+                                              &worker_stats[i])) {
+                worker_errors[i] =
+                    std::string("error: Corrupt index snapshot for ") + path;
+                ok = false;
+                return;
+              }
+              used_cache = true;
+            }
+          }
+
+          if (!used_cache) {
+            // With an index, aggregate into per-file stats first so the
+            // file's own snapshot can be cached.
+            libspirv::SpirvStats file_stats;
+            libspirv::SpirvStats* target = &worker_stats[i];
+            if (index_file) {
+              file_stats.opcode_markov_steps = 1;
+              target = &file_stats;
+            }
+
+            spv_context_t worker_context = *ctx.context;
+            spv_diagnostic diagnostic = nullptr;
+            libspirv::UseDiagnosticAsMessageConsumer(&worker_context,
+                                                     &diagnostic);
+            if (SPV_SUCCESS !=
+                libspirv::AggregateStats(worker_context, contents.data(),
+                                         contents.size(), nullptr,
+                                         target, mode)) {
+              std::ostringstream message;
+              if (diagnostic) {
+                message << "error: " << diagnostic->position.index << ": "
+                        << diagnostic->error << std::endl;
+              }
+              message << "error: Failed to aggregate stats for " << path;
+              worker_errors[i] = message.str();
+              spvDiagnosticDestroy(diagnostic);
+              ok = false;
+              return;
+            }
+            spvDiagnosticDestroy(diagnostic);
+
+            if (index_file) {
+              std::vector<uint32_t> snapshot;
+              libspirv::SerializeStats(file_stats, &snapshot);
+              libspirv::MergeStats(file_stats, &worker_stats[i]);
+              worker_updates[i].push_back({path, content_size, content_hash,
+                                           std::move(snapshot)});
+            }
+          }
+
+          const size_t processed = ++num_processed;
+          if (verbose && processed % kMilestonePeriod == 0) {
+            std::ostringstream milestone;
+            milestone << "Processed " << processed << " files..." << std::endl;
+            std::cerr << milestone.str();
+          }
+        }
+      });
+    }
+    for (auto& worker : workers) worker.join();
+
+    bool had_error = false;
+    for (const auto& error : worker_errors) {
+      if (!error.empty()) {
+        std::cerr << error << std::endl;
+        had_error = true;
+      }
+    }
+    if (had_error) return 1;
+
+    for (const auto& partial : worker_stats) {
+      libspirv::MergeStats(partial, &stats);
     }
+    for (auto& updates : worker_updates) {
+      for (auto& update : updates) {
+        stats_index.Update(update.path, update.size, update.hash,
+                           std::move(update.snapshot));
+      }
+    }
+  } else {
+    for (size_t index = 0; index < paths.size(); ++index) {
+      if (verbose) {
+        if (index % kMilestonePeriod == kMilestonePeriod - 1)
+          std::cerr << "Processed " << index + 1 << " files..." << std::endl;
+      }
+
+      const char* path = paths[index];
+      MappedInput<uint32_t> contents;
+      if (!contents.Read(path)) return 1;
+
+      if (index_file) {
+        const uint64_t content_size =
+            uint64_t(contents.size()) * sizeof(uint32_t);
+        const uint64_t content_hash =
+            StatsIndex::HashWords(contents.data(), contents.size());
+        if (const std::vector<uint32_t>* cached =
+                stats_index.Find(path, content_size, content_hash)) {
+          if (!libspirv::DeserializeStats(cached->data(), cached->size(),
+                                          &stats)) {
+            std::cerr << "error: Corrupt index snapshot for " << path
+                      << std::endl;
+            return 1;
+          }
+          continue;
+        }
+
+        libspirv::SpirvStats file_stats;
+        file_stats.opcode_markov_steps = 1;
+        if (SPV_SUCCESS != libspirv::AggregateStats(
+            *ctx.context, contents.data(), contents.size(), nullptr,
+            &file_stats, mode)) {
+          std::cerr << "error: Failed to aggregate stats for " << path
+                    << std::endl;
+          return 1;
+        }
+        std::vector<uint32_t> snapshot;
+        libspirv::SerializeStats(file_stats, &snapshot);
+        libspirv::MergeStats(file_stats, &stats);
+        stats_index.Update(path, content_size, content_hash,
+                           std::move(snapshot));
+        continue;
+      }
+
+      if (SPV_SUCCESS != libspirv::AggregateStats(
+          *ctx.context, contents.data(), contents.size(), nullptr, &stats,
+          mode)) {
+        std::cerr << "error: Failed to aggregate stats for " << path
+                  << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  if (index_file && !stats_index.Save(index_file)) {
+    std::cerr << "error: Failed to write index " << index_file << std::endl;
+    return 1;
+  }
+
+  if (snapshot_file) {
+    std::vector<uint32_t> snapshot;
+    libspirv::SerializeStats(stats, &snapshot);
+    if (!WriteFile(snapshot_file, "wb", snapshot.data(), snapshot.size()))
+      return 1;
+    return 0;
   }
 
   StatsAnalyzer analyzer(stats);
@@ -151,8 +418,12 @@ int main(int argc, char** argv) {
   out << std::endl;
   analyzer.WriteOpcodeMarkov(out);
 
-  out << std::endl;
-  analyzer.WriteConstantLiterals(out);
+  // The raw scan does not collect constant literals.  Merged snapshots may
+  // carry them, depending on how the snapshots were produced.
+  if (mode == libspirv::StatsAggregationMode::kFull || merge_snapshots) {
+    out << std::endl;
+    analyzer.WriteConstantLiterals(out);
+  }
 
   return 0;
 }
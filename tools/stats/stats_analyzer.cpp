@@ -188,8 +188,14 @@ void StatsAnalyzer::WriteOpcodeMarkov(std::ostream& out) {
   if (stats_.opcode_markov_hist.empty())
     return;
 
-  const std::unordered_map<uint32_t, std::unordered_map<uint32_t, uint32_t>>&
-      cue_to_hist = stats_.opcode_markov_hist[0];
+  // Regroup the flat histogram's gap-0 entries by cue opcode for reporting.
+  std::unordered_map<uint32_t, std::unordered_map<uint32_t, uint32_t>>
+      cue_to_hist;
+  for (const auto& pair : stats_.opcode_markov_hist) {
+    if (libspirv::MarkovKeyGap(pair.first) != 0) continue;
+    cue_to_hist[libspirv::MarkovKeyCue(pair.first)]
+               [libspirv::MarkovKeyLater(pair.first)] += pair.second;
+  }
 
   // Sort by prevalence of the opcodes in opcode_freq_ (descending).
   std::vector<std::pair<uint32_t, std::unordered_map<uint32_t, uint32_t>>>
@@ -32,8 +32,8 @@ class StatsAnalyzer {
   void WriteConstantLiterals(std::ostream& out);
 
   // Writes first order Markov analysis to |out|.
-  // stats_.opcode_markov_hist needs to contain raw data for at least one
-  // level.
+  // stats_.opcode_markov_hist needs to contain raw data collected with at
+  // least one step.
   void WriteOpcodeMarkov(std::ostream& out);
 
  private:
@@ -0,0 +1,152 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "stats_index.h"
+
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+// The index file is a stream of 32-bit words:
+//   word 0   magic number
+//   word 1   format version
+//   word 2   number of entries
+// followed by, for each entry:
+//   path word count, then the path as nul-terminated zero-padded chars,
+//   file size (two words, low first),
+//   content hash (two words, low first),
+//   snapshot word count, then the snapshot words.
+const uint32_t kIndexMagic = 0x49565053u;  // "SPVI" as little-endian bytes.
+const uint32_t kIndexVersion = 1u;
+
+void EmitU64(uint64_t value, std::vector<uint32_t>* out) {
+  out->push_back(uint32_t(value & 0xffffffffu));
+  out->push_back(uint32_t(value >> 32));
+}
+
+}  // anonymous namespace
+
+uint64_t StatsIndex::HashWords(const uint32_t* words, size_t num_words) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < num_words; ++i) {
+    hash = (hash ^ words[i]) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+bool StatsIndex::Load(const char* filename) {
+  entries_.clear();
+
+  FILE* fp = fopen(filename, "rb");
+  if (!fp) return true;  // No index yet: start empty.
+  std::vector<uint32_t> words;
+  const size_t buf_size = 16384;
+  uint32_t buf[buf_size];
+  while (size_t len = fread(buf, sizeof(uint32_t), buf_size, fp)) {
+    words.insert(words.end(), buf, buf + len);
+  }
+  const bool read_ok = !ferror(fp);
+  fclose(fp);
+  if (!read_ok) return false;
+
+  size_t pos = 0;
+  const size_t num_words = words.size();
+  auto read_word = [&words, &pos, num_words](uint32_t* word) {
+    if (pos >= num_words) return false;
+    *word = words[pos++];
+    return true;
+  };
+  auto read_u64 = [&read_word](uint64_t* value) {
+    uint32_t low, high;
+    if (!read_word(&low) || !read_word(&high)) return false;
+    *value = (uint64_t(high) << 32) | low;
+    return true;
+  };
+
+  uint32_t magic = 0, version = 0, num_entries = 0;
+  if (!read_word(&magic) || magic != kIndexMagic) return false;
+  if (!read_word(&version) || version != kIndexVersion) return false;
+  if (!read_word(&num_entries)) return false;
+
+  for (uint32_t i = 0; i < num_entries; ++i) {
+    uint32_t num_path_words = 0;
+    if (!read_word(&num_path_words)) return false;
+    if (num_path_words == 0 || num_path_words > num_words - pos) return false;
+    const char* chars = reinterpret_cast<const char*>(words.data() + pos);
+    const size_t num_bytes = size_t(num_path_words) * sizeof(uint32_t);
+    if (chars[num_bytes - 1] != 0) return false;
+    const std::string path = chars;
+    pos += num_path_words;
+
+    Entry entry;
+    if (!read_u64(&entry.size) || !read_u64(&entry.hash)) return false;
+    uint32_t num_snapshot_words = 0;
+    if (!read_word(&num_snapshot_words)) return false;
+    if (num_snapshot_words > num_words - pos) return false;
+    entry.snapshot.assign(words.begin() + pos,
+                          words.begin() + pos + num_snapshot_words);
+    pos += num_snapshot_words;
+
+    entries_[path] = std::move(entry);
+  }
+  if (pos != num_words) return false;
+  return true;
+}
+
+bool StatsIndex::Save(const char* filename) const {
+  std::vector<uint32_t> words;
+  words.push_back(kIndexMagic);
+  words.push_back(kIndexVersion);
+  words.push_back(uint32_t(entries_.size()));
+  for (const auto& pair : entries_) {
+    const std::string& path = pair.first;
+    const Entry& entry = pair.second;
+    const uint32_t num_path_words = uint32_t(path.size() / 4 + 1);
+    words.push_back(num_path_words);
+    const size_t start = words.size();
+    words.resize(start + num_path_words, 0);
+    std::memcpy(words.data() + start, path.data(), path.size());
+    EmitU64(entry.size, &words);
+    EmitU64(entry.hash, &words);
+    words.push_back(uint32_t(entry.snapshot.size()));
+    words.insert(words.end(), entry.snapshot.begin(), entry.snapshot.end());
+  }
+
+  FILE* fp = fopen(filename, "wb");
+  if (!fp) return false;
+  const size_t written =
+      fwrite(words.data(), sizeof(uint32_t), words.size(), fp);
+  const bool ok = written == words.size();
+  return fclose(fp) == 0 && ok;
+}
+
+const std::vector<uint32_t>* StatsIndex::Find(const std::string& path,
+                                              uint64_t size,
+                                              uint64_t hash) const {
+  const auto where = entries_.find(path);
+  if (where == entries_.end()) return nullptr;
+  if (where->second.size != size || where->second.hash != hash) return nullptr;
+  return &where->second.snapshot;
+}
+
+void StatsIndex::Update(const std::string& path, uint64_t size, uint64_t hash,
+                        std::vector<uint32_t>&& snapshot) {
+  Entry entry;
+  entry.size = size;
+  entry.hash = hash;
+  entry.snapshot = std::move(snapshot);
+  entries_[path] = std::move(entry);
+}
@@ -0,0 +1,64 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef STATS_INDEX_H_
+#define STATS_INDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A persistent index of per-file statistics snapshots, keyed by file path.
+// Each entry records the file's size and content hash along with the
+// snapshot produced by libspirv::SerializeStats for that one file, so an
+// incremental run can reuse the snapshot of every file that has not
+// changed and aggregate only the rest.  Entries for paths not seen in the
+// current run are kept: a corpus is often processed in several tool
+// invocations (e.g. via xargs batching).
+class StatsIndex {
+ public:
+  // Returns a 64-bit FNV-1a hash of the given words, used together with
+  // the file size to detect content changes.
+  static uint64_t HashWords(const uint32_t* words, size_t num_words);
+
+  // Loads the index from the file named |filename|.  A missing file yields
+  // an empty index, as on the first run.  Returns false if the file exists
+  // but is not a well-formed index.
+  bool Load(const char* filename);
+
+  // Writes the index to the file named |filename|.  Returns false on I/O
+  // failure.
+  bool Save(const char* filename) const;
+
+  // Returns the cached snapshot for |path| if its recorded size and hash
+  // both match, or null if the file is new or changed.
+  const std::vector<uint32_t>* Find(const std::string& path, uint64_t size,
+                                    uint64_t hash) const;
+
+  // Inserts or replaces the entry for |path|.
+  void Update(const std::string& path, uint64_t size, uint64_t hash,
+              std::vector<uint32_t>&& snapshot);
+
+ private:
+  struct Entry {
+    uint64_t size;
+    uint64_t hash;
+    std::vector<uint32_t> snapshot;
+  };
+
+  std::unordered_map<std::string, Entry> entries_;
+};
+
+#endif  // STATS_INDEX_H_
@@ -0,0 +1,437 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Generates valid SPIR-V modules with controlled characteristics for
+// benchmarking and stress testing.  Real worst-case shaders often cannot be
+// shared, so this tool produces stand-ins whose instruction count, function
+// count, control flow shape, type/constant diversity and decoration density
+// are all dialed in from the command line, and whose output is a pure
+// function of those parameters and the seed.
+
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "opt/basic_block.h"
+#include "opt/function.h"
+#include "opt/instruction.h"
+#include "opt/module.h"
+#include "spirv_constant.h"
+#include "spirv-tools/libspirv.h"
+
+#include "tools/io.h"
+
+namespace {
+
+using spvtools::ir::BasicBlock;
+using spvtools::ir::Function;
+using spvtools::ir::Instruction;
+using spvtools::ir::Module;
+
+// The dials for one synthesized module.  The defaults produce a small but
+// non-trivial module; benchmark configurations scale them up.
+struct SynthParams {
+  uint32_t num_functions = 8;
+  // Approximate number of basic blocks per function.
+  uint32_t blocks_per_function = 8;
+  // Arithmetic instructions appended to each block.
+  uint32_t insts_per_block = 16;
+  // Percentage of control flow steps that become an if-then-else diamond
+  // instead of a straight OpBranch to the next block.
+  uint32_t branch_percent = 50;
+  // Number of distinct numeric types (and how many constants each gets).
+  uint32_t num_types = 4;
+  uint32_t consts_per_type = 4;
+  // Percentage of float-typed results that get a RelaxedPrecision
+  // decoration.
+  uint32_t decoration_percent = 10;
+  uint64_t seed = 0;
+};
+
+// One numeric type in the generated module, together with the ids of its
+// constants.  Constants seed the value pool of every function.
+struct NumericType {
+  uint32_t type_id;
+  bool is_float;
+  std::vector<uint32_t> constant_ids;
+};
+
+// Builds one module from the given parameters.  All randomness comes from a
+// std::mt19937_64 seeded with params.seed, so equal parameters always yield
+// bit-identical modules.
+class ModuleSynthesizer {
+ public:
+  ModuleSynthesizer(const SynthParams& params, Module* module)
+      : params_(params), module_(module), rng_(params.seed) {}
+
+  void Synthesize() {
+    BuildPreamble();
+    BuildTypesAndConstants();
+    for (uint32_t i = 0; i < params_.num_functions; ++i) BuildFunction();
+    for (uint32_t id : decorated_ids_) {
+      module_->AddAnnotationInst(std::unique_ptr<Instruction>(new Instruction(
+          SpvOpDecorate, 0, 0,
+          {{spv_operand_type_t::SPV_OPERAND_TYPE_ID, {id}},
+           {spv_operand_type_t::SPV_OPERAND_TYPE_DECORATION,
+            {uint32_t(SpvDecorationRelaxedPrecision)}}})));
+    }
+    module_->SetHeader({SpvMagicNumber, SPV_SPIRV_VERSION_WORD(1, 2),
+                        0u /* anonymous generator */, next_id_, 0u});
+  }
+
+ private:
+  uint32_t TakeNextId() { return next_id_++; }
+
+  // Returns a pseudo-random number in [0, bound).
+  uint32_t Pick(uint32_t bound) {
+    return static_cast<uint32_t>(rng_() % bound);
+  }
+
+  bool Chance(uint32_t percent) { return Pick(100) < percent; }
+
+  void BuildPreamble() {
+    // The Linkage capability exempts the module from needing entry points,
+    // which keeps the generated functions uniform.
+    for (SpvCapability cap : {SpvCapabilityShader, SpvCapabilityLinkage}) {
+      module_->AddCapability(std::unique_ptr<Instruction>(
+          new Instruction(SpvOpCapability, 0, 0,
+                          {{spv_operand_type_t::SPV_OPERAND_TYPE_CAPABILITY,
+                            {uint32_t(cap)}}})));
+    }
+    module_->SetMemoryModel(std::unique_ptr<Instruction>(new Instruction(
+        SpvOpMemoryModel, 0, 0,
+        {{spv_operand_type_t::SPV_OPERAND_TYPE_ADDRESSING_MODEL,
+          {uint32_t(SpvAddressingModelLogical)}},
+         {spv_operand_type_t::SPV_OPERAND_TYPE_MEMORY_MODEL,
+          {uint32_t(SpvMemoryModelGLSL450)}}})));
+  }
+
+  void BuildTypesAndConstants() {
+    void_id_ = TakeNextId();
+    module_->AddType(std::unique_ptr<Instruction>(
+        new Instruction(SpvOpTypeVoid, 0, void_id_, {})));
+    bool_id_ = TakeNextId();
+    module_->AddType(std::unique_ptr<Instruction>(
+        new Instruction(SpvOpTypeBool, 0, bool_id_, {})));
+    fn_type_id_ = TakeNextId();
+    module_->AddType(std::unique_ptr<Instruction>(new Instruction(
+        SpvOpTypeFunction, 0, fn_type_id_,
+        {{spv_operand_type_t::SPV_OPERAND_TYPE_ID, {void_id_}}})));
+    true_id_ = TakeNextId();
+    module_->AddGlobalValue(std::unique_ptr<Instruction>(
+        new Instruction(SpvOpConstantTrue, bool_id_, true_id_, {})));
+
+    // The first three types are the 32-bit scalars; further diversity comes
+    // from vectors of those scalars with growing widths.
+    for (uint32_t i = 0; i < params_.num_types; ++i) {
+      NumericType type;
+      if (i < 3) {
+        type.type_id = TakeNextId();
+        type.is_float = (i == 2);
+        if (type.is_float) {
+          module_->AddType(std::unique_ptr<Instruction>(new Instruction(
+              SpvOpTypeFloat, 0, type.type_id,
+              {{spv_operand_type_t::SPV_OPERAND_TYPE_LITERAL_INTEGER,
+                {32}}})));
+        } else {
+          module_->AddType(std::unique_ptr<Instruction>(new Instruction(
+              SpvOpTypeInt, 0, type.type_id,
+              {{spv_operand_type_t::SPV_OPERAND_TYPE_LITERAL_INTEGER, {32}},
+               {spv_operand_type_t::SPV_OPERAND_TYPE_LITERAL_INTEGER,
+                {i /* 0: unsigned, 1: signed */}}})));
+        }
+        for (uint32_t c = 0; c < params_.consts_per_type; ++c) {
+          const uint32_t id = TakeNextId();
+          // Small literals; the bit pattern is a valid value for ints and
+          // floats alike.
+          module_->AddGlobalValue(std::unique_ptr<Instruction>(new Instruction(
+              SpvOpConstant, type.type_id, id,
+              {{spv_operand_type_t::SPV_OPERAND_TYPE_TYPED_LITERAL_NUMBER,
+                {Pick(1u << 20)}}})));
+          type.constant_ids.push_back(id);
+        }
+      } else {
+        // A vector of one of the scalars, built after the scalar so its
+        // constants can be composed from the scalar's constants.
+        const NumericType& component = types_[i % 3];
+        const uint32_t width = 2 + (i - 3) % 3;
+        type.type_id = TakeNextId();
+        type.is_float = component.is_float;
+        module_->AddType(std::unique_ptr<Instruction>(new Instruction(
+            SpvOpTypeVector, 0, type.type_id,
+            {{spv_operand_type_t::SPV_OPERAND_TYPE_ID, {component.type_id}},
+             {spv_operand_type_t::SPV_OPERAND_TYPE_LITERAL_INTEGER,
+              {width}}})));
+        for (uint32_t c = 0; c < params_.consts_per_type; ++c) {
+          const uint32_t id = TakeNextId();
+          std::vector<spvtools::ir::Operand> operands;
+          for (uint32_t w = 0; w < width; ++w) {
+            operands.emplace_back(
+                spv_operand_type_t::SPV_OPERAND_TYPE_ID,
+                std::vector<uint32_t>{component.constant_ids[Pick(
+                    uint32_t(component.constant_ids.size()))]});
+          }
+          module_->AddGlobalValue(std::unique_ptr<Instruction>(new Instruction(
+              SpvOpConstantComposite, type.type_id, id, operands)));
+          type.constant_ids.push_back(id);
+        }
+      }
+      types_.push_back(std::move(type));
+    }
+  }
+
+  // Appends params_.insts_per_block arithmetic instructions to |block|,
+  // drawing operands from |pools| (one value pool per numeric type).  New
+  // results are appended to the pools only when |extend_pools| is set, i.e.
+  // when the block dominates everything generated after it.
+  void FillBlock(BasicBlock* block,
+                 std::vector<std::vector<uint32_t>>* pools,
+                 bool extend_pools) {
+    // Values defined in a non-dominating block stay usable within it.
+    std::vector<std::vector<uint32_t>> local;
+    if (!extend_pools) local = *pools;
+    std::vector<std::vector<uint32_t>>& values = extend_pools ? *pools : local;
+
+    static const SpvOp kIntOps[] = {SpvOpIAdd, SpvOpISub, SpvOpIMul};
+    static const SpvOp kFloatOps[] = {SpvOpFAdd, SpvOpFSub, SpvOpFMul};
+    for (uint32_t i = 0; i < params_.insts_per_block; ++i) {
+      const uint32_t ti = Pick(uint32_t(types_.size()));
+      const NumericType& type = types_[ti];
+      const SpvOp op =
+          (type.is_float ? kFloatOps : kIntOps)[Pick(3)];
+      const uint32_t lhs = values[ti][Pick(uint32_t(values[ti].size()))];
+      const uint32_t rhs = values[ti][Pick(uint32_t(values[ti].size()))];
+      const uint32_t id = TakeNextId();
+      block->AddInstruction(std::unique_ptr<Instruction>(new Instruction(
+          op, type.type_id, id,
+          {{spv_operand_type_t::SPV_OPERAND_TYPE_ID, {lhs}},
+           {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {rhs}}})));
+      values[ti].push_back(id);
+      if (type.is_float && Chance(params_.decoration_percent)) {
+        decorated_ids_.push_back(id);
+      }
+    }
+  }
+
+  std::unique_ptr<BasicBlock> NewBlock(uint32_t label_id) {
+    return std::unique_ptr<BasicBlock>(new BasicBlock(
+        std::unique_ptr<Instruction>(
+            new Instruction(SpvOpLabel, 0, label_id, {}))));
+  }
+
+  void AddBranch(BasicBlock* block, uint32_t target_id) {
+    block->AddInstruction(std::unique_ptr<Instruction>(new Instruction(
+        SpvOpBranch, 0, 0,
+        {{spv_operand_type_t::SPV_OPERAND_TYPE_ID, {target_id}}})));
+  }
+
+  void BuildFunction() {
+    const uint32_t fn_id = TakeNextId();
+    std::unique_ptr<Function> function(new Function(
+        std::unique_ptr<Instruction>(new Instruction(
+            SpvOpFunction, void_id_, fn_id,
+            {{spv_operand_type_t::SPV_OPERAND_TYPE_FUNCTION_CONTROL,
+              {uint32_t(SpvFunctionControlMaskNone)}},
+             {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {fn_type_id_}}}))));
+
+    // Every function starts from the constants alone; results of dominating
+    // blocks join the pools as the CFG grows downward.
+    std::vector<std::vector<uint32_t>> pools;
+    for (const NumericType& type : types_) pools.push_back(type.constant_ids);
+
+    std::unique_ptr<BasicBlock> block = NewBlock(TakeNextId());
+    uint32_t remaining =
+        params_.blocks_per_function > 0 ? params_.blocks_per_function - 1 : 0;
+    while (remaining > 0) {
+      FillBlock(block.get(), &pools, /* extend_pools = */ true);
+      if (remaining >= 3 && Chance(params_.branch_percent)) {
+        // An if-then-else diamond: both arms compute locally and rejoin, so
+        // only the head's results survive into the merge block's pools.
+        const uint32_t then_id = TakeNextId();
+        const uint32_t else_id = TakeNextId();
+        const uint32_t merge_id = TakeNextId();
+        block->AddInstruction(std::unique_ptr<Instruction>(new Instruction(
+            SpvOpSelectionMerge, 0, 0,
+            {{spv_operand_type_t::SPV_OPERAND_TYPE_ID, {merge_id}},
+             {spv_operand_type_t::SPV_OPERAND_TYPE_SELECTION_CONTROL,
+              {uint32_t(SpvSelectionControlMaskNone)}}})));
+        block->AddInstruction(std::unique_ptr<Instruction>(new Instruction(
+            SpvOpBranchConditional, 0, 0,
+            {{spv_operand_type_t::SPV_OPERAND_TYPE_ID, {true_id_}},
+             {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {then_id}},
+             {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {else_id}}})));
+        function->AddBasicBlock(std::move(block));
+        for (uint32_t arm_id : {then_id, else_id}) {
+          std::unique_ptr<BasicBlock> arm = NewBlock(arm_id);
+          FillBlock(arm.get(), &pools, /* extend_pools = */ false);
+          AddBranch(arm.get(), merge_id);
+          function->AddBasicBlock(std::move(arm));
+        }
+        block = NewBlock(merge_id);
+        remaining -= 3;
+      } else {
+        const uint32_t next_id = TakeNextId();
+        AddBranch(block.get(), next_id);
+        function->AddBasicBlock(std::move(block));
+        block = NewBlock(next_id);
+        remaining -= 1;
+      }
+    }
+    FillBlock(block.get(), &pools, /* extend_pools = */ true);
+    block->AddInstruction(std::unique_ptr<Instruction>(
+        new Instruction(SpvOpReturn, 0, 0, {})));
+    function->AddBasicBlock(std::move(block));
+    function->SetFunctionEnd(std::unique_ptr<Instruction>(
+        new Instruction(SpvOpFunctionEnd, 0, 0, {})));
+    module_->AddFunction(std::move(function));
+  }
+
+  const SynthParams& params_;
+  Module* module_;
+  std::mt19937_64 rng_;
+  uint32_t next_id_ = 1;
+
+  uint32_t void_id_ = 0;
+  uint32_t bool_id_ = 0;
+  uint32_t fn_type_id_ = 0;
+  uint32_t true_id_ = 0;
+  std::vector<NumericType> types_;
+  // Float-typed result ids chosen for a RelaxedPrecision decoration.
+  std::vector<uint32_t> decorated_ids_;
+};
+
+void PrintUsage(const char* program) {
+  printf(
+      R"(%s - Generate a synthetic SPIR-V binary for benchmarking.
+
+USAGE: %s [options] -o <output>
+
+The generated module is valid SPIR-V: it declares the Shader and Linkage
+capabilities and consists of void functions whose blocks compute integer
+and floating point arithmetic over a configurable pool of types and
+constants. The output is fully determined by the options and the seed, so
+a benchmark input can be reproduced from its command line.
+If <output> is "-", the binary is written to standard output.
+
+Options:
+  --functions <n>    Number of functions to generate (default 8).
+  --blocks <n>       Approximate basic blocks per function (default 8).
+  --insts <n>        Arithmetic instructions per block (default 16).
+  --branchiness <n>  Percentage of control flow steps that become an
+                     if-then-else diamond rather than a straight branch
+                     (default 50).
+  --types <n>        Number of distinct numeric types; the first three are
+                     the 32-bit scalars, the rest are vectors of them
+                     (default 4).
+  --constants <n>    Constants per numeric type (default 4).
+  --decorations <n>  Percentage of float results decorated with
+                     RelaxedPrecision (default 10).
+  --seed <n>         Seed for the random generator (default 0).
+  -h, --help         Print this help.
+)",
+      program, program);
+}
+
+// Parses a non-negative integer option value; returns false on bad input.
+bool ParseUint(const char* text, uint64_t* value) {
+  char* end = nullptr;
+  *value = strtoull(text, &end, 10);
+  return end != text && *end == '\0';
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  const char* out_file = nullptr;
+  SynthParams params;
+
+  for (int argi = 1; argi < argc; ++argi) {
+    const char* cur_arg = argv[argi];
+    uint64_t value = 0;
+    if (0 == strcmp(cur_arg, "--help") || 0 == strcmp(cur_arg, "-h")) {
+      PrintUsage(argv[0]);
+      return 0;
+    } else if (0 == strcmp(cur_arg, "-o")) {
+      if (!out_file && argi + 1 < argc) {
+        out_file = argv[++argi];
+      } else {
+        PrintUsage(argv[0]);
+        return 1;
+      }
+    } else if (argi + 1 < argc && ParseUint(argv[argi + 1], &value)) {
+      ++argi;
+      if (0 == strcmp(cur_arg, "--functions")) {
+        params.num_functions = static_cast<uint32_t>(value);
+      } else if (0 == strcmp(cur_arg, "--blocks")) {
+        params.blocks_per_function = static_cast<uint32_t>(value);
+      } else if (0 == strcmp(cur_arg, "--insts")) {
+        params.insts_per_block = static_cast<uint32_t>(value);
+      } else if (0 == strcmp(cur_arg, "--branchiness")) {
+        params.branch_percent = static_cast<uint32_t>(value);
+      } else if (0 == strcmp(cur_arg, "--types")) {
+        params.num_types = static_cast<uint32_t>(value);
+      } else if (0 == strcmp(cur_arg, "--constants")) {
+        params.consts_per_type = static_cast<uint32_t>(value);
+      } else if (0 == strcmp(cur_arg, "--decorations")) {
+        params.decoration_percent = static_cast<uint32_t>(value);
+      } else if (0 == strcmp(cur_arg, "--seed")) {
+        params.seed = value;
+      } else {
+        fprintf(stderr, "error: unknown option: %s\n", cur_arg);
+        return 1;
+      }
+    } else {
+      fprintf(stderr, "error: unknown option or missing value: %s\n", cur_arg);
+      return 1;
+    }
+  }
+
+  if (out_file == nullptr) {
+    fprintf(stderr, "error: -o required\n");
+    return 1;
+  }
+  if (params.num_types == 0 || params.consts_per_type == 0) {
+    fprintf(stderr, "error: --types and --constants must be at least 1\n");
+    return 1;
+  }
+
+  Module module;
+  ModuleSynthesizer(params, &module).Synthesize();
+  std::vector<uint32_t> binary;
+  module.ToBinary(&binary, /* skip_nop = */ false);
+
+  // Guard against generator bugs: a benchmark input that fails validation
+  // would silently measure the error paths instead.
+  spv_context context = spvContextCreate(SPV_ENV_UNIVERSAL_1_2);
+  spv_diagnostic diagnostic = nullptr;
+  spv_const_binary_t binary_struct = {binary.data(), binary.size()};
+  spv_result_t error = spvValidate(context, &binary_struct, &diagnostic);
+  if (error) {
+    fprintf(stderr, "error: generated module failed validation:\n");
+    spvDiagnosticPrint(diagnostic);
+    spvDiagnosticDestroy(diagnostic);
+    spvContextDestroy(context);
+    return error;
+  }
+  spvDiagnosticDestroy(diagnostic);
+  spvContextDestroy(context);
+
+  if (!WriteFile<uint32_t>(out_file, "wb", binary.data(), binary.size())) {
+    return 1;
+  }
+  return 0;
+}
@@ -12,30 +12,52 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "source/spirv_target_env.h"
 #include "source/spirv_validator_options.h"
+#include "source/tracing.h"
 #include "spirv-tools/libspirv.hpp"
 #include "tools/io.h"
 
 void print_usage(char* argv0) {
   printf(
-      R"(%s - Validate a SPIR-V binary file.
+      R"(%s - Validate one or more SPIR-V binary files.
 
-USAGE: %s [options] [<filename>]
+USAGE: %s [options] [<filenames>]
 
-The SPIR-V binary is read from <filename>. If no file is specified,
-or if the filename is "-", then the binary is read from standard input.
+The SPIR-V binaries are read from the given <filenames>. If no file is
+specified, or if a filename is "-", then a binary is read from standard
+input.
+
+When more than one file is given the tool runs in batch mode: every file
+is validated in one process, diagnostics are suppressed, and one
+tab-separated summary line per file is written to standard output in the
+order the files were given:
+
+  PASS<tab><filename>
+  FAIL<tab><filename><tab><first error message>
+  ERROR<tab><filename><tab>failed to read
+
+The exit status is 0 only if every file passes.
+
+TIP: In order to validate all .spv files under the current dir use
+find . -name "*.spv" -print0 | xargs -0 -s 2000000 %s -j 8
 
 NOTE: The validator is a work in progress.
 
 Options:
   -h, --help                       Print this help.
+  -j <count>                       In batch mode, validate files on <count>
+                                   worker threads.  Defaults to 1.
   --max-struct-members             <maximum number of structure members allowed>
   --max-struct-depth               <maximum allowed nesting depth of structures>
   --max-local-variables            <maximum number of local variables allowed>
@@ -44,18 +66,75 @@ Options:
   --max-function-args              <maximum number arguments allowed per function>
   --max-control-flow-nesting-depth <maximum Control Flow nesting depth allowed>
   --max-access-chain-indexes       <maximum number of indexes allowed to use for Access Chain instructions>
+  --pipeline                       Decode the binary and run the
+                                   per-instruction checks on separate
+                                   threads.  Helps on modules dominated by
+                                   one large function.
+  --trace <file>                   Write chrome://tracing span output for the
+                                   run to <file>.  Only available when the
+                                   tools were built with SPIRV_TRACING=ON.
   --version                        Display validator version information.
   --target-env                     {vulkan1.0|spv1.0|spv1.1|spv1.2}
                                    Use Vulkan1.0/SPIR-V1.0/SPIR-V1.1/SPIR-V1.2 validation rules.
 )",
-      argv0, argv0);
+      argv0, argv0, argv0);
+}
+
+namespace {
+
+// The outcome of validating one file in batch mode.
+struct BatchResult {
+  bool read_ok = false;
+  bool valid = false;
+  std::string first_error;
+};
+
+// Validates each of the given files on num_workers threads and records the
+// per-file outcome in results, which must have one entry per path.  Each
+// worker reuses one SpirvTools instance; the grammar tables behind it are
+// process-wide and shared.
+void RunBatch(const std::vector<const char*>& paths,
+              spv_target_env target_env,
+              const spvtools::ValidatorOptions& options, size_t num_workers,
+              std::vector<BatchResult>* results) {
+  std::atomic<size_t> next_index(0);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers.emplace_back([&]() {
+      spvtools::SpirvTools tools(target_env);
+      BatchResult* current = nullptr;
+      tools.SetMessageConsumer([&current](spv_message_level_t level,
+                                          const char*, const spv_position_t&,
+                                          const char* message) {
+        if (level > SPV_MSG_ERROR) return;
+        if (current && current->first_error.empty())
+          current->first_error = message;
+      });
+      for (size_t index = next_index++; index < paths.size();
+           index = next_index++) {
+        BatchResult& result = (*results)[index];
+        MappedInput<uint32_t> contents;
+        if (!contents.Read(paths[index])) continue;
+        result.read_ok = true;
+        current = &result;
+        result.valid = tools.Validate(contents.data(), contents.size(),
+                                      options);
+        current = nullptr;
+      }
+    });
+  }
+  for (auto& worker : workers) worker.join();
 }
 
+}  // anonymous namespace
+
 int main(int argc, char** argv) {
-  const char* inFile = nullptr;
+  std::vector<const char*> in_files;
   spv_target_env target_env = SPV_ENV_UNIVERSAL_1_2;
   spvtools::ValidatorOptions options;
   bool continue_processing = true;
+  size_t num_threads = 1;
+  const char* trace_file = nullptr;
   int return_code = 0;
 
   for (int argi = 1; continue_processing && argi < argc; ++argi) {
@@ -109,28 +188,36 @@ int main(int argc, char** argv) {
           continue_processing = false;
           return_code = 1;
         }
-      } else if (0 == cur_arg[1]) {
-        // Setting a filename of "-" to indicate stdin.
-        if (!inFile) {
-          inFile = cur_arg;
+      } else if (0 == strcmp(cur_arg, "--pipeline")) {
+        options.SetPipelinedChecks(true);
+      } else if (0 == strcmp(cur_arg, "--trace")) {
+        if (argi + 1 < argc) {
+          trace_file = argv[++argi];
         } else {
-          fprintf(stderr, "error: More than one input file specified\n");
+          fprintf(stderr, "error: Missing argument to --trace\n");
+          continue_processing = false;
+          return_code = 1;
+        }
+      } else if (0 == strcmp(cur_arg, "-j")) {
+        num_threads = 0;
+        if (argi + 1 < argc) {
+          num_threads = static_cast<size_t>(atoi(argv[++argi]));
+        }
+        if (num_threads == 0) {
+          fprintf(stderr, "error: Missing or invalid argument to -j\n");
           continue_processing = false;
           return_code = 1;
         }
+      } else if (0 == cur_arg[1]) {
+        // Setting a filename of "-" to indicate stdin.
+        in_files.push_back(cur_arg);
       } else {
         print_usage(argv[0]);
         continue_processing = false;
         return_code = 1;
       }
     } else {
-      if (!inFile) {
-        inFile = cur_arg;
-      } else {
-        fprintf(stderr, "error: More than one input file specified\n");
-        continue_processing = false;
-        return_code = 1;
-      }
+      in_files.push_back(cur_arg);
     }
   }
 
@@ -139,8 +226,48 @@ int main(int argc, char** argv) {
     return return_code;
   }
 
-  std::vector<uint32_t> contents;
-  if (!ReadFile<uint32_t>(inFile, "rb", &contents)) return 1;
+  if (trace_file) {
+    if (!libspirv::TraceSupported()) {
+      fprintf(stderr,
+              "error: --trace requires building with SPIRV_TRACING=ON\n");
+      return 1;
+    }
+    if (!libspirv::TraceStart(trace_file)) {
+      fprintf(stderr, "error: failed to open trace file: %s\n", trace_file);
+      return 1;
+    }
+  }
+
+  if (in_files.size() > 1) {
+    // Batch mode: validate every file in this one process and emit a
+    // machine-readable per-file summary instead of diagnostics.
+    std::vector<BatchResult> results(in_files.size());
+    const size_t num_workers =
+        std::min(num_threads, in_files.size());
+    RunBatch(in_files, target_env, options, num_workers, &results);
+    libspirv::TraceStop();
+
+    bool all_passed = true;
+    for (size_t i = 0; i < in_files.size(); ++i) {
+      const BatchResult& result = results[i];
+      if (!result.read_ok) {
+        printf("ERROR\t%s\tfailed to read\n", in_files[i]);
+        all_passed = false;
+      } else if (result.valid) {
+        printf("PASS\t%s\n", in_files[i]);
+      } else {
+        printf("FAIL\t%s\t%s\n", in_files[i], result.first_error.c_str());
+        all_passed = false;
+      }
+    }
+    return all_passed ? 0 : 1;
+  }
+
+  const char* inFile = in_files.empty() ? nullptr : in_files.front();
+
+  // Read the input binary, memory-mapping it when possible.
+  MappedInput<uint32_t> contents;
+  if (!contents.Read(inFile)) return 1;
 
   spvtools::SpirvTools tools(target_env);
   tools.SetMessageConsumer([](spv_message_level_t level, const char*,
@@ -166,6 +293,7 @@ int main(int argc, char** argv) {
   });
 
   bool succeed = tools.Validate(contents.data(), contents.size(), options);
+  libspirv::TraceStop();
 
   return !succeed;
 }
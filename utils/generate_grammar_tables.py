@@ -255,6 +255,34 @@ def generate_instruction_table(inst_table, is_ext_inst):
                        for inst in inst_table])
 
 
+def generate_unified_instruction_table(inst_tables):
+    """Returns one instruction info table shared by every grammar version.
+
+    Arguments:
+      - inst_tables: a list of per-version 'instructions' grammar sections,
+                     ordered from oldest to newest version.
+
+    Each output entry gains a trailing bitmask recording which of the input
+    versions define it: bit i corresponds to inst_tables[i]. An instruction
+    whose description changes between versions yields one entry per distinct
+    description, each masked with the versions it serves, so a per-version
+    lookup behaves exactly as it would over that version's own table.
+    Entries stay in order of first appearance.
+    """
+    entries = []
+    masks = {}
+    for index, insts in enumerate(inst_tables):
+        bit = 1 << index
+        for inst in insts:
+            desc = generate_instruction(inst, False)
+            if desc not in masks:
+                masks[desc] = 0
+                entries.append(desc)
+            masks[desc] |= bit
+    return ',\n'.join(['{}, 0x{:x}}}'.format(e[:-1], masks[e])
+                       for e in entries])
+
+
 class EnumerantInitializer(object):
     """Prints an enumerant as the initializer for spv_operand_desc_t."""
 
@@ -396,14 +424,57 @@ def generate_extension_to_string_table(operands):
     return table_template.format(enums=',\n'.join(table_entries))
 
 
+def find_extension_perfect_hash(extensions):
+    """Finds a perfect hash over the given extension strings.
+
+    Searches for an FNV-1a seed under which every extension name lands in
+    a distinct slot of a power-of-two table, doubling the table if no such
+    seed turns up quickly.
+
+    Returns: a (size, seed, slots) tuple where slots maps each occupied
+    slot index to its extension name.
+    """
+    mask64 = (1 << 64) - 1
+
+    def fnv1a(string, seed):
+        h = seed
+        for ch in string:
+            h = ((h ^ ord(ch)) * 0x100000001b3) & mask64
+        return h
+
+    size = 1
+    while size < 2 * len(extensions):
+        size *= 2
+    while True:
+        seed = 0xcbf29ce484222325
+        for _ in range(64):
+            slots = {}
+            for extension in extensions:
+                slot = fnv1a(extension, seed) & (size - 1)
+                if slot in slots:
+                    break
+                slots[slot] = extension
+            else:
+                return size, seed, slots
+            seed = (seed * 6364136223846793005 + 1442695040888963407) \
+                & mask64
+        size *= 2
+
+
 def generate_string_to_extension_table(operands):
-    """Returns string to extension mapping table."""
+    """Returns perfect hash table over the known extension strings."""
     extensions = get_extension_list(operands)
+    size, seed, slots = find_extension_perfect_hash(extensions)
+    # Empty slots carry an arbitrary extension value; the null name marks
+    # them as misses.
+    empty_entry = '  {{nullptr,\n   Extension::k{extension}}}'.format(
+        extension=extensions[0])
     entry_template = '  {{"{extension}",\n   Extension::k{extension}}}'
-    table_entries = [entry_template.format(extension=extension)
-                     for extension in extensions]
+    table_entries = [entry_template.format(extension=slots[slot])
+                     if slot in slots else empty_entry
+                     for slot in range(size)]
     table_template = '{{\n{enums}\n}}'
-    return table_template.format(enums=',\n'.join(table_entries))
+    return seed, table_template.format(enums=',\n'.join(table_entries))
 
 
 def generate_capability_to_string_table(operands):
@@ -431,15 +502,29 @@ def generate_extension_to_string_mapping(operands):
 
 
 def generate_string_to_extension_mapping(operands):
-    """Returns mapping function from strings to corresponding extensions."""
+    """Returns mapping function from strings to corresponding extensions.
+
+    The emitted lookup is a perfect hash over the extension names fixed
+    at generation time: one FNV-1a hash plus one string comparison.
+    """
+    seed, table = generate_string_to_extension_table(operands)
     function = 'bool GetExtensionFromString(' \
-        'const std::string& str, Extension* extension) {\n ' \
-        'static const std::unordered_map<std::string, Extension> mapping =\n'
-    function += generate_string_to_extension_table(operands)
+        'const std::string& str, Extension* extension) {\n' \
+        '  struct NamedExtension {\n' \
+        '    const char* name;\n' \
+        '    Extension extension;\n' \
+        '  };\n' \
+        '  static const NamedExtension mapping[] =\n'
+    function += table
     function += ';\n\n'
-    function += '  const auto it = mapping.find(str);\n\n' \
-        '  if (it == mapping.end()) return false;\n\n' \
-        '  *extension = it->second;\n  return true;\n}'
+    function += '  uint64_t hash = 0x{seed:x}ull;\n' \
+        '  for (const char c : str) {{\n' \
+        '    hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;\n' \
+        '  }}\n\n' \
+        '  const NamedExtension& entry =\n' \
+        '      mapping[hash & (sizeof(mapping) / sizeof(mapping[0]) - 1)];\n\n' \
+        '  if (entry.name == nullptr || str != entry.name) return false;\n\n' \
+        '  *extension = entry.extension;\n  return true;\n}}'.format(seed=seed)
     return function
 
 
@@ -488,9 +573,17 @@ def main():
                         type=str, required=False, default=None,
                         help='input JSON grammar file for OpenCL extended '
                         'instruction set')
+    parser.add_argument('--spirv-core-grammars', metavar='<paths>',
+                        type=str, required=False, default=None,
+                        help='comma-separated input JSON grammar files for '
+                        'all core SPIR-V versions, ordered oldest first')
     parser.add_argument('--core-insts-output', metavar='<path>',
                         type=str, required=False, default=None,
                         help='output file for core SPIR-V instructions')
+    parser.add_argument('--unified-core-insts-output', metavar='<path>',
+                        type=str, required=False, default=None,
+                        help='output file for the version-unified core '
+                        'SPIR-V instruction table')
     parser.add_argument('--glsl-insts-output', metavar='<path>',
                         type=str, required=False, default=None,
                         help='output file for GLSL extended instruction set')
@@ -535,7 +628,13 @@ def main():
         print('error: --vendor-insts-output and '
               '--extinst-vendor-grammar should be specified together.')
         exit(1)
+    if (args.unified_core_insts_output is None) != \
+            (args.spirv_core_grammars is None):
+        print('error: --unified-core-insts-output and --spirv-core-grammars '
+              'should be specified together.')
+        exit(1)
     if all([args.core_insts_output is None,
+            args.unified_core_insts_output is None,
             args.glsl_insts_output is None,
             args.opencl_insts_output is None,
             args.vendor_insts_output is None,
@@ -564,6 +663,15 @@ def main():
                           grammar['operand_kinds']),
                       file=open(args.enum_string_mapping_output, 'w'))
 
+    if args.spirv_core_grammars is not None:
+        inst_tables = []
+        for path in args.spirv_core_grammars.split(','):
+            with open(path) as json_file:
+                inst_tables.append(json.loads(json_file.read())['instructions'])
+        make_path_to_file(args.unified_core_insts_output)
+        print(generate_unified_instruction_table(inst_tables),
+              file=open(args.unified_core_insts_output, 'w'))
+
     if args.extinst_glsl_grammar is not None:
         with open(args.extinst_glsl_grammar) as json_file:
             grammar = json.loads(json_file.read())